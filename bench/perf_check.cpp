@@ -0,0 +1,359 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+/**
+ * tierone-tar-perf-check - Throughput regression check against a baseline.
+ *
+ * Usage: ./tierone-tar-perf-check --baseline FILE [--dir PATH] [--scale F]
+ *                                 [--fixtures DIR] [--tolerance X] [--update]
+ *
+ * Lists, reads and indexes the synthetic archives of tierone-tar-bench at a
+ * small scale, plus every .tar below --fixtures, all from memory. Each time
+ * is divided by the time to hash the same archive bytes on the same machine,
+ * so the costs compare across machines far better than raw throughput. A
+ * cost more than --tolerance (default 2) times its baseline fails the check.
+ * --update writes the measured costs as the new baseline instead. Baselines
+ * are kept per build type; under another one the check is skipped (exit 77).
+ */
+
+#include "synthetic_archives.hpp"
+#include <tierone/tar/tar.hpp>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <fstream>
+#include <format>
+#include <functional>
+#include <limits>
+#include <map>
+#include <optional>
+#include <print>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#ifndef TIERONE_TAR_PERF_BUILD
+#define TIERONE_TAR_PERF_BUILD "unknown"
+#endif
+
+using namespace tierone::tar;
+
+namespace {
+
+constexpr int skipped = 77;  // CTest SKIP_RETURN_CODE
+constexpr int rounds = 5;
+constexpr auto min_round_time = std::chrono::milliseconds{40};
+
+// Results are stored here so the compiler cannot drop the work producing them
+volatile uint64_t keep = 0;
+
+struct options {
+    std::filesystem::path baseline;
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "tierone-tar-perf-check";
+    std::optional<std::filesystem::path> fixtures;
+    double scale = 0.01;
+    double tolerance = 2.0;
+    bool update = false;
+};
+
+std::optional<options> parse_options(const int argc, char* argv[]) {
+    options result;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--update") {
+            result.update = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            return std::nullopt;
+        }
+        const std::string_view value = argv[++i];
+        if (arg == "--baseline") {
+            result.baseline = value;
+        } else if (arg == "--dir") {
+            result.dir = value;
+        } else if (arg == "--fixtures") {
+            result.fixtures = value;
+        } else if (arg == "--scale") {
+            result.scale = std::stod(std::string{value});
+        } else if (arg == "--tolerance") {
+            result.tolerance = std::stod(std::string{value});
+        } else {
+            return std::nullopt;
+        }
+    }
+    if (result.baseline.empty() || result.scale <= 0 || result.tolerance < 1) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+// Build type and cost per measurement name
+struct baseline {
+    std::string build;
+    std::map<std::string, double, std::less<>> costs;
+};
+
+// Lines of "name cost" after one "build TYPE" line, '#' starts a comment
+std::optional<baseline> read_baseline(const std::filesystem::path& path) {
+    std::ifstream file{path};
+    if (!file) {
+        return std::nullopt;
+    }
+    baseline result;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line.starts_with('#')) {
+            continue;
+        }
+        std::istringstream fields{line};
+        std::string name;
+        std::string value;
+        fields >> name >> value;
+        if (name == "build") {
+            result.build = value;
+        } else if (double cost = 0; std::from_chars(value.data(), value.data() + value.size(), cost).ec == std::errc{}) {
+            result.costs.emplace(name, cost);
+        }
+    }
+    return result;
+}
+
+bool write_baseline(const std::filesystem::path& path, const std::map<std::string, double, std::less<>>& costs) {
+    std::ofstream file{path};
+    std::println(file, "# Throughput baseline for tierone-tar-perf-check, written by --update");
+    std::println(file, "# Time of each operation divided by the time to hash the same archive");
+    std::println(file, "# bytes, lower is faster. Regenerate on a quiet machine after changes");
+    std::println(file, "# that are meant to move these figures.");
+    std::println(file, "build {}", TIERONE_TAR_PERF_BUILD);
+    for (const auto& [name, cost] : costs) {
+        std::println(file, "{} {:.4f}", name, cost);
+    }
+    return static_cast<bool>(file);
+}
+
+// Best time per call over several rounds, each running op for a while
+// The minimum is the figure least disturbed by other load on the machine.
+template<typename Op>
+double best_seconds(Op op) {
+    double best = std::numeric_limits<double>::max();
+    for (int round = 0; round < rounds; ++round) {
+        const auto start = std::chrono::steady_clock::now();
+        uint64_t calls = 0;
+        std::chrono::duration<double> elapsed{};
+        do {
+            op();
+            ++calls;
+            elapsed = std::chrono::steady_clock::now() - start;
+        } while (elapsed < min_round_time);
+        best = std::min(best, elapsed.count() / static_cast<double>(calls));
+    }
+    return best;
+}
+
+// The reference work costs are measured in, a serial byte-at-a-time hash
+// It runs at the speed of the core and compiler settings of this build, as
+// the library does, and no library change can make it faster or slower.
+uint64_t fnv1a(const std::span<const std::byte> data) {
+    uint64_t hash = 0xcbf2'9ce4'8422'2325;
+    for (const auto byte : data) {
+        hash = (hash ^ static_cast<uint64_t>(byte)) * 0x100'0000'01b3;
+    }
+    return hash;
+}
+
+std::expected<std::vector<std::byte>, error> load(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    std::vector<std::byte> data(std::filesystem::file_size(path));
+    if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()))) {
+        return std::unexpected(error{error_code::io_error, "Cannot read " + path.string()});
+    }
+    return data;
+}
+
+std::expected<uint64_t, error> list(archive_reader& reader) {
+    uint64_t entries = 0;
+    while (true) {
+        auto view = reader.next_entry_view();
+        if (!view) {
+            return std::unexpected(view.error());
+        }
+        if (!*view) {
+            return entries;
+        }
+        ++entries;
+    }
+}
+
+std::expected<uint64_t, error> read_all(archive_reader& reader, std::span<std::byte> buffer) {
+    uint64_t bytes = 0;
+    while (true) {
+        auto entry = reader.next_entry();
+        if (!entry) {
+            return std::unexpected(entry.error());
+        }
+        if (!*entry) {
+            return bytes;
+        }
+        if (!(*entry)->is_regular_file()) {
+            continue;
+        }
+        for (uint64_t offset = 0; ; ) {
+            auto count = (*entry)->read_into(static_cast<size_t>(offset), buffer);
+            if (!count) {
+                return std::unexpected(count.error());
+            }
+            if (*count == 0) {
+                break;
+            }
+            offset += *count;
+            bytes += *count;
+        }
+    }
+}
+
+std::expected<uint64_t, error> index(archive_reader& reader) {
+    auto built = archive_index::build(reader);
+    if (!built) {
+        return std::unexpected(built.error());
+    }
+    return built->records().size();
+}
+
+// Costs of every operation on one archive, keyed "op/name"
+std::expected<void, error> measure(
+    const std::string& name,
+    const std::vector<std::byte>& archive,
+    std::map<std::string, double, std::less<>>& costs) {
+    uint64_t sink = 0;
+    const double reference = best_seconds([&] { sink += fnv1a(archive); });
+
+    std::vector<std::byte> buffer(default_chunk_size);
+    const std::vector<std::pair<std::string_view, std::function<std::expected<uint64_t, error>(archive_reader&)>>> ops{
+        {"list", list},
+        {"read", [&buffer](archive_reader& reader) { return read_all(reader, buffer); }},
+        {"index", index},
+    };
+    for (const auto& [op_name, op] : ops) {
+        std::optional<error> failure;
+        const double seconds = best_seconds([&] {
+            archive_reader reader{std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive})};
+            auto seen = op(reader);
+            if (!seen) {
+                failure = seen.error();
+            } else {
+                sink += *seen;
+            }
+        });
+        if (failure) {
+            return std::unexpected(*failure);
+        }
+        costs[std::format("{}/{}", op_name, name)] = seconds / reference;
+    }
+    keep = sink;
+    return {};
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const auto opts = parse_options(argc, argv);
+    if (!opts) {
+        std::println(stderr, "Usage: {} --baseline FILE [--dir PATH] [--scale F] [--fixtures DIR] "
+                     "[--tolerance X] [--update]", argv[0]);
+        return 1;
+    }
+
+    std::optional<baseline> stored;
+    if (!opts->update) {
+        stored = read_baseline(opts->baseline);
+        if (!stored) {
+            std::println(stderr, "Cannot read baseline {}", opts->baseline.string());
+            return 1;
+        }
+        if (stored->build != TIERONE_TAR_PERF_BUILD) {
+            std::println(stderr, "Baseline is for {} builds, this is a {} build; skipping",
+                         stored->build, TIERONE_TAR_PERF_BUILD);
+            return skipped;
+        }
+    }
+
+    std::vector<std::pair<std::string, std::filesystem::path>> archives;
+    for (const auto& spec : bench::default_specs(opts->scale)) {
+        auto stats = bench::generate(spec, opts->scale, opts->dir);
+        if (!stats) {
+            std::println(stderr, "Failed to generate {}: {}", spec.name, stats.error().message());
+            return 1;
+        }
+        archives.emplace_back(spec.name, stats->path);
+    }
+    if (opts->fixtures) {
+        std::vector<std::filesystem::path> found;
+        for (const auto& item : std::filesystem::directory_iterator{*opts->fixtures}) {
+            if (item.is_regular_file() && item.path().extension() == ".tar") {
+                found.push_back(item.path());
+            }
+        }
+        std::ranges::sort(found);
+        for (const auto& path : found) {
+            archives.emplace_back(path.stem().string(), path);
+        }
+    }
+
+    std::map<std::string, double, std::less<>> costs;
+    for (const auto& [name, path] : archives) {
+        auto archive = load(path);
+        if (!archive) {
+            std::println(stderr, "{}", archive.error().message());
+            return 1;
+        }
+        if (auto measured = measure(name, *archive, costs); !measured) {
+            std::println(stderr, "{} failed: {}", name, measured.error().message());
+            return 1;
+        }
+    }
+
+    if (opts->update) {
+        if (!write_baseline(opts->baseline, costs)) {
+            std::println(stderr, "Cannot write baseline {}", opts->baseline.string());
+            return 1;
+        }
+        std::println("Wrote {} costs to {}", costs.size(), opts->baseline.string());
+        return 0;
+    }
+
+    int regressions = 0;
+    std::println("{:<24} {:>10} {:>10} {:>8}", "measurement", "baseline", "cost", "ratio");
+    for (const auto& [name, cost] : costs) {
+        const auto known = stored->costs.find(name);
+        if (known == stored->costs.end()) {
+            std::println("{:<24} {:>10} {:>10.4f} {:>8}", name, "-", cost, "new");
+            continue;
+        }
+        const double ratio = cost / known->second;
+        const bool regressed = ratio > opts->tolerance;
+        regressions += regressed ? 1 : 0;
+        std::println("{:<24} {:>10.4f} {:>10.4f} {:>7.2f}x{}", name, known->second, cost, ratio,
+                     regressed ? "  REGRESSION" : "");
+    }
+    if (regressions > 0) {
+        std::println(stderr, "{} measurements more than {}x slower than the baseline", regressions, opts->tolerance);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,285 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "synthetic_archives.hpp"
+#include <tierone/tar/archive_reader.hpp>
+#include <tierone/tar/archive_writer.hpp>
+#include <tierone/tar/header_parser.hpp>
+#include <tierone/tar/stream.hpp>
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <random>
+
+namespace tierone::tar::bench {
+
+namespace {
+
+constexpr uint64_t seed = 0x7a72'6265'6e63'6801;
+constexpr size_t huge_files = 4;
+constexpr uint64_t huge_file_size = 256 * 1024 * 1024;
+constexpr size_t sparse_segments = 32;   // The sparse 1.0 map must fit one block
+constexpr uint64_t sparse_stride = 64 * 1024;
+constexpr uint64_t sparse_segment_size = 4096;
+
+// Repeatable file contents, a function of the file index and offset only
+void fill_pattern(std::span<std::byte> out, const uint64_t file, const uint64_t offset) {
+    for (size_t i = 0; i < out.size(); ++i) {
+        const uint64_t position = offset + i;
+        out[i] = static_cast<std::byte>((position * 131 + file * 7 + (position >> 12)) & 0xFF);
+    }
+}
+
+// Pattern data for one file, generated as the writer pulls it
+class pattern_stream : public input_stream {
+private:
+    uint64_t file_;
+    uint64_t size_;
+    uint64_t position_ = 0;
+
+public:
+    pattern_stream(const uint64_t file, const uint64_t size) : file_(file), size_(size) {}
+
+    [[nodiscard]] std::expected<size_t, error> read(std::span<std::byte> buffer) override {
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(buffer.size(), size_ - position_));
+        fill_pattern(buffer.first(count), file_, position_);
+        position_ += count;
+        return count;
+    }
+
+    [[nodiscard]] std::expected<void, error> skip(const uint64_t bytes) override {
+        position_ = std::min<uint64_t>(size_, position_ + bytes);
+        return {};
+    }
+
+    [[nodiscard]] bool at_end() const override { return position_ == size_; }
+};
+
+file_metadata make_file(std::string path, const uint64_t size) {
+    file_metadata meta;
+    meta.path = std::move(path);
+    meta.type = entry_type::regular_file;
+    meta.permissions = std::filesystem::perms{0644};
+    meta.size = size;
+    meta.modification_time = std::chrono::system_clock::from_time_t(1700000000);
+    meta.owner_name = "bench";
+    meta.group_name = "bench";
+    return meta;
+}
+
+std::expected<void, error> write_members(archive_writer& writer, const archive_spec& spec, const double scale) {
+    std::mt19937_64 random{seed + static_cast<uint64_t>(spec.kind)};
+    std::vector<std::byte> data;
+    const std::string deep_dir = std::string(60, 'd') + "/" + std::string(60, 'e');
+
+    for (uint64_t i = 0; i < spec.entries; ++i) {
+        switch (spec.kind) {
+            case archive_kind::tiny: {
+                data.resize(random() % 512);
+                fill_pattern(data, i, 0);
+                auto meta = make_file(std::format("tiny/d{:04}/f{:07}.txt", i / 1000, i), data.size());
+                if (auto added = writer.add_entry(meta, data); !added) {
+                    return added;
+                }
+                break;
+            }
+            case archive_kind::huge: {
+                const auto size = static_cast<uint64_t>(static_cast<double>(huge_file_size) * scale);
+                pattern_stream source{i, size};
+                if (auto added = writer.add_entry(make_file(std::format("huge/blob{}.bin", i), size), source); !added) {
+                    return added;
+                }
+                break;
+            }
+            case archive_kind::pax_heavy:
+            case archive_kind::gnu_longname: {
+                data.resize(random() % 2048);
+                fill_pattern(data, i, 0);
+                auto meta = make_file(std::format("{}/{}/file-{:07}.dat", spec.name, deep_dir, i), data.size());
+                if (spec.kind == archive_kind::pax_heavy) {
+                    meta.xattrs["user.origin"] = std::format("bench-{}", i);
+                }
+                if (auto added = writer.add_entry(meta, data); !added) {
+                    return added;
+                }
+                break;
+            }
+            case archive_kind::sparse:
+                break;  // Written by write_sparse_archive()
+        }
+    }
+    return {};
+}
+
+// ustar header block, GNU sparse members are not produced by archive_writer
+std::array<std::byte, detail::BLOCK_SIZE> raw_header(const std::string& name, const char type, const uint64_t size) {
+    std::array<std::byte, detail::BLOCK_SIZE> block{};
+    auto* raw = reinterpret_cast<char*>(block.data());
+    std::memcpy(raw, name.data(), std::min<size_t>(name.size(), 100));
+    std::snprintf(raw + 100, 8, "%07o", 0644u);
+    std::snprintf(raw + 108, 8, "%07o", 1000u);
+    std::snprintf(raw + 116, 8, "%07o", 1000u);
+    std::snprintf(raw + 124, 12, "%011llo", static_cast<unsigned long long>(size));
+    std::snprintf(raw + 136, 12, "%011o", 1700000000u);
+    raw[156] = type;
+    std::memcpy(raw + 257, "ustar", 6);
+    std::memcpy(raw + 263, "00", 2);
+    std::memset(raw + 148, ' ', 8);
+    std::snprintf(raw + 148, 8, "%06o", detail::calculate_checksum(block));
+    return block;
+}
+
+std::string pax_record(const std::string_view key, const std::string_view value) {
+    const size_t body = key.size() + value.size() + 3;  // ' ', '=', '\n'
+    size_t length = body + 1;
+    while (std::to_string(length).size() + body != length) {
+        ++length;
+    }
+    return std::format("{} {}={}\n", length, key, value);
+}
+
+std::expected<void, error> write_padded(output_stream& out, std::span<const std::byte> data) {
+    static constexpr std::array<std::byte, detail::BLOCK_SIZE> zeros{};
+    if (auto written = out.write(data); !written) {
+        return written;
+    }
+    const size_t padding = (detail::BLOCK_SIZE - data.size() % detail::BLOCK_SIZE) % detail::BLOCK_SIZE;
+    return out.write(std::span{zeros}.first(padding));
+}
+
+std::expected<void, error> write_sparse_archive(const std::filesystem::path& path, const archive_spec& spec) {
+    auto out = file_output_stream::create(path);
+    if (!out) {
+        return std::unexpected(out.error());
+    }
+
+    const uint64_t real_size = sparse_segments * sparse_stride;
+    std::string map = std::format("{}\n", sparse_segments);
+    for (size_t s = 0; s < sparse_segments; ++s) {
+        map += std::format("{}\n{}\n", s * sparse_stride, sparse_segment_size);
+    }
+    std::vector<std::byte> data(sparse_segments * sparse_segment_size);
+
+    for (uint64_t i = 0; i < spec.entries; ++i) {
+        const auto name = std::format("sparse/holes{:06}.img", i);
+        const auto records = pax_record("GNU.sparse.major", "1") + pax_record("GNU.sparse.minor", "0") +
+                             pax_record("GNU.sparse.name", name) +
+                             pax_record("GNU.sparse.realsize", std::to_string(real_size)) +
+                             pax_record("path", name);
+        fill_pattern(data, i, 0);
+
+        const auto pax_header = raw_header(std::format("PaxHeaders/{}", i), 'x', records.size());
+        const auto header = raw_header(std::format("GNUSparseFile.0/{}", i), '0', detail::BLOCK_SIZE + data.size());
+        const std::array<std::span<const std::byte>, 5> parts{
+            pax_header, std::as_bytes(std::span{records}), header, std::as_bytes(std::span{map}), data};
+        for (const auto part : parts) {
+            if (auto written = write_padded(*out, part); !written) {
+                return written;
+            }
+        }
+    }
+
+    static constexpr std::array<std::byte, 2 * detail::BLOCK_SIZE> end_marker{};
+    if (auto written = out->write(end_marker); !written) {
+        return written;
+    }
+    return out->flush();
+}
+
+// Entry count and logical data size, read back from the archive
+std::expected<archive_stats, error> measure(const std::filesystem::path& path) {
+    auto reader = archive_reader::from_file(path);
+    if (!reader) {
+        return std::unexpected(reader.error());
+    }
+    archive_stats stats{path};
+    while (true) {
+        auto entry = reader->next_entry();
+        if (!entry) {
+            return std::unexpected(entry.error());
+        }
+        if (!*entry) {
+            break;
+        }
+        ++stats.entries;
+        if ((*entry)->is_regular_file()) {
+            stats.data_bytes += (*entry)->size();
+        }
+    }
+    stats.file_bytes = std::filesystem::file_size(path);
+    return stats;
+}
+
+} // namespace
+
+auto default_specs(const double scale) -> std::vector<archive_spec> {
+    const auto scaled = [scale](const uint64_t count) {
+        return std::max<uint64_t>(1, static_cast<uint64_t>(std::llround(static_cast<double>(count) * scale)));
+    };
+    return {
+        {archive_kind::tiny, "tiny", scaled(1'000'000)},
+        {archive_kind::huge, "huge", huge_files},
+        {archive_kind::pax_heavy, "pax", scaled(200'000)},
+        {archive_kind::gnu_longname, "gnu", scaled(200'000)},
+        {archive_kind::sparse, "sparse", scaled(20'000)},
+    };
+}
+
+auto generate(const archive_spec& spec, const double scale, const std::filesystem::path& dir)
+    -> std::expected<archive_stats, error> {
+    std::error_code ec;
+    std::filesystem::create_directories(dir, ec);
+    if (ec) {
+        return std::unexpected(error{error_code::io_error, "Cannot create " + dir.string() + ": " + ec.message()});
+    }
+
+    const auto path = dir / std::format("{}-{}.tar", spec.name, scale);
+    if (std::filesystem::exists(path)) {
+        return measure(path);
+    }
+
+    // Written under a temporary name, so an interrupted run is not reused
+    const auto partial = dir / (path.filename().string() + ".partial");
+    if (spec.kind == archive_kind::sparse) {
+        if (auto written = write_sparse_archive(partial, spec); !written) {
+            return std::unexpected(written.error());
+        }
+    } else {
+        writer_options options;
+        options.long_names = spec.kind == archive_kind::gnu_longname ? long_name_format::gnu : long_name_format::pax;
+        auto writer = archive_writer::create(partial, options);
+        if (!writer) {
+            return std::unexpected(writer.error());
+        }
+        if (auto written = write_members(*writer, spec, scale); !written) {
+            return std::unexpected(written.error());
+        }
+        if (auto finished = writer->finish(); !finished) {
+            return std::unexpected(finished.error());
+        }
+    }
+
+    std::filesystem::rename(partial, path, ec);
+    if (ec) {
+        return std::unexpected(error{error_code::io_error, "Cannot rename " + partial.string() + ": " + ec.message()});
+    }
+    return measure(path);
+}
+
+} // namespace tierone::tar::bench
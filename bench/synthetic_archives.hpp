@@ -0,0 +1,61 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <tierone/tar/error.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace tierone::tar::bench {
+
+// Shapes of the generated archives
+enum class archive_kind {
+    tiny,         // Many small files, header-bound
+    huge,         // A few large files, throughput-bound
+    pax_heavy,    // Long paths and xattrs, a PAX header on every member
+    gnu_longname, // Long paths as GNU 'L' entries
+    sparse        // GNU sparse 1.0 members with many data segments
+};
+
+struct archive_spec {
+    archive_kind kind;
+    std::string name;
+    uint64_t entries;
+};
+
+// The suite at full size, scale multiplies every count and size
+[[nodiscard]] std::vector<archive_spec> default_specs(double scale);
+
+// What a generated archive holds, for throughput figures
+struct archive_stats {
+    std::filesystem::path path;
+    uint64_t entries = 0;
+    uint64_t data_bytes = 0;   // Logical bytes of all regular files
+    uint64_t file_bytes = 0;   // Size of the archive itself
+};
+
+// Write the archive for spec below dir, or reuse one written before
+// Contents depend only on the spec, so runs on different machines and days
+// read identical archives.
+[[nodiscard]] std::expected<archive_stats, error> generate(
+    const archive_spec& spec, double scale, const std::filesystem::path& dir);
+
+} // namespace tierone::tar::bench
@@ -0,0 +1,300 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/**
+ * tierone-tar-bench - Throughput of listing, reading and extraction on
+ * synthetic archives, across the stream types.
+ *
+ * Usage: ./tierone-tar-bench [--scale F] [--dir PATH] [--epochs N]
+ *                            [--filter TEXT] [--json FILE]
+ *
+ * Archives are generated on first use below --dir (default: the system temp
+ * directory) and reused afterwards. --scale shrinks or grows every archive,
+ * 1.0 being a million tiny files and four 256 MiB files. Listing reports
+ * entries/s, reading and extraction bytes/s of entry data. --filter runs only
+ * benchmarks whose name contains TEXT, such as "tiny" or "mmap".
+ */
+
+#include "synthetic_archives.hpp"
+#include <tierone/tar/tar.hpp>
+#include <nanobench.h>
+#include <charconv>
+#include <fstream>
+#include <optional>
+#include <print>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace tierone::tar;
+
+namespace {
+
+struct options {
+    double scale = 1.0;
+    std::filesystem::path dir = std::filesystem::temp_directory_path() / "tierone-tar-bench";
+    uint64_t epochs = 3;
+    std::string filter;
+    std::optional<std::filesystem::path> json;
+};
+
+enum class stream_kind { file, mmap, memory };
+
+constexpr std::string_view stream_name(const stream_kind kind) {
+    switch (kind) {
+        case stream_kind::file: return "file_stream";
+        case stream_kind::mmap: return "mmap_stream";
+        case stream_kind::memory: return "memory_mapped_stream";
+    }
+    return "";
+}
+
+std::optional<options> parse_options(const int argc, char* argv[]) {
+    options result;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (i + 1 >= argc) {
+            return std::nullopt;
+        }
+        const std::string_view value = argv[++i];
+        if (arg == "--scale") {
+            result.scale = std::stod(std::string{value});
+        } else if (arg == "--dir") {
+            result.dir = value;
+        } else if (arg == "--epochs") {
+            std::from_chars(value.data(), value.data() + value.size(), result.epochs);
+        } else if (arg == "--filter") {
+            result.filter = value;
+        } else if (arg == "--json") {
+            result.json = value;
+        } else {
+            return std::nullopt;
+        }
+    }
+    if (result.scale <= 0 || result.epochs == 0) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+std::expected<std::unique_ptr<input_stream>, error> open_stream(
+    const stream_kind kind, const std::filesystem::path& path, const std::vector<std::byte>& loaded) {
+    switch (kind) {
+        case stream_kind::file: {
+            auto stream = file_stream::open(path);
+            if (!stream) {
+                return std::unexpected(stream.error());
+            }
+            return std::make_unique<file_stream>(std::move(*stream));
+        }
+        case stream_kind::mmap: {
+            auto stream = mmap_stream::create(path);
+            if (!stream) {
+                return std::unexpected(stream.error());
+            }
+            return std::make_unique<mmap_stream>(std::move(*stream));
+        }
+        case stream_kind::memory:
+            return std::make_unique<memory_mapped_stream>(std::span<const std::byte>{loaded});
+    }
+    return std::unexpected(error{error_code::invalid_operation, "Unknown stream kind"});
+}
+
+std::expected<std::vector<std::byte>, error> load(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    std::vector<std::byte> data(std::filesystem::file_size(path));
+    if (!file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(data.size()))) {
+        return std::unexpected(error{error_code::io_error, "Cannot read " + path.string()});
+    }
+    return data;
+}
+
+// Entries seen by walking every header
+std::expected<uint64_t, error> list(archive_reader& reader) {
+    uint64_t entries = 0;
+    while (true) {
+        auto view = reader.next_entry_view();
+        if (!view) {
+            return std::unexpected(view.error());
+        }
+        if (!*view) {
+            return entries;
+        }
+        ++entries;
+    }
+}
+
+// Bytes of entry data read through a fixed buffer
+std::expected<uint64_t, error> read_all(archive_reader& reader, std::span<std::byte> buffer) {
+    uint64_t bytes = 0;
+    while (true) {
+        auto entry = reader.next_entry();
+        if (!entry) {
+            return std::unexpected(entry.error());
+        }
+        if (!*entry) {
+            return bytes;
+        }
+        if (!(*entry)->is_regular_file()) {
+            continue;
+        }
+        for (uint64_t offset = 0; ; ) {
+            auto count = (*entry)->read_into(static_cast<size_t>(offset), buffer);
+            if (!count) {
+                return std::unexpected(count.error());
+            }
+            if (*count == 0) {
+                break;
+            }
+            offset += *count;
+            bytes += *count;
+        }
+    }
+}
+
+class suite {
+private:
+    const options& options_;
+    std::optional<error> failure_;
+    ankerl::nanobench::Bench list_;
+    ankerl::nanobench::Bench read_;
+    ankerl::nanobench::Bench extract_;
+    std::vector<std::byte> buffer_ = std::vector<std::byte>(default_chunk_size);
+
+    [[nodiscard]] bool selected(const std::string& name) const {
+        return options_.filter.empty() || name.find(options_.filter) != std::string::npos;
+    }
+
+    // Run op once per iteration on a fresh reader, failing the suite on error
+    // or when it does not see the expected amount
+    template<typename Op>
+    void run(ankerl::nanobench::Bench& bench, const std::string& name, const uint64_t expected,
+             const stream_kind kind, const bench::archive_stats& stats,
+             const std::vector<std::byte>& loaded, Op op) {
+        if (!selected(name) || failure_) {
+            return;
+        }
+        bench.batch(expected).run(name, [&] {
+            if (failure_) {
+                return;
+            }
+            auto stream = open_stream(kind, stats.path, loaded);
+            if (!stream) {
+                failure_ = stream.error();
+                return;
+            }
+            archive_reader reader{std::move(*stream)};
+            auto seen = op(reader);
+            if (!seen) {
+                failure_ = seen.error();
+            } else if (*seen != expected) {
+                failure_ = error{error_code::corrupt_archive,
+                    std::format("{} saw {} instead of {}", name, *seen, expected)};
+            }
+            ankerl::nanobench::doNotOptimizeAway(seen.has_value());
+        });
+    }
+
+    static void configure(ankerl::nanobench::Bench& bench, const char* title, const char* unit, const uint64_t epochs) {
+        bench.title(title).unit(unit).epochs(epochs).epochIterations(1).warmup(1).relative(false);
+    }
+
+public:
+    explicit suite(const options& opts) : options_(opts) {
+        configure(list_, "Listing (next_entry_view)", "entry", opts.epochs);
+        configure(read_, "Reading (next_entry + read_into)", "byte", opts.epochs);
+        configure(extract_, "Extraction (extract_archive)", "byte", opts.epochs);
+    }
+
+    void run_archive(const bench::archive_stats& stats, const std::string& archive_name) {
+        std::vector<std::byte> loaded;
+        for (const auto kind : {stream_kind::file, stream_kind::mmap, stream_kind::memory}) {
+            const auto suffix = std::format("{}/{}", archive_name, stream_name(kind));
+            if (kind == stream_kind::memory && loaded.empty() &&
+                (selected("list/" + suffix) || selected("read/" + suffix) || selected("extract/" + suffix))) {
+                auto data = load(stats.path);
+                if (!data) {
+                    failure_ = data.error();
+                    return;
+                }
+                loaded = std::move(*data);
+            }
+
+            run(list_, "list/" + suffix, stats.entries, kind, stats, loaded,
+                [](archive_reader& reader) { return list(reader); });
+            run(read_, "read/" + suffix, stats.data_bytes, kind, stats, loaded,
+                [this](archive_reader& reader) { return read_all(reader, buffer_); });
+
+            // Every iteration extracts into its own directory, removed afterwards,
+            // so the timings do not include deleting the previous tree
+            const auto target = options_.dir / "extract";
+            uint64_t iteration = 0;
+            run(extract_, "extract/" + suffix, stats.data_bytes, kind, stats, loaded,
+                [&](archive_reader& reader) -> std::expected<uint64_t, error> {
+                    if (auto extracted = extract_archive(reader, target / std::to_string(iteration++)); !extracted) {
+                        return std::unexpected(extracted.error());
+                    }
+                    return stats.data_bytes;
+                });
+            std::error_code ec;
+            std::filesystem::remove_all(target, ec);
+        }
+    }
+
+    [[nodiscard]] const std::optional<error>& failure() const noexcept { return failure_; }
+
+    void write_json(std::ostream& out) const {
+        for (const auto* bench : {&list_, &read_, &extract_}) {
+            if (!bench->results().empty()) {
+                ankerl::nanobench::render(ankerl::nanobench::templates::json(), *bench, out);
+            }
+        }
+    }
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    const auto opts = parse_options(argc, argv);
+    if (!opts) {
+        std::println(stderr, "Usage: {} [--scale F] [--dir PATH] [--epochs N] [--filter TEXT] [--json FILE]", argv[0]);
+        return 1;
+    }
+
+    suite benchmarks{*opts};
+    for (const auto& spec : bench::default_specs(opts->scale)) {
+        std::println(stderr, "Preparing {} archive...", spec.name);
+        auto stats = bench::generate(spec, opts->scale, opts->dir);
+        if (!stats) {
+            std::println(stderr, "Failed to generate {}: {}", spec.name, stats.error().message());
+            return 1;
+        }
+        std::println(stderr, "{}: {} entries, {} data bytes, {} archive bytes",
+                     stats->path.string(), stats->entries, stats->data_bytes, stats->file_bytes);
+
+        benchmarks.run_archive(*stats, spec.name);
+        if (const auto& failure = benchmarks.failure()) {
+            std::println(stderr, "Benchmark failed: {}", failure->message());
+            return 1;
+        }
+    }
+
+    if (opts->json) {
+        std::ofstream out{*opts->json};
+        benchmarks.write_json(out);
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fuzz_budget.hpp"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <malloc.h>
+#include <new>
+
+namespace {
+
+std::atomic<size_t> live{0};
+std::atomic<size_t> peak{0};
+
+void* counted(void* block) {
+    if (block == nullptr) {
+        throw std::bad_alloc{};
+    }
+    const size_t now = live.fetch_add(malloc_usable_size(block), std::memory_order_relaxed) +
+                       malloc_usable_size(block);
+    size_t seen = peak.load(std::memory_order_relaxed);
+    while (now > seen && !peak.compare_exchange_weak(seen, now, std::memory_order_relaxed)) {
+    }
+    return block;
+}
+
+void uncounted(void* block) noexcept {
+    if (block != nullptr) {
+        live.fetch_sub(malloc_usable_size(block), std::memory_order_relaxed);
+        std::free(block);
+    }
+}
+
+} // anonymous namespace
+
+// Replacing the global allocation functions sees every new in the library,
+// including those of standard containers. malloc_usable_size() gives the
+// same figure on both sides, so nothing needs storing next to the block.
+void* operator new(const size_t size) {
+    return counted(std::malloc(size == 0 ? 1 : size));
+}
+
+void* operator new[](const size_t size) {
+    return counted(std::malloc(size == 0 ? 1 : size));
+}
+
+void* operator new(const size_t size, const std::align_val_t alignment) {
+    const auto align = static_cast<size_t>(alignment);
+    return counted(std::aligned_alloc(align, (size + align - 1) / align * align));
+}
+
+void* operator new[](const size_t size, const std::align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+void operator delete(void* block) noexcept { uncounted(block); }
+void operator delete[](void* block) noexcept { uncounted(block); }
+void operator delete(void* block, size_t) noexcept { uncounted(block); }
+void operator delete[](void* block, size_t) noexcept { uncounted(block); }
+void operator delete(void* block, std::align_val_t) noexcept { uncounted(block); }
+void operator delete[](void* block, std::align_val_t) noexcept { uncounted(block); }
+void operator delete(void* block, size_t, std::align_val_t) noexcept { uncounted(block); }
+void operator delete[](void* block, size_t, std::align_val_t) noexcept { uncounted(block); }
+
+namespace tierone::tar::fuzz {
+
+auto live_bytes() noexcept -> size_t {
+    return live.load(std::memory_order_relaxed);
+}
+
+budget_scope::budget_scope(const size_t input_size, const budget& limits) noexcept
+    : limits_(limits),
+      input_size_(input_size),
+      base_bytes_(live_bytes()),
+      start_(std::chrono::steady_clock::now()) {
+    peak.store(base_bytes_, std::memory_order_relaxed);
+}
+
+budget_scope::~budget_scope() {
+    const auto elapsed = std::chrono::steady_clock::now() - start_;
+    const auto time_limit = limits_.time + limits_.time_per_byte * input_size_;
+    const size_t used = peak.load(std::memory_order_relaxed) - base_bytes_;
+    const size_t memory_limit = limits_.memory + limits_.memory_per_byte * input_size_;
+
+    if (elapsed > time_limit) {
+        std::fprintf(stderr, "==fuzz budget== %zu byte input took %lld ms, budget %lld ms\n", input_size_,
+            static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()),
+            static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(time_limit).count()));
+        std::abort();
+    }
+    if (used > memory_limit) {
+        std::fprintf(stderr, "==fuzz budget== %zu byte input peaked at %zu heap bytes, budget %zu\n",
+            input_size_, used, memory_limit);
+        std::abort();
+    }
+}
+
+} // namespace tierone::tar::fuzz
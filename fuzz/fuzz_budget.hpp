@@ -0,0 +1,57 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace tierone::tar::fuzz {
+
+// Resources one input may use, a fixed allowance plus a share per input byte
+// Parsers are expected to stay linear in their input: a record length or a
+// segment count read from a few bytes must not buy megabytes of memory or
+// seconds of work. The allowances are loose enough for sanitizer builds.
+struct budget {
+    std::chrono::milliseconds time{250};
+    std::chrono::microseconds time_per_byte{2};
+    size_t memory = 1024 * 1024;          // Peak live heap bytes
+    size_t memory_per_byte = 64;
+};
+
+// Live heap bytes allocated through operator new, counted by fuzz_budget.cpp
+[[nodiscard]] size_t live_bytes() noexcept;
+
+// Checks one input against its budget when it goes out of scope
+// Exceeding either allowance prints what was used and aborts, which both
+// libFuzzer and the replay driver report as a crash with the input saved.
+class budget_scope {
+private:
+    budget limits_;
+    size_t input_size_;
+    size_t base_bytes_;
+    std::chrono::steady_clock::time_point start_;
+
+public:
+    explicit budget_scope(size_t input_size, const budget& limits = {}) noexcept;
+    ~budget_scope();
+
+    budget_scope(const budget_scope&) = delete;
+    budget_scope& operator=(const budget_scope&) = delete;
+};
+
+} // namespace tierone::tar::fuzz
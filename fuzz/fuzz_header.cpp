@@ -0,0 +1,66 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Fuzz target for detail::parse_header() and entry_view::parse()
+// The input is cut into header blocks, the last one padded with zeros.
+
+#include "fuzz_budget.hpp"
+#include <tierone/tar/entry_view.hpp>
+#include <tierone/tar/header_parser.hpp>
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+using namespace tierone::tar;
+
+namespace {
+
+void parse_block(const std::span<const std::byte, detail::BLOCK_SIZE> block) {
+    (void)detail::is_zero_block(block);
+    for (const auto replaced : {detail::replaced_fields{}, detail::replaced_fields{true, true}}) {
+        if (auto metadata = detail::parse_header(block, replaced)) {
+            (void)metadata->path.native().size();
+            (void)metadata->link_target;
+        }
+    }
+
+    auto view = entry_view::parse(block);
+    if (!view) {
+        return;
+    }
+    (void)view->path();
+    (void)view->link_target();
+    (void)view->owner_name();
+    (void)view->size();
+    (void)view->file_size();
+    (void)view->permissions();
+    (void)view->owner_id();
+    (void)view->modification_time();
+    (void)view->to_metadata();
+}
+
+} // anonymous namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, const size_t size) {
+    const fuzz::budget_scope scope{size};
+    for (size_t offset = 0; offset < size; offset += detail::BLOCK_SIZE) {
+        std::array<std::byte, detail::BLOCK_SIZE> block{};
+        std::memcpy(block.data(), data + offset, std::min(detail::BLOCK_SIZE, size - offset));
+        parse_block(block);
+    }
+    return 0;
+}
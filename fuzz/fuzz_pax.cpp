@@ -0,0 +1,57 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Fuzz target for the PAX record parsers
+// The input is the data of one extended header. Both the view form the
+// reader uses and the owning map are parsed, then everything derived from
+// them: metadata, xattrs, ACLs and a GNU sparse 1.0 map.
+
+#include "fuzz_budget.hpp"
+#include <tierone/tar/metadata.hpp>
+#include <tierone/tar/pax_parser.hpp>
+#include <tierone/tar/sparse.hpp>
+#include <span>
+
+using namespace tierone::tar;
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, const size_t size) {
+    const fuzz::budget_scope scope{size};
+    const auto input = std::as_bytes(std::span{data, size});
+
+    pax::extended_header header;
+    if (pax::parse_records(input, header)) {
+        file_metadata metadata;
+        header.apply_to(metadata);
+        (void)pax::extract_extended_attributes(header);
+        (void)pax::extract_acls(header);
+    }
+
+    auto headers = pax::parse_pax_headers(input);
+    if (!headers) {
+        return 0;
+    }
+    (void)pax::extract_extended_attributes(*headers);
+    (void)pax::extract_acls(*headers);
+    if (pax::has_gnu_sparse_markers(*headers)) {
+        (void)pax::get_gnu_sparse_version(*headers);
+        if (auto sparse_map = sparse::parse_sparse_1_0_header(*headers)) {
+            sparse_map->index_segments();
+            (void)sparse_map->find_segment(sparse_map->real_size / 2);
+        }
+    }
+    return 0;
+}
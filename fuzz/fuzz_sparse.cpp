@@ -0,0 +1,88 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Fuzz target for the GNU sparse map parsers
+// Every input is tried in each form a map takes: an old GNU header block
+// with the extension blocks after it, the decimal map at the start of sparse
+// 1.0 data, and the comma-separated GNU.sparse.map value of PAX headers.
+
+#include "fuzz_budget.hpp"
+#include <tierone/tar/header_parser.hpp>
+#include <tierone/tar/metadata.hpp>
+#include <tierone/tar/sparse.hpp>
+#include <tierone/tar/stream.hpp>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <map>
+#include <span>
+#include <string>
+
+using namespace tierone::tar;
+
+namespace {
+
+// Look up offsets in and around every segment, as readers of the file would
+void walk(sparse::sparse_metadata& info) {
+    info.index_segments();
+    (void)info.total_data_size();
+    sparse::segment_cursor cursor;
+    for (size_t i = 0; i < info.segments.size(); ++i) {
+        const auto& segment = info.segments[i];
+        (void)cursor.locate(info, segment.offset);
+        (void)cursor.locate(info, segment.offset + segment.size);
+        (void)info.data_offset_of(i);
+    }
+    (void)info.find_segment(info.real_size);
+}
+
+} // anonymous namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, const size_t size) {
+    const fuzz::budget_scope scope{size};
+    const auto input = std::as_bytes(std::span{data, size});
+
+    if (size >= detail::BLOCK_SIZE) {
+        std::array<std::byte, detail::BLOCK_SIZE> block;
+        std::memcpy(block.data(), data, block.size());
+        const auto& header = *reinterpret_cast<const ustar_header*>(block.data());
+        if (auto info = sparse::parse_old_sparse_header(header)) {
+            if (sparse::old_map_continues(block)) {
+                memory_mapped_stream extensions{input.subspan(detail::BLOCK_SIZE)};
+                (void)sparse::read_sparse_map_continuation(extensions, *info);
+            }
+            walk(*info);
+        }
+    }
+
+    {
+        memory_mapped_stream stream{input};
+        if (auto info = sparse::parse_sparse_1_0_data_map(stream, std::numeric_limits<uint64_t>::max())) {
+            walk(*info);
+        }
+    }
+
+    const std::map<std::string, std::string> headers{
+        {"GNU.sparse.major", "1"},
+        {"GNU.sparse.minor", "0"},
+        {"GNU.sparse.map", std::string{reinterpret_cast<const char*>(data), size}},
+    };
+    if (auto info = sparse::parse_sparse_1_0_header(headers)) {
+        walk(*info);
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+// Runs a fuzz target over saved inputs, for compilers without libFuzzer
+// Usage: <target> FILE|DIR...
+// Directories are walked recursively. The target's budget checks apply as
+// under libFuzzer, so the corpus doubles as a regression test under CTest.
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <print>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace {
+
+bool replay(const std::filesystem::path& path) {
+    std::ifstream file{path, std::ios::binary};
+    if (!file) {
+        std::println(stderr, "Cannot read {}", path.string());
+        return false;
+    }
+    const std::vector<uint8_t> input{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+    std::println(stderr, "Running {} ({} bytes)", path.string(), input.size());
+    LLVMFuzzerTestOneInput(input.data(), input.size());
+    return true;
+}
+
+} // anonymous namespace
+
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        std::println(stderr, "Usage: {} FILE|DIR...", argv[0]);
+        return 1;
+    }
+
+    size_t inputs = 0;
+    for (int i = 1; i < argc; ++i) {
+        const std::filesystem::path arg{argv[i]};
+        if (!std::filesystem::is_directory(arg)) {
+            if (!replay(arg)) {
+                return 1;
+            }
+            ++inputs;
+            continue;
+        }
+        for (const auto& item : std::filesystem::recursive_directory_iterator{arg}) {
+            if (item.is_regular_file()) {
+                if (!replay(item.path())) {
+                    return 1;
+                }
+                ++inputs;
+            }
+        }
+    }
+    std::println(stderr, "Replayed {} inputs", inputs);
+    return 0;
+}
@@ -17,30 +17,129 @@
 #pragma once
 
 #include <tierone/tar/error.hpp>
+#include <tierone/tar/digest.hpp>
 #include <tierone/tar/metadata.hpp>
+#include <tierone/tar/reader_stats.hpp>
 #include <expected>
 #include <span>
 #include <variant>
 #include <functional>
 #include <filesystem>
+#include <iosfwd>
 #include <limits>
+#include <optional>
 #include <algorithm>
 #include <ranges>
 #include <iterator>
+#include <vector>
 
 namespace tierone::tar {
 
 // Function signature for reading entry data
 using data_reader_fn = std::function<std::expected<std::span<const std::byte>, error>(size_t offset, size_t length)>;
 
+// Function signature for reading entry data into a caller-owned buffer
+// Returns the number of bytes written, 0 once the end of the data is reached
+using data_read_into_fn = std::function<std::expected<size_t, error>(size_t offset, std::span<std::byte> buffer)>;
+
+// Default chunk size used when entry data is copied out piece by piece
+constexpr size_t default_chunk_size = 64 * 1024;
+
+class entry_reader;
+class sparse_run_reader;
+class input_stream;
+class random_access_stream;
+
+// Stored bytes of an entry inside an archive being read by archive_reader
+// Either a span of a mapped archive or the reader's stream, with pointers to
+// the reader's position bookkeeping. Copying one never allocates, and entries
+// built on it expand sparse maps from their own metadata on read.
+class archive_data_source {
+private:
+    std::span<const std::byte> mapped_;
+    input_stream* stream_ = nullptr;
+    random_access_stream* seekable_ = nullptr;  // stream_, when it can seek
+    uint64_t* remaining_ = nullptr;             // Stored bytes not yet read
+    uint64_t* consumed_ = nullptr;              // Stored bytes read so far
+    uint64_t stored_size_ = 0;
+    uint64_t data_start_ = 0;                   // Stream position of the first byte
+    reader_stats* stats_ = nullptr;             // Counters of the owning reader
+    detail::digest_slot* digests_ = nullptr;    // Hashes of the owning reader's current entry
+    uint64_t entry_number_ = 0;                 // This entry's number in digests_
+    const uint64_t* current_entry_ = nullptr;   // Number of the owning reader's current entry
+
+public:
+    explicit archive_data_source(std::span<const std::byte> mapped,
+                                 detail::digest_slot* digests = nullptr, uint64_t entry_number = 0)
+        : mapped_(mapped), stored_size_(mapped.size()), digests_(digests), entry_number_(entry_number) {}
+
+    archive_data_source(input_stream& stream, random_access_stream* seekable,
+                        uint64_t& remaining, uint64_t& consumed, uint64_t stored_size, uint64_t data_start,
+                        reader_stats* stats = nullptr,
+                        detail::digest_slot* digests = nullptr, uint64_t entry_number = 0,
+                        const uint64_t* current_entry = nullptr)
+        : stream_(&stream), seekable_(seekable), remaining_(&remaining), consumed_(&consumed),
+          stored_size_(stored_size), data_start_(data_start), stats_(stats),
+          digests_(digests), entry_number_(entry_number), current_entry_(current_entry) {}
+
+    // Read stored bytes at offset, 0 at their end
+    // Streams without seek() can only move forward. Once the reader has moved
+    // past the entry its bytes are gone from the stream, reads then fail.
+    [[nodiscard]] std::expected<size_t, error> read(size_t offset, std::span<std::byte> buffer) const;
+
+    // Feed stored bytes at offset, handed out without read(), to the digests
+    void digest(const size_t offset, const std::span<const std::byte> data) const noexcept {
+        if (digests_) {
+            digests_->update(entry_number_, offset, data);
+        }
+    }
+
+    // Digests of the stored bytes, once all of them have been read in order
+    [[nodiscard]] std::optional<entry_digests> digests() const noexcept {
+        if (digests_ && digests_->entry == entry_number_) {
+            return digests_->result;
+        }
+        return std::nullopt;
+    }
+
+    // The stored bytes, when the archive is mapped
+    [[nodiscard]] std::optional<std::span<const std::byte>> mapped() const noexcept {
+        if (stream_) {
+            return std::nullopt;
+        }
+        return mapped_;
+    }
+};
+
 class archive_entry {
 private:
     file_metadata metadata_;
     std::variant<
         data_reader_fn,                      // Back to function for simplicity
-        std::span<const std::byte>           // For memory-mapped mode
+        std::span<const std::byte>,          // For memory-mapped mode
+        data_read_into_fn,                   // For chunked streaming mode
+        archive_data_source                  // Entries produced by archive_reader
     > data_source_;
 
+    // Packed segment data of a sparse entry in a mapped archive
+    std::optional<std::span<const std::byte>> stored_data_;
+
+    // Segment of the last sparse read, for archive_data_source entries
+    mutable sparse::segment_cursor cursor_;
+
+    // Bytes handed out by read_data() when they cannot be read in place
+    mutable std::vector<std::byte> chunk_buffer_;
+
+    friend class sparse_run_reader;
+
+    // Materialize a range through read_into() into chunk_buffer_
+    [[nodiscard]] std::expected<std::span<const std::byte>, error> read_chunked(
+        size_t offset, size_t length) const;
+
+    // Write only the data segments of a sparse entry, leaving holes unallocated
+    [[nodiscard]] std::expected<void, error> write_sparse_file(
+        std::ofstream& file, const std::filesystem::path& dest_path) const;
+
 public:
     // Constructor for streaming mode
     archive_entry(file_metadata metadata, data_reader_fn reader)
@@ -50,6 +149,24 @@ public:
     archive_entry(file_metadata metadata, std::span<const std::byte> data)
         : metadata_(std::move(metadata)), data_source_(data) {}
 
+    // Constructor for chunked streaming mode
+    archive_entry(file_metadata metadata, data_read_into_fn reader)
+        : metadata_(std::move(metadata)), data_source_(std::move(reader)) {}
+
+    // Constructor for sparse entries of a mapped archive
+    // stored_data holds the packed segments that reader expands
+    archive_entry(file_metadata metadata, data_read_into_fn reader, std::span<const std::byte> stored_data)
+        : metadata_(std::move(metadata)), data_source_(std::move(reader)), stored_data_(stored_data) {}
+
+    // Constructor for entries read from an archive
+    // Sparse entries read back expanded through metadata.sparse_info
+    archive_entry(file_metadata metadata, archive_data_source source)
+        : metadata_(std::move(metadata)), data_source_(source) {
+        if (metadata_.sparse_info) {
+            stored_data_ = source.mapped();
+        }
+    }
+
     // Metadata accessors
     [[nodiscard]] const std::filesystem::path& path() const noexcept { return metadata_.path; }
     [[nodiscard]] entry_type type() const noexcept { return metadata_.type; }
@@ -86,6 +203,8 @@ public:
     [[nodiscard]] bool has_acls() const noexcept { return metadata_.has_acls(); }
 
     // Data access
+    // Spans point into the mapped archive or into a buffer owned by this
+    // entry, valid until its next read_data() call or its destruction
     [[nodiscard]] auto read_data(
         size_t offset = 0,
         size_t length = std::numeric_limits<size_t>::max()
@@ -94,7 +213,7 @@ public:
             return std::unexpected(error{error_code::invalid_operation, "Entry is not a regular file"});
         }
 
-        return std::visit([=](const auto& source) -> std::expected<std::span<const std::byte>, error> {
+        return std::visit([=, this](const auto& source) -> std::expected<std::span<const std::byte>, error> {
             using T = std::decay_t<decltype(source)>;
             if constexpr (std::is_same_v<T, std::span<const std::byte>>) {
                 // Zero-copy for memory-mapped data
@@ -102,6 +221,20 @@ public:
                 size_t available = source.size() - start_offset;
                 size_t to_return = std::min(length, available);
                 return source.subspan(start_offset, to_return);
+            } else if constexpr (std::is_same_v<T, data_read_into_fn> || std::is_same_v<T, archive_data_source>) {
+                // Chunked streaming mode, bounded by the entry size
+                const uint64_t entry_size = size();
+                const size_t start_offset = static_cast<size_t>(std::min<uint64_t>(offset, entry_size));
+                const size_t available = static_cast<size_t>(entry_size - start_offset);
+                if constexpr (std::is_same_v<T, archive_data_source>) {
+                    // Mapped and not sparse: stored bytes are the data, hand them out in place
+                    if (const auto mapped = source.mapped(); mapped && !metadata_.sparse_info) {
+                        const auto data = mapped->subspan(start_offset, std::min(length, available));
+                        source.digest(start_offset, data);
+                        return data;
+                    }
+                }
+                return read_chunked(offset, std::min(length, available));
             } else {
                 // Streaming mode
                 return source(offset, length);
@@ -109,21 +242,119 @@ public:
         }, data_source_);
     }
 
+    // Read up to buffer.size() bytes starting at offset into a caller-owned buffer
+    // Returns the number of bytes read, 0 at the end of the entry data
+    [[nodiscard]] std::expected<size_t, error> read_into(size_t offset, std::span<std::byte> buffer) const;
+
+    // Open an incremental reader over the entry data
+    // The entry must outlive the returned reader
+    [[nodiscard]] std::expected<entry_reader, error> open_reader() const;
+
+    // Walk the entry as data runs and holes instead of a flattened stream
+    // Entries that are not sparse come back as data runs only
+    // The entry must outlive the returned reader
+    [[nodiscard]] std::expected<sparse_run_reader, error> open_sparse_runs() const;
+
+    // Check if the data is read straight out of a mapped archive, no I/O involved
+    [[nodiscard]] bool is_mapped() const noexcept;
+
+    // Digests of the data, once all of it has been read in order
+    // Only entries of an archive_reader with enable_digests() have them, and
+    // only while the reader is on them. Sparse entries are never hashed.
+    [[nodiscard]] std::optional<entry_digests> digests() const noexcept;
+
     // Extract entry to filesystem
     [[nodiscard]] std::expected<void, error> extract_to_path(const std::filesystem::path& dest_path) const;
 
-    // Copy data to output iterator
+    // Copy data to output iterator, one chunk at a time
     template<std::output_iterator<std::byte> OutputIt>
-    [[nodiscard]] auto copy_data_to(OutputIt output) const -> std::expected<size_t, error> {
-        auto data = read_data();
-        if (!data) return std::unexpected(data.error());
-        
-        std::ranges::copy(*data, output);
-        return data->size();
-    }
+    [[nodiscard]] auto copy_data_to(OutputIt output) const -> std::expected<size_t, error>;
 
     // Get full metadata
     [[nodiscard]] const file_metadata& metadata() const noexcept { return metadata_; }
 };
 
+// Incremental reader over the data of a single entry
+// Memory use is bounded by the caller's buffer, regardless of the entry size
+class entry_reader {
+private:
+    const archive_entry* entry_;
+    uint64_t position_ = 0;
+
+public:
+    explicit entry_reader(const archive_entry& entry) : entry_(&entry) {}
+
+    // Read up to buffer.size() bytes, returns 0 at the end of the entry
+    [[nodiscard]] std::expected<size_t, error> read_some(std::span<std::byte> buffer) {
+        auto result = entry_->read_into(static_cast<size_t>(position_), buffer);
+        if (result) {
+            position_ += *result;
+        }
+        return result;
+    }
+
+    [[nodiscard]] uint64_t position() const noexcept { return position_; }
+    [[nodiscard]] uint64_t remaining() const noexcept {
+        return entry_->size() > position_ ? entry_->size() - position_ : 0;
+    }
+    [[nodiscard]] bool at_end() const noexcept { return remaining() == 0; }
+};
+
+// One run of an entry's logical layout, either stored data or a hole
+struct sparse_run {
+    uint64_t offset = 0;              // Logical offset in the file
+    uint64_t length = 0;              // Bytes covered by the run
+    std::span<const std::byte> data;  // Contents of a data run, empty for holes
+    bool hole = false;
+
+    [[nodiscard]] bool is_hole() const noexcept { return hole; }
+};
+
+// Pulls the runs of an entry in offset order, holes are never materialized
+// Mapped archives hand out spans into the mapping, so a data run covers a
+// whole segment. Otherwise segments arrive in chunks of up to
+// default_chunk_size, read into a buffer that the next call reuses.
+class sparse_run_reader {
+private:
+    const archive_entry* entry_;
+    sparse::sparse_entry whole_file_;  // Single segment of a non-sparse entry
+    size_t segment_ = 0;               // Segment being consumed
+    uint64_t segment_consumed_ = 0;    // Bytes of it already returned
+    uint64_t stored_offset_ = 0;       // Matching offset in the packed data
+    uint64_t position_ = 0;            // Logical offset of the next run
+    std::vector<std::byte> buffer_;
+
+    [[nodiscard]] std::span<const sparse::sparse_entry> segments() const noexcept;
+    [[nodiscard]] std::optional<std::span<const std::byte>> stored_data() const noexcept;
+    [[nodiscard]] std::expected<std::span<const std::byte>, error> read_segment_data(uint64_t length);
+
+public:
+    explicit sparse_run_reader(const archive_entry& entry)
+        : entry_(&entry), whole_file_{0, entry.metadata().sparse_info ? 0 : entry.size()} {}
+
+    // The next run, std::nullopt once the end of the entry is reached
+    // Data spans stay valid until the next call
+    [[nodiscard]] std::expected<std::optional<sparse_run>, error> next_run();
+
+    [[nodiscard]] uint64_t position() const noexcept { return position_; }
+};
+
+template<std::output_iterator<std::byte> OutputIt>
+auto archive_entry::copy_data_to(OutputIt output) const -> std::expected<size_t, error> {
+    auto reader = open_reader();
+    if (!reader) return std::unexpected(reader.error());
+
+    std::vector<std::byte> buffer(static_cast<size_t>(std::min<uint64_t>(size(), default_chunk_size)));
+    size_t total = 0;
+    while (!buffer.empty()) {
+        auto chunk = reader->read_some(buffer);
+        if (!chunk) return std::unexpected(chunk.error());
+        if (*chunk == 0) break;
+
+        output = std::ranges::copy(std::span{buffer.data(), *chunk}, output).out;
+        total += *chunk;
+    }
+    return total;
+}
+
 } // namespace tierone::tar
\ No newline at end of file
@@ -0,0 +1,153 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <tierone/tar/error.hpp>
+#include <tierone/tar/metadata.hpp>
+#include <tierone/tar/stream.hpp>
+#include <tierone/tar/archive_index.hpp>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace tierone::tar {
+
+struct block_cache_options {
+    size_t block_size = 64 * 1024;           // Bytes read from the stream per miss
+    size_t capacity = 64 * 1024 * 1024;      // Bytes kept across all shards
+    size_t shards = 16;                      // Independently locked parts of the cache
+};
+
+// Least-recently-used cache of fixed-size blocks over a random_access_stream
+// Blocks are spread over shards by number, each with its own lock and LRU
+// list, so concurrent readers of different blocks rarely contend. Misses
+// are read from the stream under one lock of their own. Streams backed by
+// memory are read directly and never cached. Safe to use from several
+// threads.
+class block_cache {
+private:
+    using block = std::shared_ptr<const std::vector<std::byte>>;
+
+    struct shard {
+        std::mutex mutex;
+        std::list<std::pair<uint64_t, block>> lru;  // Most recently used first
+        std::unordered_map<uint64_t, std::list<std::pair<uint64_t, block>>::iterator> blocks;
+    };
+
+    std::unique_ptr<random_access_stream> stream_;
+    std::mutex stream_mutex_;
+    std::optional<std::span<const std::byte>> mapped_;
+    uint64_t size_ = 0;
+    size_t block_size_;
+    size_t blocks_per_shard_;
+    std::vector<std::unique_ptr<shard>> shards_;
+    std::atomic<uint64_t> hits_{0};
+    std::atomic<uint64_t> misses_{0};
+
+    [[nodiscard]] std::expected<block, error> fetch(uint64_t number);
+
+public:
+    explicit block_cache(std::unique_ptr<random_access_stream> stream, const block_cache_options& options = {});
+
+    // Copy up to buffer.size() bytes starting at offset
+    // Returns the number of bytes copied, short only at the end of the stream
+    [[nodiscard]] std::expected<size_t, error> read(uint64_t offset, std::span<std::byte> buffer);
+
+    [[nodiscard]] uint64_t size() const noexcept { return size_; }
+    [[nodiscard]] uint64_t hits() const noexcept { return hits_.load(std::memory_order_relaxed); }
+    [[nodiscard]] uint64_t misses() const noexcept { return misses_.load(std::memory_order_relaxed); }
+};
+
+// Directory entry as listed by archive_fs::readdir()
+struct fs_dir_entry {
+    std::string_view name;
+    entry_type type;
+};
+
+// Read-only filesystem view of an indexed archive
+//
+// The index is turned into an in-memory directory tree once. Paths are
+// those of the archive, without leading "/" or "./"; "" is the root.
+// Directories only implied by the paths of their members are listed too,
+// with mode 0755. Where a path occurs more than once the last member wins,
+// as with extraction. Symbolic links are not followed; hard links show the
+// metadata and data of their target. File data is read through a
+// block_cache, sparse files read back their holes as zeros. Everything is
+// immutable after open(), so all calls are safe from several threads,
+// which makes the view suitable for backing a FUSE mount.
+class archive_fs {
+private:
+    struct node {
+        file_metadata metadata;
+        entry_location location;
+        std::vector<size_t> children;  // Node numbers, sorted by name
+        std::string name;
+    };
+
+    std::vector<node> nodes_;  // Node 0 is the root
+    std::unordered_map<std::string, size_t> by_path_;
+    std::unique_ptr<block_cache> cache_;
+
+    archive_fs() = default;
+
+    [[nodiscard]] size_t directory_node(const std::string& path);
+    [[nodiscard]] std::expected<const node*, error> lookup(std::string_view path) const;
+
+public:
+    // Build the tree from an index of the archive in stream
+    [[nodiscard]] static std::expected<archive_fs, error> open(
+        const archive_index& index,
+        std::unique_ptr<random_access_stream> stream,
+        const block_cache_options& options = {});
+
+    // Index the archive file at path, then open it
+    // Compressed archives are read through their decompressing stream, so
+    // only seekable formats (BGZF, seekable zstd) can be opened.
+    [[nodiscard]] static std::expected<archive_fs, error> open(
+        const std::filesystem::path& path, const block_cache_options& options = {});
+
+    archive_fs(archive_fs&&) noexcept = default;
+    archive_fs& operator=(archive_fs&&) noexcept = default;
+
+    // Metadata of the entry at path, as with lstat()
+    // Errors carry the errno a filesystem would give, ENOENT if there is no
+    // such entry, ENOTDIR or EISDIR where the type does not fit the call.
+    [[nodiscard]] std::expected<const file_metadata*, error> stat(std::string_view path) const;
+
+    // Entries of the directory at path, sorted by name
+    // The names stay valid as long as the archive_fs.
+    [[nodiscard]] std::expected<std::vector<fs_dir_entry>, error> readdir(std::string_view path) const;
+
+    // Copy up to buffer.size() bytes of the file at path, from offset
+    // Returns the number of bytes copied, 0 at or past the end of the file
+    [[nodiscard]] std::expected<size_t, error> read(
+        std::string_view path, uint64_t offset, std::span<std::byte> buffer) const;
+
+    [[nodiscard]] const block_cache& cache() const noexcept { return *cache_; }
+};
+
+} // namespace tierone::tar
@@ -0,0 +1,68 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <tierone/tar/error.hpp>
+#include <tierone/tar/metadata.hpp>
+#include <tierone/tar/archive_reader.hpp>
+#include <expected>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace tierone::tar {
+
+// One entry of an archive index
+struct index_record {
+    file_metadata metadata;   // Final metadata, after GNU longname and PAX overrides
+    entry_location location;  // Header and data offsets inside the archive
+};
+
+// Random-access table of the entries of an archive
+class archive_index {
+private:
+    std::vector<index_record> records_;  // Archive order
+    std::vector<size_t> by_path_;        // Record indices sorted by path
+
+    void sort_paths();
+
+public:
+    archive_index() = default;
+    explicit archive_index(std::vector<index_record> records);
+
+    // Scan the whole archive once and record every entry
+    // The reader's stream must support random access
+    [[nodiscard]] static std::expected<archive_index, error> build(archive_reader& reader);
+
+    // Look up an entry by its archive path
+    // When a path occurs more than once, the last member wins, as with tar extraction
+    [[nodiscard]] const index_record* find(std::string_view path) const;
+
+    // Offset just past the last member's data and padding, where the
+    // end-of-archive marker starts; 0 for an empty archive
+    [[nodiscard]] uint64_t end_offset() const noexcept;
+
+    // Whether an update adds meta, as with tar -u: no member has its path
+    // yet, or the last one is older
+    [[nodiscard]] bool supersedes(const file_metadata& meta) const;
+
+    [[nodiscard]] std::span<const index_record> records() const noexcept { return records_; }
+    [[nodiscard]] size_t size() const noexcept { return records_.size(); }
+    [[nodiscard]] bool empty() const noexcept { return records_.empty(); }
+};
+
+} // namespace tierone::tar
@@ -19,9 +19,13 @@
 #include <tierone/tar/error.hpp>
 #include <tierone/tar/stream.hpp>
 #include <tierone/tar/archive_entry.hpp>
+#include <tierone/tar/entry_view.hpp>
 #include <tierone/tar/header_parser.hpp>
 #include <tierone/tar/gnu_tar.hpp>
+#include <tierone/tar/multi_volume.hpp>
 #include <tierone/tar/pax_parser.hpp>
+#include <tierone/tar/reader_stats.hpp>
+#include <concepts>
 #include <expected>
 #include <memory>
 #include <optional>
@@ -31,47 +35,166 @@
 
 namespace tierone::tar {
 
+// How archive_reader::from_file accesses the archive
+enum class access_mode {
+    streaming,  // Sequential reads through a file stream
+    mapped,     // Memory-mapped archive, entry data is handed out as zero-copy spans (Linux-only)
+    prefetch    // Several large reads kept in flight through io_uring, streaming where unavailable (Linux-only)
+};
+
+// Where an entry lives inside the archive
+struct entry_location {
+    uint64_t header_offset = 0;  // First header block, including PAX/GNU extension headers
+    uint64_t data_offset = 0;    // First byte of the stored data
+    uint64_t stored_size = 0;    // Bytes of stored data, excluding padding and sparse maps
+};
+
+struct index_record;
+class async_archive_reader;
+
 class archive_reader {
 private:
+    friend class async_archive_reader;  // Drives parsing over its own buffer
+
     std::unique_ptr<input_stream> stream_;  // Back to unique_ptr
-    std::optional<archive_entry> current_entry_;
-    size_t current_entry_data_remaining_ = 0;  // Data remaining for the current entry
-    size_t current_entry_data_consumed_ = 0;   // Data already consumed from the current entry
+    random_access_stream* random_access_ = nullptr;  // stream_ if it supports seeking
+    multi_volume_stream* volumes_ = nullptr;  // stream_ if it joins volumes, told where members start
+    bool peekable_ = false;  // Header blocks can be parsed in place from the stream's buffer
+    std::array<std::byte, detail::BLOCK_SIZE> block_buffer_{};  // Header copy for streams without peek()
+    std::optional<std::span<const std::byte>> mapped_data_;  // Whole archive, if stream_ is memory-backed
+    uint64_t current_entry_data_remaining_ = 0;  // Data remaining for the current entry
+    uint64_t current_entry_data_consumed_ = 0;   // Data already consumed from the current entry
+    uint64_t current_entry_stored_size_ = 0;     // Stored data size of the current entry, for padding
+    std::optional<uint64_t> pending_header_offset_;  // Offset of the first header of the entry being parsed
+    std::optional<entry_location> current_location_;
     bool finished_ = false;
     gnu::gnu_extension_data pending_gnu_extensions_;
-    std::optional<sparse::sparse_metadata> pending_sparse_info_;
-    std::map<std::string, std::string> pending_pax_headers_;
+    std::vector<std::byte> pax_buffer_;  // Payload of the last PAX header, viewed by pending_pax_
+    pax::extended_header pending_pax_;
+    std::vector<std::byte> global_buffer_;  // Payload of the last PAX global header
+    pax::extended_header global_records_;   // Records parsed from global_buffer_
+    pax::global_header global_pax_;         // Global values in force
     bool needs_sparse_1_0_processing_ = false;
+    bool sparse_extensions_pending_ = false;  // Old GNU sparse extension blocks of the last view are unread
+    bool view_extensions_held_ = false;  // Pending extensions still back the last entry_view
+    reader_stats stats_;
+    detail::digest_slot digests_;  // Hashes of the current entry, if enabled
+    uint64_t entry_count_ = 0;     // Number of the current entry, for digests_ and stale reads
 
-    // Read exactly one 512-byte block
-    [[nodiscard]] std::expected<std::array<std::byte, detail::BLOCK_SIZE>, error> read_block();
+    // Consume exactly one 512-byte block
+    // The view points into the stream's buffer when it can peek, otherwise into
+    // block_buffer_, and stays valid until the next stream read
+    [[nodiscard]] std::expected<std::span<const std::byte, detail::BLOCK_SIZE>, error> read_block();
 
     // Skip padding to the next 512-byte boundary
-    [[nodiscard]] std::expected<void, error> skip_padding(size_t data_size);
+    [[nodiscard]] std::expected<void, error> skip_padding(uint64_t data_size);
 
     // Skip remaining data from the current entry
     [[nodiscard]] std::expected<void, error> skip_current_entry_data();
 
+    // Drop extension data kept alive for the last entry_view
+    void release_view_extensions();
+
+    // Header fields that the pending GNU and PAX extensions replace
+    [[nodiscard]] detail::replaced_fields pending_replacements() const noexcept;
+
+    // Read the payload of an extension header, given its type and size
+    // Returns false if the type is not one this reader handles.
+    [[nodiscard]] std::expected<bool, error> process_extension_header(entry_type type, uint64_t size);
+
     // Process GNU extension entry
     [[nodiscard]] std::expected<bool, error> process_gnu_extension(const file_metadata& meta);
     
     // Process PAX extended header entry
     [[nodiscard]] std::expected<bool, error> process_pax_header(const file_metadata& meta);
     
-    // Process sparse file entry
-    [[nodiscard]] std::expected<void, error> process_sparse_file(const file_metadata& meta);
+    // Read the extension blocks of an old GNU sparse header into its map
+    // With no map given their segments are only walked past.
+    [[nodiscard]] std::expected<void, error> read_sparse_extensions(sparse::sparse_metadata* map);
+
+    // Read a GNU sparse 1.0 map from the start of the entry's data, block by block
+    [[nodiscard]] std::expected<void, error> read_sparse_map(sparse::sparse_metadata& map);
+
+    // Apply pending extensions to a parsed entry header and build the entry
+    [[nodiscard]] std::expected<archive_entry, error> finish_entry(file_metadata metadata);
+
+    // Number the next entry and start hashing it, if digests are enabled
+    // Returns the slot its data source feeds, nullptr if it is not hashed
+    [[nodiscard]] detail::digest_slot* begin_digests(const file_metadata& metadata);
+
+    // Build the entry for final metadata, with the stream positioned at its data
+    [[nodiscard]] std::expected<archive_entry, error> create_entry(file_metadata metadata);
+
+    // Full entry for the view just returned by next_entry_view()
+    [[nodiscard]] std::expected<archive_entry, error> entry_from_view(const entry_view& view);
+
+    // Take stream as the archive source and probe its capabilities
+    void attach(std::unique_ptr<input_stream> stream) {
+        stream_ = std::move(stream);
+        random_access_ = dynamic_cast<random_access_stream*>(stream_.get());
+        volumes_ = dynamic_cast<multi_volume_stream*>(stream_.get());
+        peekable_ = stream_ && stream_->can_peek();
+        mapped_data_.reset();
+        if (random_access_) {
+            mapped_data_ = random_access_->mapped_data();
+        }
+    }
 
 public:
-    explicit archive_reader(std::unique_ptr<input_stream> stream)
-        : stream_(std::move(stream)) {}
+    explicit archive_reader(std::unique_ptr<input_stream> stream) {
+        attach(std::move(stream));
+    }
 
     // Factory methods
-    [[nodiscard]] static std::expected<archive_reader, error> from_file(const std::filesystem::path& path);
+    [[nodiscard]] static std::expected<archive_reader, error> from_file(
+        const std::filesystem::path& path,
+        access_mode mode = access_mode::streaming);
     [[nodiscard]] static std::expected<archive_reader, error> from_stream(std::unique_ptr<input_stream> stream);
 
     // Get next entry in archive
     [[nodiscard]] std::expected<std::optional<archive_entry>, error> next_entry();
 
+    // Get the next entry as a header view, without building file_metadata
+    // Only GNU longname and PAX extension headers allocate. The entry's data is
+    // skipped on the next call; views stay valid until the reader advances.
+    [[nodiscard]] std::expected<std::optional<entry_view>, error> next_entry_view();
+
+    // Get the next entry whose entry_view satisfies filter
+    // Rejected entries cost a header check and one skip() of their data; no
+    // file_metadata is built for them. Accepts a path_filter or any predicate.
+    template<typename Filter>
+        requires std::predicate<const Filter&, const entry_view&>
+    [[nodiscard]] std::expected<std::optional<archive_entry>, error> next_entry(const Filter& filter) {
+        while (true) {
+            auto view = next_entry_view();
+            if (!view) {
+                return std::unexpected(view.error());
+            }
+            if (!*view) {
+                return std::nullopt;
+            }
+            if (filter(**view)) {
+                return entry_from_view(**view);
+            }
+        }
+    }
+
+    // Start over on another archive, keeping the buffers grown so far
+    // Entries, views and spans from the previous archive become invalid. A
+    // reader recycled this way makes no allocations of its own for archives
+    // no larger in their extension headers than ones it has already read.
+    // Returns the previous stream so its object can be reused as well.
+    // stats() starts over too.
+    std::unique_ptr<input_stream> reset(std::unique_ptr<input_stream> stream);
+
+    // Archive offsets of the entry most recently returned
+    // Only available when the stream supports random access
+    [[nodiscard]] const std::optional<entry_location>& current_location() const noexcept { return current_location_; }
+
+    // Seek straight to an indexed entry's data, without re-reading its headers
+    // Iteration continues with the entry that follows it
+    [[nodiscard]] std::expected<archive_entry, error> open_entry(const index_record& record);
+
     // Iterator support
     class iterator {
     private:
@@ -125,8 +248,30 @@ public:
     [[nodiscard]] iterator begin() { return iterator{this}; }
     [[nodiscard]] iterator end() const { return {}; }
 
+    // Values from the PAX global headers read so far
+    // They apply to every entry that follows, under its own PAX records
+    [[nodiscard]] const pax::global_header& global_pax_headers() const noexcept { return global_pax_; }
+
+    // Hash the data of each entry that follows as its caller reads it
+    // Digests are computed over the chunks already passing through the
+    // reader, see archive_entry::digests(). Entries of a mapped archive are
+    // then read through the reader too, which keeps read_data() zero-copy.
+    // An empty set turns hashing off again.
+    void enable_digests(const digest_set& algorithms) {
+        digests_ = detail::digest_slot{
+            .hasher = content_hasher{algorithms}, .entry = 0, .hashed = 0, .size = 0, .result = std::nullopt};
+    }
+
+    // Counters for the current archive, all zero unless built with
+    // TIERONE_TAR_ENABLE_STATS; reset() starts them over
+    [[nodiscard]] const reader_stats& stats() const noexcept { return stats_; }
+
     // Check if archive processing is complete
     [[nodiscard]] bool finished() const noexcept { return finished_; }
+
+    // Check if entries are handed out as zero-copy spans into the archive
+    // Such spans stay valid for the lifetime of the reader
+    [[nodiscard]] bool is_mapped() const noexcept { return mapped_data_.has_value(); }
 };
 
 } // namespace tierone::tar
\ No newline at end of file
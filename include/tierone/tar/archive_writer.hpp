@@ -0,0 +1,134 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <tierone/tar/error.hpp>
+#include <tierone/tar/metadata.hpp>
+#include <tierone/tar/stream.hpp>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace tierone::tar {
+
+class archive_index;
+
+// How paths and link targets that do not fit the ustar fields are stored
+enum class long_name_format {
+    pax,  // POSIX "path" and "linkpath" records
+    gnu   // GNU 'L' and 'K' entries, headers carry the GNU magic
+};
+
+struct writer_options {
+    long_name_format long_names = long_name_format::pax;
+
+    // Output is collected into blocks of this size before reaching the stream
+    // Entry data at least this large is written straight through
+    size_t buffer_size = 1024 * 1024;
+};
+
+// Sequential tar archive writer
+//
+// Headers are ustar. Values ustar cannot hold (sizes of 8 GiB and above,
+// large ids, times before the epoch, long owner names), extended attributes
+// and ACLs go into a PAX extended header in front of the entry, in both
+// formats. Call finish() to write the end-of-archive marker; an archive
+// dropped without it is truncated.
+class archive_writer {
+private:
+    std::unique_ptr<output_stream> output_;
+    writer_options options_;
+    std::vector<std::byte> buffer_;
+    size_t buffered_ = 0;
+    bool finished_ = false;
+
+    [[nodiscard]] std::expected<void, error> write_headers(const file_metadata& meta, uint64_t data_size);
+    [[nodiscard]] std::expected<void, error> write_extension(
+        char type, const std::string& name, std::span<const std::byte> payload);
+    [[nodiscard]] std::expected<void, error> write_bytes(std::span<const std::byte> data);
+    [[nodiscard]] std::expected<void, error> write_from(input_stream& source, uint64_t size);
+    [[nodiscard]] std::expected<void, error> write_padding(uint64_t data_size);
+    [[nodiscard]] std::expected<void, error> flush_buffer();
+    [[nodiscard]] std::expected<uint64_t, error> check_entry(const file_metadata& meta, bool stored = false) const;
+    [[nodiscard]] std::expected<uint64_t, error> begin_stored(const file_metadata& meta);
+
+public:
+    explicit archive_writer(std::unique_ptr<output_stream> output, const writer_options& options = {});
+
+    // Create or truncate an archive file
+    [[nodiscard]] static std::expected<archive_writer, error> create(
+        const std::filesystem::path& path, const writer_options& options = {});
+
+    // Open an existing archive to add entries at its end
+    // The end-of-archive marker after the last member is cut off and new
+    // entries are written in its place; finish() writes a new marker. The
+    // members are found by walking the headers, skipping all data.
+    [[nodiscard]] static std::expected<archive_writer, error> append(
+        const std::filesystem::path& path, const writer_options& options = {});
+
+    // Same, with the end taken from an index of the archive
+    // Only the blocks after the last member are read, to check that nothing
+    // but the end-of-archive marker is cut off.
+    [[nodiscard]] static std::expected<archive_writer, error> append(
+        const std::filesystem::path& path, const archive_index& index, const writer_options& options = {});
+
+    // Write an entry with its data taken from a span
+    // Regular files need data.size() == meta.size, other entry types no data
+    [[nodiscard]] std::expected<void, error> add_entry(
+        const file_metadata& meta, std::span<const std::byte> data = {});
+
+    // Write a regular file entry, streaming meta.size bytes from source
+    // The data is read straight into the output buffer
+    [[nodiscard]] std::expected<void, error> add_entry(const file_metadata& meta, input_stream& source);
+
+    // Write a regular file entry whose data is the file at source
+    // The file must hold exactly meta.size bytes. Where the output stream
+    // supports it the data is copied by the kernel and only headers and
+    // padding pass through the buffer.
+    [[nodiscard]] std::expected<void, error> add_file(const file_metadata& meta, const std::filesystem::path& source);
+
+    // Write a regular file entry from data in the form another archive stores it
+    // For a sparse entry (meta.sparse_info) that is only the segments' bytes,
+    // meta.sparse_info->total_data_size() of them; it is written as GNU
+    // sparse 1.0, with the map ahead of the data. Other entries take
+    // meta.size bytes, as add_entry() does.
+    [[nodiscard]] std::expected<void, error> add_stored(const file_metadata& meta, std::span<const std::byte> stored);
+    [[nodiscard]] std::expected<void, error> add_stored(const file_metadata& meta, input_stream& source);
+
+#ifdef __linux__
+    // Same, with the stored data read from fd starting at offset
+    // Where the output stream supports it the kernel copies the data, which
+    // then never passes through the buffer. The fd's file offset is not used.
+    [[nodiscard]] std::expected<void, error> add_stored(const file_metadata& meta, int fd, uint64_t offset);
+#endif
+
+    // Add the file at source only if it supersedes the archive's member at
+    // meta.path, as with tar -u, see archive_index::supersedes()
+    // Returns whether it was added. The index is not changed.
+    [[nodiscard]] std::expected<bool, error> update_file(
+        const archive_index& index, const file_metadata& meta, const std::filesystem::path& source);
+
+    // Write the end-of-archive marker and flush everything to the stream
+    [[nodiscard]] std::expected<void, error> finish();
+
+    [[nodiscard]] bool finished() const noexcept { return finished_; }
+};
+
+} // namespace tierone::tar
@@ -0,0 +1,274 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <tierone/tar/error.hpp>
+#include <tierone/tar/stream.hpp>
+#include <coroutine>
+#include <cstddef>
+#include <exception>
+#include <expected>
+#include <memory>
+#include <optional>
+#include <semaphore>
+#include <span>
+#include <utility>
+
+namespace tierone::tar {
+
+// Lazily started coroutine producing one T
+// Nothing runs until the task is awaited; completion resumes the awaiting
+// coroutine directly, on whichever thread finished the work. No executor is
+// involved, so tasks fit whatever scheduler the async stream resumes on.
+template<typename T>
+class task {
+public:
+    struct promise_type {
+        std::optional<T> value;
+        std::exception_ptr exception;
+        std::coroutine_handle<> continuation = std::noop_coroutine();
+
+        task get_return_object() noexcept {
+            return task{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        auto final_suspend() noexcept {
+            struct final_awaiter {
+                bool await_ready() noexcept { return false; }
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                    return handle.promise().continuation;
+                }
+                void await_resume() noexcept {}
+            };
+            return final_awaiter{};
+        }
+
+        template<typename U>
+        void return_value(U&& result) { value.emplace(std::forward<U>(result)); }
+
+        void unhandled_exception() noexcept { exception = std::current_exception(); }
+    };
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+
+    explicit task(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+public:
+    task(task&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    task& operator=(task&& other) noexcept {
+        std::swap(handle_, other.handle_);
+        return *this;
+    }
+    task(const task&) = delete;
+    task& operator=(const task&) = delete;
+
+    ~task() {
+        if (handle_) handle_.destroy();
+    }
+
+    auto operator co_await() noexcept {
+        struct awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() noexcept { return handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().continuation = awaiting;
+                return handle;
+            }
+
+            T await_resume() {
+                if (handle.promise().exception) {
+                    std::rethrow_exception(handle.promise().exception);
+                }
+                return std::move(*handle.promise().value);
+            }
+        };
+        return awaiter{handle_};
+    }
+};
+
+// Coroutine yielding a sequence of T, pulled with co_await next()
+// next() gives std::nullopt once the generator returns.
+template<typename T>
+class async_generator {
+public:
+    struct promise_type {
+        std::optional<T> current;
+        std::exception_ptr exception;
+        std::coroutine_handle<> consumer = std::noop_coroutine();
+
+        async_generator get_return_object() noexcept {
+            return async_generator{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct to_consumer {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                return handle.promise().consumer;
+            }
+            void await_resume() noexcept {}
+        };
+
+        to_consumer final_suspend() noexcept { return {}; }
+
+        to_consumer yield_value(T value) {
+            current.emplace(std::move(value));
+            return {};
+        }
+
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { exception = std::current_exception(); }
+    };
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+
+    explicit async_generator(std::coroutine_handle<promise_type> handle) noexcept : handle_(handle) {}
+
+public:
+    async_generator(async_generator&& other) noexcept : handle_(std::exchange(other.handle_, nullptr)) {}
+    async_generator& operator=(async_generator&& other) noexcept {
+        std::swap(handle_, other.handle_);
+        return *this;
+    }
+    async_generator(const async_generator&) = delete;
+    async_generator& operator=(const async_generator&) = delete;
+
+    ~async_generator() {
+        if (handle_) handle_.destroy();
+    }
+
+    // Resume the generator until it yields or returns
+    [[nodiscard]] auto next() noexcept {
+        struct awaiter {
+            std::coroutine_handle<promise_type> handle;
+
+            bool await_ready() noexcept { return handle.done(); }
+
+            std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+                handle.promise().consumer = awaiting;
+                return handle;
+            }
+
+            std::optional<T> await_resume() {
+                if (handle.promise().exception) {
+                    std::rethrow_exception(std::exchange(handle.promise().exception, nullptr));
+                }
+                return std::exchange(handle.promise().current, std::nullopt);
+            }
+        };
+        return awaiter{handle_};
+    }
+};
+
+namespace detail {
+
+// Top-level coroutine that signals a semaphore when done, for sync_wait()
+struct blocking_task {
+    struct promise_type {
+        std::binary_semaphore* done = nullptr;
+
+        blocking_task get_return_object() noexcept {
+            return blocking_task{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        auto final_suspend() noexcept {
+            struct signal {
+                bool await_ready() noexcept { return false; }
+                void await_suspend(std::coroutine_handle<promise_type> handle) noexcept {
+                    handle.promise().done->release();
+                }
+                void await_resume() noexcept {}
+            };
+            return signal{};
+        }
+
+        void return_void() noexcept {}
+        void unhandled_exception() noexcept { std::terminate(); }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+
+    blocking_task(blocking_task&& other) noexcept : handle(std::exchange(other.handle, nullptr)) {}
+    explicit blocking_task(std::coroutine_handle<promise_type> h) noexcept : handle(h) {}
+    ~blocking_task() {
+        if (handle) handle.destroy();
+    }
+};
+
+} // namespace detail
+
+// Run a task to completion, blocking the calling thread
+// For tests and for callers at the edge of an async program.
+template<typename T>
+T sync_wait(task<T> work) {
+    std::optional<T> result;
+    std::exception_ptr exception;
+    auto runner = [](task<T> inner, std::optional<T>& out, std::exception_ptr& failure) -> detail::blocking_task {
+        try {
+            out.emplace(co_await inner);
+        } catch (...) {
+            failure = std::current_exception();
+        }
+    }(std::move(work), result, exception);
+
+    std::binary_semaphore done{0};
+    runner.handle.promise().done = &done;
+    runner.handle.resume();
+    done.acquire();
+
+    if (exception) {
+        std::rethrow_exception(exception);
+    }
+    return std::move(*result);
+}
+
+// Base interface for reading data without blocking the calling thread
+// A read may complete on any thread; the awaiting coroutine resumes there.
+class async_input_stream {
+public:
+    virtual ~async_input_stream() = default;
+
+    // Read up to buffer.size() bytes, 0 at end of stream
+    // The buffer must stay valid until the task completes
+    [[nodiscard]] virtual task<std::expected<size_t, error>> read(std::span<std::byte> buffer) = 0;
+};
+
+// Presents a blocking input_stream as an async one
+// Reads run inline, so this suits memory-backed or already-buffered sources.
+class async_stream_adapter : public async_input_stream {
+private:
+    std::unique_ptr<input_stream> source_;
+
+public:
+    explicit async_stream_adapter(std::unique_ptr<input_stream> source)
+        : source_(std::move(source)) {}
+
+    [[nodiscard]] task<std::expected<size_t, error>> read(std::span<std::byte> buffer) override {
+        co_return source_->read(buffer);
+    }
+};
+
+} // namespace tierone::tar
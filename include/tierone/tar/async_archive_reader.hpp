@@ -0,0 +1,73 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <tierone/tar/archive_entry.hpp>
+#include <tierone/tar/archive_reader.hpp>
+#include <tierone/tar/async.hpp>
+#include <tierone/tar/error.hpp>
+#include <expected>
+#include <memory>
+#include <optional>
+#include <span>
+
+namespace tierone::tar {
+
+// Archive reader over an async_input_stream
+//
+// Before each entry the reader awaits the source until the entry's whole
+// header chain (extension headers, sparse maps) is buffered, then parses it
+// with the same code as archive_reader, so no call ever blocks on I/O.
+// Skipped data is discarded as it arrives. Read entry data with read_data();
+// the returned entry's own read_data() only sees data already buffered.
+class async_archive_reader {
+public:
+    class window;
+
+private:
+    std::unique_ptr<async_input_stream> source_;
+    window* window_;  // Owned by reader_, filled from source_
+    archive_reader reader_;
+    std::optional<archive_entry> current_;  // Copy of the entry read_data() serves
+    uint64_t data_offset_ = 0;  // Next offset into the current entry
+
+    // Await the source until the window holds bytes or the source is exhausted
+    [[nodiscard]] task<std::expected<void, error>> fill(size_t bytes);
+
+    async_archive_reader(std::unique_ptr<async_input_stream> source, std::unique_ptr<window> buffer);
+
+public:
+    explicit async_archive_reader(std::unique_ptr<async_input_stream> source);
+    async_archive_reader(async_archive_reader&&) = delete;
+    async_archive_reader& operator=(async_archive_reader&&) = delete;
+    ~async_archive_reader();
+
+    // Get the next entry, skipping any data left unread in the current one
+    [[nodiscard]] task<std::expected<std::optional<archive_entry>, error>> next_entry();
+
+    // Read the next bytes of the current entry's data, 0 at its end
+    // Sparse entries read back with their holes expanded
+    [[nodiscard]] task<std::expected<size_t, error>> read_data(std::span<std::byte> buffer);
+
+    // All remaining entries; an error is yielded once and ends the sequence
+    [[nodiscard]] async_generator<std::expected<archive_entry, error>> entries();
+
+    // Counters of the underlying parser, see archive_reader::stats()
+    [[nodiscard]] const reader_stats& stats() const noexcept { return reader_.stats(); }
+};
+
+} // namespace tierone::tar
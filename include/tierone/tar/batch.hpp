@@ -0,0 +1,81 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <tierone/tar/error.hpp>
+#include <tierone/tar/archive_entry.hpp>
+#include <tierone/tar/stream.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace tierone::tar {
+
+// One archive of a batch, a file to open or a stream already open
+// Compressed archives are decompressed as with open_archive().
+using batch_source = std::variant<std::filesystem::path, std::unique_ptr<input_stream>>;
+
+struct batch_options {
+    // Worker threads, 0 uses std::thread::hardware_concurrency()
+    unsigned threads = 0;
+
+    // Stream reads in progress at once across all workers, 0 for no cap
+    // Lets many workers parse and run callbacks while storage sees only
+    // this many requests.
+    unsigned max_reads_in_flight = 0;
+
+    // Stop handing out archives after the first failure
+    bool stop_on_error = false;
+};
+
+// Called for each entry, on the worker reading its archive
+// Entries of one archive come in archive order from one thread; the entry
+// and its data are valid only during the call. An error ends the archive,
+// which is then reported as failed.
+using batch_visitor = std::function<std::expected<void, error>(size_t source, const archive_entry& entry)>;
+
+// Called once an archive is finished, with its entry count or the error that ended it
+using batch_completion = std::function<void(size_t source, const std::expected<uint64_t, error>& entries)>;
+
+struct batch_result {
+    uint64_t archives = 0;  // Read to the end without error
+    uint64_t entries = 0;   // Delivered to the visitor, failed archives included
+    std::vector<std::pair<size_t, error>> failures;  // By source index
+};
+
+// Read many archives on one pool of worker threads
+//
+// Workers take the next unread source as soon as they finish one, so a long
+// tail of small archives keeps every thread busy. Each worker keeps one
+// archive_reader and, for files on Linux, one fd_stream, and moves them on
+// from archive to archive with their buffers. A failed archive does not
+// stop the others unless stop_on_error is set; sources never started then
+// appear neither in archives nor in failures.
+[[nodiscard]] batch_result for_each_archive(
+    std::vector<batch_source> sources,
+    const batch_visitor& visit,
+    const batch_options& options = {},
+    const batch_completion& completed = {});
+
+} // namespace tierone::tar
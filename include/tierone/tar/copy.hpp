@@ -0,0 +1,55 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <tierone/tar/archive_entry.hpp>
+#include <tierone/tar/error.hpp>
+#include <tierone/tar/stream.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <span>
+
+namespace tierone::tar {
+
+struct copy_options {
+    // Bytes moved by each read and each write
+    size_t chunk_size = 1024 * 1024;
+
+    // Buffers cycling between the reading and the writing thread, at least 2
+    size_t buffers = 2;
+
+    // Called on the writing thread with each chunk once it is written, in order
+    std::function<void(std::span<const std::byte>)> observer;
+};
+
+// Copy an entry's data to output, reading each chunk while the last is written
+// Entries of more than one chunk are read on the calling thread into a small
+// pool of page-aligned buffers, and written to output from a second thread,
+// so a large entry copies at the slower of the two bandwidths rather than
+// their sum. Entries of mapped archives are written straight from the
+// mapping. Sparse entries are copied with their holes as zeros. Returns the
+// bytes copied, entry.size() on success.
+[[nodiscard]] std::expected<uint64_t, error> copy_entry(
+    const archive_entry& entry,
+    output_stream& output,
+    const copy_options& options = {}
+);
+
+} // namespace tierone::tar
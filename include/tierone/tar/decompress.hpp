@@ -0,0 +1,167 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <tierone/tar/error.hpp>
+#include <tierone/tar/stream.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <memory>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace tierone::tar {
+
+enum class compression_format {
+    none,
+    gzip,
+    zstd,
+    xz
+};
+
+// Bytes needed by detect_compression()
+constexpr size_t compression_magic_size = 6;
+
+// Identify a compressed stream from its leading bytes
+[[nodiscard]] compression_format detect_compression(std::span<const std::byte> head) noexcept;
+
+// Whether support for format was compiled in
+// Each codec is an optional build dependency (zlib, libzstd, liblzma)
+[[nodiscard]] bool is_compression_supported(compression_format format) noexcept;
+
+// Decompressing stream over another input stream
+// Compressed input is pulled through one large buffer, and skip() decodes
+// into a scratch buffer allocated up front, so skipping never allocates.
+// Concatenated gzip members, zstd frames and xz streams are read back to back.
+class decompress_stream : public input_stream {
+public:
+    struct codec;
+
+private:
+    std::unique_ptr<input_stream> source_;
+    std::unique_ptr<codec> codec_;
+    std::vector<std::byte> input_;
+    std::vector<std::byte> scratch_;
+    size_t input_begin_ = 0;
+    size_t input_end_ = 0;
+    bool source_done_ = false;
+    bool finished_ = false;
+
+    [[nodiscard]] std::expected<void, error> refill();
+
+    decompress_stream(std::unique_ptr<input_stream> source, std::unique_ptr<codec> codec, size_t buffer_size);
+
+public:
+    static constexpr size_t default_buffer_size = 1024 * 1024;
+    static constexpr size_t scratch_size = 64 * 1024;
+
+    // Fails with unsupported_feature if format was not compiled in
+    [[nodiscard]] static std::expected<decompress_stream, error> create(
+        std::unique_ptr<input_stream> source,
+        compression_format format,
+        size_t buffer_size = default_buffer_size);
+
+    decompress_stream(decompress_stream&& other) noexcept;
+    decompress_stream& operator=(decompress_stream&& other) noexcept;
+    ~decompress_stream() override;
+
+    [[nodiscard]] std::expected<size_t, error> read(std::span<std::byte> buffer) override;
+    [[nodiscard]] std::expected<void, error> skip(uint64_t bytes) override;
+    [[nodiscard]] bool at_end() const override { return finished_; }
+};
+
+// A compressed frame that decodes independently of the others
+struct compressed_frame {
+    uint64_t compressed_offset = 0;
+    uint64_t compressed_size = 0;
+    uint64_t uncompressed_offset = 0;
+    uint64_t uncompressed_size = 0;
+};
+
+// Largest frame, compressed or not, decoded in one piece
+// Sizes come from the archive, so each in-flight frame's buffer is bounded.
+constexpr uint64_t max_frame_size = 16 * 1024 * 1024;
+
+// Locate the independent frames of a compressed stream
+// Reads the seek table of a zstd seekable archive or walks the block headers
+// of a BGZF (bgzip) file. Other streams, including plain multi-member gzip
+// and xz, give an empty table as their frames can only be found by decoding;
+// so do zstd seek tables listing a frame above max_frame_size. BGZF blocks
+// claiming more than 64 KiB are corrupt. The stream is left at position 0.
+[[nodiscard]] std::expected<std::vector<compressed_frame>, error> find_frames(
+    random_access_stream& source, compression_format format);
+
+struct parallel_decompress_options {
+    // Decoding threads, 0 uses std::thread::hardware_concurrency()
+    unsigned threads = 0;
+
+    // Frames decoded ahead of the reader, 0 uses twice the thread count
+    size_t frames_ahead = 0;
+};
+
+// Decompressing stream that decodes independent frames on a thread pool
+// The reading thread loads compressed frames in order and hands them to the
+// workers, which decode into a ring of buffers consumed in frame order.
+// The frame table maps uncompressed offsets to frames, so the stream is
+// seekable: seek() and skip() drop the frames in flight unless the target is
+// among them, and the next read decodes from the frame holding the target.
+class parallel_decompress_stream : public random_access_stream {
+public:
+    struct state;
+
+private:
+    std::unique_ptr<state> state_;
+
+    explicit parallel_decompress_stream(std::unique_ptr<state> state);
+
+public:
+    // frames must be in order and cover the stream, as returned by find_frames()
+    // Frames above max_frame_size are refused.
+    [[nodiscard]] static std::expected<parallel_decompress_stream, error> create(
+        std::unique_ptr<random_access_stream> source,
+        compression_format format,
+        std::vector<compressed_frame> frames,
+        const parallel_decompress_options& options = {});
+
+    parallel_decompress_stream(parallel_decompress_stream&& other) noexcept;
+    parallel_decompress_stream& operator=(parallel_decompress_stream&& other) noexcept;
+    ~parallel_decompress_stream() override;
+
+    [[nodiscard]] std::expected<size_t, error> read(std::span<std::byte> buffer) override;
+    [[nodiscard]] std::expected<void, error> skip(uint64_t bytes) override;
+    [[nodiscard]] bool at_end() const override;
+
+    // Views within one frame point into its decoded buffer, others are copied
+    [[nodiscard]] bool can_peek() const override { return true; }
+    [[nodiscard]] std::expected<std::span<const std::byte>, error> peek(size_t bytes) override;
+
+    [[nodiscard]] std::expected<void, error> seek(uint64_t position) override;
+    [[nodiscard]] uint64_t position() const override;
+    [[nodiscard]] std::optional<uint64_t> size() const override;
+};
+
+// Put a decompressor in front of stream if its leading bytes carry a known magic
+// The result can peek so headers are still parsed in place. Seekable streams
+// with independent frames are decoded in parallel and stay seekable, so
+// open_entry() works on them. Streams that cannot peek are returned
+// unchanged, as detection would consume their data.
+[[nodiscard]] std::expected<std::unique_ptr<input_stream>, error> open_decompressed(
+    std::unique_ptr<input_stream> stream);
+
+} // namespace tierone::tar
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+
+namespace tierone::tar {
+
+// Digest algorithms to compute over entry data, any combination
+struct digest_set {
+    bool sha256 = false;  // SHA-256, with SHA-NI where the CPU has it
+    bool xxh64 = false;   // XXH64 with seed 0, non-cryptographic and far cheaper
+
+    [[nodiscard]] bool any() const noexcept { return sha256 || xxh64; }
+};
+
+// Finished digests, one per algorithm that was requested
+struct entry_digests {
+    std::optional<std::array<std::byte, 32>> sha256;
+    std::optional<uint64_t> xxh64;
+};
+
+// Lowercase hex, as in manifests and sha256sum output
+[[nodiscard]] std::string to_hex(std::span<const std::byte> digest);
+[[nodiscard]] std::string to_hex(uint64_t digest);
+
+namespace detail {
+
+struct sha256_state {
+    std::array<uint32_t, 8> h{};
+    std::array<std::byte, 64> block{};
+    size_t buffered = 0;
+    uint64_t length = 0;
+};
+
+struct xxh64_state {
+    std::array<uint64_t, 4> v{};
+    std::array<std::byte, 32> stripe{};
+    size_t buffered = 0;
+    uint64_t length = 0;
+};
+
+} // namespace detail
+
+// Incremental digests over data arriving in chunks of any size
+class content_hasher {
+private:
+    digest_set algorithms_;
+    detail::sha256_state sha256_;
+    detail::xxh64_state xxh64_;
+
+public:
+    explicit content_hasher(digest_set algorithms = {}) noexcept;
+
+    [[nodiscard]] const digest_set& algorithms() const noexcept { return algorithms_; }
+
+    void update(std::span<const std::byte> data) noexcept;
+
+    // Digests of everything passed to update() so far; hashing may go on
+    [[nodiscard]] entry_digests finish() const noexcept;
+
+    // Start over, hashing with the same algorithms
+    void reset() noexcept;
+};
+
+namespace detail {
+
+// Digests of the entry an archive_reader is on, built from the data its
+// caller reads. Bytes only count where they extend the hashed prefix, so
+// a jump ahead leaves the entry without a result.
+struct digest_slot {
+    content_hasher hasher;
+    uint64_t entry = 0;   // Number of the entry being hashed, 0 for none
+    uint64_t hashed = 0;  // Leading bytes of its data hashed so far
+    uint64_t size = 0;
+    std::optional<entry_digests> result;
+
+    void begin(const uint64_t number, const uint64_t data_size) noexcept {
+        hasher.reset();
+        entry = number;
+        hashed = 0;
+        size = data_size;
+        result.reset();
+        if (size == 0) {
+            result = hasher.finish();
+        }
+    }
+
+    void update(const uint64_t number, const uint64_t offset, const std::span<const std::byte> data) noexcept {
+        if (number != entry || result || offset > hashed || offset + data.size() <= hashed) {
+            return;
+        }
+        hasher.update(data.subspan(static_cast<size_t>(hashed - offset)));
+        hashed = offset + data.size();
+        if (hashed >= size) {
+            result = hasher.finish();
+        }
+    }
+};
+
+} // namespace detail
+
+} // namespace tierone::tar
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <tierone/tar/error.hpp>
+#include <tierone/tar/metadata.hpp>
+#include <tierone/tar/header_parser.hpp>
+#include <tierone/tar/pax_parser.hpp>
+#include <array>
+#include <chrono>
+#include <expected>
+#include <map>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+
+namespace tierone::tar {
+
+class archive_reader;
+
+// Lightweight view of one archive member, decoded on demand
+// Holds a copy of the header block, so constructing one never allocates.
+// String accessors return views into that block or into extension data owned
+// by the reader, which stay valid until the reader advances. Numeric fields
+// are decoded from their octal fields on each call. Values from the entry's
+// PAX records, then from PAX global headers, take precedence over the block.
+class entry_view {
+private:
+    std::array<std::byte, detail::BLOCK_SIZE> block_{};
+    std::array<char, 256> joined_path_{};  // prefix + '/' + name
+    size_t joined_length_ = 0;
+
+    // Overrides from GNU longname/longlink and PAX headers, owned by the reader
+    std::string_view path_override_;
+    std::string_view link_override_;
+    std::optional<uint64_t> size_override_;
+    const pax::extended_header* pax_headers_ = nullptr;
+    const pax::global_header* global_pax_ = nullptr;
+    bool sparse_ = false;
+
+    friend class archive_reader;
+
+    [[nodiscard]] const ustar_header& header() const noexcept {
+        return *std::bit_cast<const ustar_header*>(block_.data());
+    }
+
+public:
+    // Validate magic, version and checksum, and wrap the block
+    [[nodiscard]] static std::expected<entry_view, error> parse(std::span<const std::byte, detail::BLOCK_SIZE> block);
+
+    [[nodiscard]] std::string_view path() const noexcept;
+    [[nodiscard]] entry_type type() const noexcept { return static_cast<entry_type>(header().typeflag); }
+    [[nodiscard]] std::string_view owner_name() const noexcept;
+    [[nodiscard]] std::string_view group_name() const noexcept;
+
+    // Link target for hard and symbolic links
+    [[nodiscard]] std::optional<std::string_view> link_target() const noexcept;
+
+    // Bytes of entry data stored in the archive, excluding padding
+    [[nodiscard]] std::expected<uint64_t, error> size() const;
+
+    [[nodiscard]] std::expected<std::filesystem::perms, error> permissions() const;
+    [[nodiscard]] std::expected<uint32_t, error> owner_id() const;
+    [[nodiscard]] std::expected<uint32_t, error> group_id() const;
+    [[nodiscard]] std::expected<std::chrono::system_clock::time_point, error> modification_time() const;
+
+    // GNU sparse member, its stored data is the packed segments
+    [[nodiscard]] bool is_sparse() const noexcept { return sparse_; }
+
+    // Size of the file once extracted: the real size of a sparse member, from
+    // its header or PAX records, without reading its map; size() otherwise
+    [[nodiscard]] std::expected<uint64_t, error> file_size() const;
+
+    // Full metadata, including PAX global values, extended attributes and ACLs
+    // Sparse maps stored in the data area are not decoded, iterate with
+    // archive_reader::next_entry() when they are needed
+    [[nodiscard]] std::expected<file_metadata, error> to_metadata() const;
+
+    // The raw header block
+    [[nodiscard]] std::span<const std::byte, detail::BLOCK_SIZE> block() const noexcept { return block_; }
+};
+
+} // namespace tierone::tar
@@ -16,7 +16,9 @@
 
 #pragma once
 
+#include <cstdint>
 #include <expected>
+#include <optional>
 #include <string>
 #include <system_error>
 
@@ -31,17 +33,43 @@ enum class error_code {
     end_of_archive
 };
 
+// Most errors are a code, a static context string and optionally the errno
+// and archive offset involved. They allocate nothing; message() formats them
+// when asked. Errors whose text carries other data own a string instead.
 class error {
 public:
+    // context must outlive the error, in practice a string literal
+    constexpr error(const error_code code, const char* context, const int system_errno = 0) noexcept
+        : code_(code), errno_(system_errno), context_(context) {}
+
     error(const error_code code, std::string message)
-        : code_(code), message_(std::move(message)) {}
+        : code_(code), detail_(std::move(message)) {}
+
+    // The same error, located at an archive offset
+    [[nodiscard]] error at_offset(const uint64_t offset) && noexcept {
+        offset_ = offset;
+        return std::move(*this);
+    }
+
+    [[nodiscard]] constexpr error_code code() const noexcept { return code_; }
+
+    // Static context, nullptr for errors built from a string
+    [[nodiscard]] const char* context() const noexcept { return context_; }
+
+    // errno of the failed system call, 0 if none
+    [[nodiscard]] int system_errno() const noexcept { return errno_; }
+
+    [[nodiscard]] std::optional<uint64_t> offset() const noexcept { return offset_; }
 
-    [[nodiscard]] error_code code() const noexcept { return code_; }
-    [[nodiscard]] const std::string& message() const noexcept { return message_; }
+    // Context or string, then the errno description and the offset
+    [[nodiscard]] std::string message() const;
 
 private:
     error_code code_;
-    std::string message_;
+    int errno_ = 0;
+    const char* context_ = nullptr;
+    std::optional<uint64_t> offset_;
+    std::string detail_;
 };
 
-} // namespace tierone::tar
\ No newline at end of file
+} // namespace tierone::tar
@@ -0,0 +1,148 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <tierone/tar/error.hpp>
+#include <tierone/tar/archive_reader.hpp>
+#include <tierone/tar/digest.hpp>
+#include <expected>
+#include <filesystem>
+#include <functional>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+
+namespace tierone::tar {
+
+// How extract_archive() reuses files it has already written
+enum class dedup_mode {
+    none,       // Every member is written out
+    hard_link,  // Identical members become hard links to the first copy
+    reflink,    // Identical members become reflinked copies (FICLONE), sharing extents
+};
+
+struct extract_options {
+    // Number of worker threads, 0 uses std::thread::hardware_concurrency()
+    unsigned threads = 0;
+
+    // Upper bound on file data buffered while waiting for a worker
+    // Entries larger than this are written by the scanning thread itself
+    size_t max_queued_bytes = 64 * 1024 * 1024;
+
+    // Regular files at least this large are written behind the page cache, 0 never
+    // Their size is preallocated, writeback starts as each 8 MiB is written
+    // and written ranges leave the cache once on disk, so large restores
+    // neither evict other data nor pile up dirty pages. Linux-only.
+    uint64_t write_behind_threshold = 0;
+
+    // Digests to compute over each regular file's data as it is extracted
+    // The reader hashes the chunks it already reads, no second pass is made.
+    // Needs on_digests; sparse files are not hashed.
+    digest_set digests{};
+
+    // Called with each regular file and its digests, on the scanning thread
+    std::function<void(const archive_entry& entry, const entry_digests& digests)> on_digests{};
+
+    // Reuse earlier regular files with the same content, matched by SHA-256
+    // and size. A duplicate whose data is hashed before it is written, every
+    // mapped or buffered member, is never written; members streamed from a
+    // plain stream are written but still serve later duplicates. Hard links
+    // share an inode, so only members with the same mode and owner (when
+    // preserved) and no xattrs or ACLs are joined, and the first copy's mtime
+    // is kept. Reflinks keep every member's metadata and fall back to an
+    // in-kernel copy where the filesystem cannot clone. A duplicate is made
+    // as soon as its first copy is written, so a later member replacing that
+    // copy leaves it alone. Sparse members are not deduplicated.
+    dedup_mode dedup = dedup_mode::none;
+
+    // Metadata restored beyond permissions, all best effort: what the
+    // filesystem or the caller's privileges refuse is left as created
+    bool preserve_times = true;   // Modification times
+    bool preserve_owner = true;   // Numeric uid and gid, needs CAP_CHOWN
+    bool preserve_xattrs = true;  // Extended attributes and POSIX ACLs (Linux-only)
+};
+
+// Writes entries below one destination directory through directory fds
+// Each directory is created and opened once, then cached; files, links and
+// subdirectories are made with openat(), mkdirat(), symlinkat() and linkat()
+// relative to their parent's fd, and permissions are set with fchmod(). No
+// path is walked twice, and no component is followed if it is a symlink, so
+// an archive cannot redirect writes outside the destination. Paths are those
+// of the archive; absolute ones are taken relative to the destination and
+// ones containing ".." are refused. Safe to use from several threads.
+class extract_context {
+public:
+    struct state;
+
+private:
+    std::unique_ptr<state> state_;
+
+    explicit extract_context(std::unique_ptr<state> state);
+
+    friend std::expected<void, error> extract_archive(
+        archive_reader& reader, const std::filesystem::path& dest, const extract_options& options);
+
+public:
+    // Create dest if needed and open it
+    // Only the preserve_* fields of options are used.
+    [[nodiscard]] static std::expected<extract_context, error> open(
+        const std::filesystem::path& dest, const extract_options& options = {});
+
+    extract_context(extract_context&& other) noexcept;
+    extract_context& operator=(extract_context&& other) noexcept;
+    ~extract_context();
+
+    // Create a file, directory or link for entry, streaming its data
+    // Sparse entries are written run by run and keep their holes. Files and
+    // symlinks get their metadata through their own handle as soon as they
+    // are written; that of directories is deferred to finish(). Device and
+    // FIFO entries fail with unsupported_feature.
+    [[nodiscard]] std::expected<void, error> extract(const archive_entry& entry);
+
+    // Create a file holding data, replacing whatever was at path
+    [[nodiscard]] std::expected<void, error> write_file(
+        const std::filesystem::path& path, std::filesystem::perms permissions, std::span<const std::byte> data);
+
+    // Create path as a symbolic link to target, which is stored as given
+    [[nodiscard]] std::expected<void, error> create_symlink(
+        const std::filesystem::path& path, const std::filesystem::path& target);
+
+    // Create path as a hard link to target, both below the destination
+    [[nodiscard]] std::expected<void, error> create_hard_link(
+        const std::filesystem::path& path, const std::filesystem::path& target);
+
+    // Apply deferred directory metadata, deepest first, in one pass
+    // Done last, read-only directories do not block writing their children
+    // and no later write inside a directory bumps its restored mtime.
+    [[nodiscard]] std::expected<void, error> finish();
+};
+
+// Extract every entry of the archive below dest
+// One thread scans headers sequentially while a pool of workers writes file
+// contents, creates links and restores metadata, all through one
+// extract_context. Directories are created before any entry inside them,
+// entries sharing a path are written in archive order so the last member
+// wins, hard links follow their source's data, and directory metadata is
+// applied last. Device and FIFO entries are skipped.
+[[nodiscard]] std::expected<void, error> extract_archive(
+    archive_reader& reader,
+    const std::filesystem::path& dest,
+    const extract_options& options = {}
+);
+
+} // namespace tierone::tar
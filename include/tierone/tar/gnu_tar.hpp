@@ -45,6 +45,13 @@ struct gnu_extension_data {
     size_t data_size
 );
 
+// Read GNU extension data into out, reusing its capacity
+[[nodiscard]] std::expected<void, error> read_gnu_extension_data(
+    input_stream& stream,
+    size_t data_size,
+    std::string& out
+);
+
 // Apply GNU extensions to metadata
 void apply_gnu_extensions(file_metadata& metadata, const gnu_extension_data& extensions);
 
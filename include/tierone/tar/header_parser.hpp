@@ -22,6 +22,8 @@
 #include <span>
 #include <bit>
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <ranges>
 
 namespace tierone::tar::detail {
@@ -34,38 +36,217 @@ concept OctalField = requires(T t) {
     { std::span{t} } -> std::convertible_to<std::span<const char>>;
 };
 
-// Parse octal field with proper error handling
+// SWAR helpers for numeric header fields, eight field bytes per 64-bit word
+namespace swar {
+
+constexpr uint64_t ones = 0x0101010101010101ull;
+constexpr uint64_t high_bits = ones * 0x80;
+
+// 8 bytes from p as a little-endian word; a single load outside constant evaluation
+constexpr uint64_t load(const char* p) noexcept {
+    if !consteval {
+        uint64_t word;
+        std::memcpy(&word, p, sizeof(word));
+        if constexpr (std::endian::native == std::endian::big) {
+            word = std::byteswap(word);
+        }
+        return word;
+    }
+    uint64_t word = 0;
+    for (size_t i = 0; i < 8; ++i) {
+        word |= static_cast<uint64_t>(static_cast<uint8_t>(p[i])) << (8 * i);
+    }
+    return word;
+}
+
+// One bit per byte of word, set where the byte is zero
+constexpr uint32_t zero_bytes(const uint64_t word) noexcept {
+    const uint64_t nonzero = (((word & ~high_bits) + ~high_bits) | word) & high_bits;
+    return static_cast<uint32_t>((((~nonzero & high_bits) >> 7) * 0x0102040810204080ull) >> 56);
+}
+
+// Bytes of word that are separators (space or NUL) and octal digits
+struct field_classes {
+    uint32_t separators = 0;
+    uint32_t digits = 0;
+};
+
+constexpr field_classes classify(const uint64_t word) noexcept {
+    return {zero_bytes(word) | zero_bytes(word ^ (ones * ' ')),
+            zero_bytes((word & (ones * 0xF8)) ^ (ones * '0'))};
+}
+
+// Bytes of a word selected by bits [first, last) of a per-byte mask
+constexpr uint64_t byte_range(const unsigned first, const unsigned last) noexcept {
+    const uint64_t below_last = last >= 8 ? ~uint64_t{0} : (uint64_t{1} << (8 * last)) - 1;
+    const uint64_t below_first = first >= 8 ? ~uint64_t{0} : (uint64_t{1} << (8 * first)) - 1;
+    return below_last & ~below_first;
+}
+
+// Value of the eight octal digit bytes of word, first byte most significant
+// Digits are merged pairwise in three steps.
+constexpr uint64_t octal_word(uint64_t word) noexcept {
+    word &= ones * 0x07;
+    word = ((word & 0x00FF00FF00FF00FFull) << 3) + ((word >> 8) & 0x00FF00FF00FF00FFull);
+    word = ((word & 0x0000FFFF0000FFFFull) << 6) + ((word >> 16) & 0x0000FFFF0000FFFFull);
+    return ((word & 0xFFFFFFFFull) << 12) + (word >> 32);
+}
+
+} // namespace swar
+
+// parse_octal() for fields of 8 to 16 bytes, two overlapping word loads
+template<size_t N>
+constexpr std::expected<uint64_t, error> parse_octal_word(std::span<const char, N> field) {
+    constexpr unsigned tail = N - 8;  // Bytes after the first word
+    constexpr uint32_t all = static_cast<uint32_t>((uint64_t{1} << N) - 1);
+
+    // Two overlapping loads cover the field; bytes are classified in both
+    const uint64_t head_word = swar::load(field.data());
+    const uint64_t tail_word = swar::load(field.data() + tail);
+
+    // Canonical form first: digits in every byte but the last, which ends them
+    // This is what ustar writers emit, zero-padded, so it is checked whole.
+    {
+        constexpr uint64_t digit_check = swar::ones * 0xF8;
+        constexpr uint64_t zero_digits = swar::ones * '0';
+        constexpr uint64_t head_digits = tail > 0 ? ~uint64_t{0} : swar::byte_range(0, 7);
+        constexpr uint64_t tail_digits = swar::byte_range(8 - tail, 7);
+        const auto last = static_cast<uint8_t>(tail_word >> 56);
+        if ((((head_word & digit_check) ^ zero_digits) & head_digits) == 0 &&
+            (((tail_word & digit_check) ^ zero_digits) & tail_digits) == 0 && (last == 0 || last == ' ')) {
+            uint64_t value = swar::octal_word(head_word & head_digits);
+            if constexpr (tail > 0) {
+                value = (value << (3 * tail)) | swar::octal_word(tail_word & tail_digits);
+            }
+            return value >> 3;  // The terminator was decoded as a zero digit
+        }
+    }
+
+    const auto head = swar::classify(head_word);
+    const auto rest = swar::classify(tail_word);
+    const uint32_t separators = head.separators | (rest.separators << tail);
+    const uint32_t digits = head.digits | (rest.digits << tail);
+
+    const uint32_t content = ~separators & all;
+    if (content == 0) {
+        return 0;
+    }
+    const auto start = static_cast<unsigned>(std::countr_zero(content));
+    const uint32_t terminators = separators & all & ~((1u << start) - 1);
+    const auto end = terminators ? static_cast<unsigned>(std::countr_zero(terminators)) : static_cast<unsigned>(N);
+    const uint32_t run = ((1u << end) - 1) & ~((1u << start) - 1);
+    if ((digits & run) != run) {
+        return std::unexpected(error{error_code::invalid_header, "Invalid octal digit"});
+    }
+
+    // Decode all N positions with bytes outside the run as zero digits, then
+    // drop the zeros after it. At most 48 bits, so no overflow is possible.
+    uint64_t value = swar::octal_word(head_word & swar::byte_range(start, end));
+    if constexpr (tail > 0) {
+        // Bytes 8..N-1 of the field end tail_word, the bytes before them are
+        // already in head_word and read as leading zeros here
+        const uint64_t run_bytes = swar::byte_range(start > 8 ? start - 8 : 0, end > 8 ? end - 8 : 0);
+        value = (value << (3 * tail)) | swar::octal_word(tail_word & (run_bytes << (8 * (8 - tail))));
+    }
+    return value >> (3 * (N - end));
+}
+
+// Parse an octal field: optional leading spaces or NULs, digits, then a
+// space or NUL (or the end of the field); whatever follows is ignored
 template<size_t N>
 constexpr std::expected<uint64_t, error> parse_octal(std::span<const char, N> field) {
-    uint64_t result = 0;
-    bool found_digit = false;
-    
-    for (char c : field) {
-        if (c == '\0' || c == ' ') {
-            if (!found_digit) continue;
-            break;
+    if constexpr (N < 8 || N > 16) {
+        // Not a header field width, decoded a byte at a time
+        uint64_t result = 0;
+        bool found_digit = false;
+        for (char c : field) {
+            if (c == '\0' || c == ' ') {
+                if (!found_digit) continue;
+                break;
+            }
+            if (c < '0' || c > '7') {
+                return std::unexpected(error{error_code::invalid_header, "Invalid octal digit"});
+            }
+            found_digit = true;
+            if (result > (UINT64_MAX >> 3)) {
+                return std::unexpected(error{error_code::invalid_header, "Octal value overflow"});
+            }
+            result = (result << 3) | static_cast<uint64_t>(c - '0');
         }
-        if (c < '0' || c > '7') {
-            return std::unexpected(error{error_code::invalid_header, "Invalid octal digit"});
+        return found_digit ? result : 0;
+    } else {
+        return parse_octal_word(field);
+    }
+}
+
+// Parse a numeric field that may hold a signed value
+// GNU tar stores values too large for octal, such as sizes of 8 GiB and up,
+// and negative times in base-256: a first byte with its high bit set starts
+// a big-endian two's complement number whose sign is bit 6 of that byte.
+template<size_t N>
+constexpr std::expected<int64_t, error> parse_signed_numeric(std::span<const char, N> field) {
+    static_assert(N >= 8 && N <= 16, "Numeric header fields are 8 or 12 bytes");
+    const auto first = static_cast<uint8_t>(field[0]);
+    if ((first & 0x80) == 0) {
+        auto value = parse_octal(field);
+        if (!value) {
+            return std::unexpected(value.error());
         }
-        found_digit = true;
-        
-        // Check for overflow
-        if (result > (UINT64_MAX >> 3)) {
-            return std::unexpected(error{error_code::invalid_header, "Octal value overflow"});
+        return static_cast<int64_t>(*value);
+    }
+
+    // Sign-extend the first byte, then every byte above the low eight has to
+    // be all sign for the value to fit
+    const bool negative = (first & 0x40) != 0;
+    const uint8_t head = negative ? static_cast<uint8_t>(first | 0x80) : static_cast<uint8_t>(first & 0x7F);
+    const uint8_t sign = negative ? 0xFF : 0x00;
+    for (size_t i = 0; i + 8 < N; ++i) {
+        if ((i == 0 ? head : static_cast<uint8_t>(field[i])) != sign) {
+            return std::unexpected(error{error_code::invalid_header, "Base-256 value overflow"});
         }
-        
-        result = (result << 3) | static_cast<uint64_t>(c - '0');
     }
-    
-    return found_digit ? result : 0;
+    uint64_t low = std::byteswap(swar::load(field.data() + N - 8));
+    if constexpr (N == 8) {
+        low = (low & 0x00FFFFFFFFFFFFFFull) | (uint64_t{head} << 56);
+    }
+    if (((low >> 63) != 0) != negative) {
+        return std::unexpected(error{error_code::invalid_header, "Base-256 value overflow"});
+    }
+    return static_cast<int64_t>(low);
+}
+
+// Parse a numeric field that cannot be negative, octal or base-256
+template<size_t N>
+constexpr std::expected<uint64_t, error> parse_numeric(std::span<const char, N> field) {
+    if ((static_cast<uint8_t>(field[0]) & 0x80) == 0) {
+        return parse_octal(field);
+    }
+    auto value = parse_signed_numeric(field);
+    if (!value) {
+        return std::unexpected(value.error());
+    }
+    if (*value < 0) {
+        return std::unexpected(error{error_code::invalid_header, "Negative value in unsigned field"});
+    }
+    return static_cast<uint64_t>(*value);
 }
 
 // Calculate checksum for header validation
 [[nodiscard]] uint32_t calculate_checksum(std::span<const std::byte, BLOCK_SIZE> block);
 
+// Check magic, version and checksum of a header block without decoding it
+[[nodiscard]] std::expected<void, error> validate_header(std::span<const std::byte, BLOCK_SIZE> block);
+
+// Header fields that the entry's extension headers replace
+// They are left empty rather than built only to be overwritten.
+struct replaced_fields {
+    bool path = false;
+    bool link_target = false;
+};
+
 // Parse a complete tar header block
-[[nodiscard]] std::expected<file_metadata, error> parse_header(std::span<const std::byte, BLOCK_SIZE> block);
+[[nodiscard]] std::expected<file_metadata, error> parse_header(
+    std::span<const std::byte, BLOCK_SIZE> block, replaced_fields replaced = {});
 
 // Check if block is all zeros (end-of-archive marker)
 [[nodiscard]] bool is_zero_block(std::span<const std::byte, BLOCK_SIZE> block);
@@ -0,0 +1,91 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <tierone/tar/error.hpp>
+#include <tierone/tar/archive_index.hpp>
+#include <tierone/tar/stream.hpp>
+#include <array>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace tierone::tar {
+
+// Digest identifying archive contents, e.g. a SHA-256 layer digest
+using archive_digest = std::array<std::byte, 32>;
+
+struct sidecar_options {
+    // When set, the sidecar is bound to this digest instead of the archive's size and mtime
+    std::optional<archive_digest> digest;
+};
+
+// Write an index to a versioned sidecar file next to its archive
+// The file is written to a temporary name and renamed into place
+[[nodiscard]] std::expected<void, error> write_index_sidecar(
+    const archive_index& index,
+    const std::filesystem::path& sidecar_path,
+    const std::filesystem::path& archive_path,
+    const sidecar_options& options = {}
+);
+
+// Read-only view of a sidecar index file
+//
+// Layout: a fixed header, fixed-width records in archive order, a table of
+// record numbers sorted by path, a string table and a sparse segment table.
+// All integers are native-endian and the file is mapped without parsing, so
+// lookups cost a binary search over the mapping regardless of archive size.
+// Extended attributes and ACLs are not persisted.
+class index_sidecar {
+private:
+    std::unique_ptr<random_access_stream> storage_;
+    std::vector<std::byte> owned_;  // Used where the file cannot be mapped
+    std::span<const std::byte> data_;
+    size_t record_count_ = 0;
+
+    index_sidecar() = default;
+
+    [[nodiscard]] std::string_view path_of(size_t record) const noexcept;
+    [[nodiscard]] size_t sorted_record(size_t position) const noexcept;
+
+public:
+    // Map a sidecar and check it still describes the archive
+    // With options.digest set the stored digest must match, otherwise the
+    // archive's current size and modification time must match
+    [[nodiscard]] static std::expected<index_sidecar, error> open(
+        const std::filesystem::path& sidecar_path,
+        const std::filesystem::path& archive_path,
+        const sidecar_options& options = {}
+    );
+
+    [[nodiscard]] size_t size() const noexcept { return record_count_; }
+
+    // Decode one record, in archive order
+    [[nodiscard]] std::expected<index_record, error> record(size_t i) const;
+
+    // Look up an entry by path, the last member with that path wins
+    [[nodiscard]] std::expected<std::optional<index_record>, error> find(std::string_view path) const;
+
+    // Materialize every record into an in-memory index
+    [[nodiscard]] std::expected<archive_index, error> to_index() const;
+};
+
+} // namespace tierone::tar
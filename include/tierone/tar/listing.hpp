@@ -0,0 +1,140 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <tierone/tar/archive_reader.hpp>
+#include <tierone/tar/error.hpp>
+#include <tierone/tar/metadata.hpp>
+#include <chrono>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+namespace tierone::tar {
+
+// One member of an archive listing, allocated from a memory_resource
+// Carries what a listing shows: the header fields with GNU and PAX overrides
+// applied, but no xattrs, ACLs or sparse map.
+struct listed_entry {
+    using allocator_type = std::pmr::polymorphic_allocator<>;
+
+    std::pmr::string path;
+    std::pmr::string link_target;  // Empty unless a link
+    std::pmr::string owner_name;
+    std::pmr::string group_name;
+    entry_type type = entry_type::regular_file;
+    std::filesystem::perms permissions = std::filesystem::perms::none;
+    uint32_t owner_id = 0;
+    uint32_t group_id = 0;
+    uint64_t size = 0;  // Stored bytes; sparse members list their packed size
+    std::chrono::system_clock::time_point modification_time;
+    bool sparse = false;
+
+    listed_entry() = default;
+    explicit listed_entry(const allocator_type& alloc)
+        : path(alloc), link_target(alloc), owner_name(alloc), group_name(alloc) {}
+    listed_entry(const listed_entry& other, const allocator_type& alloc);
+    listed_entry(listed_entry&& other, const allocator_type& alloc);
+    listed_entry(const listed_entry&) = default;
+    listed_entry(listed_entry&&) noexcept = default;
+    listed_entry& operator=(const listed_entry&) = default;
+    listed_entry& operator=(listed_entry&&) = default;
+
+    [[nodiscard]] allocator_type get_allocator() const noexcept { return path.get_allocator(); }
+};
+
+// List the remaining members of reader, allocating only from resource
+// Walks next_entry_view(), so neither file_metadata nor archive_entry is
+// built. With a std::pmr::monotonic_buffer_resource the whole listing is
+// released at once when the resource goes away, and threads listing
+// archives side by side stay off the shared heap.
+[[nodiscard]] std::expected<std::pmr::vector<listed_entry>, error> list_entries(
+    archive_reader& reader,
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+// Member count and bytes of a group of members
+// Bytes are file sizes once extracted, the real size for sparse members.
+struct size_totals {
+    uint64_t count = 0;
+    uint64_t bytes = 0;
+
+    void add(const uint64_t size) noexcept {
+        ++count;
+        bytes += size;
+    }
+};
+
+// One of the largest members found by summarize()
+struct summary_member {
+    std::pmr::string path;
+    uint64_t size = 0;
+    uint64_t number = 0;  // Position among the archive's members, from 0
+};
+
+struct summary_options {
+    // Leading directory components that name a prefix in the per-prefix
+    // totals; "usr/lib/x.so" counts towards "usr" with 1, "usr/lib" with 2.
+    // 0 leaves the totals out
+    size_t prefix_depth = 1;
+
+    // Largest members kept, 0 for none
+    size_t largest = 10;
+};
+
+// Totals over the members of an archive, as du would show for its contents
+// Every member counts, including ones a later member of the same path
+// replaces on extraction.
+struct archive_summary {
+    size_totals total;
+    uint64_t stored_bytes = 0;  // Entry data in the archive, sparse members packed
+
+    size_totals regular_files;  // Sparse and contiguous files included
+    size_totals directories;
+    size_totals symbolic_links;
+    size_totals hard_links;
+    size_totals devices;
+    size_totals fifos;
+    size_totals other;
+    uint64_t sparse_files = 0;
+
+    // Members by their parent directory, cut to prefix_depth components;
+    // members at the top level count towards ""
+    std::pmr::map<std::pmr::string, size_totals, std::less<>> prefixes;
+
+    // Largest regular files, largest first; ties keep archive order
+    std::pmr::vector<summary_member> largest;
+
+    explicit archive_summary(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : prefixes(resource), largest(resource) {}
+};
+
+// Summarize the remaining members of reader in one pass
+// Walks next_entry_view() like list_entries(), so no file_metadata is
+// built. Memory is taken from resource only for a prefix not seen before
+// and while the largest members are first filled; after that, a member
+// entering the largest list reuses the storage of the one it displaces.
+[[nodiscard]] std::expected<archive_summary, error> summarize(
+    archive_reader& reader,
+    const summary_options& options = {},
+    std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+} // namespace tierone::tar
@@ -100,8 +100,10 @@ struct file_metadata {
     std::vector<acl_entry> access_acl;
     std::vector<acl_entry> default_acl;
 
+    // Contiguous files are read and extracted as regular files, as POSIX allows
     [[nodiscard]] bool is_regular_file() const noexcept {
-        return type == entry_type::regular_file || type == entry_type::regular_file_old;
+        return type == entry_type::regular_file || type == entry_type::regular_file_old ||
+               type == entry_type::contiguous_file;
     }
 
     [[nodiscard]] bool is_directory() const noexcept {
@@ -0,0 +1,128 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <tierone/tar/error.hpp>
+#include <tierone/tar/stream.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tierone::tar {
+
+// Where a volume picks up the member left unfinished by the one before,
+// from its GNU 'M' header
+struct volume_continuation {
+    std::string name;     // Member being continued
+    uint64_t offset = 0;  // Bytes of its stored data held by earlier volumes
+    uint64_t size = 0;    // Bytes of its stored data still to come
+};
+
+// The volumes of a GNU multi-volume archive joined into one archive stream
+//
+// Each volume starts with an optional 'V' label and, when a member crosses
+// into it, an 'M' header giving the member's name and how much of its data
+// came before. Both are stripped, so an archive_reader sees one archive and
+// reads split members as a whole. A first volume continuing a member has that
+// member's data dropped. While one volume is consumed the
+// next is opened, its leading headers parsed and its first data read on a
+// background thread, so crossing into it does not stall the pass.
+//
+// An archive_reader over this stream reports each member it starts, and every
+// continuation is checked against it: a volume must continue the right member,
+// and one overlapping data already read is resumed at the right offset.
+class multi_volume_stream : public input_stream {
+public:
+    // Opens volume index, or returns nullptr when there is none
+    // Called from a background thread, one volume at a time.
+    using volume_opener = std::function<std::expected<std::unique_ptr<input_stream>, error>(size_t index)>;
+
+    static constexpr size_t default_prefetch_size = 1024 * 1024;
+
+private:
+    struct prefetched_volume {
+        std::unique_ptr<input_stream> stream;  // nullptr past the last volume
+        std::optional<volume_continuation> continuation;
+        std::vector<std::byte> head;  // Volume content read ahead, after its leading headers
+    };
+
+    struct member {
+        std::string name;
+        uint64_t data_start = 0;  // Stream position of its first data byte
+        uint64_t stored_size = 0;
+    };
+
+    volume_opener open_volume_;
+    size_t prefetch_size_;
+    std::unique_ptr<input_stream> current_;
+    random_access_stream* seekable_ = nullptr;  // current_ if it can tell how much is left
+    size_t volume_ = 0;
+    std::vector<std::byte> head_;  // Content of current_ read ahead of the caller
+    size_t head_position_ = 0;
+    std::future<std::expected<prefetched_volume, error>> next_;
+    bool exhausted_ = false;  // No volume follows current_
+    uint64_t position_ = 0;   // Bytes handed out or skipped, across volumes
+    std::optional<member> member_;
+    std::vector<std::byte> scratch_;  // Discarded data of volumes that cannot skip exactly
+
+    multi_volume_stream(volume_opener open_volume, size_t prefetch_size);
+
+    // Start opening the volume after the current one
+    void prefetch_next();
+
+    // Move on to the next volume, false past the last one
+    [[nodiscard]] std::expected<bool, error> next_volume();
+
+    // Drop bytes of the current volume, fewer only at its end
+    [[nodiscard]] std::expected<uint64_t, error> discard(uint64_t bytes);
+
+public:
+    // Open the first volume and start prefetching the second
+    [[nodiscard]] static std::expected<std::unique_ptr<multi_volume_stream>, error> open(
+        volume_opener open_volume, size_t prefetch_size = default_prefetch_size);
+
+    // Volumes read from files, in order
+    [[nodiscard]] static std::expected<std::unique_ptr<multi_volume_stream>, error> open(
+        std::vector<std::filesystem::path> paths, size_t prefetch_size = default_prefetch_size);
+
+    multi_volume_stream(const multi_volume_stream&) = delete;
+    multi_volume_stream& operator=(const multi_volume_stream&) = delete;
+    ~multi_volume_stream() override;
+
+    [[nodiscard]] std::expected<size_t, error> read(std::span<std::byte> buffer) override;
+    [[nodiscard]] std::expected<void, error> skip(uint64_t bytes) override;
+    [[nodiscard]] bool at_end() const override;
+
+    // Note the member whose stored data starts at the current position
+    // Continuations in later volumes are checked against the last one noted.
+    void begin_member(std::string_view name, uint64_t stored_size);
+
+    // Index of the volume being read
+    [[nodiscard]] size_t volume() const noexcept { return volume_; }
+};
+
+} // namespace tierone::tar
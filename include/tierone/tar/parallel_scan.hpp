@@ -0,0 +1,64 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <tierone/tar/error.hpp>
+#include <tierone/tar/archive_index.hpp>
+#include <tierone/tar/stream.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <expected>
+#include <functional>
+#include <span>
+
+namespace tierone::tar {
+
+struct scan_options {
+    // Number of scanning threads, 0 uses std::thread::hardware_concurrency()
+    unsigned threads = 0;
+
+    // Bytes of archive each thread walks at a time
+    // Archives no larger than one range are scanned on the calling thread.
+    uint64_t range_size = 256 * 1024 * 1024;
+};
+
+// Called for each entry with its stored data, sparse maps excluded
+using scan_visitor = std::function<std::expected<void, error>(
+    const index_record& record, std::span<const std::byte> stored_data)>;
+
+// Index an uncompressed archive with several threads
+//
+// The archive is cut into ranges that are walked at once. Each thread finds
+// the first block of its range that passes the magic and checksum checks and
+// follows the header chain from there, past the end of its range, with PAX
+// and GNU extension headers applied as archive_reader does. The ranges are
+// then joined along the true chain from the first header: where a range's
+// walk started inside member data and never met that chain, the range is
+// walked again from the right place. Entries following a PAX global header
+// are parsed again in order, as their metadata depends on it. The stream must
+// be memory-backed (mapped_data()), as with mmap_stream.
+[[nodiscard]] std::expected<archive_index, error> scan_archive(
+    const random_access_stream& stream, const scan_options& options = {});
+
+// Index the archive as scan_archive() does, then call visit for every entry
+// Entries are handed to the threads in contiguous runs, in archive order
+// within each run. The first error stops the scan and is returned.
+[[nodiscard]] std::expected<void, error> for_each_entry(
+    const random_access_stream& stream, const scan_visitor& visit, const scan_options& options = {});
+
+} // namespace tierone::tar
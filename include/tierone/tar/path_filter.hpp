@@ -0,0 +1,59 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <tierone/tar/entry_view.hpp>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace tierone::tar {
+
+// Shell-style match of a whole path
+// '*' and '?' stop at '/', "**" also crosses directories ("a/**/b" matches
+// "a/b"), [...] matches one character of a set, [!...] one outside it, and
+// a backslash escapes the next character.
+[[nodiscard]] bool glob_match(std::string_view pattern, std::string_view path) noexcept;
+
+// Member selection by path, for archive_reader::next_entry(filter)
+// A path matches when it matches any glob or starts with any prefix; a
+// leading "./" is ignored. An empty filter matches every path.
+class path_filter {
+private:
+    struct glob {
+        std::string pattern;
+        size_t literal_length;  // Characters before the first wildcard
+    };
+
+    std::vector<glob> globs_;
+    std::vector<std::string> prefixes_;
+
+public:
+    path_filter() = default;
+    path_filter(std::initializer_list<std::string_view> globs);
+
+    path_filter& add_glob(std::string_view pattern);
+    path_filter& add_prefix(std::string_view prefix);
+
+    [[nodiscard]] bool empty() const noexcept { return globs_.empty() && prefixes_.empty(); }
+    [[nodiscard]] bool matches(std::string_view path) const noexcept;
+
+    [[nodiscard]] bool operator()(const entry_view& view) const noexcept { return matches(view.path()); }
+};
+
+} // namespace tierone::tar
@@ -17,7 +17,10 @@
 #pragma once
 
 #include <tierone/tar/error.hpp>
+#include <cstdint>
+#include <utility>
 #include <map>
+#include <optional>
 #include <string>
 #include <string_view>
 #include <expected>
@@ -27,14 +30,84 @@
 namespace tierone::tar {
     // Forward declarations
     struct acl_entry;
+    struct file_metadata;
     using extended_attributes = std::map<std::string, std::string>;
 }
 
 namespace tierone::tar::pax {
 
-// Parse PAX extended header format
+// One "key=value" record, viewing the header data it was parsed from
+struct record {
+    std::string_view key;
+    std::string_view value;
+};
+
+// Records of one PAX extended header, with the common keys decoded during
+// the scan so applying them needs no lookups
+// All views point into the data given to parse_records() and are valid as
+// long as it is. Reusing one instance keeps its capacity between headers.
+struct extended_header {
+    std::vector<record> records;  // In order of appearance
+
+    // Last occurrence of each key wins, as with the map form
+    std::optional<std::string_view> path;
+    std::optional<std::string_view> linkpath;
+    std::optional<std::string_view> uname;
+    std::optional<std::string_view> gname;
+    std::optional<uint64_t> size;
+    std::optional<uint32_t> uid;
+    std::optional<uint32_t> gid;
+    std::optional<int64_t> mtime;  // Whole seconds, any fraction dropped
+
+    bool gnu_sparse = false;  // Any of GNU.sparse.major, minor or map present
+    int sparse_major = 0;
+    int sparse_minor = 0;
+    std::optional<uint64_t> sparse_realsize;
+
+    bool has_xattrs_or_acls = false;  // SCHILY/LIBARCHIVE xattr or SCHILY.acl keys
+
+    void clear() noexcept;
+    [[nodiscard]] bool empty() const noexcept { return records.empty(); }
+
+    // Value of the last record with this key
+    [[nodiscard]] std::optional<std::string_view> find(std::string_view key) const noexcept;
+
+    // Apply path, linkpath, size, ids, names, mtime, xattrs and ACLs
+    void apply_to(file_metadata& metadata) const;
+};
+
+// Values set by PAX global headers ('g'), in force for the rest of the archive
+// Layered between the ustar header and an entry's own PAX records. Later
+// global headers override earlier ones key by key, and an empty value drops
+// the key. The common keys are decoded once, so applying them to each entry
+// costs a few branches.
+struct global_header {
+    std::optional<std::string> uname;
+    std::optional<std::string> gname;
+    std::optional<uint32_t> uid;
+    std::optional<uint32_t> gid;
+    std::optional<int64_t> mtime;
+
+    // Every key in force, such as the "comment" git archive stores
+    std::vector<std::pair<std::string, std::string>> records;
+
+    void merge(const extended_header& header);
+    void clear() noexcept;
+    [[nodiscard]] bool empty() const noexcept { return records.empty(); }
+    [[nodiscard]] std::optional<std::string_view> find(std::string_view key) const noexcept;
+
+    // Apply uname, gname, uid, gid and mtime
+    void apply_to(file_metadata& metadata) const;
+};
+
+// Parse PAX records into out, replacing its contents
+// Allocation free once out has grown to the record count.
+[[nodiscard]] std::expected<void, error> parse_records(std::span<const std::byte> data, extended_header& out);
+
+// Parse PAX extended header format into an owning map
 // : "length key=value\n"
 // Example: "25 path=long/file/name.txt\n"
+// The reader uses parse_records(), which does not allocate per record
 [[nodiscard]] std::expected<std::map<std::string, std::string>, error>
 parse_pax_headers(std::span<const std::byte> data);
 
@@ -47,11 +120,14 @@ parse_pax_headers(std::span<const std::byte> data);
 // Extract extended attributes from PAX headers
 // Looks for keys like SCHILY.xattr.user.*, SCHILY.xattr.security.*, etc.
 [[nodiscard]] extended_attributes extract_extended_attributes(const std::map<std::string, std::string>& headers);
+[[nodiscard]] extended_attributes extract_extended_attributes(const extended_header& header);
 
 // Extract POSIX ACLs from PAX headers  
 // Looks for SCHILY.acl.access and SCHILY.acl.default
 [[nodiscard]] std::pair<std::vector<acl_entry>, std::vector<acl_entry>> 
 extract_acls(const std::map<std::string, std::string>& headers);
+[[nodiscard]] std::pair<std::vector<acl_entry>, std::vector<acl_entry>>
+extract_acls(const extended_header& header);
 
 // Parse ACL text format to ACL entries
 // Format: "user::rwx,group::r-x,other::r--,user:1000:rwx,mask::rwx"
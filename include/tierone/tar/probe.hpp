@@ -0,0 +1,52 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <tierone/tar/decompress.hpp>
+#include <tierone/tar/header_parser.hpp>
+#include <cstddef>
+#include <span>
+
+namespace tierone::tar {
+
+// Header layout of the first archive member
+enum class tar_format {
+    none,   // Not a tar archive, or compressed
+    empty,  // Nothing but the end-of-archive marker
+    ustar,  // POSIX ustar
+    pax,    // POSIX ustar starting with a PAX extended or global header
+    gnu     // GNU tar
+};
+
+struct probe_result {
+    compression_format compression = compression_format::none;
+    tar_format format = tar_format::none;
+
+    [[nodiscard]] bool is_tar() const noexcept { return format != tar_format::none; }
+};
+
+// Bytes probe() needs to recognize every format, including empty archives
+constexpr size_t probe_size = 2 * detail::BLOCK_SIZE;
+
+// Classify data from its leading bytes, without building a reader
+// Compressed data is only identified by its magic, format stays none. For
+// uncompressed data the first header's magic, version and checksum are
+// checked in place. Allocates nothing.
+[[nodiscard]] probe_result probe(std::span<const std::byte> head) noexcept;
+
+} // namespace tierone::tar
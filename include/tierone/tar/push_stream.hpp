@@ -0,0 +1,100 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <tierone/tar/error.hpp>
+#include <tierone/tar/stream.hpp>
+#include <cstddef>
+#include <expected>
+#include <functional>
+#include <memory>
+#include <span>
+#include <utility>
+
+namespace tierone::tar {
+
+// Input stream over data pushed in by another thread, such as a request body
+// delivered chunk by chunk by an HTTP server
+//
+// Data passes through a bounded ring buffer. A producer that gets ahead of the
+// reader blocks in push(), or sees try_push() accept less, until the reader
+// frees space. Skipping past the buffered bytes never waits: the remainder is
+// dropped by the producer as it arrives, without being copied into the ring.
+// read() blocks until the buffer is full or the stream ends, so the archive
+// parser always sees complete extension headers and sparse maps.
+class push_stream : public input_stream {
+public:
+    struct ring;
+
+    // Producer side of a push_stream
+    // Dropping a feeder without finish() fails the stream.
+    class feeder {
+    private:
+        std::shared_ptr<ring> ring_;
+
+        friend class push_stream;
+        explicit feeder(std::shared_ptr<ring> ring) : ring_(std::move(ring)) {}
+
+    public:
+        feeder(feeder&& other) noexcept = default;
+        feeder& operator=(feeder&& other) noexcept;
+        ~feeder();
+
+        // Queue all of data, waiting for the reader to free space as needed
+        // Fails once the reading side has been destroyed
+        [[nodiscard]] std::expected<void, error> push(std::span<const std::byte> data);
+
+        // Queue what fits without waiting, returns the bytes taken
+        [[nodiscard]] std::expected<size_t, error> try_push(std::span<const std::byte> data);
+
+        // Run callback once the ring has free space again, from the reading
+        // thread, or right away if it already has; for event-loop producers
+        // that resume delivery after try_push() took less than offered
+        void when_writable(std::function<void()> callback);
+
+        // End of data
+        void finish();
+
+        // End the stream with an error the reader sees once buffered data is read
+        void fail(error failure);
+    };
+
+private:
+    std::shared_ptr<ring> ring_;
+
+    explicit push_stream(std::shared_ptr<ring> ring) : ring_(std::move(ring)) {}
+
+public:
+    static constexpr size_t default_capacity = 4 * 1024 * 1024;
+
+    // A stream and the feeder that supplies it, sharing a ring of capacity bytes
+    [[nodiscard]] static std::pair<push_stream, feeder> create(size_t capacity = default_capacity);
+
+    push_stream(push_stream&& other) noexcept = default;
+    push_stream& operator=(push_stream&& other) noexcept;
+    ~push_stream() override;
+
+    [[nodiscard]] std::expected<size_t, error> read(std::span<std::byte> buffer) override;
+    [[nodiscard]] std::expected<void, error> skip(uint64_t bytes) override;
+    [[nodiscard]] bool at_end() const override;
+
+    // Views that wrap around the end of the ring are copied, others point into it
+    [[nodiscard]] bool can_peek() const override { return true; }
+    [[nodiscard]] std::expected<std::span<const std::byte>, error> peek(size_t bytes) override;
+};
+
+} // namespace tierone::tar
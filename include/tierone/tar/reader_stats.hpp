@@ -0,0 +1,132 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace tierone::tar {
+
+// Whether archive_reader keeps its counters, set by TIERONE_TAR_ENABLE_STATS
+#ifdef TIERONE_TAR_ENABLE_STATS
+inline constexpr bool stats_enabled = true;
+#else
+inline constexpr bool stats_enabled = false;
+#endif
+
+// Where an archive_reader spent its work on the current archive
+// Counts the calls the reader makes into its stream, not the stream's own
+// system calls. Without TIERONE_TAR_ENABLE_STATS every record_*() compiles
+// to nothing and all counters stay zero.
+struct reader_stats {
+    uint64_t headers_parsed = 0;  // Header blocks decoded, extension headers included
+    uint64_t pax_headers = 0;     // PAX extended and global headers
+    uint64_t gnu_extensions = 0;  // GNU longname, longlink, sparse and volume headers
+    uint64_t bytes_read = 0;      // Bytes read or peeked from the stream
+    uint64_t bytes_skipped = 0;   // Bytes passed over with skip(), padding included
+    uint64_t read_calls = 0;      // Stream read() and peek() calls
+    uint64_t skip_calls = 0;
+    uint64_t seek_calls = 0;
+    uint64_t buffer_resizes = 0;  // Extension payload and sparse map buffers that had to grow
+
+    std::chrono::nanoseconds header_time{};  // Reading and decoding header chains
+    std::chrono::nanoseconds skip_time{};    // Skipping data left unread
+    std::chrono::nanoseconds data_time{};    // Reading entry data from the stream
+
+    void record_header(const bool pax, const bool gnu_extension) noexcept {
+        if constexpr (stats_enabled) {
+            ++headers_parsed;
+            pax_headers += pax ? 1 : 0;
+            gnu_extensions += gnu_extension ? 1 : 0;
+        }
+    }
+
+    void record_read(const size_t bytes) noexcept {
+        if constexpr (stats_enabled) {
+            ++read_calls;
+            bytes_read += bytes;
+        }
+    }
+
+    void record_skip(const uint64_t bytes) noexcept {
+        if constexpr (stats_enabled) {
+            ++skip_calls;
+            bytes_skipped += bytes;
+        }
+    }
+
+    void record_seek() noexcept {
+        if constexpr (stats_enabled) {
+            ++seek_calls;
+        }
+    }
+
+    // Count a buffer whose capacity went from before to after
+    void record_growth(const size_t before, const size_t after) noexcept {
+        if constexpr (stats_enabled) {
+            buffer_resizes += after > before ? 1 : 0;
+        }
+    }
+
+    reader_stats& operator+=(const reader_stats& other) noexcept {
+        headers_parsed += other.headers_parsed;
+        pax_headers += other.pax_headers;
+        gnu_extensions += other.gnu_extensions;
+        bytes_read += other.bytes_read;
+        bytes_skipped += other.bytes_skipped;
+        read_calls += other.read_calls;
+        skip_calls += other.skip_calls;
+        seek_calls += other.seek_calls;
+        buffer_resizes += other.buffer_resizes;
+        header_time += other.header_time;
+        skip_time += other.skip_time;
+        data_time += other.data_time;
+        return *this;
+    }
+};
+
+namespace detail {
+
+// Adds the time until it goes out of scope to one phase of reader_stats
+class phase_timer {
+private:
+    std::chrono::nanoseconds* total_ = nullptr;
+    std::chrono::steady_clock::time_point start_;
+
+public:
+    explicit phase_timer([[maybe_unused]] std::chrono::nanoseconds& total) noexcept {
+        if constexpr (stats_enabled) {
+            total_ = &total;
+            start_ = std::chrono::steady_clock::now();
+        }
+    }
+
+    phase_timer(const phase_timer&) = delete;
+    phase_timer& operator=(const phase_timer&) = delete;
+
+    ~phase_timer() {
+        if constexpr (stats_enabled) {
+            *total_ += std::chrono::steady_clock::now() - start_;
+        }
+    }
+};
+
+} // namespace detail
+
+} // namespace tierone::tar
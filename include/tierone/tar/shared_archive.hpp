@@ -0,0 +1,85 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <tierone/tar/error.hpp>
+#include <tierone/tar/stream.hpp>
+#include <tierone/tar/archive_entry.hpp>
+#include <tierone/tar/archive_reader.hpp>
+#include <tierone/tar/archive_index.hpp>
+#include <cstddef>
+#include <expected>
+#include <filesystem>
+#include <memory>
+#include <span>
+#include <string_view>
+#include <vector>
+
+namespace tierone::tar {
+
+// Immutable, indexed archive in memory, shared by many threads
+//
+// An archive_reader is a single cursor: its stream position and entry
+// bookkeeping belong to whoever is iterating. A shared_archive instead
+// holds the whole archive mapped (or loaded, where mmap is unavailable)
+// together with its index, and never changes after open(). Every const
+// member is safe to call from any number of threads without locking.
+// Each call to open_entry() or reader() returns a new object owned by the
+// caller, with its own position and buffers, so nothing read by one thread
+// is touched by another. Entries and readers point into the archive's
+// memory and must not outlive it.
+class shared_archive {
+private:
+    std::unique_ptr<random_access_stream> mapping_;  // Keeps a mapped file alive, never read through
+    std::vector<std::byte> loaded_;                  // File contents where it could not be mapped
+    std::span<const std::byte> data_;
+    archive_index index_;
+
+    shared_archive() = default;
+
+    [[nodiscard]] static std::expected<std::shared_ptr<const shared_archive>, error> finish(
+        std::shared_ptr<shared_archive> archive);
+
+public:
+    // Map the uncompressed archive at path and index it
+    [[nodiscard]] static std::expected<std::shared_ptr<const shared_archive>, error> open(
+        const std::filesystem::path& path);
+
+    // Index an archive already in memory
+    // The caller keeps data alive for as long as the shared_archive
+    [[nodiscard]] static std::expected<std::shared_ptr<const shared_archive>, error> open(
+        std::span<const std::byte> data);
+
+    shared_archive(const shared_archive&) = delete;
+    shared_archive& operator=(const shared_archive&) = delete;
+
+    [[nodiscard]] const archive_index& index() const noexcept { return index_; }
+    [[nodiscard]] std::span<const std::byte> data() const noexcept { return data_; }
+
+    // Entry for a record of index(), reading straight out of the archive
+    // Plain files hand out zero-copy spans; sparse files are expanded by the
+    // entry into a buffer of its own.
+    [[nodiscard]] std::expected<archive_entry, error> open_entry(const index_record& record) const;
+
+    // Entry for the last member with path, invalid_operation with ENOENT if none
+    [[nodiscard]] std::expected<archive_entry, error> open_entry(std::string_view path) const;
+
+    // Independent sequential cursor over the archive, from its first entry
+    [[nodiscard]] archive_reader reader() const;
+};
+
+} // namespace tierone::tar
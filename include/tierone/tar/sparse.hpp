@@ -18,6 +18,9 @@
 
 #include <tierone/tar/error.hpp>
 #include <tierone/tar/stream.hpp>
+#include <algorithm>
+#include <cstddef>
+#include <span>
 #include <vector>
 #include <cstdint>
 #include <optional>
@@ -39,7 +42,7 @@ struct sparse_entry {
 
 // GNU sparse file header layout - they reuse parts of the standard header
 struct gnu_sparse_header {
-    // Standard ustar header (first 329 bytes)
+    // Standard ustar header (first 345 bytes)
     char name[100];        // 0-99
     char mode[8];          // 100-107
     char uid[8];           // 108-115  
@@ -56,21 +59,34 @@ struct gnu_sparse_header {
     char devmajor[8];      // 329-336
     char devminor[8];      // 337-344
     
-    // GNU sparse uses part of the prefix field for a sparse map (starts at 345)
-    char prefix_part1[39]; // 345-383 (first part of the prefix still available)
+    // Old GNU fields in place of the ustar prefix
+    char atime[12];        // 345-356
+    char ctime[12];        // 357-368
+    char offset[12];       // 369-380 (multi-volume continuation offset)
+    char longnames[4];     // 381-384
+    char unused;           // 385
     
-    // Sparse map starts at offset 384 (0x180)
+    // Sparse map starts at offset 386
     struct sparse_entry {
         char offset[12];
         char numbytes[12];
-    } sp[4];               // 384-479 (4 entries * 24 bytes = 96 bytes)
-    char isextended;       // 480
-    char realsize[12];     // 481-492 (real file size)
-    char pad2[19];         // 493-511
+    } sp[4];               // 386-481 (4 entries * 24 bytes = 96 bytes)
+    char isextended;       // 482 (non-zero if extension blocks follow)
+    char realsize[12];     // 483-494 (real file size)
+    char pad2[17];         // 495-511
 };
 
 static_assert(sizeof(gnu_sparse_header) == 512, "GNU sparse header must be exactly 512 bytes");
 
+// Extension block following an old GNU sparse header whose isextended is set
+struct gnu_sparse_extension {
+    gnu_sparse_header::sparse_entry sp[21];  // 0-503
+    char isextended;                         // 504 (non-zero if another block follows)
+    char pad[7];                             // 505-511
+};
+
+static_assert(sizeof(gnu_sparse_extension) == 512, "GNU sparse extension must be exactly 512 bytes");
+
 struct gnu_sparse_header_1_0 {
     // GNU.sparse.major/minor version
     // GNU.sparse.name - real file name
@@ -79,12 +95,20 @@ struct gnu_sparse_header_1_0 {
 };
 
 // Sparse file metadata
+// Segments are in ascending offset order, as tar writers emit them
 struct sparse_metadata {
     uint64_t real_size = 0;  // Actual size of the file
     std::vector<sparse_entry> segments;  // Non-zero data segments
     
+    // data_offsets[i] is where segment i starts in the stored data, with the
+    // total as last element. Built by index_segments(), empty until then
+    std::vector<uint64_t> data_offsets{};
+    
     // Calculate total data size (sum of all segments)
     [[nodiscard]] uint64_t total_data_size() const noexcept {
+        if (data_offsets.size() == segments.size() + 1) {
+            return data_offsets.back();
+        }
         uint64_t total = 0;
         for (const auto& seg : segments) {
             total += seg.size;
@@ -92,37 +116,149 @@ struct sparse_metadata {
         return total;
     }
     
+    // Precompute the stored data offset of every segment
+    void index_segments() {
+        data_offsets.resize(segments.size() + 1);
+        uint64_t total = 0;
+        for (size_t i = 0; i < segments.size(); ++i) {
+            data_offsets[i] = total;
+            total += segments[i].size;
+        }
+        data_offsets.back() = total;
+    }
+    
+    // Offset of segment i inside the stored data
+    [[nodiscard]] uint64_t data_offset_of(const size_t i) const noexcept {
+        if (data_offsets.size() == segments.size() + 1) {
+            return data_offsets[i];
+        }
+        uint64_t total = 0;
+        for (size_t j = 0; j < i; ++j) {
+            total += segments[j].size;
+        }
+        return total;
+    }
+    
+    // Index of the first segment that ends after offset, segments.size() if none
+    // The offset lies in that segment or in the hole just before it
+    [[nodiscard]] size_t lower_segment(const uint64_t offset) const noexcept {
+        const auto it = std::ranges::partition_point(segments,
+            [offset](const sparse_entry& seg) { return seg.offset + seg.size <= offset; });
+        return static_cast<size_t>(std::distance(segments.begin(), it));
+    }
+    
     // Check if a given offset falls within a data segment
     [[nodiscard]] std::optional<size_t> find_segment(const uint64_t offset) const noexcept {
-        for (size_t i = 0; i < segments.size(); ++i) {
-            const auto&[segoffset, size] = segments[i];
-            if (offset >= segoffset && offset < segoffset + size) {
-                return i;
-            }
+        const size_t i = lower_segment(offset);
+        if (i < segments.size() && offset >= segments[i].offset && segments[i].size > 0) {
+            return i;
         }
         return std::nullopt;
     }
 };
 
+// Remembers the last segment used, so sequential reads locate the next one
+// in constant time and only jumps fall back to binary search
+class segment_cursor {
+private:
+    size_t index_ = 0;
+
+    [[nodiscard]] static bool covers(const sparse_metadata& info, const size_t i, const uint64_t offset) noexcept {
+        const auto& segs = info.segments;
+        if (i > segs.size()) {
+            return false;
+        }
+        const bool after_previous = i == 0 || offset >= segs[i - 1].offset + segs[i - 1].size;
+        const bool before_end = i == segs.size() || offset < segs[i].offset + segs[i].size;
+        return after_previous && before_end;
+    }
+
+public:
+    // Same result as info.lower_segment(offset)
+    [[nodiscard]] size_t locate(const sparse_metadata& info, const uint64_t offset) noexcept {
+        if (!covers(info, index_, offset)) {
+            if (covers(info, index_ + 1, offset)) {
+                ++index_;
+            } else {
+                index_ = info.lower_segment(offset);
+            }
+        }
+        return index_;
+    }
+};
+
+// Parses the decimal map GNU sparse 1.0 stores ahead of the data, a block at a time
+// The map is the segment count, then an offset and a size per segment, each
+// ending in a newline, padded with NULs to a block boundary. Numbers may
+// straddle blocks; nothing is buffered beyond the one being parsed. Segments
+// go straight into the target, reserved from the declared count; without a
+// target the map is only checked, to find where the data starts.
+class map_parser {
+private:
+    sparse_metadata* target_;
+    uint64_t real_size_;
+    uint64_t value_ = 0;        // Number being parsed
+    bool in_number_ = false;
+    uint64_t numbers_ = 0;      // Complete numbers so far, the count first
+    uint64_t expected_ = 0;     // Numbers the count announces, including itself
+    uint64_t offset_ = 0;       // Offset of the segment whose size comes next
+    uint64_t end_ = 0;          // End of the last segment, segments must not overlap
+    size_t blocks_ = 0;
+
+    [[nodiscard]] std::expected<void, error> finish_number();
+
+public:
+    explicit map_parser(sparse_metadata* target, const uint64_t real_size) noexcept
+        : target_(target), real_size_(real_size) {}
+
+    // Parse the next block of the map, true once the map is complete
+    // The rest of the block holding the map's end is padding.
+    [[nodiscard]] std::expected<bool, error> feed(std::span<const std::byte> block);
+
+    // Whether the whole map has been parsed
+    [[nodiscard]] bool done() const noexcept { return numbers_ > 0 && numbers_ == expected_; }
+
+    // Blocks fed so far, which is the map's size once it is done
+    [[nodiscard]] size_t blocks() const noexcept { return blocks_; }
+};
+
+// Whether an old GNU sparse header is followed by extension blocks
+[[nodiscard]] bool old_map_continues(std::span<const std::byte, 512> header) noexcept;
+
+// Whether a sparse extension block is followed by another
+[[nodiscard]] inline bool extension_continues(std::span<const std::byte, 512> block) noexcept {
+    return block[offsetof(gnu_sparse_extension, isextended)] != std::byte{0};
+}
+
 // Parse old GNU sparse format from header
 [[nodiscard]] std::expected<sparse_metadata, error> parse_old_sparse_header(
     const ustar_header& header
 );
 
+// Append the segments of one sparse extension block
+// Returns whether another extension block follows.
+[[nodiscard]] std::expected<bool, error> parse_old_sparse_extension(
+    std::span<const std::byte, 512> block,
+    sparse_metadata& into
+);
+
 // Parse GNU sparse 1.0 format from PAX extended headers
 [[nodiscard]] std::expected<sparse_metadata, error> parse_sparse_1_0_header(
     const std::map<std::string, std::string>& pax_headers
 );
 
 // Parse GNU sparse 1.0 format sparse map from file data block
+// Reads whole blocks, leaving the stream at the first byte of data.
 [[nodiscard]] std::expected<sparse_metadata, error> parse_sparse_1_0_data_map(
     input_stream& stream,
     uint64_t real_size
 );
 
-// Read sparse map continuation from archive stream
-[[nodiscard]] std::expected<std::vector<sparse_entry>, error> read_sparse_map_continuation(
-    input_stream& stream
+// Read the extension blocks of an old GNU sparse header from the archive stream
+// Their segments are appended to into. Returns the number of blocks read.
+[[nodiscard]] std::expected<size_t, error> read_sparse_map_continuation(
+    input_stream& stream,
+    sparse_metadata& into
 );
 
 } // namespace tierone::tar::sparse
\ No newline at end of file
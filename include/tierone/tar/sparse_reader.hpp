@@ -29,17 +29,19 @@ namespace tierone::tar::sparse {
 
 // Create a sparse-aware data reader that returns zeros for holes
 // and actual data for non-sparse regions
+// Returned spans point into a buffer owned by the reader, valid until its
+// next call; copies of the reader get buffers of their own.
 inline auto make_sparse_reader(
     const sparse_metadata& sparse_info,
     std::function<std::expected<std::span<const std::byte>, error>(size_t, size_t)> base_reader
 ) -> std::function<std::expected<std::span<const std::byte>, error>(size_t, size_t)> {
     
-    return [sparse_info, base_reader = std::move(base_reader)](size_t offset, size_t length) 
-        -> std::expected<std::span<const std::byte>, error> {
-        
-        // Thread-local buffers for zero-filled data and combined results
-        thread_local std::vector<std::byte> zero_buffer;
-        thread_local std::vector<std::byte> result_buffer;
+    sparse_metadata indexed = sparse_info;
+    indexed.index_segments();
+    
+    return [sparse_info = std::move(indexed), base_reader = std::move(base_reader), cursor = segment_cursor{},
+            result_buffer = std::vector<std::byte>{}](
+        size_t offset, size_t length) mutable -> std::expected<std::span<const std::byte>, error> {
         
         // Clamp length to not exceed the sparse file's real size
         if (offset >= sparse_info.real_size) {
@@ -59,21 +61,20 @@ inline auto make_sparse_reader(
         size_t remaining = length;
         
         while (remaining > 0) {
-            // Find which segment (if any) contains current_offset
+            // Find the segment containing current_offset, or the one after the hole
+            const size_t segment_idx = cursor.locate(sparse_info, current_offset);
+            const bool in_segment = segment_idx < sparse_info.segments.size() &&
+                                    current_offset >= sparse_info.segments[segment_idx].offset;
 
-            if (auto segment_idx = sparse_info.find_segment(current_offset)) {
+            if (in_segment) {
                 // We're in a data segment
-                const auto& segment = sparse_info.segments[*segment_idx];
+                const auto& segment = sparse_info.segments[segment_idx];
                 const size_t segment_offset = current_offset - segment.offset;
                 size_t segment_remaining = segment.size - segment_offset;
                 const size_t to_read = std::min(remaining, segment_remaining);
                 
-                // Calculate the actual offset in the sparse data
-                size_t sparse_data_offset = 0;
-                for (size_t i = 0; i < *segment_idx; ++i) {
-                    sparse_data_offset += sparse_info.segments[i].size;
-                }
-                sparse_data_offset += segment_offset;
+                // The actual offset in the sparse data
+                const size_t sparse_data_offset = sparse_info.data_offset_of(segment_idx) + segment_offset;
                 
                 // Read from the underlying reader
                 auto read_result = base_reader(sparse_data_offset, to_read);
@@ -89,30 +90,16 @@ inline auto make_sparse_reader(
                 current_offset += read_result->size();
                 remaining -= read_result->size();
             } else {
-                // We're in a hole - return zeros
-                size_t next_segment_start = sparse_info.real_size;
-                
-                // Find the start of the next segment after current_offset
-                for (const auto& seg : sparse_info.segments) {
-                    if (seg.offset > current_offset) {
-                        next_segment_start = seg.offset;
-                        break;
-                    }
-                }
+                // We're in a hole - return zeros up to the next segment
+                const size_t next_segment_start = segment_idx < sparse_info.segments.size() ?
+                    sparse_info.segments[segment_idx].offset : sparse_info.real_size;
                 
                 size_t hole_size = next_segment_start - current_offset;
                 const size_t to_fill = std::min(remaining, hole_size);
                 
                 
-                // Resize zero buffer if needed
-                if (zero_buffer.size() < to_fill) {
-                    zero_buffer.resize(to_fill, std::byte{0});
-                }
-                
                 // Append zeros to result
-                result_buffer.insert(result_buffer.end(), 
-                                   zero_buffer.begin(), 
-                                   zero_buffer.begin() + static_cast<std::ptrdiff_t>(to_fill));
+                result_buffer.resize(result_buffer.size() + to_fill, std::byte{0});
                 
                 current_offset += to_fill;
                 remaining -= to_fill;
@@ -123,4 +110,80 @@ inline auto make_sparse_reader(
     };
 }
 
+// Fill buffer with the logical bytes at offset of a sparse file, writing zeros
+// for holes and reading data segments through read_stored(stored_offset, out)
+// Returns the bytes written, 0 at the end of the file. cursor carries the
+// current segment between calls so sequential reads need no search.
+template<typename StoredReader>
+auto read_expanded(
+    const sparse_metadata& sparse_info,
+    segment_cursor& cursor,
+    const size_t offset,
+    std::span<std::byte> buffer,
+    StoredReader&& read_stored
+) -> std::expected<size_t, error> {
+    // Reading beyond end-of-file
+    if (offset >= sparse_info.real_size) {
+        return size_t{0};
+    }
+
+    const size_t length = std::min(buffer.size(), static_cast<size_t>(sparse_info.real_size - offset));
+    size_t filled = 0;
+    
+    while (filled < length) {
+        const size_t current_offset = offset + filled;
+
+        const size_t segment_idx = cursor.locate(sparse_info, current_offset);
+        const bool in_segment = segment_idx < sparse_info.segments.size() &&
+                                current_offset >= sparse_info.segments[segment_idx].offset;
+
+        if (in_segment) {
+            // We're in a data segment
+            const auto& segment = sparse_info.segments[segment_idx];
+            const size_t segment_offset = current_offset - segment.offset;
+            const size_t to_read = std::min(length - filled, static_cast<size_t>(segment.size - segment_offset));
+            
+            // The actual offset in the sparse data
+            const size_t sparse_data_offset = sparse_info.data_offset_of(segment_idx) + segment_offset;
+            
+            auto read_result = read_stored(sparse_data_offset, buffer.subspan(filled, to_read));
+            if (!read_result) {
+                return read_result;
+            }
+            if (*read_result == 0) {
+                return std::unexpected(error{error_code::corrupt_archive, 
+                    "Unexpected end of sparse file data"});
+            }
+            
+            filled += *read_result;
+        } else {
+            // We're in a hole - write zeros up to the next segment
+            const size_t next_segment_start = segment_idx < sparse_info.segments.size() ?
+                sparse_info.segments[segment_idx].offset : sparse_info.real_size;
+            
+            const size_t to_fill = std::min(length - filled, next_segment_start - current_offset);
+            std::ranges::fill(buffer.subspan(filled, to_fill), std::byte{0});
+            filled += to_fill;
+        }
+    }
+    
+    return filled;
+}
+
+// Create a sparse-aware reader that fills a caller-owned buffer, writing zeros
+// for holes and reading non-sparse regions through base_reader
+inline auto make_sparse_read_into(
+    const sparse_metadata& sparse_info,
+    std::function<std::expected<size_t, error>(size_t, std::span<std::byte>)> base_reader
+) -> std::function<std::expected<size_t, error>(size_t, std::span<std::byte>)> {
+    
+    sparse_metadata indexed = sparse_info;
+    indexed.index_segments();
+    
+    return [sparse_info = std::move(indexed), base_reader = std::move(base_reader), cursor = segment_cursor{}](
+        size_t offset, std::span<std::byte> buffer) mutable -> std::expected<size_t, error> {
+        return read_expanded(sparse_info, cursor, offset, buffer, base_reader);
+    };
+}
+
 } // namespace tierone::tar::sparse
\ No newline at end of file
@@ -20,10 +20,14 @@
 #include <expected>
 #include <span>
 #include <memory>
+#include <optional>
 #include <filesystem>
 #include <algorithm>
 #include <ranges>
+#include <vector>
 #include <cstdio>
+#include <cstdint>
+#include <cstdlib>
 
 #ifdef __linux__
 #include <sys/mman.h>
@@ -40,23 +44,39 @@ public:
     [[nodiscard]] virtual std::expected<size_t, error> read(std::span<std::byte> buffer) = 0;
 
     // Skip n bytes in the stream
-    [[nodiscard]] virtual std::expected<void, error> skip(size_t bytes) = 0;
+    [[nodiscard]] virtual std::expected<void, error> skip(uint64_t bytes) = 0;
 
     // Check if at end of stream
     [[nodiscard]] virtual bool at_end() const = 0;
+
+    // Whether peek() is supported
+    [[nodiscard]] virtual bool can_peek() const { return false; }
+
+    // View of the next bytes without consuming them, shorter only at end of stream
+    // The view stays valid until the next read(), peek() or seek(); skipping within it keeps it valid
+    [[nodiscard]] virtual std::expected<std::span<const std::byte>, error> peek(size_t /*bytes*/) {
+        return std::span<const std::byte>{};
+    }
 };
 
 // Extended interface for streams that support random access
 class random_access_stream : public input_stream {
 public:
     // Seek to absolute position
-    [[nodiscard]] virtual std::expected<void, error> seek(size_t position) = 0;
+    [[nodiscard]] virtual std::expected<void, error> seek(uint64_t position) = 0;
 
     // Get current position
-    [[nodiscard]] virtual size_t position() const = 0;
+    [[nodiscard]] virtual uint64_t position() const = 0;
 
     // Get total size (if known)
-    [[nodiscard]] virtual std::optional<size_t> size() const = 0;
+    [[nodiscard]] virtual std::optional<uint64_t> size() const = 0;
+
+    // Contiguous view of the whole stream, for streams backed by memory
+    [[nodiscard]] virtual std::optional<std::span<const std::byte>> mapped_data() const { return std::nullopt; }
+
+    // Hint that the bytes at [offset, offset + length) will be read soon
+    // Streams that cannot act on it ignore it
+    virtual void will_need([[maybe_unused]] uint64_t offset, [[maybe_unused]] uint64_t length) {}
 };
 
 // Memory-mapped stream implementation
@@ -80,19 +100,19 @@ public:
         return to_read;
     }
 
-    [[nodiscard]] std::expected<void, error> skip(size_t bytes) override {
-        if (position_ + bytes > data_.size()) {
+    [[nodiscard]] std::expected<void, error> skip(uint64_t bytes) override {
+        if (bytes > data_.size() - position_) {
             return std::unexpected(error{error_code::io_error, "Skip past end of stream"});
         }
-        position_ += bytes;
+        position_ += static_cast<size_t>(bytes);
         return {};
     }
 
-    [[nodiscard]] std::expected<void, error> seek(size_t position) override {
+    [[nodiscard]] std::expected<void, error> seek(uint64_t position) override {
         if (position > data_.size()) {
             return std::unexpected(error{error_code::io_error, "Seek past end of stream"});
         }
-        position_ = position;
+        position_ = static_cast<size_t>(position);
         return {};
     }
 
@@ -100,13 +120,47 @@ public:
         return position_ >= data_.size(); 
     }
 
-    [[nodiscard]] size_t position() const override { 
+    [[nodiscard]] uint64_t position() const override { 
         return position_; 
     }
 
-    [[nodiscard]] std::optional<size_t> size() const override { 
+    [[nodiscard]] std::optional<uint64_t> size() const override { 
         return data_.size(); 
     }
+
+    [[nodiscard]] std::optional<std::span<const std::byte>> mapped_data() const override {
+        return data_;
+    }
+
+    [[nodiscard]] bool can_peek() const override { return true; }
+
+    [[nodiscard]] std::expected<std::span<const std::byte>, error> peek(size_t bytes) override {
+        return data_.subspan(position_, std::min(bytes, data_.size() - position_));
+    }
+};
+
+// Read-ahead buffer over any input stream
+// Pulls large windows from the source so header scanning parses many blocks
+// per read and short skips never reach the source
+class read_ahead_stream : public input_stream {
+private:
+    std::unique_ptr<input_stream> source_;
+    std::vector<std::byte> window_;
+    size_t begin_ = 0;  // Next unread byte in window_
+    size_t end_ = 0;    // End of buffered data in window_
+
+    [[nodiscard]] std::expected<void, error> fill(size_t bytes);
+
+public:
+    static constexpr size_t default_window_size = 1024 * 1024;
+
+    explicit read_ahead_stream(std::unique_ptr<input_stream> source, size_t window_size = default_window_size);
+
+    [[nodiscard]] std::expected<size_t, error> read(std::span<std::byte> buffer) override;
+    [[nodiscard]] std::expected<void, error> skip(uint64_t bytes) override;
+    [[nodiscard]] bool at_end() const override;
+    [[nodiscard]] bool can_peek() const override { return true; }
+    [[nodiscard]] std::expected<std::span<const std::byte>, error> peek(size_t bytes) override;
 };
 
 // File-based stream
@@ -119,24 +173,153 @@ private:
     };
     
     std::unique_ptr<std::FILE, file_deleter> file_;
-    std::optional<size_t> file_size_;
+    std::optional<uint64_t> file_size_;
 
 public:
     [[nodiscard]] static std::expected<file_stream, error> open(const std::filesystem::path& path);
 
     [[nodiscard]] std::expected<size_t, error> read(std::span<std::byte> buffer) override;
-    [[nodiscard]] std::expected<void, error> skip(size_t bytes) override;
-    [[nodiscard]] std::expected<void, error> seek(size_t position) override;
+    [[nodiscard]] std::expected<void, error> skip(uint64_t bytes) override;
+    [[nodiscard]] std::expected<void, error> seek(uint64_t position) override;
     [[nodiscard]] bool at_end() const override;
-    [[nodiscard]] size_t position() const override;
-    [[nodiscard]] std::optional<size_t> size() const override;
+    [[nodiscard]] uint64_t position() const override;
+    [[nodiscard]] std::optional<uint64_t> size() const override;
 
 private:
-    explicit file_stream(std::FILE* file, std::optional<size_t> size);
+    explicit file_stream(std::FILE* file, std::optional<uint64_t> size);
 };
 
+#ifdef __linux__
+// Buffered file descriptor stream (Linux-specific)
+// Reads go through one large aligned buffer filled with pread(), so header
+// blocks and small skips are served from memory without a system call.
+// Reads at least as large as the buffer bypass it.
+class fd_stream : public random_access_stream {
+private:
+    struct buffer_deleter {
+        void operator()(std::byte* ptr) const { std::free(ptr); }
+    };
+
+    int fd_ = -1;
+    std::unique_ptr<std::byte, buffer_deleter> buffer_;
+    size_t buffer_capacity_ = 0;
+    uint64_t buffer_offset_ = 0;  // File offset of buffer_[0]
+    size_t buffer_valid_ = 0;     // Bytes of the buffer holding file data
+    size_t buffer_cursor_ = 0;    // Current position inside the buffer
+    uint64_t file_size_ = 0;
+
+    [[nodiscard]] std::expected<size_t, error> pread_full(std::byte* dest, size_t length, uint64_t offset) const;
+
+public:
+    static constexpr size_t default_buffer_size = 1024 * 1024;
+    static constexpr size_t buffer_alignment = 4096;
+
+    // Fails with unsupported_feature for anything but a regular file
+    [[nodiscard]] static std::expected<fd_stream, error> open(
+        const std::filesystem::path& path, size_t buffer_size = default_buffer_size);
+
+    // Switch to the file at path, keeping the read buffer
+    // Saves an allocation per file when many are read in turn. On failure
+    // the stream is left reading the file it had.
+    [[nodiscard]] std::expected<void, error> reopen(const std::filesystem::path& path);
+
+    fd_stream(fd_stream&& other) noexcept;
+    fd_stream& operator=(fd_stream&& other) noexcept;
+    fd_stream(const fd_stream&) = delete;
+    fd_stream& operator=(const fd_stream&) = delete;
+    ~fd_stream() override;
+
+    [[nodiscard]] std::expected<size_t, error> read(std::span<std::byte> buffer) override;
+    [[nodiscard]] std::expected<void, error> skip(uint64_t bytes) override;
+    [[nodiscard]] std::expected<void, error> seek(uint64_t position) override;
+    [[nodiscard]] bool at_end() const override;
+    [[nodiscard]] uint64_t position() const override;
+    [[nodiscard]] std::optional<uint64_t> size() const override;
+    [[nodiscard]] bool can_peek() const override { return true; }
+    [[nodiscard]] std::expected<std::span<const std::byte>, error> peek(size_t bytes) override;
+
+    [[nodiscard]] int native_handle() const noexcept { return fd_; }
+
+private:
+    fd_stream(int fd, std::unique_ptr<std::byte, buffer_deleter> buffer, size_t capacity, uint64_t size);
+};
+#endif
+
+#ifdef __linux__
+struct uring_options {
+    // Reads kept in flight ahead of the read position, at least 2
+    unsigned queue_depth = 4;
+
+    // Bytes per read, rounded up to whole pages
+    size_t read_size = 1024 * 1024;
+};
+
+// Regular file read through io_uring (Linux-specific)
+// Keeps queue_depth reads of read_size in flight ahead of the read position
+// and serves read(), peek() and skip() from the completed buffers, so the
+// device stays busy while the caller parses. Seeking or skipping cancels the
+// prefetched reads it passes over. Needs the TIERONE_TAR_WITH_IO_URING build
+// option and a kernel that allows io_uring.
+class uring_stream : public random_access_stream {
+public:
+    struct ring;
+
+private:
+    std::unique_ptr<ring> ring_;
+
+    explicit uring_stream(std::unique_ptr<ring> ring);
+
+public:
+    // Fails with unsupported_feature for anything but a regular file, or
+    // when io_uring is not built in or refused by the kernel
+    [[nodiscard]] static std::expected<uring_stream, error> open(
+        const std::filesystem::path& path, const uring_options& options = {});
+
+    uring_stream(uring_stream&& other) noexcept;
+    uring_stream& operator=(uring_stream&& other) noexcept;
+    ~uring_stream() override;
+
+    [[nodiscard]] std::expected<size_t, error> read(std::span<std::byte> buffer) override;
+    [[nodiscard]] std::expected<void, error> skip(uint64_t bytes) override;
+    [[nodiscard]] std::expected<void, error> seek(uint64_t position) override;
+    [[nodiscard]] bool at_end() const override;
+    [[nodiscard]] uint64_t position() const override;
+    [[nodiscard]] std::optional<uint64_t> size() const override;
+    [[nodiscard]] bool can_peek() const override { return true; }
+
+    // Views are at most read_size bytes
+    [[nodiscard]] std::expected<std::span<const std::byte>, error> peek(size_t bytes) override;
+};
+#endif
+
 // Memory-mapped file stream (Linux-specific)
 #ifdef __linux__
+// How an mmap_stream tells the kernel the mapping will be read
+enum class access_pattern {
+    sequential,  // Front to back: readahead window before the position
+    random,      // Index-driven jumps: no kernel readahead, hinted entries only
+    normal       // Kernel defaults
+};
+
+struct mmap_options {
+    access_pattern pattern = access_pattern::sequential;
+
+    // Bytes kept advised with MADV_WILLNEED ahead of the position when
+    // sequential, and kept mapped behind it when release_behind is set
+    size_t window = 8 * 1024 * 1024;
+
+    // Drop pages more than window bytes behind the position when sequential,
+    // so one pass over a large archive does not fill memory
+    bool release_behind = false;
+
+    // Fault the whole file in up front with MAP_POPULATE, for hot archives
+    bool populate = false;
+
+    // Ask for transparent huge pages; only honored by kernels and
+    // filesystems that back read-only file mappings with them
+    bool huge_pages = false;
+};
+
 class mmap_stream : public random_access_stream {
 private:
     struct mapping_deleter {
@@ -149,19 +332,193 @@ private:
     std::unique_ptr<void, mapping_deleter> mapping_;
     std::span<const std::byte> data_;
     size_t position_ = 0;
+    mmap_options options_;
+    size_t advised_begin_ = 0;  // Range last advised with MADV_WILLNEED
+    size_t advised_end_ = 0;
+    size_t released_end_ = 0;   // Pages before this were released
+
+    // Slide the readahead and release windows along with position_
+    void follow_position();
+
+    void advise(size_t begin, size_t end, int advice) const;
 
 public:
-    [[nodiscard]] static std::expected<mmap_stream, error> create(const std::filesystem::path& path);
+    [[nodiscard]] static std::expected<mmap_stream, error> create(
+        const std::filesystem::path& path, const mmap_options& options = {});
 
     [[nodiscard]] std::expected<size_t, error> read(std::span<std::byte> buffer) override;
-    [[nodiscard]] std::expected<void, error> skip(size_t bytes) override;
-    [[nodiscard]] std::expected<void, error> seek(size_t position) override;
+    [[nodiscard]] std::expected<void, error> skip(uint64_t bytes) override;
+    [[nodiscard]] std::expected<void, error> seek(uint64_t position) override;
     [[nodiscard]] bool at_end() const override;
-    [[nodiscard]] size_t position() const override;
-    [[nodiscard]] std::optional<size_t> size() const override;
+    [[nodiscard]] uint64_t position() const override;
+    [[nodiscard]] std::optional<uint64_t> size() const override;
+    [[nodiscard]] std::optional<std::span<const std::byte>> mapped_data() const override;
+    [[nodiscard]] bool can_peek() const override { return true; }
+    [[nodiscard]] std::expected<std::span<const std::byte>, error> peek(size_t bytes) override;
+
+    // MADV_WILLNEED the pages of the range, unless already advised
+    void will_need(uint64_t offset, uint64_t length) override;
+
+    [[nodiscard]] const mmap_options& options() const noexcept { return options_; }
+
+private:
+    mmap_stream(void* ptr, size_t size, const mmap_options& options);
+};
+
+// Memory-mapped file stream over a sliding window (Linux-specific)
+// Only window_size bytes of the file are mapped at a time, remapped as the
+// position moves, so archives larger than the address space (multi-GB
+// files on 32-bit targets) stream with bounded address-space use. Offsets
+// are 64-bit everywhere. Views from peek() stay inside one window, so
+// unlike mmap_stream there is no mapped_data() of the whole file.
+class windowed_mmap_stream : public random_access_stream {
+private:
+    struct window_deleter {
+        size_t size;
+        void operator()(void* ptr) const {
+            if (ptr && ptr != MAP_FAILED) ::munmap(ptr, size);
+        }
+    };
+
+    int fd_ = -1;
+    uint64_t file_size_ = 0;
+    size_t window_size_ = 0;     // Whole pages
+    std::unique_ptr<void, window_deleter> window_{nullptr, window_deleter{0}};
+    uint64_t window_offset_ = 0; // File offset of the first mapped byte, page-aligned
+    size_t window_length_ = 0;
+    uint64_t position_ = 0;
+
+    // Map a window holding at least bytes bytes from position_, or up to the end of the file
+    [[nodiscard]] std::expected<void, error> map_window(size_t bytes);
+
+    // Mapped bytes from position_ on, without remapping
+    [[nodiscard]] std::span<const std::byte> window_tail() const noexcept;
+
+public:
+    static constexpr size_t default_window_size = 64 * 1024 * 1024;
+
+    [[nodiscard]] static std::expected<windowed_mmap_stream, error> open(
+        const std::filesystem::path& path, size_t window_size = default_window_size);
+
+    windowed_mmap_stream(windowed_mmap_stream&& other) noexcept;
+    windowed_mmap_stream& operator=(windowed_mmap_stream&& other) noexcept;
+    windowed_mmap_stream(const windowed_mmap_stream&) = delete;
+    windowed_mmap_stream& operator=(const windowed_mmap_stream&) = delete;
+    ~windowed_mmap_stream() override;
+
+    [[nodiscard]] std::expected<size_t, error> read(std::span<std::byte> buffer) override;
+    [[nodiscard]] std::expected<void, error> skip(uint64_t bytes) override;
+    [[nodiscard]] std::expected<void, error> seek(uint64_t position) override;
+    [[nodiscard]] bool at_end() const override;
+    [[nodiscard]] uint64_t position() const override;
+    [[nodiscard]] std::optional<uint64_t> size() const override;
+    [[nodiscard]] bool can_peek() const override { return true; }
+    [[nodiscard]] std::expected<std::span<const std::byte>, error> peek(size_t bytes) override;
+
+    // Start reading the range into the page cache with POSIX_FADV_WILLNEED
+    void will_need(uint64_t offset, uint64_t length) override;
+
+    [[nodiscard]] size_t window_size() const noexcept { return window_size_; }
 
 private:
-    mmap_stream(void* ptr, size_t size);
+    windowed_mmap_stream(int fd, uint64_t file_size, size_t window_size);
+};
+#endif
+
+// Base interface for writing data streams
+class output_stream {
+public:
+    virtual ~output_stream() = default;
+
+    // Write all of data, short writes are retried internally
+    [[nodiscard]] virtual std::expected<void, error> write(std::span<const std::byte> data) = 0;
+
+    // Push any data held by the stream to its destination
+    [[nodiscard]] virtual std::expected<void, error> flush() { return {}; }
+
+    // Append length bytes of the open file fd, starting at offset, without
+    // passing them through userspace. Returns false, having written nothing,
+    // when the stream cannot do this and the caller must copy the data itself
+    [[nodiscard]] virtual std::expected<bool, error> copy_from_file(int /*fd*/, uint64_t /*offset*/, uint64_t /*length*/) {
+        return false;
+    }
+};
+
+// Appends to a caller-owned byte vector
+class memory_output_stream : public output_stream {
+private:
+    std::vector<std::byte>* target_;
+
+public:
+    explicit memory_output_stream(std::vector<std::byte>& target)
+        : target_(&target) {}
+
+    [[nodiscard]] std::expected<void, error> write(std::span<const std::byte> data) override {
+        target_->insert(target_->end(), data.begin(), data.end());
+        return {};
+    }
+};
+
+// File-based output stream
+// Unbuffered, callers are expected to write in large blocks
+class file_output_stream : public output_stream {
+private:
+    struct file_deleter {
+        void operator()(std::FILE* f) const {
+            if (f) std::fclose(f);
+        }
+    };
+
+    std::unique_ptr<std::FILE, file_deleter> file_;
+
+public:
+    // Create or truncate the file at path
+    [[nodiscard]] static std::expected<file_output_stream, error> create(const std::filesystem::path& path);
+
+    // Open an existing file to write at offset, cutting off everything after it
+    [[nodiscard]] static std::expected<file_output_stream, error> open_at(
+        const std::filesystem::path& path, uint64_t offset);
+
+    [[nodiscard]] std::expected<void, error> write(std::span<const std::byte> data) override;
+    [[nodiscard]] std::expected<void, error> flush() override;
+
+private:
+    explicit file_output_stream(std::FILE* file);
+};
+
+#ifdef __linux__
+// File descriptor output stream (Linux-specific)
+// copy_from_file() moves data inside the kernel with copy_file_range(), which
+// can share extents on reflink filesystems, and falls back to sendfile() for
+// outputs such as pipes and sockets
+class fd_output_stream : public output_stream {
+private:
+    int fd_ = -1;
+    bool owns_fd_ = false;
+    bool copy_file_range_usable_ = true;
+    bool sendfile_usable_ = true;
+
+    fd_output_stream(int fd, bool owns_fd);
+
+public:
+    // Create or truncate the file at path
+    [[nodiscard]] static std::expected<fd_output_stream, error> create(const std::filesystem::path& path);
+
+    // Open an existing file to write at offset, cutting off everything after it
+    [[nodiscard]] static std::expected<fd_output_stream, error> open_at(
+        const std::filesystem::path& path, uint64_t offset);
+
+    // Write to a descriptor owned by the caller, such as a pipe or socket
+    [[nodiscard]] static fd_output_stream borrow(int fd) { return fd_output_stream{fd, false}; }
+
+    fd_output_stream(fd_output_stream&& other) noexcept;
+    fd_output_stream& operator=(fd_output_stream&& other) noexcept;
+    fd_output_stream(const fd_output_stream&) = delete;
+    fd_output_stream& operator=(const fd_output_stream&) = delete;
+    ~fd_output_stream() override;
+
+    [[nodiscard]] std::expected<void, error> write(std::span<const std::byte> data) override;
+    [[nodiscard]] std::expected<bool, error> copy_from_file(int fd, uint64_t offset, uint64_t length) override;
 };
 #endif
 
@@ -19,14 +19,39 @@
 #include <tierone/tar/error.hpp>
 #include <tierone/tar/metadata.hpp>
 #include <tierone/tar/stream.hpp>
+#include <tierone/tar/push_stream.hpp>
+#include <tierone/tar/decompress.hpp>
+#include <tierone/tar/probe.hpp>
 #include <tierone/tar/archive_reader.hpp>
+#include <tierone/tar/reader_stats.hpp>
+#include <tierone/tar/async.hpp>
+#include <tierone/tar/async_archive_reader.hpp>
+#include <tierone/tar/archive_writer.hpp>
 #include <tierone/tar/archive_entry.hpp>
+#include <tierone/tar/entry_view.hpp>
+#include <tierone/tar/path_filter.hpp>
+#include <tierone/tar/listing.hpp>
+#include <tierone/tar/archive_index.hpp>
+#include <tierone/tar/archive_fs.hpp>
+#include <tierone/tar/shared_archive.hpp>
+#include <tierone/tar/index_sidecar.hpp>
 #include <tierone/tar/gnu_tar.hpp>
+#include <tierone/tar/extract.hpp>
+#include <tierone/tar/copy.hpp>
+#include <tierone/tar/digest.hpp>
+#include <tierone/tar/multi_volume.hpp>
+#include <tierone/tar/parallel_scan.hpp>
+#include <tierone/tar/batch.hpp>
+#include <tierone/tar/transcode.hpp>
 
 namespace tierone::tar {
 
 // Main convenience API
-[[nodiscard]] std::expected<archive_reader, error> open_archive(const std::filesystem::path& path);
+// gzip, zstd and xz archives are detected by their magic and decompressed
+// transparently, provided the codec was built in and the stream can peek
+[[nodiscard]] std::expected<archive_reader, error> open_archive(
+    const std::filesystem::path& path,
+    access_mode mode = access_mode::streaming);
 [[nodiscard]] std::expected<archive_reader, error> open_archive(std::unique_ptr<input_stream> stream);
 
 } // namespace tierone::tar
\ No newline at end of file
@@ -0,0 +1,72 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <tierone/tar/archive_reader.hpp>
+#include <tierone/tar/archive_writer.hpp>
+#include <tierone/tar/error.hpp>
+#include <tierone/tar/metadata.hpp>
+#include <cstdint>
+#include <expected>
+#include <filesystem>
+#include <functional>
+
+namespace tierone::tar {
+
+enum class member_action {
+    keep,
+    drop
+};
+
+// Called with each member's metadata, which it may change in place
+// Paths, link targets, owners, permissions, times, extended attributes and
+// ACLs can all be rewritten. The data is copied as stored, so the type
+// must keep or lack data as before and the size and sparse map must stay.
+// Dropping the target of a hard link leaves the link dangling.
+using member_rewriter = std::function<std::expected<member_action, error>(file_metadata& metadata)>;
+
+struct transcode_stats {
+    uint64_t members = 0;     // Members read
+    uint64_t dropped = 0;     // Of those, not written
+    uint64_t data_bytes = 0;  // Stored data copied, excluding headers and padding
+};
+
+// Copy the members of one archive into another, rewriting only their headers
+// Every member is written by writer from its metadata after rewrite has
+// seen it, and its stored data follows unchanged: never decompressed from a
+// sparse map, never held whole in memory. Sparse members stay sparse as
+// GNU sparse 1.0. Global PAX values are folded into each member's headers
+// and volume labels are dropped. finish() is left to the caller.
+[[nodiscard]] std::expected<transcode_stats, error> transcode(
+    archive_reader& reader,
+    archive_writer& writer,
+    const member_rewriter& rewrite
+);
+
+// Same from one uncompressed archive file to another, which is created or
+// truncated and finished
+// On Linux member data goes from file to file inside the kernel, with
+// copy_file_range() or sendfile(), and dropped members are seeked past,
+// so filtering runs at the speed of a plain file copy.
+[[nodiscard]] std::expected<transcode_stats, error> transcode(
+    const std::filesystem::path& input,
+    const std::filesystem::path& output,
+    const member_rewriter& rewrite,
+    const writer_options& options = {}
+);
+
+} // namespace tierone::tar
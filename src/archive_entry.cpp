@@ -15,11 +15,329 @@
  */
 
 #include <tierone/tar/archive_entry.hpp>
+#include <tierone/tar/sparse_reader.hpp>
+#include <tierone/tar/stream.hpp>
 #include <fstream>
 #include <filesystem>
+#include <vector>
 
 namespace tierone::tar {
 
+auto archive_data_source::read(
+    const size_t offset,
+    const std::span<std::byte> buffer) const -> std::expected<size_t, error> {
+    if (offset >= stored_size_) {
+        return size_t{0};
+    }
+
+    // Mapped archives copy straight out of the mapping
+    if (!stream_) {
+        const size_t to_copy = std::min(buffer.size(), mapped_.size() - offset);
+        std::ranges::copy_n(mapped_.begin() + static_cast<std::ptrdiff_t>(offset),
+                           static_cast<std::ptrdiff_t>(to_copy), buffer.begin());
+        digest(offset, buffer.first(to_copy));
+        return to_copy;
+    }
+
+    // The reader's position bookkeeping belongs to its current entry alone
+    if (current_entry_ && *current_entry_ != entry_number_) {
+        return std::unexpected(error{error_code::invalid_operation,
+            "Entry data is no longer available, the reader has moved past the entry"});
+    }
+
+    // Counted against the owning reader when it keeps stats
+    reader_stats unowned;
+    auto& stats = stats_ ? *stats_ : unowned;
+    const detail::phase_timer timer{stats.data_time};
+
+    if (offset != *consumed_) {
+        if (seekable_) {
+            // Random access streams can jump anywhere inside the entry
+            stats.record_seek();
+            if (auto seek_result = seekable_->seek(data_start_ + offset); !seek_result) {
+                return std::unexpected(seek_result.error());
+            }
+        } else if (offset > *consumed_) {
+            // Plain streams can still skip forward over the gap
+            stats.record_skip(offset - *consumed_);
+            if (auto skip_result = stream_->skip(offset - *consumed_); !skip_result) {
+                return std::unexpected(skip_result.error());
+            }
+        } else {
+            return std::unexpected(error{error_code::invalid_operation, 
+                "Cannot seek backwards in streaming mode"});
+        }
+        *consumed_ = offset;
+        *remaining_ = stored_size_ - offset;
+    }
+
+    const auto to_read = static_cast<size_t>(std::min<uint64_t>(buffer.size(), *remaining_));
+    if (to_read == 0) {
+        return size_t{0};
+    }
+
+    // Read straight into the caller's buffer
+    auto result = stream_->read(buffer.first(to_read));
+    if (!result) {
+        return std::unexpected(result.error());
+    }
+    stats.record_read(*result);
+    digest(offset, buffer.first(*result));
+
+    *remaining_ -= *result;
+    *consumed_ += *result;
+    return *result;
+}
+
+auto archive_entry::read_chunked(
+    const size_t offset,
+    const size_t length) const -> std::expected<std::span<const std::byte>, error> {
+    // Owned by the entry, so repeated reads reuse the same allocation
+    auto& buffer = chunk_buffer_;
+    buffer.resize(length);
+
+    size_t filled = 0;
+    while (filled < length) {
+        auto result = read_into(offset + filled, std::span{buffer.data() + filled, length - filled});
+        if (!result) {
+            return std::unexpected(result.error());
+        }
+        if (*result == 0) {
+            break;
+        }
+        filled += *result;
+    }
+
+    return std::span<const std::byte>{buffer.data(), filled};
+}
+
+auto archive_entry::read_into(
+    const size_t offset,
+    const std::span<std::byte> buffer) const -> std::expected<size_t, error> {
+    if (!is_regular_file()) {
+        return std::unexpected(error{error_code::invalid_operation, "Entry is not a regular file"});
+    }
+
+    // Never read past the end of the entry
+    const uint64_t entry_size = size();
+    if (offset >= entry_size || buffer.empty()) {
+        return size_t{0};
+    }
+    const auto chunk = buffer.first(static_cast<size_t>(
+        std::min<uint64_t>(buffer.size(), entry_size - offset)));
+
+    return std::visit([&](const auto& source) -> std::expected<size_t, error> {
+        using T = std::decay_t<decltype(source)>;
+        if constexpr (std::is_same_v<T, std::span<const std::byte>>) {
+            // Memory-mapped mode, copy straight out of the mapping
+            const size_t start_offset = std::min(offset, source.size());
+            const size_t to_copy = std::min(chunk.size(), source.size() - start_offset);
+            std::ranges::copy_n(source.begin() + static_cast<std::ptrdiff_t>(start_offset),
+                               static_cast<std::ptrdiff_t>(to_copy), chunk.begin());
+            return to_copy;
+        } else if constexpr (std::is_same_v<T, data_read_into_fn>) {
+            // Chunked streaming mode reads directly into the caller's buffer
+            return source(offset, chunk);
+        } else if constexpr (std::is_same_v<T, archive_data_source>) {
+            // Direct call for plain entries, holes filled in for sparse ones
+            if (metadata_.sparse_info) {
+                return sparse::read_expanded(*metadata_.sparse_info, cursor_, offset, chunk,
+                    [&source](const size_t stored_offset, std::span<std::byte> out) {
+                        return source.read(stored_offset, out);
+                    });
+            }
+            return source.read(offset, chunk);
+        } else {
+            // Span-returning reader, bounded by the chunk size
+            auto data = source(offset, chunk.size());
+            if (!data) {
+                return std::unexpected(data.error());
+            }
+            const size_t to_copy = std::min(chunk.size(), data->size());
+            std::ranges::copy_n(data->begin(), static_cast<std::ptrdiff_t>(to_copy), chunk.begin());
+            return to_copy;
+        }
+    }, data_source_);
+}
+
+auto archive_entry::is_mapped() const noexcept -> bool {
+    if (stored_data_) {
+        return true;
+    }
+    return std::visit([](const auto& source) {
+        using T = std::decay_t<decltype(source)>;
+        if constexpr (std::is_same_v<T, std::span<const std::byte>>) {
+            return true;
+        } else if constexpr (std::is_same_v<T, archive_data_source>) {
+            return source.mapped().has_value();
+        } else {
+            return false;
+        }
+    }, data_source_);
+}
+
+auto archive_entry::digests() const noexcept -> std::optional<entry_digests> {
+    if (const auto* source = std::get_if<archive_data_source>(&data_source_)) {
+        return source->digests();
+    }
+    return std::nullopt;
+}
+
+auto archive_entry::open_reader() const -> std::expected<entry_reader, error> {
+    if (!is_regular_file()) {
+        return std::unexpected(error{error_code::invalid_operation, "Entry is not a regular file"});
+    }
+    return entry_reader{*this};
+}
+
+auto archive_entry::open_sparse_runs() const -> std::expected<sparse_run_reader, error> {
+    if (!is_regular_file()) {
+        return std::unexpected(error{error_code::invalid_operation, "Entry is not a regular file"});
+    }
+    return sparse_run_reader{*this};
+}
+
+auto sparse_run_reader::segments() const noexcept -> std::span<const sparse::sparse_entry> {
+    if (const auto& sparse_info = entry_->metadata_.sparse_info) {
+        return sparse_info->segments;
+    }
+    return {&whole_file_, whole_file_.size > 0 ? size_t{1} : size_t{0}};
+}
+
+auto sparse_run_reader::stored_data() const noexcept -> std::optional<std::span<const std::byte>> {
+    if (entry_->stored_data_) {
+        return entry_->stored_data_;
+    }
+    if (!entry_->metadata_.sparse_info) {
+        if (const auto* mapped = std::get_if<std::span<const std::byte>>(&entry_->data_source_)) {
+            return *mapped;
+        }
+        if (const auto* source = std::get_if<archive_data_source>(&entry_->data_source_)) {
+            return source->mapped();
+        }
+    }
+    return std::nullopt;
+}
+
+auto sparse_run_reader::read_segment_data(const uint64_t length) -> std::expected<std::span<const std::byte>, error> {
+    // Mapped data is handed out in place
+    if (const auto stored = stored_data()) {
+        if (stored_offset_ > stored->size() || length > stored->size() - stored_offset_) {
+            return std::unexpected(error{error_code::corrupt_archive,
+                "Sparse segment extends beyond stored data"});
+        }
+        const auto data = stored->subspan(static_cast<size_t>(stored_offset_), static_cast<size_t>(length));
+        if (const auto* source = std::get_if<archive_data_source>(&entry_->data_source_)) {
+            source->digest(static_cast<size_t>(stored_offset_), data);
+        }
+        return data;
+    }
+
+    if (buffer_.empty()) {
+        buffer_.resize(static_cast<size_t>(std::min<uint64_t>(
+            std::max<uint64_t>(length, 1), default_chunk_size)));
+    }
+    const auto chunk = std::span{buffer_}.first(static_cast<size_t>(std::min<uint64_t>(length, buffer_.size())));
+    auto result = entry_->read_into(static_cast<size_t>(position_), chunk);
+    if (!result) {
+        return std::unexpected(result.error());
+    }
+    if (*result == 0) {
+        return std::unexpected(error{error_code::corrupt_archive,
+            "Unexpected end of sparse file data"});
+    }
+    return std::span<const std::byte>{buffer_.data(), *result};
+}
+
+auto sparse_run_reader::next_run() -> std::expected<std::optional<sparse_run>, error> {
+    const auto segs = segments();
+    const uint64_t end = entry_->size();
+
+    // Zero-length segments only mark the file size
+    while (segment_ < segs.size() && segs[segment_].size == 0) {
+        ++segment_;
+    }
+
+    if (position_ >= end) {
+        return std::nullopt;
+    }
+
+    // Hole up to the next data segment, or up to the end of the file
+    const uint64_t next_data = segment_ < segs.size() ? std::min(segs[segment_].offset, end) : end;
+    if (position_ < next_data) {
+        sparse_run run{position_, next_data - position_, {}, true};
+        position_ = next_data;
+        return run;
+    }
+
+    const auto& segment = segs[segment_];
+    const uint64_t remaining = std::min(segment.size - segment_consumed_, end - position_);
+    auto data = read_segment_data(remaining);
+    if (!data) {
+        return std::unexpected(data.error());
+    }
+
+    sparse_run run{position_, data->size(), *data, false};
+    position_ += data->size();
+    stored_offset_ += data->size();
+    segment_consumed_ += data->size();
+    if (segment_consumed_ >= segment.size) {
+        ++segment_;
+        segment_consumed_ = 0;
+    }
+    return run;
+}
+
+auto archive_entry::write_sparse_file(
+    std::ofstream &file,
+    const std::filesystem::path &dest_path) const -> std::expected<void, error> {
+    // Only the data segments are written, at their offsets. The file starts
+    // empty, so the gaps between them stay unallocated holes
+    const auto& sparse_info = *metadata_.sparse_info;
+    std::vector<std::byte> buffer(static_cast<size_t>(std::min<uint64_t>(
+        std::max<uint64_t>(sparse_info.total_data_size(), 1), default_chunk_size)));
+    
+    for (const auto& [offset, length] : sparse_info.segments) {
+        if (length == 0) {
+            continue;
+        }
+        file.seekp(static_cast<std::streamoff>(offset));
+        
+        uint64_t written = 0;
+        while (written < length) {
+            const auto chunk_size = static_cast<size_t>(std::min<uint64_t>(length - written, buffer.size()));
+            auto chunk = read_into(static_cast<size_t>(offset + written), std::span{buffer}.first(chunk_size));
+            if (!chunk) {
+                return std::unexpected(chunk.error());
+            }
+            if (*chunk == 0) {
+                return std::unexpected(error{error_code::corrupt_archive, 
+                    "Unexpected end of sparse file data"});
+            }
+            
+            file.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(*chunk));
+            if (!file) {
+                return std::unexpected(error{error_code::io_error, "Failed to write file data"});
+            }
+            written += *chunk;
+        }
+    }
+    
+    file.close();
+    if (!file) {
+        return std::unexpected(error{error_code::io_error, "Failed to write file data"});
+    }
+    
+    // Extend to the full size, a trailing hole is never written either
+    std::error_code ec;
+    std::filesystem::resize_file(dest_path, sparse_info.real_size, ec);
+    if (ec) {
+        return std::unexpected(error{error_code::io_error, 
+            "Failed to set sparse file size: " + ec.message()});
+    }
+    return {};
+}
+
 auto archive_entry::extract_to_path(const std::filesystem::path &dest_path) const -> std::expected<void, error> {
     // Create parent directories if they don't exist
     std::error_code ec;
@@ -40,17 +358,36 @@ auto archive_entry::extract_to_path(const std::filesystem::path &dest_path) cons
                     "Failed to create output file: " + dest_path.string()});
             }
             
-            auto data = read_data();
-            if (!data) {
-                return std::unexpected(data.error());
+            if (metadata_.sparse_info) {
+                if (auto result = write_sparse_file(file, dest_path); !result) {
+                    return result;
+                }
+                break;
             }
             
-            file.write(reinterpret_cast<const char*>(data->data()), 
-                      static_cast<std::streamsize>(data->size()));
+            auto reader = open_reader();
+            if (!reader) {
+                return std::unexpected(reader.error());
+            }
             
-            if (!file) {
-                return std::unexpected(error{error_code::io_error, 
-                    "Failed to write file data"});
+            // Copy one chunk at a time so memory stays bounded for large entries
+            std::vector<std::byte> buffer(static_cast<size_t>(std::min<uint64_t>(size(), default_chunk_size)));
+            while (!buffer.empty()) {
+                auto chunk = reader->read_some(buffer);
+                if (!chunk) {
+                    return std::unexpected(chunk.error());
+                }
+                if (*chunk == 0) {
+                    break;
+                }
+                
+                file.write(reinterpret_cast<const char*>(buffer.data()), 
+                          static_cast<std::streamsize>(*chunk));
+                
+                if (!file) {
+                    return std::unexpected(error{error_code::io_error, 
+                        "Failed to write file data"});
+                }
             }
             break;
         }
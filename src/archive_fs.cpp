@@ -0,0 +1,391 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <tierone/tar/archive_fs.hpp>
+#include <tierone/tar/archive_reader.hpp>
+#include <tierone/tar/decompress.hpp>
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstring>
+#include <limits>
+
+namespace tierone::tar {
+
+namespace {
+
+// Archive or caller path as '/'-separated components
+// Leading '/', empty and "." components are dropped, as extraction does.
+auto normalize(const std::string_view path) -> std::string {
+    std::string result;
+    result.reserve(path.size());
+    size_t start = 0;
+    while (start <= path.size()) {
+        size_t end = path.find('/', start);
+        if (end == std::string_view::npos) {
+            end = path.size();
+        }
+        const auto component = path.substr(start, end - start);
+        if (!component.empty() && component != ".") {
+            if (!result.empty()) {
+                result += '/';
+            }
+            result += component;
+        }
+        start = end + 1;
+    }
+    return result;
+}
+
+auto parent_of(const std::string& path) -> std::string {
+    const size_t slash = path.rfind('/');
+    return slash == std::string::npos ? std::string{} : path.substr(0, slash);
+}
+
+auto not_found() -> error {
+    return error{error_code::invalid_operation, "No such file or directory", ENOENT};
+}
+
+} // anonymous namespace
+
+block_cache::block_cache(std::unique_ptr<random_access_stream> stream, const block_cache_options& options)
+    : stream_(std::move(stream)),
+      mapped_(stream_->mapped_data()),
+      size_(stream_->size().value_or(std::numeric_limits<uint64_t>::max())),
+      block_size_(std::max<size_t>(options.block_size, 512)) {
+    const size_t shard_count = std::max<size_t>(options.shards, 1);
+    blocks_per_shard_ = std::max<size_t>(options.capacity / block_size_ / shard_count, 1);
+    shards_.reserve(shard_count);
+    for (size_t i = 0; i < shard_count; ++i) {
+        shards_.push_back(std::make_unique<shard>());
+    }
+}
+
+auto block_cache::fetch(const uint64_t number) -> std::expected<block, error> {
+    auto& part = *shards_[number % shards_.size()];
+    {
+        std::lock_guard lock{part.mutex};
+        if (const auto found = part.blocks.find(number); found != part.blocks.end()) {
+            part.lru.splice(part.lru.begin(), part.lru, found->second);
+            hits_.fetch_add(1, std::memory_order_relaxed);
+            return found->second->second;
+        }
+    }
+    misses_.fetch_add(1, std::memory_order_relaxed);
+
+    // Read without holding the shard, hits on its other blocks go on meanwhile
+    auto data = std::make_shared<std::vector<std::byte>>(block_size_);
+    size_t filled = 0;
+    {
+        std::lock_guard lock{stream_mutex_};
+        if (auto seeked = stream_->seek(number * block_size_); !seeked) {
+            return std::unexpected(seeked.error());
+        }
+        while (filled < data->size()) {
+            auto got = stream_->read(std::span{*data}.subspan(filled));
+            if (!got) {
+                return std::unexpected(got.error());
+            }
+            if (*got == 0) {
+                break;
+            }
+            filled += *got;
+        }
+    }
+    data->resize(filled);
+
+    std::lock_guard lock{part.mutex};
+    if (const auto found = part.blocks.find(number); found != part.blocks.end()) {
+        return found->second->second;  // Another reader missed on it too
+    }
+    part.lru.emplace_front(number, std::move(data));
+    part.blocks.emplace(number, part.lru.begin());
+    while (part.lru.size() > blocks_per_shard_) {
+        part.blocks.erase(part.lru.back().first);
+        part.lru.pop_back();
+    }
+    return part.lru.front().second;
+}
+
+auto block_cache::read(const uint64_t offset, const std::span<std::byte> buffer) -> std::expected<size_t, error> {
+    if (mapped_) {
+        if (offset >= mapped_->size()) {
+            return size_t{0};
+        }
+        const auto available = mapped_->subspan(static_cast<size_t>(offset));
+        const size_t length = std::min(buffer.size(), available.size());
+        std::memcpy(buffer.data(), available.data(), length);
+        return length;
+    }
+
+    size_t copied = 0;
+    while (copied < buffer.size() && offset + copied < size_) {
+        const uint64_t position = offset + copied;
+        const uint64_t number = position / block_size_;
+        auto data = fetch(number);
+        if (!data) {
+            return std::unexpected(data.error());
+        }
+        const auto within = static_cast<size_t>(position - number * block_size_);
+        if (within >= (*data)->size()) {
+            break;
+        }
+        const size_t length = std::min(buffer.size() - copied, (*data)->size() - within);
+        std::memcpy(buffer.data() + copied, (*data)->data() + within, length);
+        copied += length;
+        if ((*data)->size() < block_size_) {
+            break;  // The last block of the stream
+        }
+    }
+    return copied;
+}
+
+auto archive_fs::directory_node(const std::string& path) -> size_t {
+    if (const auto found = by_path_.find(path); found != by_path_.end()) {
+        return found->second;
+    }
+    const size_t parent = directory_node(parent_of(path));
+    const size_t number = nodes_.size();
+    node implied;
+    implied.metadata.path = path;
+    implied.metadata.type = entry_type::directory;
+    implied.metadata.permissions = std::filesystem::perms{0755};
+    implied.name = path.substr(path.rfind('/') == std::string::npos ? 0 : path.rfind('/') + 1);
+    nodes_.push_back(std::move(implied));
+    nodes_[parent].children.push_back(number);
+    by_path_.emplace(path, number);
+    return number;
+}
+
+auto archive_fs::open(
+    const archive_index& index,
+    std::unique_ptr<random_access_stream> stream,
+    const block_cache_options& options) -> std::expected<archive_fs, error> {
+    archive_fs fs;
+    node root;
+    root.metadata.type = entry_type::directory;
+    root.metadata.permissions = std::filesystem::perms{0755};
+    fs.nodes_.push_back(std::move(root));
+    fs.by_path_.emplace(std::string{}, 0);
+
+    std::vector<size_t> hard_links;
+    for (const auto& record : index.records()) {
+        auto path = normalize(record.metadata.path.generic_string());
+        size_t number = 0;
+        if (!path.empty()) {
+            const size_t parent = fs.directory_node(parent_of(path));
+            const auto [found, inserted] = fs.by_path_.try_emplace(path, fs.nodes_.size());
+            number = found->second;
+            if (inserted) {
+                node added;
+                added.name = path.substr(path.rfind('/') == std::string::npos ? 0 : path.rfind('/') + 1);
+                fs.nodes_.push_back(std::move(added));
+                fs.nodes_[parent].children.push_back(number);
+            }
+        }
+
+        // A later member with the same path replaces the earlier one
+        auto& entry = fs.nodes_[number];
+        entry.metadata = record.metadata;
+        entry.metadata.path = std::move(path);
+        entry.location = record.location;
+        if (entry.metadata.sparse_info) {
+            entry.metadata.sparse_info->index_segments();
+        }
+        if (entry.metadata.type == entry_type::hard_link) {
+            hard_links.push_back(number);
+        }
+    }
+
+    for (auto& entry : fs.nodes_) {
+        std::ranges::sort(entry.children, {}, [&fs](const size_t child) -> std::string_view {
+            return fs.nodes_[child].name;
+        });
+    }
+
+    // Hard links take on their target, in archive order so chains resolve
+    for (const size_t number : hard_links) {
+        auto& link = fs.nodes_[number];
+        if (link.metadata.type != entry_type::hard_link || !link.metadata.link_target) {
+            continue;
+        }
+        const auto target = fs.by_path_.find(normalize(*link.metadata.link_target));
+        if (target == fs.by_path_.end() || target->second == number) {
+            continue;  // Left as a dangling hard link
+        }
+        const auto& source = fs.nodes_[target->second];
+        auto path = std::move(link.metadata.path);
+        link.metadata = source.metadata;
+        link.metadata.path = std::move(path);
+        link.location = source.location;
+    }
+
+    fs.cache_ = std::make_unique<block_cache>(std::move(stream), options);
+    return fs;
+}
+
+auto archive_fs::open(
+    const std::filesystem::path& path, const block_cache_options& options) -> std::expected<archive_fs, error> {
+    auto reader = archive_reader::from_file(path);
+    if (!reader) {
+        return std::unexpected(reader.error());
+    }
+    auto index = archive_index::build(*reader);
+    if (!index) {
+        return std::unexpected(index.error());
+    }
+
+#ifdef __linux__
+    // Cache misses read whole blocks, a read buffer of its own would only copy
+    auto file = fd_stream::open(path, fd_stream::buffer_alignment);
+#else
+    auto file = file_stream::open(path);
+#endif
+    if (!file) {
+        return std::unexpected(file.error());
+    }
+    std::array<std::byte, compression_magic_size> head{};
+    size_t filled = 0;
+    while (filled < head.size()) {
+        auto got = file->read(std::span{head}.subspan(filled));
+        if (!got) {
+            return std::unexpected(got.error());
+        }
+        if (*got == 0) {
+            break;
+        }
+        filled += *got;
+    }
+    if (detect_compression(std::span{head}.first(filled)) == compression_format::none) {
+        if (auto rewound = file->seek(0); !rewound) {
+            return std::unexpected(rewound.error());
+        }
+#ifdef __linux__
+        return open(*index, std::make_unique<fd_stream>(std::move(*file)), options);
+#else
+        return open(*index, std::make_unique<file_stream>(std::move(*file)), options);
+#endif
+    }
+
+    // Index offsets count decompressed bytes, so the cache reads through the
+    // reader's own decompressing stream, which has to be seekable
+    auto decompressed = reader->reset(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{}));
+    auto* seekable = dynamic_cast<random_access_stream*>(decompressed.get());
+    if (!seekable) {
+        return std::unexpected(error{error_code::unsupported_feature,
+            "Compressed archives need a seekable format, such as BGZF or seekable zstd"});
+    }
+    decompressed.release();
+    return open(*index, std::unique_ptr<random_access_stream>{seekable}, options);
+}
+
+auto archive_fs::lookup(const std::string_view path) const -> std::expected<const node*, error> {
+    const auto found = by_path_.find(normalize(path));
+    if (found == by_path_.end()) {
+        return std::unexpected(not_found());
+    }
+    return &nodes_[found->second];
+}
+
+auto archive_fs::stat(const std::string_view path) const -> std::expected<const file_metadata*, error> {
+    auto found = lookup(path);
+    if (!found) {
+        return std::unexpected(found.error());
+    }
+    return &(*found)->metadata;
+}
+
+auto archive_fs::readdir(const std::string_view path) const -> std::expected<std::vector<fs_dir_entry>, error> {
+    auto found = lookup(path);
+    if (!found) {
+        return std::unexpected(found.error());
+    }
+    if (!(*found)->metadata.is_directory()) {
+        return std::unexpected(error{error_code::invalid_operation, "Not a directory", ENOTDIR});
+    }
+    std::vector<fs_dir_entry> entries;
+    entries.reserve((*found)->children.size());
+    for (const size_t child : (*found)->children) {
+        entries.push_back({nodes_[child].name, nodes_[child].metadata.type});
+    }
+    return entries;
+}
+
+auto archive_fs::read(
+    const std::string_view path,
+    const uint64_t offset,
+    const std::span<std::byte> buffer) const -> std::expected<size_t, error> {
+    auto found = lookup(path);
+    if (!found) {
+        return std::unexpected(found.error());
+    }
+    const auto& file = **found;
+    if (file.metadata.is_directory()) {
+        return std::unexpected(error{error_code::invalid_operation, "Is a directory", EISDIR});
+    }
+    if (!file.metadata.is_regular_file()) {
+        return std::unexpected(error{error_code::invalid_operation, "Not a regular file", EINVAL});
+    }
+    if (offset >= file.metadata.size) {
+        return size_t{0};
+    }
+    const auto length = static_cast<size_t>(std::min<uint64_t>(buffer.size(), file.metadata.size - offset));
+
+    const auto read_stored = [&](const uint64_t stored, const std::span<std::byte> into) -> std::expected<void, error> {
+        auto got = cache_->read(file.location.data_offset + stored, into);
+        if (!got) {
+            return std::unexpected(got.error());
+        }
+        if (*got != into.size()) {
+            return std::unexpected(error{error_code::corrupt_archive, "Unexpected end of archive data"});
+        }
+        return {};
+    };
+
+    if (!file.metadata.sparse_info) {
+        if (auto result = read_stored(offset, buffer.first(length)); !result) {
+            return std::unexpected(result.error());
+        }
+        return length;
+    }
+
+    // Sparse files: data runs come from the stored segments, holes are zeros
+    const auto& info = *file.metadata.sparse_info;
+    uint64_t position = offset;
+    const uint64_t end = offset + length;
+    const auto part = [&](const uint64_t until) {
+        return buffer.subspan(static_cast<size_t>(position - offset), static_cast<size_t>(until - position));
+    };
+    for (size_t i = info.lower_segment(position); position < end; ++i) {
+        if (i >= info.segments.size() || position < info.segments[i].offset) {
+            const uint64_t hole_end = i < info.segments.size() ? std::min(end, info.segments[i].offset) : end;
+            std::ranges::fill(part(hole_end), std::byte{0});
+            position = hole_end;
+            if (position == end) {
+                break;
+            }
+        }
+        const auto& segment = info.segments[i];
+        const uint64_t run_end = std::min(end, segment.offset + segment.size);
+        if (auto result = read_stored(info.data_offset_of(i) + (position - segment.offset), part(run_end)); !result) {
+            return std::unexpected(result.error());
+        }
+        position = run_end;
+    }
+    return length;
+}
+
+} // namespace tierone::tar
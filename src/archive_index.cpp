@@ -0,0 +1,88 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <tierone/tar/archive_index.hpp>
+#include <tierone/tar/header_parser.hpp>
+#include <algorithm>
+#include <numeric>
+
+namespace tierone::tar {
+
+archive_index::archive_index(std::vector<index_record> records)
+    : records_(std::move(records)) {
+    sort_paths();
+}
+
+void archive_index::sort_paths() {
+    by_path_.resize(records_.size());
+    std::iota(by_path_.begin(), by_path_.end(), size_t{0});
+    
+    // Stable, so equal paths keep archive order and the last member sorts last
+    std::ranges::stable_sort(by_path_, {}, [this](const size_t i) -> std::string_view {
+        return records_[i].metadata.path.native();
+    });
+}
+
+auto archive_index::build(archive_reader &reader) -> std::expected<archive_index, error> {
+    std::vector<index_record> records;
+    
+    while (true) {
+        auto entry = reader.next_entry();
+        if (!entry) {
+            return std::unexpected(entry.error());
+        }
+        if (!*entry) {
+            break;
+        }
+        
+        const auto& location = reader.current_location();
+        if (!location) {
+            return std::unexpected(error{error_code::unsupported_feature, 
+                "Index building requires a random access stream"});
+        }
+        
+        records.push_back(index_record{(*entry)->metadata(), *location});
+    }
+    
+    return archive_index{std::move(records)};
+}
+
+auto archive_index::find(const std::string_view path) const -> const index_record* {
+    const auto key = [this](const size_t i) -> std::string_view {
+        return records_[i].metadata.path.native();
+    };
+    
+    const auto it = std::ranges::upper_bound(by_path_, path, {}, key);
+    if (it == by_path_.begin() || key(*std::prev(it)) != path) {
+        return nullptr;
+    }
+    return &records_[*std::prev(it)];
+}
+
+auto archive_index::end_offset() const noexcept -> uint64_t {
+    if (records_.empty()) {
+        return 0;
+    }
+    const auto& last = records_.back().location;
+    return last.data_offset + (last.stored_size + detail::BLOCK_SIZE - 1) / detail::BLOCK_SIZE * detail::BLOCK_SIZE;
+}
+
+auto archive_index::supersedes(const file_metadata& meta) const -> bool {
+    const auto* existing = find(meta.path.native());
+    return !existing || meta.modification_time > existing->metadata.modification_time;
+}
+
+} // namespace tierone::tar
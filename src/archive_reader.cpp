@@ -15,22 +15,69 @@
  */
 
 #include <tierone/tar/archive_reader.hpp>
+#include <tierone/tar/archive_index.hpp>
 #include <tierone/tar/stream.hpp>
 #include <tierone/tar/sparse.hpp>
-#include <tierone/tar/sparse_reader.hpp>
 #include <tierone/tar/pax_parser.hpp>
+#include <tierone/tar/decompress.hpp>
 #include <algorithm>
 #include <charconv>
 
 namespace tierone::tar {
 
-auto archive_reader::from_file(const std::filesystem::path &path) -> std::expected<archive_reader, error> {
-    auto stream = file_stream::open(path);
+namespace {
+
+// Headers that carry data for the entry after them rather than an entry
+auto is_extension_type(const entry_type type) noexcept -> bool {
+    return type == entry_type::gnu_longname || type == entry_type::gnu_longlink ||
+           type == entry_type::gnu_volhdr || type == entry_type::gnu_multivol ||
+           type == entry_type::pax_extended_header || type == entry_type::pax_global_header;
+}
+
+} // anonymous namespace
+
+auto archive_reader::from_file(
+    const std::filesystem::path &path,
+    const access_mode mode) -> std::expected<archive_reader, error> {
+    std::unique_ptr<input_stream> stream;
+#ifdef __linux__
+    if (mode == access_mode::mapped) {
+        auto mapped = mmap_stream::create(path);
+        if (!mapped) {
+            return std::unexpected(mapped.error());
+        }
+        stream = std::make_unique<mmap_stream>(std::move(*mapped));
+    } else if (mode == access_mode::prefetch) {
+        if (auto prefetched = uring_stream::open(path)) {
+            stream = std::make_unique<uring_stream>(std::move(*prefetched));
+        } else if (prefetched.error().code() != error_code::unsupported_feature) {
+            return std::unexpected(prefetched.error());
+        }
+    }
+    if (!stream) {
+        // Regular files get the buffered fd stream, anything else falls back to stdio
+        if (auto buffered = fd_stream::open(path)) {
+            stream = std::make_unique<fd_stream>(std::move(*buffered));
+        } else if (buffered.error().code() != error_code::unsupported_feature) {
+            return std::unexpected(buffered.error());
+        }
+    }
+#endif
+    
     if (!stream) {
-        return std::unexpected(stream.error());
+        auto file = file_stream::open(path);
+        if (!file) {
+            return std::unexpected(file.error());
+        }
+        stream = std::make_unique<file_stream>(std::move(*file));
     }
     
-    return archive_reader{std::make_unique<file_stream>(std::move(*stream))};
+    // Compressed archives are decompressed transparently
+    auto decompressed = open_decompressed(std::move(stream));
+    if (!decompressed) {
+        return std::unexpected(decompressed.error());
+    }
+    return archive_reader{std::move(*decompressed)};
 }
 
 auto archive_reader::from_stream(std::unique_ptr<input_stream> stream) -> std::expected<archive_reader, error> {
@@ -41,39 +88,73 @@ auto archive_reader::from_stream(std::unique_ptr<input_stream> stream) -> std::e
     return archive_reader{std::move(stream)};
 }
 
-auto archive_reader::read_block() -> std::expected<std::array<std::byte, detail::BLOCK_SIZE>, error> {
-    std::array<std::byte, detail::BLOCK_SIZE> block{};
-    auto result = stream_->read(block);
-    if (!result) {
-        return std::unexpected(result.error());
+auto archive_reader::read_block() -> std::expected<std::span<const std::byte, detail::BLOCK_SIZE>, error> {
+    size_t bytes_read;
+    const std::byte* block;
+    
+    if (peekable_) {
+        // Parse in place, the stream already holds many headers per I/O
+        auto view = stream_->peek(detail::BLOCK_SIZE);
+        if (!view) {
+            return std::unexpected(view.error());
+        }
+        bytes_read = view->size();
+        block = view->data();
+        stats_.record_read(bytes_read);
+        if (bytes_read == detail::BLOCK_SIZE) {
+            stats_.record_skip(0);  // Consumes the peeked bytes, counted above
+            if (auto skip_result = stream_->skip(detail::BLOCK_SIZE); !skip_result) {
+                return std::unexpected(skip_result.error());
+            }
+        }
+    } else {
+        auto result = stream_->read(block_buffer_);
+        if (!result) {
+            return std::unexpected(result.error());
+        }
+        bytes_read = *result;
+        block = block_buffer_.data();
+        stats_.record_read(bytes_read);
     }
     
-    if (*result != detail::BLOCK_SIZE) {
-        if (*result == 0 && stream_->at_end()) {
+    if (bytes_read != detail::BLOCK_SIZE) {
+        if (bytes_read == 0 && stream_->at_end()) {
             return std::unexpected(error{error_code::end_of_archive, "Unexpected end of archive"});
         }
         return std::unexpected(error{error_code::corrupt_archive, "Incomplete block read"});
     }
     
-    return block;
+    return std::span<const std::byte, detail::BLOCK_SIZE>{block, detail::BLOCK_SIZE};
 }
 
-auto archive_reader::skip_padding(size_t data_size) -> std::expected<void, error> {
-    const size_t padding = (detail::BLOCK_SIZE - (data_size % detail::BLOCK_SIZE)) % detail::BLOCK_SIZE;
+auto archive_reader::skip_padding(uint64_t data_size) -> std::expected<void, error> {
+    const uint64_t padding = (detail::BLOCK_SIZE - (data_size % detail::BLOCK_SIZE)) % detail::BLOCK_SIZE;
     if (padding > 0) {
+        stats_.record_skip(padding);
         return stream_->skip(padding);
     }
     return {};
 }
 
 auto archive_reader::skip_current_entry_data() -> std::expected<void, error> {
+    const detail::phase_timer timer{stats_.skip_time};
+
+    // Extension blocks of a listed old GNU sparse entry sit before its data
+    if (sparse_extensions_pending_) {
+        sparse_extensions_pending_ = false;
+        if (auto walked = read_sparse_extensions(nullptr); !walked) {
+            return std::unexpected(walked.error());
+        }
+    }
+
     // Calculate how much data still needs to be skipped
-    const size_t total_entry_size = current_entry_ ? current_entry_->size() : 0;
-    const size_t data_to_skip = current_entry_data_remaining_;
+    const uint64_t total_entry_size = current_entry_stored_size_;
+    const uint64_t data_to_skip = current_entry_data_remaining_;
     
     
     // Skip any remaining data
     if (data_to_skip > 0) {
+        stats_.record_skip(data_to_skip);
         auto skip_result = stream_->skip(data_to_skip);
         if (!skip_result) {
             return std::unexpected(skip_result.error());
@@ -90,153 +171,293 @@ auto archive_reader::skip_current_entry_data() -> std::expected<void, error> {
     
     current_entry_data_remaining_ = 0;
     current_entry_data_consumed_ = 0;
+    current_entry_stored_size_ = 0;
     
     return {};
 }
 
-auto archive_reader::next_entry() -> std::expected<std::optional<archive_entry>, error> {
+void archive_reader::release_view_extensions() {
+    if (view_extensions_held_) {
+        pending_gnu_extensions_.clear();
+        pending_pax_.clear();
+        view_extensions_held_ = false;
+    }
+}
+
+auto archive_reader::next_entry_view() -> std::expected<std::optional<entry_view>, error> {
     if (finished_) {
         return std::nullopt;
     }
+    release_view_extensions();
+    ++entry_count_;  // Entries handed out so far can no longer read from the stream
     
-    
-    // Skip any remaining data from the previous entry
-    if (auto skip_result = skip_current_entry_data(); !skip_result) {
-        return std::unexpected(skip_result.error());
-    }
-    
-    // Clear the current entry state after skipping data to prevent recursive issues
-    current_entry_.reset();
-    current_entry_data_remaining_ = 0;
-    current_entry_data_consumed_ = 0;
-    
-    // Read header block
-    auto block_result = read_block();
-    if (!block_result) {
-        if (block_result.error().code() == error_code::end_of_archive) {
-            finished_ = true;
-            return std::nullopt;
+    while (true) {
+        if (auto skip_result = skip_current_entry_data(); !skip_result) {
+            return std::unexpected(skip_result.error());
+        }
+        current_location_.reset();
+        const detail::phase_timer timer{stats_.header_time};
+        
+        if (random_access_ && !pending_header_offset_) {
+            pending_header_offset_ = random_access_->position();
+        }
+        
+        auto block_result = read_block();
+        if (!block_result) {
+            if (block_result.error().code() == error_code::end_of_archive) {
+                finished_ = true;
+                return std::nullopt;
+            }
+            return std::unexpected(block_result.error());
+        }
+        
+        if (detail::is_zero_block(*block_result)) {
+            if (auto second_block = read_block(); second_block && detail::is_zero_block(*second_block)) {
+                finished_ = true;
+                return std::nullopt;
+            }
+            return std::unexpected(error{error_code::corrupt_archive, "Single zero block in archive"});
+        }
+        
+        auto view = entry_view::parse(*block_result);
+        if (!view) {
+            return std::unexpected(view.error());
+        }
+        sparse_extensions_pending_ = sparse::old_map_continues(*block_result);
+        
+        // Extension headers only need their type and size, the payload is
+        // read into buffers reused across entries
+        const auto type = view->type();
+        if (is_extension_type(type)) {
+            auto size = view->size();
+            if (!size) {
+                return std::unexpected(size.error());
+            }
+            auto processed = process_extension_header(type, *size);
+            if (!processed) {
+                return std::unexpected(processed.error());
+            }
+            if (*processed) {
+                continue;
+            }
+        } else {
+            stats_.record_header(false, false);
+        }
+        
+        // Overrides point into the pending extension data, kept until the next call
+        if (pending_gnu_extensions_.has_longname()) {
+            view->path_override_ = pending_gnu_extensions_.longname;
+        }
+        if (pending_gnu_extensions_.has_longlink()) {
+            view->link_override_ = pending_gnu_extensions_.longlink;
+        }
+        if (!global_pax_.empty()) {
+            view->global_pax_ = &global_pax_;
+        }
+        if (!pending_pax_.empty()) {
+            if (pending_pax_.path) {
+                view->path_override_ = *pending_pax_.path;
+            }
+            if (pending_pax_.linkpath) {
+                view->link_override_ = *pending_pax_.linkpath;
+            }
+            view->size_override_ = pending_pax_.size;
+            view->sparse_ = view->sparse_ || pending_pax_.gnu_sparse;
+            view->pax_headers_ = &pending_pax_;
+        }
+        view_extensions_held_ = true;
+        
+        auto stored_size = view->size();
+        if (!stored_size) {
+            return std::unexpected(stored_size.error());
         }
-        return std::unexpected(block_result.error());
+        
+        // The data, including any sparse map, is skipped on the next call
+        current_entry_data_remaining_ = *stored_size;
+        current_entry_data_consumed_ = 0;
+        current_entry_stored_size_ = current_entry_data_remaining_;
+        if (volumes_) {
+            volumes_->begin_member(view->path(), current_entry_stored_size_);
+        }
+        if (random_access_) {
+            const uint64_t data_offset = random_access_->position();
+            current_location_ = entry_location{
+                pending_header_offset_.value_or(data_offset - detail::BLOCK_SIZE),
+                data_offset,
+                current_entry_stored_size_
+            };
+        }
+        pending_header_offset_.reset();
+        
+        return std::move(*view);
     }
-    
-    // Check for end-of-archive (two zero blocks)
-    if (detail::is_zero_block(*block_result)) {
-        // Try to read the second zero block
-        if (auto second_block = read_block(); second_block && detail::is_zero_block(*second_block)) {
-            finished_ = true;
-            return std::nullopt;  // Normal end of archive
+}
+
+auto archive_reader::entry_from_view(const entry_view& view) -> std::expected<archive_entry, error> {
+    const detail::phase_timer timer{stats_.header_time};
+    auto metadata = detail::parse_header(view.block(), pending_replacements());
+    if (!metadata) {
+        return std::unexpected(metadata.error());
+    }
+
+    // The extensions move into the entry, and the data is still unread
+    view_extensions_held_ = false;
+    if (current_location_) {
+        pending_header_offset_ = current_location_->header_offset;
+    }
+    if (sparse_extensions_pending_ && metadata->sparse_info) {
+        sparse_extensions_pending_ = false;
+        if (auto extended = read_sparse_extensions(&*metadata->sparse_info); !extended) {
+            return std::unexpected(extended.error());
         }
-        // Not end of archive, this is an error
-        return std::unexpected(error{error_code::corrupt_archive, "Single zero block in archive"});
     }
-    
-    // Parse header
-    auto metadata_result = detail::parse_header(*block_result);
-    if (!metadata_result) {
-        return std::unexpected(metadata_result.error());
+    return finish_entry(std::move(*metadata));
+}
+
+auto archive_reader::next_entry() -> std::expected<std::optional<archive_entry>, error> {
+    if (finished_) {
+        return std::nullopt;
     }
+    release_view_extensions();
+    ++entry_count_;  // Entries handed out so far can no longer read from the stream
     
-    // Check if this is a GNU extension entry
-    if (metadata_result->is_gnu_extension()) {
-        auto process_result = process_gnu_extension(*metadata_result);
-        if (!process_result) {
-            return std::unexpected(process_result.error());
+    // Extension headers loop back here until the entry header they describe
+    while (true) {
+        // Skip any remaining data from the previous entry
+        if (auto skip_result = skip_current_entry_data(); !skip_result) {
+            return std::unexpected(skip_result.error());
         }
+        current_location_.reset();
+        const detail::phase_timer timer{stats_.header_time};
         
-        if (*process_result) {
-            // GNU extension processed, continue to the next entry
-            return next_entry();
-        }
-        // Fall through for unsupported GNU extensions
-    }
-    
-    // Check if this is a PAX extended header entry
-    if (metadata_result->is_pax_header()) {
-        auto process_result = process_pax_header(*metadata_result);
-        if (!process_result) {
-            return std::unexpected(process_result.error());
+        // Remember where this entry's first header starts
+        if (random_access_ && !pending_header_offset_) {
+            pending_header_offset_ = random_access_->position();
         }
         
-        if (*process_result) {
-            // PAX header processed, continue to the next entry
-            return next_entry();
+        // Read header block
+        auto block_result = read_block();
+        if (!block_result) {
+            if (block_result.error().code() == error_code::end_of_archive) {
+                finished_ = true;
+                return std::nullopt;
+            }
+            return std::unexpected(block_result.error());
         }
-        // Fall through for unsupported PAX extensions
-    }
-    
-    // Apply any pending GNU extensions to the metadata
-    auto final_metadata = *metadata_result;
-    gnu::apply_gnu_extensions(final_metadata, pending_gnu_extensions_);
-    pending_gnu_extensions_.clear();
-    
-    // Apply PAX headers to metadata
-    if (!pending_pax_headers_.empty()) {
-        // Apply standard PAX header overrides
-        if (auto path_it = pending_pax_headers_.find("path"); path_it != pending_pax_headers_.end()) {
-            final_metadata.path = path_it->second;
-        }
-        if (auto size_it = pending_pax_headers_.find("size"); size_it != pending_pax_headers_.end()) {
-            uint64_t pax_size;
-            if (std::from_chars(size_it->second.data(), size_it->second.data() + size_it->second.size(), pax_size).ec == std::errc{}) {
-                final_metadata.size = pax_size;
+        
+        // Check for end-of-archive (two zero blocks)
+        if (detail::is_zero_block(*block_result)) {
+            // Try to read the second zero block
+            if (auto second_block = read_block(); second_block && detail::is_zero_block(*second_block)) {
+                finished_ = true;
+                return std::nullopt;  // Normal end of archive
             }
+            // Not end of archive, this is an error
+            return std::unexpected(error{error_code::corrupt_archive, "Single zero block in archive"});
         }
         
-        // Check for GNU sparse format 1.0
-        if (pax::has_gnu_sparse_markers(pending_pax_headers_)) {
-            auto version = pax::get_gnu_sparse_version(pending_pax_headers_);
-            if (version.first == 1 && version.second == 0) {
-                // GNU sparse format 1.0 - sparse map is in a data block
-                // Get the real size from PAX headers
-                uint64_t real_size = final_metadata.size;
-                if (auto realsize_it = pending_pax_headers_.find("GNU.sparse.realsize"); 
-                    realsize_it != pending_pax_headers_.end()) {
-                    std::from_chars(realsize_it->second.data(), 
-                                  realsize_it->second.data() + realsize_it->second.size(), 
-                                  real_size);
-                }
-                
-                // Mark that this file needs sparse 1.0 processing
-                // We'll read the sparse map from the data block later
-                final_metadata.size = real_size;
-                
-                // Set a special marker to indicate sparse 1.0 processing needed
-                sparse::sparse_metadata placeholder;
-                placeholder.real_size = real_size;
-                // Empty segments - will be filled when we read the data block
-                final_metadata.sparse_info = std::move(placeholder);
-                needs_sparse_1_0_processing_ = true;
+        // Extension headers are taken from their type and size alone, like
+        // next_entry_view() does; nothing is built for their own header
+        const auto& header = *std::bit_cast<const ustar_header*>(block_result->data());
+        if (const auto type = static_cast<entry_type>(header.typeflag); is_extension_type(type)) {
+            if (auto valid = detail::validate_header(*block_result); !valid) {
+                return std::unexpected(valid.error());
+            }
+            auto size = detail::parse_numeric(std::span{header.size});
+            if (!size) {
+                return std::unexpected(size.error());
+            }
+            auto processed = process_extension_header(type, *size);
+            if (!processed) {
+                return std::unexpected(processed.error());
+            }
+            if (*processed) {
+                continue;
             }
         }
         
-        // Extract extended attributes from PAX headers
-        final_metadata.xattrs = pax::extract_extended_attributes(pending_pax_headers_);
+        // Parse header, leaving out what pending extensions replace
+        auto metadata_result = detail::parse_header(*block_result, pending_replacements());
+        if (!metadata_result) {
+            return std::unexpected(metadata_result.error());
+        }
+        stats_.record_header(metadata_result->is_pax_header(), metadata_result->is_gnu_extension());
+        
+        // GNU extension and PAX headers apply to the entry that follows
+        // Unsupported ones fall through and are returned as entries
+        if (metadata_result->is_gnu_extension() || metadata_result->is_pax_header()) {
+            auto process_result = metadata_result->is_pax_header() ?
+                process_pax_header(*metadata_result) : process_gnu_extension(*metadata_result);
+            if (!process_result) {
+                return std::unexpected(process_result.error());
+            }
+            if (*process_result) {
+                continue;
+            }
+        }
         
-        // Extract POSIX ACLs from PAX headers
-        auto [access_acl, default_acl] = pax::extract_acls(pending_pax_headers_);
-        final_metadata.access_acl = std::move(access_acl);
-        final_metadata.default_acl = std::move(default_acl);
+        // Extension blocks continue an old GNU sparse map before the data
+        if (metadata_result->sparse_info && sparse::old_map_continues(*block_result)) {
+            if (auto extended = read_sparse_extensions(&*metadata_result->sparse_info); !extended) {
+                return std::unexpected(extended.error());
+            }
+        }
         
-        pending_pax_headers_.clear();
+        return finish_entry(std::move(*metadata_result));
     }
+}
+
+auto archive_reader::finish_entry(file_metadata final_metadata) -> std::expected<archive_entry, error> {
+    // Apply any pending GNU extensions to the metadata
+    gnu::apply_gnu_extensions(final_metadata, pending_gnu_extensions_);
+    pending_gnu_extensions_.clear();
     
-    // Apply pending sparse info if we have any (from the old format)
-    if (pending_sparse_info_ && final_metadata.is_regular_file()) {
-        final_metadata.sparse_info = std::move(pending_sparse_info_);
-        pending_sparse_info_.reset();
+    // Global PAX values sit under the entry's own PAX records
+    if (!global_pax_.empty()) {
+        global_pax_.apply_to(final_metadata);
     }
     
-    // Handle GNU sparse format 1.0 data block processing
-    if (needs_sparse_1_0_processing_ && final_metadata.sparse_info) {
-        // Read the sparse map from the data block
-        auto sparse_1_0_result = sparse::parse_sparse_1_0_data_map(*stream_, final_metadata.sparse_info->real_size);
-        if (sparse_1_0_result) {
-            final_metadata.sparse_info = std::move(*sparse_1_0_result);
+    // Apply PAX headers to metadata
+    if (!pending_pax_.empty()) {
+        pending_pax_.apply_to(final_metadata);
+        
+        // GNU sparse format 1.0 keeps its sparse map in a data block
+        if (pending_pax_.gnu_sparse && pending_pax_.sparse_major == 1 && pending_pax_.sparse_minor == 0) {
+            const uint64_t real_size = pending_pax_.sparse_realsize.value_or(final_metadata.size);
+            final_metadata.size = real_size;
+            
+            // Empty segments until the map is read from the data block
+            sparse::sparse_metadata placeholder;
+            placeholder.real_size = real_size;
+            final_metadata.sparse_info = std::move(placeholder);
+            needs_sparse_1_0_processing_ = true;
         }
+        
+        pending_pax_.clear();
+    }
+    
+    // GNU sparse format 1.0 keeps its map at the start of the data
+    if (needs_sparse_1_0_processing_ && final_metadata.sparse_info) {
         needs_sparse_1_0_processing_ = false;
+        if (auto map_result = read_sparse_map(*final_metadata.sparse_info); !map_result) {
+            return std::unexpected(map_result.error());
+        }
     }
     
+    return create_entry(std::move(final_metadata));
+}
+
+auto archive_reader::begin_digests(const file_metadata& metadata) -> detail::digest_slot* {
+    ++entry_count_;
+    if (!digests_.hasher.algorithms().any() || !metadata.is_regular_file() || metadata.sparse_info) {
+        digests_.entry = 0;
+        return nullptr;
+    }
+    digests_.begin(entry_count_, metadata.size);
+    return &digests_;
+}
+
+auto archive_reader::create_entry(file_metadata final_metadata) -> std::expected<archive_entry, error> {
     // Create entry with data reader
     // For sparse files, we need to adjust the data size and reader
     if (final_metadata.sparse_info) {
@@ -251,104 +472,144 @@ auto archive_reader::next_entry() -> std::expected<std::optional<archive_entry>,
         current_entry_data_remaining_ = final_metadata.size;
         current_entry_data_consumed_ = 0;
     }
+    current_entry_stored_size_ = current_entry_data_remaining_;
+    if (volumes_) {
+        volumes_->begin_member(final_metadata.path.string(), current_entry_stored_size_);
+    }
     
-    // Capture the necessary variables for the lambda
-    auto* stream_ptr = stream_.get();
-    auto* remaining_ptr = &current_entry_data_remaining_;
-    auto* consumed_ptr = &current_entry_data_consumed_;
-    
-    data_reader_fn base_reader = [stream_ptr, remaining_ptr, consumed_ptr](const size_t offset, const size_t length)
-        -> std::expected<std::span<const std::byte>, error> {
-        
-        if (offset > 0) {
-            return std::unexpected(error{error_code::unsupported_feature, 
-                "Streaming mode doesn't support offset reads"});
-        }
-        
-        // Only read from where we left off
-        if (offset < *consumed_ptr) {
-            return std::unexpected(error{error_code::invalid_operation, 
-                "Cannot seek backwards in streaming mode"});
+    // Record where the entry lives when the stream can tell us
+    if (random_access_) {
+        const uint64_t data_offset = random_access_->position();
+        current_location_ = entry_location{
+            pending_header_offset_.value_or(data_offset >= detail::BLOCK_SIZE ? data_offset - detail::BLOCK_SIZE : 0),
+            data_offset,
+            current_entry_stored_size_
+        };
+    }
+    pending_header_offset_.reset();
+    
+    // Memory-backed archives hand out spans that point directly into the mapping
+    if (mapped_data_) {
+        const uint64_t data_start = random_access_->position();
+        const uint64_t stored_size = current_entry_data_remaining_;
+        if (data_start > mapped_data_->size() || stored_size > mapped_data_->size() - data_start) {
+            return std::unexpected(error{error_code::corrupt_archive, "Entry data extends beyond end of archive"});
         }
+        const auto stored_data = mapped_data_->subspan(static_cast<size_t>(data_start), static_cast<size_t>(stored_size));
         
-        // Skip any gap between consumed and requested offset
-        if (size_t skip_amount = offset - *consumed_ptr; skip_amount > 0) {
-            if (auto skip_result = stream_ptr->skip(skip_amount); !skip_result) {
-                return std::unexpected(skip_result.error());
+        if (!final_metadata.sparse_info) {
+            if (auto* digests = begin_digests(final_metadata)) {
+                return archive_entry{std::move(final_metadata), archive_data_source{stored_data, digests, entry_count_}};
             }
-            *consumed_ptr += skip_amount;
-            *remaining_ptr -= skip_amount;
-        }
-
-        const size_t to_read = std::min(length, *remaining_ptr);
-        if (to_read == 0) {
-            return std::span<const std::byte>{};
-        }
-        
-        // Use thread_local buffer for data
-        thread_local std::vector<std::byte> buffer;
-        buffer.resize(to_read);
-        
-        auto result = stream_ptr->read(std::span{buffer.data(), to_read});
-        if (!result) {
-            return std::unexpected(result.error());
+            return archive_entry{std::move(final_metadata), stored_data};
         }
         
-        *remaining_ptr -= *result;
-        *consumed_ptr += *result;
-        return std::span{buffer.data(), *result};
-    };
+        // Sparse entries map logical offsets onto the stored data segments
+        final_metadata.sparse_info->index_segments();
+        return archive_entry{std::move(final_metadata), archive_data_source{stored_data}};
+    }
     
-    // Wrap with a sparse reader if needed
-    data_reader_fn reader;
+    // Reads go through the stream and this reader's position bookkeeping
     if (final_metadata.sparse_info) {
-        reader = sparse::make_sparse_reader(*final_metadata.sparse_info, std::move(base_reader));
-    } else {
-        reader = std::move(base_reader);
+        final_metadata.sparse_info->index_segments();
     }
+    auto* digests = begin_digests(final_metadata);
+    const archive_data_source source{*stream_, random_access_,
+        current_entry_data_remaining_, current_entry_data_consumed_,
+        current_entry_stored_size_, random_access_ ? random_access_->position() : 0, &stats_,
+        digests, entry_count_, &entry_count_};
     
-    archive_entry entry{std::move(final_metadata), std::move(reader)};
-    current_entry_ = entry;
-    
-    return entry;
+    return archive_entry{std::move(final_metadata), source};
 }
 
-auto archive_reader::process_gnu_extension(const file_metadata &meta) -> std::expected<bool, error> {
-    if (meta.is_gnu_longname()) {
-        // Read the long filename
-        auto longname_result = gnu::read_gnu_extension_data(*stream_, meta.size);
-        if (!longname_result) {
-            return std::unexpected(longname_result.error());
-        }
-        
-        pending_gnu_extensions_.longname = std::move(*longname_result);
-        return true;  // Extension processed
+auto archive_reader::open_entry(const index_record &record) -> std::expected<archive_entry, error> {
+    if (!random_access_) {
+        return std::unexpected(error{error_code::unsupported_feature, 
+            "Opening indexed entries requires a random access stream"});
     }
     
-    if (meta.is_gnu_longlink()) {
-        // Read the long link target
-        auto longlink_result = gnu::read_gnu_extension_data(*stream_, meta.size);
-        if (!longlink_result) {
-            return std::unexpected(longlink_result.error());
-        }
-        
-        pending_gnu_extensions_.longlink = std::move(*longlink_result);
-        return true;  // Extension processed
+    // Let mapped streams fault the entry in ahead of the caller's reads
+    const auto& location = record.location;
+    random_access_->will_need(location.header_offset,
+        location.data_offset - location.header_offset + location.stored_size);
+
+    stats_.record_seek();
+    if (auto seek_result = random_access_->seek(record.location.data_offset); !seek_result) {
+        return std::unexpected(seek_result.error());
     }
     
-    if (meta.type == entry_type::gnu_sparse) {
-        // Handle sparse files
-        if (auto sparse_result = process_sparse_file(meta); !sparse_result) {
-            return std::unexpected(sparse_result.error());
+    // Discard any state left over from sequential iteration
+    pending_gnu_extensions_.clear();
+    pending_pax_.clear();
+    needs_sparse_1_0_processing_ = false;
+    sparse_extensions_pending_ = false;
+    pending_header_offset_ = record.location.header_offset;
+    finished_ = false;
+    
+    return create_entry(record.metadata);
+}
+
+auto archive_reader::reset(std::unique_ptr<input_stream> stream) -> std::unique_ptr<input_stream> {
+    auto previous = std::move(stream_);
+    attach(std::move(stream));
+
+    // Clear per-archive state; vectors and strings keep their capacity
+    current_entry_data_remaining_ = 0;
+    current_entry_data_consumed_ = 0;
+    current_entry_stored_size_ = 0;
+    pending_header_offset_.reset();
+    current_location_.reset();
+    finished_ = false;
+    pending_gnu_extensions_.clear();
+    pending_pax_.clear();
+    global_records_.clear();
+    global_pax_.clear();
+    needs_sparse_1_0_processing_ = false;
+    sparse_extensions_pending_ = false;
+    view_extensions_held_ = false;
+    stats_ = {};
+    digests_.entry = 0;
+    ++entry_count_;
+    return previous;
+}
+
+auto archive_reader::pending_replacements() const noexcept -> detail::replaced_fields {
+    return {pending_gnu_extensions_.has_longname() || pending_pax_.path.has_value(),
+            pending_gnu_extensions_.has_longlink() || pending_pax_.linkpath.has_value()};
+}
+
+auto archive_reader::process_extension_header(const entry_type type, const uint64_t size) -> std::expected<bool, error> {
+    file_metadata metadata;
+    metadata.type = type;
+    metadata.size = size;
+    stats_.record_header(metadata.is_pax_header(), metadata.is_gnu_extension());
+    return metadata.is_pax_header() ? process_pax_header(metadata) : process_gnu_extension(metadata);
+}
+
+auto archive_reader::process_gnu_extension(const file_metadata &meta) -> std::expected<bool, error> {
+    if (meta.is_gnu_longname() || meta.is_gnu_longlink()) {
+        // Read the long filename or link target
+        auto& target = meta.is_gnu_longname() ? pending_gnu_extensions_.longname : pending_gnu_extensions_.longlink;
+        const size_t capacity = target.capacity();
+        auto read_result = gnu::read_gnu_extension_data(*stream_, meta.size, target);
+        if (!read_result) {
+            return std::unexpected(read_result.error());
         }
-        return true;  // Sparse file processed
+        stats_.record_read(meta.size);
+        stats_.record_skip((detail::BLOCK_SIZE - meta.size % detail::BLOCK_SIZE) % detail::BLOCK_SIZE);
+        stats_.record_growth(capacity, target.capacity());
+        
+        return true;  // Extension processed
     }
     
-    // Other GNU extensions - skip for now
+    // Volume labels carry no entry. A multi_volume_stream strips the
+    // continuation headers of later volumes; one met here starts a volume
+    // read on its own, and the rest of its member cannot be used.
     if (meta.type == entry_type::gnu_volhdr ||
         meta.type == entry_type::gnu_multivol) {
         
-        // Skip the data for unsupported GNU extensions
+        // Skip the label or the member's remaining data
+        stats_.record_skip(meta.size);
         if (auto skip_result = stream_->skip(meta.size); !skip_result) {
             return std::unexpected(skip_result.error());
         }
@@ -366,26 +627,26 @@ auto archive_reader::process_gnu_extension(const file_metadata &meta) -> std::ex
 
 auto archive_reader::process_pax_header(const file_metadata &meta) -> std::expected<bool, error> {
     if (meta.type == entry_type::pax_extended_header) {
-        // Read PAX header data
-        std::vector<std::byte> pax_data(meta.size);
-        auto read_result = stream_->read(std::span{pax_data.data(), meta.size});
+        // Read PAX header data into a buffer reused across headers
+        // The parsed records view it until they are applied to the entry
+        const size_t capacity = pax_buffer_.capacity();
+        pax_buffer_.resize(meta.size);
+        stats_.record_growth(capacity, pax_buffer_.capacity());
+        auto read_result = stream_->read(std::span{pax_buffer_});
         if (!read_result) {
             return std::unexpected(read_result.error());
         }
+        stats_.record_read(*read_result);
         
         if (*read_result != meta.size) {
             return std::unexpected(error{error_code::corrupt_archive, "Incomplete PAX header data"});
         }
         
-        // Parse PAX headers
-        auto parse_result = pax::parse_pax_headers(std::span{pax_data});
-        if (!parse_result) {
+        // Store PAX records for the next entry
+        if (auto parse_result = pax::parse_records(pax_buffer_, pending_pax_); !parse_result) {
             return std::unexpected(parse_result.error());
         }
         
-        // Store PAX headers for the next entry
-        pending_pax_headers_ = std::move(*parse_result);
-        
         // Skip padding
         if (auto padding_result = skip_padding(meta.size); !padding_result) {
             return std::unexpected(padding_result.error());
@@ -395,49 +656,84 @@ auto archive_reader::process_pax_header(const file_metadata &meta) -> std::expec
     }
     
     if (meta.type == entry_type::pax_global_header) {
-        // For now, skip global PAX headers (they apply to all subsequent entries)
-        if (auto skip_result = stream_->skip(meta.size); !skip_result) {
-            return std::unexpected(skip_result.error());
+        // Global records apply to all following entries, decoded once here
+        const size_t capacity = global_buffer_.capacity();
+        global_buffer_.resize(meta.size);
+        stats_.record_growth(capacity, global_buffer_.capacity());
+        auto read_result = stream_->read(std::span{global_buffer_});
+        if (!read_result) {
+            return std::unexpected(read_result.error());
         }
-
+        stats_.record_read(*read_result);
+        
+        if (*read_result != meta.size) {
+            return std::unexpected(error{error_code::corrupt_archive, "Incomplete PAX global header data"});
+        }
+        
+        if (auto parse_result = pax::parse_records(global_buffer_, global_records_); !parse_result) {
+            return std::unexpected(parse_result.error());
+        }
+        global_pax_.merge(global_records_);
+        
         if (auto padding_result = skip_padding(meta.size); !padding_result) {
             return std::unexpected(padding_result.error());
         }
         
-        return true;  // Global PAX header skipped
+        return true;  // Global PAX header processed
     }
     
     return false;  // Not a PAX header
 }
 
-auto archive_reader::process_sparse_file(const file_metadata &meta) -> std::expected<void, error> {
-    // This is called when we have a regular file with sparse info that has extended headers
-    // We need to read the extended sparse header blocks
-    
-    if (!meta.sparse_info) {
-        return std::unexpected(error{error_code::invalid_header, "Sparse file entry without sparse info"});
+auto archive_reader::read_sparse_extensions(sparse::sparse_metadata* map) -> std::expected<void, error> {
+    const size_t capacity = map ? map->segments.capacity() : 0;
+    while (true) {
+        auto block = read_block();
+        if (!block) {
+            if (block.error().code() == error_code::end_of_archive) {
+                return std::unexpected(error{error_code::corrupt_archive, "Archive ends inside sparse extension blocks"});
+            }
+            return std::unexpected(block.error());
+        }
+        bool continues = sparse::extension_continues(*block);
+        if (map) {
+            auto parsed = sparse::parse_old_sparse_extension(*block, *map);
+            if (!parsed) {
+                return std::unexpected(parsed.error());
+            }
+            continues = *parsed;
+        }
+        if (!continues) {
+            break;
+        }
     }
-    
-    // Read extended sparse headers
-    auto extended_segments = sparse::read_sparse_map_continuation(*stream_);
-    if (!extended_segments) {
-        return std::unexpected(extended_segments.error());
+    if (map) {
+        stats_.record_growth(capacity, map->segments.capacity());
     }
-    
-    // Add the extended segments to our sparse info
-    pending_sparse_info_ = *meta.sparse_info;
-    pending_sparse_info_->segments.insert(
-        pending_sparse_info_->segments.end(),
-        extended_segments->begin(),
-        extended_segments->end()
-    );
-    
-    // Recalculate real size based on all segments
-    if (!pending_sparse_info_->segments.empty()) {
-        const auto& last = pending_sparse_info_->segments.back();
-        pending_sparse_info_->real_size = last.offset + last.size;
+    return {};
+}
+
+auto archive_reader::read_sparse_map(sparse::sparse_metadata& map) -> std::expected<void, error> {
+    // Parsed in place from each block as it arrives, nothing is accumulated
+    const size_t capacity = map.segments.capacity();
+    sparse::map_parser parser{&map, map.real_size};
+    while (true) {
+        auto block = read_block();
+        if (!block) {
+            if (block.error().code() == error_code::end_of_archive) {
+                return std::unexpected(error{error_code::corrupt_archive, "Archive ends inside sparse map"});
+            }
+            return std::unexpected(block.error());
+        }
+        auto done = parser.feed(*block);
+        if (!done) {
+            return std::unexpected(done.error());
+        }
+        if (*done) {
+            break;
+        }
     }
-    
+    stats_.record_growth(capacity, map.segments.capacity());
     return {};
 }
 
@@ -0,0 +1,690 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <tierone/tar/archive_writer.hpp>
+#include <tierone/tar/archive_index.hpp>
+#include <tierone/tar/header_parser.hpp>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <charconv>
+#include <cerrno>
+#include <cstring>
+#include <string_view>
+#include <utility>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
+
+namespace tierone::tar {
+
+namespace {
+
+constexpr std::array<std::byte, 2 * detail::BLOCK_SIZE> zero_blocks{};
+
+// Whether value fits a NUL-terminated octal field of this width
+template<size_t N>
+constexpr bool fits_octal(const char (&)[N], const uint64_t value) {
+    return value < (uint64_t{1} << (3 * (N - 1)));
+}
+
+template<size_t N>
+void put_octal(char (&field)[N], const uint64_t value) {
+    std::array<char, 24> digits{};
+    const auto result = std::to_chars(digits.data(), digits.data() + digits.size(), value, 8);
+    const auto length = static_cast<size_t>(result.ptr - digits.data());
+    std::memset(field, '0', N - 1 - length);
+    std::memcpy(field + (N - 1 - length), digits.data(), length);
+    field[N - 1] = '\0';
+}
+
+// Copies up to N bytes, a field filled to the brim is not NUL-terminated
+template<size_t N>
+void put_string(char (&field)[N], const std::string_view value) {
+    std::memcpy(field, value.data(), std::min(value.size(), N));
+}
+
+// Split a path into ustar prefix and name fields at a '/'
+// Returns false if no split fits
+bool split_ustar_path(const std::string_view path, std::string_view& prefix, std::string_view& name) {
+    if (path.size() <= sizeof(ustar_header::name)) {
+        prefix = {};
+        name = path;
+        return true;
+    }
+    const size_t first = path.size() - sizeof(ustar_header::name) - 1;
+    for (size_t slash = path.find('/', first); slash != std::string_view::npos; slash = path.find('/', slash + 1)) {
+        if (slash > sizeof(ustar_header::prefix)) {
+            break;
+        }
+        if (slash + 1 < path.size()) {
+            prefix = path.substr(0, slash);
+            name = path.substr(slash + 1);
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t decimal_digits(size_t value) {
+    size_t digits = 1;
+    while (value >= 10) {
+        value /= 10;
+        ++digits;
+    }
+    return digits;
+}
+
+// Append "length key=value\n", where length counts its own digits
+void append_pax_record(std::string& records, const std::string_view key, const std::string_view value) {
+    const size_t body = key.size() + value.size() + 3;  // ' ', '=' and '\n'
+    size_t length = body + decimal_digits(body);
+    if (decimal_digits(length) != decimal_digits(body)) {
+        ++length;
+    }
+    records += std::to_string(length);
+    records += ' ';
+    records += key;
+    records += '=';
+    records += value;
+    records += '\n';
+}
+
+// Text form read back by pax::parse_acl_text()
+std::string format_acl(const std::vector<acl_entry>& acl) {
+    std::string text;
+    for (const auto& entry : acl) {
+        if (!text.empty()) {
+            text += ',';
+        }
+        switch (entry.entry_type) {
+            case acl_entry::type::user_obj: text += "user::"; break;
+            case acl_entry::type::user: text += "user:" + std::to_string(entry.id) + ':'; break;
+            case acl_entry::type::group_obj: text += "group::"; break;
+            case acl_entry::type::group: text += "group:" + std::to_string(entry.id) + ':'; break;
+            case acl_entry::type::mask: text += "mask::"; break;
+            case acl_entry::type::other: text += "other::"; break;
+            default: break;
+        }
+        const auto perms = std::to_underlying(entry.permissions);
+        text += (perms & std::to_underlying(acl_entry::perm::read)) ? 'r' : '-';
+        text += (perms & std::to_underlying(acl_entry::perm::write)) ? 'w' : '-';
+        text += (perms & std::to_underlying(acl_entry::perm::execute)) ? 'x' : '-';
+    }
+    return text;
+}
+
+// Set magic and version, then the checksum over the finished block
+void seal_header(ustar_header& header, const long_name_format format) {
+    if (format == long_name_format::gnu) {
+        std::memcpy(header.magic, "ustar ", sizeof(header.magic));
+        std::memcpy(header.version, " ", sizeof(header.version));
+    } else {
+        std::memcpy(header.magic, "ustar", sizeof(header.magic));
+        std::memcpy(header.version, "00", sizeof(header.version));
+    }
+    const auto block = std::span<const std::byte, detail::BLOCK_SIZE>{
+        reinterpret_cast<const std::byte*>(&header), detail::BLOCK_SIZE};
+    // Six digits, NUL and a space, as GNU tar writes it
+    char digits[7];
+    put_octal(digits, detail::calculate_checksum(block));
+    std::memcpy(header.checksum, digits, sizeof(digits));
+    header.checksum[7] = ' ';
+}
+
+std::span<const std::byte> as_bytes(const ustar_header& header) {
+    return {reinterpret_cast<const std::byte*>(&header), sizeof(header)};
+}
+
+std::span<const std::byte> as_bytes(const std::string& text) {
+    return {reinterpret_cast<const std::byte*>(text.data()), text.size()};
+}
+
+} // anonymous namespace
+
+archive_writer::archive_writer(std::unique_ptr<output_stream> output, const writer_options& options)
+    : output_(std::move(output)), options_(options),
+      buffer_(std::max(options.buffer_size, detail::BLOCK_SIZE)) {}
+
+auto archive_writer::create(
+    const std::filesystem::path& path, const writer_options& options) -> std::expected<archive_writer, error> {
+#ifdef __linux__
+    auto file = fd_output_stream::create(path);
+    if (!file) {
+        return std::unexpected(file.error());
+    }
+    return archive_writer{std::make_unique<fd_output_stream>(std::move(*file)), options};
+#else
+    auto file = file_output_stream::create(path);
+    if (!file) {
+        return std::unexpected(file.error());
+    }
+    return archive_writer{std::make_unique<file_output_stream>(std::move(*file)), options};
+#endif
+}
+
+auto archive_writer::append(
+    const std::filesystem::path& path, const writer_options& options) -> std::expected<archive_writer, error> {
+    auto reader = archive_reader::from_file(path);
+    if (!reader) {
+        return std::unexpected(reader.error());
+    }
+    auto index = archive_index::build(*reader);
+    if (!index) {
+        return std::unexpected(index.error());
+    }
+    return append(path, *index, options);
+}
+
+auto archive_writer::append(
+    const std::filesystem::path& path,
+    const archive_index& index,
+    const writer_options& options) -> std::expected<archive_writer, error> {
+    const uint64_t end = index.end_offset();
+
+    // Only zero blocks, or nothing, may follow the last member; anything
+    // else means the index is stale and cutting there would lose members
+    {
+        auto file = file_stream::open(path);
+        if (!file) {
+            return std::unexpected(file.error());
+        }
+        if (file->size() && *file->size() < end) {
+            return std::unexpected(error{error_code::corrupt_archive,
+                "Archive is shorter than its index"}.at_offset(end));
+        }
+        if (auto seeked = file->seek(end); !seeked) {
+            return std::unexpected(seeked.error());
+        }
+        std::array<std::byte, 2 * detail::BLOCK_SIZE> marker{};
+        auto read = file->read(marker);
+        if (!read) {
+            return std::unexpected(read.error());
+        }
+        if (std::ranges::any_of(std::span{marker}.first(*read), [](const std::byte b) { return b != std::byte{0}; })) {
+            return std::unexpected(error{error_code::corrupt_archive,
+                "Archive has data after its last indexed member"}.at_offset(end));
+        }
+    }
+
+#ifdef __linux__
+    auto file = fd_output_stream::open_at(path, end);
+    if (!file) {
+        return std::unexpected(file.error());
+    }
+    return archive_writer{std::make_unique<fd_output_stream>(std::move(*file)), options};
+#else
+    auto file = file_output_stream::open_at(path, end);
+    if (!file) {
+        return std::unexpected(file.error());
+    }
+    return archive_writer{std::make_unique<file_output_stream>(std::move(*file)), options};
+#endif
+}
+
+auto archive_writer::check_entry(const file_metadata& meta, const bool stored) const -> std::expected<uint64_t, error> {
+    if (finished_) {
+        return std::unexpected(error{error_code::invalid_operation, "Archive has already been finished"});
+    }
+    if (meta.path.empty()) {
+        return std::unexpected(error{error_code::invalid_operation, "Empty file path"});
+    }
+    if (meta.is_pax_header() || meta.is_gnu_extension()) {
+        return std::unexpected(error{error_code::invalid_operation,
+            "Extension headers are generated by the writer, not added as entries"});
+    }
+    if (meta.sparse_info) {
+        // Only the stored segments can be written, there is no hole detection
+        if (!stored) {
+            return std::unexpected(error{error_code::unsupported_feature,
+                "Sparse entries can only be written from stored data"});
+        }
+        const auto& info = *meta.sparse_info;
+        if (!meta.is_regular_file() || info.real_size != meta.size) {
+            return std::unexpected(error{error_code::invalid_operation, "Sparse map does not match the entry"});
+        }
+        uint64_t end = 0;
+        for (const auto& segment : info.segments) {
+            if (segment.offset < end || segment.size > info.real_size - segment.offset) {
+                return std::unexpected(error{error_code::invalid_operation, "Sparse map does not match the entry"});
+            }
+            end = segment.offset + segment.size;
+        }
+        return info.total_data_size();
+    }
+    return meta.is_regular_file() ? meta.size : 0;
+}
+
+auto archive_writer::add_entry(
+    const file_metadata& meta, const std::span<const std::byte> data) -> std::expected<void, error> {
+    auto data_size = check_entry(meta);
+    if (!data_size) {
+        return std::unexpected(data_size.error());
+    }
+    if (data.size() != *data_size) {
+        return std::unexpected(error{error_code::invalid_operation, "Entry data does not match the entry size"});
+    }
+
+    if (auto result = write_headers(meta, *data_size); !result) {
+        return result;
+    }
+    if (auto result = write_bytes(data); !result) {
+        return result;
+    }
+    return write_padding(*data_size);
+}
+
+auto archive_writer::add_entry(const file_metadata& meta, input_stream& source) -> std::expected<void, error> {
+    auto data_size = check_entry(meta);
+    if (!data_size) {
+        return std::unexpected(data_size.error());
+    }
+
+    if (auto result = write_headers(meta, *data_size); !result) {
+        return result;
+    }
+
+    if (auto result = write_from(source, *data_size); !result) {
+        return result;
+    }
+    return write_padding(*data_size);
+}
+
+auto archive_writer::add_file(
+    const file_metadata& meta, const std::filesystem::path& source) -> std::expected<void, error> {
+    auto data_size = check_entry(meta);
+    if (!data_size) {
+        return std::unexpected(data_size.error());
+    }
+
+#ifdef __linux__
+    // Minimal read buffer, the fallback copy reads straight into the output buffer
+    auto file = fd_stream::open(source, fd_stream::buffer_alignment);
+#else
+    auto file = file_stream::open(source);
+#endif
+    if (!file) {
+        return std::unexpected(file.error());
+    }
+    if (file->size() != *data_size) {
+        return std::unexpected(error{error_code::invalid_operation, "Source file size does not match the entry size"});
+    }
+
+    if (auto result = write_headers(meta, *data_size); !result) {
+        return result;
+    }
+
+#ifdef __linux__
+    if (*data_size > 0) {
+        // The kernel appends at the stream's position, so everything buffered goes first
+        if (auto flushed = flush_buffer(); !flushed) {
+            return flushed;
+        }
+        auto copied = output_->copy_from_file(file->native_handle(), 0, *data_size);
+        if (!copied) {
+            return std::unexpected(copied.error());
+        }
+        if (*copied) {
+            return write_padding(*data_size);
+        }
+    }
+#endif
+
+    if (auto result = write_from(*file, *data_size); !result) {
+        return result;
+    }
+    return write_padding(*data_size);
+}
+
+auto archive_writer::begin_stored(const file_metadata& meta) -> std::expected<uint64_t, error> {
+    auto stored_size = check_entry(meta, true);
+    if (!stored_size) {
+        return std::unexpected(stored_size.error());
+    }
+    if (!meta.sparse_info) {
+        if (auto result = write_headers(meta, *stored_size); !result) {
+            return std::unexpected(result.error());
+        }
+        return *stored_size;
+    }
+
+    // GNU sparse 1.0 map: segment count, then offset and size of each, one per line
+    std::string map = std::to_string(meta.sparse_info->segments.size()) + '\n';
+    for (const auto& segment : meta.sparse_info->segments) {
+        map += std::to_string(segment.offset) + '\n' + std::to_string(segment.size) + '\n';
+    }
+    const uint64_t map_size = (map.size() + detail::BLOCK_SIZE - 1) / detail::BLOCK_SIZE * detail::BLOCK_SIZE;
+    if (auto result = write_headers(meta, map_size + *stored_size); !result) {
+        return std::unexpected(result.error());
+    }
+    if (auto result = write_bytes(as_bytes(map)); !result) {
+        return std::unexpected(result.error());
+    }
+    if (auto result = write_padding(map.size()); !result) {
+        return std::unexpected(result.error());
+    }
+    return *stored_size;
+}
+
+auto archive_writer::add_stored(
+    const file_metadata& meta, const std::span<const std::byte> stored) -> std::expected<void, error> {
+    auto stored_size = check_entry(meta, true);
+    if (!stored_size) {
+        return std::unexpected(stored_size.error());
+    }
+    if (stored.size() != *stored_size) {
+        return std::unexpected(error{error_code::invalid_operation, "Stored data does not match the entry"});
+    }
+    if (auto begun = begin_stored(meta); !begun) {
+        return std::unexpected(begun.error());
+    }
+    if (auto result = write_bytes(stored); !result) {
+        return result;
+    }
+    return write_padding(stored.size());
+}
+
+auto archive_writer::add_stored(const file_metadata& meta, input_stream& source) -> std::expected<void, error> {
+    auto stored_size = begin_stored(meta);
+    if (!stored_size) {
+        return std::unexpected(stored_size.error());
+    }
+    if (auto result = write_from(source, *stored_size); !result) {
+        return result;
+    }
+    return write_padding(*stored_size);
+}
+
+#ifdef __linux__
+auto archive_writer::add_stored(
+    const file_metadata& meta, const int fd, const uint64_t offset) -> std::expected<void, error> {
+    auto stored_size = begin_stored(meta);
+    if (!stored_size) {
+        return std::unexpected(stored_size.error());
+    }
+
+    if (*stored_size > 0) {
+        if (auto flushed = flush_buffer(); !flushed) {
+            return flushed;
+        }
+        auto copied = output_->copy_from_file(fd, offset, *stored_size);
+        if (!copied) {
+            return std::unexpected(copied.error());
+        }
+        if (*copied) {
+            return write_padding(*stored_size);
+        }
+    }
+
+    // The output cannot take a kernel copy, read through the buffer
+    uint64_t done = 0;
+    while (done < *stored_size) {
+        if (buffered_ == buffer_.size()) {
+            if (auto flushed = flush_buffer(); !flushed) {
+                return flushed;
+            }
+        }
+        const size_t chunk = static_cast<size_t>(std::min<uint64_t>(*stored_size - done, buffer_.size() - buffered_));
+        const ssize_t n = ::pread(fd, buffer_.data() + buffered_, chunk, static_cast<off_t>(offset + done));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return std::unexpected(error{error_code::io_error, "Failed to read stored data", errno});
+        }
+        if (n == 0) {
+            return std::unexpected(error{error_code::io_error, "Source ended before the entry size was reached"});
+        }
+        buffered_ += static_cast<size_t>(n);
+        done += static_cast<uint64_t>(n);
+    }
+    return write_padding(*stored_size);
+}
+#endif
+
+auto archive_writer::update_file(
+    const archive_index& index,
+    const file_metadata& meta,
+    const std::filesystem::path& source) -> std::expected<bool, error> {
+    if (!index.supersedes(meta)) {
+        return false;
+    }
+    if (auto added = add_file(meta, source); !added) {
+        return std::unexpected(added.error());
+    }
+    return true;
+}
+
+auto archive_writer::write_headers(const file_metadata& meta, const uint64_t data_size) -> std::expected<void, error> {
+    ustar_header header{};
+    std::string records;
+
+    std::string path = meta.path.generic_string();
+    if (meta.is_directory() && !path.ends_with('/')) {
+        path += '/';
+    }
+
+    if (meta.sparse_info) {
+        // GNU sparse 1.0: tars that know nothing of it extract the map and
+        // segments as a file under a stand-in name, the records give the real one
+        append_pax_record(records, "GNU.sparse.major", "1");
+        append_pax_record(records, "GNU.sparse.minor", "0");
+        append_pax_record(records, "GNU.sparse.name", path);
+        append_pax_record(records, "GNU.sparse.realsize", std::to_string(meta.sparse_info->real_size));
+        append_pax_record(records, "path", path);
+        const auto parent = meta.path.parent_path().generic_string();
+        const std::string stand_in = (parent.empty() ? "" : parent + '/') +
+            "GNUSparseFile.0/" + meta.path.filename().string();
+        std::string_view prefix;
+        std::string_view name;
+        if (options_.long_names == long_name_format::pax && split_ustar_path(stand_in, prefix, name)) {
+            put_string(header.prefix, prefix);
+            put_string(header.name, name);
+        } else {
+            put_string(header.name, stand_in);
+        }
+    } else if (options_.long_names == long_name_format::gnu) {
+        if (path.size() > sizeof(header.name)) {
+            if (auto result = write_extension(std::to_underlying(entry_type::gnu_longname), "././@LongLink",
+                                              as_bytes(path + '\0')); !result) {
+                return result;
+            }
+        }
+        put_string(header.name, path);
+    } else {
+        std::string_view prefix;
+        std::string_view name;
+        if (split_ustar_path(path, prefix, name)) {
+            put_string(header.prefix, prefix);
+            put_string(header.name, name);
+        } else {
+            append_pax_record(records, "path", path);
+            put_string(header.name, path);
+        }
+    }
+
+    if (meta.link_target) {
+        const std::string& target = *meta.link_target;
+        if (target.size() > sizeof(header.linkname)) {
+            if (options_.long_names == long_name_format::gnu) {
+                if (auto result = write_extension(std::to_underlying(entry_type::gnu_longlink), "././@LongLink",
+                                                  as_bytes(target + '\0')); !result) {
+                    return result;
+                }
+            } else {
+                append_pax_record(records, "linkpath", target);
+            }
+        }
+        put_string(header.linkname, target);
+    }
+
+    put_octal(header.mode, static_cast<uint64_t>(meta.permissions) & 07777);
+
+    const auto put_number = [&records](auto& field, const uint64_t value, const std::string_view key) {
+        if (fits_octal(field, value)) {
+            put_octal(field, value);
+        } else {
+            append_pax_record(records, key, std::to_string(value));
+            put_octal(field, 0);
+        }
+    };
+    put_number(header.uid, meta.owner_id, "uid");
+    put_number(header.gid, meta.group_id, "gid");
+    put_number(header.size, data_size, "size");
+
+    const auto mtime = std::chrono::duration_cast<std::chrono::seconds>(
+        meta.modification_time.time_since_epoch()).count();
+    if (mtime < 0) {
+        append_pax_record(records, "mtime", std::to_string(mtime));
+        put_octal(header.mtime, 0);
+    } else {
+        put_number(header.mtime, static_cast<uint64_t>(mtime), "mtime");
+    }
+
+    if (meta.owner_name.size() > sizeof(header.uname)) {
+        append_pax_record(records, "uname", meta.owner_name);
+    }
+    if (meta.group_name.size() > sizeof(header.gname)) {
+        append_pax_record(records, "gname", meta.group_name);
+    }
+    put_string(header.uname, meta.owner_name);
+    put_string(header.gname, meta.group_name);
+
+    if (meta.is_device()) {
+        put_number(header.devmajor, meta.device_major, "SCHILY.devmajor");
+        put_number(header.devminor, meta.device_minor, "SCHILY.devminor");
+    }
+
+    for (const auto& [name, value] : meta.xattrs) {
+        append_pax_record(records, "SCHILY.xattr." + name, value);
+    }
+    if (!meta.access_acl.empty()) {
+        append_pax_record(records, "SCHILY.acl.access", format_acl(meta.access_acl));
+    }
+    if (!meta.default_acl.empty()) {
+        append_pax_record(records, "SCHILY.acl.default", format_acl(meta.default_acl));
+    }
+
+    header.typeflag = meta.type == entry_type::regular_file_old ?
+        std::to_underlying(entry_type::regular_file) : std::to_underlying(meta.type);
+
+    if (!records.empty()) {
+        const std::string pax_name = "PaxHeaders/" + meta.path.filename().string();
+        if (auto result = write_extension(std::to_underlying(entry_type::pax_extended_header), pax_name,
+                                          as_bytes(records)); !result) {
+            return result;
+        }
+    }
+
+    seal_header(header, options_.long_names);
+    return write_bytes(as_bytes(header));
+}
+
+auto archive_writer::write_extension(
+    const char type, const std::string& name, const std::span<const std::byte> payload) -> std::expected<void, error> {
+    ustar_header header{};
+    put_string(header.name, name);
+    put_octal(header.mode, 0644);
+    put_octal(header.uid, 0);
+    put_octal(header.gid, 0);
+    put_octal(header.size, payload.size());
+    put_octal(header.mtime, 0);
+    header.typeflag = type;
+    seal_header(header, options_.long_names);
+
+    if (auto result = write_bytes(as_bytes(header)); !result) {
+        return result;
+    }
+    if (auto result = write_bytes(payload); !result) {
+        return result;
+    }
+    return write_padding(payload.size());
+}
+
+auto archive_writer::write_bytes(std::span<const std::byte> data) -> std::expected<void, error> {
+    if (data.size() >= buffer_.size()) {
+        if (auto flushed = flush_buffer(); !flushed) {
+            return flushed;
+        }
+        return output_->write(data);
+    }
+
+    while (!data.empty()) {
+        const size_t chunk = std::min(data.size(), buffer_.size() - buffered_);
+        std::memcpy(buffer_.data() + buffered_, data.data(), chunk);
+        buffered_ += chunk;
+        data = data.subspan(chunk);
+        if (buffered_ == buffer_.size()) {
+            if (auto flushed = flush_buffer(); !flushed) {
+                return flushed;
+            }
+        }
+    }
+    return {};
+}
+
+auto archive_writer::write_from(input_stream& source, const uint64_t size) -> std::expected<void, error> {
+    uint64_t remaining = size;
+    while (remaining > 0) {
+        if (buffered_ == buffer_.size()) {
+            if (auto flushed = flush_buffer(); !flushed) {
+                return flushed;
+            }
+        }
+        const size_t chunk = static_cast<size_t>(std::min<uint64_t>(remaining, buffer_.size() - buffered_));
+        auto read = source.read(std::span{buffer_.data() + buffered_, chunk});
+        if (!read) {
+            return std::unexpected(read.error());
+        }
+        if (*read == 0) {
+            return std::unexpected(error{error_code::io_error, "Source ended before the entry size was reached"});
+        }
+        buffered_ += *read;
+        remaining -= *read;
+    }
+    return {};
+}
+
+auto archive_writer::write_padding(const uint64_t data_size) -> std::expected<void, error> {
+    const size_t padding = static_cast<size_t>((detail::BLOCK_SIZE - data_size % detail::BLOCK_SIZE) % detail::BLOCK_SIZE);
+    return write_bytes(std::span{zero_blocks.data(), padding});
+}
+
+auto archive_writer::flush_buffer() -> std::expected<void, error> {
+    if (buffered_ == 0) {
+        return {};
+    }
+    auto result = output_->write(std::span{buffer_.data(), buffered_});
+    buffered_ = 0;
+    return result;
+}
+
+auto archive_writer::finish() -> std::expected<void, error> {
+    if (finished_) {
+        return {};
+    }
+    if (auto result = write_bytes(zero_blocks); !result) {
+        return result;
+    }
+    if (auto result = flush_buffer(); !result) {
+        return result;
+    }
+    finished_ = true;
+    return output_->flush();
+}
+
+} // namespace tierone::tar
@@ -0,0 +1,286 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <tierone/tar/async_archive_reader.hpp>
+#include <tierone/tar/header_parser.hpp>
+#include <tierone/tar/pax_parser.hpp>
+#include <tierone/tar/sparse.hpp>
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace tierone::tar {
+
+namespace {
+
+// Bytes requested from the source per read, and the most read_data() buffers
+constexpr size_t read_chunk = 64 * 1024;
+constexpr size_t max_data_chunk = 1024 * 1024;
+
+// Bytes from the start of data needed before archive_reader can parse the
+// next entry without running dry: all extension headers and their payloads,
+// the entry header, old GNU sparse extension blocks and any sparse 1.0 map
+// A result larger than data.size() means more bytes must arrive first.
+auto header_chain_size(std::span<const std::byte> data) -> size_t {
+    size_t offset = 0;
+    bool sparse_map = false;
+    pax::extended_header records;
+    while (true) {
+        if (data.size() < offset + detail::BLOCK_SIZE) {
+            return offset + detail::BLOCK_SIZE;
+        }
+        const auto block = data.subspan(offset).first<detail::BLOCK_SIZE>();
+        if (detail::is_zero_block(block)) {
+            return offset + 2 * detail::BLOCK_SIZE;
+        }
+        auto meta = detail::parse_header(block);
+        if (!meta) {
+            return offset + detail::BLOCK_SIZE;  // archive_reader reports the error
+        }
+        offset += detail::BLOCK_SIZE;
+        const uint64_t padded = (meta->size + detail::BLOCK_SIZE - 1) / detail::BLOCK_SIZE * detail::BLOCK_SIZE;
+
+        switch (meta->type) {
+            case entry_type::pax_extended_header: {
+                if (data.size() < offset + padded) {
+                    return offset + padded;
+                }
+                // Only the last PAX header applies to the entry
+                sparse_map = pax::parse_records(data.subspan(offset, meta->size), records) &&
+                             records.gnu_sparse && records.sparse_major == 1 && records.sparse_minor == 0;
+                offset += padded;
+                break;
+            }
+            case entry_type::pax_global_header:
+            case entry_type::gnu_longname:
+            case entry_type::gnu_longlink:
+            case entry_type::gnu_volhdr:
+            case entry_type::gnu_multivol:
+                offset += padded;
+                break;
+            default: {
+                // Extension blocks follow an old GNU sparse header until one
+                // clears its extended flag
+                bool extended = sparse::old_map_continues(block);
+                while (extended) {
+                    if (data.size() < offset + detail::BLOCK_SIZE) {
+                        return offset + detail::BLOCK_SIZE;
+                    }
+                    extended = sparse::extension_continues(data.subspan(offset).first<detail::BLOCK_SIZE>());
+                    offset += detail::BLOCK_SIZE;
+                }
+                if (!sparse_map) {
+                    return offset;
+                }
+                
+                // A sparse 1.0 map spans as many blocks as it takes to end,
+                // its segments are checked by archive_reader
+                sparse::map_parser map{nullptr, UINT64_MAX};
+                while (true) {
+                    if (data.size() < offset + detail::BLOCK_SIZE) {
+                        return offset + detail::BLOCK_SIZE;
+                    }
+                    auto done = map.feed(data.subspan(offset, detail::BLOCK_SIZE));
+                    offset += detail::BLOCK_SIZE;
+                    if (!done || *done) {
+                        return offset;  // archive_reader reports a bad map
+                    }
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+// Buffered bytes of the async source, presented to archive_reader as a stream
+// Reads never block: they return what is buffered, 0 once it runs dry. A skip
+// past the buffered bytes is recorded as debt, paid by discarding the bytes
+// as fill() receives them.
+class async_archive_reader::window : public input_stream {
+public:
+    std::vector<std::byte> buffer;
+    size_t begin = 0;
+    size_t end = 0;
+    uint64_t debt = 0;
+    bool source_done = false;
+
+    [[nodiscard]] size_t available() const noexcept { return end - begin; }
+
+    [[nodiscard]] std::expected<size_t, error> read(std::span<std::byte> out) override {
+        const size_t count = std::min(out.size(), available());
+        if (count > 0) {
+            std::memcpy(out.data(), buffer.data() + begin, count);
+            begin += count;
+        }
+        return count;
+    }
+
+    [[nodiscard]] std::expected<void, error> skip(uint64_t bytes) override {
+        const size_t dropped = static_cast<size_t>(std::min<uint64_t>(bytes, available()));
+        begin += dropped;
+        debt += bytes - dropped;
+        return {};
+    }
+
+    [[nodiscard]] bool at_end() const override { return source_done && available() == 0; }
+
+    [[nodiscard]] bool can_peek() const override { return true; }
+
+    [[nodiscard]] std::expected<std::span<const std::byte>, error> peek(size_t bytes) override {
+        return std::span<const std::byte>{buffer.data() + begin, std::min(bytes, available())};
+    }
+};
+
+async_archive_reader::async_archive_reader(std::unique_ptr<async_input_stream> source)
+    : async_archive_reader(std::move(source), std::make_unique<window>()) {}
+
+async_archive_reader::async_archive_reader(std::unique_ptr<async_input_stream> source, std::unique_ptr<window> buffer)
+    : source_(std::move(source)), window_(buffer.get()), reader_(std::move(buffer)) {}
+
+async_archive_reader::~async_archive_reader() = default;
+
+auto async_archive_reader::fill(const size_t bytes) -> task<std::expected<void, error>> {
+    auto& w = *window_;
+    if (w.buffer.size() < read_chunk) {
+        w.buffer.resize(read_chunk);
+    }
+
+    // Discard skipped bytes first, the window is empty while there is debt
+    while (w.debt > 0) {
+        if (w.source_done) {
+            co_return std::unexpected(error{error_code::corrupt_archive, "Archive ends inside skipped entry data"});
+        }
+        w.begin = w.end = 0;
+        const size_t want = static_cast<size_t>(std::min<uint64_t>(w.debt, w.buffer.size()));
+        auto result = co_await source_->read(std::span{w.buffer.data(), want});
+        if (!result) {
+            co_return std::unexpected(result.error());
+        }
+        if (*result == 0) {
+            w.source_done = true;
+        }
+        w.debt -= *result;
+    }
+
+    while (w.available() < bytes && !w.source_done) {
+        if (w.begin > 0) {
+            std::memmove(w.buffer.data(), w.buffer.data() + w.begin, w.available());
+            w.end -= w.begin;
+            w.begin = 0;
+        }
+        if (w.buffer.size() - w.end < read_chunk) {
+            w.buffer.resize(std::max(w.end + read_chunk, bytes));
+        }
+        auto result = co_await source_->read(std::span{w.buffer.data() + w.end, w.buffer.size() - w.end});
+        if (!result) {
+            co_return std::unexpected(result.error());
+        }
+        if (*result == 0) {
+            w.source_done = true;
+        }
+        w.end += *result;
+    }
+    co_return std::expected<void, error>{};
+}
+
+auto async_archive_reader::next_entry() -> task<std::expected<std::optional<archive_entry>, error>> {
+    if (reader_.finished_) {
+        co_return std::optional<archive_entry>{};
+    }
+
+    // Unread data becomes debt, paid by the first fill below
+    if (auto skip_result = reader_.skip_current_entry_data(); !skip_result) {
+        co_return std::unexpected(skip_result.error());
+    }
+
+    while (true) {
+        const auto buffered = std::span<const std::byte>{window_->buffer.data() + window_->begin, window_->available()};
+        const size_t needed = window_->debt > 0 ? detail::BLOCK_SIZE : header_chain_size(buffered);
+        if (window_->debt == 0 && (needed <= buffered.size() || window_->source_done)) {
+            break;
+        }
+        if (auto filled = co_await fill(needed); !filled) {
+            co_return std::unexpected(filled.error());
+        }
+    }
+
+    data_offset_ = 0;
+    auto entry = reader_.next_entry();
+    if (entry) {
+        current_ = *entry;
+    } else {
+        current_.reset();
+    }
+    co_return entry;
+}
+
+auto async_archive_reader::read_data(std::span<std::byte> buffer) -> task<std::expected<size_t, error>> {
+    if (!current_) {
+        co_return std::unexpected(error{error_code::invalid_operation, "No current entry"});
+    }
+    const auto& entry = *current_;
+    if (data_offset_ >= entry.size() || buffer.empty()) {
+        co_return size_t{0};
+    }
+    const size_t length = static_cast<size_t>(std::min<uint64_t>({buffer.size(), entry.size() - data_offset_, max_data_chunk}));
+
+    // Stored bytes behind the logical range, holes of sparse entries need none
+    uint64_t stored_end = data_offset_ + length;
+    if (const auto& sparse = entry.metadata().sparse_info) {
+        stored_end = 0;
+        const uint64_t range_end = data_offset_ + length;
+        for (size_t i = sparse->lower_segment(data_offset_); i < sparse->segments.size(); ++i) {
+            const auto& segment = sparse->segments[i];
+            if (segment.offset >= range_end) {
+                break;
+            }
+            stored_end = sparse->data_offset_of(i) + std::min(segment.offset + segment.size, range_end) - segment.offset;
+        }
+    }
+    const uint64_t consumed = reader_.current_entry_data_consumed_;
+    if (stored_end > consumed) {
+        if (auto filled = co_await fill(static_cast<size_t>(stored_end - consumed)); !filled) {
+            co_return std::unexpected(filled.error());
+        }
+    }
+
+    auto result = entry.read_into(static_cast<size_t>(data_offset_), buffer.first(length));
+    if (!result) {
+        co_return std::unexpected(result.error());
+    }
+    if (*result == 0) {
+        co_return std::unexpected(error{error_code::corrupt_archive, "Archive ends inside entry data"});
+    }
+    data_offset_ += *result;
+    co_return *result;
+}
+
+auto async_archive_reader::entries() -> async_generator<std::expected<archive_entry, error>> {
+    while (true) {
+        auto entry = co_await next_entry();
+        if (!entry) {
+            co_yield std::unexpected(entry.error());
+            co_return;
+        }
+        if (!*entry) {
+            co_return;
+        }
+        co_yield std::move(**entry);
+    }
+}
+
+} // namespace tierone::tar
@@ -0,0 +1,255 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <tierone/tar/batch.hpp>
+#include <tierone/tar/archive_reader.hpp>
+#include <tierone/tar/decompress.hpp>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <optional>
+#include <semaphore>
+#include <thread>
+
+namespace tierone::tar {
+
+namespace {
+
+// Slots for stream reads, shared by the workers of one batch
+class io_gate {
+private:
+    std::optional<std::counting_semaphore<>> slots_;
+
+public:
+    explicit io_gate(const unsigned limit) {
+        if (limit > 0) {
+            slots_.emplace(static_cast<std::ptrdiff_t>(limit));
+        }
+    }
+
+    template<typename Op>
+    auto operator()(Op op) {
+        if (!slots_) {
+            return op();
+        }
+        slots_->acquire();
+        auto result = op();
+        slots_->release();
+        return result;
+    }
+};
+
+// Sequential source stream, reading through the gate
+class gated_input final : public input_stream {
+private:
+    std::unique_ptr<input_stream> inner_;
+    io_gate& gate_;
+
+public:
+    gated_input(std::unique_ptr<input_stream> inner, io_gate& gate) : inner_(std::move(inner)), gate_(gate) {}
+
+    [[nodiscard]] std::expected<size_t, error> read(const std::span<std::byte> buffer) override {
+        return gate_([&] { return inner_->read(buffer); });
+    }
+    [[nodiscard]] std::expected<void, error> skip(const uint64_t bytes) override {
+        return gate_([&] { return inner_->skip(bytes); });
+    }
+    [[nodiscard]] bool at_end() const override { return inner_->at_end(); }
+    [[nodiscard]] bool can_peek() const override { return inner_->can_peek(); }
+    [[nodiscard]] std::expected<std::span<const std::byte>, error> peek(const size_t bytes) override {
+        return gate_([&] { return inner_->peek(bytes); });
+    }
+};
+
+// Random access stream, either a source or the worker's own fd_stream,
+// reading through the gate
+class gated_random_access final : public random_access_stream {
+private:
+    random_access_stream& inner_;
+    std::unique_ptr<input_stream> owned_;  // Null when the worker keeps inner_
+    io_gate& gate_;
+
+public:
+    gated_random_access(random_access_stream& inner, std::unique_ptr<input_stream> owned, io_gate& gate)
+        : inner_(inner), owned_(std::move(owned)), gate_(gate) {}
+
+    [[nodiscard]] std::expected<size_t, error> read(const std::span<std::byte> buffer) override {
+        return gate_([&] { return inner_.read(buffer); });
+    }
+    [[nodiscard]] std::expected<void, error> skip(const uint64_t bytes) override {
+        return gate_([&] { return inner_.skip(bytes); });
+    }
+    [[nodiscard]] bool at_end() const override { return inner_.at_end(); }
+    [[nodiscard]] bool can_peek() const override { return inner_.can_peek(); }
+    [[nodiscard]] std::expected<std::span<const std::byte>, error> peek(const size_t bytes) override {
+        return gate_([&] { return inner_.peek(bytes); });
+    }
+    [[nodiscard]] std::expected<void, error> seek(const uint64_t position) override {
+        return gate_([&] { return inner_.seek(position); });
+    }
+    [[nodiscard]] uint64_t position() const override { return inner_.position(); }
+    [[nodiscard]] std::optional<uint64_t> size() const override { return inner_.size(); }
+    [[nodiscard]] std::optional<std::span<const std::byte>> mapped_data() const override {
+        return inner_.mapped_data();
+    }
+    void will_need(const uint64_t offset, const uint64_t length) override { inner_.will_need(offset, length); }
+};
+
+// What one worker keeps from archive to archive
+class worker {
+private:
+    io_gate& gate_;
+    // The reader rests on an empty stream between archives, so nothing of
+    // the last archive's stream chain outlives it
+    std::unique_ptr<input_stream> idle_ = std::make_unique<memory_mapped_stream>(std::span<const std::byte>{});
+    archive_reader reader_{std::make_unique<memory_mapped_stream>(std::span<const std::byte>{})};
+#ifdef __linux__
+    std::optional<fd_stream> file_;
+#endif
+
+    std::expected<std::unique_ptr<input_stream>, error> open_path(const std::filesystem::path& path) {
+#ifdef __linux__
+        if (file_) {
+            if (auto reopened = file_->reopen(path); reopened) {
+                return std::make_unique<gated_random_access>(*file_, nullptr, gate_);
+            } else if (reopened.error().code() != error_code::unsupported_feature) {
+                return std::unexpected(reopened.error());
+            }
+        } else if (auto opened = fd_stream::open(path)) {
+            file_.emplace(std::move(*opened));
+            return std::make_unique<gated_random_access>(*file_, nullptr, gate_);
+        } else if (opened.error().code() != error_code::unsupported_feature) {
+            return std::unexpected(opened.error());
+        }
+#endif
+        // Anything but a regular file goes through stdio
+        auto file = file_stream::open(path);
+        if (!file) {
+            return std::unexpected(file.error());
+        }
+        auto owned = std::make_unique<file_stream>(std::move(*file));
+        auto& stream = *owned;
+        return std::make_unique<gated_random_access>(stream, std::move(owned), gate_);
+    }
+
+    std::unique_ptr<input_stream> wrap(std::unique_ptr<input_stream> stream) {
+        if (auto* random = dynamic_cast<random_access_stream*>(stream.get())) {
+            return std::make_unique<gated_random_access>(*random, std::move(stream), gate_);
+        }
+        return std::make_unique<gated_input>(std::move(stream), gate_);
+    }
+
+    std::expected<void, error> read_archive(const size_t index, const batch_visitor& visit, uint64_t& entries) {
+        while (true) {
+            auto entry = reader_.next_entry();
+            if (!entry) {
+                return std::unexpected(entry.error());
+            }
+            if (!*entry) {
+                return {};
+            }
+            ++entries;
+            if (auto visited = visit(index, **entry); !visited) {
+                return std::unexpected(visited.error());
+            }
+        }
+    }
+
+public:
+    explicit worker(io_gate& gate) : gate_(gate) {}
+
+    // Read the whole of source, counting the entries delivered to visit
+    std::expected<void, error> run(
+        const size_t index, batch_source& source, const batch_visitor& visit, uint64_t& entries) {
+        auto stream = std::holds_alternative<std::filesystem::path>(source)
+            ? open_path(std::get<std::filesystem::path>(source))
+            : std::expected<std::unique_ptr<input_stream>, error>{
+                  wrap(std::move(std::get<std::unique_ptr<input_stream>>(source)))};
+        if (!stream) {
+            return std::unexpected(stream.error());
+        }
+        auto decompressed = open_decompressed(std::move(*stream));
+        if (!decompressed) {
+            return std::unexpected(decompressed.error());
+        }
+
+        idle_ = reader_.reset(std::move(*decompressed));
+        auto finished = read_archive(index, visit, entries);
+        reader_.reset(std::move(idle_));  // Closes the archive's streams
+        return finished;
+    }
+};
+
+} // anonymous namespace
+
+auto for_each_archive(
+    std::vector<batch_source> sources,
+    const batch_visitor& visit,
+    const batch_options& options,
+    const batch_completion& completed) -> batch_result {
+    const unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    io_gate gate{options.max_reads_in_flight};
+    std::atomic<size_t> next{0};
+    std::atomic<bool> stop{false};
+    std::mutex result_mutex;
+    batch_result result;
+
+    const auto work = [&] {
+        worker state{gate};
+        while (!stop.load(std::memory_order_relaxed)) {
+            const size_t index = next.fetch_add(1, std::memory_order_relaxed);
+            if (index >= sources.size()) {
+                return;
+            }
+            uint64_t entries = 0;
+            const auto finished = state.run(index, sources[index], visit, entries);
+            if (completed) {
+                completed(index, finished ? std::expected<uint64_t, error>{entries}
+                                          : std::expected<uint64_t, error>{std::unexpect, finished.error()});
+            }
+
+            const std::lock_guard lock{result_mutex};
+            result.entries += entries;
+            if (finished) {
+                ++result.archives;
+            } else {
+                result.failures.emplace_back(index, finished.error());
+                if (options.stop_on_error) {
+                    stop = true;
+                }
+            }
+        }
+    };
+
+    const size_t workers = std::min<size_t>(threads, sources.size());
+    if (workers <= 1) {
+        if (workers == 1) {
+            work();
+        }
+    } else {
+        std::vector<std::jthread> pool;
+        pool.reserve(workers);
+        for (size_t i = 0; i < workers; ++i) {
+            pool.emplace_back(work);
+        }
+    }
+
+    std::ranges::sort(result.failures, {}, &std::pair<size_t, error>::first);
+    return result;
+}
+
+} // namespace tierone::tar
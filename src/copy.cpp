@@ -0,0 +1,248 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <tierone/tar/copy.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace tierone::tar {
+
+namespace {
+
+// Alignment of copy buffers, enough for O_DIRECT on common devices
+constexpr size_t buffer_alignment = 4096;
+
+struct aligned_delete {
+    void operator()(std::byte* data) const noexcept {
+        ::operator delete[](data, std::align_val_t{buffer_alignment});
+    }
+};
+
+using aligned_buffer = std::unique_ptr<std::byte[], aligned_delete>;
+
+auto make_buffer(const size_t size) -> aligned_buffer {
+    return aligned_buffer{static_cast<std::byte*>(::operator new[](size, std::align_val_t{buffer_alignment}))};
+}
+
+// Buffer indices cycling between the reading and the writing thread
+class buffer_ring {
+private:
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    std::deque<size_t> free_;
+    std::deque<std::pair<size_t, size_t>> filled_;  // Index and bytes held
+    bool closed_ = false;
+    std::optional<error> error_;
+
+public:
+    explicit buffer_ring(const size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            free_.push_back(i);
+        }
+    }
+
+    // An empty buffer to read into, std::nullopt once the copy failed
+    [[nodiscard]] std::optional<size_t> acquire() {
+        std::unique_lock lock{mutex_};
+        changed_.wait(lock, [&] { return !free_.empty() || error_; });
+        if (error_) {
+            return std::nullopt;
+        }
+        const size_t index = free_.front();
+        free_.pop_front();
+        return index;
+    }
+
+    void submit(const size_t index, const size_t bytes) {
+        std::lock_guard lock{mutex_};
+        filled_.emplace_back(index, bytes);
+        changed_.notify_all();
+    }
+
+    // The next buffer to write, std::nullopt once all are written or the copy failed
+    [[nodiscard]] std::optional<std::pair<size_t, size_t>> next() {
+        std::unique_lock lock{mutex_};
+        changed_.wait(lock, [&] { return !filled_.empty() || closed_ || error_; });
+        if (error_ || filled_.empty()) {
+            return std::nullopt;
+        }
+        const auto filled = filled_.front();
+        filled_.pop_front();
+        return filled;
+    }
+
+    void release(const size_t index) {
+        std::lock_guard lock{mutex_};
+        free_.push_back(index);
+        changed_.notify_all();
+    }
+
+    void close() {
+        std::lock_guard lock{mutex_};
+        closed_ = true;
+        changed_.notify_all();
+    }
+
+    void fail(error err) {
+        std::lock_guard lock{mutex_};
+        if (!error_) {
+            error_ = std::move(err);
+        }
+        changed_.notify_all();
+    }
+
+    [[nodiscard]] std::optional<error> failure() {
+        std::lock_guard lock{mutex_};
+        return error_;
+    }
+};
+
+// Read exactly buffer.size() bytes of entry data starting at offset
+auto fill(const archive_entry& entry, const std::span<std::byte> buffer, const uint64_t offset)
+    -> std::expected<size_t, error> {
+    size_t filled = 0;
+    while (filled < buffer.size()) {
+        auto result = entry.read_into(static_cast<size_t>(offset + filled), buffer.subspan(filled));
+        if (!result) {
+            return std::unexpected(result.error());
+        }
+        if (*result == 0) {
+            return std::unexpected(error{error_code::corrupt_archive, "Archive ends inside entry data"});
+        }
+        filled += *result;
+    }
+    return filled;
+}
+
+} // anonymous namespace
+
+auto copy_entry(
+    const archive_entry& entry,
+    output_stream& output,
+    const copy_options& options) -> std::expected<uint64_t, error> {
+    if (!entry.is_regular_file()) {
+        return std::unexpected(error{error_code::invalid_operation, "Entry is not a regular file"});
+    }
+    const uint64_t size = entry.size();
+    const size_t chunk_size = std::max<size_t>(options.chunk_size, 1);
+
+    const auto deliver = [&](const std::span<const std::byte> data) -> std::expected<void, error> {
+        if (auto written = output.write(data); !written) {
+            return written;
+        }
+        if (options.observer) {
+            options.observer(data);
+        }
+        return {};
+    };
+
+    // Mapped data needs no reading: write it where it lies, holes as zeros
+    if (entry.is_mapped()) {
+        auto runs = entry.open_sparse_runs();
+        if (!runs) {
+            return std::unexpected(runs.error());
+        }
+        std::vector<std::byte> zeros;
+        while (true) {
+            auto run = runs->next_run();
+            if (!run) {
+                return std::unexpected(run.error());
+            }
+            if (!*run) {
+                return size;
+            }
+            if ((*run)->is_hole() && zeros.empty()) {
+                zeros.resize(static_cast<size_t>(std::min<uint64_t>(chunk_size, (*run)->length)));
+            }
+            for (uint64_t done = 0; done < (*run)->length;) {
+                const size_t length = static_cast<size_t>(std::min<uint64_t>(chunk_size, (*run)->length - done));
+                const auto data = (*run)->is_hole() ?
+                    std::span<const std::byte>{zeros}.first(std::min(length, zeros.size())) :
+                    (*run)->data.subspan(static_cast<size_t>(done), length);
+                if (auto delivered = deliver(data); !delivered) {
+                    return std::unexpected(delivered.error());
+                }
+                done += data.size();
+            }
+        }
+    }
+
+    // One chunk or less, nothing to overlap
+    if (size <= chunk_size) {
+        auto buffer = make_buffer(static_cast<size_t>(std::max<uint64_t>(size, 1)));
+        const std::span<std::byte> data{buffer.get(), static_cast<size_t>(size)};
+        if (auto filled = fill(entry, data, 0); !filled) {
+            return std::unexpected(filled.error());
+        }
+        if (auto delivered = deliver(data); !delivered) {
+            return std::unexpected(delivered.error());
+        }
+        return size;
+    }
+
+    // Read on this thread, write on another, one buffer ahead or more
+    std::vector<aligned_buffer> buffers;
+    buffers.reserve(std::max<size_t>(options.buffers, 2));
+    while (buffers.size() < buffers.capacity()) {
+        buffers.push_back(make_buffer(chunk_size));
+    }
+    buffer_ring ring{buffers.size()};
+
+    {
+        std::jthread writer{[&] {
+            while (auto filled = ring.next()) {
+                const auto [index, bytes] = *filled;
+                if (auto delivered = deliver({buffers[index].get(), bytes}); !delivered) {
+                    ring.fail(std::move(delivered.error()));
+                    return;
+                }
+                ring.release(index);
+            }
+        }};
+
+        for (uint64_t offset = 0; offset < size;) {
+            const auto index = ring.acquire();
+            if (!index) {
+                break;
+            }
+            const size_t length = static_cast<size_t>(std::min<uint64_t>(chunk_size, size - offset));
+            auto filled = fill(entry, {buffers[*index].get(), length}, offset);
+            if (!filled) {
+                ring.fail(std::move(filled.error()));
+                break;
+            }
+            ring.submit(*index, *filled);
+            offset += *filled;
+        }
+        ring.close();
+    }  // The writer drains the ring and joins here
+
+    if (auto failure = ring.failure()) {
+        return std::unexpected(std::move(*failure));
+    }
+    return size;
+}
+
+} // namespace tierone::tar
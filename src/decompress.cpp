@@ -0,0 +1,935 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <tierone/tar/decompress.hpp>
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+
+#ifdef TIERONE_TAR_HAVE_ZLIB
+#define ZLIB_CONST
+#include <zlib.h>
+#endif
+#ifdef TIERONE_TAR_HAVE_ZSTD
+#include <zstd.h>
+#endif
+#ifdef TIERONE_TAR_HAVE_LZMA
+#include <lzma.h>
+#endif
+
+namespace tierone::tar {
+
+// One decoding step of a compression library
+struct decompress_stream::codec {
+    struct step_result {
+        size_t consumed = 0;
+        size_t produced = 0;
+        bool stream_end = false;  // The current member, frame or stream is complete
+    };
+
+    virtual ~codec() = default;
+
+    // Decode from input into output, input_done once the source has no more data
+    [[nodiscard]] virtual std::expected<step_result, error> step(
+        std::span<const std::byte> input, std::span<std::byte> output, bool input_done) = 0;
+
+    // Prepare to decode another member that starts with input
+    // Returns false if input does not start one, which ends the stream
+    [[nodiscard]] virtual bool next_member(std::span<const std::byte> input) = 0;
+};
+
+namespace {
+
+constexpr std::array<std::byte, 2> gzip_magic{std::byte{0x1f}, std::byte{0x8b}};
+constexpr std::array<std::byte, 4> zstd_magic{std::byte{0x28}, std::byte{0xb5}, std::byte{0x2f}, std::byte{0xfd}};
+constexpr std::array<std::byte, 6> xz_magic{
+    std::byte{0xfd}, std::byte{'7'}, std::byte{'z'}, std::byte{'X'}, std::byte{'Z'}, std::byte{0x00}};
+
+template<size_t N>
+bool starts_with(const std::span<const std::byte> data, const std::array<std::byte, N>& magic) {
+    return data.size() >= N && std::equal(magic.begin(), magic.end(), data.begin());
+}
+
+// Library calls take unsigned int counts, larger spans are fed in slices
+constexpr size_t max_step = UINT_MAX;
+
+#ifdef TIERONE_TAR_HAVE_ZLIB
+class gzip_codec final : public decompress_stream::codec {
+    z_stream stream_{};
+
+public:
+    gzip_codec() = default;
+    gzip_codec(const gzip_codec&) = delete;
+    gzip_codec& operator=(const gzip_codec&) = delete;
+
+    [[nodiscard]] bool init() {
+        // 15 window bits plus 16 accepts gzip headers only
+        return inflateInit2(&stream_, 15 + 16) == Z_OK;
+    }
+
+    ~gzip_codec() override { inflateEnd(&stream_); }
+
+    std::expected<step_result, error> step(
+        std::span<const std::byte> input, std::span<std::byte> output, bool) override {
+        stream_.next_in = reinterpret_cast<const Bytef*>(input.data());
+        stream_.avail_in = static_cast<uInt>(std::min(input.size(), max_step));
+        stream_.next_out = reinterpret_cast<Bytef*>(output.data());
+        stream_.avail_out = static_cast<uInt>(std::min(output.size(), max_step));
+        const uInt avail_in = stream_.avail_in;
+        const uInt avail_out = stream_.avail_out;
+
+        const int status = inflate(&stream_, Z_NO_FLUSH);
+        if (status != Z_OK && status != Z_STREAM_END && status != Z_BUF_ERROR) {
+            return std::unexpected(error{error_code::corrupt_archive,
+                std::string{"gzip decompression failed: "} + (stream_.msg ? stream_.msg : "invalid data")});
+        }
+        return step_result{avail_in - stream_.avail_in, avail_out - stream_.avail_out, status == Z_STREAM_END};
+    }
+
+    bool next_member(std::span<const std::byte> input) override {
+        // Anything but another member, such as zero padding, ends the stream like gzip -d does
+        return starts_with(input, gzip_magic) && inflateReset(&stream_) == Z_OK;
+    }
+};
+#endif
+
+#ifdef TIERONE_TAR_HAVE_ZSTD
+class zstd_codec final : public decompress_stream::codec {
+    ZSTD_DStream* stream_ = ZSTD_createDStream();
+
+public:
+    zstd_codec() = default;
+    zstd_codec(const zstd_codec&) = delete;
+    zstd_codec& operator=(const zstd_codec&) = delete;
+
+    [[nodiscard]] bool init() {
+        return stream_ && !ZSTD_isError(ZSTD_initDStream(stream_));
+    }
+
+    ~zstd_codec() override { ZSTD_freeDStream(stream_); }
+
+    std::expected<step_result, error> step(
+        std::span<const std::byte> input, std::span<std::byte> output, bool) override {
+        ZSTD_inBuffer in{input.data(), input.size(), 0};
+        ZSTD_outBuffer out{output.data(), output.size(), 0};
+        const size_t status = ZSTD_decompressStream(stream_, &out, &in);
+        if (ZSTD_isError(status)) {
+            return std::unexpected(error{error_code::corrupt_archive,
+                std::string{"zstd decompression failed: "} + ZSTD_getErrorName(status)});
+        }
+        return step_result{in.pos, out.pos, status == 0};
+    }
+
+    bool next_member(std::span<const std::byte> input) override {
+        // The decoder moves on to the next frame by itself
+        return !input.empty();
+    }
+};
+#endif
+
+#ifdef TIERONE_TAR_HAVE_LZMA
+class xz_codec final : public decompress_stream::codec {
+    lzma_stream stream_ = LZMA_STREAM_INIT;
+
+public:
+    xz_codec() = default;
+    xz_codec(const xz_codec&) = delete;
+    xz_codec& operator=(const xz_codec&) = delete;
+
+    [[nodiscard]] bool init() {
+        // Concatenated streams and their padding are handled by liblzma
+        return lzma_stream_decoder(&stream_, UINT64_MAX, LZMA_CONCATENATED) == LZMA_OK;
+    }
+
+    ~xz_codec() override { lzma_end(&stream_); }
+
+    std::expected<step_result, error> step(
+        std::span<const std::byte> input, std::span<std::byte> output, bool input_done) override {
+        stream_.next_in = reinterpret_cast<const uint8_t*>(input.data());
+        stream_.avail_in = input.size();
+        stream_.next_out = reinterpret_cast<uint8_t*>(output.data());
+        stream_.avail_out = output.size();
+
+        const lzma_ret status = lzma_code(&stream_, input_done ? LZMA_FINISH : LZMA_RUN);
+        if (status != LZMA_OK && status != LZMA_STREAM_END && status != LZMA_BUF_ERROR) {
+            return std::unexpected(error{error_code::corrupt_archive,
+                "xz decompression failed with code " + std::to_string(static_cast<int>(status))});
+        }
+        return step_result{input.size() - stream_.avail_in, output.size() - stream_.avail_out,
+                           status == LZMA_STREAM_END};
+    }
+
+    bool next_member(std::span<const std::byte>) override {
+        // LZMA_CONCATENATED only reports the end once all input is consumed
+        return false;
+    }
+};
+#endif
+
+template<typename Codec>
+auto make_codec() -> std::expected<std::unique_ptr<decompress_stream::codec>, error> {
+    auto codec = std::make_unique<Codec>();
+    if (!codec->init()) {
+        return std::unexpected(error{error_code::io_error, "Failed to initialize decompressor"});
+    }
+    return codec;
+}
+
+} // anonymous namespace
+
+auto detect_compression(const std::span<const std::byte> head) noexcept -> compression_format {
+    if (starts_with(head, gzip_magic)) {
+        return compression_format::gzip;
+    }
+    if (starts_with(head, zstd_magic)) {
+        return compression_format::zstd;
+    }
+    if (starts_with(head, xz_magic)) {
+        return compression_format::xz;
+    }
+    return compression_format::none;
+}
+
+bool is_compression_supported(const compression_format format) noexcept {
+    switch (format) {
+        case compression_format::none:
+            return true;
+        case compression_format::gzip:
+#ifdef TIERONE_TAR_HAVE_ZLIB
+            return true;
+#else
+            return false;
+#endif
+        case compression_format::zstd:
+#ifdef TIERONE_TAR_HAVE_ZSTD
+            return true;
+#else
+            return false;
+#endif
+        case compression_format::xz:
+#ifdef TIERONE_TAR_HAVE_LZMA
+            return true;
+#else
+            return false;
+#endif
+        default:
+            return false;
+    }
+}
+
+decompress_stream::decompress_stream(
+    std::unique_ptr<input_stream> source, std::unique_ptr<codec> codec, const size_t buffer_size)
+    : source_(std::move(source)), codec_(std::move(codec)),
+      input_(std::max<size_t>(buffer_size, 4096)), scratch_(scratch_size) {}
+
+decompress_stream::decompress_stream(decompress_stream&& other) noexcept = default;
+auto decompress_stream::operator=(decompress_stream&& other) noexcept -> decompress_stream& = default;
+decompress_stream::~decompress_stream() = default;
+
+auto decompress_stream::create(
+    std::unique_ptr<input_stream> source,
+    const compression_format format,
+    const size_t buffer_size) -> std::expected<decompress_stream, error> {
+    if (!source) {
+        return std::unexpected(error{error_code::invalid_operation, "Null stream provided"});
+    }
+
+    std::expected<std::unique_ptr<codec>, error> created =
+        std::unexpected(error{error_code::unsupported_feature, "Compression format not supported by this build"});
+    switch (format) {
+#ifdef TIERONE_TAR_HAVE_ZLIB
+        case compression_format::gzip:
+            created = make_codec<gzip_codec>();
+            break;
+#endif
+#ifdef TIERONE_TAR_HAVE_ZSTD
+        case compression_format::zstd:
+            created = make_codec<zstd_codec>();
+            break;
+#endif
+#ifdef TIERONE_TAR_HAVE_LZMA
+        case compression_format::xz:
+            created = make_codec<xz_codec>();
+            break;
+#endif
+        default:
+            break;
+    }
+    if (!created) {
+        return std::unexpected(created.error());
+    }
+    return decompress_stream{std::move(source), std::move(*created), buffer_size};
+}
+
+auto decompress_stream::refill() -> std::expected<void, error> {
+    // Keep a partial tail the decoder could not use yet
+    const size_t kept = input_end_ - input_begin_;
+    std::memmove(input_.data(), input_.data() + input_begin_, kept);
+    input_begin_ = 0;
+    input_end_ = kept;
+
+    while (input_end_ < input_.size() && !source_done_) {
+        auto result = source_->read(std::span{input_.data() + input_end_, input_.size() - input_end_});
+        if (!result) {
+            return std::unexpected(result.error());
+        }
+        if (*result == 0) {
+            source_done_ = true;
+        }
+        input_end_ += *result;
+        if (*result > 0) {
+            break;
+        }
+    }
+    return {};
+}
+
+auto decompress_stream::read(std::span<std::byte> buffer) -> std::expected<size_t, error> {
+    size_t produced = 0;
+    while (produced < buffer.size() && !finished_) {
+        if (input_begin_ == input_end_ && !source_done_) {
+            if (auto filled = refill(); !filled) {
+                return std::unexpected(filled.error());
+            }
+        }
+
+        const auto input = std::span<const std::byte>{input_.data() + input_begin_, input_end_ - input_begin_};
+        auto step = codec_->step(input, buffer.subspan(produced), source_done_);
+        if (!step) {
+            return std::unexpected(step.error());
+        }
+        input_begin_ += step->consumed;
+        produced += step->produced;
+
+        if (step->stream_end) {
+            if (input_begin_ == input_end_ && !source_done_) {
+                if (auto filled = refill(); !filled) {
+                    return std::unexpected(filled.error());
+                }
+            }
+            const auto rest = std::span<const std::byte>{input_.data() + input_begin_, input_end_ - input_begin_};
+            finished_ = !codec_->next_member(rest);
+        } else if (step->consumed == 0 && step->produced == 0) {
+            // The decoder needs more input than is buffered
+            if (source_done_) {
+                return std::unexpected(error{error_code::corrupt_archive, "Compressed stream is truncated"});
+            }
+            if (auto filled = refill(); !filled) {
+                return std::unexpected(filled.error());
+            }
+        }
+    }
+    return produced;
+}
+
+auto decompress_stream::skip(uint64_t bytes) -> std::expected<void, error> {
+    while (bytes > 0) {
+        auto result = read(std::span{scratch_.data(), static_cast<size_t>(std::min<uint64_t>(bytes, scratch_.size()))});
+        if (!result) {
+            return std::unexpected(result.error());
+        }
+        if (*result == 0) {
+            return std::unexpected(error{error_code::io_error, "Skip past end of stream"});
+        }
+        bytes -= *result;
+    }
+    return {};
+}
+
+namespace {
+
+uint32_t load_le32(const std::byte* data) {
+    return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 |
+           static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+}
+
+auto read_at(random_access_stream& source, const uint64_t offset, std::span<std::byte> buffer)
+    -> std::expected<void, error> {
+    if (auto sought = source.seek(offset); !sought) {
+        return std::unexpected(sought.error());
+    }
+    size_t done = 0;
+    while (done < buffer.size()) {
+        auto result = source.read(buffer.subspan(done));
+        if (!result) {
+            return std::unexpected(result.error());
+        }
+        if (*result == 0) {
+            return std::unexpected(error{error_code::corrupt_archive, "Compressed stream is truncated"});
+        }
+        done += *result;
+    }
+    return {};
+}
+
+// zstd seekable format: a skippable frame at the end holding one entry per frame
+constexpr uint32_t seek_table_magic = 0x8F92EAB1;
+constexpr uint32_t skippable_frame_magic = 0x184D2A5E;
+constexpr size_t seek_table_footer_size = 9;
+constexpr size_t skippable_header_size = 8;
+
+auto find_zstd_frames(random_access_stream& source, const uint64_t size)
+    -> std::expected<std::vector<compressed_frame>, error> {
+    std::vector<compressed_frame> frames;
+    if (size < skippable_header_size + seek_table_footer_size) {
+        return frames;
+    }
+
+    std::array<std::byte, seek_table_footer_size> footer{};
+    if (auto read = read_at(source, size - footer.size(), footer); !read) {
+        return std::unexpected(read.error());
+    }
+    if (load_le32(footer.data() + 5) != seek_table_magic) {
+        return frames;
+    }
+    const uint64_t count = load_le32(footer.data());
+    const size_t entry_size = (static_cast<uint8_t>(footer[4]) & 0x80) != 0 ? 12 : 8;
+    const uint64_t table_size = count * entry_size + seek_table_footer_size;
+    if (table_size + skippable_header_size > size) {
+        return std::unexpected(error{error_code::corrupt_archive, "zstd seek table is larger than the stream"});
+    }
+
+    std::vector<std::byte> table(skippable_header_size + table_size);
+    if (auto read = read_at(source, size - table.size(), table); !read) {
+        return std::unexpected(read.error());
+    }
+    if (load_le32(table.data()) != skippable_frame_magic || load_le32(table.data() + 4) != table_size) {
+        return std::unexpected(error{error_code::corrupt_archive, "Invalid zstd seek table"});
+    }
+
+    frames.reserve(count);
+    uint64_t compressed_offset = 0;
+    uint64_t uncompressed_offset = 0;
+    for (uint64_t i = 0; i < count; ++i) {
+        const auto* entry = table.data() + skippable_header_size + i * entry_size;
+        const compressed_frame frame{compressed_offset, load_le32(entry), uncompressed_offset, load_le32(entry + 4)};
+        // Too large to buffer per worker, the stream is decoded sequentially instead
+        if (frame.compressed_size > max_frame_size || frame.uncompressed_size > max_frame_size) {
+            return std::vector<compressed_frame>{};
+        }
+        compressed_offset += frame.compressed_size;
+        uncompressed_offset += frame.uncompressed_size;
+        frames.push_back(frame);
+    }
+    if (compressed_offset != size - table.size()) {
+        return std::unexpected(error{error_code::corrupt_archive, "zstd seek table does not match the stream"});
+    }
+    return frames;
+}
+
+// BGZF: gzip members whose "BC" extra subfield records the member size
+constexpr size_t bgzf_header_size = 18;
+constexpr size_t gzip_trailer_size = 8;
+constexpr uint32_t bgzf_max_block_size = 64 * 1024;
+
+auto find_bgzf_frames(random_access_stream& source, const uint64_t size)
+    -> std::expected<std::vector<compressed_frame>, error> {
+    std::vector<compressed_frame> frames;
+    uint64_t offset = 0;
+    uint64_t uncompressed_offset = 0;
+    while (offset < size) {
+        std::array<std::byte, bgzf_header_size> header{};
+        if (size - offset < header.size()) {
+            return std::unexpected(error{error_code::corrupt_archive, "Truncated BGZF block"});
+        }
+        if (auto read = read_at(source, offset, header); !read) {
+            return std::unexpected(read.error());
+        }
+
+        const auto byte = [&header](const size_t i) { return static_cast<uint8_t>(header[i]); };
+        const bool is_bgzf = byte(0) == 0x1f && byte(1) == 0x8b && byte(2) == 8 && (byte(3) & 0x04) != 0 &&
+                             (byte(10) | byte(11) << 8) >= 6 && byte(12) == 'B' && byte(13) == 'C' &&
+                             byte(14) == 2 && byte(15) == 0;
+        if (!is_bgzf) {
+            if (offset == 0) {
+                return frames;
+            }
+            return std::unexpected(error{error_code::corrupt_archive, "Invalid BGZF block header"});
+        }
+
+        const uint64_t block_size = (byte(16) | byte(17) << 8) + 1u;
+        if (block_size < header.size() + gzip_trailer_size || block_size > size - offset) {
+            return std::unexpected(error{error_code::corrupt_archive, "Invalid BGZF block size"});
+        }
+        // The trailer ends with the uncompressed size
+        std::array<std::byte, 4> isize{};
+        if (auto read = read_at(source, offset + block_size - isize.size(), isize); !read) {
+            return std::unexpected(read.error());
+        }
+
+        const compressed_frame frame{offset, block_size, uncompressed_offset, load_le32(isize.data())};
+        if (frame.uncompressed_size > bgzf_max_block_size) {
+            return std::unexpected(error{error_code::corrupt_archive, "BGZF block larger than 64 KiB"});
+        }
+        offset += frame.compressed_size;
+        uncompressed_offset += frame.uncompressed_size;
+        // Empty blocks such as the EOF marker hold no data
+        if (frame.uncompressed_size > 0) {
+            frames.push_back(frame);
+        }
+    }
+    return frames;
+}
+
+// Decodes whole frames, one instance per worker thread
+class frame_decoder {
+    compression_format format_;
+#ifdef TIERONE_TAR_HAVE_ZSTD
+    std::unique_ptr<ZSTD_DCtx, decltype(&ZSTD_freeDCtx)> zstd_{nullptr, ZSTD_freeDCtx};
+#endif
+
+public:
+    explicit frame_decoder(const compression_format format) : format_(format) {}
+
+    // output must be sized to the frame's uncompressed size
+    [[nodiscard]] auto decode(std::span<const std::byte> input, std::span<std::byte> output)
+        -> std::expected<void, error> {
+        switch (format_) {
+#ifdef TIERONE_TAR_HAVE_ZLIB
+            case compression_format::gzip: {
+                // BGZF blocks are at most 64 KiB either way, as find_bgzf_frames() checks
+                z_stream stream{};
+                if (inflateInit2(&stream, 15 + 16) != Z_OK) {
+                    return std::unexpected(error{error_code::io_error, "Failed to initialize decompressor"});
+                }
+                stream.next_in = reinterpret_cast<const Bytef*>(input.data());
+                stream.avail_in = static_cast<uInt>(input.size());
+                stream.next_out = reinterpret_cast<Bytef*>(output.data());
+                stream.avail_out = static_cast<uInt>(output.size());
+                const int status = inflate(&stream, Z_FINISH);
+                const bool complete = status == Z_STREAM_END && stream.avail_out == 0;
+                inflateEnd(&stream);
+                if (!complete) {
+                    return std::unexpected(error{error_code::corrupt_archive, "gzip block does not match its size"});
+                }
+                return {};
+            }
+#endif
+#ifdef TIERONE_TAR_HAVE_ZSTD
+            case compression_format::zstd: {
+                if (!zstd_) {
+                    zstd_.reset(ZSTD_createDCtx());
+                    if (!zstd_) {
+                        return std::unexpected(error{error_code::io_error, "Failed to initialize decompressor"});
+                    }
+                }
+                const size_t status = ZSTD_decompressDCtx(
+                    zstd_.get(), output.data(), output.size(), input.data(), input.size());
+                if (ZSTD_isError(status)) {
+                    return std::unexpected(error{error_code::corrupt_archive,
+                        std::string{"zstd decompression failed: "} + ZSTD_getErrorName(status)});
+                }
+                if (status != output.size()) {
+                    return std::unexpected(error{error_code::corrupt_archive, "zstd frame does not match its size"});
+                }
+                return {};
+            }
+#endif
+            default:
+                return std::unexpected(error{error_code::unsupported_feature,
+                    "Compression format not supported by this build"});
+        }
+    }
+};
+
+} // anonymous namespace
+
+auto find_frames(random_access_stream& source, const compression_format format)
+    -> std::expected<std::vector<compressed_frame>, error> {
+    const auto size = source.size();
+    std::expected<std::vector<compressed_frame>, error> frames = std::vector<compressed_frame>{};
+    if (size) {
+        if (format == compression_format::zstd) {
+            frames = find_zstd_frames(source, *size);
+        } else if (format == compression_format::gzip) {
+            frames = find_bgzf_frames(source, *size);
+        }
+    }
+    if (auto rewound = source.seek(0); !rewound) {
+        return std::unexpected(rewound.error());
+    }
+    return frames;
+}
+
+struct parallel_decompress_stream::state {
+    // One frame in flight, owned by the reader until handed to a worker
+    struct slot {
+        std::vector<std::byte> buffer;  // Compressed data, unless the source is mapped
+        std::span<const std::byte> input;
+        std::vector<std::byte> output;
+        bool done = false;
+        std::optional<error> failure;
+    };
+
+    std::unique_ptr<random_access_stream> source;
+    compression_format format;
+    std::vector<compressed_frame> frames;
+    uint64_t total_size = 0;
+    std::vector<slot> slots;
+
+    std::mutex mutex;
+    std::condition_variable work_ready;
+    std::condition_variable frame_done;
+    std::deque<size_t> jobs;  // Frames waiting for a worker
+    bool stopping = false;
+
+    // Reader side
+    size_t next_dispatch = 0;
+    size_t next_consume = 0;
+    size_t consume_offset = 0;
+    frame_decoder reader_decoder;       // Frames a peek needs beyond those in flight
+    std::vector<std::byte> peek_buffer;  // Peeks that cross a frame boundary
+    std::vector<std::byte> peek_frame;
+
+    std::vector<std::jthread> workers;
+
+    state(std::unique_ptr<random_access_stream> source, const compression_format format,
+          std::vector<compressed_frame> frames, const size_t slot_count)
+        : source(std::move(source)), format(format), frames(std::move(frames)), slots(slot_count),
+          reader_decoder(format) {
+        if (!this->frames.empty()) {
+            total_size = this->frames.back().uncompressed_offset + this->frames.back().uncompressed_size;
+        }
+    }
+
+    void work() {
+        frame_decoder decoder{format};
+        while (true) {
+            size_t frame = 0;
+            {
+                std::unique_lock lock{mutex};
+                work_ready.wait(lock, [this] { return stopping || !jobs.empty(); });
+                if (stopping) {
+                    return;
+                }
+                frame = jobs.front();
+                jobs.pop_front();
+            }
+
+            auto& target = slots[frame % slots.size()];
+            auto decoded = decoder.decode(target.input, target.output);
+            {
+                std::lock_guard lock{mutex};
+                target.done = true;
+                if (!decoded) {
+                    target.failure = decoded.error();
+                }
+            }
+            frame_done.notify_all();
+        }
+    }
+
+    void stop() {
+        {
+            std::lock_guard lock{mutex};
+            stopping = true;
+        }
+        work_ready.notify_all();
+        workers.clear();
+    }
+
+    [[nodiscard]] auto load(const compressed_frame& frame, std::vector<std::byte>& buffer)
+        -> std::expected<std::span<const std::byte>, error> {
+        if (const auto mapped = source->mapped_data()) {
+            if (frame.compressed_offset + frame.compressed_size > mapped->size()) {
+                return std::unexpected(error{error_code::corrupt_archive, "Compressed stream is truncated"});
+            }
+            return mapped->subspan(frame.compressed_offset, frame.compressed_size);
+        }
+        buffer.resize(frame.compressed_size);
+        if (auto read = read_at(*source, frame.compressed_offset, buffer); !read) {
+            return std::unexpected(read.error());
+        }
+        return std::span<const std::byte>{buffer};
+    }
+
+    // Hand frames to the workers until every slot is busy
+    [[nodiscard]] auto dispatch() -> std::expected<void, error> {
+        while (next_dispatch < frames.size() && next_dispatch - next_consume < slots.size()) {
+            const auto& frame = frames[next_dispatch];
+            auto& target = slots[next_dispatch % slots.size()];
+            auto input = load(frame, target.buffer);
+            if (!input) {
+                return std::unexpected(input.error());
+            }
+            target.input = *input;
+            target.output.resize(frame.uncompressed_size);
+            {
+                std::lock_guard lock{mutex};
+                target.done = false;
+                target.failure.reset();
+                jobs.push_back(next_dispatch);
+            }
+            work_ready.notify_one();
+            ++next_dispatch;
+        }
+        return {};
+    }
+
+    // Wait for a frame in flight to be decoded
+    [[nodiscard]] auto wait_frame(const size_t frame) -> std::expected<slot*, error> {
+        auto& target = slots[frame % slots.size()];
+        std::unique_lock lock{mutex};
+        frame_done.wait(lock, [&target] { return target.done; });
+        if (target.failure) {
+            return std::unexpected(*target.failure);
+        }
+        return &target;
+    }
+
+    // Drop every frame in flight, waiting for those a worker already holds
+    void cancel() {
+        std::unique_lock lock{mutex};
+        for (const size_t frame : jobs) {
+            slots[frame % slots.size()].done = true;
+        }
+        jobs.clear();
+        for (size_t frame = next_consume; frame < next_dispatch; ++frame) {
+            auto& target = slots[frame % slots.size()];
+            frame_done.wait(lock, [&target] { return target.done; });
+        }
+    }
+
+    [[nodiscard]] uint64_t position() const {
+        if (next_consume == frames.size()) {
+            return total_size;
+        }
+        return frames[next_consume].uncompressed_offset + consume_offset;
+    }
+};
+
+parallel_decompress_stream::parallel_decompress_stream(std::unique_ptr<state> state)
+    : state_(std::move(state)) {}
+
+parallel_decompress_stream::parallel_decompress_stream(parallel_decompress_stream&& other) noexcept = default;
+
+auto parallel_decompress_stream::operator=(parallel_decompress_stream&& other) noexcept
+    -> parallel_decompress_stream& {
+    if (this != &other) {
+        if (state_) {
+            state_->stop();
+        }
+        state_ = std::move(other.state_);
+    }
+    return *this;
+}
+
+parallel_decompress_stream::~parallel_decompress_stream() {
+    if (state_) {
+        state_->stop();
+    }
+}
+
+auto parallel_decompress_stream::create(
+    std::unique_ptr<random_access_stream> source,
+    const compression_format format,
+    std::vector<compressed_frame> frames,
+    const parallel_decompress_options& options) -> std::expected<parallel_decompress_stream, error> {
+    if (!source) {
+        return std::unexpected(error{error_code::invalid_operation, "Null stream provided"});
+    }
+    if ((format != compression_format::gzip && format != compression_format::zstd) ||
+        !is_compression_supported(format)) {
+        return std::unexpected(error{error_code::unsupported_feature,
+            "Parallel decompression not supported for this format"});
+    }
+    if (std::ranges::any_of(frames, [](const compressed_frame& frame) {
+            return frame.compressed_size > max_frame_size || frame.uncompressed_size > max_frame_size;
+        })) {
+        return std::unexpected(error{error_code::invalid_operation, "Frame larger than max_frame_size"});
+    }
+
+    const unsigned hardware = std::max(1u, std::thread::hardware_concurrency());
+    const size_t thread_count = std::max<size_t>(1, std::min<size_t>(
+        options.threads != 0 ? options.threads : hardware, frames.size()));
+    const size_t slot_count = options.frames_ahead != 0 ? options.frames_ahead : thread_count * 2;
+
+    auto shared = std::make_unique<state>(std::move(source), format, std::move(frames), slot_count);
+    shared->workers.reserve(thread_count);
+    for (size_t i = 0; i < thread_count; ++i) {
+        shared->workers.emplace_back([worker = shared.get()] { worker->work(); });
+    }
+    return parallel_decompress_stream{std::move(shared)};
+}
+
+auto parallel_decompress_stream::read(std::span<std::byte> buffer) -> std::expected<size_t, error> {
+    auto& s = *state_;
+    size_t copied = 0;
+    while (copied < buffer.size() && s.next_consume < s.frames.size()) {
+        if (auto dispatched = s.dispatch(); !dispatched) {
+            return std::unexpected(dispatched.error());
+        }
+        auto head = s.wait_frame(s.next_consume);
+        if (!head) {
+            return std::unexpected(head.error());
+        }
+
+        const auto& output = (*head)->output;
+        const size_t count = std::min(buffer.size() - copied, output.size() - s.consume_offset);
+        std::memcpy(buffer.data() + copied, output.data() + s.consume_offset, count);
+        copied += count;
+        s.consume_offset += count;
+        if (s.consume_offset == output.size()) {
+            ++s.next_consume;
+            s.consume_offset = 0;
+        }
+    }
+    return copied;
+}
+
+auto parallel_decompress_stream::peek(const size_t bytes) -> std::expected<std::span<const std::byte>, error> {
+    auto& s = *state_;
+    if (s.next_consume == s.frames.size()) {
+        return std::span<const std::byte>{};
+    }
+    if (auto dispatched = s.dispatch(); !dispatched) {
+        return std::unexpected(dispatched.error());
+    }
+    auto head = s.wait_frame(s.next_consume);
+    if (!head) {
+        return std::unexpected(head.error());
+    }
+    const auto rest = std::span<const std::byte>{(*head)->output}.subspan(s.consume_offset);
+    if (rest.size() >= bytes) {
+        return rest.first(bytes);
+    }
+
+    // Gather the following frames, decoding here those not yet handed out
+    s.peek_buffer.assign(rest.begin(), rest.end());
+    for (size_t frame = s.next_consume + 1; frame < s.frames.size() && s.peek_buffer.size() < bytes; ++frame) {
+        std::span<const std::byte> data;
+        if (frame < s.next_dispatch) {
+            auto decoded = s.wait_frame(frame);
+            if (!decoded) {
+                return std::unexpected(decoded.error());
+            }
+            data = (*decoded)->output;
+        } else {
+            std::vector<std::byte> compressed;
+            auto input = s.load(s.frames[frame], compressed);
+            if (!input) {
+                return std::unexpected(input.error());
+            }
+            s.peek_frame.resize(s.frames[frame].uncompressed_size);
+            if (auto decoded = s.reader_decoder.decode(*input, s.peek_frame); !decoded) {
+                return std::unexpected(decoded.error());
+            }
+            data = s.peek_frame;
+        }
+        const size_t count = std::min(bytes - s.peek_buffer.size(), data.size());
+        s.peek_buffer.insert(s.peek_buffer.end(), data.begin(), data.begin() + static_cast<std::ptrdiff_t>(count));
+    }
+    return std::span<const std::byte>{s.peek_buffer};
+}
+
+auto parallel_decompress_stream::seek(const uint64_t position) -> std::expected<void, error> {
+    auto& s = *state_;
+    if (position > s.total_size) {
+        return std::unexpected(error{error_code::io_error, "Seek past end of stream"});
+    }
+
+    // Last frame starting at or before position, skipping empty ones
+    size_t target = s.frames.size();
+    uint64_t offset = 0;
+    if (position < s.total_size) {
+        const auto found = std::upper_bound(s.frames.begin(), s.frames.end(), static_cast<uint64_t>(position),
+            [](const uint64_t pos, const compressed_frame& frame) { return pos < frame.uncompressed_offset; });
+        target = static_cast<size_t>(found - s.frames.begin()) - 1;
+        offset = position - s.frames[target].uncompressed_offset;
+    }
+
+    if (target >= s.next_consume && target < s.next_dispatch) {
+        // Already in flight: keep it and the frames after it, waiting on those
+        // before it as a worker may still be writing into their slots
+        for (; s.next_consume < target; ++s.next_consume) {
+            static_cast<void>(s.wait_frame(s.next_consume));
+        }
+    } else {
+        s.cancel();
+        s.next_consume = target;
+        s.next_dispatch = target;
+    }
+    s.consume_offset = offset;
+    return {};
+}
+
+auto parallel_decompress_stream::skip(const uint64_t bytes) -> std::expected<void, error> {
+    const uint64_t current = state_->position();
+    if (bytes > state_->total_size - current) {
+        return std::unexpected(error{error_code::io_error, "Skip past end of stream"});
+    }
+    return seek(current + bytes);
+}
+
+bool parallel_decompress_stream::at_end() const {
+    return state_->position() == state_->total_size;
+}
+
+auto parallel_decompress_stream::position() const -> uint64_t {
+    return state_->position();
+}
+
+auto parallel_decompress_stream::size() const -> std::optional<uint64_t> {
+    return state_->total_size;
+}
+
+auto open_decompressed(std::unique_ptr<input_stream> stream) -> std::expected<std::unique_ptr<input_stream>, error> {
+    if (!stream || !stream->can_peek()) {
+        return stream;
+    }
+    auto head = stream->peek(compression_magic_size);
+    if (!head) {
+        return std::unexpected(head.error());
+    }
+
+    const auto format = detect_compression(*head);
+    if (format == compression_format::none) {
+        return stream;
+    }
+
+    // Independent frames found without decoding can be spread over threads
+    if (auto* seekable = dynamic_cast<random_access_stream*>(stream.get());
+        seekable && (format == compression_format::gzip || format == compression_format::zstd) &&
+        is_compression_supported(format)) {
+        auto frames = find_frames(*seekable, format);
+        if (!frames) {
+            return std::unexpected(frames.error());
+        }
+        if (frames->size() > 1) {
+            std::unique_ptr<random_access_stream> owned{static_cast<random_access_stream*>(stream.release())};
+            auto parallel = parallel_decompress_stream::create(std::move(owned), format, std::move(*frames));
+            if (!parallel) {
+                return std::unexpected(parallel.error());
+            }
+            return std::make_unique<parallel_decompress_stream>(std::move(*parallel));
+        }
+    }
+
+    auto decompressed = decompress_stream::create(std::move(stream), format);
+    if (!decompressed) {
+        return std::unexpected(decompressed.error());
+    }
+    return std::make_unique<read_ahead_stream>(std::make_unique<decompress_stream>(std::move(*decompressed)));
+}
+
+} // namespace tierone::tar
@@ -0,0 +1,332 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <tierone/tar/digest.hpp>
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#include <immintrin.h>
+#define TIERONE_TAR_SHA_NI 1
+#endif
+
+namespace tierone::tar {
+
+namespace {
+
+constexpr std::array<uint32_t, 8> sha256_initial{
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19};
+
+alignas(16) constexpr std::array<uint32_t, 64> sha256_k{
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+[[nodiscard]] uint32_t load_be32(const std::byte* p) noexcept {
+    return (std::to_integer<uint32_t>(p[0]) << 24) | (std::to_integer<uint32_t>(p[1]) << 16) |
+           (std::to_integer<uint32_t>(p[2]) << 8) | std::to_integer<uint32_t>(p[3]);
+}
+
+[[nodiscard]] uint32_t load_le32(const std::byte* p) noexcept {
+    return std::to_integer<uint32_t>(p[0]) | (std::to_integer<uint32_t>(p[1]) << 8) |
+           (std::to_integer<uint32_t>(p[2]) << 16) | (std::to_integer<uint32_t>(p[3]) << 24);
+}
+
+[[nodiscard]] uint64_t load_le64(const std::byte* p) noexcept {
+    return load_le32(p) | (static_cast<uint64_t>(load_le32(p + 4)) << 32);
+}
+
+void sha256_blocks_portable(std::array<uint32_t, 8>& h, const std::byte* data, size_t blocks) noexcept {
+    while (blocks-- > 0) {
+        std::array<uint32_t, 64> w;
+        for (size_t t = 0; t < 16; ++t) {
+            w[t] = load_be32(data + 4 * t);
+        }
+        for (size_t t = 16; t < 64; ++t) {
+            const uint32_t s0 = std::rotr(w[t - 15], 7) ^ std::rotr(w[t - 15], 18) ^ (w[t - 15] >> 3);
+            const uint32_t s1 = std::rotr(w[t - 2], 17) ^ std::rotr(w[t - 2], 19) ^ (w[t - 2] >> 10);
+            w[t] = w[t - 16] + s0 + w[t - 7] + s1;
+        }
+        auto [a, b, c, d, e, f, g, hh] = h;
+        for (size_t t = 0; t < 64; ++t) {
+            const uint32_t t1 = hh + (std::rotr(e, 6) ^ std::rotr(e, 11) ^ std::rotr(e, 25)) +
+                                ((e & f) ^ (~e & g)) + sha256_k[t] + w[t];
+            const uint32_t t2 = (std::rotr(a, 2) ^ std::rotr(a, 13) ^ std::rotr(a, 22)) +
+                                ((a & b) ^ (a & c) ^ (b & c));
+            hh = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        h[0] += a; h[1] += b; h[2] += c; h[3] += d;
+        h[4] += e; h[5] += f; h[6] += g; h[7] += hh;
+        data += 64;
+    }
+}
+
+#ifdef TIERONE_TAR_SHA_NI
+// Two rounds per sha256rnds2, state kept as ABEF/CDGH lane pairs
+__attribute__((target("sha,sse4.1,ssse3")))
+void sha256_blocks_sha_ni(std::array<uint32_t, 8>& h, const std::byte* data, size_t blocks) noexcept {
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    __m128i tmp = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&h[0])), 0xb1);  // CDAB
+    __m128i state1 = _mm_shuffle_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(&h[4])), 0x1b);  // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);  // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xf0);       // CDGH
+
+    while (blocks-- > 0) {
+        const __m128i abef = state0;
+        const __m128i cdgh = state1;
+
+        __m128i w[16];
+        for (size_t g = 0; g < 4; ++g) {
+            w[g] = _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + 16 * g)), byte_swap);
+        }
+        for (size_t g = 4; g < 16; ++g) {
+            const __m128i mixed = _mm_add_epi32(_mm_sha256msg1_epu32(w[g - 4], w[g - 3]),
+                                                _mm_alignr_epi8(w[g - 1], w[g - 2], 4));
+            w[g] = _mm_sha256msg2_epu32(mixed, w[g - 1]);
+        }
+        for (size_t g = 0; g < 16; ++g) {
+            __m128i message = _mm_add_epi32(w[g], _mm_load_si128(reinterpret_cast<const __m128i*>(&sha256_k[4 * g])));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, message);
+            message = _mm_shuffle_epi32(message, 0x0e);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, message);
+        }
+
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+        data += 64;
+    }
+
+    tmp = _mm_shuffle_epi32(state0, 0x1b);     // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xb1);  // DCHG
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&h[0]), _mm_blend_epi16(tmp, state1, 0xf0));  // DCBA
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&h[4]), _mm_alignr_epi8(state1, tmp, 8));     // HGFE
+}
+
+[[nodiscard]] bool cpu_has_sha_ni() noexcept {
+    unsigned eax = 0, ebx = 0, ecx = 0, edx = 0;
+    if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx) || !(ecx & bit_SSE4_1) || !(ecx & bit_SSSE3)) {
+        return false;
+    }
+    return __get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx) && (ebx & bit_SHA);
+}
+#endif
+
+void sha256_blocks(std::array<uint32_t, 8>& h, const std::byte* data, const size_t blocks) noexcept {
+#ifdef TIERONE_TAR_SHA_NI
+    static const bool sha_ni = cpu_has_sha_ni();
+    if (sha_ni) {
+        sha256_blocks_sha_ni(h, data, blocks);
+        return;
+    }
+#endif
+    sha256_blocks_portable(h, data, blocks);
+}
+
+void sha256_update(detail::sha256_state& state, std::span<const std::byte> data) noexcept {
+    state.length += data.size();
+    if (state.buffered > 0) {
+        const size_t take = std::min(data.size(), state.block.size() - state.buffered);
+        std::memcpy(state.block.data() + state.buffered, data.data(), take);
+        state.buffered += take;
+        data = data.subspan(take);
+        if (state.buffered < state.block.size()) {
+            return;
+        }
+        sha256_blocks(state.h, state.block.data(), 1);
+        state.buffered = 0;
+    }
+    const size_t blocks = data.size() / 64;
+    if (blocks > 0) {
+        sha256_blocks(state.h, data.data(), blocks);
+        data = data.subspan(blocks * 64);
+    }
+    std::memcpy(state.block.data(), data.data(), data.size());
+    state.buffered = data.size();
+}
+
+[[nodiscard]] std::array<std::byte, 32> sha256_finish(detail::sha256_state state) noexcept {
+    const uint64_t bits = state.length * 8;
+    state.block[state.buffered++] = std::byte{0x80};
+    if (state.buffered > 56) {
+        std::fill(state.block.begin() + static_cast<std::ptrdiff_t>(state.buffered), state.block.end(), std::byte{0});
+        sha256_blocks(state.h, state.block.data(), 1);
+        state.buffered = 0;
+    }
+    std::fill(state.block.begin() + static_cast<std::ptrdiff_t>(state.buffered), state.block.begin() + 56, std::byte{0});
+    for (size_t i = 0; i < 8; ++i) {
+        state.block[56 + i] = static_cast<std::byte>(bits >> (56 - 8 * i));
+    }
+    sha256_blocks(state.h, state.block.data(), 1);
+
+    std::array<std::byte, 32> digest;
+    for (size_t i = 0; i < 8; ++i) {
+        for (size_t j = 0; j < 4; ++j) {
+            digest[4 * i + j] = static_cast<std::byte>(state.h[i] >> (24 - 8 * j));
+        }
+    }
+    return digest;
+}
+
+constexpr uint64_t xxh_prime1 = 0x9e3779b185ebca87ULL;
+constexpr uint64_t xxh_prime2 = 0xc2b2ae3d27d4eb4fULL;
+constexpr uint64_t xxh_prime3 = 0x165667b19e3779f9ULL;
+constexpr uint64_t xxh_prime4 = 0x85ebca77c2b2ae63ULL;
+constexpr uint64_t xxh_prime5 = 0x27d4eb2f165667c5ULL;
+
+[[nodiscard]] uint64_t xxh64_round(uint64_t acc, const uint64_t input) noexcept {
+    acc += input * xxh_prime2;
+    return std::rotl(acc, 31) * xxh_prime1;
+}
+
+[[nodiscard]] uint64_t xxh64_merge(uint64_t acc, const uint64_t value) noexcept {
+    acc ^= xxh64_round(0, value);
+    return acc * xxh_prime1 + xxh_prime4;
+}
+
+void xxh64_stripe(detail::xxh64_state& state, const std::byte* data) noexcept {
+    for (size_t lane = 0; lane < 4; ++lane) {
+        state.v[lane] = xxh64_round(state.v[lane], load_le64(data + 8 * lane));
+    }
+}
+
+void xxh64_update(detail::xxh64_state& state, std::span<const std::byte> data) noexcept {
+    state.length += data.size();
+    if (state.buffered > 0) {
+        const size_t take = std::min(data.size(), state.stripe.size() - state.buffered);
+        std::memcpy(state.stripe.data() + state.buffered, data.data(), take);
+        state.buffered += take;
+        data = data.subspan(take);
+        if (state.buffered < state.stripe.size()) {
+            return;
+        }
+        xxh64_stripe(state, state.stripe.data());
+        state.buffered = 0;
+    }
+    while (data.size() >= 32) {
+        xxh64_stripe(state, data.data());
+        data = data.subspan(32);
+    }
+    std::memcpy(state.stripe.data(), data.data(), data.size());
+    state.buffered = data.size();
+}
+
+[[nodiscard]] uint64_t xxh64_finish(const detail::xxh64_state& state) noexcept {
+    uint64_t h;
+    if (state.length >= 32) {
+        const auto& v = state.v;
+        h = std::rotl(v[0], 1) + std::rotl(v[1], 7) + std::rotl(v[2], 12) + std::rotl(v[3], 18);
+        for (const uint64_t lane : v) {
+            h = xxh64_merge(h, lane);
+        }
+    } else {
+        h = xxh_prime5;  // seed 0
+    }
+    h += state.length;
+
+    const std::byte* p = state.stripe.data();
+    size_t left = state.buffered;
+    for (; left >= 8; left -= 8, p += 8) {
+        h ^= xxh64_round(0, load_le64(p));
+        h = std::rotl(h, 27) * xxh_prime1 + xxh_prime4;
+    }
+    if (left >= 4) {
+        h ^= static_cast<uint64_t>(load_le32(p)) * xxh_prime1;
+        h = std::rotl(h, 23) * xxh_prime2 + xxh_prime3;
+        left -= 4;
+        p += 4;
+    }
+    for (; left > 0; --left, ++p) {
+        h ^= std::to_integer<uint64_t>(*p) * xxh_prime5;
+        h = std::rotl(h, 11) * xxh_prime1;
+    }
+
+    h ^= h >> 33;
+    h *= xxh_prime2;
+    h ^= h >> 29;
+    h *= xxh_prime3;
+    h ^= h >> 32;
+    return h;
+}
+
+} // anonymous namespace
+
+content_hasher::content_hasher(const digest_set algorithms) noexcept : algorithms_(algorithms) {
+    reset();
+}
+
+void content_hasher::reset() noexcept {
+    sha256_ = {};
+    sha256_.h = sha256_initial;
+    xxh64_ = {};
+    xxh64_.v = {xxh_prime1 + xxh_prime2, xxh_prime2, 0, 0 - xxh_prime1};  // seed 0
+}
+
+void content_hasher::update(const std::span<const std::byte> data) noexcept {
+    if (algorithms_.sha256) {
+        sha256_update(sha256_, data);
+    }
+    if (algorithms_.xxh64) {
+        xxh64_update(xxh64_, data);
+    }
+}
+
+auto content_hasher::finish() const noexcept -> entry_digests {
+    entry_digests digests;
+    if (algorithms_.sha256) {
+        digests.sha256 = sha256_finish(sha256_);
+    }
+    if (algorithms_.xxh64) {
+        digests.xxh64 = xxh64_finish(xxh64_);
+    }
+    return digests;
+}
+
+auto to_hex(const std::span<const std::byte> digest) -> std::string {
+    constexpr char digits[] = "0123456789abcdef";
+    std::string text;
+    text.reserve(digest.size() * 2);
+    for (const std::byte b : digest) {
+        text += digits[std::to_integer<unsigned>(b) >> 4];
+        text += digits[std::to_integer<unsigned>(b) & 0xf];
+    }
+    return text;
+}
+
+auto to_hex(const uint64_t digest) -> std::string {
+    std::array<std::byte, 8> bytes;
+    for (size_t i = 0; i < 8; ++i) {
+        bytes[i] = static_cast<std::byte>(digest >> (56 - 8 * i));
+    }
+    return to_hex(bytes);
+}
+
+} // namespace tierone::tar
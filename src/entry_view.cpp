@@ -0,0 +1,189 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <tierone/tar/entry_view.hpp>
+#include <tierone/tar/pax_parser.hpp>
+#include <tierone/tar/sparse.hpp>
+#include <algorithm>
+#include <cstring>
+
+namespace tierone::tar {
+
+auto entry_view::parse(std::span<const std::byte, detail::BLOCK_SIZE> block) -> std::expected<entry_view, error> {
+    if (auto valid = detail::validate_header(block); !valid) {
+        return std::unexpected(valid.error());
+    }
+
+    entry_view view;
+    std::ranges::copy(block, view.block_.begin());
+
+    // Join prefix and name once, into the view's own storage
+    const auto& hdr = view.header();
+    const auto prefix = detail::extract_string(std::span{hdr.prefix});
+    const auto name = detail::extract_string(std::span{hdr.name});
+    if (!prefix.empty()) {
+        std::memcpy(view.joined_path_.data(), prefix.data(), prefix.size());
+        view.joined_length_ = prefix.size();
+        if (prefix.back() != '/') {
+            view.joined_path_[view.joined_length_++] = '/';
+        }
+        std::memcpy(view.joined_path_.data() + view.joined_length_, name.data(), name.size());
+        view.joined_length_ += name.size();
+    }
+
+    view.sparse_ = hdr.typeflag == std::to_underlying(entry_type::gnu_sparse);
+    return view;
+}
+
+auto entry_view::path() const noexcept -> std::string_view {
+    if (!path_override_.empty()) {
+        return path_override_;
+    }
+    if (joined_length_ != 0) {
+        return {joined_path_.data(), joined_length_};
+    }
+    return detail::extract_string(std::span{header().name});
+}
+
+auto entry_view::owner_name() const noexcept -> std::string_view {
+    if (pax_headers_ && pax_headers_->uname) {
+        return *pax_headers_->uname;
+    }
+    if (global_pax_ && global_pax_->uname) {
+        return *global_pax_->uname;
+    }
+    return detail::extract_string(std::span{header().uname});
+}
+
+auto entry_view::group_name() const noexcept -> std::string_view {
+    if (pax_headers_ && pax_headers_->gname) {
+        return *pax_headers_->gname;
+    }
+    if (global_pax_ && global_pax_->gname) {
+        return *global_pax_->gname;
+    }
+    return detail::extract_string(std::span{header().gname});
+}
+
+auto entry_view::link_target() const noexcept -> std::optional<std::string_view> {
+    if (type() != entry_type::symbolic_link && type() != entry_type::hard_link) {
+        return std::nullopt;
+    }
+    if (!link_override_.empty()) {
+        return link_override_;
+    }
+    const auto linkname = detail::extract_string(std::span{header().linkname});
+    if (linkname.empty()) {
+        return std::nullopt;
+    }
+    return linkname;
+}
+
+auto entry_view::size() const -> std::expected<uint64_t, error> {
+    if (size_override_) {
+        return *size_override_;
+    }
+    return detail::parse_numeric(std::span{header().size});
+}
+
+auto entry_view::file_size() const -> std::expected<uint64_t, error> {
+    if (sparse_) {
+        if (pax_headers_ && pax_headers_->sparse_realsize) {
+            return *pax_headers_->sparse_realsize;
+        }
+        if (type() == entry_type::gnu_sparse) {
+            const auto& sparse_header = *std::bit_cast<const sparse::gnu_sparse_header*>(block_.data());
+            return detail::parse_numeric(std::span{sparse_header.realsize});
+        }
+    }
+    return size();
+}
+
+auto entry_view::permissions() const -> std::expected<std::filesystem::perms, error> {
+    auto mode = detail::parse_octal(std::span{header().mode});
+    if (!mode) {
+        return std::unexpected(mode.error());
+    }
+    return static_cast<std::filesystem::perms>(*mode & 07777);
+}
+
+auto entry_view::owner_id() const -> std::expected<uint32_t, error> {
+    if (pax_headers_ && pax_headers_->uid) {
+        return *pax_headers_->uid;
+    }
+    if (global_pax_ && global_pax_->uid) {
+        return *global_pax_->uid;
+    }
+    auto uid = detail::parse_numeric(std::span{header().uid});
+    if (!uid) {
+        return std::unexpected(uid.error());
+    }
+    return static_cast<uint32_t>(*uid);
+}
+
+auto entry_view::group_id() const -> std::expected<uint32_t, error> {
+    if (pax_headers_ && pax_headers_->gid) {
+        return *pax_headers_->gid;
+    }
+    if (global_pax_ && global_pax_->gid) {
+        return *global_pax_->gid;
+    }
+    auto gid = detail::parse_numeric(std::span{header().gid});
+    if (!gid) {
+        return std::unexpected(gid.error());
+    }
+    return static_cast<uint32_t>(*gid);
+}
+
+auto entry_view::modification_time() const -> std::expected<std::chrono::system_clock::time_point, error> {
+    if (pax_headers_ && pax_headers_->mtime) {
+        return std::chrono::system_clock::time_point{std::chrono::seconds{*pax_headers_->mtime}};
+    }
+    if (global_pax_ && global_pax_->mtime) {
+        return std::chrono::system_clock::time_point{std::chrono::seconds{*global_pax_->mtime}};
+    }
+    auto mtime = detail::parse_signed_numeric(std::span{header().mtime});
+    if (!mtime) {
+        return std::unexpected(mtime.error());
+    }
+    return std::chrono::system_clock::from_time_t(static_cast<std::time_t>(*mtime));
+}
+
+auto entry_view::to_metadata() const -> std::expected<file_metadata, error> {
+    auto metadata = detail::parse_header(block_);
+    if (!metadata) {
+        return std::unexpected(metadata.error());
+    }
+
+    if (!path_override_.empty()) {
+        metadata->path = std::filesystem::path{path_override_};
+    }
+    if (!link_override_.empty()) {
+        metadata->link_target = std::string{link_override_};
+    }
+    if (size_override_) {
+        metadata->size = *size_override_;
+    }
+    if (global_pax_) {
+        global_pax_->apply_to(*metadata);
+    }
+    if (pax_headers_) {
+        pax_headers_->apply_to(*metadata);
+    }
+    return metadata;
+}
+
+} // namespace tierone::tar
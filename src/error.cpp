@@ -0,0 +1,35 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <tierone/tar/error.hpp>
+
+namespace tierone::tar {
+
+auto error::message() const -> std::string {
+    std::string text = context_ ? std::string{context_} : detail_;
+    if (errno_ != 0) {
+        text += ": ";
+        text += std::generic_category().message(errno_);
+    }
+    if (offset_) {
+        text += " at offset ";
+        text += std::to_string(*offset_);
+    }
+    return text;
+}
+
+} // namespace tierone::tar
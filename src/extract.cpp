@@ -0,0 +1,1184 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <tierone/tar/extract.hpp>
+#include <tierone/tar/copy.hpp>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <variant>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <linux/fs.h>
+#include <sys/ioctl.h>
+#include <sys/xattr.h>
+#endif
+
+namespace tierone::tar {
+
+namespace {
+
+// Metadata applied once an entry's contents are in place
+// Fields the extract_options leave alone are unset or empty.
+struct restore_info {
+    std::filesystem::perms permissions = std::filesystem::perms::none;
+    std::optional<std::pair<uint32_t, uint32_t>> owner;  // uid, gid
+    std::optional<std::chrono::system_clock::time_point> modification_time;
+    extended_attributes xattrs;
+    std::vector<acl_entry> access_acl;
+    std::vector<acl_entry> default_acl;
+};
+
+auto restore_info_of(const file_metadata& meta, const extract_options& options) -> restore_info {
+    restore_info info{meta.permissions, std::nullopt, std::nullopt, {}, {}, {}};
+    if (options.preserve_owner) {
+        info.owner.emplace(meta.owner_id, meta.group_id);
+    }
+    if (options.preserve_times) {
+        info.modification_time = meta.modification_time;
+    }
+    if (options.preserve_xattrs) {
+        info.xattrs = meta.xattrs;
+        info.access_acl = meta.access_acl;
+        info.default_acl = meta.default_acl;
+    }
+    return info;
+}
+
+// Work item handed from the scanning thread to the workers
+struct extract_job {
+    std::string path;  // Normalized archive path
+    restore_info info;
+    entry_type type = entry_type::regular_file;
+    std::optional<std::string> link_target;  // Symlink target, or normalized source of a link or duplicate
+    dedup_mode reuse = dedup_mode::none;      // How a duplicate file is made from link_target
+
+    // File contents, either owned or borrowed from a memory-mapped archive
+    std::variant<std::vector<std::byte>, std::span<const std::byte>> data;
+
+    [[nodiscard]] std::span<const std::byte> bytes() const {
+        return std::visit([](const auto& d) { return std::span<const std::byte>{d}; }, data);
+    }
+};
+
+// Files written so far by content, for extract_options::dedup
+// Only touched by the scanning thread.
+class content_table {
+private:
+    std::unordered_map<std::string, std::string> paths_;  // Dedup key to the first copy
+    std::unordered_map<std::string, std::string> keys_;   // First copy to its dedup key
+
+public:
+    // Path of an earlier file with the content under key
+    [[nodiscard]] const std::string* find(const std::string& key) const {
+        const auto found = paths_.find(key);
+        return found != paths_.end() ? &found->second : nullptr;
+    }
+
+    // Record what an entry put at path, nullopt for anything not reusable
+    // A path written again no longer serves as a copy of its old content.
+    void record(const std::string& path, std::optional<std::string> key) {
+        if (const auto old = keys_.find(path); old != keys_.end()) {
+            paths_.erase(old->second);
+            keys_.erase(old);
+        }
+        if (key && paths_.try_emplace(*key, path).second) {
+            keys_.emplace(path, std::move(*key));
+        }
+    }
+};
+
+// Key under which a file's content is matched against earlier ones
+// Hard links share one inode, so its mode and owner are part of the key
+// and files with xattrs or ACLs are left alone; clones restore their own.
+auto dedup_key(const archive_entry& entry, const extract_options& options) -> std::optional<std::string> {
+    const auto digests = entry.digests();
+    if (!digests || !digests->sha256) {
+        return std::nullopt;
+    }
+    std::string key(reinterpret_cast<const char*>(digests->sha256->data()), digests->sha256->size());
+    key.append(std::to_string(entry.size()));
+    if (options.dedup == dedup_mode::hard_link) {
+        const auto& meta = entry.metadata();
+        if (options.preserve_xattrs && (meta.has_extended_attributes() || meta.has_acls())) {
+            return std::nullopt;
+        }
+        key.append(":" + std::to_string(static_cast<unsigned>(meta.permissions)));
+        if (options.preserve_owner) {
+            key.append(":" + std::to_string(meta.owner_id) + ":" + std::to_string(meta.group_id));
+        }
+    }
+    return key;
+}
+
+// Paths a job writes and reads, hashed; a collision only orders two jobs needlessly
+struct job_paths {
+    size_t path;
+    std::optional<size_t> source;  // File a link or duplicate is made from
+};
+
+[[nodiscard]] job_paths paths_of(const extract_job& job) {
+    const std::hash<std::string_view> hash;
+    job_paths paths{hash(job.path), std::nullopt};
+    if (job.type != entry_type::symbolic_link && job.link_target) {
+        paths.source = hash(*job.link_target);
+    }
+    return paths;
+}
+
+// Queued jobs looked at for one that may run, beyond these workers wait
+constexpr size_t max_lookahead = 64;
+
+// Bounded queue shared by the scanner and the workers
+// Jobs touching the same path run one at a time in archive order, so a
+// member stored twice ends up as its last copy and a link sees its source
+// written. Other jobs may pass one that is held back.
+class job_queue {
+private:
+    std::mutex mutex_;
+    std::condition_variable not_empty_;
+    std::condition_variable not_full_;
+    std::condition_variable settled_;
+    std::deque<extract_job> jobs_;
+    std::unordered_map<size_t, size_t> claimed_;  // Queued and running jobs per path
+    std::unordered_map<size_t, size_t> running_;  // Running jobs per path
+    std::vector<size_t> held_;                    // Paths of jobs passed over by next()
+    size_t queued_bytes_ = 0;
+    size_t max_queued_bytes_;
+    bool closed_ = false;
+    std::optional<error> error_;
+
+    static void count(std::unordered_map<size_t, size_t>& counts, const job_paths& paths, const bool add) {
+        const auto apply = [&](const size_t path) {
+            if (add) {
+                ++counts[path];
+            } else if (const auto found = counts.find(path); found != counts.end() && --found->second == 0) {
+                counts.erase(found);
+            }
+        };
+        apply(paths.path);
+        if (paths.source) {
+            apply(*paths.source);
+        }
+    }
+
+    // First queued job whose paths are neither in use nor wanted by an earlier job
+    [[nodiscard]] std::optional<size_t> next() {
+        held_.clear();
+        const auto blocked = [&](const size_t path) {
+            return running_.contains(path) || std::ranges::find(held_, path) != held_.end();
+        };
+        const size_t window = std::min(jobs_.size(), max_lookahead);
+        for (size_t i = 0; i < window; ++i) {
+            const auto paths = paths_of(jobs_[i]);
+            if (!blocked(paths.path) && !(paths.source && blocked(*paths.source))) {
+                return i;
+            }
+            held_.push_back(paths.path);
+            if (paths.source) {
+                held_.push_back(*paths.source);
+            }
+        }
+        return std::nullopt;
+    }
+
+public:
+    explicit job_queue(const size_t max_queued_bytes) : max_queued_bytes_(max_queued_bytes) {}
+
+    void push(extract_job job) {
+        const size_t job_bytes = job.bytes().size();
+        std::unique_lock lock{mutex_};
+        not_full_.wait(lock, [&] {
+            return jobs_.empty() || queued_bytes_ + job_bytes <= max_queued_bytes_ || error_;
+        });
+        queued_bytes_ += job_bytes;
+        count(claimed_, paths_of(job), true);
+        jobs_.push_back(std::move(job));
+        not_empty_.notify_one();
+    }
+
+    [[nodiscard]] std::optional<extract_job> pop() {
+        std::unique_lock lock{mutex_};
+        std::optional<size_t> index;
+        not_empty_.wait(lock, [&] {
+            if (error_) {
+                return true;
+            }
+            index = next();
+            return index || (jobs_.empty() && closed_);
+        });
+        if (error_ || !index) {
+            return std::nullopt;
+        }
+        const auto position = jobs_.begin() + static_cast<std::ptrdiff_t>(*index);
+        auto job = std::move(*position);
+        jobs_.erase(position);
+        queued_bytes_ -= job.bytes().size();
+        count(running_, paths_of(job), true);
+        not_full_.notify_one();
+        return job;
+    }
+
+    // Release the paths of a job taken by pop()
+    void done(const extract_job& job) {
+        const auto paths = paths_of(job);
+        std::lock_guard lock{mutex_};
+        count(running_, paths, false);
+        count(claimed_, paths, false);
+        not_empty_.notify_all();
+        settled_.notify_all();
+    }
+
+    // Wait until no queued or running job touches path, before writing it elsewhere
+    void settle(const std::string& path) {
+        const size_t key = std::hash<std::string_view>{}(path);
+        std::unique_lock lock{mutex_};
+        settled_.wait(lock, [&] { return !claimed_.contains(key) || error_; });
+    }
+
+    void close() {
+        std::lock_guard lock{mutex_};
+        closed_ = true;
+        not_empty_.notify_all();
+    }
+
+    void fail(error err) {
+        std::lock_guard lock{mutex_};
+        if (!error_) {
+            error_ = std::move(err);
+        }
+        not_empty_.notify_all();
+        not_full_.notify_all();
+        settled_.notify_all();
+    }
+
+    [[nodiscard]] std::optional<error> failure() {
+        std::lock_guard lock{mutex_};
+        return error_;
+    }
+};
+
+// Directories kept open by an extract_context before the cache starts over
+constexpr size_t max_open_directories = 256;
+
+// An open directory, closed once neither the cache nor a caller holds it
+class directory_fd {
+private:
+    int fd_;
+
+public:
+    explicit directory_fd(const int fd) noexcept : fd_(fd) {}
+    directory_fd(const directory_fd&) = delete;
+    directory_fd& operator=(const directory_fd&) = delete;
+    ~directory_fd() { ::close(fd_); }
+
+    [[nodiscard]] int get() const noexcept { return fd_; }
+};
+
+using directory_handle = std::shared_ptr<const directory_fd>;
+
+// An entry's parent directory and its name inside it
+struct placement {
+    directory_handle parent;
+    std::string name;
+};
+
+// Archive path as '/'-separated components below the destination
+// Leading '/', empty and "." components are dropped; ".." is refused.
+auto normalize(const std::filesystem::path& path) -> std::expected<std::string, error> {
+    const std::string text = path.generic_string();
+    std::string result;
+    result.reserve(text.size());
+    size_t begin = 0;
+    while (begin <= text.size()) {
+        size_t end = text.find('/', begin);
+        if (end == std::string::npos) {
+            end = text.size();
+        }
+        const std::string_view component{text.data() + begin, end - begin};
+        if (component == "..") {
+            return std::unexpected(error{error_code::invalid_operation,
+                "Refusing to extract entry outside destination: " + text});
+        }
+        if (!component.empty() && component != ".") {
+            if (!result.empty()) {
+                result += '/';
+            }
+            result += component;
+        }
+        begin = end + 1;
+    }
+    return result;
+}
+
+// Mode bits of archive permissions
+[[nodiscard]] mode_t mode_of(const std::filesystem::perms permissions) noexcept {
+    return static_cast<mode_t>(permissions) & 07777;
+}
+
+// Access and modification times for futimens(), leaving the access time alone
+[[nodiscard]] std::array<timespec, 2> times_of(const std::chrono::system_clock::time_point time) noexcept {
+    const auto seconds = std::chrono::floor<std::chrono::seconds>(time);
+    const auto nanoseconds = std::chrono::duration_cast<std::chrono::nanoseconds>(time - seconds);
+    return {timespec{0, UTIME_OMIT},
+            timespec{static_cast<time_t>(seconds.time_since_epoch().count()), static_cast<long>(nanoseconds.count())}};
+}
+
+#ifdef __linux__
+// ACL in the little-endian system.posix_acl_* xattr layout
+// The kernel wants entries ordered by tag, then by id.
+auto encode_acl(const std::vector<acl_entry>& acl) -> std::string {
+    constexpr uint32_t undefined_id = 0xffffffff;
+    struct record {
+        uint16_t tag;
+        uint16_t perm;
+        uint32_t id;
+    };
+    std::vector<record> records;
+    records.reserve(acl.size());
+    for (const auto& entry : acl) {
+        uint16_t tag = 0;
+        bool qualified = false;
+        switch (entry.entry_type) {
+            case acl_entry::type::user_obj: tag = 0x01; break;
+            case acl_entry::type::user: tag = 0x02; qualified = true; break;
+            case acl_entry::type::group_obj: tag = 0x04; break;
+            case acl_entry::type::group: tag = 0x08; qualified = true; break;
+            case acl_entry::type::mask: tag = 0x10; break;
+            case acl_entry::type::other: tag = 0x20; break;
+        }
+        records.push_back({tag, static_cast<uint16_t>(std::to_underlying(entry.permissions) & 07),
+                           qualified ? entry.id : undefined_id});
+    }
+    std::ranges::sort(records, {}, [](const record& r) { return std::pair{r.tag, r.id}; });
+
+    std::string encoded;
+    encoded.reserve(4 + records.size() * 8);
+    const auto put = [&](const uint32_t value, const int bytes) {
+        for (int i = 0; i < bytes; ++i) {
+            encoded += static_cast<char>((value >> (8 * i)) & 0xff);
+        }
+    };
+    put(2, 4);  // POSIX_ACL_XATTR_VERSION
+    for (const auto& r : records) {
+        put(r.tag, 2);
+        put(r.perm, 2);
+        put(r.id, 4);
+    }
+    return encoded;
+}
+#endif
+
+// Apply metadata to an open file or directory, best effort
+// The owner goes first as chown clears set-id bits, and xattrs before the
+// mode, which may take away the write access user.* attributes need. ACLs
+// follow the mode they extend; the times go last.
+void restore(const int fd, const restore_info& info) {
+    if (info.owner) {
+        (void)::fchown(fd, info.owner->first, info.owner->second);
+    }
+#ifdef __linux__
+    for (const auto& [name, value] : info.xattrs) {
+        ::fsetxattr(fd, name.c_str(), value.data(), value.size(), 0);
+    }
+#endif
+    ::fchmod(fd, mode_of(info.permissions));
+#ifdef __linux__
+    if (!info.access_acl.empty()) {
+        const auto acl = encode_acl(info.access_acl);
+        ::fsetxattr(fd, "system.posix_acl_access", acl.data(), acl.size(), 0);
+    }
+    if (!info.default_acl.empty()) {
+        const auto acl = encode_acl(info.default_acl);
+        ::fsetxattr(fd, "system.posix_acl_default", acl.data(), acl.size(), 0);
+    }
+#endif
+    if (info.modification_time) {
+        const auto times = times_of(*info.modification_time);
+        ::futimens(fd, times.data());
+    }
+}
+
+auto write_all(const int fd, std::span<const std::byte> data, uint64_t offset) -> std::expected<void, error> {
+    while (!data.empty()) {
+        const ssize_t written = ::pwrite(fd, data.data(), data.size(), static_cast<off_t>(offset));
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return std::unexpected(error{error_code::io_error, "Failed to write file data", errno});
+        }
+        data = data.subspan(static_cast<size_t>(written));
+        offset += static_cast<uint64_t>(written);
+    }
+    return {};
+}
+
+// Copy the whole of one open file into another, in the kernel where possible
+auto copy_contents(const int from, const int to) -> std::expected<void, error> {
+    uint64_t offset = 0;
+#ifdef __linux__
+    while (true) {
+        auto in = static_cast<loff_t>(offset);
+        auto out = static_cast<loff_t>(offset);
+        const ssize_t copied = ::copy_file_range(from, &in, to, &out, size_t{1} << 30, 0);
+        if (copied == 0) {
+            return {};
+        }
+        if (copied < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EXDEV || errno == EINVAL || errno == ENOSYS || errno == EOPNOTSUPP) {
+                break;  // Copied through user space below
+            }
+            return std::unexpected(error{error_code::io_error, "Failed to copy file data", errno});
+        }
+        offset += static_cast<uint64_t>(copied);
+    }
+#endif
+    std::vector<std::byte> buffer(256 * 1024);
+    while (true) {
+        const ssize_t got = ::pread(from, buffer.data(), buffer.size(), static_cast<off_t>(offset));
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return std::unexpected(error{error_code::io_error, "Failed to read file data", errno});
+        }
+        if (got == 0) {
+            return {};
+        }
+        if (auto written = write_all(to, std::span{buffer}.first(static_cast<size_t>(got)), offset); !written) {
+            return written;
+        }
+        offset += static_cast<uint64_t>(got);
+    }
+}
+
+// Bytes handed to writeback at a time by file_output
+constexpr uint64_t write_behind_window = 8 * 1024 * 1024;
+
+// Writes the data of one output file, optionally behind the page cache
+// With write-behind, writeback of each window starts as soon as it is
+// written, and the window before it is waited for and dropped from the
+// cache, so at most two windows of the file are dirty or cached at once.
+class file_output {
+private:
+    int fd_;
+    bool write_behind_;
+    uint64_t pending_ = 0;  // Start of written bytes not yet handed to writeback
+    uint64_t end_ = 0;      // End of the last write
+    uint64_t flight_offset_ = 0;
+    uint64_t flight_size_ = 0;  // Range under writeback, 0 if none
+
+    // Wait for the range under writeback and drop it from the cache
+    void settle() {
+#ifdef __linux__
+        if (flight_size_ > 0) {
+            ::sync_file_range(fd_, static_cast<off_t>(flight_offset_), static_cast<off_t>(flight_size_),
+                SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WRITE | SYNC_FILE_RANGE_WAIT_AFTER);
+            ::posix_fadvise(fd_, static_cast<off_t>(flight_offset_), static_cast<off_t>(flight_size_),
+                POSIX_FADV_DONTNEED);
+        }
+#endif
+        flight_size_ = 0;
+    }
+
+    void submit(const uint64_t offset, const uint64_t size) {
+#ifdef __linux__
+        ::sync_file_range(fd_, static_cast<off_t>(offset), static_cast<off_t>(size), SYNC_FILE_RANGE_WRITE);
+#endif
+        settle();
+        flight_offset_ = offset;
+        flight_size_ = size;
+    }
+
+public:
+    file_output(const int fd, const bool write_behind) noexcept : fd_(fd), write_behind_(write_behind) {}
+
+    // Reserve the file's blocks up front, failing early if they do not fit
+    // Only worth it, and only done, for write-behind files
+    [[nodiscard]] std::expected<void, error> preallocate(const uint64_t size) {
+#ifdef __linux__
+        if (write_behind_ && size > 0 && ::fallocate(fd_, 0, 0, static_cast<off_t>(size)) != 0 && errno == ENOSPC) {
+            return std::unexpected(error{error_code::io_error, "Not enough space for file", ENOSPC});
+        }
+#endif
+        (void)size;
+        return {};
+    }
+
+    // Offsets must ascend; a gap between writes is a hole
+    [[nodiscard]] std::expected<void, error> write(std::span<const std::byte> data, uint64_t offset) {
+        if (!write_behind_) {
+            return write_all(fd_, data, offset);
+        }
+        if (offset != end_) {
+            if (end_ > pending_) {
+                submit(pending_, end_ - pending_);
+            }
+            pending_ = offset;
+        }
+        while (!data.empty()) {
+            const size_t chunk = static_cast<size_t>(std::min<uint64_t>(
+                data.size(), pending_ + write_behind_window - offset));
+            if (auto written = write_all(fd_, data.first(chunk), offset); !written) {
+                return written;
+            }
+            data = data.subspan(chunk);
+            offset += chunk;
+            end_ = offset;
+            if (end_ - pending_ == write_behind_window) {
+                submit(pending_, write_behind_window);
+                pending_ = end_;
+            }
+        }
+        return {};
+    }
+
+    // Hand the rest to writeback and wait for it
+    void finish() {
+        if (write_behind_) {
+            if (end_ > pending_) {
+                submit(pending_, end_ - pending_);
+            }
+            settle();
+        }
+    }
+};
+
+// A file_output written front to back, for copy_entry()
+class file_output_sink : public output_stream {
+private:
+    file_output* output_;
+    uint64_t offset_ = 0;
+
+public:
+    explicit file_output_sink(file_output& output) noexcept : output_(&output) {}
+
+    [[nodiscard]] std::expected<void, error> write(const std::span<const std::byte> data) override {
+        auto written = output_->write(data, offset_);
+        offset_ += data.size();
+        return written;
+    }
+};
+
+} // anonymous namespace
+
+struct extract_context::state {
+    directory_handle root;
+    extract_options options;
+    std::mutex mutex;
+    std::unordered_map<std::string, directory_handle> directories;  // By normalized path
+    std::vector<std::pair<std::string, restore_info>> deferred_directories;
+
+    // Open a normalized directory path, creating what is missing
+    // Components are opened with O_NOFOLLOW, a symlink in the way is an error.
+    auto open_directory(const std::string& path) -> std::expected<directory_handle, error> {
+        std::lock_guard lock{mutex};
+        return open_directory_locked(path);
+    }
+
+    auto open_directory_locked(const std::string& path) -> std::expected<directory_handle, error> {
+        if (path.empty()) {
+            return root;
+        }
+        if (auto found = directories.find(path); found != directories.end()) {
+            return found->second;
+        }
+
+        const size_t slash = path.rfind('/');
+        auto parent = open_directory_locked(slash == std::string::npos ? std::string{} : path.substr(0, slash));
+        if (!parent) {
+            return parent;
+        }
+        const char* name = path.c_str() + (slash == std::string::npos ? 0 : slash + 1);
+
+        if (::mkdirat((*parent)->get(), name, 0755) != 0 && errno != EEXIST) {
+            return std::unexpected(error{error_code::io_error, "Failed to create directory", errno});
+        }
+        const int fd = ::openat((*parent)->get(), name, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+        if (fd < 0) {
+            return std::unexpected(error{error_code::io_error, "Failed to open directory", errno});
+        }
+
+        if (directories.size() >= max_open_directories) {
+            directories.clear();  // Handles still in use stay open until released
+        }
+        auto handle = std::make_shared<const directory_fd>(fd);
+        directories.emplace(path, handle);
+        return handle;
+    }
+
+    auto locate(const std::filesystem::path& path) -> std::expected<placement, error> {
+        auto normalized = normalize(path);
+        if (!normalized) {
+            return std::unexpected(normalized.error());
+        }
+        return place(*normalized);
+    }
+
+    // Parent directory and name of an already normalized path
+    auto place(const std::string& normalized) -> std::expected<placement, error> {
+        if (normalized.empty()) {
+            return std::unexpected(error{error_code::invalid_operation, "Entry has an empty path"});
+        }
+        const size_t slash = normalized.rfind('/');
+        auto parent = open_directory(slash == std::string::npos ? std::string{} : normalized.substr(0, slash));
+        if (!parent) {
+            return std::unexpected(parent.error());
+        }
+        return placement{std::move(*parent), normalized.substr(slash == std::string::npos ? 0 : slash + 1)};
+    }
+
+    // Make where a hard link to source, replacing whatever is there
+    static auto link(const placement& source, const placement& where) -> std::expected<void, error> {
+        ::unlinkat(where.parent->get(), where.name.c_str(), 0);
+        if (::linkat(source.parent->get(), source.name.c_str(), where.parent->get(), where.name.c_str(), 0) != 0) {
+            return std::unexpected(error{error_code::io_error, "Failed to create hard link", errno});
+        }
+        return {};
+    }
+
+    // Make where a copy of source sharing its extents, with its own metadata
+    // Filesystems that cannot clone get an ordinary copy.
+    static auto clone(const placement& source, const placement& where, const restore_info& info)
+        -> std::expected<void, error> {
+        const int from = ::openat(source.parent->get(), source.name.c_str(), O_RDONLY | O_NOFOLLOW | O_CLOEXEC);
+        if (from < 0) {
+            return std::unexpected(error{error_code::io_error, "Failed to open file to copy", errno});
+        }
+        auto fd = create_file(where);
+        if (!fd) {
+            ::close(from);
+            return std::unexpected(fd.error());
+        }
+        std::expected<void, error> copied;
+#ifdef FICLONE
+        if (::ioctl(*fd, FICLONE, from) != 0) {
+            copied = copy_contents(from, *fd);
+        }
+#else
+        copied = copy_contents(from, *fd);
+#endif
+        ::close(from);
+        if (!copied) {
+            ::close(*fd);
+            return copied;
+        }
+        return close_file(*fd, info);
+    }
+
+    // Create a regular file, replacing a symlink or file already there
+    // What is there is unlinked rather than truncated, so a file hard linked
+    // to it keeps its content.
+    static auto create_file(const placement& where) -> std::expected<int, error> {
+        constexpr int flags = O_WRONLY | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC;
+        int fd = ::openat(where.parent->get(), where.name.c_str(), flags, 0600);
+        if (fd < 0 && errno == EEXIST) {
+            ::unlinkat(where.parent->get(), where.name.c_str(), 0);
+            fd = ::openat(where.parent->get(), where.name.c_str(), flags, 0600);
+        }
+        if (fd < 0) {
+            return std::unexpected(error{error_code::io_error, "Failed to create output file", errno});
+        }
+        return fd;
+    }
+
+    // Restore metadata (best effort) and close, reporting delayed write errors
+    static auto close_file(const int fd, const restore_info& info) -> std::expected<void, error> {
+        restore(fd, info);
+        if (::close(fd) != 0 && errno != EINTR) {
+            return std::unexpected(error{error_code::io_error, "Failed to write file data", errno});
+        }
+        return {};
+    }
+
+    auto write_file(
+        const std::filesystem::path& path,
+        const restore_info& info,
+        const std::span<const std::byte> data) -> std::expected<void, error> {
+        auto where = locate(path);
+        if (!where) {
+            return std::unexpected(where.error());
+        }
+        auto fd = create_file(*where);
+        if (!fd) {
+            return std::unexpected(fd.error());
+        }
+        file_output output{*fd, options.write_behind_threshold != 0 && data.size() >= options.write_behind_threshold};
+        auto written = output.preallocate(data.size());
+        if (written) {
+            written = output.write(data, 0);
+        }
+        if (!written) {
+            ::close(*fd);
+            return written;
+        }
+        output.finish();
+        return close_file(*fd, info);
+    }
+
+    // Symlinks take an owner and times, their mode means nothing
+    auto create_symlink(
+        const std::filesystem::path& path,
+        const std::filesystem::path& target,
+        const restore_info& info) -> std::expected<void, error> {
+        auto where = locate(path);
+        if (!where) {
+            return std::unexpected(where.error());
+        }
+        const int parent = where->parent->get();
+        const char* name = where->name.c_str();
+        ::unlinkat(parent, name, 0);
+        if (::symlinkat(target.c_str(), parent, name) != 0) {
+            return std::unexpected(error{error_code::io_error, "Failed to create symbolic link", errno});
+        }
+        if (info.owner) {
+            (void)::fchownat(parent, name, info.owner->first, info.owner->second, AT_SYMLINK_NOFOLLOW);
+        }
+        if (info.modification_time) {
+            const auto times = times_of(*info.modification_time);
+            ::utimensat(parent, name, times.data(), AT_SYMLINK_NOFOLLOW);
+        }
+        return {};
+    }
+};
+
+extract_context::extract_context(std::unique_ptr<state> state) : state_(std::move(state)) {}
+
+extract_context::extract_context(extract_context&& other) noexcept = default;
+
+auto extract_context::operator=(extract_context&& other) noexcept -> extract_context& = default;
+
+extract_context::~extract_context() = default;
+
+auto extract_context::open(
+    const std::filesystem::path& dest,
+    const extract_options& options) -> std::expected<extract_context, error> {
+    std::error_code ec;
+    std::filesystem::create_directories(dest, ec);
+    if (ec) {
+        return std::unexpected(error{error_code::io_error,
+            "Failed to create destination directory: " + ec.message()});
+    }
+    const int fd = ::open(dest.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return std::unexpected(error{error_code::io_error, "Failed to open destination directory", errno});
+    }
+    auto shared = std::make_unique<state>();
+    shared->root = std::make_shared<const directory_fd>(fd);
+    shared->options = options;
+    return extract_context{std::move(shared)};
+}
+
+auto extract_context::write_file(
+    const std::filesystem::path& path,
+    const std::filesystem::perms permissions,
+    const std::span<const std::byte> data) -> std::expected<void, error> {
+    restore_info info;
+    info.permissions = permissions;
+    return state_->write_file(path, info, data);
+}
+
+auto extract_context::create_symlink(
+    const std::filesystem::path& path,
+    const std::filesystem::path& target) -> std::expected<void, error> {
+    return state_->create_symlink(path, target, restore_info{});
+}
+
+auto extract_context::create_hard_link(
+    const std::filesystem::path& path,
+    const std::filesystem::path& target) -> std::expected<void, error> {
+    auto source = state_->locate(target);
+    if (!source) {
+        return std::unexpected(source.error());
+    }
+    auto where = state_->locate(path);
+    if (!where) {
+        return std::unexpected(where.error());
+    }
+    return state::link(*source, *where);
+}
+
+auto extract_context::extract(const archive_entry& entry) -> std::expected<void, error> {
+    switch (entry.type()) {
+        case entry_type::directory: {
+            auto normalized = normalize(entry.path());
+            if (!normalized) {
+                return std::unexpected(normalized.error());
+            }
+            if (auto directory = state_->open_directory(*normalized); !directory) {
+                return std::unexpected(directory.error());
+            }
+            auto info = restore_info_of(entry.metadata(), state_->options);
+            std::lock_guard lock{state_->mutex};
+            state_->deferred_directories.emplace_back(std::move(*normalized), std::move(info));
+            return {};
+        }
+
+        case entry_type::regular_file:
+        case entry_type::regular_file_old:
+        case entry_type::contiguous_file: {
+            auto where = state_->locate(entry.path());
+            if (!where) {
+                return std::unexpected(where.error());
+            }
+            auto runs = entry.open_sparse_runs();
+            if (!runs) {
+                return std::unexpected(runs.error());
+            }
+            auto fd = state::create_file(*where);
+            if (!fd) {
+                return std::unexpected(fd.error());
+            }
+            const uint64_t threshold = state_->options.write_behind_threshold;
+            file_output output{*fd, threshold != 0 && entry.size() >= threshold};
+
+            // Data runs land at their offsets, holes are never written
+            auto result = [&]() -> std::expected<void, error> {
+                // Preallocating would fill the holes of sparse entries
+                if (!entry.metadata().sparse_info) {
+                    if (auto reserved = output.preallocate(entry.size()); !reserved) {
+                        return reserved;
+                    }
+                }
+                // Streamed data is read a chunk ahead of the write
+                if (!entry.metadata().sparse_info && !entry.is_mapped()) {
+                    file_output_sink sink{output};
+                    if (auto copied = copy_entry(entry, sink); !copied) {
+                        return std::unexpected(copied.error());
+                    }
+                    output.finish();
+                    return {};
+                }
+                while (true) {
+                    auto run = runs->next_run();
+                    if (!run) {
+                        return std::unexpected(run.error());
+                    }
+                    if (!*run) {
+                        break;
+                    }
+                    if (!(*run)->is_hole()) {
+                        if (auto written = output.write((*run)->data, (*run)->offset); !written) {
+                            return written;
+                        }
+                    }
+                }
+                // A trailing hole only shows in the file size
+                if (entry.metadata().sparse_info && ::ftruncate(*fd, static_cast<off_t>(entry.size())) != 0) {
+                    return std::unexpected(error{error_code::io_error, "Failed to set sparse file size", errno});
+                }
+                output.finish();
+                return {};
+            }();
+            if (!result) {
+                ::close(*fd);
+                return result;
+            }
+            return state::close_file(*fd, restore_info_of(entry.metadata(), state_->options));
+        }
+
+        case entry_type::symbolic_link:
+            if (!entry.link_target()) {
+                return std::unexpected(error{error_code::invalid_operation, "Symbolic link has no target"});
+            }
+            return state_->create_symlink(entry.path(), *entry.link_target(),
+                restore_info_of(entry.metadata(), state_->options));
+
+        case entry_type::hard_link:
+            if (!entry.link_target()) {
+                return std::unexpected(error{error_code::invalid_operation, "Hard link has no target"});
+            }
+            return create_hard_link(entry.path(), *entry.link_target());
+
+        default:
+            return std::unexpected(error{error_code::unsupported_feature,
+                "Extraction of this entry type is not supported"});
+    }
+}
+
+auto extract_context::finish() -> std::expected<void, error> {
+    std::vector<std::pair<std::string, restore_info>> pending;
+    {
+        std::lock_guard lock{state_->mutex};
+        pending = std::move(state_->deferred_directories);
+        state_->deferred_directories.clear();
+    }
+    // Children first: restoring a directory never touches its parent's mtime
+    std::ranges::stable_sort(pending, std::ranges::greater{},
+        [](const auto& dir) { return std::ranges::count(dir.first, '/'); });
+    for (const auto& [path, info] : pending) {
+        auto directory = state_->open_directory(path);
+        if (!directory) {
+            return std::unexpected(directory.error());
+        }
+        restore((*directory)->get(), info);
+    }
+    return {};
+}
+
+namespace {
+
+auto run_job(extract_context::state &context, const extract_job &job) -> std::expected<void, error> {
+    if (job.type == entry_type::symbolic_link) {
+        return context.create_symlink(job.path, job.link_target.value_or(std::string{}), job.info);
+    }
+    if (!job.link_target) {
+        return context.write_file(job.path, job.info, job.bytes());
+    }
+
+    // Links and duplicates, their paths are normalized already and only need their parents opened
+    auto source = context.place(*job.link_target);
+    if (!source) {
+        return std::unexpected(source.error());
+    }
+    auto where = context.place(job.path);
+    if (!where) {
+        return std::unexpected(where.error());
+    }
+    if (job.reuse == dedup_mode::reflink) {
+        return extract_context::state::clone(*source, *where, job.info);
+    }
+    auto result = extract_context::state::link(*source, *where);
+    // A source out of links, e.g. one of many empty files, gets a copy instead
+    if (!result && job.reuse == dedup_mode::hard_link && result.error().system_errno() == EMLINK) {
+        result = extract_context::state::clone(*source, *where, job.info);
+    }
+    return result;
+}
+
+void run_worker(extract_context::state &context, job_queue &queue) {
+    while (auto job = queue.pop()) {
+        auto result = run_job(context, *job);
+        queue.done(*job);
+        if (!result) {
+            queue.fail(std::move(result.error()));
+            return;
+        }
+    }
+}
+
+// Scan the archive and dispatch work, returning once every entry is queued
+auto scan_entries(
+    archive_reader &reader,
+    extract_context &context,
+    const extract_options &options,
+    job_queue &queue) -> std::expected<void, error> {
+    content_table copies;
+    while (true) {
+        if (auto failure = queue.failure()) {
+            return std::unexpected(std::move(*failure));
+        }
+
+        auto next = reader.next_entry();
+        if (!next) {
+            return std::unexpected(next.error());
+        }
+        if (!*next) {
+            return {};
+        }
+        const archive_entry& entry = **next;
+
+        // Refuse escaping paths before anything of the entry is queued
+        auto path = normalize(entry.path());
+        if (!path) {
+            return std::unexpected(path.error());
+        }
+
+        // Note what ends up at path, for dedup
+        const auto remember = [&](std::optional<std::string> key) {
+            if (options.dedup != dedup_mode::none) {
+                copies.record(*path, std::move(key));
+            }
+        };
+
+        switch (entry.type()) {
+            case entry_type::directory: {
+                // Created up front so every later entry finds its parent
+                queue.settle(*path);
+                if (auto result = context.extract(entry); !result) {
+                    return result;
+                }
+                remember(std::nullopt);
+                break;
+            }
+
+            case entry_type::regular_file:
+            case entry_type::regular_file_old:
+            case entry_type::contiguous_file: {
+                // All data has passed through the reader once this returns
+                const auto report_digests = [&] {
+                    if (options.on_digests) {
+                        if (const auto digests = entry.digests()) {
+                            options.on_digests(entry, *digests);
+                        }
+                    }
+                };
+
+                // Too large to buffer, or sparse and written segment by
+                // segment, so streamed to disk from this thread
+                const bool sparse = entry.metadata().sparse_info.has_value();
+                const bool streamed = entry.size() > options.max_queued_bytes || sparse;
+                const bool dedup = options.dedup != dedup_mode::none && !sparse;
+
+                // Buffered data, and mapped data at no cost, is hashed before
+                // anything is written, so a duplicate never reaches the disk
+                std::optional<std::span<const std::byte>> data;
+                if (!streamed || (dedup && reader.is_mapped())) {
+                    auto read = entry.read_data();
+                    if (!read) {
+                        return std::unexpected(read.error());
+                    }
+                    data = *read;
+                }
+                std::optional<std::string> key;
+                if (dedup && data) {
+                    key = dedup_key(entry, options);
+                    if (const auto* source = key ? copies.find(*key) : nullptr; source && *source != *path) {
+                        // Queued after its source, so made once the source is written
+                        queue.push(extract_job{.path = *path, .info = restore_info_of(entry.metadata(), options),
+                            .type = entry.type(), .link_target = *source, .reuse = options.dedup, .data = {}});
+                        remember(std::nullopt);
+                        report_digests();
+                        break;
+                    }
+                }
+
+                if (streamed) {
+                    queue.settle(*path);
+                    if (auto result = context.extract(entry); !result) {
+                        return result;
+                    }
+                    // Hashed on its way to disk, it can serve later duplicates
+                    remember(dedup && !key ? dedup_key(entry, options) : std::move(key));
+                    report_digests();
+                    break;
+                }
+
+                remember(std::move(key));
+                extract_job job{.path = std::move(*path), .info = restore_info_of(entry.metadata(), options),
+                    .type = entry.type(), .link_target = std::nullopt, .reuse = dedup_mode::none, .data = {}};
+                if (reader.is_mapped()) {
+                    // Spans into the mapping stay valid while the reader lives
+                    job.data = *data;
+                } else {
+                    job.data = std::vector<std::byte>(data->begin(), data->end());
+                }
+                queue.push(std::move(job));
+                report_digests();
+                break;
+            }
+
+            case entry_type::symbolic_link: {
+                if (!entry.link_target()) {
+                    return std::unexpected(error{error_code::invalid_operation,
+                        "Symbolic link has no target"});
+                }
+                remember(std::nullopt);
+                queue.push(extract_job{.path = std::move(*path), .info = restore_info_of(entry.metadata(), options),
+                    .type = entry.type(), .link_target = entry.link_target(), .reuse = dedup_mode::none, .data = {}});
+                break;
+            }
+
+            case entry_type::hard_link: {
+                if (!entry.link_target()) {
+                    return std::unexpected(error{error_code::invalid_operation,
+                        "Hard link has no target"});
+                }
+                auto target = normalize(*entry.link_target());
+                if (!target) {
+                    return std::unexpected(target.error());
+                }
+                remember(std::nullopt);
+                queue.push(extract_job{.path = std::move(*path), .info = restore_info_of(entry.metadata(), options),
+                    .type = entry.type(), .link_target = std::move(*target), .reuse = dedup_mode::none, .data = {}});
+                break;
+            }
+
+            default:
+                // Devices, FIFOs and unknown types are not extracted
+                break;
+        }
+    }
+}
+
+} // anonymous namespace
+
+auto extract_archive(
+    archive_reader &reader,
+    const std::filesystem::path &dest,
+    const extract_options &options) -> std::expected<void, error> {
+    auto context = extract_context::open(dest, options);
+    if (!context) {
+        return std::unexpected(context.error());
+    }
+    if (options.dedup != dedup_mode::none) {
+        // Duplicates are matched by SHA-256, whatever else the caller asked for
+        auto digests = options.digests;
+        digests.sha256 = true;
+        reader.enable_digests(digests);
+    } else if (options.on_digests) {
+        reader.enable_digests(options.digests);
+    }
+
+    const unsigned thread_count = options.threads != 0 ?
+        options.threads : std::max(1u, std::thread::hardware_concurrency());
+
+    job_queue queue{options.max_queued_bytes};
+
+    std::expected<void, error> scan_result;
+    {
+        std::vector<std::jthread> workers;
+        workers.reserve(thread_count);
+        for (unsigned i = 0; i < thread_count; ++i) {
+            workers.emplace_back([&context, &queue] { run_worker(*context->state_, queue); });
+        }
+
+        scan_result = scan_entries(reader, *context, options, queue);
+        if (!scan_result) {
+            queue.fail(scan_result.error());
+        }
+        queue.close();
+    }  // Workers drain the queue and join here
+
+    if (!scan_result) {
+        return scan_result;
+    }
+    if (auto failure = queue.failure()) {
+        return std::unexpected(std::move(*failure));
+    }
+
+    // Directory metadata last, once nothing more is written inside them
+    return context->finish();
+}
+
+} // namespace tierone::tar
@@ -22,23 +22,14 @@ namespace tierone::tar::gnu {
 
 auto read_gnu_extension_data(
     input_stream &stream,
-    const size_t data_size
-) -> std::expected<std::string, error> {
-    if (data_size == 0) {
-        return std::string{};
-    }
-    
-    // Read the data in blocks
-    std::string result;
-    result.reserve(data_size);
-    
-    size_t remaining = data_size;
-    std::array<std::byte, detail::BLOCK_SIZE> buffer{};
-    
-    while (remaining > 0) {
-        size_t to_read = std::min(remaining, detail::BLOCK_SIZE);
-        
-        auto read_result = stream.read(std::span{buffer.data(), to_read});
+    const size_t data_size,
+    std::string &out
+) -> std::expected<void, error> {
+    // Read straight into out, reusing whatever capacity it already has
+    out.resize(data_size);
+    size_t filled = 0;
+    while (filled < data_size) {
+        auto read_result = stream.read(std::as_writable_bytes(std::span{out.data() + filled, data_size - filled}));
         if (!read_result) {
             return std::unexpected(read_result.error());
         }
@@ -48,12 +39,7 @@ auto read_gnu_extension_data(
                 "Unexpected end of stream while reading GNU extension data"});
         }
         
-        // Convert bytes to chars and append
-        for (size_t i = 0; i < *read_result; ++i) {
-            result.push_back(static_cast<char>(buffer[i]));
-        }
-        
-        remaining -= *read_result;
+        filled += *read_result;
     }
     
     // Skip padding to next block boundary
@@ -66,10 +52,21 @@ auto read_gnu_extension_data(
     }
     
     // GNU extensions are null-terminated, so remove trailing nulls
-    while (!result.empty() && result.back() == '\0') {
-        result.pop_back();
+    while (!out.empty() && out.back() == '\0') {
+        out.pop_back();
     }
     
+    return {};
+}
+
+auto read_gnu_extension_data(
+    input_stream &stream,
+    const size_t data_size
+) -> std::expected<std::string, error> {
+    std::string result;
+    if (auto read_result = read_gnu_extension_data(stream, data_size, result); !read_result) {
+        return std::unexpected(read_result.error());
+    }
     return result;
 }
 
@@ -18,30 +18,149 @@
 #include <tierone/tar/gnu_tar.hpp>
 #include <tierone/tar/sparse.hpp>
 #include <algorithm>
+#include <cstddef>
 #include <cstring>
 #include <ranges>
 #include <utility>
-#include <utility>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
 
 namespace tierone::tar::detail {
 
+namespace {
+
+constexpr size_t checksum_offset = offsetof(ustar_header, checksum);
+constexpr size_t checksum_length = sizeof(ustar_header::checksum);
+
+// Byte sum and zero test over one header block, selected once per process
+struct block_kernel_table {
+    uint32_t (*sum)(const std::byte* block);
+    bool (*is_zero)(const std::byte* block);
+};
+
+auto load_word(const std::byte* data) -> uint64_t {
+    uint64_t word;
+    std::memcpy(&word, data, sizeof(word));
+    return word;
+}
+
+[[maybe_unused]] uint32_t sum_scalar(const std::byte* block) {
+    // Add byte pairs into 16-bit lanes, 64 words cannot overflow them
+    constexpr uint64_t low_bytes = 0x00FF00FF00FF00FFull;
+    uint64_t lanes = 0;
+    for (size_t i = 0; i < BLOCK_SIZE; i += sizeof(uint64_t)) {
+        const uint64_t word = load_word(block + i);
+        lanes += (word & low_bytes) + ((word >> 8) & low_bytes);
+    }
+    return static_cast<uint32_t>((lanes & 0xFFFF) + ((lanes >> 16) & 0xFFFF) +
+                                 ((lanes >> 32) & 0xFFFF) + (lanes >> 48));
+}
+
+[[maybe_unused]] bool is_zero_scalar(const std::byte* block) {
+    uint64_t bits = 0;
+    for (size_t i = 0; i < BLOCK_SIZE; i += sizeof(uint64_t)) {
+        bits |= load_word(block + i);
+    }
+    return bits == 0;
+}
+
+#if defined(__x86_64__) || defined(_M_X64)
+// SSE2 is part of the x86-64 baseline
+uint32_t sum_sse2(const std::byte* block) {
+    const __m128i zero = _mm_setzero_si128();
+    __m128i acc = zero;
+    for (size_t i = 0; i < BLOCK_SIZE; i += 16) {
+        const __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i));
+        acc = _mm_add_epi64(acc, _mm_sad_epu8(v, zero));
+    }
+    return static_cast<uint32_t>(_mm_cvtsi128_si64(acc) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(acc, acc)));
+}
+
+bool is_zero_sse2(const std::byte* block) {
+    __m128i bits = _mm_setzero_si128();
+    for (size_t i = 0; i < BLOCK_SIZE; i += 16) {
+        bits = _mm_or_si128(bits, _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + i)));
+    }
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(bits, _mm_setzero_si128())) == 0xFFFF;
+}
+
+#if defined(__GNUC__)
+__attribute__((target("avx2"))) uint32_t sum_avx2(const std::byte* block) {
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+    for (size_t i = 0; i < BLOCK_SIZE; i += 32) {
+        const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i));
+        acc = _mm256_add_epi64(acc, _mm256_sad_epu8(v, zero));
+    }
+    const __m128i folded = _mm_add_epi64(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+    return static_cast<uint32_t>(_mm_cvtsi128_si64(folded) + _mm_cvtsi128_si64(_mm_unpackhi_epi64(folded, folded)));
+}
+
+__attribute__((target("avx2"))) bool is_zero_avx2(const std::byte* block) {
+    __m256i bits = _mm256_setzero_si256();
+    for (size_t i = 0; i < BLOCK_SIZE; i += 32) {
+        bits = _mm256_or_si256(bits, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block + i)));
+    }
+    return _mm256_testz_si256(bits, bits) != 0;
+}
+#endif
+#endif
+
+#if defined(__aarch64__)
+// NEON is part of the AArch64 baseline
+uint32_t sum_neon(const std::byte* block) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(block);
+    uint32x4_t acc = vdupq_n_u32(0);
+    for (size_t i = 0; i < BLOCK_SIZE; i += 16) {
+        acc = vpadalq_u16(acc, vpaddlq_u8(vld1q_u8(bytes + i)));
+    }
+    return vaddvq_u32(acc);
+}
+
+bool is_zero_neon(const std::byte* block) {
+    const auto* bytes = reinterpret_cast<const uint8_t*>(block);
+    uint8x16_t bits = vdupq_n_u8(0);
+    for (size_t i = 0; i < BLOCK_SIZE; i += 16) {
+        bits = vorrq_u8(bits, vld1q_u8(bytes + i));
+    }
+    return vmaxvq_u8(bits) == 0;
+}
+#endif
+
+auto select_block_kernels() -> block_kernel_table {
+#if defined(__x86_64__) || defined(_M_X64)
+#if defined(__GNUC__)
+    if (__builtin_cpu_supports("avx2")) {
+        return {sum_avx2, is_zero_avx2};
+    }
+#endif
+    return {sum_sse2, is_zero_sse2};
+#elif defined(__aarch64__)
+    return {sum_neon, is_zero_neon};
+#else
+    return {sum_scalar, is_zero_scalar};
+#endif
+}
+
+auto block_kernels() -> const block_kernel_table& {
+    static const block_kernel_table table = select_block_kernels();
+    return table;
+}
+
+} // anonymous namespace
+
 uint32_t calculate_checksum(std::span<const std::byte, BLOCK_SIZE> block) {
-    uint32_t sum = 0;
-    
-    // Create a copy to zero out the checksum field
-    std::array<std::byte, BLOCK_SIZE> temp_block{};
-    std::ranges::copy(block, temp_block.begin());
-    
-    // Zero out checksum field (bytes 148-155) and fill with spaces
-    auto* header = std::bit_cast<ustar_header*>(temp_block.data());
-    std::ranges::fill(std::span{header->checksum}, ' ');
-    
-    // Calculate sum
-    for (auto byte : temp_block) {
-        sum += static_cast<uint8_t>(byte);
+    // The checksum field counts as eight spaces, so take its bytes back out
+    // instead of patching a copy of the block
+    uint32_t field_sum = 0;
+    for (size_t i = checksum_offset; i < checksum_offset + checksum_length; ++i) {
+        field_sum += static_cast<uint8_t>(block[i]);
     }
-    
-    return sum;
+    return block_kernels().sum(block.data()) - field_sum + checksum_length * ' ';
 }
 
 std::string_view extract_string(std::span<const char> field) {
@@ -53,10 +172,10 @@ std::string_view extract_string(std::span<const char> field) {
 }
 
 bool is_zero_block(std::span<const std::byte, BLOCK_SIZE> block) {
-    return std::ranges::all_of(block, [](auto b) { return b == std::byte{0}; });
+    return block_kernels().is_zero(block.data());
 }
 
-auto parse_header(std::span<const std::byte, BLOCK_SIZE> block) -> std::expected<file_metadata, error> {
+auto validate_header(std::span<const std::byte, BLOCK_SIZE> block) -> std::expected<void, error> {
     const auto* header = std::bit_cast<const ustar_header*>(block.data());
     
     // Verify magic number for POSIX ustar or GNU tar format
@@ -65,8 +184,7 @@ auto parse_header(std::span<const std::byte, BLOCK_SIZE> block) -> std::expected
     bool is_gnu = gnu::is_gnu_tar_magic(magic);
     
     if (!is_ustar && !is_gnu) {
-        return std::unexpected(error{error_code::invalid_header, 
-            "Not a POSIX ustar or GNU tar archive (magic: '" + std::string{magic} + "')"});
+        return std::unexpected(error{error_code::invalid_header, "Not a POSIX ustar or GNU tar archive"});
     }
     
     // Verify version
@@ -86,12 +204,23 @@ auto parse_header(std::span<const std::byte, BLOCK_SIZE> block) -> std::expected
         return std::unexpected(error{error_code::corrupt_archive, "Header checksum mismatch"});
     }
     
+    return {};
+}
+
+auto parse_header(std::span<const std::byte, BLOCK_SIZE> block, const replaced_fields replaced) -> std::expected<file_metadata, error> {
+    const auto* header = std::bit_cast<const ustar_header*>(block.data());
+    
+    if (auto valid = validate_header(block); !valid) {
+        return std::unexpected(valid.error());
+    }
+    const bool is_gnu = gnu::is_gnu_tar_magic(extract_string(std::span{header->magic, 6}));
+    
     // Parse numeric fields
     auto mode = parse_octal(std::span{header->mode});
-    auto uid = parse_octal(std::span{header->uid});
-    auto gid = parse_octal(std::span{header->gid});
-    auto size = parse_octal(std::span{header->size});
-    auto mtime = parse_octal(std::span{header->mtime});
+    auto uid = parse_numeric(std::span{header->uid});
+    auto gid = parse_numeric(std::span{header->gid});
+    auto size = parse_numeric(std::span{header->size});
+    auto mtime = parse_signed_numeric(std::span{header->mtime});
     
     if (!mode || !uid || !gid || !size || !mtime) {
         return std::unexpected(error{error_code::invalid_header, "Failed to parse numeric fields"});
@@ -101,13 +230,15 @@ auto parse_header(std::span<const std::byte, BLOCK_SIZE> block) -> std::expected
     file_metadata meta;
     
     // Build path from prefix + name
-    std::string_view prefix = extract_string(std::span{header->prefix});
-    std::string_view name = extract_string(std::span{header->name});
-    
-    if (!prefix.empty()) {
-        meta.path = std::filesystem::path{prefix} / name;
-    } else {
-        meta.path = name;
+    if (!replaced.path) {
+        std::string_view prefix = extract_string(std::span{header->prefix});
+        std::string_view name = extract_string(std::span{header->name});
+        
+        if (!prefix.empty()) {
+            meta.path = std::filesystem::path{prefix} / name;
+        } else {
+            meta.path = name;
+        }
     }
     
     // Check for sparse file information in GNU tar format
@@ -119,11 +250,13 @@ auto parse_header(std::span<const std::byte, BLOCK_SIZE> block) -> std::expected
             header->typeflag == std::to_underlying(entry_type::gnu_sparse)) {
             // Check if this is a sparse file by looking at the padding area
             // GNU sparse format uses header->padding for sparse entries
+            // A type 'S' file is sparse even if its map starts in extension blocks
+            const bool is_sparse = header->typeflag == std::to_underlying(entry_type::gnu_sparse);
             auto sparse_result = sparse::parse_old_sparse_header(*header);
-            if (sparse_result && !sparse_result->segments.empty()) {
+            if (sparse_result && (is_sparse || !sparse_result->segments.empty())) {
                 meta.sparse_info = std::move(*sparse_result);
                 // For type 'S' files, convert them to regular files since we have the sparse info
-                if (header->typeflag == std::to_underlying(entry_type::gnu_sparse)) {
+                if (is_sparse) {
                     meta.type = entry_type::regular_file;
                 }
             }
@@ -131,7 +264,7 @@ auto parse_header(std::span<const std::byte, BLOCK_SIZE> block) -> std::expected
     }
     
     // Validate path
-    if (meta.path.empty()) {
+    if (!replaced.path && meta.path.empty()) {
         return std::unexpected(error{error_code::invalid_header, "Empty file path"});
     }
     
@@ -156,8 +289,8 @@ auto parse_header(std::span<const std::byte, BLOCK_SIZE> block) -> std::expected
     
     // Parse device numbers for character and block devices
     if (meta.type == entry_type::character_device || meta.type == entry_type::block_device) {
-        auto major = parse_octal(std::span{header->devmajor});
-        auto minor = parse_octal(std::span{header->devminor});
+        auto major = parse_numeric(std::span{header->devmajor});
+        auto minor = parse_numeric(std::span{header->devminor});
         if (major) {
             meta.device_major = static_cast<uint32_t>(*major);
         }
@@ -167,7 +300,7 @@ auto parse_header(std::span<const std::byte, BLOCK_SIZE> block) -> std::expected
     }
     
     // Handle links
-    if (meta.type == entry_type::symbolic_link || meta.type == entry_type::hard_link) {
+    if ((meta.type == entry_type::symbolic_link || meta.type == entry_type::hard_link) && !replaced.link_target) {
         std::string_view linkname = extract_string(std::span{header->linkname});
         if (!linkname.empty()) {
             meta.link_target = std::string{linkname};
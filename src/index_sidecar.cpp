@@ -0,0 +1,462 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <tierone/tar/index_sidecar.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <tuple>
+
+namespace tierone::tar {
+
+namespace {
+
+constexpr char sidecar_magic[8] = {'T', '1', 'T', 'A', 'R', 'I', 'D', 'X'};
+constexpr uint32_t sidecar_version = 1;
+constexpr uint32_t byte_order_mark = 0x01020304;
+
+constexpr uint32_t header_flag_digest = 1u << 0;
+constexpr uint8_t record_flag_link = 1u << 0;
+constexpr uint8_t record_flag_sparse = 1u << 1;
+
+struct raw_header {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint64_t archive_size;
+    int64_t archive_mtime;      // file_time_type ticks of the archive
+    uint64_t record_count;
+    uint64_t records_offset;
+    uint64_t sorted_offset;
+    uint64_t strings_offset;
+    uint64_t strings_size;
+    uint64_t segments_offset;
+    uint64_t segment_count;
+    uint32_t flags;
+    uint32_t reserved;
+    archive_digest digest;
+};
+static_assert(sizeof(raw_header) == 128);
+
+struct raw_record {
+    uint64_t header_offset;
+    uint64_t data_offset;
+    uint64_t stored_size;
+    uint64_t size;
+    int64_t mtime;              // Nanoseconds since the epoch
+    uint64_t path_offset;
+    uint64_t link_offset;
+    uint64_t uname_offset;
+    uint64_t gname_offset;
+    uint64_t sparse_real_size;
+    uint64_t segment_first;
+    uint32_t path_length;
+    uint32_t link_length;
+    uint32_t uname_length;
+    uint32_t gname_length;
+    uint32_t mode;
+    uint32_t uid;
+    uint32_t gid;
+    uint32_t device_major;
+    uint32_t device_minor;
+    uint32_t segment_count;
+    uint8_t type;
+    uint8_t flags;
+    uint8_t padding[6];
+};
+static_assert(sizeof(raw_record) == 136);
+
+struct raw_segment {
+    uint64_t offset;
+    uint64_t size;
+};
+
+auto corrupt(const std::string& what) -> error {
+    return error{error_code::corrupt_archive, "Corrupt index sidecar: " + what};
+}
+
+// Records are copied out rather than cast, the mapping carries no alignment guarantee
+template<typename T>
+auto load(const std::span<const std::byte> data, const uint64_t offset) -> T {
+    T value;
+    std::memcpy(&value, data.data() + offset, sizeof(T));
+    return value;
+}
+
+auto table_fits(const uint64_t offset, const uint64_t count, const uint64_t width,
+                const uint64_t file_size) -> bool {
+    if (offset > file_size) {
+        return false;
+    }
+    return count <= (file_size - offset) / width;
+}
+
+auto archive_mtime_ticks(const std::filesystem::path& archive_path) -> std::expected<int64_t, error> {
+    std::error_code ec;
+    const auto mtime = std::filesystem::last_write_time(archive_path, ec);
+    if (ec) {
+        return std::unexpected(error{error_code::io_error,
+            "Failed to stat archive: " + ec.message()});
+    }
+    return static_cast<int64_t>(mtime.time_since_epoch().count());
+}
+
+auto append_string(std::string& strings, const std::string_view value,
+                   uint64_t& offset, uint32_t& length) -> std::expected<void, error> {
+    if (value.size() > UINT32_MAX) {
+        return std::unexpected(error{error_code::unsupported_feature,
+            "String too long for index sidecar"});
+    }
+    offset = strings.size();
+    length = static_cast<uint32_t>(value.size());
+    strings.append(value);
+    return {};
+}
+
+} // anonymous namespace
+
+auto write_index_sidecar(
+    const archive_index &index,
+    const std::filesystem::path &sidecar_path,
+    const std::filesystem::path &archive_path,
+    const sidecar_options &options) -> std::expected<void, error> {
+    std::error_code ec;
+    const auto archive_size = std::filesystem::file_size(archive_path, ec);
+    if (ec) {
+        return std::unexpected(error{error_code::io_error,
+            "Failed to stat archive: " + ec.message()});
+    }
+    auto archive_mtime = archive_mtime_ticks(archive_path);
+    if (!archive_mtime) {
+        return std::unexpected(archive_mtime.error());
+    }
+
+    const auto records = index.records();
+    std::vector<raw_record> raw_records;
+    raw_records.reserve(records.size());
+    std::vector<raw_segment> segments;
+    std::string strings;
+
+    for (const auto& [metadata, location] : records) {
+        raw_record raw{};
+        raw.header_offset = location.header_offset;
+        raw.data_offset = location.data_offset;
+        raw.stored_size = location.stored_size;
+        raw.size = metadata.size;
+        raw.mtime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            metadata.modification_time.time_since_epoch()).count();
+        raw.mode = static_cast<uint32_t>(metadata.permissions);
+        raw.uid = metadata.owner_id;
+        raw.gid = metadata.group_id;
+        raw.device_major = metadata.device_major;
+        raw.device_minor = metadata.device_minor;
+        raw.type = static_cast<uint8_t>(metadata.type);
+
+        const std::string_view link = metadata.link_target ? std::string_view{*metadata.link_target} : std::string_view{};
+        for (auto [value, offset, length] : {
+                 std::tuple{std::string_view{metadata.path.native()}, &raw.path_offset, &raw.path_length},
+                 std::tuple{std::string_view{metadata.owner_name}, &raw.uname_offset, &raw.uname_length},
+                 std::tuple{std::string_view{metadata.group_name}, &raw.gname_offset, &raw.gname_length},
+                 std::tuple{link, &raw.link_offset, &raw.link_length}}) {
+            if (auto appended = append_string(strings, value, *offset, *length); !appended) {
+                return std::unexpected(appended.error());
+            }
+        }
+        if (metadata.link_target) {
+            raw.flags |= record_flag_link;
+        }
+
+        if (metadata.sparse_info) {
+            if (metadata.sparse_info->segments.size() > UINT32_MAX) {
+                return std::unexpected(error{error_code::unsupported_feature,
+                    "Too many sparse segments for index sidecar"});
+            }
+            raw.flags |= record_flag_sparse;
+            raw.sparse_real_size = metadata.sparse_info->real_size;
+            raw.segment_first = segments.size();
+            raw.segment_count = static_cast<uint32_t>(metadata.sparse_info->segments.size());
+            for (const auto& seg : metadata.sparse_info->segments) {
+                segments.push_back({seg.offset, seg.size});
+            }
+        }
+
+        raw_records.push_back(raw);
+    }
+
+    // Same ordering as archive_index: stable by path, so the last duplicate sorts last
+    std::vector<uint64_t> sorted(records.size());
+    for (size_t i = 0; i < sorted.size(); ++i) {
+        sorted[i] = i;
+    }
+    std::ranges::stable_sort(sorted, {}, [&](const uint64_t i) -> std::string_view {
+        return records[i].metadata.path.native();
+    });
+
+    raw_header header{};
+    std::memcpy(header.magic, sidecar_magic, sizeof(sidecar_magic));
+    header.version = sidecar_version;
+    header.byte_order = byte_order_mark;
+    header.archive_size = archive_size;
+    header.archive_mtime = *archive_mtime;
+    header.record_count = raw_records.size();
+    header.records_offset = sizeof(raw_header);
+    header.sorted_offset = header.records_offset + raw_records.size() * sizeof(raw_record);
+    header.segments_offset = header.sorted_offset + sorted.size() * sizeof(uint64_t);
+    header.segment_count = segments.size();
+    header.strings_offset = header.segments_offset + segments.size() * sizeof(raw_segment);
+    header.strings_size = strings.size();
+    if (options.digest) {
+        header.flags |= header_flag_digest;
+        header.digest = *options.digest;
+    }
+
+    auto temp_path = sidecar_path;
+    temp_path += ".tmp";
+    {
+        std::ofstream file{temp_path, std::ios::binary | std::ios::trunc};
+        if (!file) {
+            return std::unexpected(error{error_code::io_error,
+                "Failed to create index sidecar: " + temp_path.string()});
+        }
+
+        const auto write = [&file](const void* data, const size_t size) {
+            file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        };
+        write(&header, sizeof(header));
+        write(raw_records.data(), raw_records.size() * sizeof(raw_record));
+        write(sorted.data(), sorted.size() * sizeof(uint64_t));
+        write(segments.data(), segments.size() * sizeof(raw_segment));
+        write(strings.data(), strings.size());
+
+        file.close();
+        if (!file) {
+            std::filesystem::remove(temp_path, ec);
+            return std::unexpected(error{error_code::io_error, "Failed to write index sidecar"});
+        }
+    }
+
+    std::filesystem::rename(temp_path, sidecar_path, ec);
+    if (ec) {
+        std::filesystem::remove(temp_path, ec);
+        return std::unexpected(error{error_code::io_error,
+            "Failed to install index sidecar: " + ec.message()});
+    }
+    return {};
+}
+
+auto index_sidecar::open(
+    const std::filesystem::path &sidecar_path,
+    const std::filesystem::path &archive_path,
+    const sidecar_options &options) -> std::expected<index_sidecar, error> {
+    index_sidecar sidecar;
+
+#ifdef __linux__
+    auto mapped = mmap_stream::create(sidecar_path);
+    if (!mapped) {
+        return std::unexpected(mapped.error());
+    }
+    sidecar.storage_ = std::make_unique<mmap_stream>(std::move(*mapped));
+    sidecar.data_ = sidecar.storage_->mapped_data().value_or(std::span<const std::byte>{});
+#else
+    std::ifstream file{sidecar_path, std::ios::binary};
+    if (!file) {
+        return std::unexpected(error{error_code::io_error,
+            "Failed to open index sidecar: " + sidecar_path.string()});
+    }
+    const auto contents = std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    sidecar.owned_.resize(contents.size());
+    std::memcpy(sidecar.owned_.data(), contents.data(), contents.size());
+    sidecar.data_ = sidecar.owned_;
+#endif
+
+    const auto data = sidecar.data_;
+    if (data.size() < sizeof(raw_header)) {
+        return std::unexpected(corrupt("file too small"));
+    }
+    const auto header = load<raw_header>(data, 0);
+    if (std::memcmp(header.magic, sidecar_magic, sizeof(sidecar_magic)) != 0) {
+        return std::unexpected(corrupt("bad magic"));
+    }
+    if (header.version != sidecar_version) {
+        return std::unexpected(error{error_code::unsupported_feature,
+            "Unsupported index sidecar version: " + std::to_string(header.version)});
+    }
+    if (header.byte_order != byte_order_mark) {
+        return std::unexpected(error{error_code::unsupported_feature,
+            "Index sidecar was written with a different byte order"});
+    }
+    if (!table_fits(header.records_offset, header.record_count, sizeof(raw_record), data.size()) ||
+        !table_fits(header.sorted_offset, header.record_count, sizeof(uint64_t), data.size()) ||
+        !table_fits(header.segments_offset, header.segment_count, sizeof(raw_segment), data.size()) ||
+        !table_fits(header.strings_offset, header.strings_size, 1, data.size())) {
+        return std::unexpected(corrupt("table out of bounds"));
+    }
+
+    // Freshness check, a stale sidecar must never be trusted
+    if (options.digest) {
+        if (!(header.flags & header_flag_digest) || header.digest != *options.digest) {
+            return std::unexpected(error{error_code::invalid_operation,
+                "Index sidecar does not match archive digest"});
+        }
+    } else {
+        std::error_code ec;
+        const auto archive_size = std::filesystem::file_size(archive_path, ec);
+        if (ec) {
+            return std::unexpected(error{error_code::io_error,
+                "Failed to stat archive: " + ec.message()});
+        }
+        auto archive_mtime = archive_mtime_ticks(archive_path);
+        if (!archive_mtime) {
+            return std::unexpected(archive_mtime.error());
+        }
+        if (archive_size != header.archive_size || *archive_mtime != header.archive_mtime) {
+            return std::unexpected(error{error_code::invalid_operation,
+                "Index sidecar is stale for archive: " + archive_path.string()});
+        }
+    }
+
+    sidecar.record_count_ = header.record_count;
+    return sidecar;
+}
+
+auto index_sidecar::path_of(const size_t record) const noexcept -> std::string_view {
+    if (record >= record_count_) {
+        return {};
+    }
+    const auto header = load<raw_header>(data_, 0);
+    const auto raw = load<raw_record>(data_, header.records_offset + record * sizeof(raw_record));
+    if (raw.path_offset > header.strings_size || raw.path_length > header.strings_size - raw.path_offset) {
+        return {};
+    }
+    return {reinterpret_cast<const char*>(data_.data() + header.strings_offset + raw.path_offset), raw.path_length};
+}
+
+auto index_sidecar::sorted_record(const size_t position) const noexcept -> size_t {
+    const auto header = load<raw_header>(data_, 0);
+    return load<uint64_t>(data_, header.sorted_offset + position * sizeof(uint64_t));
+}
+
+auto index_sidecar::record(const size_t i) const -> std::expected<index_record, error> {
+    if (i >= record_count_) {
+        return std::unexpected(error{error_code::invalid_operation, "Index record out of range"});
+    }
+
+    const auto header = load<raw_header>(data_, 0);
+    const auto raw = load<raw_record>(data_, header.records_offset + i * sizeof(raw_record));
+
+    const auto string_at = [&](const uint64_t offset, const uint32_t length) -> std::expected<std::string, error> {
+        if (offset > header.strings_size || length > header.strings_size - offset) {
+            return std::unexpected(corrupt("string out of bounds"));
+        }
+        return std::string{reinterpret_cast<const char*>(data_.data() + header.strings_offset + offset), length};
+    };
+
+    index_record result;
+    result.location = entry_location{raw.header_offset, raw.data_offset, raw.stored_size};
+
+    auto& metadata = result.metadata;
+    auto path = string_at(raw.path_offset, raw.path_length);
+    auto owner = string_at(raw.uname_offset, raw.uname_length);
+    auto group = string_at(raw.gname_offset, raw.gname_length);
+    if (!path || !owner || !group) {
+        return std::unexpected(corrupt("string out of bounds"));
+    }
+    metadata.path = std::move(*path);
+    metadata.owner_name = std::move(*owner);
+    metadata.group_name = std::move(*group);
+    if (raw.flags & record_flag_link) {
+        auto link = string_at(raw.link_offset, raw.link_length);
+        if (!link) {
+            return std::unexpected(link.error());
+        }
+        metadata.link_target = std::move(*link);
+    }
+
+    metadata.type = static_cast<entry_type>(raw.type);
+    metadata.permissions = static_cast<std::filesystem::perms>(raw.mode);
+    metadata.owner_id = raw.uid;
+    metadata.group_id = raw.gid;
+    metadata.size = raw.size;
+    metadata.modification_time = std::chrono::system_clock::time_point{
+        std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::nanoseconds{raw.mtime})};
+    metadata.device_major = raw.device_major;
+    metadata.device_minor = raw.device_minor;
+
+    if (raw.flags & record_flag_sparse) {
+        if (raw.segment_first > header.segment_count ||
+            raw.segment_count > header.segment_count - raw.segment_first) {
+            return std::unexpected(corrupt("sparse map out of bounds"));
+        }
+        sparse::sparse_metadata sparse_info;
+        sparse_info.real_size = raw.sparse_real_size;
+        sparse_info.segments.reserve(raw.segment_count);
+        for (uint64_t s = 0; s < raw.segment_count; ++s) {
+            const auto seg = load<raw_segment>(data_,
+                header.segments_offset + (raw.segment_first + s) * sizeof(raw_segment));
+            sparse_info.segments.push_back({seg.offset, seg.size});
+        }
+        metadata.sparse_info = std::move(sparse_info);
+    }
+
+    return result;
+}
+
+auto index_sidecar::find(const std::string_view path) const -> std::expected<std::optional<index_record>, error> {
+    // upper_bound over the sorted table, straight out of the mapping
+    size_t low = 0;
+    size_t high = record_count_;
+    while (low < high) {
+        const size_t mid = low + (high - low) / 2;
+        if (path < path_of(sorted_record(mid))) {
+            high = mid;
+        } else {
+            low = mid + 1;
+        }
+    }
+
+    if (low == 0) {
+        return std::nullopt;
+    }
+    const size_t candidate = sorted_record(low - 1);
+    if (candidate >= record_count_) {
+        return std::unexpected(corrupt("sorted table out of range"));
+    }
+    if (path_of(candidate) != path) {
+        return std::nullopt;
+    }
+    auto found = record(candidate);
+    if (!found) {
+        return std::unexpected(found.error());
+    }
+    return std::optional<index_record>{std::move(*found)};
+}
+
+auto index_sidecar::to_index() const -> std::expected<archive_index, error> {
+    std::vector<index_record> records;
+    records.reserve(record_count_);
+    for (size_t i = 0; i < record_count_; ++i) {
+        auto rec = record(i);
+        if (!rec) {
+            return std::unexpected(rec.error());
+        }
+        records.push_back(std::move(*rec));
+    }
+    return archive_index{std::move(records)};
+}
+
+} // namespace tierone::tar
@@ -0,0 +1,227 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <tierone/tar/listing.hpp>
+#include <algorithm>
+#include <string_view>
+#include <tuple>
+
+namespace tierone::tar {
+
+namespace {
+
+// Path without leading "./" or "/", nor a trailing "/"
+auto trim_path(std::string_view path) -> std::string_view {
+    while (path.starts_with("./") || path.starts_with('/')) {
+        path.remove_prefix(path.starts_with('/') ? 1 : 2);
+    }
+    while (path.ends_with('/')) {
+        path.remove_suffix(1);
+    }
+    return path;
+}
+
+// First depth components of the directory holding path
+auto prefix_of(const std::string_view path, const size_t depth) -> std::string_view {
+    const auto slash = path.rfind('/');
+    if (slash == std::string_view::npos) {
+        return {};
+    }
+    const auto parent = path.substr(0, slash);
+    size_t end = 0;
+    for (size_t i = 0; i < depth; ++i) {
+        end = parent.find('/', i == 0 ? 0 : end + 1);
+        if (end == std::string_view::npos) {
+            return parent;
+        }
+    }
+    return parent.substr(0, end);
+}
+
+auto totals_for(archive_summary& summary, const entry_type type) -> size_totals& {
+    switch (type) {
+        case entry_type::regular_file:
+        case entry_type::regular_file_old:
+        case entry_type::contiguous_file:
+        case entry_type::gnu_sparse:
+            return summary.regular_files;
+        case entry_type::directory:
+            return summary.directories;
+        case entry_type::symbolic_link:
+            return summary.symbolic_links;
+        case entry_type::hard_link:
+            return summary.hard_links;
+        case entry_type::character_device:
+        case entry_type::block_device:
+            return summary.devices;
+        case entry_type::fifo:
+            return summary.fifos;
+        default:
+            return summary.other;
+    }
+}
+
+// Whether a ranks before b among the largest: bigger, or as big and earlier
+// As a heap order it keeps the member to displace next at the front
+auto ranks_before(const summary_member& a, const summary_member& b) noexcept -> bool {
+    return std::tie(b.size, a.number) < std::tie(a.size, b.number);
+}
+
+} // anonymous namespace
+
+listed_entry::listed_entry(const listed_entry& other, const allocator_type& alloc)
+    : path(other.path, alloc),
+      link_target(other.link_target, alloc),
+      owner_name(other.owner_name, alloc),
+      group_name(other.group_name, alloc),
+      type(other.type),
+      permissions(other.permissions),
+      owner_id(other.owner_id),
+      group_id(other.group_id),
+      size(other.size),
+      modification_time(other.modification_time),
+      sparse(other.sparse) {}
+
+listed_entry::listed_entry(listed_entry&& other, const allocator_type& alloc)
+    : path(std::move(other.path), alloc),
+      link_target(std::move(other.link_target), alloc),
+      owner_name(std::move(other.owner_name), alloc),
+      group_name(std::move(other.group_name), alloc),
+      type(other.type),
+      permissions(other.permissions),
+      owner_id(other.owner_id),
+      group_id(other.group_id),
+      size(other.size),
+      modification_time(other.modification_time),
+      sparse(other.sparse) {}
+
+auto list_entries(archive_reader& reader, std::pmr::memory_resource* resource)
+    -> std::expected<std::pmr::vector<listed_entry>, error> {
+    std::pmr::vector<listed_entry> entries{resource};
+    while (true) {
+        auto view = reader.next_entry_view();
+        if (!view) {
+            return std::unexpected(view.error());
+        }
+        if (!*view) {
+            return entries;
+        }
+        const auto& member = **view;
+
+        auto size = member.size();
+        auto permissions = member.permissions();
+        auto owner_id = member.owner_id();
+        auto group_id = member.group_id();
+        auto modification_time = member.modification_time();
+        if (!size) {
+            return std::unexpected(size.error());
+        }
+        if (!permissions) {
+            return std::unexpected(permissions.error());
+        }
+        if (!owner_id) {
+            return std::unexpected(owner_id.error());
+        }
+        if (!group_id) {
+            return std::unexpected(group_id.error());
+        }
+        if (!modification_time) {
+            return std::unexpected(modification_time.error());
+        }
+
+        // Strings are built in place with the vector's resource
+        auto& entry = entries.emplace_back();
+        entry.path = member.path();
+        if (auto target = member.link_target()) {
+            entry.link_target = *target;
+        }
+        entry.owner_name = member.owner_name();
+        entry.group_name = member.group_name();
+        entry.type = member.type();
+        entry.permissions = *permissions;
+        entry.owner_id = *owner_id;
+        entry.group_id = *group_id;
+        entry.size = *size;
+        entry.modification_time = *modification_time;
+        entry.sparse = member.is_sparse();
+    }
+}
+
+auto summarize(archive_reader& reader, const summary_options& options, std::pmr::memory_resource* resource)
+    -> std::expected<archive_summary, error> {
+    archive_summary summary{resource};
+    summary.largest.reserve(options.largest);
+
+    for (uint64_t number = 0;; ++number) {
+        auto view = reader.next_entry_view();
+        if (!view) {
+            return std::unexpected(view.error());
+        }
+        if (!*view) {
+            break;
+        }
+        const auto& member = **view;
+
+        auto stored = member.size();
+        if (!stored) {
+            return std::unexpected(stored.error());
+        }
+        auto size = member.file_size();
+        if (!size) {
+            return std::unexpected(size.error());
+        }
+
+        summary.total.add(*size);
+        summary.stored_bytes += *stored;
+        auto& totals = totals_for(summary, member.type());
+        totals.add(*size);
+        summary.sparse_files += member.is_sparse() ? 1 : 0;
+
+        // Only a prefix not seen before allocates
+        if (options.prefix_depth > 0) {
+            const auto prefix = prefix_of(trim_path(member.path()), options.prefix_depth);
+            auto found = summary.prefixes.find(prefix);
+            if (found == summary.prefixes.end()) {
+                found = summary.prefixes.emplace(std::piecewise_construct,
+                    std::forward_as_tuple(prefix), std::forward_as_tuple()).first;
+            }
+            found->second.add(*size);
+        }
+
+        // Bounded heap of the largest files, the smallest of them at the front
+        if (options.largest == 0 || &totals != &summary.regular_files) {
+            continue;
+        }
+        auto& largest = summary.largest;
+        if (largest.size() < options.largest) {
+            largest.push_back({std::pmr::string{member.path(), resource}, *size, number});
+            std::ranges::push_heap(largest, ranks_before);
+        } else if (*size > largest.front().size) {
+            // Reuse the displaced member's string
+            std::ranges::pop_heap(largest, ranks_before);
+            auto& slot = largest.back();
+            slot.path.assign(member.path());
+            slot.size = *size;
+            slot.number = number;
+            std::ranges::push_heap(largest, ranks_before);
+        }
+    }
+
+    std::ranges::sort(summary.largest, ranks_before);
+    return summary;
+}
+
+} // namespace tierone::tar
@@ -0,0 +1,399 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <tierone/tar/multi_volume.hpp>
+#include <tierone/tar/header_parser.hpp>
+#include <algorithm>
+#include <array>
+#include <format>
+#include <utility>
+
+namespace tierone::tar {
+
+namespace {
+
+// Fields of the GNU headers that open a volume
+constexpr size_t name_length = 100;
+constexpr size_t size_field = 124;
+constexpr size_t checksum_field = 148;
+constexpr size_t type_field = 156;
+constexpr size_t offset_field = 369;  // How much of a continued member earlier volumes hold
+
+constexpr size_t discard_chunk = 64 * 1024;
+
+auto padded(const uint64_t size) -> uint64_t {
+    return (size + detail::BLOCK_SIZE - 1) / detail::BLOCK_SIZE * detail::BLOCK_SIZE;
+}
+
+// Header block opening a volume: a label, a long name or a continuation
+struct volume_header {
+    char type = 0;
+    std::string_view name;
+    uint64_t size = 0;
+    uint64_t offset = 0;
+};
+
+// Decode block if it is a label ('V'), long name ('L') or continuation ('M')
+// GNU tar writes labels and continuations without magic, so only the
+// checksum tells them from data.
+auto parse_volume_header(const std::span<const std::byte, detail::BLOCK_SIZE> block)
+    -> std::optional<volume_header> {
+    const auto* chars = reinterpret_cast<const char*>(block.data());
+    const char type = chars[type_field];
+    if ((type != 'V' && type != 'L' && type != 'M') || detail::is_zero_block(block)) {
+        return std::nullopt;
+    }
+    const auto checksum = detail::parse_octal(std::span<const char, 8>{chars + checksum_field, 8});
+    if (!checksum || *checksum != detail::calculate_checksum(block)) {
+        return std::nullopt;
+    }
+    const auto size = detail::parse_octal(std::span<const char, 12>{chars + size_field, 12});
+    const auto offset = detail::parse_octal(std::span<const char, 12>{chars + offset_field, 12});
+    if (!size || !offset) {
+        return std::nullopt;
+    }
+    return volume_header{type, detail::extract_string(std::span{chars, name_length}), *size, *offset};
+}
+
+// Whether a continuation's name is the member's, which GNU tar cuts to
+// the 100 bytes of the name field
+auto continues(const std::string_view continued, const std::string_view member) -> bool {
+    return continued == member || (continued.size() == name_length && member.starts_with(continued));
+}
+
+// Fill buffer, fewer bytes only at the end of the stream
+auto read_full(input_stream& stream, const std::span<std::byte> buffer) -> std::expected<size_t, error> {
+    size_t total = 0;
+    while (total < buffer.size()) {
+        auto got = stream.read(buffer.subspan(total));
+        if (!got) {
+            return std::unexpected(got.error());
+        }
+        if (*got == 0) {
+            break;
+        }
+        total += *got;
+    }
+    return total;
+}
+
+// Consume the label and continuation headers a volume starts with
+// What follows them is left in head, along with up to prefetch_size bytes
+// read ahead; a long name header is only dropped if it names a continuation.
+auto read_volume_start(input_stream& stream, const size_t prefetch_size, std::vector<std::byte>& head)
+    -> std::expected<std::optional<volume_continuation>, error> {
+    std::vector<std::byte> held;
+    std::string longname;
+    std::optional<volume_continuation> continuation;
+    std::array<std::byte, detail::BLOCK_SIZE> block{};
+
+    while (true) {
+        auto got = read_full(stream, block);
+        if (!got) {
+            return std::unexpected(got.error());
+        }
+        if (*got == 0) {
+            break;
+        }
+        if (*got < detail::BLOCK_SIZE) {
+            return std::unexpected(error{error_code::corrupt_archive, "Incomplete block at start of volume"});
+        }
+
+        const auto header = parse_volume_header(block);
+        if (header && header->type == 'V') {
+            // Labels only name the volume
+            if (auto skipped = stream.skip(padded(header->size)); !skipped) {
+                return std::unexpected(skipped.error());
+            }
+            continue;
+        }
+
+        if (header && header->type == 'L' && held.empty()) {
+            held.assign(block.begin(), block.end());
+            held.resize(detail::BLOCK_SIZE + padded(header->size));
+            auto payload = read_full(stream, std::span{held}.subspan(detail::BLOCK_SIZE));
+            if (!payload) {
+                return std::unexpected(payload.error());
+            }
+            if (*payload != held.size() - detail::BLOCK_SIZE) {
+                return std::unexpected(error{error_code::corrupt_archive, "Incomplete long name at start of volume"});
+            }
+            longname = detail::extract_string(std::span{
+                reinterpret_cast<const char*>(held.data() + detail::BLOCK_SIZE), static_cast<size_t>(header->size)});
+            continue;
+        }
+
+        if (header && header->type == 'M') {
+            continuation = volume_continuation{
+                longname.empty() ? std::string{header->name} : std::move(longname), header->offset, header->size};
+            held.clear();
+            break;
+        }
+
+        // First block of the volume's own content
+        held.insert(held.end(), block.begin(), block.end());
+        break;
+    }
+
+    head = std::move(held);
+    if (const size_t start = head.size(); start < prefetch_size) {
+        head.resize(prefetch_size);
+        auto got = read_full(stream, std::span{head}.subspan(start));
+        if (!got) {
+            return std::unexpected(got.error());
+        }
+        head.resize(start + *got);
+    }
+    return continuation;
+}
+
+} // anonymous namespace
+
+multi_volume_stream::multi_volume_stream(volume_opener open_volume, const size_t prefetch_size)
+    : open_volume_(std::move(open_volume)), prefetch_size_(prefetch_size) {}
+
+// Waits for a prefetch still in flight
+multi_volume_stream::~multi_volume_stream() = default;
+
+auto multi_volume_stream::open(volume_opener open_volume, const size_t prefetch_size)
+    -> std::expected<std::unique_ptr<multi_volume_stream>, error> {
+    std::unique_ptr<multi_volume_stream> stream{new multi_volume_stream(std::move(open_volume), prefetch_size)};
+    auto first = stream->open_volume_(0);
+    if (!first) {
+        return std::unexpected(first.error());
+    }
+    if (!*first) {
+        return std::unexpected(error{error_code::invalid_operation, "No volumes to read"});
+    }
+    stream->current_ = std::move(*first);
+    stream->seekable_ = dynamic_cast<random_access_stream*>(stream->current_.get());
+
+    // The first volume can carry a label too; if it continues a member from
+    // a volume not given, that member's data is of no use and is dropped
+    auto continuation = read_volume_start(*stream->current_, 0, stream->head_);
+    if (!continuation) {
+        return std::unexpected(continuation.error());
+    }
+    if (*continuation) {
+        if (auto skipped = stream->discard(padded((*continuation)->size)); !skipped) {
+            return std::unexpected(skipped.error());
+        }
+    }
+    stream->prefetch_next();
+    return stream;
+}
+
+auto multi_volume_stream::open(std::vector<std::filesystem::path> paths, const size_t prefetch_size)
+    -> std::expected<std::unique_ptr<multi_volume_stream>, error> {
+    auto open_file = [paths = std::move(paths)](const size_t index)
+        -> std::expected<std::unique_ptr<input_stream>, error> {
+        if (index >= paths.size()) {
+            return std::unique_ptr<input_stream>{};
+        }
+#ifdef __linux__
+        if (auto buffered = fd_stream::open(paths[index])) {
+            return std::make_unique<fd_stream>(std::move(*buffered));
+        } else if (buffered.error().code() != error_code::unsupported_feature) {
+            return std::unexpected(buffered.error());
+        }
+#endif
+        auto file = file_stream::open(paths[index]);
+        if (!file) {
+            return std::unexpected(file.error());
+        }
+        return std::make_unique<file_stream>(std::move(*file));
+    };
+    return open(std::move(open_file), prefetch_size);
+}
+
+void multi_volume_stream::prefetch_next() {
+    next_ = std::async(std::launch::async, [this, index = volume_ + 1]() -> std::expected<prefetched_volume, error> {
+        auto stream = open_volume_(index);
+        if (!stream) {
+            return std::unexpected(stream.error());
+        }
+        prefetched_volume volume;
+        if (!*stream) {
+            return volume;
+        }
+        auto continuation = read_volume_start(**stream, prefetch_size_, volume.head);
+        if (!continuation) {
+            return std::unexpected(continuation.error());
+        }
+        volume.continuation = std::move(*continuation);
+        volume.stream = std::move(*stream);
+        return volume;
+    });
+}
+
+auto multi_volume_stream::next_volume() -> std::expected<bool, error> {
+    if (exhausted_) {
+        return false;
+    }
+    auto prefetched = next_.get();
+    if (!prefetched || !prefetched->stream) {
+        exhausted_ = true;
+        if (!prefetched) {
+            return std::unexpected(prefetched.error());
+        }
+        return false;
+    }
+
+    // Check the continuation against the member being read, and find how
+    // much of the new volume repeats data already handed out
+    const size_t index = volume_ + 1;
+    uint64_t overlap = 0;
+    const auto& continuation = prefetched->continuation;
+    if (member_ && position_ < member_->data_start + member_->stored_size) {
+        const uint64_t consumed = position_ - member_->data_start;
+        if (!continuation) {
+            return std::unexpected(error{error_code::corrupt_archive,
+                std::format("Volume {} does not continue {}", index + 1, member_->name)});
+        }
+        if (!continues(continuation->name, member_->name)) {
+            return std::unexpected(error{error_code::corrupt_archive,
+                std::format("Volume {} continues {}, not {}", index + 1, continuation->name, member_->name)});
+        }
+        if (continuation->offset > consumed || continuation->offset + continuation->size != member_->stored_size) {
+            return std::unexpected(error{error_code::corrupt_archive,
+                std::format("Volume {} resumes {} at byte {} of {}, but {} bytes were read", index + 1,
+                            member_->name, continuation->offset, member_->stored_size, consumed)});
+        }
+        overlap = consumed - continuation->offset;
+    } else if (member_ && continuation) {
+        return std::unexpected(error{error_code::corrupt_archive,
+            std::format("Volume {} continues {} after it ended", index + 1, continuation->name)});
+    }
+
+    current_ = std::move(prefetched->stream);
+    seekable_ = dynamic_cast<random_access_stream*>(current_.get());
+    head_ = std::move(prefetched->head);
+    head_position_ = 0;
+    volume_ = index;
+    prefetch_next();
+
+    if (overlap > 0) {
+        auto skipped = discard(static_cast<size_t>(overlap));
+        if (!skipped) {
+            return std::unexpected(skipped.error());
+        }
+        if (*skipped != overlap) {
+            return std::unexpected(error{error_code::corrupt_archive, "Volume ends inside a repeated member"});
+        }
+    }
+    return true;
+}
+
+auto multi_volume_stream::discard(const uint64_t bytes) -> std::expected<uint64_t, error> {
+    uint64_t done = std::min<uint64_t>(bytes, head_.size() - head_position_);
+    head_position_ += static_cast<size_t>(done);
+    if (done == bytes) {
+        return done;
+    }
+
+    if (seekable_) {
+        if (const auto size = seekable_->size()) {
+            const uint64_t count = std::min(bytes - done, *size - std::min(*size, seekable_->position()));
+            if (auto skipped = current_->skip(count); !skipped) {
+                return std::unexpected(skipped.error());
+            }
+            return done + count;
+        }
+    }
+
+    // Without a known size only reading tells where the volume ends
+    scratch_.resize(discard_chunk);
+    while (done < bytes) {
+        auto got = current_->read(std::span{scratch_}.first(
+            static_cast<size_t>(std::min<uint64_t>(scratch_.size(), bytes - done))));
+        if (!got) {
+            return std::unexpected(got.error());
+        }
+        if (*got == 0) {
+            break;
+        }
+        done += *got;
+    }
+    return done;
+}
+
+auto multi_volume_stream::read(const std::span<std::byte> buffer) -> std::expected<size_t, error> {
+    size_t total = 0;
+    while (total < buffer.size()) {
+        const auto rest = buffer.subspan(total);
+        if (head_position_ < head_.size()) {
+            const size_t count = std::min(rest.size(), head_.size() - head_position_);
+            std::copy_n(head_.data() + head_position_, count, rest.data());
+            head_position_ += count;
+            position_ += count;
+            total += count;
+            continue;
+        }
+
+        auto got = current_->read(rest);
+        if (!got) {
+            return std::unexpected(got.error());
+        }
+        if (*got > 0) {
+            position_ += *got;
+            total += *got;
+            continue;
+        }
+
+        auto switched = next_volume();
+        if (!switched) {
+            return std::unexpected(switched.error());
+        }
+        if (!*switched) {
+            break;
+        }
+    }
+    return total;
+}
+
+auto multi_volume_stream::skip(uint64_t bytes) -> std::expected<void, error> {
+    while (bytes > 0) {
+        auto skipped = discard(bytes);
+        if (!skipped) {
+            return std::unexpected(skipped.error());
+        }
+        position_ += *skipped;
+        bytes -= *skipped;
+        if (bytes == 0) {
+            break;
+        }
+
+        auto switched = next_volume();
+        if (!switched) {
+            return std::unexpected(switched.error());
+        }
+        if (!*switched) {
+            break;
+        }
+    }
+    return {};
+}
+
+bool multi_volume_stream::at_end() const {
+    return head_position_ >= head_.size() && exhausted_ && current_->at_end();
+}
+
+void multi_volume_stream::begin_member(const std::string_view name, const uint64_t stored_size) {
+    member_ = member{std::string{name}, position_, stored_size};
+}
+
+} // namespace tierone::tar
@@ -0,0 +1,281 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <tierone/tar/parallel_scan.hpp>
+#include <tierone/tar/header_parser.hpp>
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <vector>
+
+namespace tierone::tar {
+
+namespace {
+
+constexpr size_t size_field = 124;
+constexpr size_t type_field = 156;
+constexpr uint64_t archive_end = std::numeric_limits<uint64_t>::max();
+
+auto padded(const uint64_t size) -> uint64_t {
+    return (size + detail::BLOCK_SIZE - 1) / detail::BLOCK_SIZE * detail::BLOCK_SIZE;
+}
+
+// Entries met following the header chain from one header
+struct chain_walk {
+    std::vector<index_record> records;  // Entries starting before the range end, in order
+    std::optional<uint64_t> next;       // Start of the first entry past the range end
+    std::optional<error> failure;       // Why the chain broke, if it did
+};                                      // Neither next nor failure: end of archive
+
+// Follow the chain from the header at start until an entry starts at or past end
+auto walk_chain(const std::span<const std::byte> archive, const uint64_t start, const uint64_t end) -> chain_walk {
+    chain_walk walk;
+    archive_reader reader{std::make_unique<memory_mapped_stream>(archive.subspan(static_cast<size_t>(start)))};
+    while (true) {
+        auto entry = reader.next_entry();
+        if (!entry) {
+            walk.failure = std::move(entry.error());
+            break;
+        }
+        if (!*entry) {
+            break;
+        }
+        auto location = *reader.current_location();
+        location.header_offset += start;
+        location.data_offset += start;
+        if (location.header_offset >= end) {
+            walk.next = location.header_offset;
+            break;
+        }
+        walk.records.push_back(index_record{(*entry)->metadata(), location});
+    }
+    return walk;
+}
+
+// First block in [from, end) that passes the magic and checksum checks
+auto find_header(const std::span<const std::byte> archive, const uint64_t from, const uint64_t end)
+    -> std::optional<uint64_t> {
+    for (uint64_t position = from; position < end && position + detail::BLOCK_SIZE <= archive.size();
+         position += detail::BLOCK_SIZE) {
+        const std::span<const std::byte, detail::BLOCK_SIZE> block{
+            archive.data() + position, detail::BLOCK_SIZE};
+        if (detail::validate_header(block)) {
+            return position;
+        }
+    }
+    return std::nullopt;
+}
+
+// Walks of one range, from successive candidate headers until one holds up
+// Candidates inside member data usually break their chain quickly; the next
+// candidate after a broken walk's start is tried then.
+auto scan_range(const std::span<const std::byte> archive, const uint64_t begin, const uint64_t end)
+    -> std::vector<chain_walk> {
+    std::vector<chain_walk> walks;
+    uint64_t from = begin;
+    while (const auto start = find_header(archive, from, end)) {
+        walks.push_back(walk_chain(archive, *start, end));
+        if (!walks.back().failure) {
+            break;
+        }
+        from = *start + detail::BLOCK_SIZE;
+    }
+    return walks;
+}
+
+// Whether the headers in front of an entry include a PAX global header
+auto follows_global_header(const std::span<const std::byte> archive, const entry_location& location) -> bool {
+    uint64_t position = location.header_offset;
+    while (position + detail::BLOCK_SIZE <= location.data_offset) {
+        const auto* block = reinterpret_cast<const char*>(archive.data() + position);
+        const char type = block[type_field];
+        if (type == 'g') {
+            return true;
+        }
+        if (type != 'x' && type != 'L' && type != 'K') {
+            return false;
+        }
+        const auto size = detail::parse_octal(std::span<const char, 12>{block + size_field, 12});
+        if (!size) {
+            return false;
+        }
+        position += detail::BLOCK_SIZE + padded(*size);
+    }
+    return false;
+}
+
+// Join the walks of consecutive ranges along the true chain from offset 0
+auto join_ranges(const std::span<const std::byte> archive, const uint64_t range_size,
+                 const std::vector<std::vector<chain_walk>>& walks)
+    -> std::expected<std::vector<index_record>, error> {
+    std::vector<index_record> records;
+    uint64_t next = 0;
+    for (size_t range = 0; range < walks.size(); ++range) {
+        const uint64_t end = range + 1 < walks.size() ? (range + 1) * range_size : archive_end;
+        if (next >= end) {
+            continue;  // Inside the data of a member that started earlier
+        }
+
+        // A walk through the chain's next entry matches it from there on
+        const chain_walk* joined = nullptr;
+        size_t first = 0;
+        for (const auto& walk : walks[range]) {
+            const auto it = std::ranges::lower_bound(walk.records, next, {},
+                [](const index_record& record) { return record.location.header_offset; });
+            if (it != walk.records.end() && it->location.header_offset == next) {
+                joined = &walk;
+                first = static_cast<size_t>(it - walk.records.begin());
+                break;
+            }
+        }
+        chain_walk rewalk;
+        if (!joined) {
+            rewalk = walk_chain(archive, next, end);
+            joined = &rewalk;
+        }
+
+        records.insert(records.end(), joined->records.begin() + static_cast<std::ptrdiff_t>(first),
+                       joined->records.end());
+        if (joined->failure) {
+            return std::unexpected(*joined->failure);
+        }
+        if (!joined->next) {
+            break;
+        }
+        next = *joined->next;
+    }
+    return records;
+}
+
+auto scan_records(const random_access_stream& stream, const scan_options& options)
+    -> std::expected<std::vector<index_record>, error> {
+    const auto mapped = stream.mapped_data();
+    if (!mapped) {
+        return std::unexpected(error{error_code::unsupported_feature,
+            "Parallel scanning requires a memory-backed stream"});
+    }
+    const auto archive = *mapped;
+
+    const unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    const uint64_t range_size = padded(std::max<uint64_t>(options.range_size, detail::BLOCK_SIZE));
+    const size_t ranges = static_cast<size_t>((archive.size() + range_size - 1) / range_size);
+    if (threads == 1 || ranges <= 1) {
+        auto walk = walk_chain(archive, 0, archive_end);
+        if (walk.failure) {
+            return std::unexpected(*walk.failure);
+        }
+        return std::move(walk.records);
+    }
+
+    std::vector<std::vector<chain_walk>> walks(ranges);
+    {
+        std::atomic<size_t> next_range{0};
+        std::vector<std::jthread> workers;
+        for (size_t i = 0; i < std::min<size_t>(threads, ranges); ++i) {
+            workers.emplace_back([&] {
+                for (size_t range = next_range++; range < ranges; range = next_range++) {
+                    walks[range] = scan_range(archive, range * range_size, (range + 1) * range_size);
+                }
+            });
+        }
+    }
+
+    auto records = join_ranges(archive, range_size, walks);
+    if (!records) {
+        return std::unexpected(records.error());
+    }
+
+    // Global headers change the entries after them, which ranges walked
+    // without seeing one got wrong, so parse from the first one in order
+    const auto global = std::ranges::find_if(*records, [&](const index_record& record) {
+        return follows_global_header(archive, record.location);
+    });
+    if (global != records->end()) {
+        auto walk = walk_chain(archive, global->location.header_offset, archive_end);
+        if (walk.failure) {
+            return std::unexpected(*walk.failure);
+        }
+        records->erase(global, records->end());
+        std::ranges::move(walk.records, std::back_inserter(*records));
+    }
+    return records;
+}
+
+} // anonymous namespace
+
+auto scan_archive(const random_access_stream& stream, const scan_options& options)
+    -> std::expected<archive_index, error> {
+    auto records = scan_records(stream, options);
+    if (!records) {
+        return std::unexpected(records.error());
+    }
+    return archive_index{std::move(*records)};
+}
+
+auto for_each_entry(const random_access_stream& stream, const scan_visitor& visit, const scan_options& options)
+    -> std::expected<void, error> {
+    const auto records = scan_records(stream, options);
+    if (!records) {
+        return std::unexpected(records.error());
+    }
+    const auto archive = *stream.mapped_data();
+
+    const unsigned threads = options.threads ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+    const size_t runs = std::min<size_t>(threads, records->size());
+    std::mutex failure_mutex;
+    std::optional<error> failure;
+    std::atomic<bool> stop{false};
+
+    const auto visit_run = [&](const size_t run) {
+        const size_t begin = records->size() * run / runs;
+        const size_t end = records->size() * (run + 1) / runs;
+        for (size_t i = begin; i < end && !stop; ++i) {
+            const auto& location = (*records)[i].location;
+            const auto data = archive.subspan(static_cast<size_t>(location.data_offset),
+                                              static_cast<size_t>(location.stored_size));
+            if (auto result = visit((*records)[i], data); !result) {
+                const std::lock_guard lock{failure_mutex};
+                if (!failure) {
+                    failure = std::move(result.error());
+                }
+                stop = true;
+            }
+        }
+    };
+
+    if (runs <= 1) {
+        if (runs == 1) {
+            visit_run(0);
+        }
+    } else {
+        std::vector<std::jthread> workers;
+        for (size_t run = 0; run < runs; ++run) {
+            workers.emplace_back(visit_run, run);
+        }
+    }
+
+    if (failure) {
+        return std::unexpected(*failure);
+    }
+    return {};
+}
+
+} // namespace tierone::tar
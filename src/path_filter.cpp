@@ -0,0 +1,176 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <tierone/tar/path_filter.hpp>
+#include <algorithm>
+
+namespace tierone::tar {
+
+namespace {
+
+// Match c against the set starting after '[', advancing pattern past ']'
+// A set without a closing ']' matches a literal '['.
+auto match_set(std::string_view& pattern, const char c) noexcept -> bool {
+    size_t i = 0;
+    const bool negated = i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^');
+    if (negated) {
+        ++i;
+    }
+    bool found = false;
+    bool first = true;
+    while (i < pattern.size() && (pattern[i] != ']' || first)) {
+        first = false;
+        char low = pattern[i];
+        if (low == '\\' && i + 1 < pattern.size()) {
+            low = pattern[++i];
+        }
+        char high = low;
+        if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']') {
+            high = pattern[i + 2];
+            i += 2;
+        }
+        found = found || (c >= low && c <= high);
+        ++i;
+    }
+    if (i >= pattern.size()) {
+        return c == '[';
+    }
+    pattern.remove_prefix(i + 1);
+    return found != negated;
+}
+
+auto is_wildcard(const char c) noexcept -> bool {
+    return c == '*' || c == '?' || c == '[' || c == '\\';
+}
+
+auto strip_dot_slash(std::string_view path) noexcept -> std::string_view {
+    while (path.starts_with("./")) {
+        path.remove_prefix(2);
+    }
+    return path;
+}
+
+} // namespace
+
+auto glob_match(std::string_view pattern, std::string_view path) noexcept -> bool {
+    while (!pattern.empty()) {
+        if (pattern.starts_with("**")) {
+            while (pattern.starts_with('*')) {
+                pattern.remove_prefix(1);
+            }
+            if (pattern.empty()) {
+                return true;
+            }
+            // "**/" also stands for no directory at all
+            if (pattern.front() == '/' && glob_match(pattern.substr(1), path)) {
+                return true;
+            }
+            for (size_t i = 0; i <= path.size(); ++i) {
+                if (glob_match(pattern, path.substr(i))) {
+                    return true;
+                }
+            }
+            return false;
+        }
+        if (pattern.front() == '*') {
+            pattern.remove_prefix(1);
+            for (size_t i = 0; i <= path.size(); ++i) {
+                if (glob_match(pattern, path.substr(i))) {
+                    return true;
+                }
+                if (i < path.size() && path[i] == '/') {
+                    break;
+                }
+            }
+            return false;
+        }
+        if (path.empty()) {
+            return false;
+        }
+
+        const char c = path.front();
+        switch (pattern.front()) {
+            case '?':
+                if (c == '/') {
+                    return false;
+                }
+                pattern.remove_prefix(1);
+                break;
+            case '[': {
+                pattern.remove_prefix(1);
+                auto rest = pattern;
+                if (c == '/' || !match_set(rest, c)) {
+                    return false;
+                }
+                pattern = rest;
+                break;
+            }
+            case '\\':
+                if (pattern.size() > 1) {
+                    pattern.remove_prefix(1);
+                }
+                [[fallthrough]];
+            default:
+                if (pattern.front() != c) {
+                    return false;
+                }
+                pattern.remove_prefix(1);
+                break;
+        }
+        path.remove_prefix(1);
+    }
+    return path.empty();
+}
+
+path_filter::path_filter(std::initializer_list<std::string_view> globs) {
+    for (const auto pattern : globs) {
+        add_glob(pattern);
+    }
+}
+
+auto path_filter::add_glob(std::string_view pattern) -> path_filter& {
+    pattern = strip_dot_slash(pattern);
+    const auto wildcard = std::ranges::find_if(pattern, is_wildcard);
+    globs_.push_back({std::string{pattern}, static_cast<size_t>(wildcard - pattern.begin())});
+    return *this;
+}
+
+auto path_filter::add_prefix(const std::string_view prefix) -> path_filter& {
+    prefixes_.emplace_back(strip_dot_slash(prefix));
+    return *this;
+}
+
+auto path_filter::matches(std::string_view path) const noexcept -> bool {
+    if (empty()) {
+        return true;
+    }
+    path = strip_dot_slash(path);
+    for (const auto& prefix : prefixes_) {
+        if (path.starts_with(prefix)) {
+            return true;
+        }
+    }
+    for (const auto& [pattern, literal_length] : globs_) {
+        // Most paths are rejected by the literal head without running the matcher
+        if (path.compare(0, literal_length, pattern, 0, literal_length) == 0 &&
+            glob_match(pattern, path)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+} // namespace tierone::tar
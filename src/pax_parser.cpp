@@ -20,13 +20,177 @@
 #include <algorithm>
 #include <sstream>
 #include <utility>
-#include <format>
+#include <optional>
 
 namespace tierone::tar::pax {
 
-auto parse_pax_headers(
-    const std::span<const std::byte> data) -> std::expected<std::map<std::string, std::string>, error> {
-    std::map<std::string, std::string> result;
+namespace {
+
+template<typename T>
+auto parse_number(const std::string_view text) noexcept -> std::optional<T> {
+    T value;
+    if (std::from_chars(text.data(), text.data() + text.size(), value).ec != std::errc{}) {
+        return std::nullopt;
+    }
+    return value;
+}
+
+// Decode a well-known key into its field, during the scan
+void decode_record(extended_header& header, const record& rec) {
+    const auto [key, value] = rec;
+    if (key == "path") {
+        header.path = value;
+    } else if (key == "linkpath") {
+        header.linkpath = value;
+    } else if (key == "size") {
+        header.size = parse_number<uint64_t>(value);
+    } else if (key == "mtime") {
+        header.mtime = parse_number<int64_t>(value);
+    } else if (key == "uid") {
+        header.uid = parse_number<uint32_t>(value);
+    } else if (key == "gid") {
+        header.gid = parse_number<uint32_t>(value);
+    } else if (key == "uname") {
+        header.uname = value;
+    } else if (key == "gname") {
+        header.gname = value;
+    } else if (key.starts_with("GNU.sparse.")) {
+        const auto field = key.substr(11);
+        if (field == "major") {
+            header.gnu_sparse = true;
+            header.sparse_major = parse_number<int>(value).value_or(0);
+        } else if (field == "minor") {
+            header.gnu_sparse = true;
+            header.sparse_minor = parse_number<int>(value).value_or(0);
+        } else if (field == "map") {
+            header.gnu_sparse = true;
+        } else if (field == "realsize") {
+            header.sparse_realsize = parse_number<uint64_t>(value);
+        } else if (field == "name") {
+            header.path = value;  // The header itself names a stand-in
+        }
+    } else if (key.starts_with("SCHILY.xattr.") || key.starts_with("LIBARCHIVE.xattr.") ||
+               key.starts_with("SCHILY.acl.")) {
+        header.has_xattrs_or_acls = true;
+    }
+}
+
+} // namespace
+
+void extended_header::clear() noexcept {
+    // Keep the records' capacity for the next header
+    auto kept = std::move(records);
+    *this = extended_header{};
+    records = std::move(kept);
+    records.clear();
+}
+
+auto extended_header::find(const std::string_view key) const noexcept -> std::optional<std::string_view> {
+    for (auto it = records.rbegin(); it != records.rend(); ++it) {
+        if (it->key == key) {
+            return it->value;
+        }
+    }
+    return std::nullopt;
+}
+
+void extended_header::apply_to(file_metadata& metadata) const {
+    if (path) {
+        metadata.path = *path;
+    }
+    if (size) {
+        metadata.size = *size;
+    }
+    if (linkpath) {
+        metadata.link_target = std::string{*linkpath};
+    }
+    if (uname) {
+        metadata.owner_name = *uname;
+    }
+    if (gname) {
+        metadata.group_name = *gname;
+    }
+    if (uid) {
+        metadata.owner_id = *uid;
+    }
+    if (gid) {
+        metadata.group_id = *gid;
+    }
+    if (mtime) {
+        metadata.modification_time = std::chrono::system_clock::time_point{std::chrono::seconds{*mtime}};
+    }
+    if (has_xattrs_or_acls) {
+        metadata.xattrs = extract_extended_attributes(*this);
+        auto [access_acl, default_acl] = extract_acls(*this);
+        metadata.access_acl = std::move(access_acl);
+        metadata.default_acl = std::move(default_acl);
+    }
+}
+
+void global_header::merge(const extended_header& header) {
+    for (const auto& [key, value] : header.records) {
+        const auto it = std::ranges::find(records, key, &std::pair<std::string, std::string>::first);
+        if (value.empty()) {
+            if (it != records.end()) {
+                records.erase(it);
+            }
+        } else if (it != records.end()) {
+            it->second = value;
+        } else {
+            records.emplace_back(key, value);
+        }
+
+        if (key == "uname") {
+            uname = value.empty() ? std::nullopt : std::optional<std::string>{value};
+        } else if (key == "gname") {
+            gname = value.empty() ? std::nullopt : std::optional<std::string>{value};
+        } else if (key == "uid") {
+            uid = parse_number<uint32_t>(value);
+        } else if (key == "gid") {
+            gid = parse_number<uint32_t>(value);
+        } else if (key == "mtime") {
+            mtime = parse_number<int64_t>(value);
+        }
+    }
+}
+
+void global_header::clear() noexcept {
+    uname.reset();
+    gname.reset();
+    uid.reset();
+    gid.reset();
+    mtime.reset();
+    records.clear();
+}
+
+auto global_header::find(const std::string_view key) const noexcept -> std::optional<std::string_view> {
+    const auto it = std::ranges::find(records, key, &std::pair<std::string, std::string>::first);
+    if (it == records.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+void global_header::apply_to(file_metadata& metadata) const {
+    if (uname) {
+        metadata.owner_name = *uname;
+    }
+    if (gname) {
+        metadata.group_name = *gname;
+    }
+    if (uid) {
+        metadata.owner_id = *uid;
+    }
+    if (gid) {
+        metadata.group_id = *gid;
+    }
+    if (mtime) {
+        metadata.modification_time = std::chrono::system_clock::time_point{std::chrono::seconds{*mtime}};
+    }
+}
+
+auto parse_records(const std::span<const std::byte> data, extended_header& out) -> std::expected<void, error> {
+    out.clear();
 
     const auto start = reinterpret_cast<const char*>(data.data());
     const char* end = start + data.size();
@@ -40,9 +204,8 @@ auto parse_pax_headers(
         }
         
         if (pos == length_start || pos >= end || *pos != ' ') {
-            const std::string debug_str(length_start, std::min(pos, end));
-            return std::unexpected(error{error_code::invalid_header, 
-                std::format("Invalid PAX header length field, found: '{}'", debug_str)});
+            return std::unexpected(error{error_code::invalid_header, "Invalid PAX header length field"}
+                .at_offset(static_cast<uint64_t>(length_start - start)));
         }
         
         // Extract length
@@ -61,11 +224,10 @@ auto parse_pax_headers(
         
         // Find the record boundary
         const char* record_start = length_start;
-        const char* record_end = record_start + length;
-        
-        if (record_end > end) {
+        if (length > static_cast<size_t>(end - record_start)) {
             return std::unexpected(error{error_code::corrupt_archive, "PAX header record extends beyond data"});
         }
+        const char* record_end = record_start + length;
         
         // Find key=value part
         const char* key_start = pos;
@@ -76,22 +238,37 @@ auto parse_pax_headers(
             --value_end;
         }
         
-        const char* equals_pos = std::find(key_start, value_end, '=');
+        const char* equals_pos = key_start < value_end ? std::find(key_start, value_end, '=') : value_end;
         
         if (equals_pos == value_end) {
             return std::unexpected(error{error_code::invalid_header, "PAX header missing '=' separator"});
         }
         
-        // Extract key and value
-        const std::string key(key_start, equals_pos);
-        const std::string value(equals_pos + 1, value_end);
-        
-        result[key] = value;
+        const record rec{
+            std::string_view{key_start, static_cast<size_t>(equals_pos - key_start)},
+            std::string_view{equals_pos + 1, static_cast<size_t>(value_end - equals_pos - 1)}
+        };
+        out.records.push_back(rec);
+        decode_record(out, rec);
         
         // Move to the next record
         pos = record_end;
     }
     
+    return {};
+}
+
+auto parse_pax_headers(
+    const std::span<const std::byte> data) -> std::expected<std::map<std::string, std::string>, error> {
+    extended_header header;
+    if (auto parsed = parse_records(data, header); !parsed) {
+        return std::unexpected(parsed.error());
+    }
+
+    std::map<std::string, std::string> result;
+    for (const auto& [key, value] : header.records) {
+        result.insert_or_assign(std::string{key}, std::string{value});
+    }
     return result;
 }
 
@@ -140,6 +317,35 @@ extended_attributes extract_extended_attributes(const std::map<std::string, std:
     return result;
 }
 
+extended_attributes extract_extended_attributes(const extended_header& header) {
+    extended_attributes result;
+    for (const auto& [key, value] : header.records) {
+        if (key.starts_with("SCHILY.xattr.")) {
+            result.insert_or_assign(std::string{key.substr(13)}, std::string{value});
+        } else if (key.starts_with("LIBARCHIVE.xattr.")) {
+            result.insert_or_assign(std::string{key.substr(17)}, std::string{value});
+        }
+    }
+    return result;
+}
+
+std::pair<std::vector<acl_entry>, std::vector<acl_entry>>
+extract_acls(const extended_header& header) {
+    std::vector<acl_entry> access_acl;
+    std::vector<acl_entry> default_acl;
+    if (const auto access = header.find("SCHILY.acl.access")) {
+        if (auto parsed_access = parse_acl_text(std::string{*access})) {
+            access_acl = std::move(*parsed_access);
+        }
+    }
+    if (const auto default_text = header.find("SCHILY.acl.default")) {
+        if (auto parsed_default = parse_acl_text(std::string{*default_text})) {
+            default_acl = std::move(*parsed_default);
+        }
+    }
+    return {std::move(access_acl), std::move(default_acl)};
+}
+
 std::pair<std::vector<acl_entry>, std::vector<acl_entry>> 
 extract_acls(const std::map<std::string, std::string>& headers) {
     std::vector<acl_entry> access_acl;
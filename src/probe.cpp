@@ -0,0 +1,56 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <tierone/tar/probe.hpp>
+#include <tierone/tar/header_parser.hpp>
+#include <bit>
+#include <utility>
+
+namespace tierone::tar {
+
+auto probe(const std::span<const std::byte> head) noexcept -> probe_result {
+    probe_result result;
+    result.compression = detect_compression(head);
+    if (result.compression != compression_format::none || head.size() < detail::BLOCK_SIZE) {
+        return result;
+    }
+
+    const auto block = head.first<detail::BLOCK_SIZE>();
+    if (detail::is_zero_block(block)) {
+        if (head.size() >= probe_size && detail::is_zero_block(head.subspan<detail::BLOCK_SIZE, detail::BLOCK_SIZE>())) {
+            result.format = tar_format::empty;
+        }
+        return result;
+    }
+    if (!detail::validate_header(block)) {
+        return result;
+    }
+
+    const auto* header = std::bit_cast<const ustar_header*>(block.data());
+    // GNU tar writes "ustar " where POSIX has "ustar\0"
+    if (header->magic[5] == ' ') {
+        result.format = tar_format::gnu;
+    } else if (header->typeflag == std::to_underlying(entry_type::pax_extended_header) ||
+               header->typeflag == std::to_underlying(entry_type::pax_global_header)) {
+        result.format = tar_format::pax;
+    } else {
+        result.format = tar_format::ustar;
+    }
+    return result;
+}
+
+} // namespace tierone::tar
@@ -0,0 +1,301 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <tierone/tar/push_stream.hpp>
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+namespace tierone::tar {
+
+struct push_stream::ring {
+    std::mutex mutex;
+    std::condition_variable readable;
+    std::condition_variable writable;
+    std::vector<std::byte> data;
+    size_t head = 0;        // Next unread byte
+    size_t count = 0;       // Unread bytes
+    size_t pinned = 0;      // Skipped bytes before head that still back a peek view
+    size_t view_left = 0;   // Bytes of the last peek view not yet skipped
+    uint64_t discard = 0;   // Bytes to drop as they arrive
+    bool finished = false;
+    bool reader_gone = false;
+    std::optional<error> failure;
+    std::function<void()> on_writable;
+    std::vector<std::byte> peek_copy;  // Reader only, for views that wrap
+
+    explicit ring(const size_t capacity) : data(capacity) {}
+
+    [[nodiscard]] size_t free_space() const noexcept { return data.size() - count - pinned; }
+
+    [[nodiscard]] bool ended() const noexcept { return finished || failure.has_value(); }
+
+    // Take bytes from the front of input: dropped while there is discard,
+    // otherwise copied in as far as they fit. Returns the bytes taken.
+    size_t accept(std::span<const std::byte> input) {
+        if (discard > 0) {
+            const size_t dropped = static_cast<size_t>(std::min<uint64_t>(discard, input.size()));
+            discard -= dropped;
+            return dropped;
+        }
+        const size_t n = std::min(input.size(), free_space());
+        const size_t tail = (head + count) % data.size();
+        const size_t first = std::min(n, data.size() - tail);
+        std::memcpy(data.data() + tail, input.data(), first);
+        std::memcpy(data.data(), input.data() + first, n - first);
+        count += n;
+        if (n > 0) {
+            readable.notify_one();
+        }
+        return n;
+    }
+
+    // Copy out the first out.size() unread bytes without consuming them
+    void copy_out(std::span<std::byte> out) const {
+        const size_t first = std::min(out.size(), data.size() - head);
+        std::memcpy(out.data(), data.data() + head, first);
+        std::memcpy(out.data() + first, data.data(), out.size() - first);
+    }
+
+    void consume(const size_t bytes) noexcept {
+        head = (head + bytes) % data.size();
+        count -= bytes;
+    }
+
+    // Return the space behind a peek view to the producer
+    // Any when_writable() callback is handed back to run outside the lock.
+    [[nodiscard]] std::function<void()> release() {
+        pinned = 0;
+        view_left = 0;
+        writable.notify_all();
+        if (free_space() > 0) {
+            return std::exchange(on_writable, nullptr);
+        }
+        return nullptr;
+    }
+
+    // Error for a reader that found no more data, if the end is not clean
+    [[nodiscard]] std::optional<error> end_error() const {
+        if (failure) {
+            return failure;
+        }
+        if (discard > 0) {
+            return error{error_code::io_error, "Skip past end of stream"};
+        }
+        return std::nullopt;
+    }
+};
+
+namespace {
+
+void notify(const std::function<void()>& callback) {
+    if (callback) {
+        callback();
+    }
+}
+
+} // namespace
+
+auto push_stream::create(const size_t capacity) -> std::pair<push_stream, feeder> {
+    auto shared = std::make_shared<ring>(std::max<size_t>(capacity, 512));
+    return {push_stream{shared}, feeder{shared}};
+}
+
+auto push_stream::operator=(push_stream&& other) noexcept -> push_stream& {
+    if (this != &other) {
+        push_stream discarded{std::move(*this)};
+        ring_ = std::move(other.ring_);
+    }
+    return *this;
+}
+
+push_stream::~push_stream() {
+    if (ring_) {
+        std::lock_guard lock{ring_->mutex};
+        ring_->reader_gone = true;
+        ring_->writable.notify_all();
+    }
+}
+
+auto push_stream::read(std::span<std::byte> buffer) -> std::expected<size_t, error> {
+    std::unique_lock lock{ring_->mutex};
+    auto callback = ring_->release();
+    size_t total = 0;
+    while (total < buffer.size()) {
+        ring_->readable.wait(lock, [this] { return ring_->count > 0 || ring_->ended(); });
+        if (ring_->count == 0) {
+            if (auto failure = ring_->end_error(); failure && total == 0) {
+                return std::unexpected(*failure);
+            }
+            break;
+        }
+        const size_t n = std::min(ring_->count, buffer.size() - total);
+        ring_->copy_out(buffer.subspan(total, n));
+        ring_->consume(n);
+        total += n;
+        ring_->writable.notify_all();
+        if (!callback && ring_->on_writable) {
+            callback = std::exchange(ring_->on_writable, nullptr);
+        }
+
+        // Let an event-loop producer refill while this read waits for more
+        if (callback && total < buffer.size()) {
+            lock.unlock();
+            notify(std::exchange(callback, nullptr));
+            lock.lock();
+        }
+    }
+    lock.unlock();
+    notify(callback);
+    return total;
+}
+
+auto push_stream::skip(const uint64_t bytes) -> std::expected<void, error> {
+    std::function<void()> callback;
+    {
+        std::lock_guard lock{ring_->mutex};
+        const size_t dropped = static_cast<size_t>(std::min<uint64_t>(bytes, ring_->count));
+        ring_->consume(dropped);
+        if (dropped <= ring_->view_left) {
+            // Still inside the last peek view, keep its bytes from being overwritten
+            ring_->pinned += dropped;
+            ring_->view_left -= dropped;
+        } else {
+            callback = ring_->release();
+        }
+
+        if (bytes > dropped) {
+            if (ring_->finished) {
+                return std::unexpected(error{error_code::io_error, "Skip past end of stream"});
+            }
+            ring_->discard += bytes - dropped;
+            ring_->writable.notify_all();
+        }
+    }
+    notify(callback);
+    return {};
+}
+
+bool push_stream::at_end() const {
+    std::lock_guard lock{ring_->mutex};
+    return ring_->count == 0 && ring_->finished && ring_->discard == 0;
+}
+
+auto push_stream::peek(const size_t bytes) -> std::expected<std::span<const std::byte>, error> {
+    std::unique_lock lock{ring_->mutex};
+    auto callback = ring_->release();
+    if (callback) {
+        lock.unlock();
+        notify(callback);
+        lock.lock();
+    }
+
+    const size_t wanted = std::min(bytes, ring_->data.size());
+    ring_->readable.wait(lock, [&] { return ring_->count >= wanted || ring_->ended(); });
+    if (ring_->count < wanted) {
+        if (auto failure = ring_->end_error()) {
+            return std::unexpected(*failure);
+        }
+    }
+
+    const size_t n = std::min(wanted, ring_->count);
+    ring_->view_left = n;
+    if (ring_->head + n <= ring_->data.size()) {
+        return std::span<const std::byte>{ring_->data.data() + ring_->head, n};
+    }
+    ring_->peek_copy.resize(n);
+    ring_->copy_out(ring_->peek_copy);
+    return std::span<const std::byte>{ring_->peek_copy};
+}
+
+auto push_stream::feeder::operator=(feeder&& other) noexcept -> feeder& {
+    if (this != &other) {
+        feeder discarded{std::move(*this)};
+        ring_ = std::move(other.ring_);
+    }
+    return *this;
+}
+
+push_stream::feeder::~feeder() {
+    if (ring_) {
+        std::lock_guard lock{ring_->mutex};
+        if (!ring_->ended()) {
+            ring_->failure = error{error_code::io_error, "Stream ended without finish()"};
+            ring_->readable.notify_all();
+        }
+    }
+}
+
+auto push_stream::feeder::push(std::span<const std::byte> data) -> std::expected<void, error> {
+    std::unique_lock lock{ring_->mutex};
+    while (!data.empty()) {
+        if (ring_->reader_gone) {
+            return std::unexpected(error{error_code::invalid_operation, "Reader has closed the stream"});
+        }
+        const size_t taken = ring_->accept(data);
+        data = data.subspan(taken);
+        if (taken == 0) {
+            ring_->writable.wait(lock, [this] {
+                return ring_->reader_gone || ring_->discard > 0 || ring_->free_space() > 0;
+            });
+        }
+    }
+    return {};
+}
+
+auto push_stream::feeder::try_push(std::span<const std::byte> data) -> std::expected<size_t, error> {
+    std::lock_guard lock{ring_->mutex};
+    if (ring_->reader_gone) {
+        return std::unexpected(error{error_code::invalid_operation, "Reader has closed the stream"});
+    }
+    size_t total = 0;
+    while (total < data.size()) {
+        const size_t taken = ring_->accept(data.subspan(total));
+        if (taken == 0) {
+            break;
+        }
+        total += taken;
+    }
+    return total;
+}
+
+void push_stream::feeder::when_writable(std::function<void()> callback) {
+    {
+        std::lock_guard lock{ring_->mutex};
+        if (ring_->free_space() == 0 && ring_->discard == 0 && !ring_->reader_gone) {
+            ring_->on_writable = std::move(callback);
+            return;
+        }
+    }
+    notify(callback);
+}
+
+void push_stream::feeder::finish() {
+    std::lock_guard lock{ring_->mutex};
+    ring_->finished = true;
+    ring_->readable.notify_all();
+}
+
+void push_stream::feeder::fail(error failure) {
+    std::lock_guard lock{ring_->mutex};
+    ring_->failure = std::move(failure);
+    ring_->readable.notify_all();
+}
+
+} // namespace tierone::tar
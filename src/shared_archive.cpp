@@ -0,0 +1,105 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <tierone/tar/shared_archive.hpp>
+#include <cerrno>
+
+namespace tierone::tar {
+
+auto shared_archive::finish(std::shared_ptr<shared_archive> archive)
+    -> std::expected<std::shared_ptr<const shared_archive>, error> {
+    // Index through a throwaway reader, the archive keeps only the records
+    auto reader = archive->reader();
+    auto index = archive_index::build(reader);
+    if (!index) {
+        return std::unexpected(index.error());
+    }
+    archive->index_ = std::move(*index);
+    return archive;
+}
+
+auto shared_archive::open(const std::filesystem::path& path)
+    -> std::expected<std::shared_ptr<const shared_archive>, error> {
+    std::shared_ptr<shared_archive> archive{new shared_archive{}};
+#ifdef __linux__
+    // Threads jump between entries, but each reads its entry front to back,
+    // so keep the kernel's fault-around readahead rather than MADV_RANDOM
+    auto mapped = mmap_stream::create(path, {.pattern = access_pattern::normal});
+    if (!mapped) {
+        return std::unexpected(mapped.error());
+    }
+    archive->mapping_ = std::make_unique<mmap_stream>(std::move(*mapped));
+    archive->data_ = archive->mapping_->mapped_data().value_or(std::span<const std::byte>{});
+#else
+    auto file = file_stream::open(path);
+    if (!file) {
+        return std::unexpected(file.error());
+    }
+    archive->loaded_.resize(file->size().value_or(0));
+    size_t filled = 0;
+    while (filled < archive->loaded_.size()) {
+        auto result = file->read(std::span{archive->loaded_}.subspan(filled));
+        if (!result) {
+            return std::unexpected(result.error());
+        }
+        if (*result == 0) {
+            break;
+        }
+        filled += *result;
+    }
+    archive->loaded_.resize(filled);
+    archive->data_ = archive->loaded_;
+#endif
+    return finish(std::move(archive));
+}
+
+auto shared_archive::open(const std::span<const std::byte> data)
+    -> std::expected<std::shared_ptr<const shared_archive>, error> {
+    std::shared_ptr<shared_archive> archive{new shared_archive{}};
+    archive->data_ = data;
+    return finish(std::move(archive));
+}
+
+auto shared_archive::open_entry(const index_record& record) const -> std::expected<archive_entry, error> {
+    const auto& location = record.location;
+    if (location.data_offset > data_.size() || location.stored_size > data_.size() - location.data_offset) {
+        return std::unexpected(error{error_code::corrupt_archive, "Entry data extends beyond end of archive"});
+    }
+    const auto stored_data = data_.subspan(static_cast<size_t>(location.data_offset),
+                                           static_cast<size_t>(location.stored_size));
+
+    // Each entry gets its own copy of the metadata and its own sparse cursor
+    auto metadata = record.metadata;
+    if (!metadata.sparse_info) {
+        return archive_entry{std::move(metadata), stored_data};
+    }
+    metadata.sparse_info->index_segments();
+    return archive_entry{std::move(metadata), archive_data_source{stored_data}};
+}
+
+auto shared_archive::open_entry(const std::string_view path) const -> std::expected<archive_entry, error> {
+    const auto* record = index_.find(path);
+    if (!record) {
+        return std::unexpected(error{error_code::invalid_operation, "No such entry in archive", ENOENT});
+    }
+    return open_entry(*record);
+}
+
+auto shared_archive::reader() const -> archive_reader {
+    return archive_reader{std::make_unique<memory_mapped_stream>(data_)};
+}
+
+} // namespace tierone::tar
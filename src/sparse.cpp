@@ -21,7 +21,7 @@
 #include <charconv>
 #include <cstring>
 #include <algorithm>
-#include <iostream>
+#include <cstddef>
 
 namespace tierone::tar::sparse {
 
@@ -30,6 +30,16 @@ namespace {
 // GNU sparse format can have embedded nulls and leading junk in octal fields
 // This is a more tolerant parser for sparse-specific fields
 auto parse_sparse_octal(const char *field, size_t size) -> std::optional<uint64_t> {
+    // Well-formed fields, octal or base-256 for 8 GiB and up, decode directly
+    if (size == 12 && field[0] != '\0') {
+        if (const auto value = detail::parse_numeric(std::span<const char, 12>{field, 12})) {
+            return *value;
+        }
+        if ((static_cast<uint8_t>(field[0]) & 0x80) != 0) {
+            return std::nullopt;
+        }
+    }
+
     // Find the longest sequence of octal digits
     uint64_t best_value = 0;
     size_t best_len = 0;
@@ -53,10 +63,27 @@ auto parse_sparse_octal(const char *field, size_t size) -> std::optional<uint64_
         }
     }
     
-    // Remove debug output
     return best_len > 0 ? std::optional{best_value} : std::nullopt;
 }
 
+// Largest number of segments reserved up front from a sparse 1.0 map's count
+// A larger count still parses, the vector grows past it as segments arrive.
+// The count is a few bytes of untrusted input, so it may only buy 64 KiB.
+constexpr uint64_t max_reserved_segments = 4096;
+
+// Append the segments of one map, which ends at the first empty entry
+template<size_t N>
+void append_segments(const gnu_sparse_header::sparse_entry (&entries)[N], sparse_metadata& into) {
+    for (const auto& entry : entries) {
+        const auto offset = parse_sparse_octal(entry.offset, sizeof(entry.offset));
+        const auto size = parse_sparse_octal(entry.numbytes, sizeof(entry.numbytes));
+        if (!offset || !size || *size == 0) {
+            break;
+        }
+        into.segments.push_back({*offset, *size});
+    }
+}
+
 } // anonymous namespace
 
 auto parse_old_sparse_header(
@@ -64,30 +91,10 @@ auto parse_old_sparse_header(
     sparse_metadata result;
     
     // GNU sparse format reuses part of the header for sparse data
-    // Cast the header to our GNU sparse layout
     const auto* sparse_header = reinterpret_cast<const gnu_sparse_header*>(&header);
+    append_segments(sparse_header->sp, result);
     
-    // Remove debug output
-    
-    // Parse the sparse entries from the header at offset 384
-    for (const auto & i : sparse_header->sp) {
-        auto offset = parse_sparse_octal(i.offset, 12);
-        auto size = parse_sparse_octal(i.numbytes, 12);
-        
-        if (!offset || !size || *size == 0) {
-            break;  // No more entries
-        }
-        
-        result.segments.push_back({*offset, *size});
-    }
-    
-    // Check if extended sparse headers follow
-    if (sparse_header->isextended == '1') {
-        // Extended sparse headers follow - we'll need to read them later
-        // This is handled in read_sparse_map_continuation
-    }
-    
-    // Parse real size from header (at offset 481)
+    // Parse real size from header (at offset 483)
     if (const auto real_size = parse_sparse_octal(sparse_header->realsize, 12)) {
         result.real_size = *real_size;
     } else if (!result.segments.empty()) {
@@ -98,6 +105,19 @@ auto parse_old_sparse_header(
     return result;
 }
 
+auto old_map_continues(const std::span<const std::byte, 512> header) noexcept -> bool {
+    return header[offsetof(gnu_sparse_header, typeflag)] == std::byte{'S'} &&
+           header[offsetof(gnu_sparse_header, isextended)] != std::byte{0};
+}
+
+auto parse_old_sparse_extension(
+    const std::span<const std::byte, 512> block,
+    sparse_metadata &into) -> std::expected<bool, tierone::tar::error> {
+    const auto* extension = reinterpret_cast<const gnu_sparse_extension*>(block.data());
+    append_segments(extension->sp, into);
+    return extension_continues(block);
+}
+
 auto parse_sparse_1_0_header(
     const std::map<std::string, std::string> &pax_headers) -> std::expected<sparse_metadata, tierone::tar::error> {
     
@@ -174,6 +194,69 @@ auto parse_sparse_1_0_header(
     return result;
 }
 
+auto map_parser::finish_number() -> std::expected<void, tierone::tar::error> {
+    const uint64_t index = numbers_++;
+    const uint64_t value = value_;
+    value_ = 0;
+    in_number_ = false;
+    
+    if (index == 0) {
+        // The count, two numbers per segment follow
+        if (value > (UINT64_MAX - 1) / 2) {
+            return std::unexpected(tierone::tar::error{tierone::tar::error_code::invalid_header,
+                "Invalid sparse map segment count"});
+        }
+        expected_ = 1 + 2 * value;
+        if (target_) {
+            target_->segments.reserve(target_->segments.size() + std::min(value, max_reserved_segments));
+        }
+        return {};
+    }
+    if (index % 2 == 1) {
+        offset_ = value;
+        return {};
+    }
+    
+    // Segments come in file order and within the file; the last may be empty,
+    // marking a trailing hole, and is not kept
+    if (offset_ < end_ || offset_ > real_size_ || value > real_size_ - offset_) {
+        return std::unexpected(tierone::tar::error{tierone::tar::error_code::invalid_header,
+            "Sparse map segment out of order or beyond end of file"});
+    }
+    end_ = offset_ + value;
+    if (target_ && value > 0) {
+        target_->segments.push_back({offset_, value});
+    }
+    return {};
+}
+
+auto map_parser::feed(const std::span<const std::byte> block) -> std::expected<bool, tierone::tar::error> {
+    ++blocks_;
+    for (const auto byte : block) {
+        if (done()) {
+            break;
+        }
+        const auto c = static_cast<char>(byte);
+        if (c >= '0' && c <= '9') {
+            const auto digit = static_cast<uint64_t>(c - '0');
+            if (value_ > (UINT64_MAX - digit) / 10) {
+                return std::unexpected(tierone::tar::error{tierone::tar::error_code::invalid_header,
+                    "Sparse map number overflow"});
+            }
+            value_ = value_ * 10 + digit;
+            in_number_ = true;
+        } else if (c == '\n' && in_number_) {
+            if (auto result = finish_number(); !result) {
+                return std::unexpected(result.error());
+            }
+        } else {
+            return std::unexpected(tierone::tar::error{tierone::tar::error_code::invalid_header,
+                "Invalid number in sparse map data block"});
+        }
+    }
+    return done();
+}
+
 auto parse_sparse_1_0_data_map(
     tierone::tar::input_stream &stream,
     const uint64_t real_size) -> std::expected<sparse_metadata, tierone::tar::error> {
@@ -182,132 +265,58 @@ auto parse_sparse_1_0_data_map(
     result.real_size = real_size;
     
     // GNU sparse 1.0 stores the sparse map as decimal numbers at the start of the file data
-    // Format: "offset1\nsize1\noffset2\nsize2\n...\n"
-    // Read one block to get the sparse map
+    // Format: "count\noffset1\nsize1\n...\n", padded to a block boundary
+    map_parser parser{&result, real_size};
     std::array<std::byte, 512> block;
-    auto read_result = stream.read(block);
-    if (!read_result) {
-        return std::unexpected(read_result.error());
-    }
-    
-    if (*read_result == 0) {
-        // Empty file
-        return result;
-    }
-    
-    // Convert to string for parsing
-    std::string_view data(reinterpret_cast<const char*>(block.data()), *read_result);
-    
-    // Find the end of the sparse map (double newline or null terminator)
-    size_t map_end = data.find("\n\n");
-    if (map_end == std::string_view::npos) {
-        map_end = data.find('\0');
-        if (map_end == std::string_view::npos) {
-            map_end = data.size();
+    while (true) {
+        auto read_result = stream.read(block);
+        if (!read_result) {
+            return std::unexpected(read_result.error());
         }
-    }
-    
-    std::string_view map_data = data.substr(0, map_end);
-    
-    // Parse the sparse map - GNU format 1.0 uses this structure:
-    // segments_count\noffset1\nsize1\noffset2\nsize2\n...\nreal_size\n0\n
-    std::vector<uint64_t> numbers;
-    
-    size_t pos = 0;
-    while (pos < map_data.size()) {
-        // Skip whitespace and newlines
-        while (pos < map_data.size() && (map_data[pos] == ' ' || map_data[pos] == '\n' || map_data[pos] == '\t')) {
-            ++pos;
+        if (*read_result == 0) {
+            if (parser.blocks() == 0) {
+                return result;  // Empty file
+            }
+            return std::unexpected(tierone::tar::error{tierone::tar::error_code::corrupt_archive,
+                "Sparse map ends before its last segment"});
         }
         
-        if (pos >= map_data.size()) break;
-        
-        // Parse number
-        size_t number_start = pos;
-        while (pos < map_data.size() && map_data[pos] >= '0' && map_data[pos] <= '9') {
-            ++pos;
+        auto done = parser.feed(std::span{block}.first(*read_result));
+        if (!done) {
+            return std::unexpected(done.error());
         }
-        
-        if (pos == number_start) break; // No more numbers
-        
-        uint64_t number;
-        const auto parse_result = std::from_chars(map_data.data() + number_start,
-                                          map_data.data() + pos, number);
-        if (parse_result.ec != std::errc{}) {
-            return std::unexpected(tierone::tar::error{tierone::tar::error_code::invalid_header, 
-                "Invalid number in sparse map data block"});
+        if (*done) {
+            return result;
         }
-        
-        numbers.push_back(number);
     }
-    
-    // Parse the numbers according to GNU sparse 1.0 format
-    // Based on analysis: version, offset1, size1, ..., real_size, 0
-    if (numbers.size() >= 4) {
-        // Skip the first number (might be version/format indicator)
-        // Parse pairs starting from index 1
-        for (size_t i = 1; i + 1 < numbers.size(); i += 2) {
-            const uint64_t offset = numbers[i];
-            const uint64_t size = numbers[i + 1];
-            
-            // Stop if we hit what looks like the real size (larger than reasonable offset+size)
-            // or if we hit the end marker (0)
-            if (size == 0 || size > real_size || offset + size > real_size * 2) {
-                break;
-            }
-            
-            result.segments.push_back({offset, size});
-        }
-    }
-    
-    return result;
 }
 
 auto read_sparse_map_continuation(
-    tierone::tar::input_stream &stream) -> std::expected<std::vector<sparse_entry>, tierone::tar::error> {
-    
-    std::vector<sparse_entry> result;
-    
-    // Read extended sparse headers
-    // Each extended header block contains 21 sparse entries and a continuation flag
-    constexpr size_t SPARSE_EXT_ENTRIES = 21;
-    constexpr size_t SPARSE_EXT_SIZE = 512;
+    tierone::tar::input_stream &stream,
+    sparse_metadata &into) -> std::expected<size_t, tierone::tar::error> {
     
+    // Each extension block holds 21 segments and a continuation flag
+    size_t blocks = 0;
     while (true) {
-        std::array<std::byte, SPARSE_EXT_SIZE> block{};
+        std::array<std::byte, 512> block{};
         auto read_result = stream.read(block);
         if (!read_result) {
             return std::unexpected(read_result.error());
         }
         
-        if (*read_result != SPARSE_EXT_SIZE) {
+        if (*read_result != block.size()) {
             return std::unexpected(tierone::tar::error{tierone::tar::error_code::corrupt_archive, "Incomplete sparse extension block"});
         }
+        ++blocks;
         
-        // Parse sparse entries
-        const char* data = reinterpret_cast<const char*>(block.data());
-        for (size_t i = 0; i < SPARSE_EXT_ENTRIES; ++i) {
-            const char* offset_field = data + (i * 24);
-            const char* size_field = data + (i * 24) + 12;
-            
-            auto offset = parse_sparse_octal(offset_field, 12);
-            auto size = parse_sparse_octal(size_field, 12);
-            
-            if (!offset || !size || *size == 0) {
-                break;  // No more entries
-            }
-            
-            result.push_back({*offset, *size});
+        auto continues = parse_old_sparse_extension(block, into);
+        if (!continues) {
+            return std::unexpected(continues.error());
         }
-        
-        // Check continuation flag
-        char is_extended = data[SPARSE_EXT_ENTRIES * 24];
-        if (is_extended != '1') {
-            break;  // No more extensions
+        if (!*continues) {
+            return blocks;
         }
     }
-    
-    return result;
 }
 
 } // namespace tierone::tar::sparse
\ No newline at end of file
@@ -18,9 +18,13 @@
 #include <cstdio>
 #include <cerrno>
 #include <cstring>
+#include <limits>
+#include <utility>
+#include <sys/types.h>
 
 #ifdef __linux__
 #include <sys/mman.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
@@ -29,23 +33,23 @@
 namespace tierone::tar {
 
 // file_stream implementation
-file_stream::file_stream(std::FILE* file, const std::optional<size_t> size)
+file_stream::file_stream(std::FILE* file, const std::optional<uint64_t> size)
     : file_(file), file_size_(size) {}
 
 auto file_stream::open(const std::filesystem::path &path) -> std::expected<file_stream, error> {
     std::FILE* file = std::fopen(path.c_str(), "rb");
     if (!file) {
         return std::unexpected(error{error_code::io_error, 
-            "Failed to open file: " + std::string{std::strerror(errno)}});
+            "Failed to open file", errno});
     }
     
-    // Try to get file size
-    std::optional<size_t> file_size;
-    if (std::fseek(file, 0, SEEK_END) == 0) {
-        if (const long pos = std::ftell(file); pos >= 0) {
-            file_size = static_cast<size_t>(pos);
+    // Try to get file size, with 64-bit offsets where long is 32 bits
+    std::optional<uint64_t> file_size;
+    if (::fseeko(file, 0, SEEK_END) == 0) {
+        if (const off_t pos = ::ftello(file); pos >= 0) {
+            file_size = static_cast<uint64_t>(pos);
         }
-        std::fseek(file, 0, SEEK_SET);
+        ::fseeko(file, 0, SEEK_SET);
     }
     
     return file_stream{file, file_size};
@@ -56,24 +60,30 @@ auto file_stream::read(std::span<std::byte> buffer) -> std::expected<size_t, err
     
     if (bytes_read == 0 && std::ferror(file_.get())) {
         return std::unexpected(error{error_code::io_error, 
-            "File read error: " + std::string{std::strerror(errno)}});
+            "File read error", errno});
     }
     
     return bytes_read;
 }
 
-auto file_stream::skip(size_t bytes) -> std::expected<void, error> {
-    if (std::fseek(file_.get(), static_cast<long>(bytes), SEEK_CUR) != 0) {
+auto file_stream::skip(uint64_t bytes) -> std::expected<void, error> {
+    if (bytes > static_cast<uint64_t>(std::numeric_limits<off_t>::max())) {
+        return std::unexpected(error{error_code::io_error, "Skip past end of stream", EOVERFLOW});
+    }
+    if (::fseeko(file_.get(), static_cast<off_t>(bytes), SEEK_CUR) != 0) {
         return std::unexpected(error{error_code::io_error, 
-            "File seek error: " + std::string{std::strerror(errno)}});
+            "File seek error", errno});
     }
     return {};
 }
 
-auto file_stream::seek(size_t position) -> std::expected<void, error> {
-    if (std::fseek(file_.get(), static_cast<long>(position), SEEK_SET) != 0) {
+auto file_stream::seek(uint64_t position) -> std::expected<void, error> {
+    if (position > static_cast<uint64_t>(std::numeric_limits<off_t>::max())) {
+        return std::unexpected(error{error_code::io_error, "Seek past end of stream", EOVERFLOW});
+    }
+    if (::fseeko(file_.get(), static_cast<off_t>(position), SEEK_SET) != 0) {
         return std::unexpected(error{error_code::io_error, 
-            "File seek error: " + std::string{std::strerror(errno)}});
+            "File seek error", errno});
     }
     return {};
 }
@@ -81,9 +91,9 @@ auto file_stream::seek(size_t position) -> std::expected<void, error> {
 bool file_stream::at_end() const {
     // If we know the file size, check if position equals size
     if (file_size_.has_value()) {
-        long pos = std::ftell(file_.get());
+        const off_t pos = ::ftello(file_.get());
         if (pos >= 0) {
-            return static_cast<size_t>(pos) >= file_size_.value();
+            return static_cast<uint64_t>(pos) >= file_size_.value();
         }
     }
     
@@ -91,33 +101,328 @@ bool file_stream::at_end() const {
     return std::feof(file_.get()) != 0;
 }
 
-size_t file_stream::position() const {
-    long pos = std::ftell(file_.get());
-    return pos >= 0 ? static_cast<size_t>(pos) : 0;
+uint64_t file_stream::position() const {
+    const off_t pos = ::ftello(file_.get());
+    return pos >= 0 ? static_cast<uint64_t>(pos) : 0;
 }
 
-auto file_stream::size() const -> std::optional<size_t> {
+auto file_stream::size() const -> std::optional<uint64_t> {
     return file_size_;
 }
 
+// read_ahead_stream implementation
+read_ahead_stream::read_ahead_stream(std::unique_ptr<input_stream> source, const size_t window_size)
+    : source_(std::move(source)), window_(std::max<size_t>(window_size, 512)) {}
+
+auto read_ahead_stream::fill(const size_t bytes) -> std::expected<void, error> {
+    // Move the unread tail to the front so the window has room
+    if (begin_ > 0) {
+        std::memmove(window_.data(), window_.data() + begin_, end_ - begin_);
+        end_ -= begin_;
+        begin_ = 0;
+    }
+    
+    while (end_ < bytes) {
+        auto result = source_->read(std::span{window_}.subspan(end_));
+        if (!result) {
+            return std::unexpected(result.error());
+        }
+        if (*result == 0) {
+            break;
+        }
+        end_ += *result;
+    }
+    return {};
+}
+
+auto read_ahead_stream::read(std::span<std::byte> buffer) -> std::expected<size_t, error> {
+    if (begin_ == end_) {
+        // Nothing buffered, large reads skip the window entirely
+        if (buffer.size() >= window_.size()) {
+            return source_->read(buffer);
+        }
+        if (auto result = fill(1); !result) {
+            return std::unexpected(result.error());
+        }
+    }
+    
+    const size_t to_copy = std::min(buffer.size(), end_ - begin_);
+    std::memcpy(buffer.data(), window_.data() + begin_, to_copy);
+    begin_ += to_copy;
+    return to_copy;
+}
+
+auto read_ahead_stream::skip(const uint64_t bytes) -> std::expected<void, error> {
+    const size_t buffered = end_ - begin_;
+    if (bytes <= buffered) {
+        begin_ += static_cast<size_t>(bytes);
+        return {};
+    }
+    begin_ = end_ = 0;
+    return source_->skip(bytes - buffered);
+}
+
+bool read_ahead_stream::at_end() const {
+    return begin_ == end_ && source_->at_end();
+}
+
+auto read_ahead_stream::peek(const size_t bytes) -> std::expected<std::span<const std::byte>, error> {
+    const size_t wanted = std::min(bytes, window_.size());
+    if (end_ - begin_ < wanted) {
+        if (auto result = fill(wanted); !result) {
+            return std::unexpected(result.error());
+        }
+    }
+    return std::span<const std::byte>{window_}.subspan(begin_, std::min(wanted, end_ - begin_));
+}
+
 #ifdef __linux__
+// fd_stream implementation
+namespace {
+
+// Descriptor and size of the regular file at path, read sequentially
+auto open_regular(const std::filesystem::path &path) -> std::expected<std::pair<int, uint64_t>, error> {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return std::unexpected(error{error_code::io_error, 
+            "Failed to open file", errno});
+    }
+    
+    struct stat st{};
+    if (::fstat(fd, &st) == -1) {
+        const int saved_errno = errno;
+        ::close(fd);
+        return std::unexpected(error{error_code::io_error, 
+            "Failed to stat file", saved_errno});
+    }
+    if (!S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return std::unexpected(error{error_code::unsupported_feature, 
+            "Buffered fd stream requires a regular file"});
+    }
+    
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    return std::pair{fd, static_cast<uint64_t>(st.st_size)};
+}
+
+} // anonymous namespace
+
+fd_stream::fd_stream(const int fd, std::unique_ptr<std::byte, buffer_deleter> buffer,
+                     const size_t capacity, const uint64_t size)
+    : fd_(fd), buffer_(std::move(buffer)), buffer_capacity_(capacity), file_size_(size) {}
+
+fd_stream::fd_stream(fd_stream &&other) noexcept
+    : fd_(std::exchange(other.fd_, -1))
+    , buffer_(std::move(other.buffer_))
+    , buffer_capacity_(other.buffer_capacity_)
+    , buffer_offset_(other.buffer_offset_)
+    , buffer_valid_(other.buffer_valid_)
+    , buffer_cursor_(other.buffer_cursor_)
+    , file_size_(other.file_size_) {}
+
+auto fd_stream::operator=(fd_stream &&other) noexcept -> fd_stream& {
+    if (this != &other) {
+        if (fd_ != -1) {
+            ::close(fd_);
+        }
+        fd_ = std::exchange(other.fd_, -1);
+        buffer_ = std::move(other.buffer_);
+        buffer_capacity_ = other.buffer_capacity_;
+        buffer_offset_ = other.buffer_offset_;
+        buffer_valid_ = other.buffer_valid_;
+        buffer_cursor_ = other.buffer_cursor_;
+        file_size_ = other.file_size_;
+    }
+    return *this;
+}
+
+fd_stream::~fd_stream() {
+    if (fd_ != -1) {
+        ::close(fd_);
+    }
+}
+
+auto fd_stream::open(const std::filesystem::path &path, const size_t buffer_size) -> std::expected<fd_stream, error> {
+    auto file = open_regular(path);
+    if (!file) {
+        return std::unexpected(file.error());
+    }
+    
+    // Round the buffer up to whole pages so it also suits O_DIRECT style I/O
+    const size_t capacity = std::max(buffer_alignment,
+        (buffer_size + buffer_alignment - 1) / buffer_alignment * buffer_alignment);
+    std::unique_ptr<std::byte, buffer_deleter> buffer{
+        static_cast<std::byte*>(std::aligned_alloc(buffer_alignment, capacity))};
+    if (!buffer) {
+        ::close(file->first);
+        return std::unexpected(error{error_code::io_error, "Failed to allocate read buffer"});
+    }
+    
+    return fd_stream{file->first, std::move(buffer), capacity, file->second};
+}
+
+auto fd_stream::reopen(const std::filesystem::path &path) -> std::expected<void, error> {
+    auto file = open_regular(path);
+    if (!file) {
+        return std::unexpected(file.error());
+    }
+    if (fd_ != -1) {
+        ::close(fd_);
+    }
+    fd_ = file->first;
+    file_size_ = file->second;
+    buffer_offset_ = 0;
+    buffer_valid_ = 0;
+    buffer_cursor_ = 0;
+    return {};
+}
+
+auto fd_stream::pread_full(std::byte* dest, const size_t length, const uint64_t offset) const
+    -> std::expected<size_t, error> {
+    size_t total = 0;
+    while (total < length) {
+        const ssize_t n = ::pread(fd_, dest + total, length - total, static_cast<off_t>(offset + total));
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return std::unexpected(error{error_code::io_error, 
+                "File read error", errno});
+        }
+        if (n == 0) {
+            break;
+        }
+        total += static_cast<size_t>(n);
+    }
+    return total;
+}
+
+auto fd_stream::read(std::span<std::byte> buffer) -> std::expected<size_t, error> {
+    size_t copied = 0;
+    
+    // Serve what we can from the buffer first
+    if (buffer_cursor_ < buffer_valid_) {
+        copied = std::min(buffer.size(), buffer_valid_ - buffer_cursor_);
+        std::memcpy(buffer.data(), buffer_.get() + buffer_cursor_, copied);
+        buffer_cursor_ += copied;
+        if (copied == buffer.size()) {
+            return copied;
+        }
+    }
+    
+    const uint64_t file_position = buffer_offset_ + buffer_cursor_;
+    const auto rest = buffer.subspan(copied);
+    
+    // Large reads go straight to the caller's memory
+    if (rest.size() >= buffer_capacity_) {
+        auto result = pread_full(rest.data(), rest.size(), file_position);
+        if (!result) {
+            return std::unexpected(result.error());
+        }
+        buffer_offset_ = file_position + *result;
+        buffer_valid_ = 0;
+        buffer_cursor_ = 0;
+        return copied + *result;
+    }
+    
+    // Refill the buffer at the current position
+    auto filled = pread_full(buffer_.get(), buffer_capacity_, file_position);
+    if (!filled) {
+        return std::unexpected(filled.error());
+    }
+    buffer_offset_ = file_position;
+    buffer_valid_ = *filled;
+    buffer_cursor_ = std::min(rest.size(), buffer_valid_);
+    std::memcpy(rest.data(), buffer_.get(), buffer_cursor_);
+    return copied + buffer_cursor_;
+}
+
+auto fd_stream::peek(const size_t bytes) -> std::expected<std::span<const std::byte>, error> {
+    const size_t wanted = std::min(bytes, buffer_capacity_);
+    if (buffer_valid_ - buffer_cursor_ < wanted && buffer_offset_ + buffer_valid_ < file_size_) {
+        // Keep the unread tail and top the buffer up behind it
+        const size_t kept = buffer_valid_ - buffer_cursor_;
+        std::memmove(buffer_.get(), buffer_.get() + buffer_cursor_, kept);
+        buffer_offset_ += buffer_cursor_;
+        buffer_cursor_ = 0;
+        buffer_valid_ = kept;
+        
+        auto filled = pread_full(buffer_.get() + kept, buffer_capacity_ - kept, buffer_offset_ + kept);
+        if (!filled) {
+            return std::unexpected(filled.error());
+        }
+        buffer_valid_ += *filled;
+    }
+    return std::span<const std::byte>{buffer_.get() + buffer_cursor_, std::min(wanted, buffer_valid_ - buffer_cursor_)};
+}
+
+auto fd_stream::skip(const uint64_t bytes) -> std::expected<void, error> {
+    const uint64_t current = position();
+    if (bytes > file_size_ - std::min(current, file_size_)) {
+        return std::unexpected(error{error_code::io_error, "Skip past end of stream"});
+    }
+    return seek(current + bytes);
+}
+
+auto fd_stream::seek(const uint64_t position) -> std::expected<void, error> {
+    if (position > file_size_) {
+        return std::unexpected(error{error_code::io_error, "Seek past end of stream"});
+    }
+    
+    // Stay inside the buffer when the target is already loaded
+    if (position >= buffer_offset_ && position <= buffer_offset_ + buffer_valid_) {
+        buffer_cursor_ = static_cast<size_t>(position - buffer_offset_);
+        return {};
+    }
+    
+    buffer_offset_ = position;
+    buffer_valid_ = 0;
+    buffer_cursor_ = 0;
+    return {};
+}
+
+bool fd_stream::at_end() const {
+    return buffer_offset_ + buffer_cursor_ >= file_size_;
+}
+
+uint64_t fd_stream::position() const {
+    return buffer_offset_ + buffer_cursor_;
+}
+
+auto fd_stream::size() const -> std::optional<uint64_t> {
+    return file_size_;
+}
+
 // mmap_stream implementation
-mmap_stream::mmap_stream(void* ptr, const size_t size)
+namespace {
+
+auto page_size() -> size_t {
+    static const size_t size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+    return size;
+}
+
+} // anonymous namespace
+
+mmap_stream::mmap_stream(void* ptr, const size_t size, const mmap_options& options)
     : mapping_{ptr, mapping_deleter{size}}
-    , data_{static_cast<const std::byte*>(ptr), size} {}
+    , data_{static_cast<const std::byte*>(ptr), size}
+    , options_{options} {}
 
-auto mmap_stream::create(const std::filesystem::path &path) -> std::expected<mmap_stream, error> {
+auto mmap_stream::create(
+    const std::filesystem::path &path,
+    const mmap_options& options) -> std::expected<mmap_stream, error> {
     int fd = ::open(path.c_str(), O_RDONLY);
     if (fd == -1) {
         return std::unexpected(error{error_code::io_error, 
-            "Failed to open file: " + std::string{std::strerror(errno)}});
+            "Failed to open file", errno});
     }
     
     struct stat st{};
     if (::fstat(fd, &st) == -1) {
+        const int saved_errno = errno;
         ::close(fd);
         return std::unexpected(error{error_code::io_error, 
-            "Failed to stat file: " + std::string{std::strerror(errno)}});
+            "Failed to stat file", saved_errno});
     }
 
     const size_t file_size = static_cast<size_t>(st.st_size);
@@ -127,20 +432,90 @@ auto mmap_stream::create(const std::filesystem::path &path) -> std::expected<mma
         // Handle empty files - use nullptr for empty mapping
         ptr = nullptr;
     } else {
-        ptr = ::mmap(nullptr, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        const int flags = MAP_PRIVATE | (options.populate ? MAP_POPULATE : 0);
+        ptr = ::mmap(nullptr, file_size, PROT_READ, flags, fd, 0);
         if (ptr == MAP_FAILED) {
+            const int saved_errno = errno;
             ::close(fd);
             return std::unexpected(error{error_code::io_error, 
-                "Memory mapping failed: " + std::string{std::strerror(errno)}});
+                "Memory mapping failed", saved_errno});
         }
         
-        // Advise kernel about access pattern
-        ::madvise(ptr, file_size, MADV_SEQUENTIAL);
+        // Advise kernel about access pattern, failures only cost speed
+        if (options.pattern == access_pattern::sequential) {
+            ::madvise(ptr, file_size, MADV_SEQUENTIAL);
+        } else if (options.pattern == access_pattern::random) {
+            ::madvise(ptr, file_size, MADV_RANDOM);
+        }
+#ifdef MADV_HUGEPAGE
+        if (options.huge_pages) {
+            ::madvise(ptr, file_size, MADV_HUGEPAGE);
+        }
+#endif
     }
     
     ::close(fd);  // Can close fd after mmap
     
-    return mmap_stream{ptr, file_size};
+    mmap_stream stream{ptr, file_size, options};
+    stream.follow_position();
+    return stream;
+}
+
+void mmap_stream::advise(const size_t begin, const size_t end, const int advice) const {
+    // madvise() wants a page-aligned start, so begin is rounded down to one
+    const size_t aligned = begin / page_size() * page_size();
+    if (end > aligned) {
+        ::madvise(const_cast<std::byte*>(data_.data()) + aligned, end - aligned, advice);
+    }
+}
+
+void mmap_stream::follow_position() {
+    if (options_.pattern != access_pattern::sequential || data_.empty() || options_.window == 0) {
+        return;
+    }
+
+    // Keep at least half a window advised ahead, topped up in steps of
+    // half a window so sequential reads cost few madvise() calls
+    if (position_ < advised_begin_ || position_ + options_.window / 2 > advised_end_) {
+        const bool contiguous = position_ >= advised_begin_ && position_ <= advised_end_;
+        const size_t begin = contiguous ? advised_end_ : position_;
+        const size_t end = std::min(data_.size(), position_ + options_.window);
+        if (end > begin) {
+            advise(begin, end, MADV_WILLNEED);
+        }
+        advised_begin_ = position_;
+        advised_end_ = std::max(end, begin);
+    }
+
+    if (!options_.release_behind) {
+        return;
+    }
+    if (position_ < released_end_) {
+        // Seeked back into released pages, they fault in again on demand
+        released_end_ = position_ / page_size() * page_size();
+    } else if (position_ - released_end_ > 2 * options_.window) {
+        // Whole pages a window behind, never the ones being read
+        const size_t cut = (position_ - options_.window) / page_size() * page_size();
+#ifdef MADV_COLD
+        advise(released_end_, cut, MADV_COLD);
+#endif
+        advise(released_end_, cut, MADV_DONTNEED);
+        released_end_ = cut;
+    }
+}
+
+void mmap_stream::will_need(const uint64_t offset, const uint64_t length) {
+    if (offset >= data_.size() || length == 0) {
+        return;
+    }
+    const auto begin = static_cast<size_t>(offset);
+    const size_t end = begin + static_cast<size_t>(std::min<uint64_t>(length, data_.size() - begin));
+    if (begin >= advised_begin_ && end <= advised_end_) {
+        return;
+    }
+    advise(begin, end, MADV_WILLNEED);
+    advised_begin_ = begin;
+    advised_end_ = end;
 }
 
 auto mmap_stream::read(std::span<std::byte> buffer) -> std::expected<size_t, error> {
@@ -150,23 +525,26 @@ auto mmap_stream::read(std::span<std::byte> buffer) -> std::expected<size_t, err
     std::ranges::copy_n(data_.begin() + static_cast<std::ptrdiff_t>(position_), 
                        static_cast<std::ptrdiff_t>(to_read), buffer.begin());
     position_ += to_read;
+    follow_position();
     
     return to_read;
 }
 
-auto mmap_stream::skip(size_t bytes) -> std::expected<void, error> {
-    if (position_ + bytes > data_.size()) {
+auto mmap_stream::skip(uint64_t bytes) -> std::expected<void, error> {
+    if (bytes > data_.size() - position_) {
         return std::unexpected(error{error_code::io_error, "Skip past end of stream"});
     }
-    position_ += bytes;
+    position_ += static_cast<size_t>(bytes);
+    follow_position();
     return {};
 }
 
-auto mmap_stream::seek(size_t position) -> std::expected<void, error> {
+auto mmap_stream::seek(uint64_t position) -> std::expected<void, error> {
     if (position > data_.size()) {
         return std::unexpected(error{error_code::io_error, "Seek past end of stream"});
     }
-    position_ = position;
+    position_ = static_cast<size_t>(position);
+    follow_position();
     return {};
 }
 
@@ -174,13 +552,370 @@ bool mmap_stream::at_end() const {
     return position_ >= data_.size();
 }
 
-size_t mmap_stream::position() const {
+uint64_t mmap_stream::position() const {
     return position_;
 }
 
-auto mmap_stream::size() const -> std::optional<size_t> {
+auto mmap_stream::size() const -> std::optional<uint64_t> {
     return data_.size();
 }
+
+auto mmap_stream::mapped_data() const -> std::optional<std::span<const std::byte>> {
+    return data_;
+}
+
+auto mmap_stream::peek(const size_t bytes) -> std::expected<std::span<const std::byte>, error> {
+    return data_.subspan(position_, std::min(bytes, data_.size() - position_));
+}
+
+// windowed_mmap_stream implementation
+windowed_mmap_stream::windowed_mmap_stream(const int fd, const uint64_t file_size, const size_t window_size)
+    : fd_(fd), file_size_(file_size), window_size_(window_size) {}
+
+windowed_mmap_stream::windowed_mmap_stream(windowed_mmap_stream&& other) noexcept
+    : fd_(std::exchange(other.fd_, -1))
+    , file_size_(other.file_size_)
+    , window_size_(other.window_size_)
+    , window_(std::move(other.window_))
+    , window_offset_(other.window_offset_)
+    , window_length_(std::exchange(other.window_length_, 0))
+    , position_(other.position_) {}
+
+auto windowed_mmap_stream::operator=(windowed_mmap_stream&& other) noexcept -> windowed_mmap_stream& {
+    if (this != &other) {
+        if (fd_ != -1) {
+            ::close(fd_);
+        }
+        fd_ = std::exchange(other.fd_, -1);
+        file_size_ = other.file_size_;
+        window_size_ = other.window_size_;
+        window_ = std::move(other.window_);
+        window_offset_ = other.window_offset_;
+        window_length_ = std::exchange(other.window_length_, 0);
+        position_ = other.position_;
+    }
+    return *this;
+}
+
+windowed_mmap_stream::~windowed_mmap_stream() {
+    window_.reset();
+    if (fd_ != -1) {
+        ::close(fd_);
+    }
+}
+
+auto windowed_mmap_stream::open(
+    const std::filesystem::path &path,
+    const size_t window_size) -> std::expected<windowed_mmap_stream, error> {
+    const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return std::unexpected(error{error_code::io_error, 
+            "Failed to open file", errno});
+    }
+    
+    struct stat st{};
+    if (::fstat(fd, &st) == -1) {
+        const int saved_errno = errno;
+        ::close(fd);
+        return std::unexpected(error{error_code::io_error, 
+            "Failed to stat file", saved_errno});
+    }
+    if (!S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return std::unexpected(error{error_code::unsupported_feature, 
+            "Windowed mapping requires a regular file"});
+    }
+    
+    // Windows start on page boundaries, so they are whole pages too
+    const size_t pages = std::max<size_t>(1, (window_size + page_size() - 1) / page_size());
+    ::posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+    return windowed_mmap_stream{fd, static_cast<uint64_t>(st.st_size), pages * page_size()};
+}
+
+auto windowed_mmap_stream::map_window(const size_t bytes) -> std::expected<void, error> {
+    // Unmap first, so at most one window is ever mapped
+    window_.reset();
+    window_length_ = 0;
+
+    const uint64_t aligned = position_ / page_size() * page_size();
+    const uint64_t wanted = std::max<uint64_t>(window_size_, position_ - aligned + bytes);
+    const uint64_t length = std::min(wanted, file_size_ - std::min(aligned, file_size_));
+    if (length == 0) {
+        return {};
+    }
+    if (length > std::numeric_limits<size_t>::max()) {
+        return std::unexpected(error{error_code::io_error, "Window larger than the address space", ENOMEM});
+    }
+
+    void* ptr = ::mmap(nullptr, static_cast<size_t>(length), PROT_READ, MAP_PRIVATE, fd_, static_cast<off_t>(aligned));
+    if (ptr == MAP_FAILED) {
+        return std::unexpected(error{error_code::io_error, 
+            "Memory mapping failed", errno});
+    }
+    ::madvise(ptr, static_cast<size_t>(length), MADV_SEQUENTIAL);
+    window_ = std::unique_ptr<void, window_deleter>{ptr, window_deleter{static_cast<size_t>(length)}};
+    window_offset_ = aligned;
+    window_length_ = static_cast<size_t>(length);
+    return {};
+}
+
+auto windowed_mmap_stream::window_tail() const noexcept -> std::span<const std::byte> {
+    if (!window_ || position_ < window_offset_ || position_ >= window_offset_ + window_length_) {
+        return {};
+    }
+    const auto skipped = static_cast<size_t>(position_ - window_offset_);
+    return {static_cast<const std::byte*>(window_.get()) + skipped, window_length_ - skipped};
+}
+
+auto windowed_mmap_stream::read(std::span<std::byte> buffer) -> std::expected<size_t, error> {
+    size_t total = 0;
+    while (total < buffer.size() && position_ < file_size_) {
+        auto tail = window_tail();
+        if (tail.empty()) {
+            if (auto mapped = map_window(1); !mapped) {
+                return std::unexpected(mapped.error());
+            }
+            tail = window_tail();
+            if (tail.empty()) {
+                break;
+            }
+        }
+        const size_t count = std::min(tail.size(), buffer.size() - total);
+        std::memcpy(buffer.data() + total, tail.data(), count);
+        total += count;
+        position_ += count;
+    }
+    return total;
+}
+
+auto windowed_mmap_stream::peek(const size_t bytes) -> std::expected<std::span<const std::byte>, error> {
+    const auto wanted = static_cast<size_t>(std::min<uint64_t>(bytes, file_size_ - std::min(position_, file_size_)));
+    if (window_tail().size() < wanted) {
+        if (auto mapped = map_window(wanted); !mapped) {
+            return std::unexpected(mapped.error());
+        }
+    }
+    return window_tail().first(wanted);
+}
+
+auto windowed_mmap_stream::skip(const uint64_t bytes) -> std::expected<void, error> {
+    if (bytes > file_size_ - std::min(position_, file_size_)) {
+        return std::unexpected(error{error_code::io_error, "Skip past end of stream"});
+    }
+    position_ += bytes;
+    return {};
+}
+
+auto windowed_mmap_stream::seek(const uint64_t position) -> std::expected<void, error> {
+    if (position > file_size_) {
+        return std::unexpected(error{error_code::io_error, "Seek past end of stream"});
+    }
+    position_ = position;
+    return {};
+}
+
+bool windowed_mmap_stream::at_end() const {
+    return position_ >= file_size_;
+}
+
+uint64_t windowed_mmap_stream::position() const {
+    return position_;
+}
+
+auto windowed_mmap_stream::size() const -> std::optional<uint64_t> {
+    return file_size_;
+}
+
+void windowed_mmap_stream::will_need(const uint64_t offset, const uint64_t length) {
+    if (offset < file_size_ && length > 0) {
+        ::posix_fadvise(fd_, static_cast<off_t>(offset),
+            static_cast<off_t>(std::min(length, file_size_ - offset)), POSIX_FADV_WILLNEED);
+    }
+}
+#endif
+
+// file_output_stream implementation
+file_output_stream::file_output_stream(std::FILE* file)
+    : file_(file) {}
+
+auto file_output_stream::create(const std::filesystem::path &path) -> std::expected<file_output_stream, error> {
+    std::FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        return std::unexpected(error{error_code::io_error,
+            "Failed to create file", errno});
+    }
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    return file_output_stream{file};
+}
+
+auto file_output_stream::open_at(
+    const std::filesystem::path &path, const uint64_t offset) -> std::expected<file_output_stream, error> {
+    std::error_code ec;
+    std::filesystem::resize_file(path, offset, ec);
+    if (ec) {
+        return std::unexpected(error{error_code::io_error, "Failed to truncate file", ec.value()});
+    }
+    std::FILE* file = std::fopen(path.c_str(), "r+b");
+    if (!file) {
+        return std::unexpected(error{error_code::io_error,
+            "Failed to open file", errno});
+    }
+    std::setvbuf(file, nullptr, _IONBF, 0);
+    if (std::fseek(file, 0, SEEK_END) != 0) {
+        const int seek_errno = errno;
+        std::fclose(file);
+        return std::unexpected(error{error_code::io_error, "Failed to seek in file", seek_errno});
+    }
+    return file_output_stream{file};
+}
+
+auto file_output_stream::write(std::span<const std::byte> data) -> std::expected<void, error> {
+    if (std::fwrite(data.data(), 1, data.size(), file_.get()) != data.size()) {
+        return std::unexpected(error{error_code::io_error,
+            "File write error", errno});
+    }
+    return {};
+}
+
+auto file_output_stream::flush() -> std::expected<void, error> {
+    if (std::fflush(file_.get()) != 0) {
+        return std::unexpected(error{error_code::io_error,
+            "File flush error", errno});
+    }
+    return {};
+}
+
+#ifdef __linux__
+// fd_output_stream implementation
+fd_output_stream::fd_output_stream(const int fd, const bool owns_fd)
+    : fd_(fd), owns_fd_(owns_fd) {}
+
+auto fd_output_stream::create(const std::filesystem::path &path) -> std::expected<fd_output_stream, error> {
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd == -1) {
+        return std::unexpected(error{error_code::io_error,
+            "Failed to create file", errno});
+    }
+    return fd_output_stream{fd, true};
+}
+
+auto fd_output_stream::open_at(
+    const std::filesystem::path &path, const uint64_t offset) -> std::expected<fd_output_stream, error> {
+    const int fd = ::open(path.c_str(), O_WRONLY | O_CLOEXEC);
+    if (fd == -1) {
+        return std::unexpected(error{error_code::io_error,
+            "Failed to open file", errno});
+    }
+    fd_output_stream stream{fd, true};
+    if (::ftruncate(fd, static_cast<off_t>(offset)) != 0) {
+        return std::unexpected(error{error_code::io_error, "Failed to truncate file", errno});
+    }
+    if (::lseek(fd, static_cast<off_t>(offset), SEEK_SET) == -1) {
+        return std::unexpected(error{error_code::io_error, "Failed to seek in file", errno});
+    }
+    return stream;
+}
+
+fd_output_stream::fd_output_stream(fd_output_stream&& other) noexcept
+    : fd_(std::exchange(other.fd_, -1))
+    , owns_fd_(std::exchange(other.owns_fd_, false))
+    , copy_file_range_usable_(other.copy_file_range_usable_)
+    , sendfile_usable_(other.sendfile_usable_) {}
+
+auto fd_output_stream::operator=(fd_output_stream&& other) noexcept -> fd_output_stream& {
+    if (this != &other) {
+        if (owns_fd_ && fd_ != -1) {
+            ::close(fd_);
+        }
+        fd_ = std::exchange(other.fd_, -1);
+        owns_fd_ = std::exchange(other.owns_fd_, false);
+        copy_file_range_usable_ = other.copy_file_range_usable_;
+        sendfile_usable_ = other.sendfile_usable_;
+    }
+    return *this;
+}
+
+fd_output_stream::~fd_output_stream() {
+    if (owns_fd_ && fd_ != -1) {
+        ::close(fd_);
+    }
+}
+
+auto fd_output_stream::write(std::span<const std::byte> data) -> std::expected<void, error> {
+    while (!data.empty()) {
+        const ssize_t n = ::write(fd_, data.data(), data.size());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return std::unexpected(error{error_code::io_error,
+                "File write error", errno});
+        }
+        data = data.subspan(static_cast<size_t>(n));
+    }
+    return {};
+}
+
+auto fd_output_stream::copy_from_file(const int fd, const uint64_t offset, const uint64_t length)
+    -> std::expected<bool, error> {
+    // Errors that mean "not between these two descriptors", as long as nothing was copied yet
+    const auto unsupported = [](const int err) {
+        return err == EINVAL || err == EXDEV || err == ENOSYS || err == EOPNOTSUPP || err == EBADF;
+    };
+    const auto short_source = [] {
+        return std::unexpected(error{error_code::io_error, "Source file ended before the requested length"});
+    };
+
+    uint64_t copied = 0;
+    if (copy_file_range_usable_) {
+        while (copied < length) {
+            auto in_offset = static_cast<off_t>(offset + copied);
+            const ssize_t n = ::copy_file_range(fd, &in_offset, fd_, nullptr, static_cast<size_t>(length - copied), 0);
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (copied == 0 && unsupported(errno)) {
+                    copy_file_range_usable_ = false;
+                    break;
+                }
+                return std::unexpected(error{error_code::io_error,
+                    "copy_file_range failed", errno});
+            }
+            if (n == 0) {
+                return short_source();
+            }
+            copied += static_cast<uint64_t>(n);
+        }
+        if (copy_file_range_usable_) {
+            return true;
+        }
+    }
+
+    if (sendfile_usable_) {
+        while (copied < length) {
+            auto in_offset = static_cast<off_t>(offset + copied);
+            const ssize_t n = ::sendfile(fd_, fd, &in_offset, static_cast<size_t>(length - copied));
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                if (copied == 0 && unsupported(errno)) {
+                    sendfile_usable_ = false;
+                    return false;
+                }
+                return std::unexpected(error{error_code::io_error,
+                    "sendfile failed", errno});
+            }
+            if (n == 0) {
+                return short_source();
+            }
+            copied += static_cast<uint64_t>(n);
+        }
+        return true;
+    }
+    return false;
+}
 #endif
 
 } // namespace tierone::tar
\ No newline at end of file
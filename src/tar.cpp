@@ -18,12 +18,16 @@
 
 namespace tierone::tar {
 
-auto open_archive(const std::filesystem::path &path) -> std::expected<archive_reader, error> {
-    return archive_reader::from_file(path);
+auto open_archive(const std::filesystem::path &path, const access_mode mode) -> std::expected<archive_reader, error> {
+    return archive_reader::from_file(path, mode);
 }
 
 auto open_archive(std::unique_ptr<input_stream> stream) -> std::expected<archive_reader, error> {
-    return archive_reader::from_stream(std::move(stream));
+    auto decompressed = open_decompressed(std::move(stream));
+    if (!decompressed) {
+        return std::unexpected(decompressed.error());
+    }
+    return archive_reader::from_stream(std::move(*decompressed));
 }
 
 } // namespace tierone::tar
\ No newline at end of file
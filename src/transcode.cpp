@@ -0,0 +1,218 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <tierone/tar/transcode.hpp>
+#include <tierone/tar/archive_entry.hpp>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <span>
+#include <utility>
+
+namespace tierone::tar {
+
+namespace {
+
+// Stored bytes of an entry as a stream: all of its data for a plain file,
+// the segments back to back for a sparse one
+class stored_data_stream final : public input_stream {
+private:
+    const archive_entry& entry_;
+    std::optional<sparse_run_reader> runs_;
+    std::span<const std::byte> run_;  // Unread part of the current data run
+    uint64_t offset_ = 0;             // Bytes of a plain entry already read
+    bool done_ = false;
+
+public:
+    explicit stored_data_stream(const archive_entry& entry) : entry_(entry) {
+        if (entry.metadata().sparse_info) {
+            runs_.emplace(entry);
+        }
+    }
+
+    [[nodiscard]] std::expected<size_t, error> read(const std::span<std::byte> buffer) override {
+        if (!runs_) {
+            auto got = entry_.read_into(static_cast<size_t>(offset_), buffer);
+            if (!got) {
+                return std::unexpected(got.error());
+            }
+            offset_ += *got;
+            done_ = *got == 0;
+            return *got;
+        }
+        // Holes are never stored, only data runs are passed on
+        while (run_.empty()) {
+            auto run = runs_->next_run();
+            if (!run) {
+                return std::unexpected(run.error());
+            }
+            if (!*run) {
+                done_ = true;
+                return size_t{0};
+            }
+            if (!(*run)->is_hole()) {
+                run_ = (*run)->data;
+            }
+        }
+        const size_t length = std::min(buffer.size(), run_.size());
+        std::memcpy(buffer.data(), run_.data(), length);
+        run_ = run_.subspan(length);
+        return length;
+    }
+
+    [[nodiscard]] std::expected<void, error> skip(uint64_t /*bytes*/) override {
+        return std::unexpected(error{error_code::invalid_operation, "Stored data is read in order"});
+    }
+
+    [[nodiscard]] bool at_end() const override { return done_; }
+};
+
+// Whether the data as stored still fits the rewritten metadata
+bool same_layout(const file_metadata& original, const file_metadata& rewritten) {
+    if (original.is_regular_file() != rewritten.is_regular_file() || original.size != rewritten.size ||
+        original.sparse_info.has_value() != rewritten.sparse_info.has_value()) {
+        return false;
+    }
+    return !original.sparse_info ||
+        (original.sparse_info->segments.size() == rewritten.sparse_info->segments.size() &&
+         original.sparse_info->total_data_size() == rewritten.sparse_info->total_data_size());
+}
+
+// Members of reader into writer; fd, when not -1, is the file under reader
+auto copy_members(
+    archive_reader& reader,
+    archive_writer& writer,
+    const member_rewriter& rewrite,
+    [[maybe_unused]] const int fd) -> std::expected<transcode_stats, error> {
+    transcode_stats stats;
+    while (true) {
+        auto entry = reader.next_entry();
+        if (!entry) {
+            return std::unexpected(entry.error());
+        }
+        if (!*entry) {
+            return stats;
+        }
+        ++stats.members;
+
+        const auto& original = (*entry)->metadata();
+        if (original.type == entry_type::gnu_volhdr || original.type == entry_type::gnu_multivol) {
+            ++stats.dropped;
+            continue;
+        }
+        auto meta = original;
+        if (rewrite) {
+            auto action = rewrite(meta);
+            if (!action) {
+                return std::unexpected(action.error());
+            }
+            if (*action == member_action::drop) {
+                ++stats.dropped;  // The reader skips its data on the next call
+                continue;
+            }
+            if (!same_layout(original, meta)) {
+                return std::unexpected(error{error_code::invalid_operation,
+                    "Rewritten metadata no longer matches the stored data of " + original.path.string()});
+            }
+        }
+
+        if (!meta.is_regular_file()) {
+            if (auto added = writer.add_entry(meta); !added) {
+                return std::unexpected(added.error());
+            }
+            continue;
+        }
+
+        const uint64_t stored_size = meta.sparse_info ? meta.sparse_info->total_data_size() : meta.size;
+        std::optional<std::expected<void, error>> added;
+#ifdef __linux__
+        if (fd != -1 && reader.current_location()) {
+            added = writer.add_stored(meta, fd, reader.current_location()->data_offset);
+        }
+#endif
+        if (!added && (*entry)->is_mapped() && !meta.sparse_info) {
+            auto data = (*entry)->read_data();
+            if (!data) {
+                return std::unexpected(data.error());
+            }
+            added = writer.add_stored(meta, *data);
+        }
+        if (!added) {
+            stored_data_stream stored{**entry};
+            added = writer.add_stored(meta, stored);
+        }
+        if (!*added) {
+            return std::unexpected(added->error());
+        }
+        stats.data_bytes += stored_size;
+    }
+}
+
+} // anonymous namespace
+
+auto transcode(
+    archive_reader& reader,
+    archive_writer& writer,
+    const member_rewriter& rewrite) -> std::expected<transcode_stats, error> {
+    return copy_members(reader, writer, rewrite, -1);
+}
+
+auto transcode(
+    const std::filesystem::path& input,
+    const std::filesystem::path& output,
+    const member_rewriter& rewrite,
+    const writer_options& options) -> std::expected<transcode_stats, error> {
+    // Truncating the output must not destroy the input
+    std::error_code ec;
+    if (std::filesystem::equivalent(input, output, ec)) {
+        return std::unexpected(error{error_code::invalid_operation, "Input and output are the same file"});
+    }
+
+    std::unique_ptr<input_stream> stream;
+    int fd = -1;
+#ifdef __linux__
+    if (auto file = fd_stream::open(input)) {
+        fd = file->native_handle();
+        stream = std::make_unique<fd_stream>(std::move(*file));
+    } else if (file.error().code() != error_code::unsupported_feature) {
+        return std::unexpected(file.error());
+    }
+#endif
+    if (!stream) {
+        auto file = file_stream::open(input);
+        if (!file) {
+            return std::unexpected(file.error());
+        }
+        stream = std::make_unique<file_stream>(std::move(*file));
+    }
+    archive_reader reader{std::move(stream)};
+
+    auto writer = archive_writer::create(output, options);
+    if (!writer) {
+        return std::unexpected(writer.error());
+    }
+    auto stats = copy_members(reader, *writer, rewrite, fd);
+    if (!stats) {
+        return stats;
+    }
+    if (auto finished = writer->finish(); !finished) {
+        return std::unexpected(finished.error());
+    }
+    return stats;
+}
+
+} // namespace tierone::tar
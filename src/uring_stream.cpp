@@ -0,0 +1,506 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <tierone/tar/stream.hpp>
+
+#ifdef __linux__
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <utility>
+
+#ifdef TIERONE_TAR_HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace tierone::tar {
+
+#ifdef TIERONE_TAR_HAVE_IO_URING
+
+namespace {
+
+constexpr size_t page_size = 4096;
+
+// user_data of cancel requests, reads carry their slot number
+constexpr uint64_t cancel_tag = UINT64_MAX;
+
+int io_uring_setup(const unsigned entries, io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int io_uring_enter(const int fd, const unsigned to_submit, const unsigned min_complete, const unsigned flags) {
+    return static_cast<int>(::syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0));
+}
+
+auto system_error(const char* what, const int code) -> error {
+    return error{error_code::io_error, what, code};
+}
+
+class mapping {
+    void* ptr_ = MAP_FAILED;
+    size_t size_ = 0;
+
+public:
+    mapping() = default;
+    mapping(void* ptr, const size_t size) : ptr_(ptr), size_(size) {}
+    mapping(mapping&& other) noexcept
+        : ptr_(std::exchange(other.ptr_, MAP_FAILED)), size_(other.size_) {}
+    mapping& operator=(mapping&& other) noexcept {
+        std::swap(ptr_, other.ptr_);
+        std::swap(size_, other.size_);
+        return *this;
+    }
+    ~mapping() {
+        if (ptr_ != MAP_FAILED) ::munmap(ptr_, size_);
+    }
+
+    [[nodiscard]] bool valid() const noexcept { return ptr_ != MAP_FAILED; }
+
+    template<typename T>
+    [[nodiscard]] T* at(const uint32_t offset) const noexcept {
+        return reinterpret_cast<T*>(static_cast<std::byte*>(ptr_) + offset);
+    }
+};
+
+} // anonymous namespace
+
+struct uring_stream::ring {
+    struct buffer_deleter {
+        void operator()(std::byte* ptr) const { std::free(ptr); }
+    };
+
+    // One read of read_size bytes, slot k % depth holds chunk k
+    struct slot {
+        std::unique_ptr<std::byte, buffer_deleter> data;
+        size_t length = 0;  // Bytes the chunk holds
+        bool in_flight = false;
+        bool cancelled = false;
+        int result = 0;
+    };
+
+    int file = -1;
+    int ring_fd = -1;
+    uint64_t file_size = 0;
+    size_t read_size = 0;
+
+    mapping sq_ring;
+    mapping cq_ring;  // Unmapped when the kernel shares one mapping for both rings
+    mapping sqe_array;
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_mask = nullptr;
+    unsigned* sq_array = nullptr;
+    io_uring_sqe* sqes = nullptr;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned* cq_mask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+    unsigned pending = 0;  // Prepared requests not yet submitted
+
+    std::vector<slot> slots;
+    uint64_t window_begin = 0;  // Chunks [window_begin, window_end) are read or in flight
+    uint64_t window_end = 0;
+    uint64_t position = 0;
+    std::vector<std::byte> peek_buffer;  // Peeks that cross a chunk boundary
+
+    ring() = default;
+    ring(const ring&) = delete;
+    ring& operator=(const ring&) = delete;
+
+    ~ring() {
+        // The kernel may still be writing into the buffers
+        if (ring_fd != -1) {
+            for (uint64_t chunk = window_begin; chunk < window_end; ++chunk) {
+                cancel(chunk);
+            }
+            static_cast<void>(settle());
+            ::close(ring_fd);
+        }
+        if (file != -1) {
+            ::close(file);
+        }
+    }
+
+    [[nodiscard]] uint64_t chunk_count() const noexcept {
+        return (file_size + read_size - 1) / read_size;
+    }
+
+    [[nodiscard]] slot& slot_of(const uint64_t chunk) noexcept {
+        return slots[chunk % slots.size()];
+    }
+
+    [[nodiscard]] auto setup(const unsigned depth) -> std::expected<void, error> {
+        // Room for a read and a cancel per slot
+        io_uring_params params{};
+        ring_fd = io_uring_setup(depth * 2, &params);
+        if (ring_fd < 0) {
+            const int code = errno;
+            ring_fd = -1;
+            if (code == ENOSYS || code == EPERM || code == EACCES) {
+                return std::unexpected(error{error_code::unsupported_feature, "io_uring is not available"});
+            }
+            return std::unexpected(system_error("io_uring_setup failed", code));
+        }
+
+        size_t sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        size_t cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            sq_size = cq_size = std::max(sq_size, cq_size);
+        }
+
+        const auto map = [this](const size_t size, const off_t offset) {
+            return mapping{::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset),
+                           size};
+        };
+        sq_ring = map(sq_size, IORING_OFF_SQ_RING);
+        if (!single_mmap) {
+            cq_ring = map(cq_size, IORING_OFF_CQ_RING);
+        }
+        sqe_array = map(params.sq_entries * sizeof(io_uring_sqe), IORING_OFF_SQES);
+        const mapping& cq = single_mmap ? sq_ring : cq_ring;
+        if (!sq_ring.valid() || !cq.valid() || !sqe_array.valid()) {
+            return std::unexpected(system_error("Failed to map io_uring", errno));
+        }
+
+        sq_tail = sq_ring.at<unsigned>(params.sq_off.tail);
+        sq_mask = sq_ring.at<unsigned>(params.sq_off.ring_mask);
+        sq_array = sq_ring.at<unsigned>(params.sq_off.array);
+        sqes = sqe_array.at<io_uring_sqe>(0);
+        cq_head = cq.at<unsigned>(params.cq_off.head);
+        cq_tail = cq.at<unsigned>(params.cq_off.tail);
+        cq_mask = cq.at<unsigned>(params.cq_off.ring_mask);
+        cqes = cq.at<io_uring_cqe>(params.cq_off.cqes);
+        return {};
+    }
+
+    io_uring_sqe& next_sqe() noexcept {
+        // Only this thread produces, and every prepared entry is submitted
+        // before the ring could fill up
+        const unsigned tail = *sq_tail + pending;
+        const unsigned index = tail & *sq_mask;
+        sq_array[index] = index;
+        ++pending;
+        io_uring_sqe& sqe = sqes[index];
+        std::memset(&sqe, 0, sizeof(sqe));
+        return sqe;
+    }
+
+    [[nodiscard]] auto submit() -> std::expected<void, error> {
+        if (pending == 0) {
+            return {};
+        }
+        std::atomic_ref{*sq_tail}.store(*sq_tail + pending, std::memory_order_release);
+        while (pending > 0) {
+            const int submitted = io_uring_enter(ring_fd, pending, 0, 0);
+            if (submitted < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return std::unexpected(system_error("io_uring_enter failed", errno));
+            }
+            pending -= static_cast<unsigned>(submitted);
+        }
+        return {};
+    }
+
+    // Queue reads until the window holds queue_depth chunks
+    [[nodiscard]] auto fill() -> std::expected<void, error> {
+        const uint64_t last = chunk_count();
+        while (window_end < last && window_end - window_begin < slots.size()) {
+            auto& target = slot_of(window_end);
+            target.length = static_cast<size_t>(std::min<uint64_t>(read_size, file_size - window_end * read_size));
+            target.in_flight = true;
+            target.cancelled = false;
+
+            auto& sqe = next_sqe();
+            sqe.opcode = IORING_OP_READ;
+            sqe.fd = file;
+            sqe.addr = reinterpret_cast<uint64_t>(target.data.get());
+            sqe.len = static_cast<uint32_t>(target.length);
+            sqe.off = window_end * read_size;
+            sqe.user_data = window_end % slots.size();
+            ++window_end;
+        }
+        return submit();
+    }
+
+    void cancel(const uint64_t chunk) {
+        auto& target = slot_of(chunk);
+        if (!target.in_flight || target.cancelled) {
+            return;
+        }
+        target.cancelled = true;
+        auto& sqe = next_sqe();
+        sqe.opcode = IORING_OP_ASYNC_CANCEL;
+        sqe.addr = chunk % slots.size();
+        sqe.user_data = cancel_tag;
+    }
+
+    // Take one completion, blocking for it if asked to
+    [[nodiscard]] auto reap(const bool wait) -> std::expected<bool, error> {
+        while (true) {
+            const unsigned head = *cq_head;
+            if (head != std::atomic_ref{*cq_tail}.load(std::memory_order_acquire)) {
+                const io_uring_cqe& cqe = cqes[head & *cq_mask];
+                if (cqe.user_data != cancel_tag) {
+                    auto& target = slots[cqe.user_data];
+                    target.in_flight = false;
+                    target.result = cqe.res;
+                }
+                std::atomic_ref{*cq_head}.store(head + 1, std::memory_order_release);
+                return true;
+            }
+            if (!wait) {
+                return false;
+            }
+            if (io_uring_enter(ring_fd, 0, 1, IORING_ENTER_GETEVENTS) < 0 && errno != EINTR) {
+                return std::unexpected(system_error("io_uring_enter failed", errno));
+            }
+        }
+    }
+
+    // Submit queued cancels and wait until no cancelled read is outstanding
+    [[nodiscard]] auto settle() -> std::expected<void, error> {
+        if (auto submitted = submit(); !submitted) {
+            return submitted;
+        }
+        for (auto& target : slots) {
+            while (target.in_flight && target.cancelled) {
+                if (auto reaped = reap(true); !reaped) {
+                    return std::unexpected(reaped.error());
+                }
+            }
+        }
+        return {};
+    }
+
+    // Move the window to start at the chunk holding position
+    // Chunks passed over are cancelled, those still ahead stay in flight
+    [[nodiscard]] auto move_to(const uint64_t target) -> std::expected<void, error> {
+        const uint64_t chunk = target / read_size;
+        if (chunk >= window_begin && chunk < window_end) {
+            for (uint64_t passed = window_begin; passed < chunk; ++passed) {
+                cancel(passed);
+            }
+            window_begin = chunk;
+        } else {
+            for (uint64_t passed = window_begin; passed < window_end; ++passed) {
+                cancel(passed);
+            }
+            window_begin = window_end = chunk;
+        }
+        position = target;
+        return settle();
+    }
+
+    // Wait for a chunk in the window to finish reading
+    [[nodiscard]] auto wait(const uint64_t chunk) -> std::expected<std::span<const std::byte>, error> {
+        auto& target = slot_of(chunk);
+        while (target.in_flight) {
+            if (auto reaped = reap(true); !reaped) {
+                return std::unexpected(reaped.error());
+            }
+        }
+        if (target.result < 0) {
+            return std::unexpected(system_error("File read error", -target.result));
+        }
+
+        // Short reads are rare on regular files, finish them synchronously
+        auto done = static_cast<size_t>(target.result);
+        while (done < target.length) {
+            const ssize_t n = ::pread(file, target.data.get() + done, target.length - done,
+                                      static_cast<off_t>(chunk * read_size + done));
+            if (n < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return std::unexpected(system_error("File read error", errno));
+            }
+            if (n == 0) {
+                return std::unexpected(error{error_code::io_error, "File shrank while reading"});
+            }
+            done += static_cast<size_t>(n);
+        }
+        target.result = static_cast<int>(done);
+        return std::span<const std::byte>{target.data.get(), target.length};
+    }
+
+    // The loaded chunk holding position, with the window moved and refilled
+    [[nodiscard]] auto current() -> std::expected<std::span<const std::byte>, error> {
+        const uint64_t chunk = position / read_size;
+        if (chunk != window_begin || window_begin == window_end) {
+            if (auto moved = move_to(position); !moved) {
+                return std::unexpected(moved.error());
+            }
+        }
+        if (auto filled = fill(); !filled) {
+            return std::unexpected(filled.error());
+        }
+        auto data = wait(chunk);
+        if (!data) {
+            return data;
+        }
+        return data->subspan(static_cast<size_t>(position - chunk * read_size));
+    }
+
+    [[nodiscard]] auto read(std::span<std::byte> buffer) -> std::expected<size_t, error> {
+        size_t copied = 0;
+        while (copied < buffer.size() && position < file_size) {
+            auto data = current();
+            if (!data) {
+                return std::unexpected(data.error());
+            }
+            const size_t count = std::min(buffer.size() - copied, data->size());
+            std::memcpy(buffer.data() + copied, data->data(), count);
+            copied += count;
+            position += count;
+        }
+        return copied;
+    }
+
+    [[nodiscard]] auto peek(const size_t bytes) -> std::expected<std::span<const std::byte>, error> {
+        const size_t wanted = static_cast<size_t>(std::min<uint64_t>({bytes, read_size, file_size - position}));
+        if (wanted == 0) {
+            return std::span<const std::byte>{};
+        }
+        auto data = current();
+        if (!data || data->size() >= wanted) {
+            return data ? data->first(wanted) : data;
+        }
+
+        // The next chunk is in flight as the window holds at least two
+        peek_buffer.assign(data->begin(), data->end());
+        auto next = wait(position / read_size + 1);
+        if (!next) {
+            return next;
+        }
+        const size_t rest = wanted - peek_buffer.size();
+        peek_buffer.insert(peek_buffer.end(), next->begin(), next->begin() + static_cast<std::ptrdiff_t>(rest));
+        return std::span<const std::byte>{peek_buffer};
+    }
+};
+
+uring_stream::uring_stream(std::unique_ptr<ring> ring) : ring_(std::move(ring)) {}
+
+uring_stream::uring_stream(uring_stream&& other) noexcept = default;
+auto uring_stream::operator=(uring_stream&& other) noexcept -> uring_stream& = default;
+uring_stream::~uring_stream() = default;
+
+auto uring_stream::open(const std::filesystem::path& path, const uring_options& options)
+    -> std::expected<uring_stream, error> {
+    auto state = std::make_unique<ring>();
+    state->file = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (state->file == -1) {
+        return std::unexpected(error{error_code::io_error,
+            "Failed to open file", errno});
+    }
+
+    struct stat st{};
+    if (::fstat(state->file, &st) == -1) {
+        return std::unexpected(system_error("Failed to stat file", errno));
+    }
+    if (!S_ISREG(st.st_mode)) {
+        return std::unexpected(error{error_code::unsupported_feature, "io_uring stream requires a regular file"});
+    }
+    state->file_size = static_cast<uint64_t>(st.st_size);
+
+    // Page-aligned reads, each within what a single read request can return
+    const size_t limit = 1u << 30;
+    state->read_size = std::min(limit, std::max(page_size, (options.read_size + page_size - 1) / page_size * page_size));
+    const unsigned depth = std::max(2u, options.queue_depth);
+    if (auto ready = state->setup(depth); !ready) {
+        return std::unexpected(ready.error());
+    }
+
+    state->slots.resize(depth);
+    for (auto& target : state->slots) {
+        target.data.reset(static_cast<std::byte*>(std::aligned_alloc(page_size, state->read_size)));
+        if (!target.data) {
+            return std::unexpected(error{error_code::io_error, "Failed to allocate read buffer"});
+        }
+    }
+    ::posix_fadvise(state->file, 0, 0, POSIX_FADV_SEQUENTIAL);
+    return uring_stream{std::move(state)};
+}
+
+auto uring_stream::read(std::span<std::byte> buffer) -> std::expected<size_t, error> {
+    return ring_->read(buffer);
+}
+
+auto uring_stream::peek(const size_t bytes) -> std::expected<std::span<const std::byte>, error> {
+    return ring_->peek(bytes);
+}
+
+auto uring_stream::skip(const uint64_t bytes) -> std::expected<void, error> {
+    if (bytes > ring_->file_size - std::min(ring_->position, ring_->file_size)) {
+        return std::unexpected(error{error_code::io_error, "Skip past end of stream"});
+    }
+    return seek(ring_->position + bytes);
+}
+
+auto uring_stream::seek(const uint64_t position) -> std::expected<void, error> {
+    if (position > ring_->file_size) {
+        return std::unexpected(error{error_code::io_error, "Seek past end of stream"});
+    }
+    return ring_->move_to(position);
+}
+
+bool uring_stream::at_end() const {
+    return ring_->position >= ring_->file_size;
+}
+
+auto uring_stream::position() const -> uint64_t {
+    return ring_->position;
+}
+
+auto uring_stream::size() const -> std::optional<uint64_t> {
+    return ring_->file_size;
+}
+
+#else
+
+// Built without io_uring: open() always fails, so the rest is never reached
+struct uring_stream::ring {};
+
+uring_stream::uring_stream(std::unique_ptr<ring> ring) : ring_(std::move(ring)) {}
+uring_stream::uring_stream(uring_stream&& other) noexcept = default;
+auto uring_stream::operator=(uring_stream&& other) noexcept -> uring_stream& = default;
+uring_stream::~uring_stream() = default;
+
+auto uring_stream::open(const std::filesystem::path&, const uring_options&) -> std::expected<uring_stream, error> {
+    return std::unexpected(error{error_code::unsupported_feature, "io_uring support not built in"});
+}
+
+auto uring_stream::read(std::span<std::byte>) -> std::expected<size_t, error> { return 0; }
+auto uring_stream::peek(size_t) -> std::expected<std::span<const std::byte>, error> {
+    return std::span<const std::byte>{};
+}
+auto uring_stream::skip(uint64_t) -> std::expected<void, error> { return {}; }
+auto uring_stream::seek(uint64_t) -> std::expected<void, error> { return {}; }
+bool uring_stream::at_end() const { return true; }
+auto uring_stream::position() const -> uint64_t { return 0; }
+auto uring_stream::size() const -> std::optional<uint64_t> { return 0; }
+
+#endif
+
+} // namespace tierone::tar
+
+#endif
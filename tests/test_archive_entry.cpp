@@ -19,6 +19,7 @@
 #include <catch2/matchers/catch_matchers_string.hpp>
 #include <tierone/tar/archive_entry.hpp>
 #include <tierone/tar/error.hpp>
+#include <tierone/tar/stream.hpp>
 #include <array>
 #include <cstring>
 #include <filesystem>
@@ -421,6 +422,127 @@ TEST_CASE("archive_entry copy_data_to", "[unit][archive_entry]") {
     }
 }
 
+TEST_CASE("archive_entry chunked reader", "[unit][archive_entry]") {
+    auto data = create_test_data("Hello, World! This is chunked data.");
+    auto metadata = create_test_metadata(entry_type::regular_file, data.size());
+    
+    SECTION("Read in small chunks with streaming mode") {
+        archive_entry entry(metadata, create_mock_reader(data));
+        auto reader = entry.open_reader();
+        REQUIRE(reader.has_value());
+        
+        std::vector<std::byte> output;
+        std::array<std::byte, 4> buffer{};
+        while (true) {
+            auto result = reader->read_some(buffer);
+            REQUIRE(result.has_value());
+            if (*result == 0) break;
+            CHECK(*result <= buffer.size());
+            output.insert(output.end(), buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(*result));
+        }
+        
+        CHECK(output == data);
+        CHECK(reader->at_end());
+        CHECK(reader->position() == data.size());
+    }
+    
+    SECTION("Read in small chunks with memory-mapped mode") {
+        archive_entry entry(metadata, std::span<const std::byte>(data));
+        auto reader = entry.open_reader();
+        REQUIRE(reader.has_value());
+        
+        std::array<std::byte, 5> buffer{};
+        auto first = reader->read_some(buffer);
+        REQUIRE(first.has_value());
+        CHECK(*first == 5);
+        CHECK(std::memcmp(buffer.data(), data.data(), 5) == 0);
+        CHECK(reader->remaining() == data.size() - 5);
+    }
+    
+    SECTION("Chunked source reads directly into the caller buffer") {
+        size_t largest_request = 0;
+        data_read_into_fn source = [&](size_t offset, std::span<std::byte> buffer) -> std::expected<size_t, error> {
+            largest_request = std::max(largest_request, buffer.size());
+            const size_t to_copy = std::min(buffer.size(), data.size() - offset);
+            std::memcpy(buffer.data(), data.data() + offset, to_copy);
+            return to_copy;
+        };
+        archive_entry entry(metadata, source);
+        
+        std::vector<std::byte> output;
+        auto copied = entry.copy_data_to(std::back_inserter(output));
+        REQUIRE(copied.has_value());
+        CHECK(*copied == data.size());
+        CHECK(output == data);
+        
+        auto whole = entry.read_data();
+        REQUIRE(whole.has_value());
+        CHECK(whole->size() == data.size());
+        CHECK(largest_request <= std::max(data.size(), default_chunk_size));
+    }
+    
+    SECTION("Reader on non-regular file") {
+        archive_entry dir_entry(create_test_metadata(entry_type::directory), create_mock_reader(data));
+        auto reader = dir_entry.open_reader();
+        
+        REQUIRE_FALSE(reader.has_value());
+        CHECK(reader.error().code() == error_code::invalid_operation);
+    }
+    
+    SECTION("Failing reader propagates errors") {
+        archive_entry entry(metadata, create_failing_reader());
+        auto reader = entry.open_reader();
+        REQUIRE(reader.has_value());
+        
+        std::array<std::byte, 8> buffer{};
+        auto result = reader->read_some(buffer);
+        REQUIRE_FALSE(result.has_value());
+        CHECK(result.error().code() == error_code::io_error);
+    }
+}
+
+TEST_CASE("archive_data_source entries", "[unit][archive_entry]") {
+    const auto packed = create_test_data("abcdWXYZ");
+
+    SECTION("Streams are read in order, skipping forward over gaps") {
+        memory_mapped_stream base{std::span<const std::byte>{packed}};
+        size_t remaining = packed.size();
+        size_t consumed = 0;
+        archive_entry entry{create_test_metadata(entry_type::regular_file, packed.size()),
+                            archive_data_source{base, nullptr, remaining, consumed, packed.size(), 0}};
+
+        std::array<std::byte, 3> buffer{};
+        auto first = entry.read_into(0, buffer);
+        REQUIRE(first.has_value());
+        CHECK(*first == 3);
+        auto later = entry.read_into(5, buffer);
+        REQUIRE(later.has_value());
+        CHECK(std::memcmp(buffer.data(), "XYZ", 3) == 0);
+        CHECK(remaining == 0);
+
+        auto backwards = entry.read_into(0, buffer);
+        REQUIRE_FALSE(backwards.has_value());
+        CHECK(backwards.error().code() == error_code::invalid_operation);
+    }
+
+    SECTION("Sparse entries expand holes from their metadata") {
+        auto metadata = create_test_metadata(entry_type::regular_file, 20);
+        metadata.sparse_info = sparse::sparse_metadata{20, {{0, 4}, {16, 4}}, {}};
+        archive_entry entry{metadata, archive_data_source{std::span<const std::byte>{packed}}};
+
+        std::vector<std::byte> output;
+        auto copied = entry.copy_data_to(std::back_inserter(output));
+        REQUIRE(copied.has_value());
+        CHECK(output == create_test_data(std::string{"abcd"} + std::string(12, '\0') + "WXYZ"));
+
+        auto runs = entry.open_sparse_runs();
+        REQUIRE(runs.has_value());
+        auto run = runs->next_run();
+        REQUIRE(run.has_value());
+        CHECK((*run)->data.data() == packed.data());
+    }
+}
+
 TEST_CASE("archive_entry edge cases", "[unit][archive_entry]") {
     SECTION("Very large file size") {
         auto metadata = create_test_metadata(entry_type::regular_file, 
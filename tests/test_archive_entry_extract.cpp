@@ -18,11 +18,16 @@
 #include <catch2/matchers/catch_matchers_string.hpp>
 #include <tierone/tar/archive_entry.hpp>
 #include <tierone/tar/error.hpp>
+#include <tierone/tar/sparse_reader.hpp>
 #include <filesystem>
 #include <fstream>
 #include <cstdlib>
 #include <random>
 
+#ifdef __linux__
+#include <sys/stat.h>
+#endif
+
 using namespace tierone::tar;
 namespace fs = std::filesystem;
 
@@ -179,6 +184,45 @@ TEST_CASE("archive_entry extract regular files", "[integration][archive_entry][e
     }
 }
 
+TEST_CASE("archive_entry extract sparse files", "[integration][archive_entry][extract]") {
+    TempDirectory temp_dir;
+    
+    // Two small data segments in an 8 MiB file, with a trailing hole
+    constexpr uint64_t real_size = 8 * 1024 * 1024;
+    sparse::sparse_metadata sparse_info;
+    sparse_info.real_size = real_size;
+    sparse_info.segments = {{4096, 5}, {4 * 1024 * 1024, 5}};
+    
+    auto packed = create_test_data("helloworld");
+    data_read_into_fn stored = [packed](size_t offset, std::span<std::byte> buffer) -> std::expected<size_t, error> {
+        const size_t n = std::min(buffer.size(), packed.size() - std::min(offset, packed.size()));
+        std::copy_n(packed.begin() + static_cast<std::ptrdiff_t>(offset), n, buffer.begin());
+        return n;
+    };
+    
+    auto meta = create_file_metadata("disk.img", entry_type::regular_file, real_size);
+    meta.sparse_info = sparse_info;
+    archive_entry entry{std::move(meta), sparse::make_sparse_read_into(sparse_info, std::move(stored))};
+    
+    auto dest = temp_dir.path() / "disk.img";
+    auto result = entry.extract_to_path(dest);
+    REQUIRE(result.has_value());
+    
+    REQUIRE(fs::file_size(dest) == real_size);
+    auto content = read_file_content(dest);
+    CHECK(content.substr(4096, 5) == "hello");
+    CHECK(content.substr(4 * 1024 * 1024, 5) == "world");
+    CHECK(content.substr(0, 4096) == std::string(4096, '\0'));
+    CHECK(content.find_first_not_of('\0', 4 * 1024 * 1024 + 5) == std::string::npos);
+    
+#ifdef __linux__
+    // Holes are left unallocated rather than written as zeros
+    struct stat st{};
+    REQUIRE(::stat(dest.c_str(), &st) == 0);
+    CHECK(static_cast<uint64_t>(st.st_blocks) * 512 < real_size / 2);
+#endif
+}
+
 TEST_CASE("archive_entry extract directories", "[integration][archive_entry][extract]") {
     TempDirectory temp_dir;
     
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <tierone/tar/tar.hpp>
+#include <tierone/tar/archive_fs.hpp>
+#include <tierone/tar/sparse.hpp>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tierone::tar;
+
+namespace {
+
+file_metadata make_entry(const std::string& path, const entry_type type, const size_t size = 0) {
+    file_metadata meta;
+    meta.path = path;
+    meta.type = type;
+    meta.permissions = std::filesystem::perms{type == entry_type::directory ? 0750u : 0644u};
+    meta.size = size;
+    meta.modification_time = std::chrono::system_clock::from_time_t(1700000000);
+    return meta;
+}
+
+std::span<const std::byte> as_bytes(const std::string& text) {
+    return {reinterpret_cast<const std::byte*>(text.data()), text.size()};
+}
+
+// File removed when the test ends
+class temp_archive {
+    std::filesystem::path path_;
+public:
+    explicit temp_archive(const std::vector<std::byte>& data) {
+        path_ = std::filesystem::temp_directory_path() /
+            ("tierone_fs_test_" + std::to_string(reinterpret_cast<uintptr_t>(this)) + ".tar");
+        std::ofstream file(path_, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+
+    ~temp_archive() {
+        std::error_code ec;
+        std::filesystem::remove(path_, ec);
+    }
+
+    const std::filesystem::path& path() const { return path_; }
+};
+
+std::string read_all(const archive_fs& fs, const std::string_view path, const size_t chunk) {
+    std::string content;
+    std::vector<std::byte> buffer(chunk);
+    while (true) {
+        auto got = fs.read(path, content.size(), buffer);
+        REQUIRE(got.has_value());
+        if (*got == 0) {
+            return content;
+        }
+        content.append(reinterpret_cast<const char*>(buffer.data()), *got);
+    }
+}
+
+} // anonymous namespace
+
+TEST_CASE("archive_fs serves stat, readdir and read from an archive", "[unit][archive_fs]") {
+    std::string large(300000, '\0');
+    for (size_t i = 0; i < large.size(); ++i) {
+        large[i] = static_cast<char>('a' + i * 13 % 26);
+    }
+
+    std::vector<std::byte> archive;
+    {
+        archive_writer writer{std::make_unique<memory_output_stream>(archive)};
+        REQUIRE(writer.add_entry(make_entry("./srv/", entry_type::directory)).has_value());
+        REQUIRE(writer.add_entry(make_entry("srv/app/config.txt", entry_type::regular_file, 3), as_bytes("old")).has_value());
+        REQUIRE(writer.add_entry(make_entry("srv/app/large.bin", entry_type::regular_file, large.size()), as_bytes(large)).has_value());
+        auto link = make_entry("srv/current", entry_type::symbolic_link);
+        link.link_target = "app/config.txt";
+        REQUIRE(writer.add_entry(link).has_value());
+        auto hard = make_entry("srv/copy.bin", entry_type::hard_link);
+        hard.link_target = "srv/app/large.bin";
+        REQUIRE(writer.add_entry(hard).has_value());
+        REQUIRE(writer.add_entry(make_entry("srv/app/config.txt", entry_type::regular_file, 3), as_bytes("new")).has_value());
+        REQUIRE(writer.finish().has_value());
+    }
+    temp_archive file{archive};
+
+    auto fs = archive_fs::open(file.path(), {.block_size = 4096, .capacity = 64 * 1024, .shards = 4});
+    REQUIRE(fs.has_value());
+
+    SECTION("stat") {
+        auto root = fs->stat("/");
+        REQUIRE(root.has_value());
+        CHECK((*root)->is_directory());
+
+        auto srv = fs->stat("srv");
+        REQUIRE(srv.has_value());
+        CHECK((*srv)->permissions == std::filesystem::perms{0750});
+
+        // Implied by its members only
+        auto app = fs->stat("srv/app/");
+        REQUIRE(app.has_value());
+        CHECK((*app)->is_directory());
+        CHECK((*app)->permissions == std::filesystem::perms{0755});
+
+        auto current = fs->stat("srv/current");
+        REQUIRE(current.has_value());
+        CHECK((*current)->is_symbolic_link());
+        CHECK((*current)->link_target == "app/config.txt");
+
+        auto copy = fs->stat("srv/copy.bin");
+        REQUIRE(copy.has_value());
+        CHECK((*copy)->is_regular_file());
+        CHECK((*copy)->size == large.size());
+        CHECK((*copy)->path == "srv/copy.bin");
+
+        auto missing = fs->stat("srv/missing");
+        REQUIRE_FALSE(missing.has_value());
+        CHECK(missing.error().system_errno() == ENOENT);
+    }
+
+    SECTION("readdir") {
+        auto top = fs->readdir("");
+        REQUIRE(top.has_value());
+        REQUIRE(top->size() == 1);
+        CHECK((*top)[0].name == "srv");
+
+        auto srv = fs->readdir("srv");
+        REQUIRE(srv.has_value());
+        REQUIRE(srv->size() == 3);
+        CHECK((*srv)[0].name == "app");
+        CHECK((*srv)[0].type == entry_type::directory);
+        CHECK((*srv)[1].name == "copy.bin");
+        CHECK((*srv)[1].type == entry_type::regular_file);
+        CHECK((*srv)[2].name == "current");
+
+        // The second config.txt replaced the first
+        auto app = fs->readdir("srv/app");
+        REQUIRE(app.has_value());
+        CHECK(app->size() == 2);
+
+        auto file_dir = fs->readdir("srv/app/config.txt");
+        REQUIRE_FALSE(file_dir.has_value());
+        CHECK(file_dir.error().system_errno() == ENOTDIR);
+    }
+
+    SECTION("read") {
+        CHECK(read_all(*fs, "srv/app/config.txt", 16) == "new");
+        CHECK(read_all(*fs, "srv/app/large.bin", 10000) == large);
+        CHECK(read_all(*fs, "srv/copy.bin", 65536) == large);
+
+        std::vector<std::byte> buffer(100);
+        auto got = fs->read("srv/app/large.bin", 4090, buffer);
+        REQUIRE(got.has_value());
+        CHECK(*got == 100);
+        CHECK(std::memcmp(buffer.data(), large.data() + 4090, 100) == 0);
+        got = fs->read("srv/app/large.bin", large.size() - 10, buffer);
+        REQUIRE(got.has_value());
+        CHECK(*got == 10);
+
+        // Read again, the block now comes from the cache
+        CHECK(read_all(*fs, "srv/app/config.txt", 16) == "new");
+        const auto misses = fs->cache().misses();
+        CHECK(read_all(*fs, "srv/app/config.txt", 16) == "new");
+        CHECK(fs->cache().misses() == misses);
+        CHECK(fs->cache().hits() > 0);
+
+        auto dir = fs->read("srv", 0, buffer);
+        REQUIRE_FALSE(dir.has_value());
+        CHECK(dir.error().system_errno() == EISDIR);
+    }
+
+    SECTION("read from several threads") {
+        std::vector<std::jthread> readers;
+        std::vector<int> matches(8, 0);
+        for (size_t t = 0; t < matches.size(); ++t) {
+            readers.emplace_back([&, t] {
+                std::vector<std::byte> buffer(777);
+                for (uint64_t offset = t * 1000; offset < large.size(); offset += 8 * 777) {
+                    auto got = fs->read("srv/copy.bin", offset, buffer);
+                    if (got && std::memcmp(buffer.data(), large.data() + offset, *got) == 0) {
+                        ++matches[t];
+                    } else {
+                        --matches[t];
+                    }
+                }
+            });
+        }
+        readers.clear();
+        for (const int count : matches) {
+            CHECK(count > 0);
+        }
+    }
+}
+
+TEST_CASE("archive_fs reads holes of sparse files as zeros", "[unit][archive_fs]") {
+    // Old GNU sparse member: "data" at 0, "tail" at 9000, 12000 bytes in all
+    std::vector<std::byte> archive(512);
+    auto& header = *reinterpret_cast<sparse::gnu_sparse_header*>(archive.data());
+    std::snprintf(header.name, sizeof(header.name), "disk.img");
+    std::snprintf(header.mode, sizeof(header.mode), "%07o", 0644);
+    std::snprintf(header.uid, sizeof(header.uid), "%07o", 0);
+    std::snprintf(header.gid, sizeof(header.gid), "%07o", 0);
+    std::snprintf(header.size, sizeof(header.size), "%011o", 8);
+    std::snprintf(header.mtime, sizeof(header.mtime), "%011o", 0);
+    header.typeflag = 'S';
+    std::memcpy(header.magic, "ustar  ", 8);
+    std::snprintf(header.sp[0].offset, 12, "%011o", 0);
+    std::snprintf(header.sp[0].numbytes, 12, "%011o", 4);
+    std::snprintf(header.sp[1].offset, 12, "%011o", 9000);
+    std::snprintf(header.sp[1].numbytes, 12, "%011o", 4);
+    std::snprintf(header.realsize, sizeof(header.realsize), "%011o", 12000);
+    std::memset(header.checksum, ' ', sizeof(header.checksum));
+    std::snprintf(header.checksum, 8, "%06o",
+        detail::calculate_checksum(std::span<const std::byte, 512>{archive.data(), 512}));
+    const std::string stored = "datatail";
+    archive.resize(1024 + 1024);
+    std::memcpy(archive.data() + 512, stored.data(), stored.size());
+    temp_archive file{archive};
+
+    auto fs = archive_fs::open(file.path(), {.block_size = 512});
+    REQUIRE(fs.has_value());
+    auto meta = fs->stat("disk.img");
+    REQUIRE(meta.has_value());
+    CHECK((*meta)->size == 12000);
+
+    std::string expected(12000, '\0');
+    expected.replace(0, 4, "data");
+    expected.replace(9000, 4, "tail");
+    CHECK(read_all(*fs, "disk.img", 1000) == expected);
+    CHECK(read_all(*fs, "disk.img", 3) == expected);
+}
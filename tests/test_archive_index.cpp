@@ -0,0 +1,350 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <tierone/tar/tar.hpp>
+#include <tierone/tar/archive_index.hpp>
+#include <tierone/tar/index_sidecar.hpp>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace tierone::tar;
+
+namespace {
+
+// Builds a ustar archive in memory
+class tar_builder {
+    std::vector<std::byte> data_;
+
+    void add_header(const std::string& name, char type, size_t size, const char* magic = "ustar") {
+        std::array<char, 512> header{};
+        std::memcpy(header.data(), name.data(), std::min<size_t>(name.size(), 100));
+        std::snprintf(header.data() + 100, 8, "%07o", 0644u);
+        std::snprintf(header.data() + 108, 8, "%07o", 1000u);
+        std::snprintf(header.data() + 116, 8, "%07o", 1000u);
+        std::snprintf(header.data() + 124, 12, "%011zo", size);
+        std::snprintf(header.data() + 136, 12, "%011o", 1700000000u);
+        header[156] = type;
+        std::memcpy(header.data() + 257, magic, std::strlen(magic) + 1);
+        header[263] = '0';
+        header[264] = '0';
+
+        std::memset(header.data() + 148, ' ', 8);
+        unsigned checksum = 0;
+        for (char c : header) {
+            checksum += static_cast<unsigned char>(c);
+        }
+        std::snprintf(header.data() + 148, 8, "%06o", checksum);
+
+        for (char c : header) {
+            data_.push_back(static_cast<std::byte>(c));
+        }
+    }
+
+    void add_data(const std::string& content) {
+        for (char c : content) {
+            data_.push_back(static_cast<std::byte>(c));
+        }
+        data_.resize((data_.size() + 511) / 512 * 512);
+    }
+
+public:
+    size_t offset() const { return data_.size(); }
+
+    tar_builder& file(const std::string& name, const std::string& content) {
+        add_header(name, '0', content.size());
+        add_data(content);
+        return *this;
+    }
+
+    tar_builder& longname(const std::string& name) {
+        add_header("././@LongLink", 'L', name.size() + 1);
+        add_data(name + '\0');
+        return *this;
+    }
+
+    tar_builder& pax_path(const std::string& path) {
+        std::string record = " path=" + path + "\n";
+        size_t length = record.size() + 2;
+        if (std::to_string(length).size() + record.size() != length) ++length;
+        record = std::to_string(length) + record;
+        add_header("PaxHeader", 'x', record.size());
+        add_data(record);
+        return *this;
+    }
+
+    std::vector<std::byte> finish() {
+        data_.resize(data_.size() + 1024);
+        return data_;
+    }
+};
+
+std::string to_string(std::span<const std::byte> bytes) {
+    return std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+// Archive written to a temporary file, removed along with its sidecar
+class temp_archive {
+    std::filesystem::path path_;
+public:
+    explicit temp_archive(const std::vector<std::byte>& data) {
+        path_ = std::filesystem::temp_directory_path() /
+            ("tierone_sidecar_test_" + std::to_string(reinterpret_cast<uintptr_t>(this)) + ".tar");
+        std::ofstream file(path_, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    }
+
+    ~temp_archive() {
+        std::error_code ec;
+        std::filesystem::remove(path_, ec);
+        std::filesystem::remove(sidecar(), ec);
+    }
+
+    const std::filesystem::path& path() const { return path_; }
+    std::filesystem::path sidecar() const { return std::filesystem::path{path_} += ".idx"; }
+};
+
+} // anonymous namespace
+
+TEST_CASE("archive_index records entry offsets", "[unit][archive_index]") {
+    tar_builder builder;
+    builder.file("first.txt", "one");
+    const size_t second_header = builder.offset();
+    builder.longname("very/long/" + std::string(120, 'x') + ".txt")
+           .file("truncated", "two two");
+    const size_t third_header = builder.offset();
+    builder.pax_path("pax/override.txt")
+           .file("short", "three")
+           .file("first.txt", "replaced");
+    auto archive = builder.finish();
+
+    auto reader = open_archive(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive}));
+    REQUIRE(reader.has_value());
+
+    auto index = archive_index::build(*reader);
+    REQUIRE(index.has_value());
+    REQUIRE(index->size() == 4);
+
+    SECTION("Offsets point at headers and data") {
+        const auto& records = index->records();
+        CHECK(records[0].location.header_offset == 0);
+        CHECK(records[0].location.data_offset == 512);
+        CHECK(records[0].location.stored_size == 3);
+
+        // Extension headers belong to the entry they describe
+        CHECK(records[1].location.header_offset == second_header);
+        CHECK(records[1].location.data_offset == second_header + 3 * 512);
+        CHECK(records[2].location.header_offset == third_header);
+        CHECK(records[2].location.data_offset == third_header + 3 * 512);
+    }
+
+    SECTION("Lookup uses final metadata") {
+        const auto* longname = index->find("very/long/" + std::string(120, 'x') + ".txt");
+        REQUIRE(longname != nullptr);
+        CHECK(longname->metadata.size == 7);
+
+        const auto* pax = index->find("pax/override.txt");
+        REQUIRE(pax != nullptr);
+        CHECK(pax->metadata.size == 5);
+
+        CHECK(index->find("truncated") == nullptr);
+        CHECK(index->find("missing") == nullptr);
+    }
+
+    SECTION("Duplicate paths resolve to the last member") {
+        const auto* first = index->find("first.txt");
+        REQUIRE(first != nullptr);
+        CHECK(first->metadata.size == 8);
+    }
+
+    SECTION("open_entry seeks straight to the data") {
+        const auto* pax = index->find("pax/override.txt");
+        REQUIRE(pax != nullptr);
+
+        auto entry = reader->open_entry(*pax);
+        REQUIRE(entry.has_value());
+        CHECK(entry->path() == "pax/override.txt");
+
+        auto data = entry->read_data();
+        REQUIRE(data.has_value());
+        CHECK(to_string(*data) == "three");
+
+        // Iteration continues after the opened entry
+        auto next = reader->next_entry();
+        REQUIRE(next.has_value());
+        REQUIRE(next->has_value());
+        CHECK((*next)->path() == "first.txt");
+        auto next_data = (*next)->read_data();
+        REQUIRE(next_data.has_value());
+        CHECK(to_string(*next_data) == "replaced");
+    }
+}
+
+TEST_CASE("archive_index with a streaming file reader", "[unit][archive_index]") {
+    auto archive = tar_builder{}.file("a", "alpha").file("b", "bravo").finish();
+
+    // A stream without mapped data still supports seeking to indexed entries
+    class seekable_stream : public memory_mapped_stream {
+    public:
+        using memory_mapped_stream::memory_mapped_stream;
+        std::optional<std::span<const std::byte>> mapped_data() const override { return std::nullopt; }
+    };
+
+    auto reader = open_archive(std::make_unique<seekable_stream>(std::span<const std::byte>{archive}));
+    REQUIRE(reader.has_value());
+    REQUIRE_FALSE(reader->is_mapped());
+
+    auto index = archive_index::build(*reader);
+    REQUIRE(index.has_value());
+
+    const auto* a = index->find("a");
+    REQUIRE(a != nullptr);
+    auto entry = reader->open_entry(*a);
+    REQUIRE(entry.has_value());
+    auto data = entry->read_data();
+    REQUIRE(data.has_value());
+    CHECK(to_string(*data) == "alpha");
+}
+
+TEST_CASE("index sidecar round trip", "[unit][archive_index]") {
+    tar_builder builder;
+    builder.file("b.txt", "bravo");
+    builder.longname(std::string(150, 'x'));
+    builder.file("ignored", "long");
+    builder.file("a.txt", "alpha");
+    builder.file("b.txt", "bravo two");
+    temp_archive archive{builder.finish()};
+
+    auto reader = open_archive(archive.path());
+    REQUIRE(reader.has_value());
+    auto index = archive_index::build(*reader);
+    REQUIRE(index.has_value());
+    REQUIRE(write_index_sidecar(*index, archive.sidecar(), archive.path()).has_value());
+
+    SECTION("Lookups match the in-memory index") {
+        auto sidecar = index_sidecar::open(archive.sidecar(), archive.path());
+        REQUIRE(sidecar.has_value());
+        CHECK(sidecar->size() == 4);
+
+        const std::string long_path(150, 'x');
+        for (const std::string& path : {std::string{"a.txt"}, std::string{"b.txt"}, long_path}) {
+            auto found = sidecar->find(path);
+            REQUIRE(found.has_value());
+            REQUIRE(found->has_value());
+            const auto* expected = index->find(path);
+            REQUIRE(expected != nullptr);
+            CHECK((*found)->metadata.path == expected->metadata.path);
+            CHECK((*found)->metadata.size == expected->metadata.size);
+            CHECK((*found)->metadata.owner_id == expected->metadata.owner_id);
+            CHECK((*found)->metadata.modification_time == expected->metadata.modification_time);
+            CHECK((*found)->location.header_offset == expected->location.header_offset);
+            CHECK((*found)->location.data_offset == expected->location.data_offset);
+        }
+
+        auto missing = sidecar->find("missing");
+        REQUIRE(missing.has_value());
+        CHECK_FALSE(missing->has_value());
+    }
+
+    SECTION("Records open entries without rescanning") {
+        auto sidecar = index_sidecar::open(archive.sidecar(), archive.path());
+        REQUIRE(sidecar.has_value());
+        auto found = sidecar->find("b.txt");
+        REQUIRE(found.has_value());
+        REQUIRE(found->has_value());
+
+        auto fresh = open_archive(archive.path());
+        REQUIRE(fresh.has_value());
+        auto entry = fresh->open_entry(**found);
+        REQUIRE(entry.has_value());
+        auto data = entry->read_data();
+        REQUIRE(data.has_value());
+        CHECK(to_string(*data) == "bravo two");
+    }
+
+    SECTION("Full materialization") {
+        auto sidecar = index_sidecar::open(archive.sidecar(), archive.path());
+        REQUIRE(sidecar.has_value());
+        auto loaded = sidecar->to_index();
+        REQUIRE(loaded.has_value());
+        REQUIRE(loaded->size() == index->size());
+        for (size_t i = 0; i < loaded->size(); ++i) {
+            CHECK(loaded->records()[i].metadata.path == index->records()[i].metadata.path);
+            CHECK(loaded->records()[i].location.data_offset == index->records()[i].location.data_offset);
+        }
+    }
+
+    SECTION("Stale sidecars are rejected") {
+        {
+            std::ofstream file(archive.path(), std::ios::binary | std::ios::app);
+            file << std::string(512, '\0');
+        }
+        auto sidecar = index_sidecar::open(archive.sidecar(), archive.path());
+        REQUIRE_FALSE(sidecar.has_value());
+        CHECK(sidecar.error().code() == error_code::invalid_operation);
+    }
+
+    SECTION("Digest binding") {
+        archive_digest digest{};
+        digest[0] = std::byte{0xab};
+        REQUIRE(write_index_sidecar(*index, archive.sidecar(), archive.path(), {.digest = digest}).has_value());
+
+        CHECK(index_sidecar::open(archive.sidecar(), archive.path(), {.digest = digest}).has_value());
+
+        archive_digest other{};
+        auto mismatch = index_sidecar::open(archive.sidecar(), archive.path(), {.digest = other});
+        REQUIRE_FALSE(mismatch.has_value());
+        CHECK(mismatch.error().code() == error_code::invalid_operation);
+    }
+
+    SECTION("Truncated sidecars are rejected") {
+        std::filesystem::resize_file(archive.sidecar(), 200);
+        auto sidecar = index_sidecar::open(archive.sidecar(), archive.path());
+        REQUIRE_FALSE(sidecar.has_value());
+        CHECK(sidecar.error().code() == error_code::corrupt_archive);
+    }
+}
+
+TEST_CASE("index sidecar keeps sparse maps", "[unit][archive_index]") {
+    temp_archive archive{tar_builder{}.file("placeholder", "x").finish()};
+
+    index_record record;
+    record.metadata.path = "sparse.img";
+    record.metadata.type = entry_type::gnu_sparse;
+    record.metadata.size = 1024;
+    record.metadata.link_target = "unused";
+    record.metadata.sparse_info = sparse::sparse_metadata{1u << 20, {{0, 512}, {65536, 512}}};
+    record.location = {0, 512, 1024};
+    archive_index index{std::vector<index_record>{record}};
+
+    REQUIRE(write_index_sidecar(index, archive.sidecar(), archive.path()).has_value());
+    auto sidecar = index_sidecar::open(archive.sidecar(), archive.path());
+    REQUIRE(sidecar.has_value());
+
+    auto loaded = sidecar->record(0);
+    REQUIRE(loaded.has_value());
+    CHECK(loaded->metadata.type == entry_type::gnu_sparse);
+    CHECK(loaded->metadata.link_target == "unused");
+    REQUIRE(loaded->metadata.sparse_info.has_value());
+    CHECK(loaded->metadata.sparse_info->real_size == (1u << 20));
+    REQUIRE(loaded->metadata.sparse_info->segments.size() == 2);
+    CHECK(loaded->metadata.sparse_info->segments[1].offset == 65536);
+    CHECK(loaded->metadata.sparse_info->segments[1].size == 512);
+}
@@ -16,6 +16,7 @@
 
 #include <catch2/catch_test_macros.hpp>
 #include <tierone/tar/archive_reader.hpp>
+#include <tierone/tar/archive_writer.hpp>
 #include <tierone/tar/stream.hpp>
 #include <sstream>
 #include <vector>
@@ -42,7 +43,7 @@ public:
         return to_read;
     }
 
-    std::expected<void, error> skip(size_t bytes) override {
+    std::expected<void, error> skip(uint64_t bytes) override {
         if (position_ + bytes > data_.size()) {
             return std::unexpected(error{error_code::io_error, "Skip past end"});
         }
@@ -116,4 +117,57 @@ TEST_CASE("Mock stream basic functionality", "[stream]") {
         CHECK(buffer[0] == std::byte{1});
         CHECK(buffer[1] == std::byte{2});
     }
-}
\ No newline at end of file
+}
+TEST_CASE("archive_reader stats account for every byte", "[unit][stats]") {
+    // A 1000-byte file, then one whose path needs a PAX header
+    std::vector<std::byte> archive;
+    archive_writer writer{std::make_unique<memory_output_stream>(archive)};
+    for (const auto& [path, size] : {std::pair{std::string{"a.txt"}, size_t{1000}},
+                                     std::pair{std::string(300, 'p'), size_t{10}}}) {
+        file_metadata meta;
+        meta.path = path;
+        meta.type = entry_type::regular_file;
+        meta.permissions = std::filesystem::perms{0644};
+        meta.size = size;
+        REQUIRE(writer.add_entry(meta, std::vector<std::byte>(size)).has_value());
+    }
+    REQUIRE(writer.finish().has_value());
+
+    archive_reader reader{std::make_unique<mock_stream>(archive)};
+    auto first = reader.next_entry();
+    REQUIRE(first.has_value());
+    REQUIRE(first->has_value());
+    std::vector<std::byte> buffer(600);
+    REQUIRE((*first)->read_into(0, buffer) == size_t{600});
+    size_t entries = 1;
+    while (true) {
+        auto next = reader.next_entry();
+        REQUIRE(next.has_value());
+        if (!*next) break;
+        ++entries;
+    }
+    CHECK(entries == 2);
+
+    const auto& stats = reader.stats();
+    if constexpr (stats_enabled) {
+        CHECK(stats.headers_parsed == 3);
+        CHECK(stats.pax_headers == 1);
+        CHECK(stats.gnu_extensions == 0);
+        CHECK(stats.buffer_resizes == 1);
+        CHECK(stats.seek_calls == 0);
+        CHECK(stats.read_calls == 7);  // Four headers, the PAX payload, data, end marker
+        CHECK(stats.skip_calls == 5);
+
+        // Read or skipped, everything up to the end-of-archive marker
+        CHECK(stats.bytes_read + stats.bytes_skipped == 9 * 512);
+        CHECK(stats.bytes_skipped >= 400);
+    } else {
+        CHECK(stats.headers_parsed == 0);
+        CHECK(stats.bytes_read == 0);
+        CHECK(stats.header_time.count() == 0);
+    }
+
+    // Starting over on another archive clears them
+    reader.reset(std::make_unique<mock_stream>(archive));
+    CHECK(reader.stats().read_calls == 0);
+}
@@ -0,0 +1,400 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <tierone/tar/tar.hpp>
+#include <tierone/tar/archive_writer.hpp>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+using namespace tierone::tar;
+
+namespace {
+
+file_metadata make_file(const std::string& path, size_t size) {
+    file_metadata meta;
+    meta.path = path;
+    meta.type = entry_type::regular_file;
+    meta.permissions = std::filesystem::perms{0644};
+    meta.owner_id = 1000;
+    meta.group_id = 1000;
+    meta.size = size;
+    meta.modification_time = std::chrono::system_clock::from_time_t(1700000000);
+    meta.owner_name = "user";
+    meta.group_name = "group";
+    return meta;
+}
+
+std::span<const std::byte> as_bytes(const std::string& text) {
+    return {reinterpret_cast<const std::byte*>(text.data()), text.size()};
+}
+
+std::string to_string(std::span<const std::byte> bytes) {
+    return std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+std::vector<archive_entry> read_all(const std::vector<std::byte>& archive) {
+    auto reader = open_archive(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive}));
+    REQUIRE(reader.has_value());
+    std::vector<archive_entry> entries;
+    while (true) {
+        auto entry = reader->next_entry();
+        REQUIRE(entry.has_value());
+        if (!*entry) break;
+        entries.push_back(std::move(**entry));
+    }
+    return entries;
+}
+
+// File removed when the test ends
+class temp_path {
+    std::filesystem::path path_;
+public:
+    explicit temp_path(const std::string& suffix) {
+        path_ = std::filesystem::temp_directory_path() /
+            ("tierone_writer_test_" + std::to_string(reinterpret_cast<uintptr_t>(this)) + suffix);
+    }
+
+    ~temp_path() {
+        std::error_code ec;
+        std::filesystem::remove(path_, ec);
+    }
+
+    const std::filesystem::path& path() const { return path_; }
+
+    void write(const std::string& content) const {
+        std::ofstream file(path_, std::ios::binary);
+        file.write(content.data(), static_cast<std::streamsize>(content.size()));
+    }
+};
+
+} // anonymous namespace
+
+TEST_CASE("archive_writer round-trips ustar entries", "[unit][archive_writer]") {
+    std::vector<std::byte> archive;
+    archive_writer writer{std::make_unique<memory_output_stream>(archive)};
+
+    const std::string content = "hello, tar";
+    REQUIRE(writer.add_entry(make_file("dir/file.txt", content.size()), as_bytes(content)).has_value());
+
+    auto dir = make_file("dir", 0);
+    dir.type = entry_type::directory;
+    dir.permissions = std::filesystem::perms{0755};
+    REQUIRE(writer.add_entry(dir).has_value());
+
+    auto link = make_file("dir/link", 0);
+    link.type = entry_type::symbolic_link;
+    link.link_target = "file.txt";
+    REQUIRE(writer.add_entry(link).has_value());
+
+    REQUIRE(writer.finish().has_value());
+    CHECK(archive.size() % 512 == 0);
+    CHECK(archive.size() == 512 * 2 + 512 * 2 + 1024);
+
+    auto entries = read_all(archive);
+    REQUIRE(entries.size() == 3);
+
+    CHECK(entries[0].path() == "dir/file.txt");
+    CHECK(entries[0].size() == content.size());
+    CHECK(entries[0].permissions() == std::filesystem::perms{0644});
+    CHECK(entries[0].owner_id() == 1000);
+    CHECK(entries[0].owner_name() == "user");
+    CHECK(entries[0].modification_time() == std::chrono::system_clock::from_time_t(1700000000));
+    auto data = entries[0].read_data();
+    REQUIRE(data.has_value());
+    CHECK(to_string(*data) == content);
+
+    CHECK(entries[1].is_directory());
+    CHECK(entries[1].path() == "dir/");
+    CHECK(entries[1].permissions() == std::filesystem::perms{0755});
+
+    CHECK(entries[2].is_symbolic_link());
+    CHECK(entries[2].link_target() == "file.txt");
+}
+
+TEST_CASE("archive_writer stores long names", "[unit][archive_writer]") {
+    const std::string split_path = std::string(120, 'p') + "/" + std::string(90, 'n');
+    const std::string long_path = std::string(300, 'x') + "/file";
+    const std::string long_target = std::string(150, 't');
+
+    for (auto format : {long_name_format::pax, long_name_format::gnu}) {
+        std::vector<std::byte> archive;
+        archive_writer writer{std::make_unique<memory_output_stream>(archive), {.long_names = format}};
+
+        REQUIRE(writer.add_entry(make_file(split_path, 1), as_bytes("a")).has_value());
+        REQUIRE(writer.add_entry(make_file(long_path, 1), as_bytes("b")).has_value());
+        auto link = make_file("link", 0);
+        link.type = entry_type::symbolic_link;
+        link.link_target = long_target;
+        REQUIRE(writer.add_entry(link).has_value());
+        REQUIRE(writer.finish().has_value());
+
+        auto entries = read_all(archive);
+        REQUIRE(entries.size() == 3);
+        CHECK(entries[0].path() == split_path);
+        CHECK(entries[1].path() == long_path);
+        CHECK(entries[2].link_target() == long_target);
+        auto data = entries[1].read_data();
+        REQUIRE(data.has_value());
+        CHECK(to_string(*data) == "b");
+    }
+}
+
+TEST_CASE("archive_writer emits PAX records for values ustar cannot hold", "[unit][archive_writer]") {
+    std::vector<std::byte> archive;
+    archive_writer writer{std::make_unique<memory_output_stream>(archive)};
+
+    auto meta = make_file("meta.txt", 2);
+    meta.owner_id = 1u << 24;
+    meta.owner_name = std::string(40, 'o');
+    meta.modification_time = std::chrono::system_clock::time_point{std::chrono::seconds{-86400}};
+    meta.xattrs["user.comment"] = "written by archive_writer";
+    meta.access_acl.push_back({acl_entry::type::user_obj, 0, acl_entry::perm{6}, ""});
+    meta.access_acl.push_back({acl_entry::type::user, 1001, acl_entry::perm{4}, ""});
+    meta.access_acl.push_back({acl_entry::type::other, 0, acl_entry::perm{0}, ""});
+    REQUIRE(writer.add_entry(meta, as_bytes("ok")).has_value());
+    REQUIRE(writer.finish().has_value());
+
+    auto entries = read_all(archive);
+    REQUIRE(entries.size() == 1);
+    const auto& entry = entries[0];
+    CHECK(entry.owner_id() == (1u << 24));
+    CHECK(entry.owner_name() == std::string(40, 'o'));
+    CHECK(entry.modification_time() == std::chrono::system_clock::time_point{std::chrono::seconds{-86400}});
+    CHECK(entry.get_extended_attributes().at("user.comment") == "written by archive_writer");
+    REQUIRE(entry.access_acl().size() == 3);
+    CHECK(entry.access_acl()[1].entry_type == acl_entry::type::user);
+    CHECK(entry.access_acl()[1].id == 1001);
+    CHECK(entry.access_acl()[1].permissions == acl_entry::perm::read);
+}
+
+TEST_CASE("archive_writer streams data from an input_stream", "[unit][archive_writer]") {
+    std::string content(5000, '\0');
+    for (size_t i = 0; i < content.size(); ++i) {
+        content[i] = static_cast<char>('a' + i % 26);
+    }
+
+    std::vector<std::byte> archive;
+    // Small buffer so the data crosses several flushes
+    archive_writer writer{std::make_unique<memory_output_stream>(archive), {.buffer_size = 1024}};
+
+    memory_mapped_stream source{as_bytes(content)};
+    REQUIRE(writer.add_entry(make_file("streamed.bin", content.size()), source).has_value());
+
+    SECTION("A source shorter than the entry size is an error") {
+        memory_mapped_stream short_source{as_bytes("tiny")};
+        auto result = writer.add_entry(make_file("short.bin", 100), short_source);
+        REQUIRE_FALSE(result.has_value());
+        CHECK(result.error().code() == error_code::io_error);
+    }
+
+    SECTION("Streamed data reads back") {
+        REQUIRE(writer.finish().has_value());
+        auto entries = read_all(archive);
+        REQUIRE(entries.size() == 1);
+        auto data = entries[0].read_data();
+        REQUIRE(data.has_value());
+        CHECK(to_string(*data) == content);
+    }
+}
+
+TEST_CASE("archive_writer rejects invalid entries", "[unit][archive_writer]") {
+    std::vector<std::byte> archive;
+    archive_writer writer{std::make_unique<memory_output_stream>(archive)};
+
+    SECTION("Data size must match the entry size") {
+        auto result = writer.add_entry(make_file("a", 10), as_bytes("short"));
+        REQUIRE_FALSE(result.has_value());
+        CHECK(result.error().code() == error_code::invalid_operation);
+    }
+
+    SECTION("Extension headers cannot be added directly") {
+        auto meta = make_file("PaxHeader", 0);
+        meta.type = entry_type::pax_extended_header;
+        auto result = writer.add_entry(meta);
+        REQUIRE_FALSE(result.has_value());
+        CHECK(result.error().code() == error_code::invalid_operation);
+    }
+
+    SECTION("No entries after finish") {
+        REQUIRE(writer.finish().has_value());
+        auto result = writer.add_entry(make_file("late", 0));
+        REQUIRE_FALSE(result.has_value());
+        CHECK(result.error().code() == error_code::invalid_operation);
+    }
+}
+
+TEST_CASE("archive_writer adds file-backed members", "[unit][archive_writer]") {
+    std::string content(300000, '\0');
+    for (size_t i = 0; i < content.size(); ++i) {
+        content[i] = static_cast<char>(i * 7 % 251);
+    }
+    temp_path source{".bin"};
+    source.write(content);
+
+    const auto check_archive = [&content](const std::vector<std::byte>& archive) {
+        auto entries = read_all(archive);
+        REQUIRE(entries.size() == 3);
+        CHECK(entries[0].path() == "before.txt");
+        CHECK(entries[1].path() == "payload.bin");
+        auto data = entries[1].read_data();
+        REQUIRE(data.has_value());
+        CHECK(to_string(*data) == content);
+        auto after = entries[2].read_data();
+        REQUIRE(after.has_value());
+        CHECK(to_string(*after) == "after");
+    };
+
+    const auto add_members = [&](archive_writer& writer) {
+        REQUIRE(writer.add_entry(make_file("before.txt", 6), as_bytes("before")).has_value());
+        REQUIRE(writer.add_file(make_file("payload.bin", content.size()), source.path()).has_value());
+        REQUIRE(writer.add_entry(make_file("after.txt", 5), as_bytes("after")).has_value());
+        REQUIRE(writer.finish().has_value());
+    };
+
+    SECTION("Written to a file") {
+        temp_path target{".tar"};
+        {
+            auto writer = archive_writer::create(target.path());
+            REQUIRE(writer.has_value());
+            add_members(*writer);
+        }
+        std::ifstream file(target.path(), std::ios::binary);
+        std::string raw{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        std::vector<std::byte> archive(raw.size());
+        std::memcpy(archive.data(), raw.data(), raw.size());
+        check_archive(archive);
+    }
+
+    SECTION("Copied through the buffer for streams without kernel copies") {
+        std::vector<std::byte> archive;
+        archive_writer writer{std::make_unique<memory_output_stream>(archive), {.buffer_size = 4096}};
+        add_members(writer);
+        check_archive(archive);
+    }
+
+    SECTION("The file size must match the entry size") {
+        std::vector<std::byte> archive;
+        archive_writer writer{std::make_unique<memory_output_stream>(archive)};
+        auto result = writer.add_file(make_file("payload.bin", 10), source.path());
+        REQUIRE_FALSE(result.has_value());
+        CHECK(result.error().code() == error_code::invalid_operation);
+    }
+}
+
+TEST_CASE("archive_writer appends to existing archives", "[unit][archive_writer]") {
+    temp_path target{".tar"};
+    temp_path source{".log"};
+    source.write("fresh log");
+
+    const auto read_file = [&target] {
+        std::ifstream file(target.path(), std::ios::binary);
+        std::string raw{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        std::vector<std::byte> archive(raw.size());
+        std::memcpy(archive.data(), raw.data(), raw.size());
+        return archive;
+    };
+    const auto index_of = [&target] {
+        auto reader = archive_reader::from_file(target.path());
+        REQUIRE(reader.has_value());
+        auto index = archive_index::build(*reader);
+        REQUIRE(index.has_value());
+        return std::move(*index);
+    };
+
+    {
+        auto writer = archive_writer::create(target.path());
+        REQUIRE(writer.has_value());
+        REQUIRE(writer->add_entry(make_file("logs/a.log", 5), as_bytes("first")).has_value());
+        REQUIRE(writer->add_entry(make_file("logs/b.log", 6), as_bytes("second")).has_value());
+        REQUIRE(writer->finish().has_value());
+    }
+    // Padded to a 10 KiB record, as GNU tar leaves it
+    std::filesystem::resize_file(target.path(), 10240);
+
+    SECTION("Found by walking the headers") {
+        {
+            auto writer = archive_writer::append(target.path());
+            REQUIRE(writer.has_value());
+            REQUIRE(writer->add_entry(make_file("logs/c.log", 5), as_bytes("third")).has_value());
+            REQUIRE(writer->finish().has_value());
+        }
+        const auto archive = read_file();
+        CHECK(archive.size() == 6 * 512 + 1024);  // Three headers, three data blocks, the marker
+        auto entries = read_all(archive);
+        REQUIRE(entries.size() == 3);
+        CHECK(entries[0].path() == "logs/a.log");
+        auto data = entries[2].read_data();
+        REQUIRE(data.has_value());
+        CHECK(to_string(*data) == "third");
+    }
+
+    SECTION("Found from an index, with a superseding update") {
+        const auto index = index_of();
+        CHECK(index.end_offset() == 4 * 512);
+        {
+            auto writer = archive_writer::append(target.path(), index);
+            REQUIRE(writer.has_value());
+
+            auto older = make_file("logs/a.log", 9);
+            older.modification_time -= std::chrono::hours{1};
+            auto newer = make_file("logs/b.log", 9);
+            newer.modification_time += std::chrono::hours{1};
+            auto added = writer->update_file(index, older, source.path());
+            REQUIRE(added.has_value());
+            CHECK_FALSE(*added);
+            added = writer->update_file(index, newer, source.path());
+            REQUIRE(added.has_value());
+            CHECK(*added);
+            added = writer->update_file(index, make_file("logs/new.log", 9), source.path());
+            REQUIRE(added.has_value());
+            CHECK(*added);
+            REQUIRE(writer->finish().has_value());
+        }
+        auto entries = read_all(read_file());
+        REQUIRE(entries.size() == 4);
+        CHECK(entries[2].path() == "logs/b.log");
+        CHECK(entries[3].path() == "logs/new.log");
+
+        // The last member wins, so the update supersedes the old b.log
+        const auto updated = index_of();
+        const auto* record = updated.find("logs/b.log");
+        REQUIRE(record);
+        CHECK(record->metadata.size == 9);
+
+        // The old index no longer ends where the archive does
+        auto stale = archive_writer::append(target.path(), index);
+        REQUIRE_FALSE(stale.has_value());
+        CHECK(stale.error().code() == error_code::corrupt_archive);
+    }
+
+    SECTION("An empty archive is appended to from the start") {
+        std::filesystem::resize_file(target.path(), 0);
+        std::filesystem::resize_file(target.path(), 1024);
+        {
+            auto writer = archive_writer::append(target.path());
+            REQUIRE(writer.has_value());
+            REQUIRE(writer->add_file(make_file("only.log", 9), source.path()).has_value());
+            REQUIRE(writer->finish().has_value());
+        }
+        auto entries = read_all(read_file());
+        REQUIRE(entries.size() == 1);
+        CHECK(entries[0].path() == "only.log");
+    }
+}
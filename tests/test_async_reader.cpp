@@ -0,0 +1,281 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <tierone/tar/tar.hpp>
+#include <tierone/tar/async_archive_reader.hpp>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tierone::tar;
+
+namespace {
+
+file_metadata make_file(const std::string& path, size_t size) {
+    file_metadata meta;
+    meta.path = path;
+    meta.type = entry_type::regular_file;
+    meta.permissions = std::filesystem::perms{0644};
+    meta.size = size;
+    meta.modification_time = std::chrono::system_clock::from_time_t(1700000000);
+    return meta;
+}
+
+std::vector<std::byte> pattern(size_t size, unsigned seed) {
+    std::vector<std::byte> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<std::byte>((i * 31 + seed) & 0xFF);
+    }
+    return data;
+}
+
+const std::string long_path = std::string(150, 'd') + "/" + std::string(80, 'f');
+
+// A PAX long name, a file spanning many source reads, an empty file, a small one
+std::vector<std::byte> make_archive() {
+    std::vector<std::byte> archive;
+    archive_writer writer{std::make_unique<memory_output_stream>(archive)};
+    REQUIRE(writer.add_entry(make_file(long_path, 100), pattern(100, 1)).has_value());
+    REQUIRE(writer.add_entry(make_file("big.bin", 200 * 1024), pattern(200 * 1024, 2)).has_value());
+    REQUIRE(writer.add_entry(make_file("empty", 0)).has_value());
+    REQUIRE(writer.add_entry(make_file("small.txt", 7), pattern(7, 3)).has_value());
+    REQUIRE(writer.finish().has_value());
+    return archive;
+}
+
+// Hands out at most chunk bytes per read, each completing on a new thread
+class threaded_stream : public async_input_stream {
+    std::vector<std::byte> data_;
+    size_t position_ = 0;
+    size_t chunk_;
+
+public:
+    threaded_stream(std::vector<std::byte> data, size_t chunk) : data_(std::move(data)), chunk_(chunk) {}
+
+    task<std::expected<size_t, error>> read(std::span<std::byte> buffer) override {
+        struct resume_elsewhere {
+            bool await_ready() noexcept { return false; }
+            void await_suspend(std::coroutine_handle<> handle) {
+                std::thread([handle] { handle.resume(); }).detach();
+            }
+            void await_resume() noexcept {}
+        };
+        co_await resume_elsewhere{};
+
+        const size_t count = std::min({buffer.size(), chunk_, data_.size() - position_});
+        std::memcpy(buffer.data(), data_.data() + position_, count);
+        position_ += count;
+        co_return count;
+    }
+};
+
+task<std::expected<std::vector<std::byte>, error>> read_all(async_archive_reader& reader) {
+    std::vector<std::byte> data;
+    std::vector<std::byte> buffer(3000);
+    while (true) {
+        auto count = co_await reader.read_data(buffer);
+        if (!count) {
+            co_return std::unexpected(count.error());
+        }
+        if (*count == 0) {
+            co_return data;
+        }
+        data.insert(data.end(), buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(*count));
+    }
+}
+
+// Paths of all entries, reading the data of those named in read
+task<std::vector<std::string>> walk(async_archive_reader& reader, std::vector<std::string> read,
+                                    std::vector<std::vector<std::byte>>& contents) {
+    std::vector<std::string> paths;
+    while (true) {
+        auto entry = co_await reader.next_entry();
+        REQUIRE(entry.has_value());
+        if (!*entry) {
+            co_return paths;
+        }
+        const auto path = (*entry)->path().string();
+        paths.push_back(path);
+        if (std::ranges::find(read, path) != read.end()) {
+            auto data = co_await read_all(reader);
+            REQUIRE(data.has_value());
+            contents.push_back(std::move(*data));
+        }
+    }
+}
+
+// ustar header block for hand-built archives
+std::array<std::byte, 512> raw_header(const std::string& path, char type, size_t size) {
+    std::array<std::byte, 512> block{};
+    auto* raw = reinterpret_cast<char*>(block.data());
+    std::memcpy(raw, path.data(), path.size());
+    std::snprintf(raw + 100, 8, "%07o", 0644);
+    std::snprintf(raw + 108, 8, "%07o", 0);
+    std::snprintf(raw + 116, 8, "%07o", 0);
+    std::snprintf(raw + 124, 12, "%011zo", size);
+    std::snprintf(raw + 136, 12, "%011o", 0);
+    raw[156] = type;
+    std::memcpy(raw + 257, "ustar", 6);
+    std::memcpy(raw + 263, "00", 2);
+    std::memset(raw + 148, ' ', 8);
+    std::snprintf(raw + 148, 8, "%06o", tierone::tar::detail::calculate_checksum(block));
+    return block;
+}
+
+void append_padded(std::vector<std::byte>& out, std::span<const std::byte> data) {
+    out.insert(out.end(), data.begin(), data.end());
+    out.resize((out.size() + 511) / 512 * 512);
+}
+
+std::span<const std::byte> as_bytes(const std::string& text) {
+    return {reinterpret_cast<const std::byte*>(text.data()), text.size()};
+}
+
+} // namespace
+
+TEST_CASE("async_archive_reader reads entries and data", "[unit][async]") {
+    const auto archive = make_archive();
+
+    for (size_t chunk : {size_t{1} << 20, size_t{700}, size_t{13}}) {
+        async_archive_reader reader{std::make_unique<threaded_stream>(archive, chunk)};
+        std::vector<std::vector<std::byte>> contents;
+        const auto paths = sync_wait(walk(reader, {long_path, "big.bin", "empty", "small.txt"}, contents));
+
+        CHECK(paths == std::vector<std::string>{long_path, "big.bin", "empty", "small.txt"});
+        REQUIRE(contents.size() == 4);
+        CHECK(contents[0] == pattern(100, 1));
+        CHECK(contents[1] == pattern(200 * 1024, 2));
+        CHECK(contents[2].empty());
+        CHECK(contents[3] == pattern(7, 3));
+    }
+}
+
+TEST_CASE("async_archive_reader skips unread data", "[unit][async]") {
+    const auto archive = make_archive();
+    async_archive_reader reader{std::make_unique<threaded_stream>(archive, 4096)};
+
+    // Only part of big.bin is read before moving on
+    auto partial = [](async_archive_reader& r) -> task<std::vector<std::string>> {
+        std::vector<std::string> paths;
+        while (true) {
+            auto entry = co_await r.next_entry();
+            REQUIRE(entry.has_value());
+            if (!*entry) {
+                co_return paths;
+            }
+            paths.push_back((*entry)->path().string());
+            if (paths.back() == "big.bin") {
+                std::vector<std::byte> buffer(5000);
+                auto count = co_await r.read_data(buffer);
+                REQUIRE(count.has_value());
+                CHECK(std::equal(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(*count),
+                                 pattern(200 * 1024, 2).begin()));
+            }
+            if (paths.back() == "small.txt") {
+                std::vector<std::byte> buffer(16);
+                auto count = co_await r.read_data(buffer);
+                REQUIRE(count.has_value());
+                CHECK(*count == 7);
+            }
+        }
+    };
+    CHECK(sync_wait(partial(reader)).size() == 4);
+}
+
+TEST_CASE("async_archive_reader entries() generator", "[unit][async]") {
+    const auto archive = make_archive();
+    async_archive_reader reader{std::make_unique<async_stream_adapter>(
+        std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive}))};
+
+    auto collect = [](async_archive_reader& r) -> task<std::vector<std::string>> {
+        std::vector<std::string> paths;
+        auto entries = r.entries();
+        while (auto entry = co_await entries.next()) {
+            REQUIRE(entry->has_value());
+            paths.push_back((*entry)->path().string());
+        }
+        co_return paths;
+    };
+    CHECK(sync_wait(collect(reader)) == std::vector<std::string>{long_path, "big.bin", "empty", "small.txt"});
+}
+
+TEST_CASE("async_archive_reader reports truncated archives", "[unit][async]") {
+    auto archive = make_archive();
+    archive.resize(100 * 1024);  // Cuts big.bin short
+
+    async_archive_reader reader{std::make_unique<threaded_stream>(archive, 8192)};
+    auto skip_all = [](async_archive_reader& r) -> task<std::expected<size_t, error>> {
+        size_t count = 0;
+        while (true) {
+            auto entry = co_await r.next_entry();
+            if (!entry) {
+                co_return std::unexpected(entry.error());
+            }
+            if (!*entry) {
+                co_return count;
+            }
+            ++count;
+        }
+    };
+    auto result = sync_wait(skip_all(reader));
+    REQUIRE_FALSE(result.has_value());
+    CHECK(result.error().code() == error_code::corrupt_archive);
+}
+
+TEST_CASE("async_archive_reader expands GNU sparse 1.0 entries", "[unit][async]") {
+    // PAX header announcing sparse 1.0, then the map block and two 4-byte segments
+    const std::string records =
+        "22 GNU.sparse.major=1\n"
+        "22 GNU.sparse.minor=0\n"
+        "25 GNU.sparse.name=holey\n"
+        "28 GNU.sparse.realsize=8196\n"
+        "14 path=holey\n";
+    std::vector<std::byte> archive;
+    append_padded(archive, raw_header("PaxHeaders/holey", 'x', records.size()));
+    append_padded(archive, as_bytes(records));
+    append_padded(archive, raw_header("GNUSparseFile/holey", '0', 512 + 8));
+    append_padded(archive, as_bytes("2\n0\n4\n8192\n4\n"));
+    append_padded(archive, as_bytes("abcdWXYZ"));
+    append_padded(archive, raw_header("after", '0', 2));
+    append_padded(archive, as_bytes("ok"));
+    archive.resize(archive.size() + 1024);
+
+    async_archive_reader reader{std::make_unique<threaded_stream>(archive, 100)};
+    auto run = [](async_archive_reader& r) -> task<bool> {
+        auto entry = co_await r.next_entry();
+        REQUIRE(entry.has_value());
+        REQUIRE(entry->has_value());
+        CHECK((*entry)->path() == "holey");
+        CHECK((*entry)->size() == 8196);
+
+        auto data = co_await read_all(r);
+        REQUIRE(data.has_value());
+        REQUIRE(data->size() == 8196);
+        CHECK(std::memcmp(data->data(), "abcd", 4) == 0);
+        CHECK(std::memcmp(data->data() + 8192, "WXYZ", 4) == 0);
+        CHECK(std::all_of(data->begin() + 4, data->begin() + 8192, [](std::byte b) { return b == std::byte{0}; }));
+
+        auto after = co_await r.next_entry();
+        REQUIRE(after.has_value());
+        REQUIRE(after->has_value());
+        CHECK((*after)->path() == "after");
+        co_return true;
+    };
+    CHECK(sync_wait(run(reader)));
+}
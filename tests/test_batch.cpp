@@ -0,0 +1,232 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <catch2/catch_test_macros.hpp>
+#include <tierone/tar/tar.hpp>
+#include <tierone/tar/batch.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tierone::tar;
+
+namespace {
+
+file_metadata make_file(const std::string& path, const size_t size) {
+    file_metadata meta;
+    meta.path = path;
+    meta.type = entry_type::regular_file;
+    meta.permissions = std::filesystem::perms{0644};
+    meta.size = size;
+    meta.modification_time = std::chrono::system_clock::from_time_t(1700000000);
+    return meta;
+}
+
+std::span<const std::byte> as_bytes(const std::string& text) {
+    return {reinterpret_cast<const std::byte*>(text.data()), text.size()};
+}
+
+// Archive number n holds n % 5 + 1 files, each naming the archive in its content
+std::vector<std::byte> make_archive(const size_t n) {
+    std::vector<std::byte> archive;
+    archive_writer writer{std::make_unique<memory_output_stream>(archive)};
+    for (size_t i = 0; i < n % 5 + 1; ++i) {
+        const auto content = "archive " + std::to_string(n);
+        REQUIRE(writer.add_entry(make_file("f" + std::to_string(i), content.size()), as_bytes(content)).has_value());
+    }
+    REQUIRE(writer.finish().has_value());
+    return archive;
+}
+
+// Directory removed when the test ends
+class temp_dir {
+    std::filesystem::path path_;
+public:
+    temp_dir() {
+        path_ = std::filesystem::temp_directory_path() /
+            ("tierone_batch_test_" + std::to_string(reinterpret_cast<uintptr_t>(this)));
+        std::filesystem::create_directories(path_);
+    }
+
+    ~temp_dir() {
+        std::error_code ec;
+        std::filesystem::remove_all(path_, ec);
+    }
+
+    std::filesystem::path write(const std::string& name, const std::vector<std::byte>& data) const {
+        const auto path = path_ / name;
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        return path;
+    }
+};
+
+// Memory stream that records how many reads run at once
+class counting_stream : public input_stream {
+    memory_mapped_stream inner_;
+    std::atomic<int>& active_;
+    std::atomic<int>& most_;
+
+public:
+    counting_stream(std::span<const std::byte> data, std::atomic<int>& active, std::atomic<int>& most)
+        : inner_(data), active_(active), most_(most) {}
+
+    std::expected<size_t, error> read(std::span<std::byte> buffer) override {
+        const int now = ++active_;
+        int seen = most_.load();
+        while (now > seen && !most_.compare_exchange_weak(seen, now)) {
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds{200});
+        auto result = inner_.read(buffer);
+        --active_;
+        return result;
+    }
+
+    std::expected<void, error> skip(const uint64_t bytes) override { return inner_.skip(bytes); }
+    bool at_end() const override { return inner_.at_end(); }
+};
+
+} // anonymous namespace
+
+TEST_CASE("for_each_archive reads every archive of a batch", "[unit][batch]") {
+    constexpr size_t count = 120;
+    std::vector<std::vector<std::byte>> archives;
+    for (size_t n = 0; n < count; ++n) {
+        archives.push_back(make_archive(n));
+    }
+    temp_dir dir;
+
+    // Files and streams mixed
+    std::vector<batch_source> sources;
+    for (size_t n = 0; n < count; ++n) {
+        if (n % 2 == 0) {
+            sources.emplace_back(dir.write(std::to_string(n) + ".tar", archives[n]));
+        } else {
+            sources.emplace_back(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archives[n]}));
+        }
+    }
+
+    std::mutex mutex;
+    std::vector<size_t> seen(count, 0);
+    std::vector<int> completions(count, 0);
+    std::atomic<int> mismatches{0};
+    const auto result = for_each_archive(std::move(sources),
+        [&](const size_t source, const archive_entry& entry) -> std::expected<void, error> {
+            auto data = entry.read_data();
+            if (!data || std::string_view{reinterpret_cast<const char*>(data->data()), data->size()} !=
+                             "archive " + std::to_string(source)) {
+                ++mismatches;
+            }
+            const std::lock_guard lock{mutex};
+            ++seen[source];
+            return {};
+        },
+        {.threads = 4, .max_reads_in_flight = 2},
+        [&](const size_t source, const std::expected<uint64_t, error>& entries) {
+            const std::lock_guard lock{mutex};
+            ++completions[source];
+            CHECK(entries.has_value());
+            CHECK(entries.value_or(0) == source % 5 + 1);
+        });
+
+    CHECK(result.archives == count);
+    CHECK(result.failures.empty());
+    CHECK(mismatches == 0);
+    uint64_t total = 0;
+    for (size_t n = 0; n < count; ++n) {
+        CHECK(seen[n] == n % 5 + 1);
+        CHECK(completions[n] == 1);
+        total += seen[n];
+    }
+    CHECK(result.entries == total);
+}
+
+TEST_CASE("for_each_archive reports failed archives and goes on", "[unit][batch]") {
+    const auto good = make_archive(3);
+    auto corrupt = make_archive(4);
+    corrupt[148] = std::byte{'X'};  // Checksum of the first header
+    temp_dir dir;
+
+    const auto sources = [&] {
+        std::vector<batch_source> result;
+        result.emplace_back(dir.write("good.tar", good));
+        result.emplace_back(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{corrupt}));
+        result.emplace_back(std::filesystem::path{"/nonexistent/archive.tar"});
+        result.emplace_back(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{good}));
+        return result;
+    };
+    const auto accept = [](size_t, const archive_entry&) -> std::expected<void, error> { return {}; };
+
+    SECTION("each failure is reported with its source") {
+        const auto result = for_each_archive(sources(), accept, {.threads = 3});
+        CHECK(result.archives == 2);
+        CHECK(result.entries == 8);
+        REQUIRE(result.failures.size() == 2);
+        CHECK(result.failures[0].first == 1);
+        CHECK(result.failures[1].first == 2);
+        CHECK(result.failures[1].second.system_errno() == ENOENT);
+    }
+
+    SECTION("a visitor error ends its archive only") {
+        const auto result = for_each_archive(sources(),
+            [](const size_t source, const archive_entry& entry) -> std::expected<void, error> {
+                if (source == 3 && entry.path() == "f1") {
+                    return std::unexpected(error{error_code::invalid_operation, "Rejected"});
+                }
+                return {};
+            });
+        CHECK(result.archives == 1);
+        REQUIRE(result.failures.size() == 3);
+        CHECK(result.failures[2].first == 3);
+        CHECK(result.failures[2].second.code() == error_code::invalid_operation);
+    }
+
+    SECTION("stop_on_error hands out no more archives") {
+        const auto result = for_each_archive(sources(), accept, {.threads = 1, .stop_on_error = true});
+        CHECK(result.archives == 1);
+        REQUIRE(result.failures.size() == 1);
+        CHECK(result.failures[0].first == 1);
+    }
+}
+
+TEST_CASE("for_each_archive caps the reads in flight", "[unit][batch]") {
+    std::vector<std::vector<std::byte>> archives;
+    for (size_t n = 0; n < 32; ++n) {
+        archives.push_back(make_archive(n));
+    }
+
+    for (const unsigned cap : {1u, 3u}) {
+        std::atomic<int> active{0};
+        std::atomic<int> most{0};
+        std::vector<batch_source> sources;
+        for (const auto& archive : archives) {
+            sources.emplace_back(std::make_unique<counting_stream>(archive, active, most));
+        }
+        const auto result = for_each_archive(std::move(sources),
+            [](size_t, const archive_entry&) -> std::expected<void, error> { return {}; },
+            {.threads = 8, .max_reads_in_flight = cap});
+        CHECK(result.archives == archives.size());
+        CHECK(most.load() <= static_cast<int>(cap));
+        CHECK(most.load() >= 1);
+    }
+}
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <catch2/catch_test_macros.hpp>
+#include <tierone/tar/tar.hpp>
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+using namespace tierone::tar;
+
+namespace {
+
+// Plain stream handing out at most 1000 bytes per read, so reads come up short
+class trickle_stream : public input_stream {
+private:
+    std::vector<std::byte> data_;
+    size_t position_ = 0;
+
+public:
+    explicit trickle_stream(std::vector<std::byte> data) : data_(std::move(data)) {}
+
+    std::expected<size_t, error> read(std::span<std::byte> buffer) override {
+        const size_t count = std::min({buffer.size(), data_.size() - position_, size_t{1000}});
+        std::ranges::copy_n(data_.begin() + static_cast<std::ptrdiff_t>(position_), static_cast<std::ptrdiff_t>(count),
+                            buffer.begin());
+        position_ += count;
+        return count;
+    }
+
+    std::expected<void, error> skip(uint64_t bytes) override {
+        position_ = std::min(position_ + bytes, data_.size());
+        return {};
+    }
+
+    bool at_end() const override { return position_ >= data_.size(); }
+};
+
+// Accepts a number of writes, then fails
+class failing_output : public output_stream {
+public:
+    size_t writes_left;
+
+    explicit failing_output(size_t writes) : writes_left(writes) {}
+
+    std::expected<void, error> write(std::span<const std::byte>) override {
+        if (writes_left == 0) {
+            return std::unexpected(error{error_code::io_error, "Disk full"});
+        }
+        --writes_left;
+        return {};
+    }
+};
+
+std::vector<std::byte> patterned(size_t size) {
+    std::vector<std::byte> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<std::byte>((i * 31 + i / 997) & 0xff);
+    }
+    return data;
+}
+
+std::vector<std::byte> single_file_archive(const std::vector<std::byte>& content) {
+    std::vector<std::byte> archive;
+    archive_writer writer{std::make_unique<memory_output_stream>(archive)};
+    file_metadata meta;
+    meta.path = "snapshot.db";
+    meta.type = entry_type::regular_file;
+    meta.permissions = std::filesystem::perms{0644};
+    meta.size = content.size();
+    REQUIRE(writer.add_entry(meta, content).has_value());
+    REQUIRE(writer.finish().has_value());
+    return archive;
+}
+
+} // anonymous namespace
+
+TEST_CASE("copy_entry copies entry data chunk by chunk", "[unit][copy]") {
+    const auto content = patterned(5 * 4096 + 77);
+    const auto archive = single_file_archive(content);
+    const copy_options options{.chunk_size = 4096, .buffers = 3, .observer = {}};
+
+    SECTION("streamed entries go through the buffer pipeline") {
+        archive_reader reader{std::make_unique<trickle_stream>(archive)};
+        auto entry = reader.next_entry();
+        REQUIRE(entry.has_value());
+        REQUIRE(entry->has_value());
+        CHECK_FALSE((*entry)->is_mapped());
+
+        std::vector<std::byte> output;
+        std::vector<std::byte> observed;
+        auto observing = options;
+        observing.observer = [&](std::span<const std::byte> chunk) {
+            CHECK(chunk.size() <= 4096);
+            observed.insert(observed.end(), chunk.begin(), chunk.end());
+        };
+        memory_output_stream sink{output};
+        auto copied = copy_entry(**entry, sink, observing);
+        REQUIRE(copied.has_value());
+        CHECK(*copied == content.size());
+        CHECK(output == content);
+        CHECK(observed == content);
+    }
+
+    SECTION("mapped entries are written from the mapping") {
+        archive_reader reader{std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive})};
+        auto entry = reader.next_entry();
+        REQUIRE(entry.has_value());
+        REQUIRE(entry->has_value());
+        CHECK((*entry)->is_mapped());
+
+        std::vector<std::byte> output;
+        memory_output_stream sink{output};
+        auto copied = copy_entry(**entry, sink, options);
+        REQUIRE(copied.has_value());
+        CHECK(output == content);
+    }
+
+    SECTION("a failing write stops the copy") {
+        archive_reader reader{std::make_unique<trickle_stream>(archive)};
+        auto entry = reader.next_entry();
+        REQUIRE(entry.has_value());
+        REQUIRE(entry->has_value());
+
+        failing_output sink{2};
+        auto copied = copy_entry(**entry, sink, options);
+        REQUIRE_FALSE(copied.has_value());
+        CHECK(copied.error().code() == error_code::io_error);
+    }
+
+    SECTION("a truncated archive is reported") {
+        auto truncated = archive;
+        truncated.resize(512 + 3 * 4096);
+        archive_reader reader{std::make_unique<trickle_stream>(truncated)};
+        auto entry = reader.next_entry();
+        REQUIRE(entry.has_value());
+        REQUIRE(entry->has_value());
+
+        std::vector<std::byte> output;
+        memory_output_stream sink{output};
+        CHECK_FALSE(copy_entry(**entry, sink, options).has_value());
+        CHECK(output.size() <= 3 * 4096);
+    }
+}
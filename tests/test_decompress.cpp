@@ -0,0 +1,523 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <tierone/tar/tar.hpp>
+#include <tierone/tar/decompress.hpp>
+#include <tierone/tar/archive_fs.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <span>
+#include <string>
+#include <vector>
+
+using namespace tierone::tar;
+
+namespace {
+
+// Compressed ustar archive holding a.txt ("alpha\n"), b.txt ("bravo " x 200)
+// and c.txt ("charlie\n"), 10240 bytes uncompressed
+constexpr unsigned char archive_gz[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xed, 0xd7, 0x41, 0x0a, 0xc2, 0x30,
+    0x10, 0x85, 0xe1, 0x59, 0x7b, 0x8a, 0x9e, 0x40, 0x92, 0x30, 0x26, 0xe7, 0x19, 0x45, 0x68, 0xa1,
+    0xa0, 0xc4, 0x28, 0x1e, 0xdf, 0xd8, 0xa5, 0xdd, 0x6a, 0x5a, 0xec, 0xff, 0x2d, 0xde, 0x40, 0xb2,
+    0xc8, 0x22, 0x0c, 0x93, 0xd8, 0xbe, 0x3c, 0x8b, 0xfc, 0x96, 0xab, 0xa2, 0xea, 0x54, 0xab, 0xcf,
+    0xfa, 0xde, 0x15, 0xaf, 0x87, 0xa0, 0x29, 0x39, 0x9d, 0xd6, 0x63, 0x8a, 0x2a, 0x9d, 0x93, 0x06,
+    0xee, 0xb7, 0x62, 0xb9, 0x1e, 0x29, 0xdb, 0x64, 0xe3, 0xb5, 0xb7, 0x9d, 0x60, 0xa3, 0x8e, 0xcb,
+    0xf7, 0x7f, 0x08, 0xd1, 0xcd, 0xfa, 0x3f, 0x79, 0xfa, 0xbf, 0xc9, 0xfd, 0x67, 0x7b, 0x5c, 0x3a,
+    0x92, 0x24, 0xc9, 0xf5, 0x27, 0x13, 0xfb, 0xbb, 0x4e, 0x6b, 0x78, 0xff, 0xfb, 0xf9, 0xfc, 0x8f,
+    0xcc, 0xff, 0x36, 0xf7, 0xdf, 0x5b, 0x1e, 0x87, 0x33, 0x3f, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0x00, 0x80, 0x3f, 0xf1, 0x02, 0x84, 0x7c, 0xbb, 0xee, 0x00, 0x28, 0x00, 0x00,
+};
+
+constexpr unsigned char archive_gz_two_members[] = {
+    0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0x4b, 0xd4, 0x2b, 0xa9, 0x28, 0x61,
+    0xa0, 0x2d, 0x30, 0x00, 0x02, 0x33, 0x13, 0x13, 0x30, 0x0d, 0x04, 0xe8, 0x34, 0x48, 0x96, 0xc1,
+    0xd0, 0xc4, 0xd4, 0xc8, 0xc4, 0xdc, 0xdc, 0xc0, 0x04, 0x2c, 0x6e, 0x66, 0x6e, 0x66, 0xc2, 0xa0,
+    0x60, 0xc0, 0x40, 0x07, 0x50, 0x5a, 0x5c, 0x92, 0x58, 0x04, 0xb4, 0x92, 0x61, 0x64, 0x82, 0xc4,
+    0x9c, 0x82, 0x8c, 0x44, 0x2e, 0x86, 0x51, 0x30, 0x42, 0x01, 0x00, 0xdd, 0xe2, 0xa7, 0xe5, 0x00,
+    0x04, 0x00, 0x00, 0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xed, 0xd5, 0x41,
+    0x0a, 0xc2, 0x30, 0x10, 0x85, 0xe1, 0x59, 0x7b, 0x8a, 0x9e, 0x40, 0x26, 0x61, 0x9a, 0x9c, 0x27,
+    0x11, 0x41, 0x41, 0x28, 0xc4, 0x28, 0x3d, 0x7e, 0x43, 0x97, 0x75, 0xab, 0xa9, 0xe8, 0xff, 0x2d,
+    0xde, 0x40, 0x36, 0x59, 0x0c, 0xc3, 0xcb, 0xc7, 0x3a, 0x57, 0xf9, 0x2c, 0x6d, 0x82, 0xd9, 0x3a,
+    0x9b, 0xed, 0xf4, 0x3e, 0xa8, 0x38, 0x1b, 0xbd, 0xc5, 0xa8, 0xb6, 0xbe, 0x87, 0x18, 0x9d, 0x0c,
+    0x2a, 0x1d, 0x3c, 0xee, 0x35, 0x95, 0xf6, 0xa5, 0xfc, 0xa7, 0x5c, 0xd2, 0x73, 0x1a, 0x48, 0x92,
+    0x24, 0xbf, 0x3f, 0x05, 0x6f, 0x75, 0xda, 0xbf, 0xff, 0x55, 0xdd, 0x6b, 0xff, 0x07, 0xfa, 0xbf,
+    0xcf, 0xfe, 0x2f, 0xa9, 0xdc, 0xae, 0xe7, 0x03, 0x97, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00, 0xf0, 0x1b, 0x16, 0x3c, 0xdc, 0x71, 0x22, 0x00, 0x24, 0x00, 0x00,
+};
+
+constexpr unsigned char archive_xz[] = {
+    0xfd, 0x37, 0x7a, 0x58, 0x5a, 0x00, 0x00, 0x04, 0xe6, 0xd6, 0xb4, 0x46, 0x02, 0x00, 0x21, 0x01,
+    0x16, 0x00, 0x00, 0x00, 0x74, 0x2f, 0xe5, 0xa3, 0xe0, 0x27, 0xff, 0x00, 0x93, 0x5d, 0x00, 0x30,
+    0x8b, 0x8a, 0x87, 0xc4, 0x0e, 0xf2, 0x97, 0xa4, 0xf8, 0x75, 0x3d, 0xc5, 0xa9, 0xed, 0xd9, 0x9a,
+    0x6d, 0xca, 0x21, 0xf4, 0xb3, 0x2b, 0x98, 0x5e, 0x90, 0x42, 0x24, 0x43, 0xde, 0x45, 0x61, 0xaf,
+    0x95, 0x87, 0x75, 0xf5, 0xfc, 0xf1, 0x83, 0x46, 0x3b, 0xa2, 0xff, 0x0b, 0x8a, 0x68, 0x67, 0x10,
+    0x0b, 0x98, 0xa3, 0xe0, 0xbf, 0x18, 0xd9, 0xf8, 0x1d, 0x15, 0x3b, 0xaa, 0xda, 0xb4, 0x1b, 0xff,
+    0xca, 0x89, 0x94, 0x7b, 0x5f, 0xbe, 0x6e, 0x44, 0x0d, 0xbb, 0x8a, 0xcd, 0x75, 0xa0, 0x77, 0x4f,
+    0x14, 0x9c, 0xaf, 0x33, 0xd7, 0xd7, 0x05, 0x82, 0x5b, 0x86, 0xf1, 0xae, 0xed, 0x16, 0x62, 0xbd,
+    0x95, 0xbc, 0x16, 0xf7, 0x00, 0x11, 0x1d, 0x80, 0xc1, 0xdf, 0x6e, 0x0a, 0x18, 0xa2, 0x51, 0xe4,
+    0x62, 0x43, 0x70, 0x7f, 0x22, 0x57, 0x5a, 0xd9, 0xdc, 0x24, 0xcc, 0x07, 0xd7, 0x03, 0xb6, 0x72,
+    0xba, 0x6d, 0x40, 0x2c, 0xf9, 0x3a, 0xfc, 0x19, 0xbc, 0x76, 0x8d, 0x11, 0x99, 0x7b, 0x8c, 0x86,
+    0x81, 0xd4, 0x00, 0x00, 0xe6, 0x9d, 0x22, 0xf8, 0x00, 0x1d, 0xc0, 0xd8, 0x00, 0x01, 0xaf, 0x01,
+    0x80, 0x50, 0x00, 0x00, 0xdd, 0xc6, 0x9a, 0x97, 0xb1, 0xc4, 0x67, 0xfb, 0x02, 0x00, 0x00, 0x00,
+    0x00, 0x04, 0x59, 0x5a,
+};
+
+constexpr unsigned char archive_zst[] = {
+    0x28, 0xb5, 0x2f, 0xfd, 0x60, 0x00, 0x27, 0xb5, 0x03, 0x00, 0x72, 0x84, 0x0e, 0x11, 0xa0, 0xed,
+    0xb0, 0xb3, 0xe3, 0x36, 0xff, 0xf4, 0x3f, 0xe4, 0xd7, 0xad, 0x82, 0x20, 0x84, 0x7d, 0x0a, 0x8a,
+    0x35, 0xd8, 0x2b, 0xed, 0x48, 0xc1, 0xd1, 0x86, 0x68, 0x9c, 0x35, 0x84, 0xa0, 0x83, 0x5e, 0xaf,
+    0xf5, 0x77, 0x0f, 0x5b, 0xc6, 0xf9, 0x6f, 0x38, 0x9b, 0x63, 0x78, 0xcf, 0x61, 0x52, 0x78, 0xdc,
+    0xec, 0x99, 0xcd, 0x5e, 0x56, 0x29, 0x3a, 0x13, 0x20, 0xf0, 0x68, 0x66, 0x72, 0x7b, 0xfb, 0xc7,
+    0x3d, 0xc0, 0x2f, 0x60, 0xaa, 0x91, 0x0d, 0x80, 0x0a, 0xea, 0x61, 0x60, 0x80, 0x50, 0xdc, 0xc4,
+    0x8a, 0x56, 0xed, 0x29, 0xf1, 0x97, 0xb1, 0x2a, 0xc6, 0x99, 0xfe, 0x00, 0xd3, 0x6b, 0x5f, 0x35,
+    0xf3, 0xa6, 0xce, 0x93, 0x39, 0xbb, 0xb9, 0xb1, 0xe0, 0x80, 0x83, 0x06, 0xb0, 0x9d, 0x02, 0x1c,
+};
+
+// The same archive in five independent 2048-byte frames: BGZF blocks ending
+// with the empty EOF block, and zstd frames followed by a seek table
+constexpr unsigned char archive_bgzf[] = {
+    0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43, 0x02, 0x00,
+    0x75, 0x00, 0x4b, 0xd4, 0x2b, 0xa9, 0x28, 0x61, 0xa0, 0x2d, 0x30, 0x00, 0x02, 0x33, 0x13, 0x13,
+    0x30, 0x0d, 0x04, 0xe8, 0x34, 0x48, 0x96, 0xc1, 0xd0, 0xc4, 0xd4, 0xc8, 0xc4, 0xdc, 0xdc, 0xc0,
+    0x04, 0x2c, 0x6e, 0x66, 0x6e, 0x66, 0xc2, 0xa0, 0x60, 0xc0, 0x40, 0x07, 0x50, 0x5a, 0x5c, 0x92,
+    0x58, 0x04, 0xb4, 0x92, 0x61, 0x64, 0x82, 0xc4, 0x9c, 0x82, 0x8c, 0x44, 0x2e, 0x86, 0x51, 0x30,
+    0x42, 0x41, 0xd2, 0xc0, 0xe7, 0x7f, 0x23, 0x23, 0x33, 0x03, 0x8c, 0xfc, 0x6f, 0x6e, 0x38, 0x9a,
+    0xff, 0xe9, 0x12, 0xff, 0x45, 0x89, 0x65, 0xf9, 0x0a, 0xa3, 0xe4, 0x48, 0x25, 0x01, 0x18, 0x63,
+    0xc1, 0x63, 0x00, 0x08, 0x00, 0x00, 0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+    0x06, 0x00, 0x42, 0x43, 0x02, 0x00, 0x6e, 0x00, 0x4b, 0x2c, 0xcb, 0x57, 0x48, 0x2a, 0x4a, 0x1c,
+    0x25, 0x47, 0xc9, 0x21, 0x41, 0x32, 0x8c, 0x02, 0xaa, 0x82, 0x64, 0xbd, 0x92, 0x8a, 0x12, 0x1a,
+    0xdb, 0x61, 0x00, 0x04, 0x66, 0x26, 0x26, 0x60, 0x1a, 0x08, 0xd0, 0x69, 0x03, 0x03, 0x43, 0x03,
+    0x06, 0x43, 0x13, 0x53, 0x23, 0x13, 0x73, 0x73, 0x03, 0x13, 0xb0, 0xb8, 0x99, 0xb9, 0x99, 0x21,
+    0x83, 0x82, 0x01, 0x3d, 0x02, 0xa0, 0xb4, 0xb8, 0x24, 0xb1, 0x08, 0x68, 0xe5, 0x48, 0x8d, 0xff,
+    0x8c, 0xc4, 0xa2, 0x9c, 0xcc, 0x54, 0xae, 0xd1, 0x9c, 0x30, 0x32, 0x01, 0x00, 0x6c, 0x60, 0x51,
+    0x5e, 0x00, 0x08, 0x00, 0x00, 0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06,
+    0x00, 0x42, 0x43, 0x02, 0x00, 0x2a, 0x00, 0x63, 0x60, 0x18, 0x05, 0xa3, 0x60, 0x14, 0x8c, 0x82,
+    0x51, 0x30, 0x0a, 0x46, 0xc1, 0x48, 0x03, 0x00, 0x9e, 0xba, 0xe8, 0xf1, 0x00, 0x08, 0x00, 0x00,
+    0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43, 0x02, 0x00,
+    0x2a, 0x00, 0x63, 0x60, 0x18, 0x05, 0xa3, 0x60, 0x14, 0x8c, 0x82, 0x51, 0x30, 0x0a, 0x46, 0xc1,
+    0x48, 0x03, 0x00, 0x9e, 0xba, 0xe8, 0xf1, 0x00, 0x08, 0x00, 0x00, 0x1f, 0x8b, 0x08, 0x04, 0x00,
+    0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43, 0x02, 0x00, 0x2a, 0x00, 0x63, 0x60, 0x18,
+    0x05, 0xa3, 0x60, 0x14, 0x8c, 0x82, 0x51, 0x30, 0x0a, 0x46, 0xc1, 0x48, 0x03, 0x00, 0x9e, 0xba,
+    0xe8, 0xf1, 0x00, 0x08, 0x00, 0x00, 0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff,
+    0x06, 0x00, 0x42, 0x43, 0x02, 0x00, 0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x00
+};
+
+constexpr unsigned char archive_zst_seekable[] = {
+    0x28, 0xb5, 0x2f, 0xfd, 0x60, 0x00, 0x07, 0xb5, 0x02, 0x00, 0x42, 0x04, 0x0d, 0x10, 0xa0, 0xed,
+    0xb0, 0xb3, 0x43, 0xdf, 0xe9, 0x7f, 0x18, 0x64, 0xdd, 0x06, 0x0c, 0x38, 0xc7, 0xa7, 0x41, 0xc1,
+    0x65, 0x67, 0x98, 0x2b, 0x21, 0xc7, 0x60, 0xd1, 0x4a, 0xeb, 0xdf, 0x6c, 0x5d, 0x7b, 0x7e, 0x70,
+    0xaa, 0xd1, 0xdf, 0x7f, 0xde, 0x98, 0x24, 0x25, 0x87, 0xf5, 0xce, 0xd4, 0xff, 0xb7, 0x8b, 0x4e,
+    0x6c, 0x0b, 0x20, 0x80, 0x19, 0xd8, 0x1e, 0xf7, 0x51, 0xcb, 0x58, 0x15, 0x6b, 0xa6, 0x3f, 0x80,
+    0xf4, 0xda, 0xab, 0x66, 0x9e, 0x3a, 0x80, 0x34, 0xc4, 0xcc, 0x13, 0x86, 0xb3, 0x13, 0x2f, 0x02,
+    0x28, 0xb5, 0x2f, 0xfd, 0x60, 0x00, 0x07, 0xad, 0x02, 0x00, 0xa2, 0x43, 0x0c, 0x10, 0xa0, 0xed,
+    0xb0, 0xe3, 0xdd, 0x46, 0xe7, 0xff, 0x77, 0x5a, 0xdd, 0x06, 0x0c, 0x38, 0xc7, 0xa7, 0x60, 0x35,
+    0x07, 0x11, 0x53, 0xfe, 0x0d, 0x91, 0x8c, 0xd3, 0x0f, 0x1e, 0xe6, 0x98, 0xfd, 0x39, 0x4b, 0xca,
+    0x0e, 0x7f, 0xfc, 0xf7, 0xae, 0xb9, 0x65, 0x95, 0x42, 0x19, 0xa6, 0xf0, 0x28, 0x0a, 0x0b, 0x00,
+    0x25, 0x40, 0x81, 0xa6, 0xad, 0x42, 0xe5, 0x73, 0x40, 0x1d, 0xf0, 0x26, 0x6e, 0xa7, 0xa0, 0x2b,
+    0x08, 0x80, 0x41, 0x01, 0xc0, 0x16, 0x4c, 0x90, 0xc9, 0x55, 0xc5, 0xa9, 0x54, 0xa5, 0x08, 0x28,
+    0xb5, 0x2f, 0xfd, 0x60, 0x00, 0x07, 0x45, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00, 0xfc, 0xff, 0x40,
+    0x08, 0x28, 0xb5, 0x2f, 0xfd, 0x60, 0x00, 0x07, 0x45, 0x00, 0x00, 0x08, 0x00, 0x01, 0x00, 0xfc,
+    0xff, 0x40, 0x08, 0x28, 0xb5, 0x2f, 0xfd, 0x60, 0x00, 0x07, 0x45, 0x00, 0x00, 0x08, 0x00, 0x01,
+    0x00, 0xfc, 0xff, 0x40, 0x08, 0x5e, 0x2a, 0x4d, 0x18, 0x31, 0x00, 0x00, 0x00, 0x60, 0x00, 0x00,
+    0x00, 0x00, 0x08, 0x00, 0x00, 0x5f, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x12, 0x00, 0x00,
+    0x00, 0x00, 0x08, 0x00, 0x00, 0x12, 0x00, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x12, 0x00, 0x00,
+    0x00, 0x00, 0x08, 0x00, 0x00, 0x05, 0x00, 0x00, 0x00, 0x00, 0xb1, 0xea, 0x92, 0x8f
+};
+
+template<size_t N>
+std::span<const std::byte> bytes_of(const unsigned char (&data)[N]) {
+    return {reinterpret_cast<const std::byte*>(data), N};
+}
+
+std::string to_string(std::span<const std::byte> bytes) {
+    return std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+// Read every entry, leaving all but c.txt's data to be skipped unless read_all_data
+void check_archive(std::span<const std::byte> compressed, bool read_all_data) {
+    auto reader = open_archive(std::make_unique<memory_mapped_stream>(compressed));
+    REQUIRE(reader.has_value());
+    CHECK_FALSE(reader->is_mapped());
+
+    std::vector<std::string> paths;
+    while (true) {
+        auto entry = reader->next_entry();
+        REQUIRE(entry.has_value());
+        if (!*entry) break;
+        paths.push_back((*entry)->path().string());
+
+        // Data of entries not read here is skipped by the next call
+        if (read_all_data || (*entry)->path() == "c.txt") {
+            auto data = (*entry)->read_data();
+            REQUIRE(data.has_value());
+            if ((*entry)->path() == "a.txt") CHECK(to_string(*data) == "alpha\n");
+            if ((*entry)->path() == "c.txt") CHECK(to_string(*data) == "charlie\n");
+            if ((*entry)->path() == "b.txt") {
+                std::string expected;
+                for (int i = 0; i < 200; ++i) expected += "bravo ";
+                CHECK(to_string(*data) == expected);
+            }
+        }
+    }
+    CHECK(paths == std::vector<std::string>{"a.txt", "b.txt", "c.txt"});
+}
+
+} // anonymous namespace
+
+TEST_CASE("detect_compression recognizes magic bytes", "[unit][decompress]") {
+    CHECK(detect_compression(bytes_of(archive_gz)) == compression_format::gzip);
+    CHECK(detect_compression(bytes_of(archive_xz)) == compression_format::xz);
+    CHECK(detect_compression(bytes_of(archive_zst)) == compression_format::zstd);
+
+    const unsigned char plain[] = {'a', '.', 't', 'x', 't', 0};
+    CHECK(detect_compression(bytes_of(plain)) == compression_format::none);
+    CHECK(detect_compression({}) == compression_format::none);
+}
+
+TEST_CASE("open_archive decompresses transparently", "[unit][decompress]") {
+    const auto formats = {
+        std::pair{compression_format::gzip, bytes_of(archive_gz)},
+        std::pair{compression_format::gzip, bytes_of(archive_gz_two_members)},
+        std::pair{compression_format::xz, bytes_of(archive_xz)},
+        std::pair{compression_format::zstd, bytes_of(archive_zst)},
+        std::pair{compression_format::gzip, bytes_of(archive_bgzf)},
+        std::pair{compression_format::zstd, bytes_of(archive_zst_seekable)},
+    };
+    for (const auto& [format, compressed] : formats) {
+        if (!is_compression_supported(format)) {
+            auto stream = decompress_stream::create(std::make_unique<memory_mapped_stream>(compressed), format);
+            REQUIRE_FALSE(stream.has_value());
+            CHECK(stream.error().code() == error_code::unsupported_feature);
+            continue;
+        }
+        check_archive(compressed, true);
+        check_archive(compressed, false);
+    }
+}
+
+TEST_CASE("decompress_stream reads and skips", "[unit][decompress]") {
+    if (!is_compression_supported(compression_format::gzip)) {
+        SKIP("gzip support not built in");
+    }
+
+    SECTION("Small reads and skips cover the whole stream") {
+        auto stream = decompress_stream::create(
+            std::make_unique<memory_mapped_stream>(bytes_of(archive_gz)), compression_format::gzip, 64);
+        REQUIRE(stream.has_value());
+
+        size_t total = 0;
+        std::array<std::byte, 100> buffer{};
+        while (true) {
+            auto read = stream->read(buffer);
+            REQUIRE(read.has_value());
+            if (*read == 0) break;
+            total += *read;
+            if (total + 412 <= 10240) {
+                REQUIRE(stream->skip(412).has_value());
+                total += 412;
+            }
+        }
+        CHECK(total == 10240);
+        CHECK(stream->at_end());
+        CHECK_FALSE(stream->skip(1).has_value());
+    }
+
+    SECTION("Truncated input is an error") {
+        const auto truncated = bytes_of(archive_gz).first(80);
+        auto stream = decompress_stream::create(
+            std::make_unique<memory_mapped_stream>(truncated), compression_format::gzip);
+        REQUIRE(stream.has_value());
+        std::vector<std::byte> buffer(20000);
+        auto read = stream->read(buffer);
+        REQUIRE_FALSE(read.has_value());
+        CHECK(read.error().code() == error_code::corrupt_archive);
+    }
+}
+
+TEST_CASE("find_frames reads frame indexes", "[unit][decompress]") {
+    SECTION("BGZF blocks") {
+        memory_mapped_stream stream{bytes_of(archive_bgzf)};
+        auto frames = find_frames(stream, compression_format::gzip);
+        REQUIRE(frames.has_value());
+        // The empty EOF block is left out
+        REQUIRE(frames->size() == 5);
+        CHECK((*frames)[0].compressed_offset == 0);
+        CHECK((*frames)[1].uncompressed_offset == 2048);
+        CHECK((*frames)[4].uncompressed_size == 2048);
+        CHECK((*frames)[4].compressed_offset + (*frames)[4].compressed_size + 28 == sizeof(archive_bgzf));
+        CHECK(stream.position() == 0);
+    }
+
+    SECTION("zstd seek table") {
+        memory_mapped_stream stream{bytes_of(archive_zst_seekable)};
+        auto frames = find_frames(stream, compression_format::zstd);
+        REQUIRE(frames.has_value());
+        REQUIRE(frames->size() == 5);
+        CHECK((*frames)[2].compressed_offset == (*frames)[1].compressed_offset + (*frames)[1].compressed_size);
+        CHECK((*frames)[4].uncompressed_offset == 8192);
+    }
+
+    SECTION("Streams without an index give no frames") {
+        memory_mapped_stream gz{bytes_of(archive_gz_two_members)};
+        auto frames = find_frames(gz, compression_format::gzip);
+        REQUIRE(frames.has_value());
+        CHECK(frames->empty());
+
+        memory_mapped_stream zst{bytes_of(archive_zst)};
+        frames = find_frames(zst, compression_format::zstd);
+        REQUIRE(frames.has_value());
+        CHECK(frames->empty());
+    }
+
+    SECTION("BGZF blocks claiming more than 64 KiB are corrupt") {
+        // The first two blocks' ISIZE trailers claim 0xFFFFFFF0 bytes each
+        std::vector<std::byte> crafted(bytes_of(archive_bgzf).begin(), bytes_of(archive_bgzf).end());
+        size_t offset = 0;
+        for (int block = 0; block < 2; ++block) {
+            const size_t block_size = (static_cast<size_t>(crafted[offset + 16]) |
+                                       static_cast<size_t>(crafted[offset + 17]) << 8) + 1;
+            for (size_t i = 0; i < 4; ++i) {
+                crafted[offset + block_size - 4 + i] = static_cast<std::byte>((0xFFFFFFF0u >> (8 * i)) & 0xff);
+            }
+            offset += block_size;
+        }
+
+        memory_mapped_stream stream{crafted};
+        auto frames = find_frames(stream, compression_format::gzip);
+        REQUIRE_FALSE(frames.has_value());
+        CHECK(frames.error().code() == error_code::corrupt_archive);
+
+        // Opening fails with an error rather than allocating the claimed sizes
+        auto reader = open_archive(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{crafted}));
+        REQUIRE_FALSE(reader.has_value());
+        CHECK(reader.error().code() == error_code::corrupt_archive);
+    }
+
+    SECTION("zstd seek tables listing oversized frames are not used") {
+        // Entries of 8 bytes (no checksums) start after the 8-byte skippable header
+        std::vector<std::byte> crafted(bytes_of(archive_zst_seekable).begin(), bytes_of(archive_zst_seekable).end());
+        const size_t table = crafted.size() - 9 - 5 * 8;
+        for (size_t i = 0; i < 4; ++i) {
+            crafted[table + 4 + i] = static_cast<std::byte>((0xFFFFFFF0u >> (8 * i)) & 0xff);
+        }
+
+        memory_mapped_stream stream{crafted};
+        auto frames = find_frames(stream, compression_format::zstd);
+        REQUIRE(frames.has_value());
+        CHECK(frames->empty());
+
+        // The frames themselves are intact, so the archive still reads sequentially
+        check_archive(crafted, true);
+    }
+}
+
+TEST_CASE("parallel_decompress_stream decodes frames in order", "[unit][decompress]") {
+    for (const auto& [format, compressed] : {std::pair{compression_format::gzip, bytes_of(archive_bgzf)},
+                                             std::pair{compression_format::zstd, bytes_of(archive_zst_seekable)}}) {
+        if (!is_compression_supported(format)) {
+            continue;
+        }
+        memory_mapped_stream index_source{compressed};
+        auto frames = find_frames(index_source, format);
+        REQUIRE(frames.has_value());
+
+        auto sequential = decompress_stream::create(std::make_unique<memory_mapped_stream>(compressed), format);
+        REQUIRE(sequential.has_value());
+        std::vector<std::byte> expected(10240);
+        REQUIRE(sequential->read(expected) == 10240);
+
+        const auto open = [&, format = format, compressed = compressed] {
+            auto stream = parallel_decompress_stream::create(std::make_unique<memory_mapped_stream>(compressed),
+                                                             format, *frames, {.threads = 3, .frames_ahead = 2});
+            REQUIRE(stream.has_value());
+            return std::move(*stream);
+        };
+
+        // Reads cross frame boundaries
+        {
+            auto stream = open();
+            std::vector<std::byte> out;
+            std::array<std::byte, 700> buffer{};
+            while (true) {
+                auto read = stream.read(buffer);
+                REQUIRE(read.has_value());
+                if (*read == 0) break;
+                out.insert(out.end(), buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(*read));
+            }
+            CHECK(out == expected);
+            CHECK(stream.at_end());
+        }
+
+        // Skips jump over whole frames
+        {
+            auto stream = open();
+            std::array<std::byte, 16> buffer{};
+            REQUIRE(stream.read(buffer) == 16);
+            REQUIRE(stream.skip(6000).has_value());
+            REQUIRE(stream.read(buffer) == 16);
+            CHECK(std::equal(buffer.begin(), buffer.end(), expected.begin() + 6016));
+            REQUIRE(stream.skip(10240 - 6032).has_value());
+            CHECK(stream.at_end());
+            CHECK_FALSE(stream.skip(1).has_value());
+        }
+
+        // A frame that does not decode to its indexed size is reported when the reader reaches it
+        {
+            auto damaged = *frames;
+            damaged[2].uncompressed_size -= 1;
+            auto broken = parallel_decompress_stream::create(
+                std::make_unique<memory_mapped_stream>(compressed), format, damaged);
+            REQUIRE(broken.has_value());
+            std::vector<std::byte> buffer(4096);
+            REQUIRE(broken->read(buffer) == 4096);
+            auto read = broken->read(buffer);
+            REQUIRE_FALSE(read.has_value());
+            CHECK(read.error().code() == error_code::corrupt_archive);
+        }
+    }
+}
+
+TEST_CASE("Indexed compressed archives support open_entry", "[unit][decompress]") {
+    // A seekable source without mapped data, so frames are read through seek()
+    class seekable_stream : public memory_mapped_stream {
+    public:
+        using memory_mapped_stream::memory_mapped_stream;
+        std::optional<std::span<const std::byte>> mapped_data() const override { return std::nullopt; }
+    };
+
+    for (const auto& [format, compressed] : {std::pair{compression_format::gzip, bytes_of(archive_bgzf)},
+                                             std::pair{compression_format::zstd, bytes_of(archive_zst_seekable)}}) {
+        if (!is_compression_supported(format)) {
+            continue;
+        }
+        for (const bool mapped : {true, false}) {
+            std::unique_ptr<input_stream> source = mapped
+                ? std::make_unique<memory_mapped_stream>(compressed)
+                : std::make_unique<seekable_stream>(compressed);
+            auto reader = open_archive(std::move(source));
+            REQUIRE(reader.has_value());
+            CHECK_FALSE(reader->is_mapped());
+
+            auto index = archive_index::build(*reader);
+            REQUIRE(index.has_value());
+            const auto* c = index->find("c.txt");
+            const auto* a = index->find("a.txt");
+            REQUIRE(c != nullptr);
+            REQUIRE(a != nullptr);
+
+            // Backwards and forwards across frames
+            for (const auto* record : {c, a, c}) {
+                auto entry = reader->open_entry(*record);
+                REQUIRE(entry.has_value());
+                auto data = entry->read_data();
+                REQUIRE(data.has_value());
+                CHECK(to_string(*data) == (record == a ? "alpha\n" : "charlie\n"));
+            }
+
+            // Iteration continues after the opened entry
+            auto next = reader->open_entry(*a);
+            REQUIRE(next.has_value());
+            auto following = reader->next_entry();
+            REQUIRE(following.has_value());
+            REQUIRE(following->has_value());
+            CHECK((*following)->path() == "b.txt");
+        }
+    }
+}
+
+TEST_CASE("archive_fs reads compressed archives in decompressed offsets", "[unit][decompress][archive_fs]") {
+    if (!is_compression_supported(compression_format::gzip)) {
+        SKIP("gzip support not built in");
+    }
+    const auto path = std::filesystem::temp_directory_path() / "tierone_decompress_fs_test.tar.gz";
+    const auto write = [&](const std::span<const std::byte> data) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+    };
+
+    SECTION("BGZF") {
+        write(bytes_of(archive_bgzf));
+        auto fs = archive_fs::open(path);
+        REQUIRE(fs.has_value());
+        std::vector<std::byte> buffer(2000);
+        for (const auto& [name, content] : {std::pair{"a.txt", std::string{"alpha\n"}},
+                                            std::pair{"c.txt", std::string{"charlie\n"}}}) {
+            auto got = fs->read(name, 0, buffer);
+            REQUIRE(got.has_value());
+            CHECK(to_string(std::span{buffer}.first(*got)) == content);
+        }
+        auto got = fs->read("b.txt", 6, buffer);
+        REQUIRE(got.has_value());
+        CHECK(*got == 1194);
+        CHECK(to_string(std::span{buffer}.first(6)) == "bravo ");
+    }
+
+    SECTION("Plain gzip cannot be read at offsets") {
+        write(bytes_of(archive_gz));
+        auto fs = archive_fs::open(path);
+        REQUIRE_FALSE(fs.has_value());
+        CHECK(fs.error().code() == error_code::unsupported_feature);
+    }
+
+    std::error_code ec;
+    std::filesystem::remove(path, ec);
+}
+
+TEST_CASE("parallel_decompress_stream seeks and peeks across frames", "[unit][decompress]") {
+    if (!is_compression_supported(compression_format::zstd)) {
+        SKIP("zstd support not built in");
+    }
+    memory_mapped_stream index_source{bytes_of(archive_zst_seekable)};
+    auto frames = find_frames(index_source, compression_format::zstd);
+    REQUIRE(frames.has_value());
+
+    auto sequential = decompress_stream::create(
+        std::make_unique<memory_mapped_stream>(bytes_of(archive_zst_seekable)), compression_format::zstd);
+    REQUIRE(sequential.has_value());
+    std::vector<std::byte> expected(10240);
+    REQUIRE(sequential->read(expected) == 10240);
+
+    auto stream = parallel_decompress_stream::create(std::make_unique<memory_mapped_stream>(
+        bytes_of(archive_zst_seekable)), compression_format::zstd, *frames, {.threads = 2, .frames_ahead = 1});
+    REQUIRE(stream.has_value());
+    CHECK(stream->size() == 10240);
+
+    for (const size_t target : {9000, 100, 4000, 2047, 0}) {
+        REQUIRE(stream->seek(target).has_value());
+        CHECK(stream->position() == target);
+
+        // Crosses into frames that are not in flight with a one-slot ring
+        auto view = stream->peek(3000);
+        REQUIRE(view.has_value());
+        const size_t available = std::min<size_t>(3000, 10240 - target);
+        REQUIRE(view->size() == available);
+        CHECK(std::equal(view->begin(), view->end(), expected.begin() + static_cast<std::ptrdiff_t>(target)));
+
+        std::array<std::byte, 64> buffer{};
+        auto read = stream->read(buffer);
+        REQUIRE(read.has_value());
+        CHECK(std::equal(buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(*read),
+                         expected.begin() + static_cast<std::ptrdiff_t>(target)));
+    }
+
+    REQUIRE(stream->seek(10240).has_value());
+    CHECK(stream->at_end());
+    CHECK_FALSE(stream->seek(10241).has_value());
+}
@@ -0,0 +1,248 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <catch2/catch_test_macros.hpp>
+#include <tierone/tar/tar.hpp>
+#include <tierone/tar/extract.hpp>
+#include <algorithm>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace tierone::tar;
+
+namespace {
+
+std::vector<std::byte> bytes_of(const std::string& text) {
+    std::vector<std::byte> data(text.size());
+    std::ranges::transform(text, data.begin(), [](char c) { return static_cast<std::byte>(c); });
+    return data;
+}
+
+std::vector<std::byte> patterned(size_t size) {
+    std::vector<std::byte> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<std::byte>((i * 31 + i / 997) & 0xff);
+    }
+    return data;
+}
+
+// Plain stream over a buffer, without random access
+class plain_stream : public input_stream {
+private:
+    std::span<const std::byte> data_;
+    size_t position_ = 0;
+
+public:
+    explicit plain_stream(std::span<const std::byte> data) : data_(data) {}
+
+    std::expected<size_t, error> read(std::span<std::byte> buffer) override {
+        const size_t count = std::min(buffer.size(), data_.size() - position_);
+        std::ranges::copy(data_.subspan(position_, count), buffer.begin());
+        position_ += count;
+        return count;
+    }
+
+    std::expected<void, error> skip(uint64_t bytes) override {
+        position_ = std::min(position_ + bytes, data_.size());
+        return {};
+    }
+
+    bool at_end() const override { return position_ >= data_.size(); }
+};
+
+entry_digests digests_of(std::span<const std::byte> data) {
+    content_hasher hasher{{.sha256 = true, .xxh64 = true}};
+    hasher.update(data);
+    return hasher.finish();
+}
+
+// Archive of two regular files around a directory
+std::vector<std::byte> sample_archive(const std::vector<std::byte>& first, const std::vector<std::byte>& second) {
+    std::vector<std::byte> archive;
+    archive_writer writer{std::make_unique<memory_output_stream>(archive)};
+    file_metadata meta;
+    meta.type = entry_type::regular_file;
+    meta.permissions = std::filesystem::perms{0644};
+
+    meta.path = "first.bin";
+    meta.size = first.size();
+    REQUIRE(writer.add_entry(meta, first).has_value());
+
+    meta.path = "dir/";
+    meta.type = entry_type::directory;
+    meta.size = 0;
+    REQUIRE(writer.add_entry(meta, {}).has_value());
+
+    meta.path = "dir/second.bin";
+    meta.type = entry_type::regular_file;
+    meta.size = second.size();
+    REQUIRE(writer.add_entry(meta, second).has_value());
+    REQUIRE(writer.finish().has_value());
+    return archive;
+}
+
+} // anonymous namespace
+
+TEST_CASE("content_hasher matches known digests", "[unit][digest]") {
+    content_hasher hasher{{.sha256 = true, .xxh64 = true}};
+
+    SECTION("empty input") {
+        const auto digests = hasher.finish();
+        REQUIRE(digests.sha256.has_value());
+        REQUIRE(digests.xxh64.has_value());
+        CHECK(to_hex(*digests.sha256) == "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855");
+        CHECK(to_hex(*digests.xxh64) == "ef46db3751d8e999");
+    }
+
+    SECTION("short input") {
+        hasher.update(bytes_of("abc"));
+        const auto digests = hasher.finish();
+        CHECK(to_hex(*digests.sha256) == "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad");
+        CHECK(to_hex(*digests.xxh64) == "44bc2cf5ad770999");
+    }
+
+    SECTION("input over many blocks, in uneven chunks") {
+        const auto data = patterned(300000);
+        std::mt19937 gen(7);
+        std::uniform_int_distribution<size_t> chunk(0, 5000);
+        for (size_t offset = 0; offset < data.size();) {
+            const size_t count = std::min(chunk(gen), data.size() - offset);
+            hasher.update(std::span{data}.subspan(offset, count));
+            offset += count;
+        }
+        const auto digests = hasher.finish();
+        CHECK(to_hex(*digests.sha256) == "021df9e33ebd37cbb792bedab46a4351336a6ce1ddbf4abe257a3714b09096e7");
+        CHECK(to_hex(*digests.xxh64) == "21e313f07d5e2ea2");
+    }
+
+    SECTION("only requested algorithms are computed") {
+        content_hasher only_xxh64{{.sha256 = false, .xxh64 = true}};
+        only_xxh64.update(bytes_of("abc"));
+        const auto digests = only_xxh64.finish();
+        CHECK_FALSE(digests.sha256.has_value());
+        REQUIRE(digests.xxh64.has_value());
+        CHECK(to_hex(*digests.xxh64) == "44bc2cf5ad770999");
+    }
+
+    SECTION("reset starts over") {
+        hasher.update(bytes_of("not hashed"));
+        hasher.reset();
+        hasher.update(bytes_of("abc"));
+        CHECK(to_hex(*hasher.finish().xxh64) == "44bc2cf5ad770999");
+    }
+}
+
+TEST_CASE("archive_reader hashes entry data as it is read", "[unit][digest]") {
+    const auto first = patterned(70000);
+    const auto second = bytes_of("second file");
+    const auto archive = sample_archive(first, second);
+    const std::span<const std::byte> view{archive};
+
+    SECTION("without enable_digests no entry has digests") {
+        archive_reader reader{std::make_unique<memory_mapped_stream>(view)};
+        auto entry = reader.next_entry();
+        REQUIRE(entry.has_value());
+        REQUIRE(entry->has_value());
+        REQUIRE((*entry)->read_data().has_value());
+        CHECK_FALSE((*entry)->digests().has_value());
+    }
+
+    for (const bool mapped : {false, true}) {
+        DYNAMIC_SECTION((mapped ? "mapped" : "streamed") << " archive") {
+            std::unique_ptr<input_stream> stream;
+            if (mapped) {
+                stream = std::make_unique<memory_mapped_stream>(view);
+            } else {
+                stream = std::make_unique<plain_stream>(view);
+            }
+            archive_reader reader{std::move(stream)};
+            reader.enable_digests({.sha256 = true, .xxh64 = true});
+
+            auto entry = reader.next_entry();
+            REQUIRE(entry.has_value());
+            REQUIRE(entry->has_value());
+            CHECK_FALSE((*entry)->digests().has_value());
+            std::array<std::byte, 4096> buffer{};
+            auto part = (*entry)->read_into(0, buffer);
+            REQUIRE(part.has_value());
+            CHECK_FALSE((*entry)->digests().has_value());
+            auto rest = (*entry)->read_data(*part);
+            REQUIRE(rest.has_value());
+
+            const auto expected = digests_of(first);
+            const auto digests = (*entry)->digests();
+            REQUIRE(digests.has_value());
+            CHECK(digests->sha256 == expected.sha256);
+            CHECK(digests->xxh64 == expected.xxh64);
+
+            auto directory = reader.next_entry();
+            REQUIRE(directory.has_value());
+            REQUIRE(directory->has_value());
+            CHECK_FALSE((*directory)->digests().has_value());
+
+            auto last = reader.next_entry();
+            REQUIRE(last.has_value());
+            REQUIRE(last->has_value());
+            REQUIRE((*last)->read_data().has_value());
+            REQUIRE((*last)->digests().has_value());
+            CHECK((*last)->digests()->sha256 == digests_of(second).sha256);
+        }
+    }
+
+    SECTION("reading out of order leaves the entry without digests") {
+        archive_reader reader{std::make_unique<memory_mapped_stream>(view)};
+        reader.enable_digests({.sha256 = false, .xxh64 = true});
+        auto entry = reader.next_entry();
+        REQUIRE(entry.has_value());
+        REQUIRE(entry->has_value());
+        REQUIRE((*entry)->read_data(1000, first.size() - 1000).has_value());
+        REQUIRE((*entry)->read_data(0, 500).has_value());
+        CHECK_FALSE((*entry)->digests().has_value());
+    }
+}
+
+TEST_CASE("extract_archive reports digests of extracted files", "[integration][digest]") {
+    const auto first = patterned(200000);
+    const auto second = bytes_of("second file");
+    const auto archive = sample_archive(first, second);
+
+    const auto dest = std::filesystem::temp_directory_path() /
+                      ("tierone_digest_test_" + std::to_string(std::random_device{}() % 100000));
+    archive_reader reader{std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive})};
+
+    std::map<std::string, entry_digests> reported;
+    extract_options options;
+    options.threads = 2;
+    options.max_queued_bytes = 100000;  // First file is streamed, second queued
+    options.digests = {.sha256 = true, .xxh64 = true};
+    options.on_digests = [&](const archive_entry& entry, const entry_digests& digests) {
+        reported.emplace(entry.path().string(), digests);
+    };
+    const auto result = extract_archive(reader, dest, options);
+    std::error_code ec;
+    std::filesystem::remove_all(dest, ec);
+    REQUIRE(result.has_value());
+
+    REQUIRE(reported.size() == 2);
+    CHECK(reported["first.bin"].sha256 == digests_of(first).sha256);
+    CHECK(reported["first.bin"].xxh64 == digests_of(first).xxh64);
+    CHECK(reported["dir/second.bin"].xxh64 == digests_of(second).xxh64);
+}
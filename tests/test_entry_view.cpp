@@ -0,0 +1,507 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <tierone/tar/tar.hpp>
+#include <tierone/tar/entry_view.hpp>
+#include <cstdio>
+#include <cstring>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+using namespace tierone::tar;
+
+namespace {
+
+// Builds a ustar archive in memory
+class tar_builder {
+    std::vector<std::byte> data_;
+
+    void add_header(const std::string& name, char type, size_t size, const char* magic = "ustar") {
+        std::array<char, 512> header{};
+        std::memcpy(header.data(), name.data(), std::min<size_t>(name.size(), 100));
+        std::snprintf(header.data() + 100, 8, "%07o", 0644u);
+        std::snprintf(header.data() + 108, 8, "%07o", 1000u);
+        std::snprintf(header.data() + 116, 8, "%07o", 1000u);
+        std::snprintf(header.data() + 124, 12, "%011zo", size);
+        std::snprintf(header.data() + 136, 12, "%011o", 1700000000u);
+        header[156] = type;
+        std::memcpy(header.data() + 257, magic, std::strlen(magic) + 1);
+        header[263] = '0';
+        header[264] = '0';
+
+        std::memset(header.data() + 148, ' ', 8);
+        unsigned checksum = 0;
+        for (char c : header) {
+            checksum += static_cast<unsigned char>(c);
+        }
+        std::snprintf(header.data() + 148, 8, "%06o", checksum);
+
+        for (char c : header) {
+            data_.push_back(static_cast<std::byte>(c));
+        }
+    }
+
+    void add_data(const std::string& content) {
+        for (char c : content) {
+            data_.push_back(static_cast<std::byte>(c));
+        }
+        data_.resize((data_.size() + 511) / 512 * 512);
+    }
+
+public:
+    size_t offset() const { return data_.size(); }
+
+    tar_builder& file(const std::string& name, const std::string& content) {
+        add_header(name, '0', content.size());
+        add_data(content);
+        return *this;
+    }
+
+    tar_builder& entry(const std::string& name, char type, const std::string& content = "") {
+        add_header(name, type, content.size());
+        add_data(content);
+        return *this;
+    }
+
+    tar_builder& longname(const std::string& name) {
+        add_header("././@LongLink", 'L', name.size() + 1);
+        add_data(name + '\0');
+        return *this;
+    }
+
+    tar_builder& pax_path(const std::string& path) {
+        std::string record = " path=" + path + "\n";
+        size_t length = record.size() + 2;
+        if (std::to_string(length).size() + record.size() != length) ++length;
+        record = std::to_string(length) + record;
+        add_header("PaxHeader", 'x', record.size());
+        add_data(record);
+        return *this;
+    }
+
+    tar_builder& pax_global(const std::string& key, const std::string& value) {
+        std::string record = " " + key + "=" + value + "\n";
+        size_t length = record.size() + 2;
+        if (std::to_string(length).size() + record.size() != length) ++length;
+        record = std::to_string(length) + record;
+        add_header("pax_global_header", 'g', record.size());
+        add_data(record);
+        return *this;
+    }
+
+    std::vector<std::byte> finish() {
+        data_.resize(data_.size() + 1024);
+        return data_;
+    }
+};
+
+std::string to_string(std::span<const std::byte> bytes) {
+    return std::string(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
+
+} // anonymous namespace
+
+TEST_CASE("entry_view decodes header fields", "[unit][entry_view]") {
+    auto archive = tar_builder{}.file("dir/file.txt", "hello").finish();
+    auto block = std::span<const std::byte, 512>{archive.data(), 512};
+
+    auto view = entry_view::parse(block);
+    REQUIRE(view.has_value());
+    CHECK(view->path() == "dir/file.txt");
+    CHECK(view->type() == entry_type::regular_file);
+    CHECK(view->size().value() == 5);
+    CHECK(view->permissions().value() == std::filesystem::perms{0644});
+    CHECK(view->owner_id().value() == 1000);
+    CHECK(view->group_id().value() == 1000);
+    CHECK(view->modification_time().value() == std::chrono::system_clock::from_time_t(1700000000));
+    CHECK_FALSE(view->link_target().has_value());
+    CHECK_FALSE(view->is_sparse());
+
+    auto metadata = view->to_metadata();
+    REQUIRE(metadata.has_value());
+    CHECK(metadata->path == "dir/file.txt");
+    CHECK(metadata->size == 5);
+
+    SECTION("Corrupt checksums are rejected") {
+        auto corrupt = archive;
+        corrupt[10] = std::byte{'X'};
+        auto bad = entry_view::parse(std::span<const std::byte, 512>{corrupt.data(), 512});
+        REQUIRE_FALSE(bad.has_value());
+        CHECK(bad.error().code() == error_code::corrupt_archive);
+    }
+}
+
+TEST_CASE("next_entry_view matches next_entry", "[unit][entry_view]") {
+    const std::string long_name = "deep/" + std::string(150, 'n');
+    tar_builder builder;
+    builder.file("a.txt", "alpha");
+    builder.longname(long_name);
+    builder.file("truncated", "long");
+    builder.pax_path("pax/path.txt");
+    builder.file("ignored", "pax");
+    builder.file("z.txt", "zulu");
+    auto archive = builder.finish();
+
+    auto entries = open_archive(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive}));
+    REQUIRE(entries.has_value());
+    auto views = open_archive(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive}));
+    REQUIRE(views.has_value());
+
+    size_t count = 0;
+    while (true) {
+        auto entry = entries->next_entry();
+        auto view = views->next_entry_view();
+        REQUIRE(entry.has_value());
+        REQUIRE(view.has_value());
+        REQUIRE(entry->has_value() == view->has_value());
+        if (!*entry) break;
+
+        CHECK((*view)->path() == (*entry)->path().string());
+        CHECK((*view)->size().value() == (*entry)->size());
+        CHECK(views->current_location()->data_offset == entries->current_location()->data_offset);
+        CHECK(views->current_location()->header_offset == entries->current_location()->header_offset);
+        ++count;
+    }
+    CHECK(count == 4);
+}
+
+TEST_CASE("next_entry_view and next_entry interleave", "[unit][entry_view]") {
+    auto archive = tar_builder{}
+        .longname(std::string(120, 'l'))
+        .file("short", "one")
+        .file("b.txt", "two")
+        .finish();
+    auto reader = open_archive(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive}));
+    REQUIRE(reader.has_value());
+
+    auto view = reader->next_entry_view();
+    REQUIRE(view.has_value());
+    REQUIRE(view->has_value());
+    CHECK((*view)->path() == std::string(120, 'l'));
+
+    // The longname applied to the view must not leak into the next entry
+    auto entry = reader->next_entry();
+    REQUIRE(entry.has_value());
+    REQUIRE(entry->has_value());
+    CHECK((*entry)->path() == "b.txt");
+    auto data = (*entry)->read_data();
+    REQUIRE(data.has_value());
+    CHECK(to_string(*data) == "two");
+}
+
+TEST_CASE("glob_match follows shell rules", "[unit][entry_view][filter]") {
+    CHECK(glob_match("*.log", "app.log"));
+    CHECK_FALSE(glob_match("*.log", "var/app.log"));
+    CHECK(glob_match("var/*/app.log", "var/x/app.log"));
+    CHECK(glob_match("**/*.log", "var/log/app.log"));
+    CHECK(glob_match("**/*.log", "app.log"));
+    CHECK(glob_match("a/**/b", "a/b"));
+    CHECK(glob_match("a/**/b", "a/x/y/b"));
+    CHECK(glob_match("a/**", "a/x/y"));
+    CHECK(glob_match("file?.txt", "file1.txt"));
+    CHECK_FALSE(glob_match("file?.txt", "file/.txt"));
+    CHECK(glob_match("[a-c]x", "bx"));
+    CHECK_FALSE(glob_match("[!a-c]x", "bx"));
+    CHECK(glob_match("[]]", "]"));
+    CHECK(glob_match("\\*", "*"));
+    CHECK_FALSE(glob_match("\\*", "x"));
+    CHECK(glob_match("[x", "[x"));
+    CHECK_FALSE(glob_match("abc", "abcd"));
+}
+
+TEST_CASE("path_filter combines globs and prefixes", "[unit][entry_view][filter]") {
+    path_filter filter{"**/*.conf"};
+    filter.add_prefix("usr/share/doc/");
+
+    CHECK(filter.matches("etc/app/main.conf"));
+    CHECK(filter.matches("./etc/app/main.conf"));
+    CHECK(filter.matches("usr/share/doc/README"));
+    CHECK_FALSE(filter.matches("usr/share/man/app.1"));
+    CHECK_FALSE(filter.matches("etc/app/main.conf.bak"));
+    CHECK(path_filter{}.matches("anything"));
+}
+
+TEST_CASE("next_entry with a filter skips other members", "[unit][entry_view][filter]") {
+    const std::string long_name = "logs/" + std::string(150, 'n') + ".log";
+    tar_builder builder;
+    builder.file("a.txt", "alpha");
+    builder.longname(long_name);
+    builder.file("truncated", "long");
+    builder.pax_path("logs/pax.log");
+    builder.file("ignored", "pax");
+    builder.file("logs/skip.txt", "no");
+    builder.file("z.log", "zulu");
+    auto archive = builder.finish();
+
+    auto check = [&](archive_reader& reader) {
+        std::vector<std::string> paths;
+        std::vector<std::string> contents;
+        while (true) {
+            auto entry = reader.next_entry(path_filter{"**/*.log"});
+            REQUIRE(entry.has_value());
+            if (!*entry) break;
+            paths.push_back((*entry)->path().string());
+            auto data = (*entry)->read_data();
+            REQUIRE(data.has_value());
+            contents.push_back(to_string(*data));
+        }
+        CHECK(paths == std::vector<std::string>{long_name, "logs/pax.log", "z.log"});
+        CHECK(contents == std::vector<std::string>{"long", "pax", "zulu"});
+    };
+
+    SECTION("Mapped") {
+        auto reader = open_archive(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive}));
+        REQUIRE(reader.has_value());
+        check(*reader);
+        CHECK(reader->finished());
+    }
+
+    SECTION("Streaming") {
+        auto reader = open_archive(std::make_unique<read_ahead_stream>(
+            std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive}), 1024));
+        REQUIRE(reader.has_value());
+        check(*reader);
+    }
+
+    SECTION("Predicate over the view") {
+        auto reader = open_archive(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive}));
+        REQUIRE(reader.has_value());
+        auto entry = reader->next_entry([](const entry_view& view) { return view.size().value_or(0) == 2; });
+        REQUIRE(entry.has_value());
+        REQUIRE(entry->has_value());
+        CHECK((*entry)->path() == "logs/skip.txt");
+        CHECK(reader->current_location()->header_offset == 10 * 512);
+
+        // Unfiltered iteration picks up after the filtered entry
+        auto next = reader->next_entry();
+        REQUIRE(next.has_value());
+        REQUIRE(next->has_value());
+        CHECK((*next)->path() == "z.log");
+    }
+}
+
+TEST_CASE("PAX global headers apply to following entries", "[unit][entry_view][pax_global]") {
+    auto archive = tar_builder{}
+        .file("before", "0")
+        .pax_global("comment", "4b825dc642cb6eb9a060e54bf8d69288fbee4904")
+        .pax_global("uname", "builder")
+        .file("first", "1")
+        .pax_path("renamed")  // Per-entry records still apply on top
+        .file("second", "2")
+        .pax_global("uname", "")  // An empty value drops the key
+        .file("third", "3")
+        .finish();
+
+    SECTION("next_entry") {
+        auto reader = open_archive(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive}));
+        REQUIRE(reader.has_value());
+        std::vector<std::pair<std::string, std::string>> seen;
+        while (true) {
+            auto entry = reader->next_entry();
+            REQUIRE(entry.has_value());
+            if (!*entry) break;
+            seen.emplace_back((*entry)->path().string(), (*entry)->metadata().owner_name);
+        }
+        CHECK(seen == std::vector<std::pair<std::string, std::string>>{
+            {"before", ""}, {"first", "builder"}, {"renamed", "builder"}, {"third", ""}});
+        CHECK(reader->global_pax_headers().find("comment") == "4b825dc642cb6eb9a060e54bf8d69288fbee4904");
+        CHECK_FALSE(reader->global_pax_headers().find("uname").has_value());
+    }
+
+    SECTION("next_entry_view") {
+        auto reader = open_archive(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive}));
+        REQUIRE(reader.has_value());
+        REQUIRE(reader->next_entry_view().has_value());
+        auto view = reader->next_entry_view();
+        REQUIRE(view.has_value());
+        REQUIRE(view->has_value());
+        CHECK((*view)->path() == "first");
+        auto metadata = (*view)->to_metadata();
+        REQUIRE(metadata.has_value());
+        CHECK(metadata->owner_name == "builder");
+    }
+}
+
+TEST_CASE("archive_reader reset starts over on another archive", "[unit][entry_view][reset]") {
+    const auto first = tar_builder{}
+        .pax_global("uname", "builder")
+        .file("a", "1")
+        .pax_path("long/renamed/path")
+        .file("b", "22")
+        .finish();
+    const auto second = tar_builder{}
+        .file("c", "333")
+        .file("d", "4444")
+        .finish();
+
+    auto reader = open_archive(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{first}));
+    REQUIRE(reader.has_value());
+
+    // Leave the first archive mid-way, with a PAX header pending for "b"
+    auto entry = reader->next_entry();
+    REQUIRE(entry.has_value());
+    REQUIRE(entry->has_value());
+    CHECK((*entry)->metadata().owner_name == "builder");
+
+    // The previous stream comes back and can be pointed at the next archive
+    auto stream = reader->reset(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{second}));
+    REQUIRE(stream != nullptr);
+    std::vector<std::string> paths;
+    for (int pass = 0; pass < 2; ++pass) {
+        paths.clear();
+        while (true) {
+            auto next = reader->next_entry();
+            REQUIRE(next.has_value());
+            if (!*next) break;
+            paths.push_back((*next)->path().string());
+            CHECK((*next)->metadata().owner_name.empty());
+        }
+        CHECK(paths == std::vector<std::string>{"c", "d"});
+        CHECK(reader->finished());
+        CHECK(reader->global_pax_headers().empty());
+
+        static_cast<memory_mapped_stream&>(*stream) = memory_mapped_stream{std::span<const std::byte>{second}};
+        stream = reader->reset(std::move(stream));
+    }
+}
+
+TEST_CASE("list_entries allocates from the given resource", "[unit][entry_view][listing]") {
+    const std::string long_name = "deep/" + std::string(150, 'n');
+    const auto archive = tar_builder{}
+        .file("a.txt", "alpha")
+        .pax_global("uname", "release-builder-account")
+        .longname(long_name)
+        .file("truncated", "long")
+        .pax_path("pax/" + std::string(40, 'p'))
+        .file("ignored", "pax")
+        .finish();
+
+    // Anything past the buffer would go to the null resource and throw
+    std::array<std::byte, 8192> buffer{};
+    std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size(), std::pmr::null_memory_resource()};
+
+    auto reader = open_archive(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive}));
+    REQUIRE(reader.has_value());
+    auto listing = list_entries(*reader, &arena);
+    REQUIRE(listing.has_value());
+    REQUIRE(listing->size() == 3);
+
+    CHECK((*listing)[0].path == "a.txt");
+    CHECK((*listing)[0].size == 5);
+    CHECK((*listing)[0].owner_name.empty());
+    CHECK((*listing)[0].permissions == std::filesystem::perms{0644});
+    CHECK(std::string_view{(*listing)[1].path} == long_name);
+    CHECK((*listing)[1].owner_name == "release-builder-account");
+    CHECK(std::string_view{(*listing)[2].path} == "pax/" + std::string(40, 'p'));
+    CHECK((*listing)[2].modification_time == std::chrono::system_clock::from_time_t(1700000000));
+    for (const auto& entry : *listing) {
+        CHECK(entry.get_allocator().resource() == &arena);
+    }
+}
+
+TEST_CASE("summarize totals members by type, prefix and size", "[unit][entry_view][listing]") {
+    const std::string long_name = "usr/share/" + std::string(120, 'd');
+    const auto archive = tar_builder{}
+        .entry("./usr/", '5')
+        .file("usr/bin/ls", std::string(300, 'l'))
+        .file("usr/bin/cat", std::string(100, 'c'))
+        .entry("usr/bin/sh", '2')
+        .entry("usr/bin/list", '1')
+        .file("usr/lib/libc.so", std::string(500, 's'))
+        .longname(long_name)
+        .file("truncated", std::string(200, 'd'))
+        .file("etc/passwd", std::string(50, 'p'))
+        .entry("run/pipe", '6')
+        .file("README", std::string(10, 'r'))
+        .finish();
+
+    auto reader = open_archive(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive}));
+    REQUIRE(reader.has_value());
+    auto summary = summarize(*reader, {.prefix_depth = 2, .largest = 3});
+    REQUIRE(summary.has_value());
+
+    CHECK(summary->total.count == 10);
+    CHECK(summary->total.bytes == 1160);
+    CHECK(summary->stored_bytes == 1160);
+    CHECK(summary->regular_files.count == 6);
+    CHECK(summary->regular_files.bytes == 1160);
+    CHECK(summary->directories.count == 1);
+    CHECK(summary->symbolic_links.count == 1);
+    CHECK(summary->hard_links.count == 1);
+    CHECK(summary->fifos.count == 1);
+    CHECK(summary->other.count == 0);
+
+    // "./usr/" and README sit at the top level
+    REQUIRE(summary->prefixes.size() == 6);
+    CHECK(summary->prefixes.at("").count == 2);
+    CHECK(summary->prefixes.at("usr/bin").count == 4);
+    CHECK(summary->prefixes.at("usr/bin").bytes == 400);
+    CHECK(summary->prefixes.at("usr/lib").bytes == 500);
+    CHECK(summary->prefixes.at("usr/share").bytes == 200);
+    CHECK(summary->prefixes.at("etc").count == 1);
+    CHECK(summary->prefixes.at("run").count == 1);
+
+    REQUIRE(summary->largest.size() == 3);
+    CHECK(summary->largest[0].path == "usr/lib/libc.so");
+    CHECK(summary->largest[0].number == 5);
+    CHECK(summary->largest[1].path == "usr/bin/ls");
+    CHECK(std::string_view{summary->largest[2].path} == long_name);
+    CHECK(summary->largest[2].size == 200);
+}
+
+TEST_CASE("summarize does not allocate per member", "[unit][entry_view][listing]") {
+    // Growing sizes, so every file displaces one of the largest
+    tar_builder builder;
+    for (int i = 0; i < 1000; ++i) {
+        char name[64];
+        std::snprintf(name, sizeof(name), "%s/member-%06d.bin", i % 2 ? "odd" : "even", i);
+        builder.file(name, std::string(static_cast<size_t>(i), 'x'));
+    }
+    const auto archive = builder.finish();
+
+    // Anything past the buffer would go to the null resource and throw
+    std::array<std::byte, 4096> buffer{};
+    std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size(), std::pmr::null_memory_resource()};
+
+    auto reader = open_archive(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive}));
+    REQUIRE(reader.has_value());
+    auto summary = summarize(*reader, {.prefix_depth = 1, .largest = 4}, &arena);
+    REQUIRE(summary.has_value());
+    CHECK(summary->total.count == 1000);
+    CHECK(summary->prefixes.at("odd").count == 500);
+    REQUIRE(summary->largest.size() == 4);
+    CHECK(summary->largest[0].path == "odd/member-000999.bin");
+    CHECK(summary->largest[3].size == 996);
+}
+
+TEST_CASE("next_entry walks long chains of extension headers", "[unit][entry_view]") {
+    tar_builder builder;
+    for (int i = 0; i < 20000; ++i) {
+        builder.pax_path("chain/" + std::to_string(i));
+    }
+    builder.file("short", "x");
+    const auto archive = builder.finish();
+
+    auto reader = open_archive(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive}));
+    REQUIRE(reader.has_value());
+    auto entry = reader->next_entry();
+    REQUIRE(entry.has_value());
+    REQUIRE(entry->has_value());
+    CHECK((*entry)->path() == "chain/19999");
+    CHECK((*entry)->read_data().value().size() == 1);
+}
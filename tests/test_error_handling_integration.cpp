@@ -583,4 +583,29 @@ TEST_CASE("Error message quality", "[integration][error_handling]") {
             }
         }
     }
-}
\ No newline at end of file
+}
+TEST_CASE("Errors format their fields on demand", "[unit][error_handling]") {
+    SECTION("Static context with errno and offset") {
+        const auto failure = error{error_code::io_error, "File read error", ENOENT}.at_offset(1536);
+        CHECK(std::strcmp(failure.context(), "File read error") == 0);
+        CHECK(failure.system_errno() == ENOENT);
+        CHECK(failure.offset() == uint64_t{1536});
+        CHECK(failure.message() == "File read error: " + std::generic_category().message(ENOENT) + " at offset 1536");
+    }
+
+    SECTION("Formatted message") {
+        const error failure{error_code::corrupt_archive, std::string{"Bad entry "} + "x"};
+        CHECK(failure.context() == nullptr);
+        CHECK(failure.system_errno() == 0);
+        CHECK_FALSE(failure.offset().has_value());
+        CHECK(failure.message() == "Bad entry x");
+    }
+
+    SECTION("Rejecting a block that is not tar needs no string") {
+        std::array<std::byte, 512> block{};
+        block[0] = std::byte{'x'};
+        auto result = detail::parse_header(block);
+        REQUIRE_FALSE(result.has_value());
+        CHECK(result.error().context() != nullptr);
+    }
+}
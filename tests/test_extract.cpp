@@ -0,0 +1,522 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+#include <tierone/tar/tar.hpp>
+#include <tierone/tar/extract.hpp>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include <unistd.h>
+
+using namespace tierone::tar;
+namespace fs = std::filesystem;
+
+namespace {
+
+class TempDirectory {
+    fs::path path_;
+public:
+    TempDirectory() {
+        std::random_device rd;
+        std::mt19937 gen(rd());
+        std::uniform_int_distribution<> dis(1000, 9999);
+
+        auto temp = fs::temp_directory_path();
+        path_ = temp / ("tierone_extract_test_" + std::to_string(dis(gen)));
+        fs::create_directories(path_);
+    }
+
+    ~TempDirectory() {
+        std::error_code ec;
+        fs::permissions(path_, fs::perms::owner_all, fs::perm_options::add, ec);
+        fs::remove_all(path_, ec);
+    }
+
+    const fs::path& path() const { return path_; }
+};
+
+// Builds a ustar archive in memory
+class tar_builder {
+    std::vector<std::byte> data_;
+
+    void add_header(const std::string& name, char type, size_t size,
+                    const std::string& link = {}, unsigned mode = 0644) {
+        std::array<char, 512> header{};
+        std::memcpy(header.data(), name.data(), std::min<size_t>(name.size(), 100));
+        std::snprintf(header.data() + 100, 8, "%07o", mode);
+        std::snprintf(header.data() + 108, 8, "%07o", 1000u);
+        std::snprintf(header.data() + 116, 8, "%07o", 1000u);
+        std::snprintf(header.data() + 124, 12, "%011zo", size);
+        std::snprintf(header.data() + 136, 12, "%011o", 1700000000u);
+        header[156] = type;
+        std::memcpy(header.data() + 157, link.data(), std::min<size_t>(link.size(), 100));
+        std::memcpy(header.data() + 257, "ustar", 6);
+        header[263] = '0';
+        header[264] = '0';
+
+        std::memset(header.data() + 148, ' ', 8);
+        unsigned checksum = 0;
+        for (char c : header) {
+            checksum += static_cast<unsigned char>(c);
+        }
+        std::snprintf(header.data() + 148, 8, "%06o", checksum);
+
+        for (char c : header) {
+            data_.push_back(static_cast<std::byte>(c));
+        }
+    }
+
+public:
+    tar_builder& file(const std::string& name, const std::string& content, unsigned mode = 0644,
+                      char type = '0') {
+        add_header(name, type, content.size(), {}, mode);
+        for (char c : content) {
+            data_.push_back(static_cast<std::byte>(c));
+        }
+        data_.resize((data_.size() + 511) / 512 * 512);
+        return *this;
+    }
+
+    tar_builder& directory(const std::string& name, unsigned mode = 0755) {
+        add_header(name, '5', 0, {}, mode);
+        return *this;
+    }
+
+    tar_builder& symlink(const std::string& name, const std::string& target) {
+        add_header(name, '2', 0, target, 0777);
+        return *this;
+    }
+
+    tar_builder& hardlink(const std::string& name, const std::string& target) {
+        add_header(name, '1', 0, target);
+        return *this;
+    }
+
+    std::vector<std::byte> finish() {
+        data_.resize(data_.size() + 1024);
+        return data_;
+    }
+};
+
+std::string read_file_content(const fs::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::string(std::istreambuf_iterator<char>(file),
+                      std::istreambuf_iterator<char>());
+}
+
+archive_reader open_memory_archive(const std::vector<std::byte>& data) {
+    auto reader = open_archive(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{data}));
+    REQUIRE(reader.has_value());
+    return std::move(*reader);
+}
+
+} // anonymous namespace
+
+TEST_CASE("extract_archive writes a full tree", "[integration][extract]") {
+    TempDirectory temp_dir;
+    auto archive = tar_builder{}
+        .directory("root/")
+        .directory("root/sub/")
+        .file("root/a.txt", "alpha")
+        .file("root/sub/b.txt", "bravo", 0600)
+        .symlink("root/link", "a.txt")
+        .hardlink("root/sub/hard", "root/a.txt")
+        .directory("root/readonly/", 0555)
+        .file("root/readonly/c.txt", "charlie")
+        .finish();
+
+    SECTION("Multiple workers") {
+        auto reader = open_memory_archive(archive);
+        auto result = extract_archive(reader, temp_dir.path(), {.threads = 4});
+        REQUIRE(result.has_value());
+
+        const auto root = temp_dir.path() / "root";
+        CHECK(read_file_content(root / "a.txt") == "alpha");
+        CHECK(read_file_content(root / "sub" / "b.txt") == "bravo");
+        CHECK(read_file_content(root / "readonly" / "c.txt") == "charlie");
+        CHECK(fs::is_symlink(root / "link"));
+        CHECK(fs::read_symlink(root / "link") == "a.txt");
+        CHECK(fs::equivalent(root / "sub" / "hard", root / "a.txt"));
+        CHECK((fs::status(root / "sub" / "b.txt").permissions() & fs::perms::all) == fs::perms{0600});
+        CHECK((fs::status(root / "readonly").permissions() & fs::perms::all) == fs::perms{0555});
+    }
+
+    SECTION("Single worker with a tiny queue") {
+        auto reader = open_memory_archive(archive);
+        auto result = extract_archive(reader, temp_dir.path(), {.threads = 1, .max_queued_bytes = 2});
+        REQUIRE(result.has_value());
+
+        CHECK(read_file_content(temp_dir.path() / "root" / "a.txt") == "alpha");
+        CHECK(read_file_content(temp_dir.path() / "root" / "sub" / "b.txt") == "bravo");
+    }
+}
+
+TEST_CASE("extract_archive handles many small files", "[integration][extract]") {
+    TempDirectory temp_dir;
+    tar_builder builder;
+    for (int d = 0; d < 8; ++d) {
+        builder.directory("tree/d" + std::to_string(d) + "/");
+        for (int f = 0; f < 32; ++f) {
+            builder.file("tree/d" + std::to_string(d) + "/f" + std::to_string(f),
+                         "content " + std::to_string(d * 100 + f));
+        }
+    }
+    auto archive = builder.finish();
+    auto reader = open_memory_archive(archive);
+
+    auto result = extract_archive(reader, temp_dir.path(), {.threads = 8});
+    REQUIRE(result.has_value());
+
+    for (int d = 0; d < 8; ++d) {
+        for (int f = 0; f < 32; ++f) {
+            auto path = temp_dir.path() / "tree" / ("d" + std::to_string(d)) / ("f" + std::to_string(f));
+            CHECK(read_file_content(path) == "content " + std::to_string(d * 100 + f));
+        }
+    }
+}
+
+TEST_CASE("extract_archive writes contiguous files as regular files", "[integration][extract]") {
+    TempDirectory temp_dir;
+    const std::string large(4096, 'C');
+    auto archive = tar_builder{}
+        .file("small.dat", "contiguous", 0640, '7')
+        .file("large.dat", large, 0644, '7')
+        .finish();
+
+    auto reader = open_memory_archive(archive);
+    // The large member is streamed by the scanner, the small one goes to a worker
+    REQUIRE(extract_archive(reader, temp_dir.path(), {.threads = 2, .max_queued_bytes = 1024}).has_value());
+    CHECK(read_file_content(temp_dir.path() / "small.dat") == "contiguous");
+    CHECK(read_file_content(temp_dir.path() / "large.dat") == large);
+    CHECK((fs::status(temp_dir.path() / "small.dat").permissions() & fs::perms::all) == fs::perms{0640});
+}
+
+TEST_CASE("extract_archive keeps the last member stored at a path", "[integration][extract]") {
+    TempDirectory temp_dir;
+
+    SECTION("Large members followed by small ones") {
+        // The large copy takes longest to write, so it would finish last if unordered
+        const std::string large(256 * 1024, 'L');
+        tar_builder builder;
+        for (int i = 0; i < 100; ++i) {
+            builder.file("f" + std::to_string(i), large);
+        }
+        for (int i = 0; i < 100; ++i) {
+            builder.file("f" + std::to_string(i), "small " + std::to_string(i));
+        }
+        auto archive = builder.finish();
+        for (int round = 0; round < 3; ++round) {
+            const auto out = temp_dir.path() / ("out" + std::to_string(round));
+            auto reader = open_memory_archive(archive);
+            REQUIRE(extract_archive(reader, out, {.threads = 8}).has_value());
+            for (int i = 0; i < 100; ++i) {
+                CHECK(read_file_content(out / ("f" + std::to_string(i))) == "small " + std::to_string(i));
+            }
+        }
+    }
+
+    SECTION("Links replaced by later members") {
+        auto archive = tar_builder{}
+            .file("source", "source")
+            .hardlink("hard", "source")
+            .file("hard", "replaced")
+            .symlink("soft", "source")
+            .file("soft", "replaced too")
+            .file("later", "first")
+            .hardlink("later", "source")
+            .finish();
+        auto reader = open_memory_archive(archive);
+        REQUIRE(extract_archive(reader, temp_dir.path(), {.threads = 4}).has_value());
+        // A member written over a hard link leaves its source alone
+        CHECK(read_file_content(temp_dir.path() / "source") == "source");
+        CHECK(read_file_content(temp_dir.path() / "hard") == "replaced");
+        CHECK_FALSE(fs::equivalent(temp_dir.path() / "hard", temp_dir.path() / "source"));
+        CHECK_FALSE(fs::is_symlink(temp_dir.path() / "soft"));
+        CHECK(read_file_content(temp_dir.path() / "soft") == "replaced too");
+        CHECK(fs::equivalent(temp_dir.path() / "later", temp_dir.path() / "source"));
+    }
+}
+
+TEST_CASE("extract_archive rejects unsafe paths", "[integration][extract]") {
+    TempDirectory temp_dir;
+    auto archive = tar_builder{}
+        .file("ok.txt", "fine")
+        .file("../escape.txt", "nope")
+        .finish();
+    auto reader = open_memory_archive(archive);
+
+    auto result = extract_archive(reader, temp_dir.path() / "dest", {.threads = 2});
+    REQUIRE_FALSE(result.has_value());
+    CHECK(result.error().code() == error_code::invalid_operation);
+    CHECK_THAT(result.error().message(), Catch::Matchers::ContainsSubstring("outside destination"));
+    CHECK_FALSE(fs::exists(temp_dir.path() / "escape.txt"));
+}
+
+TEST_CASE("extract_archive never writes through an extracted symlink", "[integration][extract]") {
+    TempDirectory temp_dir;
+    const auto outside = temp_dir.path() / "outside";
+    fs::create_directories(outside);
+    auto archive = tar_builder{}
+        .symlink("link", outside.string())
+        .file("link/planted.txt", "nope")
+        .finish();
+    auto reader = open_memory_archive(archive);
+
+    auto result = extract_archive(reader, temp_dir.path() / "dest", {.threads = 1});
+    REQUIRE_FALSE(result.has_value());
+    CHECK(result.error().code() == error_code::io_error);
+    CHECK(fs::is_symlink(temp_dir.path() / "dest" / "link"));
+    CHECK_FALSE(fs::exists(outside / "planted.txt"));
+}
+
+TEST_CASE("extract_context extracts entries one by one", "[integration][extract]") {
+    TempDirectory temp_dir;
+    auto archive = tar_builder{}
+        .file("a/b/c/d/deep.txt", "deep")
+        .file("/a/b/c/d/./sibling.txt", "sibling", 0640)
+        .directory("a/b/", 0700)
+        .symlink("a/link", "b/c/d/deep.txt")
+        .hardlink("a/hard", "a/b/c/d/deep.txt")
+        .finish();
+    auto reader = open_memory_archive(archive);
+
+    auto context = extract_context::open(temp_dir.path());
+    REQUIRE(context.has_value());
+    for (const auto& entry : reader) {
+        REQUIRE(context->extract(entry).has_value());
+    }
+    REQUIRE(context->finish().has_value());
+
+    const auto deep = temp_dir.path() / "a" / "b" / "c" / "d";
+    CHECK(read_file_content(deep / "deep.txt") == "deep");
+    CHECK(read_file_content(deep / "sibling.txt") == "sibling");
+    CHECK((fs::status(deep / "sibling.txt").permissions() & fs::perms::all) == fs::perms{0640});
+    CHECK((fs::status(temp_dir.path() / "a" / "b").permissions() & fs::perms::all) == fs::perms{0700});
+    CHECK(read_file_content(temp_dir.path() / "a" / "link") == "deep");
+    CHECK(fs::equivalent(temp_dir.path() / "a" / "hard", deep / "deep.txt"));
+
+    // Writing again replaces the file, even where a symlink now stands
+    REQUIRE(context->create_symlink("a/replaced", "b/c/d/deep.txt").has_value());
+    const std::string text = "new";
+    REQUIRE(context->write_file("a/replaced", fs::perms{0644}, std::as_bytes(std::span{text})).has_value());
+    CHECK_FALSE(fs::is_symlink(temp_dir.path() / "a" / "replaced"));
+    CHECK(read_file_content(deep / "deep.txt") == "deep");
+}
+
+TEST_CASE("extract_archive restores times, owners and xattrs", "[integration][extract]") {
+    TempDirectory temp_dir;
+    using namespace std::chrono;
+    const auto dir_time = system_clock::time_point{seconds{1500000000}};
+    const auto file_time = system_clock::time_point{seconds{1600000000}};
+
+    std::vector<std::byte> archive;
+    archive_writer writer{std::make_unique<memory_output_stream>(archive)};
+    file_metadata dir;
+    dir.path = "tree";
+    dir.type = entry_type::directory;
+    dir.permissions = fs::perms{0755};
+    dir.modification_time = dir_time;
+    dir.owner_id = dir.group_id = 1234;
+    REQUIRE(writer.add_entry(dir).has_value());
+
+    file_metadata file;
+    file.path = "tree/file.txt";
+    file.type = entry_type::regular_file;
+    file.permissions = fs::perms{0444};
+    file.modification_time = file_time;
+    file.owner_id = file.group_id = 1234;
+    file.size = 4;
+    file.xattrs["user.origin"] = "tar";
+    const std::string content = "data";
+    REQUIRE(writer.add_entry(file, std::as_bytes(std::span{content})).has_value());
+
+    file_metadata link = file;
+    link.path = "tree/link";
+    link.type = entry_type::symbolic_link;
+    link.link_target = "file.txt";
+    link.size = 0;
+    link.xattrs.clear();
+    REQUIRE(writer.add_entry(link).has_value());
+    REQUIRE(writer.finish().has_value());
+
+    const auto mtime_of = [](const fs::path& path) {
+        struct stat st{};
+        REQUIRE(::lstat(path.c_str(), &st) == 0);
+        return st.st_mtim.tv_sec;
+    };
+
+    SECTION("metadata is restored, directories after their contents") {
+        auto reader = open_memory_archive(archive);
+        REQUIRE(extract_archive(reader, temp_dir.path(), {.threads = 2}).has_value());
+
+        const auto tree = temp_dir.path() / "tree";
+        CHECK(read_file_content(tree / "file.txt") == "data");
+        CHECK((fs::status(tree / "file.txt").permissions() & fs::perms::all) == fs::perms{0444});
+        CHECK(mtime_of(tree / "file.txt") == 1600000000);
+        CHECK(mtime_of(tree / "link") == 1600000000);
+        CHECK(mtime_of(tree) == 1500000000);
+
+        if (::geteuid() == 0) {
+            struct stat st{};
+            REQUIRE(::stat((tree / "file.txt").c_str(), &st) == 0);
+            CHECK(st.st_uid == 1234);
+            CHECK(st.st_gid == 1234);
+        }
+
+        // Only where the filesystem takes user xattrs at all
+        char value[16]{};
+        const auto size = ::getxattr((tree / "file.txt").c_str(), "user.origin", value, sizeof(value));
+        if (size >= 0 || errno != ENOTSUP) {
+            CHECK(std::string(value, static_cast<size_t>(std::max<ssize_t>(size, 0))) == "tar");
+        }
+    }
+
+    SECTION("options leave metadata alone") {
+        auto reader = open_memory_archive(archive);
+        const extract_options options{.threads = 1, .preserve_times = false, .preserve_owner = false,
+                                      .preserve_xattrs = false};
+        REQUIRE(extract_archive(reader, temp_dir.path(), options).has_value());
+        CHECK(mtime_of(temp_dir.path() / "tree" / "file.txt") > 1600000000);
+        CHECK(::getxattr((temp_dir.path() / "tree" / "file.txt").c_str(), "user.origin", nullptr, 0) < 0);
+    }
+}
+
+TEST_CASE("extract_archive writes large files behind the page cache", "[integration][extract]") {
+    TempDirectory temp_dir;
+    // Several write-behind windows and a partial one; the small file goes
+    // through the workers, the large one is streamed by the scanner
+    std::string large(2 * 8 * 1024 * 1024 + 12345, '\0');
+    for (size_t i = 0; i < large.size(); ++i) {
+        large[i] = static_cast<char>('a' + (i * 7 + i / 4096) % 26);
+    }
+    const std::string small = large.substr(0, 3 * 1024 * 1024);
+    auto archive = tar_builder{}
+        .file("large.bin", large)
+        .file("small.bin", small)
+        .finish();
+    auto reader = open_memory_archive(archive);
+
+    const extract_options options{.threads = 2, .max_queued_bytes = 4 * 1024 * 1024,
+                                  .write_behind_threshold = 1024 * 1024};
+    REQUIRE(extract_archive(reader, temp_dir.path(), options).has_value());
+    CHECK(read_file_content(temp_dir.path() / "large.bin") == large);
+    CHECK(read_file_content(temp_dir.path() / "small.bin") == small);
+    CHECK(fs::file_size(temp_dir.path() / "large.bin") == large.size());
+}
+
+TEST_CASE("extract_archive deduplicates identical files", "[integration][extract]") {
+    TempDirectory temp_dir;
+    const std::string large(64 * 1024, 'L');
+    auto archive = tar_builder{}
+        .file("a/first.txt", "same")
+        .file("b/second.txt", "same")
+        .file("b/private.txt", "same", 0600)
+        .file("c/other.txt", "different")
+        .hardlink("c/hard", "b/second.txt")
+        .file("big/one.bin", large)
+        .file("big/two.bin", large)
+        .file("e/empty1", "")
+        .file("e/empty2", "")
+        .finish();
+    const auto out = temp_dir.path() / "out";
+    const auto check_contents = [&] {
+        CHECK(read_file_content(out / "a" / "first.txt") == "same");
+        CHECK(read_file_content(out / "b" / "second.txt") == "same");
+        CHECK(read_file_content(out / "b" / "private.txt") == "same");
+        CHECK(read_file_content(out / "c" / "other.txt") == "different");
+        CHECK(read_file_content(out / "c" / "hard") == "same");
+        CHECK(read_file_content(out / "big" / "two.bin") == large);
+        CHECK(fs::file_size(out / "e" / "empty2") == 0);
+        CHECK((fs::status(out / "b" / "private.txt").permissions() & fs::perms::all) == fs::perms{0600});
+    };
+
+    SECTION("Hard links from a mapped archive") {
+        auto reader = open_memory_archive(archive);
+        size_t reported = 0;
+        // Large members are streamed by the scanner, mapped ones are still hashed first
+        const extract_options options{.threads = 2, .max_queued_bytes = 1024,
+            .on_digests = [&](const archive_entry&, const entry_digests&) { ++reported; },
+            .dedup = dedup_mode::hard_link};
+        REQUIRE(extract_archive(reader, out, options).has_value());
+        check_contents();
+        CHECK(fs::equivalent(out / "a" / "first.txt", out / "b" / "second.txt"));
+        CHECK(fs::equivalent(out / "a" / "first.txt", out / "c" / "hard"));
+        CHECK(fs::equivalent(out / "big" / "one.bin", out / "big" / "two.bin"));
+        CHECK(fs::equivalent(out / "e" / "empty1", out / "e" / "empty2"));
+        // A different mode would change the first copy, so it is written apart
+        CHECK_FALSE(fs::equivalent(out / "a" / "first.txt", out / "b" / "private.txt"));
+        CHECK(fs::hard_link_count(out / "a" / "first.txt") == 3);
+        CHECK(reported == 8);
+    }
+
+    SECTION("Hard links from a streamed archive") {
+        const auto path = temp_dir.path() / "dedup.tar";
+        {
+            std::ofstream file(path, std::ios::binary);
+            file.write(reinterpret_cast<const char*>(archive.data()), static_cast<std::streamsize>(archive.size()));
+        }
+        auto reader = open_archive(path);
+        REQUIRE(reader.has_value());
+        REQUIRE(extract_archive(*reader, out, {.max_queued_bytes = 1024, .dedup = dedup_mode::hard_link}).has_value());
+        check_contents();
+        CHECK(fs::equivalent(out / "a" / "first.txt", out / "b" / "second.txt"));
+        // Streamed from a plain stream, the second copy is written but not kept apart
+        CHECK_FALSE(fs::equivalent(out / "big" / "one.bin", out / "big" / "two.bin"));
+    }
+
+    SECTION("Reflinked copies") {
+        auto reader = open_memory_archive(archive);
+        REQUIRE(extract_archive(reader, out, {.threads = 2, .dedup = dedup_mode::reflink}).has_value());
+        check_contents();
+        // Each copy has its own inode and metadata, whether or not extents are shared
+        CHECK_FALSE(fs::equivalent(out / "a" / "first.txt", out / "b" / "second.txt"));
+        CHECK(fs::equivalent(out / "c" / "hard", out / "b" / "second.txt"));
+        CHECK(fs::hard_link_count(out / "a" / "first.txt") == 1);
+    }
+}
+
+TEST_CASE("extract_archive keeps duplicates whose source is overwritten", "[integration][extract]") {
+    TempDirectory temp_dir;
+    const std::string first(4096, 'X');
+    const std::string second(4096, 'Y');
+    auto archive = tar_builder{}
+        .file("a.txt", first)
+        .file("b.txt", first)
+        .file("a.txt", second)
+        .file("c.txt", first)
+        .finish();
+    for (const auto mode : {dedup_mode::hard_link, dedup_mode::reflink}) {
+        const auto out = temp_dir.path() / ("out" + std::to_string(static_cast<int>(mode)));
+        auto reader = open_memory_archive(archive);
+        REQUIRE(extract_archive(reader, out, {.threads = 4, .dedup = mode}).has_value());
+        // The duplicate was made from the first content, not what later took its source's path
+        CHECK(read_file_content(out / "a.txt") == second);
+        CHECK(read_file_content(out / "b.txt") == first);
+        CHECK(read_file_content(out / "c.txt") == first);
+        CHECK_FALSE(fs::equivalent(out / "a.txt", out / "b.txt"));
+    }
+}
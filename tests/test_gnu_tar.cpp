@@ -15,6 +15,7 @@
  */
 
 #include <catch2/catch_test_macros.hpp>
+#include <tierone/tar/archive_reader.hpp>
 #include <tierone/tar/gnu_tar.hpp>
 #include <tierone/tar/header_parser.hpp>
 #include <tierone/tar/stream.hpp>
@@ -90,6 +91,28 @@ std::vector<std::byte> create_data_blocks(const std::string& data) {
     return blocks;
 }
 
+std::array<std::byte, 512> create_entry_header(const std::string& name, const char typeflag,
+                                               const std::string& linkname = {}) {
+    std::array<std::byte, 512> block{};
+    auto* header = std::bit_cast<ustar_header*>(block.data());
+    
+    std::strncpy(header->name, name.c_str(), sizeof(header->name));
+    std::strncpy(header->mode, "0000644", sizeof(header->mode));
+    std::strncpy(header->uid, "0000000", sizeof(header->uid));
+    std::strncpy(header->gid, "0000000", sizeof(header->gid));
+    std::strncpy(header->size, "00000000000", sizeof(header->size));
+    std::strncpy(header->mtime, "00000000000", sizeof(header->mtime));
+    header->typeflag = typeflag;
+    std::strncpy(header->linkname, linkname.c_str(), sizeof(header->linkname));
+    std::strncpy(header->magic, "ustar ", sizeof(header->magic));
+    std::strncpy(header->version, " ", sizeof(header->version));
+    
+    uint32_t checksum = detail::calculate_checksum(block);
+    std::snprintf(header->checksum, sizeof(header->checksum), "%06o ", checksum);
+    
+    return block;
+}
+
 class mock_gnu_stream : public input_stream {
 private:
     std::vector<std::byte> data_;
@@ -108,7 +131,7 @@ public:
         return to_read;
     }
 
-    std::expected<void, error> skip(size_t bytes) override {
+    std::expected<void, error> skip(uint64_t bytes) override {
         if (position_ + bytes > data_.size()) {
             return std::unexpected(error{error_code::io_error, "Skip past end"});
         }
@@ -206,4 +229,51 @@ TEST_CASE("GNU extension data management", "[gnu_tar]") {
         CHECK_FALSE(extensions.has_longname());
         CHECK_FALSE(extensions.has_longlink());
     }
-}
\ No newline at end of file
+}
+
+TEST_CASE("Reader takes path and link target from GNU extensions", "[gnu_tar]") {
+    const std::string longname = std::string(60, 'd') + "/" + std::string(60, 'e') + "/link";
+    const std::string longlink = std::string(70, 't') + "/" + std::string(70, 'u') + "/target";
+    
+    std::vector<std::byte> archive;
+    const auto append = [&archive](std::span<const std::byte> bytes) {
+        archive.insert(archive.end(), bytes.begin(), bytes.end());
+    };
+    append(create_gnu_longname_header(longname));
+    append(create_data_blocks(longname));
+    append(create_gnu_longlink_header(longlink));
+    append(create_data_blocks(longlink));
+    append(create_entry_header(longname.substr(0, 99), '2', longlink.substr(0, 99)));
+    append(create_entry_header("plain.txt", '0'));
+    archive.resize(archive.size() + 1024, std::byte{0});
+    
+    archive_reader reader{std::make_unique<mock_gnu_stream>(archive)};
+    
+    auto link = reader.next_entry();
+    REQUIRE(link.has_value());
+    REQUIRE(link->has_value());
+    CHECK((*link)->path() == longname);
+    CHECK((*link)->link_target() == longlink);
+    CHECK((*link)->is_symbolic_link());
+    
+    // The extensions apply to one entry only
+    auto plain = reader.next_entry();
+    REQUIRE(plain.has_value());
+    REQUIRE(plain->has_value());
+    CHECK((*plain)->path() == "plain.txt");
+    CHECK_FALSE((*plain)->link_target().has_value());
+    
+    auto end = reader.next_entry();
+    REQUIRE(end.has_value());
+    CHECK_FALSE(end->has_value());
+}
+
+TEST_CASE("Parse header leaves replaced fields empty", "[gnu_tar]") {
+    const auto block = create_entry_header("truncated/name", '2', "truncated/target");
+    
+    auto result = detail::parse_header(block, {.path = true, .link_target = true});
+    REQUIRE(result.has_value());
+    CHECK(result->path.empty());
+    CHECK_FALSE(result->link_target.has_value());
+    CHECK(result->type == entry_type::symbolic_link);
+}
@@ -16,7 +16,9 @@
 
 #include <catch2/catch_test_macros.hpp>
 #include <tierone/tar/header_parser.hpp>
+#include <tierone/tar/entry_view.hpp>
 #include <array>
+#include <chrono>
 #include <cstring>
 
 using namespace tierone::tar;
@@ -111,4 +113,90 @@ TEST_CASE("Extract string from field", "[header_parser]") {
         auto result = detail::extract_string(std::span{field});
         CHECK(result == "hello");
     }
-}
\ No newline at end of file
+}
+namespace {
+
+// Field of the given width holding text, NUL-padded
+template<size_t Width, size_t N>
+constexpr std::array<char, Width> field_of(const char (&text)[N]) {
+    static_assert(N - 1 <= Width);
+    std::array<char, Width> field{};
+    for (size_t i = 0; i + 1 < N; ++i) {
+        field[i] = text[i];
+    }
+    return field;
+}
+
+template<size_t Width, size_t N>
+constexpr auto octal(const char (&text)[N]) {
+    const auto field = field_of<Width>(text);
+    return detail::parse_octal(std::span<const char, Width>{field});
+}
+
+template<size_t Width, size_t N>
+constexpr auto numeric(const char (&text)[N]) {
+    const auto field = field_of<Width>(text);
+    return detail::parse_numeric(std::span<const char, Width>{field});
+}
+
+template<size_t Width, size_t N>
+constexpr auto signed_numeric(const char (&text)[N]) {
+    const auto field = field_of<Width>(text);
+    return detail::parse_signed_numeric(std::span<const char, Width>{field});
+}
+
+// Octal, as written by every tar
+static_assert(octal<8>("0000644") == 0644);
+static_assert(octal<8>("  644  ") == 0644);
+static_assert(octal<8>("\0\0" "0644 ") == 0644);
+static_assert(octal<8>("") == 0);
+static_assert(octal<8>("       ") == 0);
+static_assert(octal<8>("12345670") == 012345670);
+static_assert(octal<8>("12 9") == 012);
+static_assert(octal<12>("00000000010") == 010);
+static_assert(octal<12>("77777777777") == 077777777777);
+static_assert(octal<12>("777777777777") == 0777777777777);
+static_assert(octal<12>("00001234567 ") == 01234567);
+static_assert(!octal<8>("0008"));
+static_assert(!octal<8>("+123"));
+static_assert(octal<12>("1234 x") == 01234);
+static_assert(octal<8>("0008").error().code() == error_code::invalid_header);
+
+// GNU base-256
+static_assert(numeric<12>("\x80\0\0\0\0\0\0\x02\0\0\0\0") == 8ull << 30);
+static_assert(numeric<12>("\x80\0\0\0\0\0\0\x02\x80\0\0\0") == 10ull << 30);
+static_assert(numeric<12>("\x80\0\0\0\x7f\xff\xff\xff\xff\xff\xff\xff") == 0x7fffffffffffffffull);
+static_assert(numeric<8>("\x80\0\0\0\0\0\x01\0") == 256);
+static_assert(numeric<12>("00000000010") == 010);
+static_assert(!numeric<12>("\x80\x01\0\0\0\0\0\0\0\0\0\0"));
+static_assert(!numeric<12>("\x80\0\0\0\x80\0\0\0\0\0\0\0"));
+static_assert(!numeric<12>("\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff"));
+static_assert(signed_numeric<12>("\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff") == -1);
+static_assert(signed_numeric<12>("\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\0") == -256);
+static_assert(signed_numeric<8>("\xff\xff\xff\xff\xff\xff\xff\xfe") == -2);
+static_assert(signed_numeric<12>("14371573624") == 014371573624);
+static_assert(!signed_numeric<12>("\xff\xff\xff\xfe\xff\xff\xff\xff\xff\xff\xff\xff"));
+
+} // anonymous namespace
+
+TEST_CASE("Parse base-256 numeric fields", "[header_parser]") {
+    auto block = create_test_header();
+    auto* header = std::bit_cast<ustar_header*>(block.data());
+
+    // 10 GiB, beyond the 8 GiB octal limit, and a time before 1970
+    constexpr auto size = field_of<12>("\x80\0\0\0\0\0\0\x02\x80\0\0\0");
+    constexpr auto mtime = field_of<12>("\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\xff\0");
+    std::memcpy(header->size, size.data(), size.size());
+    std::memcpy(header->mtime, mtime.data(), mtime.size());
+    std::snprintf(header->checksum, sizeof(header->checksum), "%06o ", detail::calculate_checksum(block));
+
+    auto metadata = detail::parse_header(block);
+    REQUIRE(metadata.has_value());
+    CHECK(metadata->size == 10ull << 30);
+    CHECK(metadata->modification_time == std::chrono::system_clock::from_time_t(-256));
+
+    auto view = entry_view::parse(block);
+    REQUIRE(view.has_value());
+    CHECK(view->size() == 10ull << 30);
+    CHECK(view->modification_time() == std::chrono::system_clock::from_time_t(-256));
+}
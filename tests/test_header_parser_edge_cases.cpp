@@ -21,6 +21,7 @@
 #include <array>
 #include <cstring>
 #include <limits>
+#include <random>
 
 using namespace tierone::tar;
 
@@ -392,6 +393,23 @@ TEST_CASE("calculate_checksum edge cases", "[unit][header_parser][edge_cases]")
         
         CHECK(checksum1 == checksum2);
     }
+    
+    SECTION("Matches a byte-wise reference on random blocks") {
+        std::mt19937 gen(12345);
+        std::uniform_int_distribution<int> dis(0, 255);
+        for (int round = 0; round < 200; ++round) {
+            std::array<std::byte, 512> block;
+            for (auto& b : block) {
+                b = static_cast<std::byte>(dis(gen));
+            }
+            
+            uint32_t expected = 0;
+            for (size_t i = 0; i < block.size(); ++i) {
+                expected += (i >= 148 && i < 156) ? ' ' : static_cast<uint8_t>(block[i]);
+            }
+            CHECK(detail::calculate_checksum(block) == expected);
+        }
+    }
 }
 
 TEST_CASE("is_zero_block edge cases", "[unit][header_parser][edge_cases]") {
@@ -415,6 +433,16 @@ TEST_CASE("is_zero_block edge cases", "[unit][header_parser][edge_cases]") {
         
         CHECK_FALSE(detail::is_zero_block(space_block));
     }
+    
+    SECTION("Single set bit anywhere in the block") {
+        for (size_t i = 0; i < 512; ++i) {
+            std::array<std::byte, 512> block{};
+            block[i] = std::byte{0x80};
+            CHECK_FALSE(detail::is_zero_block(block));
+        }
+        std::array<std::byte, 512> zero_block{};
+        CHECK(detail::is_zero_block(zero_block));
+    }
 }
 
 TEST_CASE("header_parser error conditions", "[unit][header_parser][edge_cases]") {
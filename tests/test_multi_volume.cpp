@@ -0,0 +1,230 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/matchers/catch_matchers_string.hpp>
+#include <tierone/tar/tar.hpp>
+#include <array>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace tierone::tar;
+
+namespace {
+
+using volume_list = std::vector<std::vector<std::byte>>;
+
+std::vector<std::byte> patterned(size_t size, unsigned seed) {
+    std::vector<std::byte> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<std::byte>((i * 31 + seed) & 0xff);
+    }
+    return data;
+}
+
+// Archive of three files, the middle one spanning several blocks
+std::vector<std::byte> sample_archive() {
+    std::vector<std::byte> archive;
+    archive_writer writer{std::make_unique<memory_output_stream>(archive)};
+    file_metadata meta;
+    meta.type = entry_type::regular_file;
+    meta.permissions = std::filesystem::perms{0644};
+    for (const auto& [name, size] : {std::pair{"first.txt", 100}, {"big.bin", 5000}, {"last.txt", 700}}) {
+        meta.path = name;
+        meta.size = static_cast<uint64_t>(size);
+        REQUIRE(writer.add_entry(meta, patterned(static_cast<size_t>(size), meta.path.string().size())).has_value());
+    }
+    REQUIRE(writer.finish().has_value());
+    return archive;
+}
+
+// GNU label or continuation header, without magic like GNU tar writes them
+std::array<std::byte, 512> gnu_header(const std::string& name, char type, uint64_t size, uint64_t offset = 0) {
+    std::array<char, 512> header{};
+    std::memcpy(header.data(), name.data(), std::min<size_t>(name.size(), 100));
+    std::snprintf(header.data() + 100, 8, "%07o", 0644u);
+    std::snprintf(header.data() + 108, 8, "%07o", 0u);
+    std::snprintf(header.data() + 116, 8, "%07o", 0u);
+    std::snprintf(header.data() + 124, 12, "%011llo", static_cast<unsigned long long>(size));
+    std::snprintf(header.data() + 136, 12, "%011o", 1700000000u);
+    header[156] = type;
+    std::snprintf(header.data() + 369, 12, "%011llo", static_cast<unsigned long long>(offset));
+    std::memset(header.data() + 148, ' ', 8);
+    unsigned checksum = 0;
+    for (char c : header) {
+        checksum += static_cast<unsigned char>(c);
+    }
+    std::snprintf(header.data() + 148, 8, "%06o", checksum);
+
+    std::array<std::byte, 512> block{};
+    std::memcpy(block.data(), header.data(), block.size());
+    return block;
+}
+
+// Split archive at cut, starting the second volume with a label and, when
+// the cut falls inside big.bin's data, a continuation resuming at resume
+volume_list split(const std::vector<std::byte>& archive, size_t cut, std::optional<uint64_t> resume = {}) {
+    // big.bin's data follows the first header, first.txt's data block and its own header
+    constexpr size_t big_data = 3 * 512;
+    constexpr uint64_t big_size = 5000;
+
+    volume_list volumes(2);
+    volumes[0].assign(archive.begin(), archive.begin() + static_cast<std::ptrdiff_t>(cut));
+    const auto label = gnu_header("backup volume 2", 'V', 0);
+    volumes[1].assign(label.begin(), label.end());
+    size_t from = cut;
+    if (cut > big_data && cut < big_data + big_size) {
+        const uint64_t offset = resume.value_or(cut - big_data);
+        const auto continuation = gnu_header("big.bin", 'M', big_size - offset, offset);
+        volumes[1].insert(volumes[1].end(), continuation.begin(), continuation.end());
+        from = big_data + static_cast<size_t>(offset);
+    }
+    volumes[1].insert(volumes[1].end(), archive.begin() + static_cast<std::ptrdiff_t>(from), archive.end());
+    return volumes;
+}
+
+std::unique_ptr<multi_volume_stream> open_volumes(const volume_list& volumes) {
+    auto stream = multi_volume_stream::open(
+        [&volumes](size_t index) -> std::expected<std::unique_ptr<input_stream>, error> {
+            if (index >= volumes.size()) {
+                return std::unique_ptr<input_stream>{};
+            }
+            return std::make_unique<memory_mapped_stream>(std::span<const std::byte>{volumes[index]});
+        },
+        1024);
+    REQUIRE(stream.has_value());
+    return std::move(*stream);
+}
+
+// Every entry's path and data, in order
+std::vector<std::pair<std::string, std::vector<std::byte>>> read_all(archive_reader& reader) {
+    std::vector<std::pair<std::string, std::vector<std::byte>>> entries;
+    while (true) {
+        auto entry = reader.next_entry();
+        REQUIRE(entry.has_value());
+        if (!*entry) {
+            break;
+        }
+        auto data = (*entry)->read_data();
+        REQUIRE(data.has_value());
+        entries.emplace_back((*entry)->path().string(), std::vector<std::byte>(data->begin(), data->end()));
+    }
+    return entries;
+}
+
+} // anonymous namespace
+
+TEST_CASE("multi_volume_stream joins split archives", "[unit][multi_volume]") {
+    const auto archive = sample_archive();
+    archive_reader single{std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive})};
+    const auto expected = read_all(single);
+    REQUIRE(expected.size() == 3);
+
+    SECTION("a member split across volumes reads back whole") {
+        const auto volumes = split(archive, 3 * 512 + 2048);
+        archive_reader reader{open_volumes(volumes)};
+        CHECK(read_all(reader) == expected);
+    }
+
+    SECTION("a split between members needs no continuation") {
+        const auto volumes = split(archive, 3 * 512 + 10 * 512);
+        archive_reader reader{open_volumes(volumes)};
+        CHECK(read_all(reader) == expected);
+    }
+
+    SECTION("skipped members are skipped across volumes") {
+        const auto volumes = split(archive, 3 * 512 + 1024);
+        archive_reader reader{open_volumes(volumes)};
+        for (const auto& [path, data] : expected) {
+            auto entry = reader.next_entry();
+            REQUIRE(entry.has_value());
+            REQUIRE(entry->has_value());
+            CHECK((*entry)->path() == path);
+        }
+    }
+
+    SECTION("a continuation repeating data already read is resumed after it") {
+        const auto volumes = split(archive, 3 * 512 + 2048, 1024);
+        archive_reader reader{open_volumes(volumes)};
+        CHECK(read_all(reader) == expected);
+    }
+
+    SECTION("a continuation missing data is refused") {
+        const auto volumes = split(archive, 3 * 512 + 2048, 3072);
+        archive_reader reader{open_volumes(volumes)};
+        REQUIRE(reader.next_entry().has_value());
+        auto big = reader.next_entry();
+        REQUIRE(big.has_value());
+        REQUIRE(big->has_value());
+        auto data = (*big)->read_data();
+        REQUIRE_FALSE(data.has_value());
+        CHECK(data.error().code() == error_code::corrupt_archive);
+        CHECK_THAT(data.error().message(), Catch::Matchers::ContainsSubstring("big.bin"));
+    }
+
+    SECTION("a later volume read alone drops the member it continues") {
+        const volume_list second_only{split(archive, 3 * 512 + 2048)[1]};
+        archive_reader reader{open_volumes(second_only)};
+        const auto entries = read_all(reader);
+        REQUIRE(entries.size() == 1);
+        CHECK(entries[0] == expected[2]);
+    }
+
+    SECTION("a volume not continuing the member is refused") {
+        auto volumes = split(archive, 3 * 512 + 10 * 512);
+        volumes[0].resize(3 * 512 + 2048);
+        archive_reader reader{open_volumes(volumes)};
+        REQUIRE(reader.next_entry().has_value());
+        auto big = reader.next_entry();
+        REQUIRE(big.has_value());
+        REQUIRE(big->has_value());
+        auto data = (*big)->read_data();
+        REQUIRE_FALSE(data.has_value());
+        CHECK(data.error().code() == error_code::corrupt_archive);
+    }
+}
+
+TEST_CASE("multi_volume_stream reads volume files in order", "[integration][multi_volume]") {
+    const auto archive = sample_archive();
+    const auto volumes = split(archive, 3 * 512 + 4096);
+
+    const auto directory = std::filesystem::temp_directory_path() /
+                           ("tierone_volumes_" + std::to_string(std::random_device{}() % 100000));
+    std::filesystem::create_directories(directory);
+    std::vector<std::filesystem::path> paths;
+    for (size_t i = 0; i < volumes.size(); ++i) {
+        paths.push_back(directory / ("backup.tar-" + std::to_string(i)));
+        std::ofstream{paths.back(), std::ios::binary}.write(
+            reinterpret_cast<const char*>(volumes[i].data()), static_cast<std::streamsize>(volumes[i].size()));
+    }
+
+    auto stream = multi_volume_stream::open(paths);
+    REQUIRE(stream.has_value());
+    archive_reader reader{std::move(*stream)};
+    const auto entries = read_all(reader);
+    std::filesystem::remove_all(directory);
+
+    REQUIRE(entries.size() == 3);
+    CHECK(entries[1].first == "big.bin");
+    CHECK(entries[1].second == patterned(5000, 7));
+}
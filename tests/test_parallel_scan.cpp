@@ -0,0 +1,221 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <catch2/catch_test_macros.hpp>
+#include <tierone/tar/tar.hpp>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace tierone::tar;
+
+namespace {
+
+std::vector<std::byte> patterned(size_t size, unsigned seed) {
+    std::vector<std::byte> data(size);
+    for (size_t i = 0; i < size; ++i) {
+        data[i] = static_cast<std::byte>(((i + seed) * 131 + 7) & 0xff);
+    }
+    return data;
+}
+
+// Archive of files of varied sizes, some with long names, and a file that
+// is itself a tar archive, so its data holds blocks that look like headers
+std::vector<std::byte> sample_archive() {
+    std::vector<std::byte> inner;
+    {
+        archive_writer writer{std::make_unique<memory_output_stream>(inner)};
+        file_metadata meta;
+        meta.type = entry_type::regular_file;
+        meta.permissions = std::filesystem::perms{0644};
+        for (unsigned i = 0; i < 20; ++i) {
+            meta.path = "inner/file" + std::to_string(i);
+            meta.size = 700;
+            REQUIRE(writer.add_entry(meta, patterned(700, i)).has_value());
+        }
+        REQUIRE(writer.finish().has_value());
+    }
+
+    std::vector<std::byte> archive;
+    archive_writer writer{std::make_unique<memory_output_stream>(archive)};
+    file_metadata meta;
+    meta.type = entry_type::regular_file;
+    meta.permissions = std::filesystem::perms{0644};
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<size_t> sizes(0, 9000);
+    for (unsigned i = 0; i < 60; ++i) {
+        meta.path = (i % 7 == 0 ? std::string(120, 'd') + "/" : std::string{"dir/"}) + "file" + std::to_string(i);
+        if (i == 30) {
+            meta.path = "nested.tar";
+            meta.size = inner.size();
+            REQUIRE(writer.add_entry(meta, inner).has_value());
+            continue;
+        }
+        const size_t size = i % 13 == 0 ? 40000 : sizes(gen);
+        meta.size = size;
+        REQUIRE(writer.add_entry(meta, patterned(size, i)).has_value());
+    }
+    REQUIRE(writer.finish().has_value());
+    return archive;
+}
+
+std::vector<index_record> sequential_records(const std::vector<std::byte>& archive) {
+    archive_reader reader{std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive})};
+    auto index = archive_index::build(reader);
+    REQUIRE(index.has_value());
+    return {index->records().begin(), index->records().end()};
+}
+
+void check_same(std::span<const index_record> scanned, const std::vector<index_record>& expected) {
+    REQUIRE(scanned.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); ++i) {
+        CHECK(scanned[i].metadata.path == expected[i].metadata.path);
+        CHECK(scanned[i].metadata.owner_name == expected[i].metadata.owner_name);
+        CHECK(scanned[i].location.header_offset == expected[i].location.header_offset);
+        CHECK(scanned[i].location.data_offset == expected[i].location.data_offset);
+        CHECK(scanned[i].location.stored_size == expected[i].location.stored_size);
+    }
+}
+
+// PAX global header setting uname, two blocks
+std::vector<std::byte> global_header() {
+    const std::string records = "16 uname=global\n";
+    std::array<char, 1024> blocks{};
+    std::memcpy(blocks.data(), "pax_global_header", 17);
+    std::snprintf(blocks.data() + 100, 8, "%07o", 0644u);
+    std::snprintf(blocks.data() + 124, 12, "%011zo", records.size());
+    std::snprintf(blocks.data() + 136, 12, "%011o", 0u);
+    blocks[156] = 'g';
+    std::memcpy(blocks.data() + 257, "ustar", 6);
+    blocks[263] = '0';
+    blocks[264] = '0';
+    std::memset(blocks.data() + 148, ' ', 8);
+    unsigned checksum = 0;
+    for (size_t i = 0; i < 512; ++i) {
+        checksum += static_cast<unsigned char>(blocks[i]);
+    }
+    std::snprintf(blocks.data() + 148, 8, "%06o", checksum);
+    std::memcpy(blocks.data() + 512, records.data(), records.size());
+
+    std::vector<std::byte> data(blocks.size());
+    std::memcpy(data.data(), blocks.data(), blocks.size());
+    return data;
+}
+
+} // anonymous namespace
+
+TEST_CASE("scan_archive matches a sequential scan", "[unit][parallel_scan]") {
+    auto archive = sample_archive();
+    const scan_options options{.threads = 4, .range_size = 4096};
+
+    SECTION("ranges cut through members, extension headers and a nested archive") {
+        const auto expected = sequential_records(archive);
+        memory_mapped_stream stream{std::span<const std::byte>{archive}};
+        auto index = scan_archive(stream, options);
+        REQUIRE(index.has_value());
+        check_same(index->records(), expected);
+        REQUIRE(index->find("nested.tar") != nullptr);
+        CHECK(index->find("inner/file3") == nullptr);
+    }
+
+    SECTION("entries after a global header get its values") {
+        const auto plain = sequential_records(archive);
+        const auto at = plain[25].location.header_offset;
+        const auto global = global_header();
+        archive.insert(archive.begin() + static_cast<std::ptrdiff_t>(at), global.begin(), global.end());
+
+        const auto expected = sequential_records(archive);
+        REQUIRE(expected[25].metadata.owner_name == "global");
+        memory_mapped_stream stream{std::span<const std::byte>{archive}};
+        auto index = scan_archive(stream, options);
+        REQUIRE(index.has_value());
+        check_same(index->records(), expected);
+    }
+
+    SECTION("small archives are scanned on one thread") {
+        const auto expected = sequential_records(archive);
+        memory_mapped_stream stream{std::span<const std::byte>{archive}};
+        auto index = scan_archive(stream, {.threads = 4, .range_size = archive.size()});
+        REQUIRE(index.has_value());
+        check_same(index->records(), expected);
+    }
+
+    SECTION("a corrupt header on the chain is reported") {
+        const auto expected = sequential_records(archive);
+        archive[static_cast<size_t>(expected[40].location.header_offset) + 148] = std::byte{'9'};
+        memory_mapped_stream stream{std::span<const std::byte>{archive}};
+        auto index = scan_archive(stream, options);
+        REQUIRE_FALSE(index.has_value());
+    }
+}
+
+TEST_CASE("scan_archive needs a memory-backed stream", "[unit][parallel_scan]") {
+    const auto archive = sample_archive();
+    const auto path = std::filesystem::temp_directory_path() /
+                      ("tierone_scan_" + std::to_string(std::random_device{}() % 100000) + ".tar");
+    std::ofstream{path, std::ios::binary}.write(
+        reinterpret_cast<const char*>(archive.data()), static_cast<std::streamsize>(archive.size()));
+    auto stream = file_stream::open(path);
+    REQUIRE(stream.has_value());
+    auto index = scan_archive(*stream);
+    std::filesystem::remove(path);
+    REQUIRE_FALSE(index.has_value());
+    CHECK(index.error().code() == error_code::unsupported_feature);
+}
+
+TEST_CASE("for_each_entry visits every entry with its data", "[unit][parallel_scan]") {
+    const auto archive = sample_archive();
+    const auto expected = sequential_records(archive);
+    memory_mapped_stream stream{std::span<const std::byte>{archive}};
+    const scan_options options{.threads = 3, .range_size = 4096};
+
+    std::atomic<size_t> visited{0};
+    std::atomic<uint64_t> bytes{0};
+    auto result = for_each_entry(stream, [&](const index_record& record, std::span<const std::byte> data) {
+        CHECK(data.size() == record.location.stored_size);
+        if (record.metadata.path == "dir/file1") {
+            CHECK(std::ranges::equal(data, patterned(data.size(), 1)));
+        }
+        ++visited;
+        bytes += data.size();
+        return std::expected<void, error>{};
+    }, options);
+    REQUIRE(result.has_value());
+    CHECK(visited == expected.size());
+    uint64_t total = 0;
+    for (const auto& record : expected) {
+        total += record.location.stored_size;
+    }
+    CHECK(bytes == total);
+
+    SECTION("the first error stops the scan") {
+        auto failed = for_each_entry(stream, [](const index_record& record, std::span<const std::byte>) {
+            if (record.metadata.path == "nested.tar") {
+                return std::expected<void, error>{std::unexpect, error{error_code::io_error, "Visitor failed"}};
+            }
+            return std::expected<void, error>{};
+        }, options);
+        REQUIRE_FALSE(failed.has_value());
+        CHECK(failed.error().code() == error_code::io_error);
+    }
+}
@@ -761,4 +761,75 @@ TEST_CASE("pax_parser integration scenarios", "[unit][pax_parser]") {
         // Should fail on the invalid entry
         REQUIRE_FALSE(result.has_value());
     }
-}
\ No newline at end of file
+}
+TEST_CASE("parse_records decodes well-known keys in place", "[unit][pax_parser]") {
+    const auto bytes = string_to_bytes(
+        "27 path=long/file/name.txt\n"
+        "19 linkpath=target\n"
+        "16 size=1234567\n"
+        "30 mtime=1700000000.123456789\n"
+        "12 uid=1000\n"
+        "12 gid=2000\n"
+        "15 uname=alice\n"
+        "15 gname=staff\n"
+        "30 SCHILY.xattr.user.tag=blue\n"
+        "15 path=second\n");
+    extended_header header;
+    REQUIRE(parse_records(make_span(bytes), header).has_value());
+
+    CHECK(header.records.size() == 10);
+    CHECK(header.records[0].key == "path");
+    // Views point into the parsed data
+    CHECK(header.records[0].value.data() >= reinterpret_cast<const char*>(bytes.data()));
+    CHECK(header.records[0].value.data() < reinterpret_cast<const char*>(bytes.data() + bytes.size()));
+
+    CHECK(header.path == "second");  // The last record wins
+    CHECK(header.find("path") == "second");
+    CHECK(header.linkpath == "target");
+    CHECK(header.size == 1234567u);
+    CHECK(header.mtime == 1700000000);
+    CHECK(header.uid == 1000u);
+    CHECK(header.gid == 2000u);
+    CHECK(header.uname == "alice");
+    CHECK(header.gname == "staff");
+    CHECK(header.has_xattrs_or_acls);
+    CHECK_FALSE(header.gnu_sparse);
+    CHECK_FALSE(header.find("missing").has_value());
+
+    file_metadata metadata;
+    header.apply_to(metadata);
+    CHECK(metadata.path == "second");
+    CHECK(metadata.link_target == "target");
+    CHECK(metadata.size == 1234567u);
+    CHECK(metadata.owner_id == 1000u);
+    CHECK(metadata.group_name == "staff");
+    CHECK(metadata.modification_time == std::chrono::system_clock::time_point{std::chrono::seconds{1700000000}});
+    CHECK(metadata.xattrs.at("user.tag") == "blue");
+}
+
+TEST_CASE("parse_records reuses its storage", "[unit][pax_parser]") {
+    extended_header header;
+    const auto first = string_to_bytes(
+        "22 GNU.sparse.major=1\n22 GNU.sparse.minor=0\n28 GNU.sparse.realsize=8196\n29 GNU.sparse.name=real/disk\n");
+    REQUIRE(parse_records(make_span(first), header).has_value());
+    CHECK(header.gnu_sparse);
+    CHECK(header.path == "real/disk");
+    CHECK(header.sparse_major == 1);
+    CHECK(header.sparse_minor == 0);
+    CHECK(header.sparse_realsize == 8196u);
+    const auto* storage = header.records.data();
+
+    // A second header replaces every decoded field
+    const auto second = string_to_bytes("12 size=bad\n");
+    REQUIRE(parse_records(make_span(second), header).has_value());
+    CHECK(header.records.data() == storage);
+    CHECK(header.records.size() == 1);
+    CHECK_FALSE(header.gnu_sparse);
+    CHECK_FALSE(header.sparse_realsize.has_value());
+    CHECK_FALSE(header.size.has_value());  // Unparsable numbers are ignored
+
+    const auto broken = string_to_bytes("99 path=x\n");
+    auto result = parse_records(make_span(broken), header);
+    REQUIRE_FALSE(result.has_value());
+    CHECK(result.error().code() == error_code::corrupt_archive);
+}
@@ -0,0 +1,82 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+
+#include <catch2/catch_test_macros.hpp>
+#include <tierone/tar/tar.hpp>
+#include <string>
+#include <vector>
+
+using namespace tierone::tar;
+
+namespace {
+
+std::vector<std::byte> make_archive(const std::string& path, long_name_format long_names = long_name_format::pax) {
+    std::vector<std::byte> archive;
+    archive_writer writer{std::make_unique<memory_output_stream>(archive), writer_options{.long_names = long_names}};
+    file_metadata meta;
+    meta.path = path;
+    meta.type = entry_type::regular_file;
+    meta.permissions = std::filesystem::perms{0644};
+    meta.size = 3;
+    REQUIRE(writer.add_entry(meta, std::vector<std::byte>(3)).has_value());
+    REQUIRE(writer.finish().has_value());
+    return archive;
+}
+
+} // namespace
+
+TEST_CASE("probe classifies tar headers", "[unit][probe]") {
+    const std::string long_path(300, 'p');
+
+    CHECK(probe(make_archive("short.txt")).format == tar_format::ustar);
+    CHECK(probe(make_archive(long_path)).format == tar_format::pax);
+    CHECK(probe(make_archive("short.txt", long_name_format::gnu)).format == tar_format::gnu);
+    CHECK(probe(make_archive(long_path, long_name_format::gnu)).format == tar_format::gnu);
+
+    const auto result = probe(make_archive("short.txt"));
+    CHECK(result.is_tar());
+    CHECK(result.compression == compression_format::none);
+}
+
+TEST_CASE("probe rejects what is not tar", "[unit][probe]") {
+    SECTION("Empty archive") {
+        const std::vector<std::byte> zeros(probe_size);
+        CHECK(probe(zeros).format == tar_format::empty);
+        CHECK(probe(std::span{zeros}.first(512)).format == tar_format::none);
+    }
+
+    SECTION("Short or unrelated data") {
+        CHECK_FALSE(probe({}).is_tar());
+        std::vector<std::byte> text(2048, std::byte{'a'});
+        CHECK_FALSE(probe(text).is_tar());
+    }
+
+    SECTION("Bad checksum") {
+        auto archive = make_archive("short.txt");
+        archive[0] = std::byte{'S'};
+        CHECK_FALSE(probe(archive).is_tar());
+    }
+
+    SECTION("Compressed data") {
+        std::vector<std::byte> gz(probe_size);
+        gz[0] = std::byte{0x1f};
+        gz[1] = std::byte{0x8b};
+        const auto result = probe(gz);
+        CHECK(result.compression == compression_format::gzip);
+        CHECK_FALSE(result.is_tar());
+    }
+}
@@ -0,0 +1,200 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <tierone/tar/tar.hpp>
+#include <tierone/tar/shared_archive.hpp>
+#include <tierone/tar/sparse.hpp>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace tierone::tar;
+
+namespace {
+
+file_metadata make_file(const std::string& path, const size_t size) {
+    file_metadata meta;
+    meta.path = path;
+    meta.type = entry_type::regular_file;
+    meta.permissions = std::filesystem::perms{0644};
+    meta.size = size;
+    meta.modification_time = std::chrono::system_clock::from_time_t(1700000000);
+    return meta;
+}
+
+std::span<const std::byte> as_bytes(const std::string& text) {
+    return {reinterpret_cast<const std::byte*>(text.data()), text.size()};
+}
+
+std::string as_string(const std::span<const std::byte> data) {
+    return {reinterpret_cast<const char*>(data.data()), data.size()};
+}
+
+// Old GNU sparse member: "data" at 0, "tail" at 9000, 12000 bytes in all
+void append_sparse(std::vector<std::byte>& archive, const char* name) {
+    const size_t start = archive.size();
+    archive.resize(start + 1024);
+    auto& header = *reinterpret_cast<sparse::gnu_sparse_header*>(archive.data() + start);
+    std::snprintf(header.name, sizeof(header.name), "%s", name);
+    std::snprintf(header.mode, sizeof(header.mode), "%07o", 0644);
+    std::snprintf(header.uid, sizeof(header.uid), "%07o", 0);
+    std::snprintf(header.gid, sizeof(header.gid), "%07o", 0);
+    std::snprintf(header.size, sizeof(header.size), "%011o", 8);
+    std::snprintf(header.mtime, sizeof(header.mtime), "%011o", 0);
+    header.typeflag = 'S';
+    std::memcpy(header.magic, "ustar  ", 8);
+    std::snprintf(header.sp[0].offset, 12, "%011o", 0);
+    std::snprintf(header.sp[0].numbytes, 12, "%011o", 4);
+    std::snprintf(header.sp[1].offset, 12, "%011o", 9000);
+    std::snprintf(header.sp[1].numbytes, 12, "%011o", 4);
+    std::snprintf(header.realsize, sizeof(header.realsize), "%011o", 12000);
+    std::memset(header.checksum, ' ', sizeof(header.checksum));
+    std::snprintf(header.checksum, 8, "%06o",
+        detail::calculate_checksum(std::span<const std::byte, 512>{archive.data() + start, 512}));
+    std::memcpy(archive.data() + start + 512, "datatail", 8);
+}
+
+std::string expected_sparse() {
+    std::string expected(12000, '\0');
+    expected.replace(0, 4, "data");
+    expected.replace(9000, 4, "tail");
+    return expected;
+}
+
+} // anonymous namespace
+
+TEST_CASE("shared_archive serves independent entries and cursors to many threads", "[unit][shared_archive]") {
+    std::string large(200000, '\0');
+    for (size_t i = 0; i < large.size(); ++i) {
+        large[i] = static_cast<char>('a' + i * 7 % 26);
+    }
+
+    std::vector<std::byte> archive;
+    {
+        archive_writer writer{std::make_unique<memory_output_stream>(archive)};
+        REQUIRE(writer.add_entry(make_file("small.txt", 5), as_bytes("hello")).has_value());
+        REQUIRE(writer.add_entry(make_file("large.bin", large.size()), as_bytes(large)).has_value());
+        REQUIRE(writer.finish().has_value());
+    }
+    // Sparse members go before the end-of-archive blocks
+    archive.resize(archive.size() - 1024);
+    append_sparse(archive, "disk.img");
+    archive.resize(archive.size() + 1024);
+
+    auto shared = shared_archive::open(archive);
+    REQUIRE(shared.has_value());
+    const auto& tar = **shared;
+    REQUIRE(tar.index().size() == 3);
+
+    const std::string sparse_content = expected_sparse();
+    std::atomic<int> failures{0};
+    std::vector<std::jthread> workers;
+    for (size_t t = 0; t < 16; ++t) {
+        workers.emplace_back([&, t] {
+            for (int round = 0; round < 20; ++round) {
+                // Zero-copy spans straight out of the shared memory
+                auto small = tar.open_entry("small.txt");
+                if (!small || as_string(*small->read_data()) != "hello") {
+                    ++failures;
+                }
+
+                // Chunked reads into this thread's own buffer
+                auto big = tar.open_entry("large.bin");
+                std::vector<std::byte> buffer(1000 + t);
+                const size_t offset = (t * 4099 + static_cast<size_t>(round) * 613) % large.size();
+                if (!big) {
+                    ++failures;
+                } else if (auto got = big->read_into(offset, buffer);
+                           !got || as_string(std::span{buffer}.first(*got)) != large.substr(offset, *got)) {
+                    ++failures;
+                }
+
+                // Sparse entries expand into a buffer owned by the entry
+                auto disk = tar.open_entry("disk.img");
+                if (!disk || as_string(*disk->read_data()) != sparse_content) {
+                    ++failures;
+                }
+
+                // Every cursor walks the whole archive on its own
+                auto reader = tar.reader();
+                size_t count = 0;
+                for ([[maybe_unused]] const auto& entry : reader) {
+                    ++count;
+                }
+                if (count != 3) {
+                    ++failures;
+                }
+            }
+        });
+    }
+    workers.clear();
+    CHECK(failures == 0);
+
+    auto missing = tar.open_entry("missing.txt");
+    REQUIRE_FALSE(missing.has_value());
+    CHECK(missing.error().system_errno() == ENOENT);
+}
+
+TEST_CASE("read_data spans belong to their entry", "[unit][shared_archive]") {
+    std::vector<std::byte> archive;
+    append_sparse(archive, "first.img");
+    append_sparse(archive, "second.img");
+    archive.resize(archive.size() + 1024);
+
+    auto shared = shared_archive::open(archive);
+    REQUIRE(shared.has_value());
+    auto first = (*shared)->open_entry("first.img");
+    auto second = (*shared)->open_entry("second.img");
+    REQUIRE(first.has_value());
+    REQUIRE(second.has_value());
+
+    // Reading the second entry leaves the first one's span alone
+    auto first_data = first->read_data(0, 4);
+    REQUIRE(first_data.has_value());
+    auto second_data = second->read_data(9000, 4);
+    REQUIRE(second_data.has_value());
+    CHECK(as_string(*first_data) == "data");
+    CHECK(as_string(*second_data) == "tail");
+}
+
+TEST_CASE("shared_archive maps archive files", "[unit][shared_archive]") {
+    std::vector<std::byte> archive;
+    {
+        archive_writer writer{std::make_unique<memory_output_stream>(archive)};
+        REQUIRE(writer.add_entry(make_file("a.txt", 3), as_bytes("abc")).has_value());
+        REQUIRE(writer.finish().has_value());
+    }
+    const auto path = std::filesystem::temp_directory_path() / "tierone_shared_archive_test.tar";
+    {
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(archive.data()), static_cast<std::streamsize>(archive.size()));
+    }
+
+    auto shared = shared_archive::open(path);
+    std::filesystem::remove(path);
+    REQUIRE(shared.has_value());
+    auto entry = (*shared)->open_entry("a.txt");
+    REQUIRE(entry.has_value());
+    CHECK(entry->is_mapped());
+    CHECK(as_string(*entry->read_data()) == "abc");
+}
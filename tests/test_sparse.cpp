@@ -15,13 +15,126 @@
  */
 
 #include <catch2/catch_test_macros.hpp>
+#include <tierone/tar/archive_entry.hpp>
+#include <tierone/tar/archive_reader.hpp>
+#include <tierone/tar/header_parser.hpp>
 #include <tierone/tar/sparse.hpp>
+#include <tierone/tar/sparse_reader.hpp>
 #include <tierone/tar/pax_parser.hpp>
 #include <tierone/tar/stream.hpp>
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
 #include <sstream>
+#include <tuple>
 
 using namespace tierone::tar;
 
+namespace {
+
+// Sequential reads over a buffer, without random access or peek()
+class sequential_stream : public input_stream {
+    std::span<const std::byte> data_;
+    size_t position_ = 0;
+
+public:
+    explicit sequential_stream(std::span<const std::byte> data) : data_(data) {}
+
+    std::expected<size_t, error> read(std::span<std::byte> buffer) override {
+        const size_t n = std::min(buffer.size(), data_.size() - position_);
+        std::copy_n(data_.begin() + static_cast<std::ptrdiff_t>(position_), n, buffer.begin());
+        position_ += n;
+        return n;
+    }
+
+    std::expected<void, error> skip(uint64_t bytes) override {
+        position_ += std::min(bytes, data_.size() - position_);
+        return {};
+    }
+
+    bool at_end() const override { return position_ == data_.size(); }
+};
+
+// The sparse 1.0 map for segments, padded to whole blocks
+std::string sparse_1_0_map(const std::vector<sparse::sparse_entry>& segments) {
+    std::string map = std::to_string(segments.size()) + "\n";
+    for (const auto& [offset, size] : segments) {
+        map += std::to_string(offset) + "\n" + std::to_string(size) + "\n";
+    }
+    map.resize((map.size() + 511) / 512 * 512, '\0');
+    return map;
+}
+
+// Old GNU sparse archive: an 'S' header with its first four segments, the
+// rest in extension blocks of 21, the packed data, then a plain file
+std::vector<std::byte> old_sparse_archive(const std::vector<sparse::sparse_entry>& segments, uint64_t real_size) {
+    std::vector<std::byte> archive;
+    auto put_entry = [](char* field, const sparse::sparse_entry& segment) {
+        std::snprintf(field, 12, "%011llo", static_cast<unsigned long long>(segment.offset));
+        std::snprintf(field + 12, 12, "%011llo", static_cast<unsigned long long>(segment.size));
+    };
+    auto header = [](const char* name, char type, uint64_t size) {
+        std::array<std::byte, 512> block{};
+        auto* raw = reinterpret_cast<char*>(block.data());
+        std::snprintf(raw, 100, "%s", name);
+        std::snprintf(raw + 100, 8, "%07o", 0644);
+        std::snprintf(raw + 108, 8, "%07o", 0);
+        std::snprintf(raw + 116, 8, "%07o", 0);
+        std::snprintf(raw + 124, 12, "%011llo", static_cast<unsigned long long>(size));
+        std::snprintf(raw + 136, 12, "%011o", 0);
+        raw[156] = type;
+        std::memcpy(raw + 257, "ustar  ", 8);
+        return block;
+    };
+    auto seal = [](std::array<std::byte, 512>& block) {
+        auto* raw = reinterpret_cast<char*>(block.data());
+        std::memset(raw + 148, ' ', 8);
+        std::snprintf(raw + 148, 8, "%06o", detail::calculate_checksum(block));
+    };
+
+    uint64_t stored = 0;
+    for (const auto& segment : segments) {
+        stored += segment.size;
+    }
+    auto block = header("disk.img", 'S', stored);
+    auto& sparse_header = *reinterpret_cast<sparse::gnu_sparse_header*>(block.data());
+    for (size_t i = 0; i < std::min<size_t>(4, segments.size()); ++i) {
+        put_entry(sparse_header.sp[i].offset, segments[i]);
+    }
+    sparse_header.isextended = segments.size() > 4 ? 1 : 0;
+    std::snprintf(sparse_header.realsize, 12, "%011llo", static_cast<unsigned long long>(real_size));
+    seal(block);
+    archive.insert(archive.end(), block.begin(), block.end());
+
+    for (size_t first = 4; first < segments.size(); first += 21) {
+        std::array<std::byte, 512> extension{};
+        auto& ext = *reinterpret_cast<sparse::gnu_sparse_extension*>(extension.data());
+        for (size_t i = first; i < std::min(first + 21, segments.size()); ++i) {
+            put_entry(ext.sp[i - first].offset, segments[i]);
+        }
+        ext.isextended = first + 21 < segments.size() ? 1 : 0;
+        archive.insert(archive.end(), extension.begin(), extension.end());
+    }
+
+    for (const auto& [offset, size] : segments) {
+        for (uint64_t b = 0; b < size; ++b) {
+            archive.push_back(static_cast<std::byte>((offset + b) % 251 + 1));
+        }
+    }
+    archive.resize((archive.size() + 511) / 512 * 512);
+
+    auto after = header("after.txt", '0', 2);
+    seal(after);
+    archive.insert(archive.end(), after.begin(), after.end());
+    archive.push_back(std::byte{'o'});
+    archive.push_back(std::byte{'k'});
+    archive.resize((archive.size() + 511) / 512 * 512 + 1024);
+    return archive;
+}
+
+} // anonymous namespace
+
 TEST_CASE("Sparse metadata operations", "[sparse]") {
     SECTION("find_segment") {
         sparse::sparse_metadata meta;
@@ -143,4 +256,297 @@ TEST_CASE("Sparse 1.0 data map parsing", "[sparse]") {
         CHECK(result->segments.empty());
         CHECK(result->real_size == 1000);
     }
-}
\ No newline at end of file
+}
+TEST_CASE("Sparse 1.0 maps are parsed block by block", "[sparse]") {
+    std::vector<sparse::sparse_entry> segments;
+    for (uint64_t i = 0; i < 300; ++i) {
+        segments.push_back({i * 1000000007ull, 1 + i % 5000});
+    }
+    const uint64_t real_size = 300 * 1000000007ull;
+    const std::string map = sparse_1_0_map(segments);
+    REQUIRE(map.size() > 512);
+
+    SECTION("A map over several blocks leaves the stream at the data") {
+        const std::string stored = map + "DATA";
+        memory_mapped_stream stream{std::span{reinterpret_cast<const std::byte*>(stored.data()), stored.size()}};
+
+        auto result = sparse::parse_sparse_1_0_data_map(stream, real_size);
+        REQUIRE(result.has_value());
+        REQUIRE(result->segments.size() == segments.size());
+        CHECK(result->segments[123].offset == segments[123].offset);
+        CHECK(result->segments[299].size == segments[299].size);
+        CHECK(stream.position() == map.size());
+    }
+
+    SECTION("Numbers may straddle blocks fed in any size") {
+        sparse::sparse_metadata target;
+        sparse::map_parser parser{&target, real_size};
+        const auto bytes = std::as_bytes(std::span{map});
+        size_t fed = 0;
+        for (const size_t step : {size_t{3}, size_t{100}, size_t{511}, size_t{7}}) {
+            auto done = parser.feed(bytes.subspan(fed, step));
+            REQUIRE(done.has_value());
+            CHECK_FALSE(*done);
+            fed += step;
+        }
+        auto done = parser.feed(bytes.subspan(fed));
+        REQUIRE(done.has_value());
+        CHECK(*done);
+        CHECK(parser.blocks() == 5);
+        CHECK(target.segments.size() == segments.size());
+        CHECK(target.segments.capacity() == segments.size());
+    }
+
+    SECTION("Checking a map without a target keeps no segments") {
+        sparse::map_parser parser{nullptr, real_size};
+        auto done = parser.feed(std::as_bytes(std::span{map}));
+        REQUIRE(done.has_value());
+        CHECK(*done);
+    }
+
+    SECTION("Malformed maps are rejected") {
+        const std::array<std::string, 4> bad{
+            "2\n0\n100\n50\n10\n",      // Overlaps the first segment
+            "1\n990\n20\n",               // Ends past the real size
+            "1\n0\nx\n",                  // Not a number
+            "99999999999999999999999\n"};  // Overflows
+        for (const auto& text : bad) {
+            sparse::map_parser parser{nullptr, 1000};
+            auto done = parser.feed(std::as_bytes(std::span{text}));
+            CHECK_FALSE(done.has_value());
+        }
+    }
+
+    SECTION("A map cut short is an error") {
+        const std::string cut = map.substr(0, 512);
+        memory_mapped_stream stream{std::span{reinterpret_cast<const std::byte*>(cut.data()), cut.size()}};
+        auto result = sparse::parse_sparse_1_0_data_map(stream, real_size);
+        REQUIRE_FALSE(result.has_value());
+        CHECK(result.error().code() == error_code::corrupt_archive);
+    }
+}
+
+TEST_CASE("Old GNU sparse headers with extension blocks", "[sparse]") {
+    // 4 segments in the header and 50 more over three extension blocks
+    std::vector<sparse::sparse_entry> segments;
+    for (uint64_t i = 0; i < 54; ++i) {
+        segments.push_back({i * 4096 + 1000, 10 + i});
+    }
+    const uint64_t real_size = 54 * 4096 + 8192;
+    const auto archive = old_sparse_archive(segments, real_size);
+
+    auto check_entries = [&](archive_reader& reader, bool through_views) {
+        auto entry = through_views ? reader.next_entry([](const entry_view&) { return true; }) : reader.next_entry();
+        REQUIRE(entry.has_value());
+        REQUIRE(entry->has_value());
+        const auto& sparse_info = (*entry)->metadata().sparse_info;
+        REQUIRE(sparse_info.has_value());
+        REQUIRE(sparse_info->segments.size() == segments.size());
+        CHECK(sparse_info->segments[53].offset == segments[53].offset);
+        CHECK((*entry)->size() == real_size);
+
+        auto data = (*entry)->read_data();
+        REQUIRE(data.has_value());
+        REQUIRE(data->size() == real_size);
+        for (const auto& [offset, size] : segments) {
+            CHECK((*data)[offset] == static_cast<std::byte>(offset % 251 + 1));
+            CHECK((*data)[offset + size] == std::byte{0});
+        }
+
+        auto after = reader.next_entry();
+        REQUIRE(after.has_value());
+        REQUIRE(after->has_value());
+        CHECK((*after)->path() == "after.txt");
+    };
+
+    SECTION("Streaming") {
+        archive_reader reader{std::make_unique<sequential_stream>(archive)};
+        check_entries(reader, false);
+    }
+
+    SECTION("Mapped, through views") {
+        archive_reader reader{std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive})};
+        check_entries(reader, true);
+    }
+
+    SECTION("Listing views walks past the map without decoding it") {
+        archive_reader reader{std::make_unique<sequential_stream>(archive)};
+        auto view = reader.next_entry_view();
+        REQUIRE(view.has_value());
+        REQUIRE(view->has_value());
+        CHECK((*view)->is_sparse());
+        CHECK((*view)->file_size() == real_size);
+
+        auto after = reader.next_entry_view();
+        REQUIRE(after.has_value());
+        REQUIRE(after->has_value());
+        CHECK((*after)->path() == "after.txt");
+        CHECK((*after)->file_size() == 2);
+    }
+}
+
+TEST_CASE("Sparse segment lookup", "[sparse]") {
+    // Many small segments with holes of varying size in between
+    sparse::sparse_metadata meta;
+    std::vector<std::byte> packed;
+    uint64_t logical = 0;
+    for (uint64_t i = 0; i < 5000; ++i) {
+        logical += (i % 3) * 7;  // Some segments are adjacent
+        const uint64_t size = 1 + i % 11;
+        meta.segments.push_back({logical, size});
+        for (uint64_t b = 0; b < size; ++b) {
+            packed.push_back(static_cast<std::byte>((logical + b) % 251 + 1));
+        }
+        logical += size;
+    }
+    meta.real_size = logical + 100;
+
+    std::vector<std::byte> expected(meta.real_size, std::byte{0});
+    for (const auto& seg : meta.segments) {
+        for (uint64_t b = 0; b < seg.size; ++b) {
+            expected[seg.offset + b] = static_cast<std::byte>((seg.offset + b) % 251 + 1);
+        }
+    }
+
+    SECTION("find_segment and data offsets with and without the index") {
+        auto indexed = meta;
+        indexed.index_segments();
+        CHECK(indexed.total_data_size() == packed.size());
+        for (const uint64_t offset : {uint64_t{0}, uint64_t{1}, uint64_t{777}, logical - 1, logical, logical + 50}) {
+            CHECK(meta.find_segment(offset) == indexed.find_segment(offset));
+            const bool is_data = expected.size() > offset && expected[offset] != std::byte{0};
+            CHECK(meta.find_segment(offset).has_value() == is_data);
+        }
+        CHECK(meta.data_offset_of(1234) == indexed.data_offset_of(1234));
+    }
+
+    SECTION("Sequential chunked reads") {
+        auto base = [&packed](size_t offset, std::span<std::byte> buffer) -> std::expected<size_t, error> {
+            const size_t n = std::min(buffer.size(), packed.size() - offset);
+            std::copy_n(packed.begin() + static_cast<std::ptrdiff_t>(offset), n, buffer.begin());
+            return n;
+        };
+        auto reader = sparse::make_sparse_read_into(meta, base);
+
+        std::vector<std::byte> content;
+        std::array<std::byte, 97> chunk{};
+        while (true) {
+            auto n = reader(content.size(), chunk);
+            REQUIRE(n.has_value());
+            if (*n == 0) break;
+            content.insert(content.end(), chunk.begin(), chunk.begin() + static_cast<std::ptrdiff_t>(*n));
+        }
+        CHECK(content == expected);
+
+        // Jumps around the file fall back to binary search
+        for (const size_t offset : {size_t{40000}, size_t{5}, size_t{20011}, size_t{0}}) {
+            auto n = reader(offset, chunk);
+            REQUIRE(n.has_value());
+            REQUIRE(*n == chunk.size());
+            CHECK(std::equal(chunk.begin(), chunk.end(), expected.begin() + static_cast<std::ptrdiff_t>(offset)));
+        }
+    }
+}
+
+TEST_CASE("Sparse run iteration", "[sparse]") {
+    // Leading hole, two segments, trailing hole
+    sparse::sparse_metadata meta;
+    meta.real_size = 1 << 20;
+    meta.segments = {{4096, 300000}, {700000, 5}, {1 << 20, 0}};
+
+    std::vector<std::byte> packed(meta.total_data_size());
+    for (size_t i = 0; i < packed.size(); ++i) {
+        packed[i] = static_cast<std::byte>(i % 249 + 1);
+    }
+
+    file_metadata file_meta;
+    file_meta.path = "disk.img";
+    file_meta.type = entry_type::regular_file;
+    file_meta.size = meta.real_size;
+    file_meta.sparse_info = meta;
+
+    auto collect = [](const archive_entry& entry) {
+        auto runs = entry.open_sparse_runs();
+        REQUIRE(runs.has_value());
+        std::vector<std::pair<sparse_run, std::vector<std::byte>>> result;
+        while (true) {
+            auto run = runs->next_run();
+            REQUIRE(run.has_value());
+            if (!*run) break;
+            result.emplace_back(**run, std::vector<std::byte>((*run)->data.begin(), (*run)->data.end()));
+        }
+        return result;
+    };
+
+    SECTION("Mapped entries yield whole segments in place") {
+        data_read_into_fn unused = [](size_t, std::span<std::byte>) -> std::expected<size_t, error> {
+            return std::unexpected(error{error_code::invalid_operation, "should not be read"});
+        };
+        archive_entry entry{file_meta, sparse::make_sparse_read_into(meta, unused), std::span<const std::byte>{packed}};
+
+        auto runs = entry.open_sparse_runs();
+        REQUIRE(runs.has_value());
+        const std::array<std::tuple<uint64_t, uint64_t, bool>, 5> expected_runs{{
+            {0, 4096, true}, {4096, 300000, false}, {304096, 395904, true},
+            {700000, 5, false}, {700005, (1 << 20) - 700005, true}}};
+        for (const auto& [offset, length, hole] : expected_runs) {
+            auto run = runs->next_run();
+            REQUIRE(run.has_value());
+            REQUIRE(run->has_value());
+            CHECK((*run)->offset == offset);
+            CHECK((*run)->length == length);
+            CHECK((*run)->is_hole() == hole);
+        }
+        auto end = runs->next_run();
+        REQUIRE(end.has_value());
+        CHECK_FALSE(end->has_value());
+
+        // Data runs point straight into the stored data
+        auto again = entry.open_sparse_runs();
+        (void)again->next_run();
+        auto data_run = again->next_run();
+        CHECK((*data_run)->data.data() == packed.data());
+        CHECK((*data_run)->data.size() == 300000);
+    }
+
+    SECTION("Streamed entries yield segments in bounded chunks") {
+        data_read_into_fn stored = [&packed](size_t offset, std::span<std::byte> buffer) -> std::expected<size_t, error> {
+            const size_t n = std::min(buffer.size(), packed.size() - std::min(offset, packed.size()));
+            std::copy_n(packed.begin() + static_cast<std::ptrdiff_t>(offset), n, buffer.begin());
+            return n;
+        };
+        archive_entry entry{file_meta, sparse::make_sparse_read_into(meta, stored)};
+
+        std::vector<std::byte> data;
+        uint64_t holes = 0;
+        uint64_t position = 0;
+        for (const auto& [run, bytes] : collect(entry)) {
+            CHECK(run.offset == position);
+            position += run.length;
+            if (run.is_hole()) {
+                CHECK(run.data.empty());
+                holes += run.length;
+            } else {
+                CHECK(run.length <= default_chunk_size);
+                data.insert(data.end(), bytes.begin(), bytes.end());
+            }
+        }
+        CHECK(position == meta.real_size);
+        CHECK(holes == meta.real_size - packed.size());
+        CHECK(data == packed);
+    }
+
+    SECTION("Entries without a sparse map are a single data run") {
+        file_metadata plain;
+        plain.path = "plain.bin";
+        plain.type = entry_type::regular_file;
+        plain.size = 1000;
+        archive_entry entry{plain, std::span<const std::byte>{packed}.first(1000)};
+
+        auto runs = collect(entry);
+        REQUIRE(runs.size() == 1);
+        CHECK_FALSE(runs[0].first.is_hole());
+        CHECK(runs[0].first.data.data() == packed.data());
+        CHECK(runs[0].first.length == 1000);
+    }
+}
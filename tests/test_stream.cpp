@@ -17,6 +17,9 @@
 #include <catch2/catch_test_macros.hpp>
 #include <catch2/matchers/catch_matchers_string.hpp>
 #include <tierone/tar/stream.hpp>
+#include <tierone/tar/push_stream.hpp>
+#include <tierone/tar/archive_reader.hpp>
+#include <tierone/tar/archive_writer.hpp>
 #include <tierone/tar/error.hpp>
 #include <filesystem>
 #include <fstream>
@@ -24,6 +27,11 @@
 #include <array>
 #include <random>
 #include <thread>
+#include <cstring>
+
+#ifdef __linux__
+#include <unistd.h>
+#endif
 
 using namespace tierone::tar;
 namespace fs = std::filesystem;
@@ -506,7 +514,7 @@ TEST_CASE("mmap_stream large file", "[unit][stream][linux]") {
     }
     
     SECTION("Sequential access pattern") {
-        // The implementation uses MADV_SEQUENTIAL
+        // The default pattern is access_pattern::sequential
         // Read sequentially through the file
         size_t total_read = 0;
         std::array<std::byte, 4096> buffer{};
@@ -524,6 +532,464 @@ TEST_CASE("mmap_stream large file", "[unit][stream][linux]") {
         CHECK(total_read == file_size);
     }
 }
+
+TEST_CASE("mmap_stream access patterns", "[unit][stream][linux]") {
+    TempFile temp_file;
+    const size_t file_size = 3 * 1024 * 1024 + 77;
+    auto test_data = create_test_data(file_size);
+    temp_file.write(test_data);
+
+    // Reads come back the same whatever the kernel was told
+    auto check_reads = [&](mmap_stream& stream) {
+        std::array<std::byte, 4096> buffer{};
+        for (size_t offset : {size_t{0}, file_size - 100, size_t{1024 * 1024 + 5}, size_t{17}}) {
+            REQUIRE(stream.seek(offset).has_value());
+            auto result = stream.read(buffer);
+            REQUIRE(result.has_value());
+            CHECK(*result == std::min(buffer.size(), file_size - offset));
+            CHECK(std::memcmp(buffer.data(), test_data.data() + offset, *result) == 0);
+        }
+        stream.will_need(file_size - 10, 1000);
+        stream.will_need(file_size + 10, 1000);
+    };
+
+    SECTION("Sequential with release behind") {
+        auto stream = mmap_stream::create(temp_file.path(),
+            {.pattern = access_pattern::sequential, .window = 256 * 1024, .release_behind = true});
+        REQUIRE(stream.has_value());
+        CHECK(stream->options().release_behind);
+
+        // A full pass drops pages behind the window, which fault back in on seek
+        std::vector<std::byte> copy(file_size);
+        size_t filled = 0;
+        while (!stream->at_end()) {
+            auto result = stream->read(std::span{copy}.subspan(filled, std::min<size_t>(5000, file_size - filled)));
+            REQUIRE(result.has_value());
+            filled += *result;
+        }
+        CHECK(filled == file_size);
+        CHECK(copy == test_data);
+        check_reads(*stream);
+    }
+
+    SECTION("Random with populate") {
+        auto stream = mmap_stream::create(temp_file.path(),
+            {.pattern = access_pattern::random, .populate = true, .huge_pages = true});
+        REQUIRE(stream.has_value());
+        check_reads(*stream);
+    }
+
+    SECTION("Normal") {
+        auto stream = mmap_stream::create(temp_file.path(), {.pattern = access_pattern::normal});
+        REQUIRE(stream.has_value());
+        check_reads(*stream);
+    }
+}
+
+TEST_CASE("windowed_mmap_stream slides its window", "[unit][stream][linux]") {
+    TempFile temp_file;
+    const size_t file_size = 5 * 4096 + 123;
+    auto test_data = create_test_data(file_size);
+    temp_file.write(test_data);
+
+    // One page per window, so most operations cross a window
+    auto stream_result = windowed_mmap_stream::open(temp_file.path(), 1);
+    REQUIRE(stream_result.has_value());
+    auto& stream = stream_result.value();
+    CHECK(stream.window_size() == static_cast<size_t>(::sysconf(_SC_PAGESIZE)));
+    CHECK(stream.size() == file_size);
+
+    SECTION("Sequential reads") {
+        std::vector<std::byte> copy(file_size);
+        size_t filled = 0;
+        while (!stream.at_end()) {
+            auto result = stream.read(std::span{copy}.subspan(filled, std::min<size_t>(1000, file_size - filled)));
+            REQUIRE(result.has_value());
+            REQUIRE(*result > 0);
+            filled += *result;
+        }
+        CHECK(copy == test_data);
+        CHECK(stream.read(std::span{copy}.first(10)).value() == 0);
+    }
+
+    SECTION("Peek across a window boundary") {
+        REQUIRE(stream.seek(stream.window_size() - 100).has_value());
+        auto view = stream.peek(1000);
+        REQUIRE(view.has_value());
+        REQUIRE(view->size() == 1000);
+        CHECK(std::memcmp(view->data(), test_data.data() + stream.window_size() - 100, 1000) == 0);
+
+        // Shorter only at the end of the stream
+        REQUIRE(stream.seek(file_size - 10).has_value());
+        CHECK(stream.peek(512).value().size() == 10);
+    }
+
+    SECTION("Seek backwards and skip") {
+        std::array<std::byte, 64> buffer{};
+        REQUIRE(stream.seek(4 * 4096 + 7).has_value());
+        REQUIRE(stream.read(buffer).has_value());
+        REQUIRE(stream.seek(3).has_value());
+        REQUIRE(stream.skip(5000).has_value());
+        CHECK(stream.position() == 5003);
+        REQUIRE(stream.read(buffer).value() == buffer.size());
+        CHECK(std::memcmp(buffer.data(), test_data.data() + 5003, buffer.size()) == 0);
+        CHECK_FALSE(stream.skip(file_size).has_value());
+        CHECK_FALSE(stream.seek(file_size + 1).has_value());
+    }
+
+    SECTION("Archive reader on top") {
+        std::vector<std::byte> archive;
+        {
+            archive_writer writer{std::make_unique<memory_output_stream>(archive)};
+            file_metadata meta;
+            meta.path = "data.bin";
+            meta.type = entry_type::regular_file;
+            meta.permissions = fs::perms{0644};
+            meta.size = test_data.size();
+            REQUIRE(writer.add_entry(meta, test_data).has_value());
+            meta.path = "second.bin";
+            meta.size = 100;
+            REQUIRE(writer.add_entry(meta, std::span{test_data}.first(100)).has_value());
+            REQUIRE(writer.finish().has_value());
+        }
+        temp_file.write(archive);
+        auto windowed = windowed_mmap_stream::open(temp_file.path(), 4096);
+        REQUIRE(windowed.has_value());
+
+        archive_reader reader{std::make_unique<windowed_mmap_stream>(std::move(*windowed))};
+        std::vector<std::string> names;
+        for (const auto& entry : reader) {
+            names.push_back(entry.path().string());
+            std::vector<std::byte> content(entry.size());
+            REQUIRE(entry.read_into(0, content).value() == content.size());
+            CHECK(std::equal(content.begin(), content.end(), test_data.begin()));
+        }
+        CHECK(names == std::vector<std::string>{"data.bin", "second.bin"});
+    }
+}
+
+TEST_CASE("streams position past 4 GiB", "[unit][stream][linux]") {
+    // Sparse file, no disk space is used for the hole
+    TempFile temp_file;
+    const uint64_t marker_offset = (uint64_t{9} << 29) + 5;  // 4.5 GiB and a bit
+    {
+        std::ofstream file(temp_file.path(), std::ios::binary);
+    }
+    fs::resize_file(temp_file.path(), marker_offset + 4);
+    {
+        std::fstream file(temp_file.path(), std::ios::binary | std::ios::in | std::ios::out);
+        file.seekp(static_cast<std::streamoff>(marker_offset));
+        file.write("mark", 4);
+    }
+
+    auto check_marker = [&](random_access_stream& stream) {
+        CHECK(stream.size() == marker_offset + 4);
+        REQUIRE(stream.seek(marker_offset - 2).has_value());
+        CHECK(stream.position() == marker_offset - 2);
+        std::array<std::byte, 8> buffer{};
+        REQUIRE(stream.read(buffer).value() == 6);
+        CHECK(std::memcmp(buffer.data() + 2, "mark", 4) == 0);
+        CHECK(stream.at_end());
+
+        REQUIRE(stream.seek(0).has_value());
+        REQUIRE(stream.skip(marker_offset).has_value());
+        CHECK(stream.position() == marker_offset);
+    };
+
+    SECTION("file_stream") {
+        auto stream = file_stream::open(temp_file.path());
+        REQUIRE(stream.has_value());
+        check_marker(*stream);
+    }
+
+    SECTION("fd_stream") {
+        auto stream = fd_stream::open(temp_file.path(), 4096);
+        REQUIRE(stream.has_value());
+        check_marker(*stream);
+    }
+
+    SECTION("windowed_mmap_stream") {
+        auto stream = windowed_mmap_stream::open(temp_file.path(), 1024 * 1024);
+        REQUIRE(stream.has_value());
+        check_marker(*stream);
+    }
+}
+
+TEST_CASE("fd_stream buffered reads", "[unit][stream][linux]") {
+    TempFile temp_file;
+    const size_t file_size = 64 * 1024 + 123;
+    auto test_data = create_test_data(file_size);
+    temp_file.write(test_data);
+    
+    // A small buffer so the tests cross refill boundaries
+    auto stream_result = fd_stream::open(temp_file.path(), 4096);
+    REQUIRE(stream_result.has_value());
+    auto& stream = stream_result.value();
+    
+    SECTION("Initial state") {
+        CHECK_FALSE(stream.at_end());
+        CHECK(stream.position() == 0);
+        CHECK(stream.size().value() == file_size);
+    }
+    
+    SECTION("Block reads across refills") {
+        std::vector<std::byte> content;
+        std::array<std::byte, 512> block{};
+        while (!stream.at_end()) {
+            auto result = stream.read(block);
+            REQUIRE(result.has_value());
+            REQUIRE(*result > 0);
+            content.insert(content.end(), block.begin(), block.begin() + static_cast<std::ptrdiff_t>(*result));
+        }
+        CHECK(content == test_data);
+        CHECK(stream.position() == file_size);
+    }
+    
+    SECTION("Reads larger than the buffer bypass it") {
+        std::array<std::byte, 10> head{};
+        REQUIRE(stream.read(head).value() == 10);
+        
+        std::vector<std::byte> big(20000);
+        auto result = stream.read(big);
+        REQUIRE(result.has_value());
+        CHECK(*result == big.size());
+        CHECK(std::memcmp(big.data(), test_data.data() + 10, big.size()) == 0);
+        CHECK(stream.position() == 10 + big.size());
+    }
+    
+    SECTION("Skips and seeks within and beyond the buffer") {
+        std::array<std::byte, 16> buffer{};
+        REQUIRE(stream.read(buffer).value() == 16);
+        
+        CHECK(stream.skip(1000).has_value());
+        CHECK(stream.position() == 1016);
+        REQUIRE(stream.read(buffer).value() == 16);
+        CHECK(std::memcmp(buffer.data(), test_data.data() + 1016, 16) == 0);
+        
+        CHECK(stream.seek(50000).has_value());
+        REQUIRE(stream.read(buffer).value() == 16);
+        CHECK(std::memcmp(buffer.data(), test_data.data() + 50000, 16) == 0);
+        
+        CHECK(stream.seek(3).has_value());
+        REQUIRE(stream.read(buffer).value() == 16);
+        CHECK(std::memcmp(buffer.data(), test_data.data() + 3, 16) == 0);
+    }
+    
+    SECTION("Bounds") {
+        CHECK_FALSE(stream.seek(file_size + 1).has_value());
+        CHECK(stream.seek(file_size - 4).has_value());
+        CHECK_FALSE(stream.skip(5).has_value());
+        
+        std::array<std::byte, 16> buffer{};
+        CHECK(stream.read(buffer).value() == 4);
+        CHECK(stream.at_end());
+        CHECK(stream.read(buffer).value() == 0);
+    }
+}
+
+TEST_CASE("fd_stream error handling", "[unit][stream][linux]") {
+    SECTION("Non-existent file") {
+        auto result = fd_stream::open("/non/existent/file");
+        REQUIRE_FALSE(result.has_value());
+        CHECK(result.error().code() == error_code::io_error);
+    }
+    
+    SECTION("Directories are not regular files") {
+        auto result = fd_stream::open(std::filesystem::temp_directory_path());
+        REQUIRE_FALSE(result.has_value());
+        CHECK(result.error().code() == error_code::unsupported_feature);
+    }
+    
+    SECTION("Empty file") {
+        TempFile temp_file;
+        temp_file.write("");
+        
+        auto stream_result = fd_stream::open(temp_file.path());
+        REQUIRE(stream_result.has_value());
+        CHECK(stream_result->at_end());
+        
+        std::array<std::byte, 16> buffer{};
+        CHECK(stream_result->read(buffer).value() == 0);
+    }
+}
+
+TEST_CASE("uring_stream prefetched reads", "[unit][stream][linux]") {
+    TempFile temp_file;
+    const size_t file_size = 64 * 1024 + 123;
+    auto test_data = create_test_data(file_size);
+    temp_file.write(test_data);
+
+    // Page-sized reads so the tests cross many chunks
+    auto stream_result = uring_stream::open(temp_file.path(), {.queue_depth = 3, .read_size = 4096});
+    if (!stream_result && stream_result.error().code() == error_code::unsupported_feature) {
+        SKIP("io_uring not available");
+    }
+    REQUIRE(stream_result.has_value());
+    auto& stream = stream_result.value();
+    CHECK(stream.size().value() == file_size);
+
+    SECTION("Block reads across chunks") {
+        std::vector<std::byte> content;
+        std::array<std::byte, 1000> block{};
+        while (!stream.at_end()) {
+            auto result = stream.read(block);
+            REQUIRE(result.has_value());
+            REQUIRE(*result > 0);
+            content.insert(content.end(), block.begin(), block.begin() + static_cast<std::ptrdiff_t>(*result));
+        }
+        CHECK(content == test_data);
+        CHECK(stream.read(block).value() == 0);
+    }
+
+    SECTION("Peeks across a chunk boundary") {
+        REQUIRE(stream.seek(4000).has_value());
+        auto view = stream.peek(512);
+        REQUIRE(view.has_value());
+        REQUIRE(view->size() == 512);
+        CHECK(std::memcmp(view->data(), test_data.data() + 4000, 512) == 0);
+        CHECK(stream.position() == 4000);
+    }
+
+    SECTION("Skips within and beyond the prefetched window") {
+        std::array<std::byte, 16> buffer{};
+        REQUIRE(stream.read(buffer).value() == 16);
+
+        CHECK(stream.skip(5000).has_value());
+        REQUIRE(stream.read(buffer).value() == 16);
+        CHECK(std::memcmp(buffer.data(), test_data.data() + 5016, 16) == 0);
+
+        CHECK(stream.skip(40000).has_value());
+        REQUIRE(stream.read(buffer).value() == 16);
+        CHECK(std::memcmp(buffer.data(), test_data.data() + 45032, 16) == 0);
+
+        CHECK(stream.seek(3).has_value());
+        REQUIRE(stream.read(buffer).value() == 16);
+        CHECK(std::memcmp(buffer.data(), test_data.data() + 3, 16) == 0);
+    }
+
+    SECTION("Bounds") {
+        CHECK_FALSE(stream.seek(file_size + 1).has_value());
+        CHECK(stream.seek(file_size - 4).has_value());
+        CHECK_FALSE(stream.skip(5).has_value());
+
+        std::array<std::byte, 16> buffer{};
+        CHECK(stream.read(buffer).value() == 4);
+        CHECK(stream.at_end());
+    }
+}
+
+TEST_CASE("uring_stream error handling", "[unit][stream][linux]") {
+    SECTION("Non-existent file") {
+        auto result = uring_stream::open("/non/existent/file");
+        REQUIRE_FALSE(result.has_value());
+        if (result.error().code() == error_code::unsupported_feature) {
+            SKIP("io_uring not available");
+        }
+        CHECK(result.error().code() == error_code::io_error);
+    }
+
+    SECTION("Directories are not regular files") {
+        auto result = uring_stream::open(std::filesystem::temp_directory_path());
+        REQUIRE_FALSE(result.has_value());
+        CHECK(result.error().code() == error_code::unsupported_feature);
+    }
+}
+#endif
+
+TEST_CASE("read_ahead_stream over a short-read source", "[unit][stream]") {
+    // Hands out at most 100 bytes per read, like a pipe
+    class trickle_stream : public input_stream {
+        std::vector<std::byte> data_;
+        size_t position_ = 0;
+    public:
+        size_t reads = 0;
+        size_t skips = 0;
+        explicit trickle_stream(std::vector<std::byte> data) : data_(std::move(data)) {}
+        std::expected<size_t, error> read(std::span<std::byte> buffer) override {
+            ++reads;
+            const size_t n = std::min({buffer.size(), size_t{100}, data_.size() - position_});
+            std::memcpy(buffer.data(), data_.data() + position_, n);
+            position_ += n;
+            return n;
+        }
+        std::expected<void, error> skip(uint64_t bytes) override {
+            ++skips;
+            if (position_ + bytes > data_.size()) {
+                return std::unexpected(error{error_code::io_error, "Skip past end of stream"});
+            }
+            position_ += bytes;
+            return {};
+        }
+        bool at_end() const override { return position_ >= data_.size(); }
+    };
+    
+    auto test_data = create_test_data(5000);
+    auto source = std::make_unique<trickle_stream>(test_data);
+    auto* raw_source = source.get();
+    read_ahead_stream stream{std::move(source), 2048};
+    
+    SECTION("Peek gathers full blocks") {
+        CHECK(stream.can_peek());
+        auto view = stream.peek(512);
+        REQUIRE(view.has_value());
+        REQUIRE(view->size() == 512);
+        CHECK(std::memcmp(view->data(), test_data.data(), 512) == 0);
+        
+        // Skipping inside the window keeps the view and never reaches the source
+        CHECK(stream.skip(512).has_value());
+        CHECK(raw_source->skips == 0);
+        CHECK(std::memcmp(view->data(), test_data.data(), 512) == 0);
+        
+        auto next = stream.peek(512);
+        REQUIRE(next.has_value());
+        CHECK(std::memcmp(next->data(), test_data.data() + 512, 512) == 0);
+    }
+    
+    SECTION("Reads, skips and end of stream") {
+        std::vector<std::byte> content;
+        std::array<std::byte, 300> buffer{};
+        CHECK(stream.skip(3000).has_value());
+        while (!stream.at_end()) {
+            auto result = stream.read(buffer);
+            REQUIRE(result.has_value());
+            REQUIRE(*result > 0);
+            content.insert(content.end(), buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(*result));
+        }
+        CHECK(content.size() == 2000);
+        CHECK(std::memcmp(content.data(), test_data.data() + 3000, 2000) == 0);
+        
+        auto view = stream.peek(512);
+        REQUIRE(view.has_value());
+        CHECK(view->empty());
+    }
+}
+
+#ifdef __linux__
+TEST_CASE("fd_stream peek", "[unit][stream][linux]") {
+    TempFile temp_file;
+    auto test_data = create_test_data(10000);
+    temp_file.write(test_data);
+    
+    auto stream_result = fd_stream::open(temp_file.path(), 4096);
+    REQUIRE(stream_result.has_value());
+    auto& stream = stream_result.value();
+    
+    // Straddle the end of the first buffer fill
+    CHECK(stream.seek(10).has_value());
+    std::array<std::byte, 3900> head{};
+    REQUIRE(stream.read(head).value() == head.size());
+    
+    auto view = stream.peek(512);
+    REQUIRE(view.has_value());
+    REQUIRE(view->size() == 512);
+    CHECK(std::memcmp(view->data(), test_data.data() + 3910, 512) == 0);
+    CHECK(stream.position() == 3910);
+    
+    CHECK(stream.seek(9800).has_value());
+    auto tail = stream.peek(512);
+    REQUIRE(tail.has_value());
+    CHECK(tail->size() == 200);
+}
 #endif
 
 TEST_CASE("Stream polymorphic usage", "[unit][stream]") {
@@ -581,4 +1047,232 @@ TEST_CASE("Stream concurrent access patterns", "[unit][stream]") {
         
         CHECK(stream.position() == 1000);
     }
-}
\ No newline at end of file
+}
+#ifdef __linux__
+TEST_CASE("fd_output_stream copies file ranges in the kernel", "[unit][stream][linux]") {
+    TempFile source;
+    auto test_data = create_test_data(20000);
+    source.write(test_data);
+    auto input = fd_stream::open(source.path());
+    REQUIRE(input.has_value());
+
+    SECTION("Into a file") {
+        TempFile target;
+        {
+            auto output = fd_output_stream::create(target.path());
+            REQUIRE(output.has_value());
+            auto header = create_test_data(100, std::byte{0x11});
+            REQUIRE(output->write(header).has_value());
+            auto copied = output->copy_from_file(input->native_handle(), 1000, 15000);
+            REQUIRE(copied.has_value());
+            CHECK(*copied);
+        }
+
+        std::ifstream file(target.path(), std::ios::binary);
+        std::vector<char> written{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+        REQUIRE(written.size() == 15100);
+        CHECK(std::memcmp(written.data() + 100, test_data.data() + 1000, 15000) == 0);
+    }
+
+    SECTION("Into a pipe") {
+        std::array<int, 2> fds{};
+        REQUIRE(::pipe(fds.data()) == 0);
+        auto output = fd_output_stream::borrow(fds[1]);
+        auto copied = output.copy_from_file(input->native_handle(), 0, 4096);
+        REQUIRE(copied.has_value());
+        CHECK(*copied);
+
+        std::array<std::byte, 4096> received{};
+        size_t total = 0;
+        while (total < received.size()) {
+            const ssize_t n = ::read(fds[0], received.data() + total, received.size() - total);
+            REQUIRE(n > 0);
+            total += static_cast<size_t>(n);
+        }
+        CHECK(std::memcmp(received.data(), test_data.data(), received.size()) == 0);
+        ::close(fds[0]);
+        ::close(fds[1]);
+    }
+
+    SECTION("Past the end of the source") {
+        TempFile target;
+        auto output = fd_output_stream::create(target.path());
+        REQUIRE(output.has_value());
+        auto copied = output->copy_from_file(input->native_handle(), 19000, 2000);
+        REQUIRE_FALSE(copied.has_value());
+        CHECK(copied.error().code() == error_code::io_error);
+    }
+}
+#endif
+
+TEST_CASE("push_stream delivers pushed data with backpressure", "[unit][stream][push]") {
+    std::vector<std::byte> data(300000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<std::byte>((i * 7) & 0xFF);
+    }
+
+    // A ring much smaller than the data keeps the producer waiting on the reader
+    auto [stream, feeder] = push_stream::create(4096);
+    std::thread producer([&data, feeder = std::move(feeder)]() mutable {
+        for (size_t offset = 0; offset < data.size(); offset += 1000) {
+            const size_t n = std::min<size_t>(1000, data.size() - offset);
+            if (!feeder.push(std::span{data}.subspan(offset, n))) return;
+        }
+        feeder.finish();
+    });
+
+    std::vector<std::byte> received;
+    std::vector<std::byte> buffer(3000);
+    while (true) {
+        auto peeked = stream.peek(512);
+        REQUIRE(peeked.has_value());
+        if (peeked->empty()) break;
+        CHECK(std::memcmp(peeked->data(), data.data() + received.size(), peeked->size()) == 0);
+
+        auto n = stream.read(buffer);
+        REQUIRE(n.has_value());
+        // Reads fill the buffer unless the stream ends
+        CHECK((*n == buffer.size() || received.size() + *n == data.size()));
+        received.insert(received.end(), buffer.begin(), buffer.begin() + static_cast<std::ptrdiff_t>(*n));
+    }
+    producer.join();
+
+    CHECK(stream.at_end());
+    CHECK(received == data);
+}
+
+TEST_CASE("push_stream skip discards without buffering", "[unit][stream][push]") {
+    auto [stream, feeder] = push_stream::create(1024);
+    std::vector<std::byte> data(10000);
+    for (size_t i = 0; i < data.size(); ++i) {
+        data[i] = static_cast<std::byte>(i & 0xFF);
+    }
+
+    SECTION("Skipped bytes are dropped as they arrive") {
+        // The skip is far beyond the ring, yet returns before any data is pushed
+        REQUIRE(stream.skip(9000).has_value());
+        auto taken = feeder.try_push(data);
+        REQUIRE(taken.has_value());
+        CHECK(*taken == data.size());
+        feeder.finish();
+
+        std::array<std::byte, 1000> tail{};
+        auto n = stream.read(tail);
+        REQUIRE(n.has_value());
+        CHECK(*n == 1000);
+        CHECK(std::memcmp(tail.data(), data.data() + 9000, 1000) == 0);
+        CHECK(stream.at_end());
+    }
+
+    SECTION("A peek view survives skipping within it") {
+        REQUIRE(feeder.try_push(std::span{data}.first(1024)).has_value());
+        auto view = stream.peek(512);
+        REQUIRE(view.has_value());
+        REQUIRE(view->size() == 512);
+        REQUIRE(stream.skip(512).has_value());
+
+        // The space behind the view stays reserved until the next peek or read
+        auto taken = feeder.try_push(std::span{data}.subspan(1024, 1024));
+        REQUIRE(taken.has_value());
+        CHECK(*taken == 0);
+        CHECK(std::memcmp(view->data(), data.data(), 512) == 0);
+
+        bool writable = false;
+        feeder.when_writable([&writable] { writable = true; });
+        auto next = stream.peek(512);
+        REQUIRE(next.has_value());
+        CHECK(writable);
+        CHECK(std::memcmp(next->data(), data.data() + 512, 512) == 0);
+    }
+
+    SECTION("Skipping past the end fails") {
+        REQUIRE(feeder.try_push(std::span{data}.first(100)).has_value());
+        REQUIRE(stream.skip(50).has_value());
+        feeder.finish();
+        auto skipped = stream.skip(200);
+        REQUIRE_FALSE(skipped.has_value());
+        CHECK(skipped.error().code() == error_code::io_error);
+    }
+}
+
+TEST_CASE("push_stream reports producer failures", "[unit][stream][push]") {
+    std::array<std::byte, 16> bytes{};
+    std::array<std::byte, 64> buffer{};
+
+    SECTION("Explicit failure after the buffered data") {
+        auto [stream, feeder] = push_stream::create(1024);
+        REQUIRE(feeder.push(bytes).has_value());
+        feeder.fail(error{error_code::io_error, "connection reset"});
+
+        auto first = stream.read(buffer);
+        REQUIRE(first.has_value());
+        CHECK(*first == bytes.size());
+        auto second = stream.read(buffer);
+        REQUIRE_FALSE(second.has_value());
+        CHECK(second.error().message() == "connection reset");
+        CHECK_FALSE(stream.at_end());
+    }
+
+    SECTION("Feeder dropped without finish()") {
+        auto [stream, feeder] = push_stream::create(1024);
+        { auto gone = std::move(feeder); }
+        REQUIRE_FALSE(stream.read(buffer).has_value());
+    }
+
+    SECTION("Reader gone") {
+        auto created = push_stream::create(1024);
+        auto feeder = std::move(created.second);
+        { auto gone = std::move(created.first); }
+        auto pushed = feeder.push(bytes);
+        REQUIRE_FALSE(pushed.has_value());
+        CHECK(pushed.error().code() == error_code::invalid_operation);
+    }
+}
+
+TEST_CASE("archive_reader unpacks an archive while it is pushed", "[unit][stream][push]") {
+    std::vector<std::byte> archive;
+    {
+        archive_writer writer{std::make_unique<memory_output_stream>(archive)};
+        for (int i = 0; i < 20; ++i) {
+            file_metadata meta;
+            meta.path = std::string(120, 'd') + "/file-" + std::to_string(i);  // PAX path records
+            meta.type = entry_type::regular_file;
+            meta.permissions = fs::perms{0644};
+            meta.size = static_cast<uint64_t>(i) * 5000;
+            std::vector<std::byte> content(meta.size, static_cast<std::byte>(i));
+            REQUIRE(writer.add_entry(meta, content).has_value());
+        }
+        REQUIRE(writer.finish().has_value());
+    }
+
+    auto [stream, feeder] = push_stream::create(16 * 1024);
+    std::thread producer([&archive, feeder = std::move(feeder)]() mutable {
+        // Uneven chunks, like network reads
+        size_t offset = 0;
+        for (size_t chunk = 1; offset < archive.size(); chunk = chunk * 3 % 7919 + 1) {
+            const size_t n = std::min(chunk, archive.size() - offset);
+            if (!feeder.push(std::span{archive}.subspan(offset, n))) return;
+            offset += n;
+        }
+        feeder.finish();
+    });
+
+    archive_reader reader{std::make_unique<push_stream>(std::move(stream))};
+    int count = 0;
+    while (true) {
+        auto entry = reader.next_entry();
+        REQUIRE(entry.has_value());
+        if (!*entry) break;
+        CHECK((*entry)->path().filename() == "file-" + std::to_string(count));
+        // Read every other entry, skip the rest
+        if (count % 2 == 0) {
+            auto data = (*entry)->read_data();
+            REQUIRE(data.has_value());
+            CHECK(data->size() == static_cast<size_t>(count) * 5000);
+            CHECK(std::ranges::all_of(*data, [&](std::byte b) { return b == static_cast<std::byte>(count); }));
+        }
+        ++count;
+    }
+    producer.join();
+    CHECK(count == 20);
+}
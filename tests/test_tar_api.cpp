@@ -144,7 +144,7 @@ public:
         return to_read;
     }
     
-    std::expected<void, error> skip(size_t bytes) override {
+    std::expected<void, error> skip(uint64_t bytes) override {
         if (fail_skip_) {
             return std::unexpected(error{error_code::io_error, "Mock skip failure"});
         }
@@ -185,6 +185,49 @@ TEST_CASE("open_archive from filesystem path", "[unit][tar_api]") {
         CHECK(entry.is_regular_file());
     }
     
+    SECTION("Mapped mode returns zero-copy spans") {
+        TempFile temp_file;
+        temp_file.write_tar_data(create_minimal_tar());
+        
+        auto result = open_archive(temp_file.path(), access_mode::mapped);
+        REQUIRE(result.has_value());
+        CHECK(result->is_mapped());
+        
+        auto entry = result->next_entry();
+        REQUIRE(entry.has_value());
+        REQUIRE(entry->has_value());
+        CHECK((*entry)->path() == "test.txt");
+        
+        auto first = (*entry)->read_data();
+        REQUIRE(first.has_value());
+        REQUIRE(first->size() == 5);
+        CHECK(std::memcmp(first->data(), "Hello", 5) == 0);
+        
+        // Offset reads are pointer arithmetic into the same mapping
+        auto tail = (*entry)->read_data(3, 2);
+        REQUIRE(tail.has_value());
+        CHECK(tail->data() == first->data() + 3);
+        CHECK(std::memcmp(tail->data(), "lo", 2) == 0);
+    }
+    
+    SECTION("Prefetch mode reads through io_uring or falls back to streaming") {
+        TempFile temp_file;
+        temp_file.write_tar_data(create_minimal_tar());
+
+        auto result = open_archive(temp_file.path(), access_mode::prefetch);
+        REQUIRE(result.has_value());
+        CHECK_FALSE(result->is_mapped());
+
+        auto entry = result->next_entry();
+        REQUIRE(entry.has_value());
+        REQUIRE(entry->has_value());
+        CHECK((*entry)->path() == "test.txt");
+        auto data = (*entry)->read_data();
+        REQUIRE(data.has_value());
+        REQUIRE(data->size() == 5);
+        CHECK(std::memcmp(data->data(), "Hello", 5) == 0);
+    }
+    
     SECTION("Non-existent file") {
         auto result = open_archive("/non/existent/file.tar");
         
@@ -301,6 +344,176 @@ TEST_CASE("open_archive from input stream", "[unit][tar_api]") {
         CHECK(entry.size() == 5);
     }
     
+    SECTION("Memory-backed stream hands out spans into the buffer") {
+        auto tar_data = create_minimal_tar();
+        std::vector<std::byte> bytes(tar_data.size());
+        std::memcpy(bytes.data(), tar_data.data(), tar_data.size());
+        
+        auto result = open_archive(std::make_unique<memory_mapped_stream>(std::span<const std::byte>{bytes}));
+        REQUIRE(result.has_value());
+        CHECK(result->is_mapped());
+        
+        auto entry = result->next_entry();
+        REQUIRE(entry.has_value());
+        REQUIRE(entry->has_value());
+        
+        auto data = (*entry)->read_data();
+        REQUIRE(data.has_value());
+        CHECK(data->data() == bytes.data() + 512);
+        CHECK(data->size() == 5);
+    }
+    
+    SECTION("Chunked read from stream") {
+        auto tar_data = create_minimal_tar();
+        auto result = open_archive(std::make_unique<mock_stream>(tar_data));
+        REQUIRE(result.has_value());
+        
+        auto entry = result->next_entry();
+        REQUIRE(entry.has_value());
+        REQUIRE(entry->has_value());
+        
+        auto reader = (*entry)->open_reader();
+        REQUIRE(reader.has_value());
+        
+        std::string content;
+        std::array<std::byte, 2> buffer{};
+        while (true) {
+            auto chunk = reader->read_some(buffer);
+            REQUIRE(chunk.has_value());
+            if (*chunk == 0) break;
+            for (size_t i = 0; i < *chunk; ++i) {
+                content.push_back(static_cast<char>(buffer[i]));
+            }
+        }
+        CHECK(content == "Hello");
+        
+        // The next entry is the end of the archive
+        auto next = result->next_entry();
+        REQUIRE(next.has_value());
+        CHECK_FALSE(next->has_value());
+    }
+    
+    SECTION("Forward offset read from stream") {
+        auto tar_data = create_minimal_tar();
+        auto result = open_archive(std::make_unique<mock_stream>(tar_data));
+        REQUIRE(result.has_value());
+        
+        auto entry = result->next_entry();
+        REQUIRE(entry.has_value());
+        REQUIRE(entry->has_value());
+        
+        // The gap before the offset is skipped, not buffered
+        auto tail = (*entry)->read_data(3, 2);
+        REQUIRE(tail.has_value());
+        REQUIRE(tail->size() == 2);
+        CHECK(std::memcmp(tail->data(), "lo", 2) == 0);
+        
+        auto head = (*entry)->read_data(0, 1);
+        REQUIRE_FALSE(head.has_value());
+        CHECK(head.error().code() == error_code::invalid_operation);
+        
+        auto next = result->next_entry();
+        REQUIRE(next.has_value());
+        CHECK_FALSE(next->has_value());
+    }
+    
+    SECTION("Random offset read from file stream") {
+        TempFile temp_file;
+        temp_file.write_tar_data(create_minimal_tar());
+        
+        auto result = open_archive(temp_file.path());
+        REQUIRE(result.has_value());
+        REQUIRE_FALSE(result->is_mapped());
+        
+        auto entry = result->next_entry();
+        REQUIRE(entry.has_value());
+        REQUIRE(entry->has_value());
+        
+        auto tail = (*entry)->read_data(3, 2);
+        REQUIRE(tail.has_value());
+        CHECK(std::memcmp(tail->data(), "lo", 2) == 0);
+        
+        // Seekable streams can go back as well
+        auto head = (*entry)->read_data(0, 2);
+        REQUIRE(head.has_value());
+        CHECK(std::memcmp(head->data(), "He", 2) == 0);
+        
+        auto next = result->next_entry();
+        REQUIRE(next.has_value());
+        CHECK_FALSE(next->has_value());
+    }
+    
+    SECTION("Read-ahead stream parses headers in place") {
+        auto entry_data = create_minimal_tar();
+        std::vector<char> tar_data;
+        for (int i = 0; i < 300; ++i) {
+            tar_data.insert(tar_data.end(), entry_data.begin(), entry_data.end());
+        }
+        
+        auto result = open_archive(std::make_unique<read_ahead_stream>(
+            std::make_unique<mock_stream>(tar_data), 4096));
+        REQUIRE(result.has_value());
+        
+        size_t count = 0;
+        while (true) {
+            auto entry = result->next_entry();
+            REQUIRE(entry.has_value());
+            if (!*entry) break;
+            CHECK((*entry)->path() == "test.txt");
+            if (count % 7 == 0) {
+                auto data = (*entry)->read_data();
+                REQUIRE(data.has_value());
+                CHECK(std::memcmp(data->data(), "Hello", 5) == 0);
+            }
+            ++count;
+        }
+        CHECK(count == 300);
+    }
+    
+    SECTION("Reads of an entry the reader has left fail") {
+        // Two members, "first" and "second", written through the library
+        std::vector<std::byte> archive;
+        {
+            archive_writer writer{std::make_unique<memory_output_stream>(archive)};
+            for (const std::string name : {"first", "second"}) {
+                file_metadata meta;
+                meta.path = name + ".txt";
+                meta.size = name.size();
+                meta.permissions = fs::perms{0644};
+                REQUIRE(writer.add_entry(meta, std::as_bytes(std::span{name})).has_value());
+            }
+            REQUIRE(writer.finish().has_value());
+        }
+        TempFile temp_file;
+        temp_file.write_tar_data({reinterpret_cast<const char*>(archive.data()),
+                                  reinterpret_cast<const char*>(archive.data() + archive.size())});
+
+        auto result = open_archive(temp_file.path());
+        REQUIRE(result.has_value());
+        REQUIRE_FALSE(result->is_mapped());
+
+        auto first = result->next_entry();
+        REQUIRE(first.has_value());
+        REQUIRE(first->has_value());
+        auto second = result->next_entry();
+        REQUIRE(second.has_value());
+        REQUIRE(second->has_value());
+
+        // Neither the seek nor the bookkeeping of the current entry is touched
+        auto stale = (*first)->read_data(0, 5);
+        REQUIRE_FALSE(stale.has_value());
+        CHECK(stale.error().code() == error_code::invalid_operation);
+
+        auto data = (*second)->read_data(0, 6);
+        REQUIRE(data.has_value());
+        CHECK(std::string_view{reinterpret_cast<const char*>(data->data()), data->size()} == "second");
+
+        auto next = result->next_entry();
+        REQUIRE(next.has_value());
+        CHECK_FALSE(next->has_value());
+        CHECK_FALSE((*second)->read_data(0, 1).has_value());
+    }
+    
     SECTION("Empty stream") {
         std::vector<char> empty_data;
         auto stream = std::make_unique<mock_stream>(empty_data);
@@ -0,0 +1,290 @@
+/*
+ * Copyright 2025 TierOne Software
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <catch2/catch_test_macros.hpp>
+#include <tierone/tar/tar.hpp>
+#include <tierone/tar/transcode.hpp>
+#include <tierone/tar/sparse.hpp>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace tierone::tar;
+
+namespace {
+
+file_metadata make_entry(const std::string& path, const entry_type type, const size_t size = 0) {
+    file_metadata meta;
+    meta.path = path;
+    meta.type = type;
+    meta.permissions = std::filesystem::perms{type == entry_type::directory ? 0755u : 0644u};
+    meta.owner_id = 1000;
+    meta.owner_name = "alice";
+    meta.size = size;
+    meta.modification_time = std::chrono::system_clock::from_time_t(1700000000);
+    return meta;
+}
+
+std::span<const std::byte> as_bytes(const std::string& text) {
+    return {reinterpret_cast<const std::byte*>(text.data()), text.size()};
+}
+
+// Reads a span without exposing it as mapped, so entries stream their data
+class unmapped_stream : public input_stream {
+    memory_mapped_stream data_;
+public:
+    explicit unmapped_stream(const std::span<const std::byte> data) : data_(data) {}
+    std::expected<size_t, error> read(const std::span<std::byte> buffer) override { return data_.read(buffer); }
+    std::expected<void, error> skip(const uint64_t bytes) override { return data_.skip(bytes); }
+    bool at_end() const override { return data_.at_end(); }
+};
+
+std::string read_all(const archive_entry& entry) {
+    std::vector<std::byte> data;
+    REQUIRE(entry.copy_data_to(std::back_inserter(data)).has_value());
+    return {reinterpret_cast<const char*>(data.data()), data.size()};
+}
+
+// Path of each member mapped to its owner and data
+std::map<std::string, std::pair<std::string, std::string>> contents(archive_reader& reader) {
+    std::map<std::string, std::pair<std::string, std::string>> members;
+    for (const auto& entry : reader) {
+        members[entry.path().generic_string()] = {entry.owner_name(), entry.is_regular_file() ? read_all(entry) : ""};
+    }
+    return members;
+}
+
+// Old GNU sparse member: "data" at 0, "tail" at 9000, 12000 bytes in all
+std::vector<std::byte> make_sparse_archive() {
+    std::vector<std::byte> archive(512);
+    auto& header = *reinterpret_cast<sparse::gnu_sparse_header*>(archive.data());
+    std::snprintf(header.name, sizeof(header.name), "img/disk.img");
+    std::snprintf(header.mode, sizeof(header.mode), "%07o", 0644);
+    std::snprintf(header.uid, sizeof(header.uid), "%07o", 0);
+    std::snprintf(header.gid, sizeof(header.gid), "%07o", 0);
+    std::snprintf(header.size, sizeof(header.size), "%011o", 8);
+    std::snprintf(header.mtime, sizeof(header.mtime), "%011o", 0);
+    header.typeflag = 'S';
+    std::memcpy(header.magic, "ustar  ", 8);
+    std::snprintf(header.sp[0].offset, 12, "%011o", 0);
+    std::snprintf(header.sp[0].numbytes, 12, "%011o", 4);
+    std::snprintf(header.sp[1].offset, 12, "%011o", 9000);
+    std::snprintf(header.sp[1].numbytes, 12, "%011o", 4);
+    std::snprintf(header.realsize, sizeof(header.realsize), "%011o", 12000);
+    std::memset(header.checksum, ' ', sizeof(header.checksum));
+    std::snprintf(header.checksum, 8, "%06o",
+        detail::calculate_checksum(std::span<const std::byte, 512>{archive.data(), 512}));
+    const std::string stored = "datatail";
+    archive.resize(1024 + 1024);
+    std::memcpy(archive.data() + 512, stored.data(), stored.size());
+    return archive;
+}
+
+// Directory removed when the test ends
+class temp_dir {
+    std::filesystem::path path_;
+public:
+    temp_dir() {
+        path_ = std::filesystem::temp_directory_path() /
+            ("tierone_transcode_test_" + std::to_string(reinterpret_cast<uintptr_t>(this)));
+        std::filesystem::create_directories(path_);
+    }
+
+    ~temp_dir() {
+        std::error_code ec;
+        std::filesystem::remove_all(path_, ec);
+    }
+
+    std::filesystem::path write(const std::string& name, const std::vector<std::byte>& data) const {
+        const auto path = path_ / name;
+        std::ofstream file(path, std::ios::binary);
+        file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        return path;
+    }
+
+    const std::filesystem::path& path() const { return path_; }
+};
+
+std::vector<std::byte> read_file(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    std::vector<char> data{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    const auto bytes = std::as_bytes(std::span{data});
+    return {bytes.begin(), bytes.end()};
+}
+
+// Move "srv/" to "app/", hand everything to "build" and drop logs
+const member_rewriter rewrite = [](file_metadata& meta) -> std::expected<member_action, error> {
+    auto path = meta.path.generic_string();
+    if (path.ends_with(".log")) {
+        return member_action::drop;
+    }
+    if (path.starts_with("srv/")) {
+        meta.path = "app/" + path.substr(4);
+    }
+    meta.owner_name = "build";
+    meta.owner_id = 0;
+    return member_action::keep;
+};
+
+} // anonymous namespace
+
+TEST_CASE("transcode rewrites headers and copies data as stored", "[unit][transcode]") {
+    std::string large(300000, '\0');
+    for (size_t i = 0; i < large.size(); ++i) {
+        large[i] = static_cast<char>('a' + i * 7 % 26);
+    }
+
+    std::vector<std::byte> archive;
+    {
+        archive_writer writer{std::make_unique<memory_output_stream>(archive)};
+        REQUIRE(writer.add_entry(make_entry("srv/", entry_type::directory)).has_value());
+        REQUIRE(writer.add_entry(make_entry("srv/config.txt", entry_type::regular_file, 6), as_bytes("config")).has_value());
+        REQUIRE(writer.add_entry(make_entry("srv/build.log", entry_type::regular_file, 3), as_bytes("log")).has_value());
+        REQUIRE(writer.add_entry(make_entry("srv/large.bin", entry_type::regular_file, large.size()), as_bytes(large)).has_value());
+        REQUIRE(writer.add_entry(make_entry("srv/empty", entry_type::regular_file)).has_value());
+        auto link = make_entry("srv/current", entry_type::symbolic_link);
+        link.link_target = "config.txt";
+        REQUIRE(writer.add_entry(link).has_value());
+        REQUIRE(writer.finish().has_value());
+    }
+
+    const auto check = [&](const std::vector<std::byte>& output) {
+        archive_reader reader{std::make_unique<memory_mapped_stream>(std::span<const std::byte>{output})};
+        const auto members = contents(reader);
+        REQUIRE(members.size() == 5);
+        CHECK(members.at("app/config.txt") == std::pair<std::string, std::string>{"build", "config"});
+        CHECK(members.at("app/large.bin").second == large);
+        CHECK(members.at("app/empty").second.empty());
+        CHECK(members.contains("app/current"));
+        CHECK_FALSE(members.contains("app/build.log"));
+    };
+
+    SECTION("from a mapped archive") {
+        std::vector<std::byte> output;
+        archive_reader reader{std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive})};
+        archive_writer writer{std::make_unique<memory_output_stream>(output)};
+        auto stats = transcode(reader, writer, rewrite);
+        REQUIRE(stats.has_value());
+        REQUIRE(writer.finish().has_value());
+        CHECK(stats->members == 6);
+        CHECK(stats->dropped == 1);
+        CHECK(stats->data_bytes == 6 + large.size());
+        check(output);
+    }
+
+    SECTION("from a stream") {
+        std::vector<std::byte> output;
+        archive_reader reader{std::make_unique<unmapped_stream>(archive)};
+        archive_writer writer{std::make_unique<memory_output_stream>(output), {.buffer_size = 4096}};
+        auto stats = transcode(reader, writer, rewrite);
+        REQUIRE(stats.has_value());
+        REQUIRE(writer.finish().has_value());
+        check(output);
+    }
+
+    SECTION("between files") {
+        temp_dir dir;
+        const auto input = dir.write("in.tar", archive);
+        auto stats = transcode(input, dir.path() / "out.tar", rewrite);
+        REQUIRE(stats.has_value());
+        CHECK(stats->dropped == 1);
+        check(read_file(dir.path() / "out.tar"));
+
+        // Without a rewriter the output reads back the same as the input
+        REQUIRE(transcode(input, dir.path() / "copy.tar", {}).has_value());
+        archive_reader original{std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive})};
+        const auto copy = read_file(dir.path() / "copy.tar");
+        archive_reader copied{std::make_unique<memory_mapped_stream>(std::span<const std::byte>{copy})};
+        CHECK(contents(copied) == contents(original));
+
+        auto same = transcode(input, input, rewrite);
+        REQUIRE_FALSE(same.has_value());
+        CHECK(same.error().code() == error_code::invalid_operation);
+    }
+
+    SECTION("data layout must not change") {
+        std::vector<std::byte> output;
+        archive_reader reader{std::make_unique<memory_mapped_stream>(std::span<const std::byte>{archive})};
+        archive_writer writer{std::make_unique<memory_output_stream>(output)};
+        auto resized = transcode(reader, writer, [](file_metadata& meta) -> std::expected<member_action, error> {
+            if (meta.is_regular_file()) {
+                meta.size += 1;
+            }
+            return member_action::keep;
+        });
+        REQUIRE_FALSE(resized.has_value());
+        CHECK(resized.error().code() == error_code::invalid_operation);
+    }
+}
+
+TEST_CASE("transcode keeps sparse members sparse", "[unit][transcode][sparse]") {
+    const auto archive = make_sparse_archive();
+    std::string expected(12000, '\0');
+    expected.replace(0, 4, "data");
+    expected.replace(9000, 4, "tail");
+
+    const auto check = [&](const std::vector<std::byte>& output) {
+        archive_reader reader{std::make_unique<memory_mapped_stream>(std::span<const std::byte>{output})};
+        auto entry = reader.next_entry();
+        REQUIRE(entry.has_value());
+        REQUIRE(entry->has_value());
+        CHECK((*entry)->path() == "disk.img");
+        REQUIRE((*entry)->metadata().sparse_info.has_value());
+        CHECK((*entry)->size() == 12000);
+        CHECK(read_all(**entry) == expected);
+        // PAX header and records, header, map, one block of data and the
+        // end marker: the holes are not stored
+        CHECK(output.size() == 7 * 512);
+    };
+
+    const member_rewriter strip = [](file_metadata& meta) -> std::expected<member_action, error> {
+        meta.path = meta.path.filename();
+        return member_action::keep;
+    };
+
+    SECTION("from a stream") {
+        std::vector<std::byte> output;
+        archive_reader reader{std::make_unique<unmapped_stream>(archive)};
+        archive_writer writer{std::make_unique<memory_output_stream>(output)};
+        auto stats = transcode(reader, writer, strip);
+        REQUIRE(stats.has_value());
+        CHECK(stats->data_bytes == 8);
+        REQUIRE(writer.finish().has_value());
+        check(output);
+    }
+
+    SECTION("between files") {
+        temp_dir dir;
+        REQUIRE(transcode(dir.write("in.tar", archive), dir.path() / "out.tar", strip).has_value());
+        check(read_file(dir.path() / "out.tar"));
+    }
+
+    SECTION("add_entry still refuses sparse metadata") {
+        std::vector<std::byte> output;
+        archive_writer writer{std::make_unique<memory_output_stream>(output)};
+        auto meta = make_entry("disk.img", entry_type::regular_file, 12000);
+        meta.sparse_info.emplace();
+        meta.sparse_info->real_size = 12000;
+        auto added = writer.add_entry(meta);
+        REQUIRE_FALSE(added.has_value());
+        CHECK(added.error().code() == error_code::unsupported_feature);
+    }
+}